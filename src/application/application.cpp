@@ -1,8 +1,47 @@
 #include "application.h"
+#include "core/allocation_counter.h"
+#include "core/profiler.h"
+#include "core/startup_trace.h"
+#include "graphics/command_buffer.h"
+#include "input/key_mapping.h"
+#include "io/file_loader.h"
+#include "io/paged_file.h"
 #include "platform/platform_factory.h"
+#include "search/literal_search.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <ctime>
 #include <print>
+#include <utility>
 
 namespace drite {
+
+    /**
+     * @brief Time the cursor stays shown or hidden while blinking, in seconds.
+     */
+    static constexpr double CursorBlinkInterval = 0.5;
+
+    /**
+     * @brief Rows moved per unit of scroll offset.
+     */
+    static constexpr double ScrollRowsPerUnit = 3.0;
+
+    /**
+     * @brief Pause in typing, in seconds, after which the next keystroke starts a new undo step.
+     */
+    static constexpr double UndoCoalesceInterval = 1.0;
+
+    /**
+     * @brief Number of files ranked by quick open.
+     */
+    static constexpr size_t QuickOpenResultCount = 20;
+
+    /**
+     * @brief Pause after a change, in seconds, before the session snapshot is written, so a burst of edits is written once.
+     */
+    static constexpr double SessionSaveDelay = 2.0;
     
     /**
      * @brief Construct a new Application object.
@@ -23,33 +62,39 @@ namespace drite {
      */
     bool Application::initialize(const WindowConfig& config) {
         // Get platform instance
-        platform = PlatformFactory::getInstance();
-        if (!platform) {
-            std::println(stderr, "Failed to create platform");
-            return false;
-        }
+        {
+            StartupPhase phase("platform");
+            platform = PlatformFactory::getInstance();
+            if (!platform) {
+                std::println(stderr, "Failed to create platform");
+                return false;
+            }
 
-        // Initialize platform
-        if (!platform->initialize()) {
-            std::println(stderr, "Failed to initialize platform");
-            return false;
+            // Initialize platform
+            if (!platform->initialize()) {
+                std::println(stderr, "Failed to initialize platform");
+                return false;
+            }
         }
 
         std::println("Platform: {}", platform->getPlatformName());
 
-        // Create window
-        window = platform->createWindow(config);
-        if (!window) {
-            std::println(stderr, "Failed to create window");
-            return false;
+        // Create window, with its graphics context
+        {
+            StartupPhase phase("window");
+            window = platform->createWindow(config);
+            if (!window) {
+                std::println(stderr, "Failed to create window");
+                return false;
+            }
         }
 
-        // Set up event callbacks
+        // Set up event callbacks; input is queued from pollEvents() and handled later in the frame, both on this thread
         window->setResizeCallback([this](int w, int h) { onResize(w, h); });
         window->setCloseCallback([this]() { onClose(); });
-        window->setKeyCallback([this](const KeyEvent& e) { onKey(e); });
-        window->setMouseCallback([this](const MouseEvent& e) { onMouse(e); });
-        window->setScrollCallback([this](const ScrollEvent& e) { onScroll(e); });
+        window->setKeyCallback([this](const KeyEvent& e) { input.push(e); });
+        window->setMouseCallback([this](const MouseEvent& e) { input.push(e); });
+        window->setScrollCallback([this](const ScrollEvent& e) { input.push(e); });
 
         // Show window
         window->show();
@@ -69,8 +114,22 @@ namespace drite {
         }
         std::println("");
 
+        // Scale text with the drawable so it keeps its size on high-DPI displays
+        if (windowHeight > 0) {
+            const int fontSize = 16 * drawableHeight / windowHeight;
+            textRenderer.setFontSize(static_cast<uint16_t>(std::clamp(fontSize, 8, 96)));
+        }
+
+        // Highlighting results arrive from another thread; wake the loop to draw them
+        highlighter.setPublishCallback([this] { platform->postEmptyEvent(); });
+        search.setResultCallback([this] { platform->postEmptyEvent(); });
+        projectSearch.setResultCallback([this] { platform->postEmptyEvent(); });
+        fileIndex.setReadyCallback([this] { platform->postEmptyEvent(); });
+        jobs.setMainThreadCallback([this] { platform->postEmptyEvent(); });
+
         running = true;
         lastFrameTime = platform->getTime();
+        restartCursorBlink();
 
         return true;
     }
@@ -79,9 +138,27 @@ namespace drite {
      * @brief Run the main application loop.
      */
     void Application::run() {
+        const auto wallStart = std::chrono::steady_clock::now();
+        const std::clock_t cpuStart = std::clock();
+
         while (running && !window->shouldClose()) {
-            // Poll events
-            platform->pollEvents();
+            // Damage from outside the loop, such as file opens, also needs a frame
+            if (!damage.isEmpty()) {
+                scheduler.requestFrame();
+            }
+
+            // Block until input arrives, a timer fires or a paced frame is due
+            const double timeout = scheduler.getTimeout(platform->getTime());
+            if (timeout > 0.0) {
+                DRITE_PROFILE_ZONE("waitEvents");
+                const auto waitStart = std::chrono::steady_clock::now();
+                platform->waitEventsTimeout(timeout);
+                idleTime += std::chrono::duration<double>(std::chrono::steady_clock::now() - waitStart).count();
+            } else {
+                DRITE_PROFILE_ZONE("pollEvents");
+                platform->pollEvents();
+            }
+            ++wakeups;
 
             // Calculate delta time
             double currentTime = platform->getTime();
@@ -89,15 +166,93 @@ namespace drite {
             lastFrameTime = currentTime;
 
             // Update and render
-            update(deltaTime);
-            render();
+            {
+                DRITE_PROFILE_ZONE("timers");
+                scheduler.runDueTimers(currentTime);
+            }
+            {
+                DRITE_PROFILE_ZONE("update");
+                update(deltaTime);
+            }
+
+            if (!damage.isEmpty() || !input.isEmpty()) {
+                scheduler.requestFrame();
+            }
+            if (scheduler.beginFrameIfDue(currentTime)) {
+                DRITE_PROFILE_ZONE("frame");
+                const uint64_t allocationsBefore = getThreadAllocationCount();
+                dispatchInput();
+                updateHighlighting();
+                updateSearch();
+                render();
+
+                const uint64_t allocations = getThreadAllocationCount() - allocationsBefore;
+                frameAllocations += allocations;
+                maxFrameAllocations = std::max(maxFrameAllocations, allocations);
+                allocationFreeFrames += allocations == 0;
+            }
+
+            // Everything the iteration allocated from the arena is released at
+            // once, after the next iteration
+            frameArena.endFrame();
         }
+
+        loopTime += std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+        loopCpuTime += static_cast<double>(std::clock() - cpuStart) / CLOCKS_PER_SEC;
     }
 
     /**
      * @brief Shutdown the application and release resources.
      */
     void Application::shutdown() {
+        reportLoopStats();
+
+        // Invocations waiting on documents are released as if they were closed
+        for (const InstanceWaiter& waiter : instanceWaiters) {
+            instanceServer.reply(waiter.client, "done", true);
+        }
+        instanceWaiters.clear();
+        instanceServer.stop();
+
+        // Files preloaded but never opened still reference their entries
+        for (const std::unique_ptr<Preload>& preload : preloads) {
+            jobs.wait(preload->job);
+        }
+        preloads.clear();
+
+        // A save in flight finishes and is reported; the job system drops queued jobs
+        if (saveJob) {
+            jobs.wait(saveJob);
+            jobs.drainMainThread();
+        }
+
+        // The session is written once more with the final state of every document
+        if (!sessionPath.empty()) {
+            scheduler.cancel(std::exchange(sessionTimer, Scheduler::InvalidTimer));
+            if (sessionJob) {
+                jobs.wait(sessionJob);
+                jobs.drainMainThread();
+            }
+            scheduler.cancel(std::exchange(sessionTimer, Scheduler::InvalidTimer));
+            saveSession();
+            if (sessionJob) {
+                jobs.wait(sessionJob);
+                jobs.drainMainThread();
+            }
+        }
+        jobs.shutdown();
+        highlighter.shutdown();
+        search.cancel();
+        projectSearch.cancel();
+        fileIndex.shutdown();
+
+        const GlyphAtlasStats& atlasStats = glyphAtlas.getStats();
+        if (atlasStats.hits + atlasStats.misses > 0) {
+            std::println("Glyph atlas: {} glyphs, {} hits, {} misses, {} evictions",
+                atlasStats.glyphCount, atlasStats.hits, atlasStats.misses, atlasStats.evictions);
+            glyphAtlas.resetStats();
+        }
+
         if (window) {
             window.reset();
         }
@@ -109,6 +264,560 @@ namespace drite {
         running = false;
     }
 
+    /**
+     * @brief Open a file in a new document and make it active.
+     * @param path The path of the file, or "-" for standard input.
+     * @return True if the file was opened, false otherwise.
+     */
+    bool Application::openFile(const std::string& path) {
+        const double startTime = platform ? platform->getTime() : 0.0;
+
+        // A file preloaded during startup is only waited for
+        std::optional<LoadedFile> loaded;
+        const auto preload = std::ranges::find(preloads, path, [](const std::unique_ptr<Preload>& preload) { return preload->path; });
+        if (preload != preloads.end()) {
+            jobs.wait((*preload)->job);
+            loaded = std::move((*preload)->loaded);
+            preloads.erase(preload);
+        } else {
+            StartupPhase phase("load file");
+            loaded = loadFile(path, pageCacheLimit);
+        }
+        if (!loaded) {
+            std::println(stderr, "Failed to open {}", path);
+            return false;
+        }
+
+        PendingOpen open;
+        open.path = path;
+        open.method = getLoadMethodName(loaded->method);
+        open.size = loaded->buffer.getSize();
+        open.startTime = startTime;
+        open.loadedTime = platform ? platform->getTime() : 0.0;
+        pendingOpens.push_back(std::move(open));
+
+        documents.push_back(std::make_unique<Document>(std::move(loaded->buffer), path));
+        if (!sessionPath.empty()) {
+            SessionEntry& entry = getSessionEntry(*documents.back());
+            entry.stamp = loaded->stamp;
+            entry.stampedNanoseconds = loaded->stampedNanoseconds;
+        }
+        showDocument(documents.size() - 1);
+        return true;
+    }
+
+    /**
+     * @brief Start loading files on the job system, so that opening them later only waits for the load.
+     * @param paths The paths, as later passed to openFile().
+     */
+    void Application::preloadFiles(const std::vector<std::string>& paths) {
+        for (const std::string& path : paths) {
+            auto preload = std::make_unique<Preload>();
+            preload->path = path;
+            preload->job = jobs.submit([preload = preload.get(), limit = pageCacheLimit] {
+                StartupPhase phase("load file");
+                preload->loaded = loadFile(preload->path, limit);
+            }, JobPriority::Frame);
+            preloads.push_back(std::move(preload));
+        }
+    }
+
+    /**
+     * @brief Close the active document and make the one before it active.
+     * @return True if it was closed, false if it is being saved.
+     */
+    bool Application::closeActiveDocument() {
+        if (documents.empty()) {
+            return false;
+        }
+        const Document* closed = documents[activeDocument].get();
+        if (closed == savedDocument) {
+            std::println(stderr, "Close: still saving {}", savePath);
+            return false;
+        }
+        documents.erase(documents.begin() + static_cast<ptrdiff_t>(activeDocument));
+        sessionEntries.erase(closed);
+
+        // Invocations waiting on the document are done once none of theirs is open
+        for (InstanceWaiter& waiter : instanceWaiters) {
+            std::erase(waiter.documents, closed);
+            if (waiter.documents.empty()) {
+                instanceServer.reply(waiter.client, "done", true);
+            }
+        }
+        std::erase_if(instanceWaiters, [](const InstanceWaiter& waiter) { return waiter.documents.empty(); });
+
+        // Closing the last document leaves an empty one
+        activeDocument = activeDocument > 0 ? activeDocument - 1 : 0;
+        static_cast<void>(getActiveDocument());
+        showDocument(activeDocument);
+        return true;
+    }
+
+    /**
+     * @brief Put the cursor of the active document on a line and scroll to it.
+     * @param line The 1-based line, clamped to the document.
+     * @param column The 1-based column, 0 for the start of the line.
+     */
+    void Application::goToLine(size_t line, size_t column) {
+        Document& document = getActiveDocument();
+        const TextPosition position{line - 1, column > 0 ? column - 1 : 0};
+        document.setCursor(document.getBuffer().positionToOffset(position));
+        scrollToCursor();
+    }
+
+    /**
+     * @brief Take files handed over by later invocations, making this the editor they open in.
+     * @param socketPath The socket to listen on.
+     * @return True if listening, false if another editor listens there or the socket failed.
+     */
+    bool Application::listenForInstances(const std::string& socketPath) {
+        // Requests arrive on the server thread and are handled between frames
+        const bool listening = instanceServer.start(socketPath, [this](uint64_t client, InstanceRequest request) {
+            jobs.postToMainThread([this, client, request = std::move(request)] { handleInstanceRequest(client, request); });
+        });
+        if (listening) {
+            std::println("Single instance: listening on {}", socketPath);
+        }
+        return listening;
+    }
+
+    /**
+     * @brief Make a document active and lay it out from the line it was scrolled to.
+     * @param index The index of the document.
+     */
+    void Application::showDocument(size_t index) {
+        // The document left keeps its scroll position, and in a session its highlighting
+        if (index != activeDocument && activeDocument < documents.size()) {
+            Document& previous = *documents[activeDocument];
+            previous.setScrollLine(firstVisibleLine);
+            if (!sessionPath.empty()) {
+                getSessionEntry(previous).highlights = highlighter.getTable();
+            }
+        }
+
+        activeDocument = index;
+        Document& document = *documents[index];
+        firstVisibleLine = std::min(document.getScrollLine(), document.getBuffer().getLineCount() - 1);
+        firstVisibleRow = 0;
+        layout.reset(document.getBuffer().getLineCount());
+        visibleRows.clear();
+        pendingLineChange.reset();
+        static_cast<void>(document.takeLineChange());
+        const auto entry = sessionEntries.find(&document);
+        highlighter.attach(document.getBuffer(), detectLanguage(document.getPath()),
+                           entry != sessionEntries.end() ? entry->second.highlights : nullptr);
+        lineStates.clear();
+        if (findActive) {
+            restartSearch();
+        }
+        damage.markAll();
+    }
+
+    /**
+     * @brief Resolve a path to the file it names.
+     * @param path The path, relative to the working directory or absolute.
+     * @return The absolute path with symbolic links resolved, or std::nullopt if the file does not exist.
+     */
+    static std::optional<std::string> getCanonicalPath(const std::string& path) {
+        char* resolved = ::realpath(path.c_str(), nullptr);
+        if (!resolved) {
+            return std::nullopt;
+        }
+        std::string canonical(resolved);
+        std::free(resolved);
+        return canonical;
+    }
+
+    /**
+     * @brief Find the open document of a file.
+     * @param path The path of the file, in any form naming the same file.
+     * @return The index of the document, or std::nullopt if the file is not open.
+     */
+    std::optional<size_t> Application::findOpenDocument(const std::string& path) const {
+        const std::optional<std::string> canonical = getCanonicalPath(path);
+        if (!canonical) {
+            return std::nullopt;
+        }
+        for (size_t i = 0; i < documents.size(); ++i) {
+            const std::string& documentPath = documents[i]->getPath();
+            if (!documentPath.empty() && documentPath != "-" && getCanonicalPath(documentPath) == canonical) {
+                return i;
+            }
+        }
+        return std::nullopt;
+    }
+
+    /**
+     * @brief Open the files of a request from another invocation and reply to it.
+     * @param client The connection to reply to.
+     * @param request The request.
+     */
+    void Application::handleInstanceRequest(uint64_t client, const InstanceRequest& request) {
+        InstanceWaiter waiter;
+        waiter.client = client;
+        for (const std::string& path : request.files) {
+            // A file already open, e.g. COMMIT_EDITMSG still open from an earlier commit, is brought forward instead of opened twice
+            if (const std::optional<size_t> open = findOpenDocument(path)) {
+                showDocument(*open);
+                waiter.documents.push_back(documents[*open].get());
+            } else if (openFile(path)) {
+                waiter.documents.push_back(documents.back().get());
+            }
+        }
+
+        // The line and column apply to the last file, which is now active
+        if (request.line > 0 && !waiter.documents.empty()) {
+            goToLine(request.line, request.column);
+        }
+        if (window) {
+            window->show();
+        }
+
+        const std::string status = waiter.documents.size() == request.files.size()
+            ? std::string("ok")
+            : "error opened " + std::to_string(waiter.documents.size()) + " of " + std::to_string(request.files.size()) + " files";
+        const bool waiting = request.wait && !waiter.documents.empty();
+        instanceServer.reply(client, status, !request.wait);
+        if (waiting) {
+            instanceWaiters.push_back(std::move(waiter));
+        } else if (request.wait) {
+            instanceServer.reply(client, "done", true);
+        }
+    }
+
+    /**
+     * @brief Get the document being edited.
+     * @return Reference to the active document.
+     */
+    Document& Application::getActiveDocument() {
+        if (documents.empty()) {
+            documents.push_back(std::make_unique<Document>());
+            activeDocument = 0;
+        }
+        return *documents[activeDocument];
+    }
+
+    /**
+     * @brief Save the active document on a worker thread, replacing the file atomically.
+     * @param path The file to save to, empty for the document's own path; saving elsewhere makes it the document's path.
+     * @return True if the save was started, false if the document has no path or a save is still running.
+     */
+    bool Application::save(const std::string& path) {
+        Document& document = getActiveDocument();
+        const std::string target = path.empty() ? document.getPath() : path;
+        if (target.empty() || target == "-") {
+            std::println(stderr, "Save: the document has no file name");
+            return false;
+        }
+        if (saveJob && !saveJob->isDone()) {
+            std::println(stderr, "Save: still saving {}", savePath);
+            return false;
+        }
+
+        // The snapshot only references the piece table's append-only buffers,
+        // so the worker streams them out while editing goes on
+        auto snapshot = std::make_shared<const TextSnapshot>(TextSnapshot::capture(document.getBuffer()));
+        Document* saved = &document;
+        savedDocument = saved;
+        savePath = target;
+        saveJob = jobs.submit([this, snapshot, saved, target] {
+            const std::optional<SaveStats> stats = saveSnapshot(*snapshot, target, [this](size_t written, size_t total) {
+                jobs.postToMainThread([this, written, total] { showSaveProgress(written, total); });
+            });
+            jobs.postToMainThread([this, saved, target, stats] { finishSave(*saved, target, stats); });
+        }, JobPriority::Background);
+        showSaveProgress(0, snapshot->size);
+        return true;
+    }
+
+    /**
+     * @brief Reopen the documents of a session snapshot and keep the snapshot up to date from now on.
+     * @param path The snapshot file, written again a couple of seconds after every change and on shutdown.
+     * @return The number of documents restored.
+     */
+    size_t Application::restoreSession(const std::string& path) {
+        StartupPhase phase("restore session");
+        const auto startTime = std::chrono::steady_clock::now();
+        sessionPath = path;
+        const std::unique_ptr<SessionSnapshot> snapshot = SessionSnapshot::open(path);
+        if (!snapshot) {
+            return 0;
+        }
+
+        // A document that cannot be restored is skipped; the rest keep their order
+        const size_t first = documents.size();
+        size_t active{first}, stale{0}, hashed{0};
+        for (size_t i = 0; i < snapshot->getDocumentCount(); ++i) {
+            std::optional<RestoredDocument> restored = snapshot->restoreDocument(i, pageCacheLimit);
+            if (!restored) {
+                continue;
+            }
+            if (i == snapshot->getActiveDocument()) {
+                active = documents.size();
+            }
+            stale += restored->stale;
+            hashed += restored->hashed;
+
+            const Document& document = *documents.emplace_back(std::move(restored->document));
+            SessionEntry& entry = getSessionEntry(document);
+            entry.stamp = restored->stamp;
+            entry.stampedNanoseconds = restored->stampedNanoseconds;
+            entry.contentHash = restored->contentHash;
+            entry.highlights = std::move(restored->highlights);
+
+            // An unchanged document is written from its restored section until it changes
+            if (restored->section) {
+                entry.encodedPath = document.getPath();
+                entry.encodedRevision = document.getBuffer().getRevision();
+                entry.encodedCursors.assign(document.getCursors().begin(), document.getCursors().end());
+                entry.encodedCursor = document.getCursor();
+                entry.encodedScrollLine = document.getScrollLine();
+                entry.encodedHighlights = entry.highlights;
+                entry.section = std::move(restored->section);
+            }
+        }
+
+        const size_t count = documents.size() - first;
+        if (count > 0) {
+            // With nothing open before, the view of the active document comes from the snapshot alone
+            active = std::min(active, documents.size() - 1);
+            if (first == 0) {
+                activeDocument = active;
+            }
+            showDocument(active);
+        }
+        std::println("Session: restored {} documents ({} changed on disk, {} hashed) from {} KiB in {:.2f} ms", count, stale, hashed,
+            snapshot->getSize() / 1024, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count());
+        return count;
+    }
+
+    /**
+     * @brief Get the session entry of a document, adding one if it has none.
+     * @param document The document.
+     * @return Reference to the entry.
+     */
+    Application::SessionEntry& Application::getSessionEntry(const Document& document) {
+        SessionEntry& entry = sessionEntries[&document];
+        if (entry.id == 0) {
+            entry.id = nextSessionEntry++;
+        }
+        return entry;
+    }
+
+    /**
+     * @brief Get the highlighting results the session snapshot would keep of a document.
+     * @param entry The session entry of the document.
+     * @param document The document.
+     * @return The results, or nullptr if none match its text.
+     */
+    std::shared_ptr<const HighlightTable> Application::getSessionHighlights(const SessionEntry& entry, const Document& document) const {
+        const bool active = activeDocument < documents.size() && documents[activeDocument].get() == &document;
+        const std::shared_ptr<const HighlightTable>& table = active ? highlighter.getTable() : entry.highlights;
+        const TextBuffer& buffer = document.getBuffer();
+        return table && table->revision == buffer.getRevision() && table->lineCount == buffer.getLineCount() ? table : nullptr;
+    }
+
+    /**
+     * @brief Check whether a document changed since its session section was encoded.
+     * @param entry The session entry of the document.
+     * @param document The document.
+     * @return True if the section has to be encoded again.
+     */
+    bool Application::isSessionOutdated(const SessionEntry& entry, const Document& document) const {
+        const bool active = activeDocument < documents.size() && documents[activeDocument].get() == &document;
+        const size_t scrollLine = active ? firstVisibleLine : document.getScrollLine();
+        return !entry.section || entry.encodedRevision != document.getBuffer().getRevision() ||
+            entry.encodedCursor != document.getCursor() || entry.encodedScrollLine != scrollLine ||
+            !std::ranges::equal(entry.encodedCursors, document.getCursors()) || entry.encodedPath != document.getPath() ||
+            entry.encodedHighlights != getSessionHighlights(entry, document);
+    }
+
+    /**
+     * @brief Check whether the session snapshot keeps a document: all but an empty untitled one.
+     * @param document The document.
+     * @return True if the document is kept.
+     */
+    bool Application::isKeptInSession(const Document& document) noexcept {
+        return !document.getPath().empty() || document.getBuffer().getSize() > 0;
+    }
+
+    /**
+     * @brief Check whether anything in the session changed since the snapshot was last written.
+     * @return True if the snapshot has to be written again.
+     */
+    bool Application::isSessionChanged() {
+        size_t written{0};
+        size_t active{0};
+        for (size_t i = 0; i < documents.size(); ++i) {
+            const Document& document = *documents[i];
+            if (!isKeptInSession(document)) {
+                continue;
+            }
+            const SessionEntry& entry = getSessionEntry(document);
+            if (written >= sessionWritten.size() || sessionWritten[written] != entry.id || isSessionOutdated(entry, document)) {
+                return true;
+            }
+            if (i == activeDocument) {
+                active = written;
+            }
+            ++written;
+        }
+        return written != sessionWritten.size() || active != sessionWrittenActive;
+    }
+
+    /**
+     * @brief Schedule writing the session snapshot if anything in it changed and no write is scheduled.
+     */
+    void Application::scheduleSessionSave() {
+        // A write in flight checks again when it finishes
+        if (sessionPath.empty() || sessionTimer != Scheduler::InvalidTimer || (sessionJob && !sessionJob->isDone()) ||
+            !isSessionChanged()) {
+            return;
+        }
+        sessionTimer = scheduler.schedule((platform ? platform->getTime() : 0.0) + SessionSaveDelay, [this] {
+            sessionTimer = Scheduler::InvalidTimer;
+            saveSession();
+        });
+    }
+
+    /**
+     * @brief Write the session snapshot on a worker thread, encoding only the documents that changed.
+     */
+    void Application::saveSession() {
+        DRITE_PROFILE_ZONE("saveSession");
+        if (sessionPath.empty() || (sessionJob && !sessionJob->isDone()) || !isSessionChanged()) {
+            return;
+        }
+
+        // Unchanged documents are written from their cached sections; the
+        // rest are captured here, sharing their text and undo groups, and
+        // copied into sections on the worker
+        auto parts = std::make_shared<std::vector<SessionPart>>();
+        size_t active{0};
+        for (size_t i = 0; i < documents.size(); ++i) {
+            const Document& document = *documents[i];
+            if (!isKeptInSession(document)) {
+                continue;
+            }
+            if (i == activeDocument) {
+                active = parts->size();
+            }
+            SessionEntry& entry = getSessionEntry(document);
+            SessionPart& part = parts->emplace_back();
+            part.document = &document;
+            part.id = entry.id;
+            if (!isSessionOutdated(entry, document)) {
+                part.section = entry.section;
+                continue;
+            }
+
+            std::shared_ptr<const HighlightTable> highlights = getSessionHighlights(entry, document);
+            SessionDocumentState& state = part.state.emplace(captureSessionDocument(document, highlights, entry.lineIndex));
+            if (i == activeDocument) {
+                state.scrollLine = firstVisibleLine;
+            }
+            state.stamp = entry.stamp;
+            state.stampedNanoseconds = entry.stampedNanoseconds;
+            state.contentHash = entry.contentHash;
+            entry.lineIndex = state.lineIndex;
+
+            entry.encodedPath = document.getPath();
+            entry.encodedRevision = document.getBuffer().getRevision();
+            entry.encodedCursors.assign(document.getCursors().begin(), document.getCursors().end());
+            entry.encodedCursor = document.getCursor();
+            entry.encodedScrollLine = state.scrollLine;
+            entry.encodedHighlights = std::move(highlights);
+        }
+
+        sessionJob = jobs.submit([this, parts, active, path = sessionPath] {
+            std::vector<std::shared_ptr<const SessionSection>> sections;
+            sections.reserve(parts->size());
+            for (SessionPart& part : *parts) {
+                if (part.state) {
+                    // A file is hashed once, the first time its document is written
+                    if (part.state->contentHash == 0 && part.state->storage) {
+                        part.state->contentHash = hashText(*part.state->storage);
+                    }
+                    part.contentHash = part.state->contentHash;
+                    part.section = std::make_shared<const SessionSection>(encodeSessionDocument(*part.state));
+                    part.state.reset();
+                }
+                sections.push_back(part.section);
+            }
+            const bool written = writeSessionSnapshot(path, sections, active).has_value();
+            jobs.postToMainThread([this, parts, active, written] { finishSessionSave(*parts, active, written); });
+        }, JobPriority::Background);
+    }
+
+    /**
+     * @brief Keep the sections encoded by a session write, once it finished.
+     * @param parts The documents written, in order.
+     * @param active The index of the active document among them.
+     * @param written Whether the snapshot was written.
+     */
+    void Application::finishSessionSave(const std::vector<SessionPart>& parts, size_t active, bool written) {
+        if (!written) {
+            std::println(stderr, "Session: cannot write {}; the session is no longer kept", sessionPath);
+            sessionPath.clear();
+            return;
+        }
+
+        // Documents closed meanwhile are gone from the entries; a reused address has another id
+        sessionWritten.clear();
+        for (const SessionPart& part : parts) {
+            sessionWritten.push_back(part.id);
+            const auto entry = sessionEntries.find(part.document);
+            if (entry != sessionEntries.end() && entry->second.id == part.id) {
+                entry->second.section = part.section;
+                if (entry->second.contentHash == 0) {
+                    entry->second.contentHash = part.contentHash;
+                }
+            }
+        }
+        sessionWrittenActive = active;
+        scheduleSessionSave();
+    }
+
+    /**
+     * @brief Open the find bar with a query and search the active document.
+     * @param query The query.
+     */
+    void Application::find(const SearchQuery& query) {
+        findActive = true;
+        findQuery = query;
+        restartSearch();
+    }
+
+    /**
+     * @brief Search the files below directories, printing matching lines as they stream in.
+     * @param roots The directories or files to search.
+     * @param query The query.
+     */
+    void Application::findInFiles(const std::vector<std::string>& roots, const SearchQuery& query) {
+        projectMatches.clear();
+        printedProjectMatches = 0;
+        static_cast<void>(projectSearch.start(roots, query));
+    }
+
+    /**
+     * @brief Open quick open with a query, indexing the working directory on first use.
+     * @param query The fuzzy file name query.
+     */
+    void Application::quickOpen(const std::string& query) {
+        // A cached index is usable at once; the refresh catches up in the background
+        if (fileIndex.getRoot().empty()) {
+            const double startTime = platform ? platform->getTime() : 0.0;
+            if (fileIndex.open(".", FileIndex::getDefaultCachePath("."))) {
+                std::println("Quick open: loaded {} cached files in {:.2f} ms", fileIndex.getStats().files,
+                    ((platform ? platform->getTime() : 0.0) - startTime) * 1000.0);
+            }
+        }
+        quickOpenActive = true;
+        quickOpenQuery = query;
+        rankQuickOpen();
+    }
+
     /**
      * @brief Handle window resize events.
      * @param width The new width of the window in points.
@@ -125,6 +834,8 @@ namespace drite {
         std::println("");
 
         // Graphics context automatically handles viewport updates
+        updateWrap(drawableWidth);
+        damage.markAll();
     }
 
     /**
@@ -140,14 +851,82 @@ namespace drite {
      * @param event The key event.
      */
     void Application::onKey(const KeyEvent& event) {
-        if (event.action == KeyAction::Press) {
-            std::println("Key pressed: {}", static_cast<int>(event.key));
-
-            // Quit on Escape
-            if (event.key == KeyCode::Escape) {
+        // Escape closes quick open or the find bar, then drops extra cursors, otherwise quits
+        if (event.action == KeyAction::Press && event.key == KeyCode::Escape) {
+            Document& document = getActiveDocument();
+            if (quickOpenActive) {
+                closeQuickOpen();
+            } else if (findActive) {
+                closeFind();
+            } else if (document.getCursors().size() > 1) {
+                markCursorLines();
+                document.setCursor(document.getCursor());
+            } else {
                 running = false;
             }
+            return;
+        }
+
+        // Cmd/Ctrl+F opens the find bar with the last query; with Shift it
+        // searches the files below the working directory for it instead
+        const bool shortcut = event.modifiers.command || event.modifiers.control;
+        if (event.action == KeyAction::Press && shortcut && event.key == KeyCode::P) {
+            quickOpen(quickOpenQuery);
+            return;
+        }
+        if (event.action == KeyAction::Press && shortcut && event.key == KeyCode::S) {
+            save();
+            return;
+        }
+        if (event.action == KeyAction::Press && shortcut && event.key == KeyCode::W) {
+            static_cast<void>(closeActiveDocument());
+            return;
+        }
+        if (quickOpenActive && handleQuickOpenKey(event)) {
+            return;
+        }
+        if (event.action == KeyAction::Press && shortcut && event.key == KeyCode::F) {
+            if (event.modifiers.shift && !findQuery.pattern.empty()) {
+                findInFiles({"."}, findQuery);
+            } else {
+                find(findQuery);
+            }
+            return;
+        }
+        if (findActive && handleFindKey(event)) {
+            return;
+        }
+
+        Document& document = getActiveDocument();
+        const TextBuffer& buffer = document.getBuffer();
+
+        // Typing bursts are undone together; a pause starts a new undo step
+        if (event.action != KeyAction::Release) {
+            const double now = platform->getTime();
+            if (now - lastKeyTime > UndoCoalesceInterval) {
+                document.getHistory().seal();
+            }
+            lastKeyTime = now;
         }
+
+        // Every line between the first and last cursor may have been edited
+        const size_t firstLineBefore = buffer.offsetToPosition(document.getCursors().front()).line;
+        const size_t lastLineBefore = buffer.offsetToPosition(document.getCursors().back()).line;
+        const size_t lineCountBefore = buffer.getLineCount();
+
+        if (!document.handleKey(event)) {
+            return;
+        }
+
+        // Edits that add or remove lines shift everything below them
+        const size_t firstLineAfter = buffer.offsetToPosition(document.getCursors().front()).line;
+        const size_t lastLineAfter = buffer.offsetToPosition(document.getCursors().back()).line;
+        const size_t lastLine = buffer.getLineCount() != lineCountBefore ? DamageTracker::ToEnd : std::max(lastLineBefore, lastLineAfter);
+        damage.markLines(std::min(firstLineBefore, firstLineAfter), lastLine);
+
+        // Keep the cursor solid while typing
+        restartCursorBlink();
+        scrollToCursor();
     }
 
     /**
@@ -165,7 +944,35 @@ namespace drite {
      * @param event The scroll event.
      */
     void Application::onScroll(const ScrollEvent& event) {
-        std::println("Scroll: {}, {}", event.xOffset, event.yOffset);
+        syncLayout();
+        const auto rows = static_cast<ptrdiff_t>(-event.yOffset * ScrollRowsPerUnit);
+        const LayoutPosition top{firstVisibleLine, firstVisibleRow};
+        const LayoutPosition target = layout.scroll(getActiveDocument().getBuffer(), top, rows);
+
+        if (target != top) {
+            firstVisibleLine = target.line;
+            firstVisibleRow = target.row;
+            damage.markAll();
+        }
+    }
+
+    /**
+     * @brief Hand the input queued since the last frame to the event handlers.
+     */
+    void Application::dispatchInput() {
+        DRITE_PROFILE_ZONE("dispatchInput");
+        input.drain([this](const InputEvent& event) {
+            if (!running) {
+                return;
+            }
+            if (const auto* key = std::get_if<KeyEvent>(&event)) {
+                onKey(*key);
+            } else if (const auto* mouse = std::get_if<MouseEvent>(&event)) {
+                onMouse(*mouse);
+            } else if (const auto* scroll = std::get_if<ScrollEvent>(&event)) {
+                onScroll(*scroll);
+            }
+        });
     }
 
     /**
@@ -173,19 +980,695 @@ namespace drite {
      * @param deltaTime The time elapsed since the last frame in seconds.
      */
     void Application::update(double /* deltaTime */) {
-        // Update logic here
-        // deltaTime will be used when implementing editor updates
+        // Time-based work is scheduled as timers; deltaTime will drive animations.
+        // Job results are applied first so the rest of the frame sees them.
+        jobs.drainMainThread();
+        updateHighlighting();
+        updateSearch();
+        updateProjectSearch();
+        updateQuickOpen();
+        scheduleSessionSave();
+    }
+
+    /**
+     * @brief Hand edits to the syntax highlighter and damage lines whose highlighting changed.
+     */
+    void Application::updateHighlighting() {
+        if (!window) {
+            return;
+        }
+
+        int width{0}, height{0};
+        window->getFramebufferSize(width, height);
+        const size_t visibleLines = textRenderer.getVisibleLineCount(height) + 1;
+
+        Document& document = getActiveDocument();
+        syncLayout();
+        const std::optional<LineChange> change = std::exchange(pendingLineChange, std::nullopt);
+        if (!highlighter.update(document.getBuffer(), change, firstVisibleLine, visibleLines)) {
+            return;
+        }
+
+        // A line is drawn from its start state, so only lines whose start
+        // state changed need redrawing
+        DRITE_PROFILE_ZONE("highlight");
+        highlighter.getLineStates(document.getBuffer(), firstVisibleLine, visibleLines, nextLineStates, frameArena.getResource());
+        for (size_t i = 0; i < nextLineStates.size(); ++i) {
+            if (i >= lineStates.size() || lineStates[i] != nextLineStates[i]) {
+                damage.markLines(firstVisibleLine + i, firstVisibleLine + i);
+            }
+        }
+        lineStates.swap(nextLineStates);
+    }
+
+    /**
+     * @brief Hand the edits made to the active document since the last call to the text layout.
+     */
+    void Application::syncLayout() {
+        Document& document = getActiveDocument();
+        const std::optional<LineChange> change = document.takeLineChange();
+        if (!change) {
+            return;
+        }
+
+        // The highlighter takes the same edits later in the frame
+        layout.applyLineChange(*change, document.getBuffer().getLineCount());
+        if (pendingLineChange) {
+            pendingLineChange->merge(*change);
+        } else {
+            pendingLineChange = change;
+        }
+    }
+
+    /**
+     * @brief Wrap lines to the view width, keeping the row at the top of the view in place.
+     * @param width The view width in pixels.
+     */
+    void Application::updateWrap(int width) {
+        // A minimized window keeps its wrapping until it has a size again
+        if (width <= 0) {
+            return;
+        }
+        const auto columns = static_cast<size_t>(std::max(1.0f, std::floor(static_cast<float>(width) / textRenderer.getAdvance())));
+        if (columns == layout.getWrapColumns()) {
+            return;
+        }
+
+        syncLayout();
+        const TextBuffer& buffer = getActiveDocument().getBuffer();
+        const size_t topOffset = layout.getRowStart(buffer, LayoutPosition{firstVisibleLine, firstVisibleRow});
+        layout.setWrapColumns(columns);
+        const LayoutPosition top = layout.locate(buffer, topOffset);
+        firstVisibleLine = top.line;
+        firstVisibleRow = top.row;
+        damage.markAll();
+    }
+
+    /**
+     * @brief Handle a key event while the find bar is open.
+     * @param event The key event.
+     * @return True if the event edited the query or moved between matches.
+     */
+    bool Application::handleFindKey(const KeyEvent& event) {
+        if (event.action == KeyAction::Release) {
+            return false;
+        }
+
+        // Alt+C toggles case sensitivity and Alt+R regular expressions
+        if (event.modifiers.alt && (event.key == KeyCode::C || event.key == KeyCode::R)) {
+            bool& flag = event.key == KeyCode::C ? findQuery.ignoreCase : findQuery.regex;
+            flag = !flag;
+            restartSearch();
+            return true;
+        }
+
+        switch (event.key) {
+            case KeyCode::Enter:
+                // Alt+Enter puts a cursor on every match
+                if (event.modifiers.alt) {
+                    addCursorsAtMatches();
+                } else {
+                    selectAdjacentMatch(!event.modifiers.shift);
+                }
+                return true;
+
+            case KeyCode::Backspace:
+                // Drop a whole UTF-8 sequence
+                while (!findQuery.pattern.empty() && (static_cast<unsigned char>(findQuery.pattern.back()) & 0xC0) == 0x80) {
+                    findQuery.pattern.pop_back();
+                }
+                if (!findQuery.pattern.empty()) {
+                    findQuery.pattern.pop_back();
+                }
+                restartSearch();
+                return true;
+
+            default:
+                break;
+        }
+
+        const char character = keyToCharacter(event);
+        if (static_cast<unsigned char>(character) < ' ' || event.modifiers.command || event.modifiers.control || event.modifiers.alt) {
+            return false;
+        }
+        findQuery.pattern.push_back(character);
+        restartSearch();
+        return true;
+    }
+
+    /**
+     * @brief Search the active document for the find query from the cursor.
+     */
+    void Application::restartSearch() {
+        // Every keystroke cancels the running search; its workers move on to
+        // the new query after the segment they are in
+        const Document& document = getActiveDocument();
+        findMatchSelected = false;
+        currentMatch = SIZE_MAX;
+        searchRevision = document.getBuffer().getRevision();
+        static_cast<void>(search.start(document.getBuffer(), findQuery, document.getCursor()));
+        updateFindTitle();
+    }
+
+    /**
+     * @brief Close the find bar and drop its matches.
+     */
+    void Application::closeFind() {
+        findActive = false;
+        search.cancel();
+        currentMatch = SIZE_MAX;
+        visibleMatches.clear();
+        damage.markAll();
+        updateFindTitle();
+    }
+
+    /**
+     * @brief Pick up streamed search results, jump to the first match and damage lines whose matches changed.
+     */
+    void Application::updateSearch() {
+        if (!findActive || !window) {
+            return;
+        }
+
+        // Match offsets are stale after an edit, so search again without moving the cursor
+        const Document& document = getActiveDocument();
+        const TextBuffer& buffer = document.getBuffer();
+        if (buffer.getRevision() != searchRevision && search.isActive()) {
+            searchRevision = buffer.getRevision();
+            currentMatch = SIZE_MAX;
+            findMatchSelected = true;
+            static_cast<void>(search.start(buffer, findQuery, document.getCursor()));
+        }
+
+        if (search.poll()) {
+            DRITE_PROFILE_ZONE("searchResults");
+            if (!findMatchSelected) {
+                if (const SearchMatch* match = search.getFirstMatch()) {
+                    findMatchSelected = true;
+                    selectMatch(*match);
+                }
+            }
+            updateFindTitle();
+
+            if (search.isComplete()) {
+                const SearchStats& stats = search.getStats();
+                const double megabytes = static_cast<double>(stats.bytesSearched) / (1024.0 * 1024.0);
+                std::println("Search: {} matches for \"{}\" in {:.2f} ms ({:.0f} MiB/s, {} threads, {}), first match after {:.2f} ms",
+                    stats.matchCount, findQuery.pattern, stats.seconds * 1000.0,
+                    stats.seconds > 0.0 ? megabytes / stats.seconds : 0.0, search.getThreadCount(),
+                    findQuery.regex ? "regex" : getLiteralSearchName(), stats.firstResultSeconds * 1000.0);
+                if (stats.skippedLines > 0) {
+                    std::println("Search: skipped {} lines longer than {} bytes", stats.skippedLines, PatternMatcher::MaxRegexLineBytes);
+                }
+            }
+        }
+
+        // Redraw the visible lines when the matches over them change, e.g. as results stream in
+        int width{0}, height{0};
+        window->getFramebufferSize(width, height);
+        const size_t lastLine = std::min(buffer.getLineCount(), firstVisibleLine + textRenderer.getVisibleLineCount(height) + 1);
+        const size_t begin = buffer.getLineStart(firstVisibleLine);
+        const size_t end = lastLine < buffer.getLineCount() ? buffer.getLineStart(lastLine) : buffer.getSize();
+
+        const std::vector<SearchMatch>& matches = search.getMatches();
+        const auto first = std::partition_point(matches.begin(), matches.end(), [&](const SearchMatch& match) {
+            return match.offset + match.length <= begin;
+        });
+        const auto last = std::partition_point(first, matches.end(), [&](const SearchMatch& match) {
+            return match.offset < end;
+        });
+        nextVisibleMatches.assign(first, last);
+        if (nextVisibleMatches != visibleMatches) {
+            damage.markLines(firstVisibleLine, lastLine);
+            visibleMatches.swap(nextVisibleMatches);
+        }
+    }
+
+    /**
+     * @brief Pick up and print the files matched by findInFiles() since the last frame.
+     */
+    void Application::updateProjectSearch() {
+        if (!projectSearch.poll(projectMatches)) {
+            return;
+        }
+
+        DRITE_PROFILE_ZONE("projectSearchResults");
+        for (; printedProjectMatches < projectMatches.size(); ++printedProjectMatches) {
+            const ProjectFileMatch& file = projectMatches[printedProjectMatches];
+            for (const ProjectLineMatch& line : file.lines) {
+                std::println("{}:{}:{}", file.path, line.line, line.text);
+            }
+        }
+
+        if (projectSearch.isComplete()) {
+            const ProjectSearchStats& stats = projectSearch.getStats();
+            const double megabytes = static_cast<double>(stats.bytesSearched) / (1024.0 * 1024.0);
+            std::println("Find in files: {} lines in {} of {} files ({:.1f} MiB) in {:.2f} ms, {} binary and {} ignored skipped",
+                stats.matchedLines, stats.filesMatched, stats.filesSearched, megabytes, stats.seconds * 1000.0,
+                stats.binaryFiles, stats.ignoredPaths);
+        }
+    }
+
+    /**
+     * @brief Handle a key event while quick open is shown.
+     * @param event The key event.
+     * @return True if the event edited the query or opened a file.
+     */
+    bool Application::handleQuickOpenKey(const KeyEvent& event) {
+        if (event.action == KeyAction::Release) {
+            return false;
+        }
+
+        switch (event.key) {
+            case KeyCode::Enter:
+                if (!quickOpenMatches.empty()) {
+                    const std::string path = fileIndex.getRoot() + "/" + quickOpenMatches.front().path;
+                    closeQuickOpen();
+                    static_cast<void>(openFile(path));
+                }
+                return true;
+
+            case KeyCode::Backspace:
+                // Drop a whole UTF-8 sequence
+                while (!quickOpenQuery.empty() && (static_cast<unsigned char>(quickOpenQuery.back()) & 0xC0) == 0x80) {
+                    quickOpenQuery.pop_back();
+                }
+                if (!quickOpenQuery.empty()) {
+                    quickOpenQuery.pop_back();
+                }
+                rankQuickOpen();
+                return true;
+
+            default:
+                break;
+        }
+
+        const char character = keyToCharacter(event);
+        if (static_cast<unsigned char>(character) < ' ' || event.modifiers.command || event.modifiers.control || event.modifiers.alt) {
+            return false;
+        }
+        quickOpenQuery.push_back(character);
+        rankQuickOpen();
+        return true;
+    }
+
+    /**
+     * @brief Rank the indexed files for the quick open query and show the best in the window title.
+     */
+    void Application::rankQuickOpen() {
+        fileIndex.find(quickOpenQuery, QuickOpenResultCount, quickOpenMatches);
+        if (!window) {
+            return;
+        }
+
+        std::string title = "Open: " + quickOpenQuery;
+        if (!quickOpenMatches.empty()) {
+            title += " - " + quickOpenMatches.front().path;
+        } else {
+            title += fileIndex.isRefreshing() ? " (indexing)" : " (no match)";
+        }
+        window->setTitle(title);
+    }
+
+    /**
+     * @brief Close quick open.
+     */
+    void Application::closeQuickOpen() {
+        quickOpenActive = false;
+        quickOpenMatches.clear();
+
+        // Hand the title back to the find bar, or to the default
+        updateFindTitle();
+    }
+
+    /**
+     * @brief Pick up a finished refresh of the file index and rank its files again.
+     */
+    void Application::updateQuickOpen() {
+        if (!fileIndex.poll()) {
+            return;
+        }
+
+        const FileIndexStats& stats = fileIndex.getStats();
+        std::println("Quick open: indexed {} files in {} directories in {:.2f} ms ({} listed, {} unchanged)", stats.files,
+            stats.directories, stats.refreshSeconds * 1000.0, stats.rescannedDirectories, stats.reusedDirectories);
+        if (quickOpenActive) {
+            rankQuickOpen();
+        }
+    }
+
+    /**
+     * @brief Show how much of the file being saved was written in the window title.
+     * @param written The bytes written so far.
+     * @param total The size of the saved text in bytes.
+     */
+    void Application::showSaveProgress(size_t written, size_t total) {
+        // The find bar and quick open own the title while they are shown
+        if (!window || findActive || quickOpenActive) {
+            return;
+        }
+        const size_t percent = total > 0 ? written * 100 / total : 100;
+        window->setTitle("Saving " + savePath + " - " + std::to_string(percent) + "%");
+    }
+
+    /**
+     * @brief Report a finished save and adopt its path for the document.
+     * @param document The saved document.
+     * @param path The file it was saved to.
+     * @param stats The save counters, or std::nullopt if the save failed.
+     */
+    void Application::finishSave(Document& document, const std::string& path, const std::optional<SaveStats>& stats) {
+        savedDocument = nullptr;
+        if (window && !findActive && !quickOpenActive) {
+            window->setTitle(WindowConfig().title);
+        }
+        if (!stats) {
+            return;
+        }
+
+        document.setPath(path);
+        const double seconds = stats->writeSeconds + stats->syncSeconds;
+        std::println("Saved {} ({} bytes, {} pieces in {} writes): written in {:.2f} ms, synced in {:.2f} ms ({:.0f} MiB/s)",
+            path, stats->bytes, stats->chunks, stats->writeCalls, stats->writeSeconds * 1000.0, stats->syncSeconds * 1000.0,
+            seconds > 0.0 ? static_cast<double>(stats->bytes) / seconds / (1024.0 * 1024.0) : 0.0);
+    }
+
+    /**
+     * @brief Move the cursor to the next or previous match.
+     * @param forward True for the next match after the cursor, false for the one before it.
+     */
+    void Application::selectAdjacentMatch(bool forward) {
+        const std::vector<SearchMatch>& matches = search.getMatches();
+        if (matches.empty()) {
+            return;
+        }
+
+        // Wrap around at either end of the document
+        const size_t cursor = getActiveDocument().getCursor();
+        auto match = std::upper_bound(matches.begin(), matches.end(), SearchMatch{cursor, SIZE_MAX});
+        if (forward) {
+            if (match == matches.end()) {
+                match = matches.begin();
+            }
+        } else {
+            match = std::lower_bound(matches.begin(), matches.end(), SearchMatch{cursor, 0});
+            if (match == matches.begin()) {
+                match = matches.end();
+            }
+            --match;
+        }
+
+        findMatchSelected = true;
+        selectMatch(*match);
+        updateFindTitle();
+    }
+
+    /**
+     * @brief Put a cursor at the start of every match found so far and close the find bar.
+     */
+    void Application::addCursorsAtMatches() {
+        const std::vector<SearchMatch>& matches = search.getMatches();
+        if (matches.empty()) {
+            return;
+        }
+
+        std::vector<size_t> offsets;
+        offsets.reserve(matches.size());
+        for (const SearchMatch& match : matches) {
+            offsets.push_back(match.offset);
+        }
+
+        Document& document = getActiveDocument();
+        document.getHistory().seal();
+        document.setCursors(offsets, currentMatch != SIZE_MAX ? currentMatch : offsets.front());
+        closeFind();
+        restartCursorBlink();
+        scrollToCursor();
+    }
+
+    /**
+     * @brief Move the cursor to a match and scroll it into view.
+     * @param match The match.
+     */
+    void Application::selectMatch(const SearchMatch& match) {
+        Document& document = getActiveDocument();
+        markCursorLines();
+        document.setCursor(match.offset);
+        currentMatch = match.offset;
+        markCursorLines();
+        restartCursorBlink();
+        scrollToCursor();
+    }
+
+    /**
+     * @brief Show the find query and match count in the window title.
+     */
+    void Application::updateFindTitle() {
+        if (!window) {
+            return;
+        }
+        if (!findActive) {
+            window->setTitle(WindowConfig().title);
+            return;
+        }
+
+        std::string title = "Find: " + findQuery.pattern;
+        if (findQuery.regex) {
+            title += " [regex]";
+        }
+        if (!findQuery.ignoreCase) {
+            title += " [case]";
+        }
+
+        if (!search.isActive()) {
+            title += findQuery.pattern.empty() ? "" : " (invalid)";
+        } else {
+            const std::vector<SearchMatch>& matches = search.getMatches();
+            const auto current = std::lower_bound(matches.begin(), matches.end(), SearchMatch{currentMatch, 0});
+            const bool selected = current != matches.end() && current->offset == currentMatch;
+            title += " - ";
+            title += selected ? std::to_string(current - matches.begin() + 1) + " of " : "";
+            title += std::to_string(search.getStats().matchCount);
+            title += search.isComplete() ? " matches" : "+ matches";
+        }
+        window->setTitle(title);
     }
 
     /**
      * @brief Render the application.
      */
     void Application::render() {
+        // Nothing changed since the last frame, so the screen is still correct
+        if (damage.isEmpty()) {
+            return;
+        }
+
+        DRITE_PROFILE_ZONE("render");
+        const double renderStart = StartupTrace::now();
         auto* ctx = window->getGraphicsContext();
+        ctx->beginFrame();
 
         // Clear the screen with the specified color
         constexpr ClearColor clearColor{0.1f, 0.1f, 0.2f, 1.0f};
         ctx->clear(clearColor);
+
+        // Only the damaged regions are redrawn; the rest keeps the previous frame
+        int width{0}, height{0};
+        ctx->getViewportSize(width, height);
+        updateWrap(width);
+        syncLayout();
+
+        // A line that wraps to a different number of rows moves every row below it
+        const int lineHeight = textRenderer.getLineHeight();
+        {
+            DRITE_PROFILE_ZONE("layout");
+            layout.layoutRows(getActiveDocument().getBuffer(), LayoutPosition{firstVisibleLine, firstVisibleRow},
+                static_cast<size_t>(std::max(0, (height + lineHeight - 1) / lineHeight)), nextVisibleRows);
+        }
+        const auto changed = std::mismatch(visibleRows.begin(), visibleRows.end(), nextVisibleRows.begin(), nextVisibleRows.end());
+        if (changed.first != visibleRows.end()) {
+            damage.markLines(changed.first->line, DamageTracker::ToEnd);
+        }
+        if (changed.second != nextVisibleRows.end()) {
+            damage.markLines(changed.second->line, DamageTracker::ToEnd);
+        }
+        visibleRows.swap(nextVisibleRows);
+
+        const std::vector<Rect>& rects = damage.resolve(visibleRows, lineHeight, width, height);
+        ctx->setDamage(rects);
+
+        lastPixelsRedrawn = 0;
+        for (const Rect& rect : rects) {
+            lastPixelsRedrawn += static_cast<size_t>(rect.width) * static_cast<size_t>(rect.height);
+        }
+        totalPixelsRedrawn += lastPixelsRedrawn;
+        totalSurfacePixels += static_cast<uint64_t>(width) * static_cast<uint64_t>(height);
+
+        // Draw the visible text of the active document
+        glyphAtlas.beginFrame();
+        drawList.reset(frameArena.getResource());
+        textRenderer.setCursorVisible(cursorVisible);
+        {
+            DRITE_PROFILE_ZONE("drawDocument");
+            TextDecorations decorations;
+            decorations.language = highlighter.getLanguage();
+            decorations.lineStates = lineStates;
+            if (findActive) {
+                decorations.matches = search.getMatches();
+                decorations.currentMatch = currentMatch;
+            }
+            textRenderer.drawDocument(getActiveDocument(), visibleRows, width, drawList, decorations, frameArena.getResource());
+        }
+        ctx->submit(drawList);
+
+        {
+            DRITE_PROFILE_ZONE("endFrame");
+            ctx->endFrame();
+        }
+        const CommandBufferStats& drawStats = ctx->getDrawStats();
+        drawCommands += drawStats.commands;
+        drawBatches += drawStats.batches;
+        unsortedDrawBatches += drawStats.unsortedBatches;
+        drawStateChanges += drawStats.pipelineChanges + drawStats.textureChanges;
+        damage.clear();
+        if (++framesDrawn == 1) {
+            StartupTrace::record("first frame", renderStart, StartupTrace::now());
+            StartupTrace::markFirstFrame();
+        }
+
+        reportPendingOpens();
+    }
+
+    /**
+     * @brief Scroll so the cursor of the active document is visible.
+     */
+    void Application::scrollToCursor() {
+        int width{0}, height{0};
+        window->getFramebufferSize(width, height);
+
+        updateWrap(width);
+        syncLayout();
+
+        // The view moves by as few rows as it takes to show the cursor's row
+        const TextBuffer& buffer = getActiveDocument().getBuffer();
+        const LayoutPosition cursor = layout.locate(buffer, getActiveDocument().getCursor());
+        const auto visibleLines = static_cast<ptrdiff_t>(textRenderer.getVisibleLineCount(height));
+
+        const LayoutPosition previous{firstVisibleLine, firstVisibleRow};
+        LayoutPosition top = previous;
+        if (cursor < top) {
+            top = cursor;
+        } else if (const LayoutPosition lowest = layout.scroll(buffer, cursor, 1 - visibleLines); top < lowest) {
+            top = lowest;
+        }
+
+        if (top != previous) {
+            firstVisibleLine = top.line;
+            firstVisibleRow = top.row;
+            damage.markAll();
+        }
+    }
+
+    /**
+     * @brief Mark the lines from the first to the last cursor of the active document as damaged.
+     */
+    void Application::markCursorLines() {
+        const Document& document = getActiveDocument();
+        const TextBuffer& buffer = document.getBuffer();
+        const std::span<const size_t> cursors = document.getCursors();
+        damage.markLines(buffer.offsetToPosition(cursors.front()).line, buffer.offsetToPosition(cursors.back()).line);
+    }
+
+    /**
+     * @brief Show the cursor and restart its blink timer, e.g. after typing.
+     */
+    void Application::restartCursorBlink() {
+        if (!cursorVisible) {
+            cursorVisible = true;
+            markCursorLines();
+        }
+
+        scheduler.cancel(cursorBlinkTimer);
+        cursorBlinkTimer = scheduler.schedule(platform->getTime() + CursorBlinkInterval, [this] {
+            cursorVisible = !cursorVisible;
+            markCursorLines();
+        }, CursorBlinkInterval);
+    }
+
+    /**
+     * @brief Report wakeups, frames, CPU usage and input handled by the main loop, and the page caches of paged documents.
+     */
+    void Application::reportLoopStats() {
+        if (wakeups == 0 || loopTime <= 0.0) {
+            return;
+        }
+
+        const double redrawn = totalSurfacePixels > 0
+            ? 100.0 * static_cast<double>(totalPixelsRedrawn) / static_cast<double>(totalSurfacePixels)
+            : 0.0;
+        std::println("Main loop: {} wakeups in {:.2f} s ({:.1f}/s), {} frames drawn, {:.1f}% of pixels redrawn per frame",
+            wakeups, loopTime, static_cast<double>(wakeups) / loopTime, framesDrawn, redrawn);
+        std::println("Main loop: CPU {:.2f}% of wall time, idle (blocked) {:.1f}% of wall time",
+            100.0 * loopCpuTime / loopTime, 100.0 * idleTime / loopTime);
+
+        // The first frames fill caches and grow the arena; after that a frame
+        // only allocates for edits and newly seen glyphs or lines
+        const FrameArenaStats& arenaStats = frameArena.getStats();
+        if (framesDrawn > 0) {
+            std::println("Frame memory: {} of {} frames made no heap allocation, {} allocations in the rest (at most {} in one frame)",
+                allocationFreeFrames, framesDrawn, frameAllocations, maxFrameAllocations);
+            std::println("Frame memory: arena peak {:.1f} KiB per iteration in {} KiB blocks, {} allocations spilled to the heap",
+                static_cast<double>(arenaStats.peakFrameBytes) / 1024.0, arenaStats.blockSize / 1024, arenaStats.overflows);
+        }
+
+        if (framesDrawn > 0 && drawCommands > 0) {
+            const auto perFrame = [this](uint64_t total) { return static_cast<double>(total) / static_cast<double>(framesDrawn); };
+            std::println("Draw: {:.0f} commands in {:.1f} batches per frame ({:.1f} unsorted), {:.1f} pipeline and texture binds",
+                perFrame(drawCommands), perFrame(drawBatches), perFrame(unsortedDrawBatches), perFrame(drawStateChanges));
+        }
+
+        const InputQueueStats inputStats = input.getStats();
+        if (inputStats.pushed + inputStats.dropped > 0) {
+            std::println("Input: {} events queued, {} handled, {} coalesced, {} spilled, {} dropped",
+                inputStats.pushed, inputStats.delivered, inputStats.coalesced, inputStats.spilled, inputStats.dropped);
+        }
+
+        const TextLayoutStats& layoutStats = layout.getStats();
+        if (layoutStats.hits + layoutStats.misses > 0) {
+            std::println("Layout: {} wrapped lines from cache, {} wrapped, {} evicted, {} forgotten on resize",
+                layoutStats.hits, layoutStats.misses, layoutStats.evictions, layoutStats.invalidated);
+        }
+
+        for (const std::unique_ptr<Document>& document : documents) {
+            if (const auto* paged = dynamic_cast<const PagedFile*>(document->getBuffer().getStorage().get())) {
+                constexpr double MiB = 1024.0 * 1024.0;
+                const PageCacheStats stats = paged->getStats();
+                std::println("Page cache: {} - {} hits, {} faults, {} evictions, {:.0f} MiB resident of {:.0f} MiB (peak {:.0f} MiB)",
+                    document->getPath(), stats.hits, stats.faults, stats.evictions,
+                    static_cast<double>(stats.residentPages * stats.pageSize) / MiB, static_cast<double>(stats.residentLimit) / MiB,
+                    static_cast<double>(stats.peakResidentPages * stats.pageSize) / MiB);
+            }
+        }
+
+        wakeups = 0;
+    }
+
+    /**
+     * @brief Report load and time-to-first-frame for files opened since the last frame.
+     */
+    void Application::reportPendingOpens() {
+        if (pendingOpens.empty()) {
+            return;
+        }
+
+        const double now = platform->getTime();
+        for (const PendingOpen& open : pendingOpens) {
+            std::println("Opened {} ({} bytes, {}): loaded in {:.2f} ms, first frame after {:.2f} ms",
+                open.path, open.size, open.method,
+                (open.loadedTime - open.startTime) * 1000.0,
+                (now - open.startTime) * 1000.0);
+        }
+        pendingOpens.clear();
     }
 
 }
@@ -1,8 +1,32 @@
 #pragma once
 
+#include "application/scheduler.h"
+#include "application/single_instance.h"
+#include "core/frame_arena.h"
+#include "core/job_system.h"
+#include "editor/document.h"
+#include "graphics/draw_list.h"
+#include "input/input_queue.h"
+#include "io/file_loader.h"
+#include "io/file_saver.h"
+#include "io/session_snapshot.h"
 #include "platform/platform.h"
+#include "render/builtin_font.h"
+#include "render/damage_tracker.h"
+#include "render/glyph_atlas.h"
+#include "render/text_layout.h"
+#include "render/text_renderer.h"
+#include "search/file_index.h"
+#include "search/project_search.h"
+#include "search/text_search.h"
+#include "syntax/syntax_highlighter.h"
 #include "window/window.h"
+#include <cstdint>
 #include <memory>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
 
 namespace drite {
 
@@ -52,6 +76,122 @@ namespace drite {
              */
             [[nodiscard]] Platform* getPlatform() const noexcept { return platform; }
 
+            /**
+             * @brief Get the job system shared by background work.
+             * @return Reference to the job system; results reach the main thread through postToMainThread().
+             */
+            [[nodiscard]] JobSystem& getJobs() noexcept { return jobs; }
+
+            /**
+             * @brief Set how much of a file too large for memory stays resident once opened.
+             * @param bytes The resident limit of files opened from now on; larger files are paged. 0 pages only files larger than memory.
+             */
+            void setPageCacheLimit(size_t bytes) noexcept { pageCacheLimit = bytes; }
+
+            /**
+             * @brief Open a file in a new document and make it active.
+             * @param path The path of the file, or "-" for standard input.
+             * @return True if the file was opened, false otherwise.
+             */
+            bool openFile(const std::string& path);
+
+            /**
+             * @brief Start loading files on the job system, so that opening them later only waits for the load.
+             *
+             * Call before initialize() so the files load while the window and
+             * its graphics context are created.
+             *
+             * @param paths The paths, as later passed to openFile().
+             */
+            void preloadFiles(const std::vector<std::string>& paths);
+
+            /**
+             * @brief Close the active document and make the one before it active.
+             * @return True if it was closed, false if it is being saved.
+             */
+            bool closeActiveDocument();
+
+            /**
+             * @brief Put the cursor of the active document on a line and scroll to it.
+             * @param line The 1-based line, clamped to the document.
+             * @param column The 1-based column, 0 for the start of the line.
+             */
+            void goToLine(size_t line, size_t column);
+
+            /**
+             * @brief Take files handed over by later invocations, making this the editor they open in.
+             * @param socketPath The socket to listen on.
+             * @return True if listening, false if another editor listens there or the socket failed.
+             */
+            bool listenForInstances(const std::string& socketPath);
+
+            /**
+             * @brief Get the document being edited.
+             * @return Reference to the active document.
+             */
+            [[nodiscard]] Document& getActiveDocument();
+
+            /**
+             * @brief Reopen the documents of a session snapshot and keep the snapshot up to date from now on.
+             *
+             * Documents whose files are unchanged come back with their edits,
+             * undo history, line index and highlighting; changed files are
+             * loaded afresh with only their cursors and scroll position. A
+             * missing snapshot starts an empty session.
+             *
+             * @param path The snapshot file, written again a couple of seconds after every change and on shutdown.
+             * @return The number of documents restored.
+             */
+            size_t restoreSession(const std::string& path);
+
+            /**
+             * @brief Save the active document on a worker thread, replacing the file atomically.
+             *
+             * Editing goes on while the file is written; the saved text is the
+             * document as of this call. Progress is shown in the window title.
+             *
+             * @param path The file to save to, empty for the document's own path; saving elsewhere makes it the document's path.
+             * @return True if the save was started, false if the document has no path or a save is still running.
+             */
+            bool save(const std::string& path = {});
+
+            /**
+             * @brief Open the find bar with a query and search the active document.
+             * @param query The query.
+             */
+            void find(const SearchQuery& query);
+
+            /**
+             * @brief Search the files below directories, printing matching lines as they stream in.
+             * @param roots The directories or files to search.
+             * @param query The query.
+             */
+            void findInFiles(const std::vector<std::string>& roots, const SearchQuery& query);
+
+            /**
+             * @brief Get the files matched by the last findInFiles() so far.
+             * @return The matched files, in the order they were searched.
+             */
+            [[nodiscard]] const std::vector<ProjectFileMatch>& getProjectMatches() const noexcept { return projectMatches; }
+
+            /**
+             * @brief Open quick open with a query, indexing the working directory on first use.
+             * @param query The fuzzy file name query.
+             */
+            void quickOpen(const std::string& query);
+
+            /**
+             * @brief Get the files ranked by quick open for its current query.
+             * @return The best matches, best first.
+             */
+            [[nodiscard]] const std::vector<FileMatch>& getQuickOpenMatches() const noexcept { return quickOpenMatches; }
+
+            /**
+             * @brief Get the number of pixels redrawn by the last drawn frame.
+             * @return The damaged area handed to the graphics context, in pixels.
+             */
+            [[nodiscard]] size_t getLastPixelsRedrawn() const noexcept { return lastPixelsRedrawn; }
+
         private:
             /**
              * @brief Handle window resize events.
@@ -83,17 +223,269 @@ namespace drite {
              */
             void onScroll(const ScrollEvent& event);
 
+            /**
+             * @brief Hand the input queued since the last frame to the event handlers.
+             */
+            void dispatchInput();
+
             /**
              * @brief Update the application state.
              * @param deltaTime The time elapsed since the last frame in seconds.
              */
             void update(double deltaTime);
 
+            /**
+             * @brief Hand edits to the syntax highlighter and damage lines whose highlighting changed.
+             */
+            void updateHighlighting();
+
+            /**
+             * @brief Hand the edits made to the active document since the last call to the text layout.
+             */
+            void syncLayout();
+
+            /**
+             * @brief Wrap lines to the view width, keeping the row at the top of the view in place.
+             * @param width The view width in pixels.
+             */
+            void updateWrap(int width);
+
+            /**
+             * @brief Make a document active and lay it out from the top.
+             * @param index The index of the document.
+             */
+            void showDocument(size_t index);
+
+            /**
+             * @brief Find the open document of a file.
+             * @param path The path of the file, in any form naming the same file.
+             * @return The index of the document, or std::nullopt if the file is not open.
+             */
+            [[nodiscard]] std::optional<size_t> findOpenDocument(const std::string& path) const;
+
+            /**
+             * @brief Open the files of a request from another invocation and reply to it.
+             * @param client The connection to reply to.
+             * @param request The request.
+             */
+            void handleInstanceRequest(uint64_t client, const InstanceRequest& request);
+
+            /**
+             * @brief Handle a key event while the find bar is open.
+             * @param event The key event.
+             * @return True if the event edited the query or moved between matches.
+             */
+            bool handleFindKey(const KeyEvent& event);
+
+            /**
+             * @brief Search the active document for the find query from the cursor.
+             */
+            void restartSearch();
+
+            /**
+             * @brief Close the find bar and drop its matches.
+             */
+            void closeFind();
+
+            /**
+             * @brief Pick up streamed search results, jump to the first match and damage lines whose matches changed.
+             */
+            void updateSearch();
+
+            /**
+             * @brief Pick up and print the files matched by findInFiles() since the last frame.
+             */
+            void updateProjectSearch();
+
+            /**
+             * @brief Handle a key event while quick open is shown.
+             * @param event The key event.
+             * @return True if the event edited the query or opened a file.
+             */
+            bool handleQuickOpenKey(const KeyEvent& event);
+
+            /**
+             * @brief Rank the indexed files for the quick open query and show the best in the window title.
+             */
+            void rankQuickOpen();
+
+            /**
+             * @brief Close quick open.
+             */
+            void closeQuickOpen();
+
+            /**
+             * @brief Pick up a finished refresh of the file index and rank its files again.
+             */
+            void updateQuickOpen();
+
+            /**
+             * @brief Show how much of the file being saved was written in the window title.
+             * @param written The bytes written so far.
+             * @param total The size of the saved text in bytes.
+             */
+            void showSaveProgress(size_t written, size_t total);
+
+            /**
+             * @brief Report a finished save and adopt its path for the document.
+             * @param document The saved document.
+             * @param path The file it was saved to.
+             * @param stats The save counters, or std::nullopt if the save failed.
+             */
+            void finishSave(Document& document, const std::string& path, const std::optional<SaveStats>& stats);
+
+            /**
+             * @brief What the session snapshot holds of an open document.
+             */
+            struct SessionEntry {
+                uint64_t id{0};
+
+                /**
+                 * @brief The file the document was loaded from, for checking it on restore.
+                 */
+                FileStamp stamp;
+                int64_t stampedNanoseconds{0};
+                uint64_t contentHash{0};
+
+                /**
+                 * @brief The index of the original text of a document backed by a file, shared by every snapshot.
+                 */
+                std::shared_ptr<const LineIndex> lineIndex;
+
+                /**
+                 * @brief Highlighting results kept while the document is not active.
+                 */
+                std::shared_ptr<const HighlightTable> highlights;
+
+                /**
+                 * @brief The document as last encoded into section.
+                 */
+                std::string encodedPath;
+                uint64_t encodedRevision{UINT64_MAX};
+                std::vector<size_t> encodedCursors;
+                size_t encodedCursor{0};
+                size_t encodedScrollLine{0};
+                std::shared_ptr<const HighlightTable> encodedHighlights;
+                std::shared_ptr<const SessionSection> section;
+            };
+
+            /**
+             * @brief Get the session entry of a document, adding one if it has none.
+             * @param document The document.
+             * @return Reference to the entry.
+             */
+            SessionEntry& getSessionEntry(const Document& document);
+
+            /**
+             * @brief Get the highlighting results the session snapshot would keep of a document.
+             * @param entry The session entry of the document.
+             * @param document The document.
+             * @return The results, or nullptr if none match its text.
+             */
+            [[nodiscard]] std::shared_ptr<const HighlightTable> getSessionHighlights(const SessionEntry& entry, const Document& document) const;
+
+            /**
+             * @brief Check whether a document changed since its session section was encoded.
+             * @param entry The session entry of the document.
+             * @param document The document.
+             * @return True if the section has to be encoded again.
+             */
+            [[nodiscard]] bool isSessionOutdated(const SessionEntry& entry, const Document& document) const;
+
+            /**
+             * @brief Schedule writing the session snapshot if anything in it changed and no write is scheduled.
+             */
+            void scheduleSessionSave();
+
+            /**
+             * @brief A document of a session snapshot being written: its cached section, or its state to encode.
+             */
+            struct SessionPart {
+                const Document* document{nullptr};
+                uint64_t id{0};
+                std::shared_ptr<const SessionSection> section;
+                std::optional<SessionDocumentState> state;
+                uint64_t contentHash{0};
+            };
+
+            /**
+             * @brief Check whether the session snapshot keeps a document: all but an empty untitled one.
+             * @param document The document.
+             * @return True if the document is kept.
+             */
+            [[nodiscard]] static bool isKeptInSession(const Document& document) noexcept;
+
+            /**
+             * @brief Check whether anything in the session changed since the snapshot was last written.
+             * @return True if the snapshot has to be written again.
+             */
+            [[nodiscard]] bool isSessionChanged();
+
+            /**
+             * @brief Write the session snapshot on a worker thread, encoding only the documents that changed.
+             */
+            void saveSession();
+
+            /**
+             * @brief Keep the sections encoded by a session write, once it finished.
+             * @param parts The documents written, in order.
+             * @param active The index of the active document among them.
+             * @param written Whether the snapshot was written.
+             */
+            void finishSessionSave(const std::vector<SessionPart>& parts, size_t active, bool written);
+
+            /**
+             * @brief Move the cursor to the next or previous match.
+             * @param forward True for the next match after the cursor, false for the one before it.
+             */
+            void selectAdjacentMatch(bool forward);
+
+            /**
+             * @brief Put a cursor at the start of every match found so far and close the find bar.
+             */
+            void addCursorsAtMatches();
+
+            /**
+             * @brief Move the cursor to a match and scroll it into view.
+             * @param match The match.
+             */
+            void selectMatch(const SearchMatch& match);
+
+            /**
+             * @brief Show the find query and match count in the window title.
+             */
+            void updateFindTitle();
+
             /**
              * @brief Render the application.
              */
             void render();
 
+            /**
+             * @brief Scroll so the cursor of the active document is visible.
+             */
+            void scrollToCursor();
+
+            /**
+             * @brief Mark the lines from the first to the last cursor of the active document as damaged.
+             */
+            void markCursorLines();
+
+            /**
+             * @brief Show the cursor and restart its blink timer, e.g. after typing.
+             */
+            void restartCursorBlink();
+
+            /**
+             * @brief Report wakeups, frames, CPU usage and input handled by the main loop, and the page caches of paged documents.
+             */
+            void reportLoopStats();
+
+            /**
+             * @brief Report load and time-to-first-frame for files opened since the last frame.
+             */
+            void reportPendingOpens();
+
         private:
             /**
              * @brief The platform abstraction instance.
@@ -105,6 +497,365 @@ namespace drite {
              */
             std::unique_ptr<Window> window{nullptr};
 
+            /**
+             * @brief Worker threads for background and per-frame jobs; declared early so it outlives their users.
+             */
+            JobSystem jobs;
+
+            /**
+             * @brief A file open whose time-to-first-frame has not been reported yet.
+             */
+            struct PendingOpen {
+                std::string path;
+                const char* method{nullptr};
+                size_t size{0};
+                double startTime{0.0};
+                double loadedTime{0.0};
+            };
+
+            /**
+             * @brief The open documents.
+             */
+            std::vector<std::unique_ptr<Document>> documents;
+
+            /**
+             * @brief Resident limit of paged files, 0 to page only files larger than memory.
+             */
+            size_t pageCacheLimit{0};
+
+            /**
+             * @brief Index of the document receiving input.
+             */
+            size_t activeDocument{0};
+
+            /**
+             * @brief Highlights the active document on a background thread.
+             */
+            SyntaxHighlighter highlighter;
+
+            /**
+             * @brief Lexer state at the start of each visible line, as last drawn.
+             */
+            std::vector<LexState> lineStates;
+
+            /**
+             * @brief Lexer states computed for the next frame, swapped with lineStates.
+             */
+            std::vector<LexState> nextLineStates;
+
+            /**
+             * @brief Searches the active document on worker threads.
+             */
+            TextSearch search;
+
+            /**
+             * @brief Whether the find bar is open and typing edits the query.
+             */
+            bool findActive{false};
+
+            /**
+             * @brief The query of the find bar.
+             */
+            SearchQuery findQuery;
+
+            /**
+             * @brief Whether the cursor already moved to a match of the current search.
+             */
+            bool findMatchSelected{false};
+
+            /**
+             * @brief Offset of the match the cursor was moved to, or SIZE_MAX for none.
+             */
+            size_t currentMatch{SIZE_MAX};
+
+            /**
+             * @brief Buffer revision the current search ran on.
+             */
+            uint64_t searchRevision{0};
+
+            /**
+             * @brief Matches drawn over the visible lines by the last frame.
+             */
+            std::vector<SearchMatch> visibleMatches;
+
+            /**
+             * @brief Matches over the visible lines for the next frame, swapped with visibleMatches.
+             */
+            std::vector<SearchMatch> nextVisibleMatches;
+
+            /**
+             * @brief Searches the files below directories on worker threads.
+             */
+            ProjectSearch projectSearch{jobs};
+
+            /**
+             * @brief Files matched by the last findInFiles() so far.
+             */
+            std::vector<ProjectFileMatch> projectMatches;
+
+            /**
+             * @brief Number of files in projectMatches already printed.
+             */
+            size_t printedProjectMatches{0};
+
+            /**
+             * @brief Indexes the files below the working directory for quick open.
+             */
+            FileIndex fileIndex;
+
+            /**
+             * @brief Whether quick open is shown and typing edits its query.
+             */
+            bool quickOpenActive{false};
+
+            /**
+             * @brief The fuzzy file name query of quick open.
+             */
+            std::string quickOpenQuery;
+
+            /**
+             * @brief The files ranked for quickOpenQuery, best first.
+             */
+            std::vector<FileMatch> quickOpenMatches;
+
+            /**
+             * @brief The running or last save, waited for on shutdown so a file is never left half-replaced.
+             */
+            JobHandle saveJob;
+
+            /**
+             * @brief The file saveJob writes.
+             */
+            std::string savePath;
+
+            /**
+             * @brief The document saveJob writes, until its save is finished.
+             */
+            const Document* savedDocument{nullptr};
+
+            /**
+             * @brief The session snapshot file, empty if the session is not kept.
+             */
+            std::string sessionPath;
+
+            /**
+             * @brief The session entries of the open documents.
+             */
+            std::unordered_map<const Document*, SessionEntry> sessionEntries;
+
+            /**
+             * @brief The id of the next session entry.
+             */
+            uint64_t nextSessionEntry{1};
+
+            /**
+             * @brief The entries and active document in the session snapshot as last written.
+             */
+            std::vector<uint64_t> sessionWritten;
+            size_t sessionWrittenActive{SIZE_MAX};
+
+            /**
+             * @brief The running or last session write.
+             */
+            JobHandle sessionJob;
+
+            /**
+             * @brief The timer writing the session snapshot after a change.
+             */
+            Scheduler::TimerId sessionTimer{Scheduler::InvalidTimer};
+
+            /**
+             * @brief File opens waiting for their first rendered frame.
+             */
+            std::vector<PendingOpen> pendingOpens;
+
+            /**
+             * @brief A file loading ahead of openFile().
+             */
+            struct Preload {
+                std::string path;
+                JobHandle job;
+                std::optional<LoadedFile> loaded;
+            };
+
+            /**
+             * @brief Files loading ahead of openFile(), in the order given.
+             */
+            std::vector<std::unique_ptr<Preload>> preloads;
+
+            /**
+             * @brief An invocation waiting for the documents it opened to be closed.
+             */
+            struct InstanceWaiter {
+                uint64_t client{0};
+                std::vector<const Document*> documents;
+            };
+
+            /**
+             * @brief Serves later invocations handing files over.
+             */
+            InstanceServer instanceServer;
+
+            /**
+             * @brief Invocations run with --wait whose documents are still open.
+             */
+            std::vector<InstanceWaiter> instanceWaiters;
+
+            /**
+             * @brief Rasterizer for the built-in font.
+             */
+            BuiltinFontRasterizer fontRasterizer;
+
+            /**
+             * @brief Cache of rasterized glyphs shared by all documents.
+             */
+            GlyphAtlas glyphAtlas{fontRasterizer};
+
+            /**
+             * @brief Lays out and draws document text.
+             */
+            TextRenderer textRenderer{glyphAtlas};
+
+            /**
+             * @brief Memory for data that lives for one iteration of the main loop, such as draw commands.
+             */
+            FrameArena frameArena;
+
+            /**
+             * @brief Draw commands of the frame being rendered, stored in the frame arena.
+             */
+            DrawList drawList;
+
+            /**
+             * @brief Soft-wraps the active document to the view width.
+             */
+            TextLayout layout;
+
+            /**
+             * @brief The line of the active document at the top of the viewport.
+             */
+            size_t firstVisibleLine{0};
+
+            /**
+             * @brief The visual row of firstVisibleLine at the top of the viewport.
+             */
+            size_t firstVisibleRow{0};
+
+            /**
+             * @brief The visual rows of the viewport, as last drawn.
+             */
+            std::vector<VisualRow> visibleRows;
+
+            /**
+             * @brief Visual rows laid out for the next frame, swapped with visibleRows.
+             */
+            std::vector<VisualRow> nextVisibleRows;
+
+            /**
+             * @brief Edits taken from the active document for the layout and not yet handed to the highlighter.
+             */
+            std::optional<LineChange> pendingLineChange;
+
+            /**
+             * @brief Regions that changed since the last drawn frame.
+             */
+            DamageTracker damage;
+
+            /**
+             * @brief Timers and frame pacing for the main loop.
+             */
+            Scheduler scheduler;
+
+            /**
+             * @brief Input events waiting for the next frame.
+             */
+            InputQueue input;
+
+            /**
+             * @brief The timer toggling the cursor visibility.
+             */
+            Scheduler::TimerId cursorBlinkTimer{Scheduler::InvalidTimer};
+
+            /**
+             * @brief Whether the blinking cursor is currently shown.
+             */
+            bool cursorVisible{true};
+
+            /**
+             * @brief Number of times the main loop woke up.
+             */
+            uint64_t wakeups{0};
+
+            /**
+             * @brief Wall time spent blocked waiting for events, in seconds.
+             */
+            double idleTime{0.0};
+
+            /**
+             * @brief Wall time spent in run(), in seconds.
+             */
+            double loopTime{0.0};
+
+            /**
+             * @brief Process CPU time spent in run(), in seconds.
+             */
+            double loopCpuTime{0.0};
+
+            /**
+             * @brief Number of frames drawn.
+             */
+            uint64_t framesDrawn{0};
+
+            /**
+             * @brief Heap allocations made by the main thread while drawing frames.
+             */
+            uint64_t frameAllocations{0};
+
+            /**
+             * @brief Most heap allocations one drawn frame made.
+             */
+            uint64_t maxFrameAllocations{0};
+
+            /**
+             * @brief Drawn frames that made no heap allocation.
+             */
+            uint64_t allocationFreeFrames{0};
+
+            /**
+             * @brief Draw commands submitted over all drawn frames.
+             */
+            uint64_t drawCommands{0};
+
+            /**
+             * @brief Batches the submitted commands were sorted into, over all drawn frames.
+             */
+            uint64_t drawBatches{0};
+
+            /**
+             * @brief Batches the submitted commands would have taken unsorted, over all drawn frames.
+             */
+            uint64_t unsortedDrawBatches{0};
+
+            /**
+             * @brief Pipeline and texture binds over all drawn frames.
+             */
+            uint64_t drawStateChanges{0};
+
+            /**
+             * @brief Pixels redrawn by the last drawn frame.
+             */
+            size_t lastPixelsRedrawn{0};
+
+            /**
+             * @brief Pixels redrawn over all drawn frames.
+             */
+            uint64_t totalPixelsRedrawn{0};
+
+            /**
+             * @brief Surface pixels over all drawn frames, the cost of redrawing everything.
+             */
+            uint64_t totalSurfacePixels{0};
+
             /**
              * @brief Flag indicating whether the application is running.
              */
@@ -114,6 +865,11 @@ namespace drite {
              * @brief The time of the last frame in seconds.
              */
             double lastFrameTime{0.0};
+
+            /**
+             * @brief The time of the last handled key press in seconds.
+             */
+            double lastKeyTime{0.0};
         };
 
 }
@@ -0,0 +1,202 @@
+#include "application/command_line.h"
+#include <charconv>
+#include <print>
+#include <string_view>
+
+namespace drite {
+
+    /**
+     * @brief Parse a numeric option value.
+     * @param text The option value.
+     * @param value Receives the parsed number.
+     * @return True if the whole value was a valid number.
+     */
+    template<typename T>
+    static bool parseNumber(std::string_view text, T& value) {
+        const char* end = text.data() + text.size();
+        const auto result = std::from_chars(text.data(), end, value);
+        return result.ec == std::errc() && result.ptr == end;
+    }
+
+    /**
+     * @brief Parse the process arguments.
+     * @param argc The argument count.
+     * @param argv The argument vector.
+     * @return The parsed options, or std::nullopt if the arguments are invalid.
+     */
+    std::optional<CommandLineOptions> parseCommandLine(int argc, char** argv) {
+        CommandLineOptions options;
+        bool endOfOptions{false};
+
+        for (int i = 1; i < argc; ++i) {
+            const std::string_view argument = argv[i];
+
+            // Options taking a value read it from the next argument
+            const auto nextValue = [&](std::string_view& value) {
+                if (i + 1 >= argc) {
+                    std::println(stderr, "Missing value for option: {}", argument);
+                    return false;
+                }
+                value = argv[++i];
+                return true;
+            };
+
+            std::string_view value;
+            if (endOfOptions || argument == "-" || !argument.starts_with('-')) {
+                options.files.emplace_back(argument);
+            } else if (argument == "--") {
+                endOfOptions = true;
+            } else if (argument == "-h" || argument == "--help") {
+                options.showHelp = true;
+            } else if (argument == "--headless") {
+                options.headless = true;
+            } else if (argument == "--frames") {
+                if (!nextValue(value) || !parseNumber(value, options.frameLimit)) {
+                    std::println(stderr, "Invalid frame count: {}", value);
+                    return std::nullopt;
+                }
+            } else if (argument == "--time-step") {
+                if (!nextValue(value) || !parseNumber(value, options.timeStep) || options.timeStep < 0.0) {
+                    std::println(stderr, "Invalid time step: {}", value);
+                    return std::nullopt;
+                }
+            } else if (argument == "--duration") {
+                if (!nextValue(value) || !parseNumber(value, options.duration) || options.duration < 0.0) {
+                    std::println(stderr, "Invalid duration: {}", value);
+                    return std::nullopt;
+                }
+            } else if (argument == "--dump-frame") {
+                if (!nextValue(value) || value.empty()) {
+                    std::println(stderr, "Invalid frame dump path: {}", value);
+                    return std::nullopt;
+                }
+                options.dumpFramePath = value;
+            } else if (argument == "--profile") {
+                if (!nextValue(value) || value.empty()) {
+                    std::println(stderr, "Invalid trace path: {}", value);
+                    return std::nullopt;
+                }
+                options.profilePath = value;
+            } else if (argument == "--find" || argument == "--find-regex") {
+                if (!nextValue(value) || value.empty()) {
+                    std::println(stderr, "Invalid search pattern: {}", value);
+                    return std::nullopt;
+                }
+                options.findPattern = value;
+                options.findRegex = argument == "--find-regex";
+            } else if (argument == "--grep" || argument == "--grep-regex") {
+                if (!nextValue(value) || value.empty()) {
+                    std::println(stderr, "Invalid search pattern: {}", value);
+                    return std::nullopt;
+                }
+                options.grepPattern = value;
+                options.grepRegex = argument == "--grep-regex";
+            } else if (argument == "--find-file") {
+                if (!nextValue(value) || value.empty()) {
+                    std::println(stderr, "Invalid file query: {}", value);
+                    return std::nullopt;
+                }
+                options.findFilePattern = value;
+            } else if (argument == "--save-as") {
+                if (!nextValue(value) || value.empty()) {
+                    std::println(stderr, "Invalid save path: {}", value);
+                    return std::nullopt;
+                }
+                options.saveAsPath = value;
+            } else if (argument == "--goto") {
+                // LINE or LINE:COLUMN, both 1-based
+                if (!nextValue(value)) {
+                    return std::nullopt;
+                }
+                const size_t colon = value.find(':');
+                const std::string_view line = value.substr(0, colon);
+                const std::string_view column = colon == std::string_view::npos ? std::string_view{} : value.substr(colon + 1);
+                if (!parseNumber(line, options.gotoLine) || options.gotoLine == 0 ||
+                    (colon != std::string_view::npos && (!parseNumber(column, options.gotoColumn) || options.gotoColumn == 0))) {
+                    std::println(stderr, "Invalid line: {}", value);
+                    return std::nullopt;
+                }
+            } else if (argument == "--wait") {
+                options.wait = true;
+            } else if (argument == "--new-instance") {
+                options.newInstance = true;
+            } else if (argument == "--socket") {
+                if (!nextValue(value) || value.empty()) {
+                    std::println(stderr, "Invalid socket path: {}", value);
+                    return std::nullopt;
+                }
+                options.socketPath = value;
+            } else if (argument == "--trace-startup") {
+                options.traceStartup = true;
+            } else if (argument == "--session") {
+                if (!nextValue(value) || value.empty()) {
+                    std::println(stderr, "Invalid session path: {}", value);
+                    return std::nullopt;
+                }
+                options.sessionPath = value;
+            } else if (argument == "--page-cache") {
+                if (!nextValue(value) || !parseNumber(value, options.pageCacheMiB) || options.pageCacheMiB == 0) {
+                    std::println(stderr, "Invalid page cache size: {}", value);
+                    return std::nullopt;
+                }
+            } else if (argument == "-i" || argument == "--ignore-case") {
+                options.ignoreCase = true;
+            } else if (argument == "--threads") {
+                if (!nextValue(value) || !parseNumber(value, options.threadCount)) {
+                    std::println(stderr, "Invalid thread count: {}", value);
+                    return std::nullopt;
+                }
+            } else if (argument == "--input-flood") {
+                if (!nextValue(value) || !parseNumber(value, options.inputFloodRate) || options.inputFloodRate < 0.0) {
+                    std::println(stderr, "Invalid input flood rate: {}", value);
+                    return std::nullopt;
+                }
+            } else {
+                std::println(stderr, "Unknown option: {}", argument);
+                return std::nullopt;
+            }
+        }
+
+        return options;
+    }
+
+    /**
+     * @brief Print usage information to standard output.
+     */
+    void printUsage() {
+        std::println("Usage: drite [options] [file...]");
+        std::println("       drite --grep PATTERN [options] [directory...]");
+        std::println("       drite --find-file QUERY [directory]");
+        std::println("");
+        std::println("Opens each file for editing. Use '-' to read from standard input.");
+        std::println("If an editor of the same user is running, the files open in it instead and this one exits.");
+        std::println("With --grep, prints the lines matching PATTERN in the files below each directory instead.");
+        std::println("With --find-file, prints the paths below the directory best matching QUERY as typed in quick open.");
+        std::println("");
+        std::println("Options:");
+        std::println("  --headless            Run without a display, rendering offscreen");
+        std::println("  --frames N            Exit after N main loop iterations (headless only)");
+        std::println("  --duration SECONDS    Exit after SECONDS of platform time (headless only)");
+        std::println("  --time-step SECONDS   Advance a virtual clock by a fixed step per frame (headless only)");
+        std::println("  --dump-frame PATH     Write the last frame as raw BGRA8 to PATH on exit (headless only)");
+        std::println("  --input-flood HZ      Inject synthetic mouse moves and scrolls at HZ events per second (headless only)");
+        std::println("  --find TEXT           Open the find bar searching the last file for TEXT, ignoring case");
+        std::println("  --find-regex REGEX    Open the find bar searching the last file for a regular expression");
+        std::println("  --grep TEXT           Search the files below the given directories, default '.', skipping ignored and binary files");
+        std::println("  --grep-regex REGEX    Like --grep, matching a regular expression");
+        std::println("  --find-file QUERY     Rank the paths below the given directory, default '.', by fuzzy match");
+        std::println("  -i, --ignore-case     Ignore case in --grep and --grep-regex");
+        std::println("  --page-cache MIB      Page files larger than MIB, keeping MIB of each resident (default 256 for files over half the memory)");
+        std::println("  --goto LINE[:COLUMN]  Put the cursor on LINE, and COLUMN, of the last file");
+        std::println("  --wait                Return once the files were closed in the editor, for use as $EDITOR");
+        std::println("  --new-instance        Start a new editor even if one is running, and do not accept files from later ones");
+        std::println("  --socket PATH         Hand files to, or accept them on, PATH instead of the per-user socket; its directory must be writable by the user alone");
+        std::println("  --session FILE        Reopen the documents kept in FILE, with their edits and undo history, and keep them there");
+        std::println("  --save-as PATH        Save the last file to PATH in the background, as Cmd/Ctrl+S does");
+        std::println("  --threads N           Search with N worker threads (--grep); default one per core");
+        std::println("  --profile PATH        Time frame phases, print p50/p99/max per zone and write a Chrome trace to PATH");
+        std::println("  --trace-startup       Print each startup phase, its thread and the time to the first frame on exit");
+        std::println("  -h, --help            Show this help message");
+    }
+
+}
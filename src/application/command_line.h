@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace drite {
+
+    /**
+     * @brief Options parsed from the command line.
+     */
+    struct CommandLineOptions {
+        std::vector<std::string> files;
+        bool headless{false};
+        uint64_t frameLimit{0};
+        double timeStep{0.0};
+        double duration{0.0};
+        std::string dumpFramePath;
+        double inputFloodRate{0.0};
+        std::string profilePath;
+        std::string findPattern;
+        bool findRegex{false};
+        std::string grepPattern;
+        bool grepRegex{false};
+        bool ignoreCase{false};
+        unsigned threadCount{0};
+        std::string findFilePattern;
+        std::string saveAsPath;
+        size_t pageCacheMiB{0};
+        size_t gotoLine{0};
+        size_t gotoColumn{0};
+        bool wait{false};
+        bool newInstance{false};
+        std::string socketPath;
+        bool traceStartup{false};
+        std::string sessionPath;
+        bool showHelp{false};
+    };
+
+    /**
+     * @brief Parse the process arguments.
+     * @param argc The argument count.
+     * @param argv The argument vector.
+     * @return The parsed options, or std::nullopt if the arguments are invalid.
+     */
+    [[nodiscard]] std::optional<CommandLineOptions> parseCommandLine(int argc, char** argv);
+
+    /**
+     * @brief Print usage information to standard output.
+     */
+    void printUsage();
+
+}
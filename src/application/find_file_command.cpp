@@ -0,0 +1,78 @@
+#include "application/find_file_command.h"
+#include "search/file_index.h"
+#include "search/fuzzy_match.h"
+#include <condition_variable>
+#include <mutex>
+#include <print>
+
+namespace drite {
+
+    /**
+     * @brief Number of paths printed.
+     */
+    static constexpr size_t ResultLimit = 20;
+
+    /**
+     * @brief Run a query one keystroke at a time, reporting each one's time.
+     * @param index The index.
+     * @param query The query.
+     * @param matches Receives the matches of the whole query.
+     */
+    static void typeQuery(FileIndex& index, const std::string& query, std::vector<FileMatch>& matches) {
+        double slowest{0.0};
+        for (size_t length = 1; length <= query.size(); ++length) {
+            index.find(std::string_view(query).substr(0, length), ResultLimit, matches);
+            const FileIndexStats& stats = index.getStats();
+            slowest = std::max(slowest, stats.findSeconds);
+            std::println(stderr, "Find file: \"{}\" {} candidates, {} scored in {:.3f} ms", query.substr(0, length), stats.candidates,
+                stats.scored, stats.findSeconds * 1000.0);
+        }
+        std::println(stderr, "Find file: slowest keystroke {:.3f} ms over {} paths ({})", slowest * 1000.0,
+            index.getStats().files, getMaskFilterName());
+    }
+
+    /**
+     * @brief Print the paths below a directory best matching --find-file.
+     * @param options The parsed options, with a find-file query.
+     * @return The exit status: 0 if a path matched, 1 if none did.
+     */
+    int runFindFile(const CommandLineOptions& options) {
+        std::mutex mutex;
+        std::condition_variable indexReady;
+        bool ready{false};
+        FileIndex index;
+        index.setReadyCallback([&] {
+            {
+                std::lock_guard lock(mutex);
+                ready = true;
+            }
+            indexReady.notify_one();
+        });
+
+        const std::string root = options.files.empty() ? "." : options.files.front();
+        std::vector<FileMatch> matches;
+        if (index.open(root, FileIndex::getDefaultCachePath(root))) {
+            std::println(stderr, "Find file: mapped cached index of {} files in {:.3f} ms", index.getStats().files,
+                index.getStats().loadSeconds * 1000.0);
+            typeQuery(index, options.findFilePattern, matches);
+        }
+
+        // Wait for the refresh, which only relists changed directories
+        {
+            std::unique_lock lock(mutex);
+            indexReady.wait(lock, [&] { return ready; });
+        }
+        if (index.poll()) {
+            const FileIndexStats& stats = index.getStats();
+            std::println(stderr, "Find file: indexed {} files in {} directories in {:.2f} ms ({} listed, {} unchanged)",
+                stats.files, stats.directories, stats.refreshSeconds * 1000.0, stats.rescannedDirectories, stats.reusedDirectories);
+        }
+        typeQuery(index, options.findFilePattern, matches);
+
+        for (const FileMatch& match : matches) {
+            std::println("{}", match.path);
+        }
+        return matches.empty() ? 1 : 0;
+    }
+
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include "application/command_line.h"
+
+namespace drite {
+
+    /**
+     * @brief Print the paths below a directory best matching --find-file.
+     *
+     * The query is typed one character at a time against the cached index,
+     * if any, and again once the index was refreshed, reporting the time of
+     * each keystroke and of the load and refresh on standard error.
+     *
+     * @param options The parsed options, with a find-file query.
+     * @return The exit status: 0 if a path matched, 1 if none did.
+     */
+    [[nodiscard]] int runFindFile(const CommandLineOptions& options);
+
+}
@@ -0,0 +1,87 @@
+#include "application/grep_command.h"
+#include "core/job_system.h"
+#include "search/literal_search.h"
+#include "search/project_search.h"
+#include <condition_variable>
+#include <cstdio>
+#include <mutex>
+#include <print>
+
+namespace drite {
+
+    /**
+     * @brief Print the lines matching --grep in the files below the given directories.
+     * @param options The parsed options, with a grep pattern.
+     * @return The exit status: 0 if a line matched, 1 if none did, 2 on error.
+     */
+    int runGrep(const CommandLineOptions& options) {
+        SearchQuery query;
+        query.pattern = options.grepPattern;
+        query.ignoreCase = options.ignoreCase;
+        query.regex = options.grepRegex;
+
+        // Workers only flag new results; this thread formats and writes them
+        std::mutex mutex;
+        std::condition_variable resultsReady;
+        bool ready{false};
+        // There is no editor here, so the search gets a job system of its own
+        JobSystem jobs(options.threadCount);
+        ProjectSearch search(jobs);
+        search.setResultCallback([&] {
+            {
+                std::lock_guard lock(mutex);
+                ready = true;
+            }
+            resultsReady.notify_one();
+        });
+
+        const std::vector<std::string> roots = options.files.empty() ? std::vector<std::string>{"."} : options.files;
+        if (!search.start(roots, query)) {
+            return 2;
+        }
+
+        std::vector<ProjectFileMatch> results;
+        std::string output;
+        while (!search.isComplete()) {
+            {
+                std::unique_lock lock(mutex);
+                resultsReady.wait(lock, [&] { return ready; });
+                ready = false;
+            }
+
+            results.clear();
+            if (!search.poll(results)) {
+                continue;
+            }
+
+            // One write per batch keeps the output of a file together and the syscalls few
+            output.clear();
+            for (const ProjectFileMatch& file : results) {
+                for (const ProjectLineMatch& line : file.lines) {
+                    output += file.path;
+                    output += ':';
+                    output += std::to_string(line.line);
+                    output += ':';
+                    output += line.text;
+                    output += '\n';
+                }
+            }
+            std::fwrite(output.data(), 1, output.size(), stdout);
+        }
+        std::fflush(stdout);
+
+        const ProjectSearchStats& stats = search.getStats();
+        const double megabytes = static_cast<double>(stats.bytesSearched) / (1024.0 * 1024.0);
+        std::println(stderr, "Grep: {} lines in {} files; searched {} files ({:.1f} MiB) in {} directories in {:.2f} ms "
+            "({:.0f} MiB/s, {} threads, {} steals, {})",
+            stats.matchedLines, stats.filesMatched, stats.filesSearched, megabytes, stats.directories, stats.seconds * 1000.0,
+            stats.seconds > 0.0 ? megabytes / stats.seconds : 0.0, search.getThreadCount(), stats.steals,
+            query.regex ? "regex" : getLiteralSearchName());
+        std::println(stderr, "Grep: skipped {} binary files and {} ignored paths", stats.binaryFiles, stats.ignoredPaths);
+        if (stats.skippedLines > 0) {
+            std::println(stderr, "Grep: skipped {} lines longer than {} bytes", stats.skippedLines, PatternMatcher::MaxRegexLineBytes);
+        }
+        return stats.matchedLines > 0 ? 0 : 1;
+    }
+
+}
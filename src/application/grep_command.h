@@ -0,0 +1,18 @@
+#pragma once
+
+#include "application/command_line.h"
+
+namespace drite {
+
+    /**
+     * @brief Print the lines matching --grep in the files below the given directories.
+     *
+     * Results are written to standard output as path:line:text as each file
+     * finishes, in no particular file order; a summary goes to standard error.
+     *
+     * @param options The parsed options, with a grep pattern.
+     * @return The exit status: 0 if a line matched, 1 if none did, 2 on error.
+     */
+    [[nodiscard]] int runGrep(const CommandLineOptions& options);
+
+}
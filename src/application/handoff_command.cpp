@@ -0,0 +1,90 @@
+#include "application/handoff_command.h"
+#include "application/single_instance.h"
+#include <climits>
+#include <print>
+#include <unistd.h>
+
+namespace drite {
+
+    /**
+     * @brief Check whether this invocation takes part in single instance mode.
+     * @param options The parsed options.
+     * @return True if files are handed to, or accepted from, other invocations.
+     */
+    bool usesSingleInstance(const CommandLineOptions& options) {
+        return !options.newInstance && (!options.headless || !options.socketPath.empty());
+    }
+
+    /**
+     * @brief Get the socket this invocation hands files to or accepts them on.
+     * @param options The parsed options.
+     * @return The --socket path, or the per-user socket.
+     */
+    std::string getHandoffSocketPath(const CommandLineOptions& options) {
+        return options.socketPath.empty() ? getInstanceSocketPath() : options.socketPath;
+    }
+
+    /**
+     * @brief Build the request for the files on the command line.
+     * @param options The parsed options.
+     * @return The request, or std::nullopt if a file cannot be handed over.
+     */
+    static std::optional<InstanceRequest> buildRequest(const CommandLineOptions& options) {
+        char buffer[PATH_MAX];
+        if (::getcwd(buffer, sizeof(buffer)) == nullptr) {
+            return std::nullopt;
+        }
+        const std::string directory = buffer;
+
+        InstanceRequest request;
+        for (const std::string& file : options.files) {
+            // The protocol is line based, and standard input is this process's
+            if (file == "-" || file.empty() || file.find('\n') != std::string::npos) {
+                return std::nullopt;
+            }
+            request.files.push_back(file.front() == '/' ? file : directory + '/' + file);
+        }
+        request.line = options.gotoLine;
+        request.column = options.gotoColumn;
+        request.wait = options.wait;
+        return request;
+    }
+
+    /**
+     * @brief Hand the files on the command line to a running editor.
+     * @param options The parsed options.
+     * @return The exit status if a running editor took the files, or std::nullopt to start an editor.
+     */
+    std::optional<int> runHandoff(const CommandLineOptions& options) {
+        if (!usesSingleInstance(options) || !options.findPattern.empty() || !options.saveAsPath.empty() || !options.profilePath.empty() ||
+            !options.sessionPath.empty()) {
+            return std::nullopt;
+        }
+        const std::optional<InstanceRequest> request = buildRequest(options);
+        if (!request) {
+            return std::nullopt;
+        }
+
+        InstanceClient client;
+        if (!client.connect(getHandoffSocketPath(options))) {
+            return std::nullopt;
+        }
+
+        // Once connected the running editor owns the files; a failure from
+        // here on is reported rather than opening them a second time
+        const std::optional<std::string> reply = client.send(*request);
+        if (!reply) {
+            std::println(stderr, "Handoff: the running editor closed the connection");
+            return 1;
+        }
+        if (*reply != "ok") {
+            std::println(stderr, "Handoff: {}", reply->starts_with("error ") ? reply->substr(6) : *reply);
+        }
+        if (options.wait && !client.waitUntilDone()) {
+            std::println(stderr, "Handoff: the running editor closed the connection");
+            return 1;
+        }
+        return *reply == "ok" ? 0 : 1;
+    }
+
+}
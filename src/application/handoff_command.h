@@ -0,0 +1,41 @@
+#pragma once
+
+#include "application/command_line.h"
+#include <optional>
+#include <string>
+
+namespace drite {
+
+    /**
+     * @brief Check whether this invocation takes part in single instance mode.
+     *
+     * Editors with a window do unless started with --new-instance; headless
+     * ones only with an explicit --socket, so scripted runs stay independent.
+     *
+     * @param options The parsed options.
+     * @return True if files are handed to, or accepted from, other invocations.
+     */
+    [[nodiscard]] bool usesSingleInstance(const CommandLineOptions& options);
+
+    /**
+     * @brief Get the socket this invocation hands files to or accepts them on.
+     * @param options The parsed options.
+     * @return The --socket path, or the per-user socket.
+     */
+    [[nodiscard]] std::string getHandoffSocketPath(const CommandLineOptions& options);
+
+    /**
+     * @brief Hand the files on the command line to a running editor.
+     *
+     * Paths are made absolute against the working directory, since the
+     * editor has its own. Standard input and the options acting on the new
+     * editor's state, such as --find, --save-as or --session, cannot be
+     * handed over, so such invocations start an editor of their own. With
+     * --wait, blocks until the files are closed in the running editor.
+     *
+     * @param options The parsed options.
+     * @return The exit status if a running editor took the files, or std::nullopt to start an editor.
+     */
+    [[nodiscard]] std::optional<int> runHandoff(const CommandLineOptions& options);
+
+}
@@ -0,0 +1,112 @@
+#include "application/scheduler.h"
+#include <algorithm>
+#include <limits>
+
+namespace drite {
+
+    /**
+     * @brief Schedule a timer.
+     * @param time The platform time at which the timer fires.
+     * @param callback The function to call.
+     * @param interval The repeat interval in seconds; 0 fires once.
+     * @return The timer id.
+     */
+    Scheduler::TimerId Scheduler::schedule(double time, TimerCallback callback, double interval) {
+        const TimerId id = m_nextId++;
+        m_timers.emplace(id, Timer{time, std::max(interval, 0.0), std::move(callback)});
+        m_deadlines.push(Deadline{time, id});
+        return id;
+    }
+
+    /**
+     * @brief Cancel a timer.
+     * @param id The timer id; unknown or fired one-shot timers are ignored.
+     * @return True if a pending timer was cancelled.
+     */
+    bool Scheduler::cancel(TimerId id) {
+        return m_timers.erase(id) > 0;
+    }
+
+    /**
+     * @brief Fire every timer that is due.
+     *
+     * Repeating timers are rescheduled from their previous deadline, but never
+     * into the past, so a loop that slept through several periods fires them
+     * once instead of in a burst.
+     *
+     * @param now The current platform time.
+     * @return The number of timers fired.
+     */
+    size_t Scheduler::runDueTimers(double now) {
+        size_t fired{0};
+
+        for (discardStaleDeadlines(); !m_deadlines.empty() && m_deadlines.top().time <= now; discardStaleDeadlines()) {
+            const TimerId id = m_deadlines.top().id;
+            m_deadlines.pop();
+
+            auto it = m_timers.find(id);
+            TimerCallback callback = it->second.callback;
+            if (it->second.interval > 0.0) {
+                it->second.time = std::max(it->second.time + it->second.interval, now);
+                m_deadlines.push(Deadline{it->second.time, id});
+            } else {
+                m_timers.erase(it);
+            }
+
+            // Callbacks may schedule or cancel timers, including their own
+            callback();
+            ++fired;
+        }
+
+        return fired;
+    }
+
+    /**
+     * @brief Check whether a requested frame may be drawn now, and claim the slot if so.
+     * @param now The current platform time.
+     * @return True if the caller should draw a frame.
+     */
+    bool Scheduler::beginFrameIfDue(double now) noexcept {
+        if (!m_frameRequested || now < m_lastFrameTime + m_frameInterval) {
+            return false;
+        }
+
+        m_frameRequested = false;
+        m_lastFrameTime = now;
+        return true;
+    }
+
+    /**
+     * @brief Get how long the loop may block before something is due.
+     * @param now The current platform time.
+     * @return The timeout in seconds, 0 if something is due, infinity if nothing is scheduled.
+     */
+    double Scheduler::getTimeout(double now) {
+        double deadline = std::numeric_limits<double>::infinity();
+        if (m_frameRequested) {
+            deadline = m_lastFrameTime + m_frameInterval;
+        }
+
+        discardStaleDeadlines();
+        if (!m_deadlines.empty()) {
+            deadline = std::min(deadline, m_deadlines.top().time);
+        }
+
+        return std::max(deadline - now, 0.0);
+    }
+
+    /**
+     * @brief Drop stale entries from the top of the heap.
+     */
+    void Scheduler::discardStaleDeadlines() {
+        while (!m_deadlines.empty()) {
+            const Deadline& top = m_deadlines.top();
+            const auto it = m_timers.find(top.id);
+            if (it != m_timers.end() && it->second.time == top.time) {
+                return;
+            }
+            m_deadlines.pop();
+        }
+    }
+
+}
@@ -0,0 +1,165 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <queue>
+#include <unordered_map>
+#include <vector>
+
+namespace drite {
+
+    /**
+     * @brief Decides when the main loop has to wake up: timers and paced frames.
+     *
+     * Everything that needs the loop to run at a later time registers a timer;
+     * everything that needs a redraw requests a frame. The loop blocks in the
+     * platform until getTimeout() expires or input arrives, so an idle editor
+     * wakes only for its timers. Times are platform times in seconds.
+     */
+    class Scheduler {
+        public:
+            /**
+             * @brief Identifies a scheduled timer.
+             */
+            using TimerId = uint64_t;
+
+            /**
+             * @brief Function called when a timer fires.
+             */
+            using TimerCallback = std::function<void()>;
+
+            /**
+             * @brief A timer id that never refers to a timer.
+             */
+            static constexpr TimerId InvalidTimer = 0;
+
+            /**
+             * @brief Default frame interval, matching a 60 Hz display.
+             */
+            static constexpr double DefaultFrameInterval = 1.0 / 60.0;
+
+            /**
+             * @brief Schedule a timer.
+             * @param time The platform time at which the timer fires.
+             * @param callback The function to call.
+             * @param interval The repeat interval in seconds; 0 fires once.
+             * @return The timer id.
+             */
+            TimerId schedule(double time, TimerCallback callback, double interval = 0.0);
+
+            /**
+             * @brief Cancel a timer.
+             * @param id The timer id; unknown or fired one-shot timers are ignored.
+             * @return True if a pending timer was cancelled.
+             */
+            bool cancel(TimerId id);
+
+            /**
+             * @brief Fire every timer that is due.
+             * @param now The current platform time.
+             * @return The number of timers fired.
+             */
+            size_t runDueTimers(double now);
+
+            /**
+             * @brief Ask for a frame to be drawn at the next frame slot.
+             */
+            void requestFrame() noexcept { m_frameRequested = true; }
+
+            /**
+             * @brief Check whether a requested frame may be drawn now, and claim the slot if so.
+             * @param now The current platform time.
+             * @return True if the caller should draw a frame.
+             */
+            [[nodiscard]] bool beginFrameIfDue(double now) noexcept;
+
+            /**
+             * @brief Get how long the loop may block before something is due.
+             * @param now The current platform time.
+             * @return The timeout in seconds, 0 if something is due, infinity if nothing is scheduled.
+             */
+            [[nodiscard]] double getTimeout(double now);
+
+            /**
+             * @brief Set the minimum time between frames.
+             * @param interval The frame interval in seconds, e.g. the display refresh period.
+             */
+            void setFrameInterval(double interval) noexcept { m_frameInterval = interval; }
+
+            /**
+             * @brief Get the minimum time between frames.
+             * @return The frame interval in seconds.
+             */
+            [[nodiscard]] double getFrameInterval() const noexcept { return m_frameInterval; }
+
+            /**
+             * @brief Get the number of timers waiting to fire.
+             * @return The timer count.
+             */
+            [[nodiscard]] size_t getTimerCount() const noexcept { return m_timers.size(); }
+
+        private:
+            /**
+             * @brief A pending timer.
+             */
+            struct Timer {
+                double time{0.0};
+                double interval{0.0};
+                TimerCallback callback;
+            };
+
+            /**
+             * @brief A heap entry; stale once its timer was cancelled or rescheduled.
+             */
+            struct Deadline {
+                double time{0.0};
+                TimerId id{InvalidTimer};
+
+                /**
+                 * @brief Order deadlines so the earliest is at the top of the heap.
+                 * @param other The other deadline.
+                 * @return True if this deadline is later.
+                 */
+                bool operator>(const Deadline& other) const noexcept { return time > other.time; }
+            };
+
+            /**
+             * @brief Drop stale entries from the top of the heap.
+             */
+            void discardStaleDeadlines();
+
+        private:
+            /**
+             * @brief Pending timers by id.
+             */
+            std::unordered_map<TimerId, Timer> m_timers;
+
+            /**
+             * @brief Timer deadlines, earliest first; cancelled timers are removed lazily.
+             */
+            std::priority_queue<Deadline, std::vector<Deadline>, std::greater<Deadline>> m_deadlines;
+
+            /**
+             * @brief The id given to the next timer.
+             */
+            TimerId m_nextId{1};
+
+            /**
+             * @brief Whether a frame was requested and not yet drawn.
+             */
+            bool m_frameRequested{false};
+
+            /**
+             * @brief The platform time of the last frame, or a large negative value before the first.
+             */
+            double m_lastFrameTime{-1.0e9};
+
+            /**
+             * @brief Minimum time between frames in seconds.
+             */
+            double m_frameInterval{DefaultFrameInterval};
+    };
+
+}
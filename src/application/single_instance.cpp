@@ -0,0 +1,636 @@
+#include "application/single_instance.h"
+#include "io/temporary_file.h"
+#include <cerrno>
+#include <charconv>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <print>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace drite {
+
+    /**
+     * @brief Largest request accepted, enough for thousands of paths.
+     */
+    static constexpr size_t MaxRequestBytes = 1024 * 1024;
+
+    /**
+     * @brief Connections queued by the kernel before the server thread accepts them.
+     */
+    static constexpr int ListenBacklog = 64;
+
+    /**
+     * @brief How far a request was parsed.
+     */
+    enum class ParseResult {
+        Incomplete,
+        Complete,
+        Invalid
+    };
+
+    /**
+     * @brief Fill a socket address with a path.
+     * @param path The socket path.
+     * @param address Receives the address.
+     * @return False if the path is too long for a socket address.
+     */
+    static bool makeAddress(const std::string& path, sockaddr_un& address) {
+        std::memset(&address, 0, sizeof(address));
+        if (path.empty() || path.size() >= sizeof(address.sun_path)) {
+            return false;
+        }
+        address.sun_family = AF_UNIX;
+        std::memcpy(address.sun_path, path.data(), path.size());
+        return true;
+    }
+
+    /**
+     * @brief Get the directory holding a socket.
+     * @param path The socket path.
+     * @return The directory, "." for a path without one.
+     */
+    static std::string getSocketDirectory(const std::string& path) {
+        const size_t slash = path.rfind('/');
+        if (slash == std::string::npos) {
+            return ".";
+        }
+        return slash == 0 ? "/" : path.substr(0, slash);
+    }
+
+    /**
+     * @brief Check that a socket directory belongs to the current user and nobody else can add or replace entries in it.
+     * @param directory The directory.
+     * @param create True to create it, for the user alone, if it is missing.
+     * @return True if the directory is a real directory of the user that group and others cannot write to.
+     */
+    static bool isPrivateDirectory(const std::string& directory, bool create) {
+        if (create && ::mkdir(directory.c_str(), S_IRWXU) != 0 && errno != EEXIST) {
+            return false;
+        }
+
+        // lstat() so a symbolic link to someone else's directory is refused
+        struct stat status;
+        return ::lstat(directory.c_str(), &status) == 0 && S_ISDIR(status.st_mode) && status.st_uid == ::getuid() &&
+               (status.st_mode & (S_IWGRP | S_IWOTH)) == 0;
+    }
+
+    /**
+     * @brief Check that the process at the other end of a connected socket runs as the current user.
+     * @param fd The socket.
+     * @return True if the peer's user is the current user.
+     */
+    static bool isPeerCurrentUser(int fd) {
+#ifdef SO_PEERCRED
+        ucred credentials{};
+        socklen_t size = sizeof(credentials);
+        return ::getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &credentials, &size) == 0 && credentials.uid == ::getuid();
+#else
+        uid_t user;
+        gid_t group;
+        return ::getpeereid(fd, &user, &group) == 0 && user == ::getuid();
+#endif
+    }
+
+    /**
+     * @brief Create a stream socket that is not inherited by child processes and does not raise SIGPIPE where the platform allows.
+     * @return The socket, or -1 with errno set.
+     */
+    static int createSocket() {
+        const int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0) {
+            return -1;
+        }
+        ::fcntl(fd, F_SETFD, FD_CLOEXEC);
+#ifdef SO_NOSIGPIPE
+        const int enabled = 1;
+        ::setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &enabled, sizeof(enabled));
+#endif
+        return fd;
+    }
+
+    /**
+     * @brief Make a descriptor non-blocking and not inherited by child processes.
+     * @param fd The descriptor.
+     */
+    static void makeNonBlocking(int fd) {
+        ::fcntl(fd, F_SETFD, FD_CLOEXEC);
+        ::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL) | O_NONBLOCK);
+    }
+
+    /**
+     * @brief Connect a socket, retrying if interrupted.
+     * @param fd The socket.
+     * @param address The address.
+     * @return True if connected, false with errno set.
+     */
+    static bool connectSocket(int fd, const sockaddr_un& address) {
+        while (::connect(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0) {
+            if (errno != EINTR) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /**
+     * @brief Send bytes without raising SIGPIPE if the peer is gone.
+     * @param fd The socket.
+     * @param data The bytes.
+     * @param size The number of bytes.
+     * @return The number of bytes sent, or -1 with errno set.
+     */
+    static ssize_t sendBytes(int fd, const char* data, size_t size) {
+#ifdef MSG_NOSIGNAL
+        return ::send(fd, data, size, MSG_NOSIGNAL);
+#else
+        // The socket was created with SO_NOSIGPIPE
+        return ::send(fd, data, size, 0);
+#endif
+    }
+
+    /**
+     * @brief Parse a number at the start of a string.
+     * @param text The text; the parsed digits are removed from it.
+     * @param value Receives the number.
+     * @return False if the text does not start with a number.
+     */
+    static bool parseNumber(std::string_view& text, size_t& value) {
+        const auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+        if (error != std::errc{}) {
+            return false;
+        }
+        text.remove_prefix(static_cast<size_t>(end - text.data()));
+        return true;
+    }
+
+    /**
+     * @brief Parse the lines received from a client.
+     * @param input The bytes received so far.
+     * @param request Receives the request.
+     * @return Whether the request is complete, incomplete or invalid.
+     */
+    static ParseResult parseRequest(std::string_view input, InstanceRequest& request) {
+        request = InstanceRequest{};
+        size_t start{0};
+        for (size_t end = input.find('\n'); end != std::string_view::npos; end = input.find('\n', start)) {
+            std::string_view line = input.substr(start, end - start);
+            start = end + 1;
+            if (line == "end") {
+                return ParseResult::Complete;
+            }
+            if (line == "wait") {
+                request.wait = true;
+            } else if (line.starts_with("open /")) {
+                request.files.emplace_back(line.substr(5));
+            } else if (line.starts_with("goto ")) {
+                line.remove_prefix(5);
+                if (!parseNumber(line, request.line) || !line.starts_with(' ')) {
+                    return ParseResult::Invalid;
+                }
+                line.remove_prefix(1);
+                if (!parseNumber(line, request.column) || !line.empty()) {
+                    return ParseResult::Invalid;
+                }
+            } else {
+                return ParseResult::Invalid;
+            }
+        }
+        return ParseResult::Incomplete;
+    }
+
+    /**
+     * @brief Get the socket the editor of the current user listens on.
+     * @return The socket path.
+     */
+    std::string getInstanceSocketPath() {
+        const char* runtime = std::getenv("XDG_RUNTIME_DIR");
+        if (runtime != nullptr && *runtime != '\0') {
+            return std::string(runtime) + "/drite.sock";
+        }
+
+        return getTemporaryDirectory() + "/drite-" + std::to_string(::getuid()) + "/drite.sock";
+    }
+
+    /**
+     * @brief Destroy the Instance Server object, stopping it.
+     */
+    InstanceServer::~InstanceServer() {
+        stop();
+    }
+
+    /**
+     * @brief Listen on a socket, replacing it if it was left behind by an editor that exited.
+     * @param path The socket path.
+     * @param callback The callback receiving requests.
+     * @return True if listening, false if another editor listens there, the directory is not private or the socket could not be created.
+     */
+    bool InstanceServer::start(const std::string& path, RequestCallback callback) {
+        if (isListening()) {
+            return false;
+        }
+
+        sockaddr_un address;
+        if (!makeAddress(path, address)) {
+            std::println(stderr, "Single instance: socket path is too long: {}", path);
+            return false;
+        }
+        const std::string directory = getSocketDirectory(path);
+        if (!isPrivateDirectory(directory, true)) {
+            std::println(stderr, "Single instance: {} must be a directory of this user that nobody else can write to", directory);
+            return false;
+        }
+        m_listener = createSocket();
+        if (m_listener < 0) {
+            std::println(stderr, "Single instance: cannot create a socket: {}", std::strerror(errno));
+            return false;
+        }
+
+        const auto fail = [this](const char* what, int error) {
+            if (error != 0) {
+                std::println(stderr, "Single instance: cannot {} {}: {}", what, m_path, std::strerror(error));
+            }
+            ::close(m_listener);
+            m_listener = -1;
+            m_path.clear();
+            return false;
+        };
+        m_path = path;
+
+        const auto bindAddress = [&] { return ::bind(m_listener, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) == 0; };
+        if (!bindAddress()) {
+            if (errno != EADDRINUSE) {
+                return fail("listen on", errno);
+            }
+
+            // A socket nobody accepts on was left by an editor of this user
+            // that exited; one that accepts belongs to a running editor, which
+            // keeps it, and one of another user is never removed
+            struct stat status;
+            const int probe = createSocket();
+            const bool refused = probe >= 0 && !connectSocket(probe, address) && errno == ECONNREFUSED;
+            if (probe >= 0) {
+                ::close(probe);
+            }
+            const bool stale = refused && ::lstat(path.c_str(), &status) == 0 && S_ISSOCK(status.st_mode) && status.st_uid == ::getuid();
+            if (!stale) {
+                return fail("listen on", refused ? EEXIST : 0);
+            }
+            if (::unlink(path.c_str()) != 0 || !bindAddress()) {
+                return fail("listen on", errno);
+            }
+        }
+
+        // Only the user may connect; set before listening, so nobody connects earlier
+        struct stat status;
+        if (::chmod(path.c_str(), S_IRUSR | S_IWUSR) != 0 || ::lstat(path.c_str(), &status) != 0 || ::listen(m_listener, ListenBacklog) != 0) {
+            const int error = errno;
+            ::unlink(path.c_str());
+            return fail("listen on", error);
+        }
+        m_socketDevice = static_cast<uint64_t>(status.st_dev);
+        m_socketInode = static_cast<uint64_t>(status.st_ino);
+        makeNonBlocking(m_listener);
+
+        int wake[2];
+        if (::pipe(wake) != 0) {
+            const int error = errno;
+            ::unlink(path.c_str());
+            return fail("create a wake pipe for", error);
+        }
+        m_wakeRead = wake[0];
+        m_wakeWrite = wake[1];
+        makeNonBlocking(m_wakeRead);
+        makeNonBlocking(m_wakeWrite);
+
+        m_callback = std::move(callback);
+        m_stopping.store(false, std::memory_order_relaxed);
+        m_thread = std::thread([this] { serve(); });
+        return true;
+    }
+
+    /**
+     * @brief Stop listening, close every connection and remove the socket.
+     */
+    void InstanceServer::stop() {
+        if (!m_thread.joinable()) {
+            return;
+        }
+
+        m_stopping.store(true, std::memory_order_release);
+        wake();
+        m_thread.join();
+
+        // A later editor may have replaced the socket if this one was removed by hand
+        struct stat status;
+        if (::lstat(m_path.c_str(), &status) == 0 && static_cast<uint64_t>(status.st_dev) == m_socketDevice &&
+            static_cast<uint64_t>(status.st_ino) == m_socketInode) {
+            ::unlink(m_path.c_str());
+        }
+        ::close(m_listener);
+        ::close(m_wakeRead);
+        ::close(m_wakeWrite);
+        m_listener = -1;
+        m_wakeRead = -1;
+        m_wakeWrite = -1;
+        m_path.clear();
+        m_callback = nullptr;
+        m_replies.clear();
+    }
+
+    /**
+     * @brief Send a reply line to a client; ignored if it disconnected.
+     * @param client The connection.
+     * @param message The line, without the newline.
+     * @param last True to close the connection once it is sent.
+     */
+    void InstanceServer::reply(uint64_t client, std::string_view message, bool last) {
+        {
+            std::lock_guard lock(m_mutex);
+            Reply& reply = m_replies.emplace_back();
+            reply.client = client;
+            reply.text.reserve(message.size() + 1);
+            reply.text.append(message);
+            reply.text.push_back('\n');
+            reply.last = last;
+        }
+        wake();
+    }
+
+    /**
+     * @brief Wake the server thread.
+     */
+    void InstanceServer::wake() noexcept {
+        // A full pipe already wakes it
+        const char byte{0};
+        static_cast<void>(::write(m_wakeWrite, &byte, 1));
+    }
+
+    /**
+     * @brief Accept connections and move bytes until stopped; runs on m_thread.
+     */
+    void InstanceServer::serve() {
+        std::vector<Connection> connections;
+        std::vector<pollfd> fds;
+        std::vector<Reply> replies;
+        uint64_t nextClient{1};
+
+        while (true) {
+            fds.clear();
+            fds.push_back(pollfd{m_wakeRead, POLLIN, 0});
+            fds.push_back(pollfd{m_listener, POLLIN, 0});
+            for (const Connection& connection : connections) {
+                const short events = static_cast<short>(POLLIN | (connection.output.empty() ? 0 : POLLOUT));
+                fds.push_back(pollfd{connection.fd, events, 0});
+            }
+            if (::poll(fds.data(), static_cast<nfds_t>(fds.size()), -1) < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                std::println(stderr, "Single instance: poll failed: {}", std::strerror(errno));
+                break;
+            }
+
+            if (fds[0].revents != 0) {
+                char buffer[64];
+                while (::read(m_wakeRead, buffer, sizeof(buffer)) > 0) {
+                }
+                {
+                    std::lock_guard lock(m_mutex);
+                    replies.swap(m_replies);
+                }
+                for (Reply& reply : replies) {
+                    for (Connection& connection : connections) {
+                        if (connection.id == reply.client) {
+                            connection.output += reply.text;
+                            connection.closing = connection.closing || reply.last;
+                        }
+                    }
+                }
+                replies.clear();
+
+                // The last replies are short enough to fit in the socket buffers
+                if (m_stopping.load(std::memory_order_acquire)) {
+                    for (Connection& connection : connections) {
+                        static_cast<void>(transmit(connection));
+                    }
+                    break;
+                }
+            }
+
+            // Connections are closed after the pass, so fds still lines up with them
+            for (size_t i = 0; i < connections.size(); ++i) {
+                Connection& connection = connections[i];
+                bool open = true;
+                if ((fds[i + 2].revents & (POLLIN | POLLHUP | POLLERR)) != 0) {
+                    open = receive(connection);
+                }
+                if (open && !connection.output.empty()) {
+                    open = transmit(connection);
+                }
+                if (!open) {
+                    ::close(connection.fd);
+                    connection.fd = -1;
+                }
+            }
+            std::erase_if(connections, [](const Connection& connection) { return connection.fd < 0; });
+
+            if ((fds[1].revents & POLLIN) != 0) {
+                for (int fd = ::accept(m_listener, nullptr, nullptr); fd >= 0; fd = ::accept(m_listener, nullptr, nullptr)) {
+                    if (!isPeerCurrentUser(fd)) {
+                        ::close(fd);
+                        continue;
+                    }
+                    makeNonBlocking(fd);
+#ifdef SO_NOSIGPIPE
+                    const int enabled = 1;
+                    ::setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &enabled, sizeof(enabled));
+#endif
+                    Connection& connection = connections.emplace_back();
+                    connection.id = nextClient++;
+                    connection.fd = fd;
+                }
+            }
+        }
+
+        for (const Connection& connection : connections) {
+            ::close(connection.fd);
+        }
+    }
+
+    /**
+     * @brief Read what a client sent, handing a complete request to the callback.
+     * @param connection The connection.
+     * @return False if the connection is done and should be closed.
+     */
+    bool InstanceServer::receive(Connection& connection) {
+        char buffer[4096];
+        while (true) {
+            const ssize_t count = ::read(connection.fd, buffer, sizeof(buffer));
+            if (count > 0) {
+                // Anything after the request is ignored; only a hangup matters then
+                if (!connection.received) {
+                    connection.input.append(buffer, static_cast<size_t>(count));
+                }
+                continue;
+            }
+            if (count < 0 && errno == EINTR) {
+                continue;
+            }
+            if (count < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                break;
+            }
+            // The client hung up, e.g. a waiting one was interrupted
+            return false;
+        }
+        if (connection.received) {
+            return true;
+        }
+
+        InstanceRequest request;
+        const ParseResult result = connection.input.size() > MaxRequestBytes ? ParseResult::Invalid : parseRequest(connection.input, request);
+        if (result == ParseResult::Incomplete) {
+            return true;
+        }
+        connection.received = true;
+        connection.input = std::string{};
+        if (result == ParseResult::Invalid) {
+            connection.output += "error invalid request\n";
+            connection.closing = true;
+            return true;
+        }
+        m_callback(connection.id, std::move(request));
+        return true;
+    }
+
+    /**
+     * @brief Write what is queued for a client.
+     * @param connection The connection.
+     * @return False if the connection is done and should be closed.
+     */
+    bool InstanceServer::transmit(Connection& connection) {
+        while (!connection.output.empty()) {
+            const ssize_t count = sendBytes(connection.fd, connection.output.data(), connection.output.size());
+            if (count > 0) {
+                connection.output.erase(0, static_cast<size_t>(count));
+                continue;
+            }
+            if (count < 0 && errno == EINTR) {
+                continue;
+            }
+            if (count < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                return true;
+            }
+            return false;
+        }
+        return !connection.closing;
+    }
+
+    /**
+     * @brief Destroy the Instance Client object, closing the connection.
+     */
+    InstanceClient::~InstanceClient() {
+        if (m_fd >= 0) {
+            ::close(m_fd);
+        }
+    }
+
+    /**
+     * @brief Connect to the editor listening on a socket.
+     * @param path The socket path.
+     * @return True if connected, false if no editor of this user listens there.
+     */
+    bool InstanceClient::connect(const std::string& path) {
+        sockaddr_un address;
+        if (m_fd >= 0 || !makeAddress(path, address) || !isPrivateDirectory(getSocketDirectory(path), false)) {
+            return false;
+        }
+        m_fd = createSocket();
+        if (m_fd < 0) {
+            return false;
+        }
+        if (!connectSocket(m_fd, address) || !isPeerCurrentUser(m_fd)) {
+            ::close(m_fd);
+            m_fd = -1;
+            return false;
+        }
+        return true;
+    }
+
+    /**
+     * @brief Send a request and wait until the editor handled it.
+     * @param request The request; paths must be absolute.
+     * @return The reply, "ok" or "error MESSAGE", or nullopt if the connection failed.
+     */
+    std::optional<std::string> InstanceClient::send(const InstanceRequest& request) {
+        if (m_fd < 0) {
+            return std::nullopt;
+        }
+
+        std::string message;
+        for (const std::string& file : request.files) {
+            message += "open ";
+            message += file;
+            message += '\n';
+        }
+        if (request.line > 0) {
+            message += "goto " + std::to_string(request.line) + " " + std::to_string(request.column) + "\n";
+        }
+        if (request.wait) {
+            message += "wait\n";
+        }
+        message += "end\n";
+
+        size_t sent{0};
+        while (sent < message.size()) {
+            const ssize_t count = sendBytes(m_fd, message.data() + sent, message.size() - sent);
+            if (count < 0 && errno == EINTR) {
+                continue;
+            }
+            if (count <= 0) {
+                return std::nullopt;
+            }
+            sent += static_cast<size_t>(count);
+        }
+        return readLine();
+    }
+
+    /**
+     * @brief Block until the editor reports that the files of a waiting request were closed.
+     * @return True once they were, false if the connection failed first.
+     */
+    bool InstanceClient::waitUntilDone() {
+        const std::optional<std::string> line = readLine();
+        return line && *line == "done";
+    }
+
+    /**
+     * @brief Read one line from the editor.
+     * @return The line without the newline, or nullopt if the connection closed first.
+     */
+    std::optional<std::string> InstanceClient::readLine() {
+        while (true) {
+            const size_t end = m_input.find('\n');
+            if (end != std::string::npos) {
+                std::string line = m_input.substr(0, end);
+                m_input.erase(0, end + 1);
+                return line;
+            }
+
+            char buffer[256];
+            const ssize_t count = ::read(m_fd, buffer, sizeof(buffer));
+            if (count < 0 && errno == EINTR) {
+                continue;
+            }
+            if (count <= 0) {
+                return std::nullopt;
+            }
+            m_input.append(buffer, static_cast<size_t>(count));
+        }
+    }
+
+}
@@ -0,0 +1,269 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace drite {
+
+    /**
+     * @brief What a later invocation asks the running editor to do.
+     */
+    struct InstanceRequest {
+        /**
+         * @brief Absolute paths of the files to open, in order; the last becomes active.
+         */
+        std::vector<std::string> files;
+
+        /**
+         * @brief The 1-based line to put the cursor on in the last file, 0 to leave it.
+         */
+        size_t line{0};
+
+        /**
+         * @brief The 1-based column on that line, 0 for its start.
+         */
+        size_t column{0};
+
+        /**
+         * @brief True to be told once every file opened by the request is closed.
+         */
+        bool wait{false};
+    };
+
+    /**
+     * @brief Get the socket the editor of the current user listens on.
+     *
+     * The socket lives in $XDG_RUNTIME_DIR if set, otherwise in a directory
+     * named with the user id in $TMPDIR or /tmp, which the server creates
+     * with access for the user alone.
+     *
+     * @return The socket path.
+     */
+    [[nodiscard]] std::string getInstanceSocketPath();
+
+    /**
+     * @brief Accepts requests from later invocations on a Unix domain socket.
+     *
+     * The protocol is line based. A client sends "open PATH" lines, an
+     * optional "goto LINE COLUMN" and "wait", then "end"; the server answers
+     * "ok" or "error MESSAGE" once the editor handled the request, and with
+     * "wait" a final "done" when the files are closed or the editor quits.
+     *
+     * Connections are served on a thread of their own that only moves bytes;
+     * complete requests go to a callback, which hands them to the main
+     * thread, and replies come back through reply() from any thread.
+     */
+    class InstanceServer {
+        public:
+            /**
+             * @brief Callback receiving each complete request, on the server thread.
+             * @param client The connection to reply to.
+             * @param request The request.
+             */
+            using RequestCallback = std::function<void(uint64_t client, InstanceRequest request)>;
+
+            /**
+             * @brief Construct a new Instance Server object.
+             */
+            InstanceServer() = default;
+
+            /**
+             * @brief Destroy the Instance Server object, stopping it.
+             */
+            ~InstanceServer();
+
+            InstanceServer(const InstanceServer&) = delete;
+            InstanceServer& operator=(const InstanceServer&) = delete;
+
+            /**
+             * @brief Listen on a socket, replacing it if it was left behind by an editor that exited.
+             *
+             * The socket's directory is created if missing, and must be a real
+             * directory of the user that nobody else can write to, so nobody
+             * else can put a socket in its place. Connections from processes
+             * of other users are closed unread.
+             *
+             * @param path The socket path.
+             * @param callback The callback receiving requests.
+             * @return True if listening, false if another editor listens there, the directory is not private or the socket could not be created.
+             */
+            [[nodiscard]] bool start(const std::string& path, RequestCallback callback);
+
+            /**
+             * @brief Stop listening, close every connection and remove the socket.
+             */
+            void stop();
+
+            /**
+             * @brief Send a reply line to a client; ignored if it disconnected.
+             * @param client The connection.
+             * @param message The line, without the newline.
+             * @param last True to close the connection once it is sent.
+             */
+            void reply(uint64_t client, std::string_view message, bool last);
+
+            /**
+             * @brief Check whether the server is listening.
+             * @return True between a successful start() and stop().
+             */
+            [[nodiscard]] bool isListening() const noexcept { return m_thread.joinable(); }
+
+        private:
+            /**
+             * @brief A reply waiting for the server thread.
+             */
+            struct Reply {
+                uint64_t client{0};
+                std::string text;
+                bool last{false};
+            };
+
+            /**
+             * @brief A client connection; owned by the server thread.
+             */
+            struct Connection {
+                uint64_t id{0};
+                int fd{-1};
+                std::string input;
+                std::string output;
+                bool received{false};
+                bool closing{false};
+            };
+
+            /**
+             * @brief Wake the server thread.
+             */
+            void wake() noexcept;
+
+            /**
+             * @brief Accept connections and move bytes until stopped; runs on m_thread.
+             */
+            void serve();
+
+            /**
+             * @brief Read what a client sent, handing a complete request to the callback.
+             * @param connection The connection.
+             * @return False if the connection is done and should be closed.
+             */
+            [[nodiscard]] bool receive(Connection& connection);
+
+            /**
+             * @brief Write what is queued for a client.
+             * @param connection The connection.
+             * @return False if the connection is done and should be closed.
+             */
+            [[nodiscard]] bool transmit(Connection& connection);
+
+            /**
+             * @brief The socket path, removed again by stop().
+             */
+            std::string m_path;
+
+            /**
+             * @brief The listening socket.
+             */
+            int m_listener{-1};
+
+            /**
+             * @brief The device and inode of the socket file, so stop() only removes its own.
+             */
+            uint64_t m_socketDevice{0};
+            uint64_t m_socketInode{0};
+
+            /**
+             * @brief Pipe waking the server thread for replies and stop().
+             */
+            int m_wakeRead{-1};
+            int m_wakeWrite{-1};
+
+            /**
+             * @brief Receives the requests.
+             */
+            RequestCallback m_callback;
+
+            /**
+             * @brief Replies not yet picked up by the server thread, guarded by m_mutex.
+             */
+            std::vector<Reply> m_replies;
+            std::mutex m_mutex;
+
+            /**
+             * @brief Set by stop() to end the server thread.
+             */
+            std::atomic<bool> m_stopping{false};
+
+            /**
+             * @brief The server thread.
+             */
+            std::thread m_thread;
+    };
+
+    /**
+     * @brief Hands a request to a running editor.
+     */
+    class InstanceClient {
+        public:
+            /**
+             * @brief Construct a new Instance Client object.
+             */
+            InstanceClient() = default;
+
+            /**
+             * @brief Destroy the Instance Client object, closing the connection.
+             */
+            ~InstanceClient();
+
+            InstanceClient(const InstanceClient&) = delete;
+            InstanceClient& operator=(const InstanceClient&) = delete;
+
+            /**
+             * @brief Connect to the editor listening on a socket.
+             *
+             * The socket's directory must be one the server would listen in,
+             * and the editor must run as the current user.
+             *
+             * @param path The socket path.
+             * @return True if connected, false if no editor of this user listens there.
+             */
+            [[nodiscard]] bool connect(const std::string& path);
+
+            /**
+             * @brief Send a request and wait until the editor handled it.
+             * @param request The request; paths must be absolute.
+             * @return The reply, "ok" or "error MESSAGE", or nullopt if the connection failed.
+             */
+            [[nodiscard]] std::optional<std::string> send(const InstanceRequest& request);
+
+            /**
+             * @brief Block until the editor reports that the files of a waiting request were closed.
+             * @return True once they were, false if the connection failed first.
+             */
+            [[nodiscard]] bool waitUntilDone();
+
+        private:
+            /**
+             * @brief Read one line from the editor.
+             * @return The line without the newline, or nullopt if the connection closed first.
+             */
+            [[nodiscard]] std::optional<std::string> readLine();
+
+            /**
+             * @brief The connected socket.
+             */
+            int m_fd{-1};
+
+            /**
+             * @brief Bytes received after the last line read.
+             */
+            std::string m_input;
+    };
+
+}
@@ -0,0 +1,218 @@
+#include "bench/bench_command_line.h"
+#include "bench/close_bench.h"
+#include "bench/cursor_bench.h"
+#include "bench/draw_bench.h"
+#include "bench/edit_bench.h"
+#include "bench/grep_bench.h"
+#include "bench/handoff_bench.h"
+#include "bench/index_bench.h"
+#include "bench/job_bench.h"
+#include "bench/save_bench.h"
+#include "bench/session_bench.h"
+#include "bench/startup_bench.h"
+#include "bench/undo_bench.h"
+#include <array>
+#include <charconv>
+#include <print>
+
+namespace drite {
+
+    /**
+     * @brief Every benchmark, in the order the usage lists them.
+     */
+    static constexpr std::array<BenchCommand, 12> BenchCommands = {{
+        {"jobs", BenchArgument::None, false, "jobs [--threads N]",
+            "Times independent, parallel-for and dependent jobs on 1 to N threads.", runJobBench},
+        {"save", BenchArgument::Path, true, "save PATH [file]",
+            "Times saving the file, or 256 MiB of generated text, to PATH against raw writes.", runSaveBench},
+        {"cursors", BenchArgument::Count, false, "cursors N",
+            "Times a rename typed with N cursors against editing at each cursor in turn.", runCursorBench},
+        {"draw", BenchArgument::None, false, "draw",
+            "Counts the batches and uploads of a full screen of text scrolled through.", runDrawBench},
+        {"handoff", BenchArgument::Count, false, "handoff N",
+            "Times N files handed to a running editor against starting a new one.", runHandoffBench},
+        {"startup", BenchArgument::Budget, true, "startup MS [file]",
+            "Times headless launches to the first frame of the file, or generated code, and fails over MS.", runStartupBench},
+        {"session", BenchArgument::Count, false, "session N",
+            "Times restoring N edited documents from a session snapshot against opening them afresh.", runSessionBench},
+        {"edits", BenchArgument::None, false, "edits",
+            "Times typing, inserts and deletions on documents from 1 KiB to 1 GiB and checks the tree stays balanced.", runEditBench},
+        {"index", BenchArgument::None, false, "index",
+            "Times counting and finding line feeds in 256 MiB of text, and the line index over it.", runIndexBench},
+        {"undo", BenchArgument::None, false, "undo",
+            "Times undoing and redoing pastes of 64 KiB to 256 MiB and a history spilled to disk.", runUndoBench},
+        {"grep", BenchArgument::Count, false, "grep N [--threads N]",
+            "Times searching a generated tree of N files on 1 to --threads workers and checks every planted line is found.", runGrepBench},
+        {"close", BenchArgument::None, false, "close [--threads N]",
+            "Times closing 64 MiB documents while they are searched and highlighted and checks every match is still found.", runCloseBench},
+    }};
+
+    /**
+     * @brief Parse a numeric argument.
+     * @param text The argument.
+     * @param value Receives the parsed number.
+     * @return True if the whole argument was a valid number.
+     */
+    template<typename T>
+    static bool parseNumber(std::string_view text, T& value) {
+        const char* end = text.data() + text.size();
+        const auto result = std::from_chars(text.data(), end, value);
+        return result.ec == std::errc() && result.ptr == end;
+    }
+
+    /**
+     * @brief Parse the value a benchmark takes after its name.
+     * @param bench The benchmark.
+     * @param value The argument.
+     * @param options Receives the value.
+     * @return True if the value is valid for the benchmark.
+     */
+    static bool parseBenchArgument(const BenchCommand& bench, std::string_view value, BenchOptions& options) {
+        switch (bench.argument) {
+        case BenchArgument::Count:
+            if (!parseNumber(value, options.count) || options.count == 0) {
+                std::println(stderr, "Invalid count: {}", value);
+                return false;
+            }
+            return true;
+        case BenchArgument::Budget:
+            if (!parseNumber(value, options.budget) || options.budget <= 0.0) {
+                std::println(stderr, "Invalid budget: {}", value);
+                return false;
+            }
+            return true;
+        case BenchArgument::Path:
+            if (value.empty()) {
+                std::println(stderr, "Invalid path: {}", value);
+                return false;
+            }
+            options.path = value;
+            return true;
+        case BenchArgument::None:
+            break;
+        }
+        return false;
+    }
+
+    /**
+     * @brief Find a benchmark by name.
+     * @param name The name given on the command line.
+     * @return The benchmark, or nullptr if there is none of that name.
+     */
+    const BenchCommand* findBench(std::string_view name) {
+        for (const BenchCommand& bench : BenchCommands) {
+            if (bench.name == name) {
+                return &bench;
+            }
+        }
+        return nullptr;
+    }
+
+    /**
+     * @brief Parse the arguments of drite-bench.
+     * @param argc The argument count.
+     * @param argv The argument vector.
+     * @return The parsed options, or std::nullopt if the arguments are invalid.
+     */
+    std::optional<BenchOptions> parseBenchCommandLine(int argc, char** argv) {
+        BenchOptions options;
+        const BenchCommand* bench{nullptr};
+        bool argumentRead{false};
+
+        // The editor the launching benchmarks start is the one built next to drite-bench
+        const std::string_view executable = argc > 0 ? argv[0] : "";
+        const size_t slash = executable.rfind('/');
+        options.editorPath = slash == std::string_view::npos ? "drite" : std::string(executable.substr(0, slash + 1)) + "drite";
+
+        for (int i = 1; i < argc; ++i) {
+            const std::string_view argument = argv[i];
+
+            // Options taking a value read it from the next argument
+            const auto nextValue = [&](std::string_view& value) {
+                if (i + 1 >= argc) {
+                    std::println(stderr, "Missing value for option: {}", argument);
+                    return false;
+                }
+                value = argv[++i];
+                return true;
+            };
+
+            std::string_view value;
+            if (argument == "-h" || argument == "--help") {
+                options.showHelp = true;
+            } else if (argument == "--threads") {
+                if (!nextValue(value) || !parseNumber(value, options.threadCount)) {
+                    std::println(stderr, "Invalid thread count: {}", value);
+                    return std::nullopt;
+                }
+            } else if (argument == "--page-cache") {
+                if (!nextValue(value) || !parseNumber(value, options.pageCacheMiB) || options.pageCacheMiB == 0) {
+                    std::println(stderr, "Invalid page cache size: {}", value);
+                    return std::nullopt;
+                }
+            } else if (argument == "--editor") {
+                if (!nextValue(value) || value.empty()) {
+                    std::println(stderr, "Invalid editor path: {}", value);
+                    return std::nullopt;
+                }
+                options.editorPath = value;
+            } else if (argument.starts_with('-') && argument != "-") {
+                std::println(stderr, "Unknown option: {}", argument);
+                return std::nullopt;
+            } else if (bench == nullptr) {
+                bench = findBench(argument);
+                if (bench == nullptr) {
+                    std::println(stderr, "Unknown benchmark: {}", argument);
+                    return std::nullopt;
+                }
+                options.name = argument;
+            } else if (bench->argument != BenchArgument::None && !argumentRead) {
+                if (!parseBenchArgument(*bench, argument, options)) {
+                    return std::nullopt;
+                }
+                argumentRead = true;
+            } else if (bench->takesFile && options.files.empty()) {
+                options.files.emplace_back(argument);
+            } else {
+                std::println(stderr, "Unexpected argument: {}", argument);
+                return std::nullopt;
+            }
+        }
+
+        if (options.showHelp) {
+            return options;
+        }
+        if (bench == nullptr) {
+            std::println(stderr, "Missing benchmark name");
+            return std::nullopt;
+        }
+        if (bench->argument != BenchArgument::None && !argumentRead) {
+            std::println(stderr, "Missing value for benchmark: {}", bench->name);
+            return std::nullopt;
+        }
+        return options;
+    }
+
+    /**
+     * @brief Print the usage of drite-bench to standard output.
+     */
+    void printBenchUsage() {
+        for (const BenchCommand& bench : BenchCommands) {
+            std::println("{} drite-bench {}", &bench == BenchCommands.data() ? "Usage:" : "      ", bench.usage);
+        }
+        std::println("");
+        std::println("Runs one self-checking benchmark and exits with 1 if its check or budget failed.");
+        std::println("");
+        std::println("Benchmarks:");
+        for (const BenchCommand& bench : BenchCommands) {
+            std::println("  {:<20}{}", bench.name, bench.description);
+        }
+        std::println("");
+        std::println("Options:");
+        std::println("  --threads N           Search with N worker threads (close), or bench up to N (jobs, grep); default one per core");
+        std::println("  --page-cache MIB      Page the file of save if larger than MIB, keeping MIB resident");
+        std::println("  --editor PATH         Launch PATH for handoff and startup (default: the drite next to drite-bench)");
+        std::println("  -h, --help            Show this help message");
+    }
+
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "bench/bench_options.h"
+#include <optional>
+#include <string_view>
+
+namespace drite {
+
+    /**
+     * @brief The value a benchmark takes after its name.
+     */
+    enum class BenchArgument {
+        None,
+        Count,
+        Budget,
+        Path
+    };
+
+    /**
+     * @brief A benchmark drite-bench can run.
+     */
+    struct BenchCommand {
+        std::string_view name;
+        BenchArgument argument;
+        bool takesFile;
+        std::string_view usage;
+        std::string_view description;
+        int (*run)(const BenchOptions& options);
+    };
+
+    /**
+     * @brief Find a benchmark by name.
+     * @param name The name given on the command line.
+     * @return The benchmark, or nullptr if there is none of that name.
+     */
+    [[nodiscard]] const BenchCommand* findBench(std::string_view name);
+
+    /**
+     * @brief Parse the arguments of drite-bench.
+     * @param argc The argument count.
+     * @param argv The argument vector.
+     * @return The parsed options, or std::nullopt if the arguments are invalid.
+     */
+    [[nodiscard]] std::optional<BenchOptions> parseBenchCommandLine(int argc, char** argv);
+
+    /**
+     * @brief Print the usage of drite-bench to standard output.
+     */
+    void printBenchUsage();
+
+}
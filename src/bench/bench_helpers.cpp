@@ -0,0 +1,69 @@
+#include "bench/bench_helpers.h"
+#include <algorithm>
+
+namespace drite {
+
+    /**
+     * @brief Get the seconds elapsed since a time point.
+     * @param start The time point.
+     * @return The elapsed seconds.
+     */
+    double getSecondsSince(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    /**
+     * @brief Get a percentile of a set of durations.
+     * @param seconds The durations; sorted in place.
+     * @param percentile The percentile, from 0 to 100.
+     * @return The duration at the percentile, in the unit of the durations.
+     */
+    double getPercentile(std::vector<double>& seconds, size_t percentile) {
+        std::sort(seconds.begin(), seconds.end());
+        return seconds[std::min(seconds.size() - 1, seconds.size() * percentile / 100)];
+    }
+
+    /**
+     * @brief Get the median of a set of durations.
+     * @param seconds The durations; sorted in place.
+     * @return The median, in the unit of the durations.
+     */
+    double getMedian(std::vector<double>& seconds) {
+        return getPercentile(seconds, 50);
+    }
+
+    /**
+     * @brief Generate numbered lines of text of exactly the given size.
+     * @param size The size in bytes.
+     * @param label Text starting every line, so different texts differ.
+     * @return The text.
+     */
+    std::string generateText(size_t size, std::string_view label) {
+        std::string text;
+        text.reserve(size + label.size() + 64);
+        for (size_t line = 0; text.size() < size; ++line) {
+            text += label;
+            text += ' ';
+            text += std::to_string(line);
+            text += ": the quick brown fox jumps over the lazy dog\n";
+        }
+        text.resize(size);
+        return text;
+    }
+
+    /**
+     * @brief Describe a byte count in the largest binary unit it reaches.
+     * @param size The byte count.
+     * @return The description, e.g. "32 MiB".
+     */
+    std::string describeSize(size_t size) {
+        if (size >= (size_t{1} << 30)) {
+            return std::to_string(size >> 30) + " GiB";
+        }
+        if (size >= (size_t{1} << 20)) {
+            return std::to_string(size >> 20) + " MiB";
+        }
+        return std::to_string(size >> 10) + " KiB";
+    }
+
+}
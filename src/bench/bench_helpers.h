@@ -0,0 +1,48 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace drite {
+
+    /**
+     * @brief Get the seconds elapsed since a time point.
+     * @param start The time point.
+     * @return The elapsed seconds.
+     */
+    [[nodiscard]] double getSecondsSince(std::chrono::steady_clock::time_point start);
+
+    /**
+     * @brief Get a percentile of a set of durations.
+     * @param seconds The durations; sorted in place.
+     * @param percentile The percentile, from 0 to 100.
+     * @return The duration at the percentile, in the unit of the durations.
+     */
+    [[nodiscard]] double getPercentile(std::vector<double>& seconds, size_t percentile);
+
+    /**
+     * @brief Get the median of a set of durations.
+     * @param seconds The durations; sorted in place.
+     * @return The median, in the unit of the durations.
+     */
+    [[nodiscard]] double getMedian(std::vector<double>& seconds);
+
+    /**
+     * @brief Generate numbered lines of text of exactly the given size.
+     * @param size The size in bytes.
+     * @param label Text starting every line, so different texts differ.
+     * @return The text.
+     */
+    [[nodiscard]] std::string generateText(size_t size, std::string_view label = "line");
+
+    /**
+     * @brief Describe a byte count in the largest binary unit it reaches.
+     * @param size The byte count.
+     * @return The description, e.g. "32 MiB".
+     */
+    [[nodiscard]] std::string describeSize(size_t size);
+
+}
@@ -0,0 +1,17 @@
+#include "bench/bench_command_line.h"
+
+int main(int argc, char** argv) {
+    const auto options = drite::parseBenchCommandLine(argc, argv);
+    if (!options) {
+        drite::printBenchUsage();
+        return 1;
+    }
+
+    if (options->showHelp) {
+        drite::printBenchUsage();
+        return 0;
+    }
+
+    // Each benchmark checks its own results and returns the exit status
+    return drite::findBench(options->name)->run(*options);
+}
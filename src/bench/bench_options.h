@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace drite {
+
+    /**
+     * @brief Options parsed from the drite-bench command line.
+     */
+    struct BenchOptions {
+        std::string name;
+        size_t count{0};
+        double budget{0.0};
+        std::string path;
+        std::vector<std::string> files;
+        unsigned threadCount{0};
+        size_t pageCacheMiB{0};
+        std::string editorPath;
+        bool showHelp{false};
+    };
+
+}
@@ -0,0 +1,115 @@
+#include "bench/close_bench.h"
+#include "bench/bench_helpers.h"
+#include "editor/document.h"
+#include "search/text_search.h"
+#include "syntax/language.h"
+#include "syntax/syntax_highlighter.h"
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <print>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace drite {
+
+    /**
+     * @brief Size of the original text of each closed document.
+     */
+    static constexpr size_t DocumentSize = size_t{64} << 20;
+
+    /**
+     * @brief Lines inserted into each document holding the searched token.
+     */
+    static constexpr size_t NeedleCount = 4096;
+
+    /**
+     * @brief The searched token, only ever found in inserted text.
+     */
+    static constexpr std::string_view Needle = "close_needle";
+
+    /**
+     * @brief Documents closed, each a little later into its search than the one before.
+     */
+    static constexpr int RoundCount = 12;
+
+    /**
+     * @brief Size of the blocks allocated to overwrite freed memory, the size of an add block.
+     */
+    static constexpr size_t ScribbleBlockSize = size_t{64} << 10;
+
+    /**
+     * @brief Make a document whose only matches are in its add blocks, each on a line of its own.
+     * @param source The original text.
+     * @return The document.
+     */
+    static std::unique_ptr<Document> makeEditedDocument(const std::string& source) {
+        auto document = std::make_unique<Document>(TextBuffer(source));
+        for (size_t i = 0; i < NeedleCount; ++i) {
+            const TextBuffer& buffer = document->getBuffer();
+            document->setCursor(buffer.getLineStart(i * 7919 % buffer.getLineCount()));
+            document->insertAtCursor(std::string(Needle) + " " + std::to_string(i) + "\n");
+        }
+        return document;
+    }
+
+    /**
+     * @brief Time closing documents that are being searched and highlighted for drite-bench close.
+     * @param options The parsed options.
+     * @return The exit status: 0 on success, 1 if a search of a closed document found the wrong matches.
+     */
+    int runCloseBench(const BenchOptions& options) {
+        const std::string source = generateText(DocumentSize);
+        const Language* language = detectLanguage("close.cpp");
+        TextSearch search(options.threadCount);
+        SyntaxHighlighter highlighter;
+        SearchQuery query;
+        query.pattern = Needle;
+
+        std::vector<double> closeSeconds;
+        int closedMidSearch{0};
+        bool passed{true};
+        for (int round = 0; round < RoundCount; ++round) {
+            std::unique_ptr<Document> document = makeEditedDocument(source);
+            highlighter.attach(document->getBuffer(), language);
+            static_cast<void>(search.start(document->getBuffer(), query, document->getBuffer().getSize() / 2));
+            std::this_thread::sleep_for(std::chrono::milliseconds(round * 2));
+            static_cast<void>(search.poll());
+            closedMidSearch += search.isComplete() ? 0 : 1;
+
+            // Close as the editor does, showing the document before it
+            auto start = std::chrono::steady_clock::now();
+            document.reset();
+            const Document replacement{TextBuffer(std::string())};
+            highlighter.attach(replacement.getBuffer(), language);
+            closeSeconds.push_back(getSecondsSince(start));
+
+            // Reuse the freed memory so reads of it would miss matches
+            std::string original(DocumentSize, 'x');
+            std::vector<std::string> blocks(NeedleCount * 24 / ScribbleBlockSize + 16, std::string(ScribbleBlockSize, 'x'));
+
+            while (!search.isComplete()) {
+                static_cast<void>(search.poll());
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+            if (search.getStats().matchCount != NeedleCount) {
+                std::println(stderr, "Close: round {} found {} matches in the closed document, expected {}", round,
+                    search.getStats().matchCount, NeedleCount);
+                passed = false;
+            }
+        }
+        search.cancel();
+        highlighter.shutdown();
+        const double maxCloseSeconds = *std::max_element(closeSeconds.begin(), closeSeconds.end());
+
+        std::println("Close: {} documents of {} MiB closed, {} while being searched", RoundCount, DocumentSize >> 20, closedMidSearch);
+        std::println("Close: close p50 {:.3f} ms  max {:.3f} ms", getMedian(closeSeconds) * 1000.0, maxCloseSeconds * 1000.0);
+        if (passed) {
+            std::println("Close: every search of a closed document found all {} matches", NeedleCount);
+        }
+        return passed ? 0 : 1;
+    }
+
+}
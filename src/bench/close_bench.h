@@ -0,0 +1,22 @@
+#pragma once
+
+#include "bench/bench_options.h"
+
+namespace drite {
+
+    /**
+     * @brief Time closing documents that are being searched and highlighted for drite-bench close.
+     *
+     * Each round edits a large document so its matches live in add blocks,
+     * starts a search and highlighting on it, and closes it a little later in
+     * every round, while the workers still read it. The freed memory is then
+     * overwritten before the search finishes, which must still find every
+     * match. Run under AddressSanitizer this also catches the highlighter
+     * reading a closed document.
+     *
+     * @param options The parsed options, with the search thread count.
+     * @return The exit status: 0 on success, 1 if a search of a closed document found the wrong matches.
+     */
+    [[nodiscard]] int runCloseBench(const BenchOptions& options);
+
+}
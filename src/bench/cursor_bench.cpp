@@ -0,0 +1,174 @@
+#include "bench/cursor_bench.h"
+#include "bench/bench_helpers.h"
+#include "editor/document.h"
+#include <chrono>
+#include <print>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace drite {
+
+    /**
+     * @brief The identifier every cursor sits after, renamed by the keystrokes.
+     */
+    static constexpr std::string_view OldName = "value";
+
+    /**
+     * @brief The name typed in its place.
+     */
+    static constexpr std::string_view NewName = "result";
+
+    /**
+     * @brief Generate one line of code per cursor and the cursor offsets, each just after OldName.
+     * @param count The number of lines.
+     * @param cursors Receives the cursor offsets.
+     * @return The text.
+     */
+    static std::string generateLines(size_t count, std::vector<size_t>& cursors) {
+        std::string text;
+        cursors.clear();
+        cursors.reserve(count);
+        for (size_t line = 0; line < count; ++line) {
+            const std::string number = std::to_string(line);
+            text += "    int ";
+            text += OldName;
+            cursors.push_back(text.size());
+            text += number + " = compute(" + number + ");\n";
+        }
+        return text;
+    }
+
+    /**
+     * @brief Build the key events of the rename: erase OldName, type NewName, then comment the line out.
+     * @return The key presses in order.
+     */
+    static std::vector<KeyEvent> makeKeystrokes() {
+        std::vector<KeyEvent> events;
+        const auto press = [&events](KeyCode key) {
+            KeyEvent event;
+            event.key = key;
+            event.action = KeyAction::Press;
+            events.push_back(event);
+        };
+
+        for (size_t i = 0; i < OldName.size(); ++i) {
+            press(KeyCode::Backspace);
+        }
+        for (const char character : NewName) {
+            press(static_cast<KeyCode>(static_cast<int>(KeyCode::A) + (character - 'a')));
+        }
+        press(KeyCode::Home);
+        press(KeyCode::Slash);
+        press(KeyCode::Slash);
+        press(KeyCode::Space);
+        return events;
+    }
+
+    /**
+     * @brief Print the median and worst of a set of keystroke latencies.
+     * @param label The name of the run.
+     * @param seconds The latency of each keystroke; sorted in place.
+     * @param undoGroups The number of undo groups the run left.
+     * @return The total of the latencies.
+     */
+    static double printLatencies(std::string_view label, std::vector<double>& seconds, size_t undoGroups) {
+        const double median = getMedian(seconds);
+        double total{0.0};
+        for (const double value : seconds) {
+            total += value;
+        }
+        std::println("Cursors: {:<10} p50 {:9.3f} ms  max {:9.3f} ms  total {:9.2f} ms  {:7} undo groups", label,
+            median * 1000.0, seconds.back() * 1000.0, total * 1000.0, undoGroups);
+        return total;
+    }
+
+    /**
+     * @brief Time editing with many cursors for drite-bench cursors.
+     * @param options The parsed options.
+     * @return The exit status: 0 on success, 1 if the two ways of editing disagree.
+     */
+    int runCursorBench(const BenchOptions& options) {
+        const size_t count = options.count;
+        std::vector<size_t> offsets;
+        const std::string text = generateLines(count, offsets);
+        const std::vector<KeyEvent> keystrokes = makeKeystrokes();
+        std::println("Cursors: {} cursors in {} bytes, renaming '{}' to '{}' in {} keystrokes", count, text.size(), OldName, NewName,
+            keystrokes.size());
+
+        // Every keystroke as one batch at all cursors
+        Document batched{TextBuffer(text)};
+        batched.setCursors(offsets, offsets.front());
+        std::vector<double> batchedSeconds;
+        for (const KeyEvent& event : keystrokes) {
+            const auto start = std::chrono::steady_clock::now();
+            static_cast<void>(batched.handleKey(event));
+            static_cast<void>(batched.takeLineChange());
+            batchedSeconds.push_back(getSecondsSince(start));
+        }
+        const std::string batchedText = batched.getBuffer().getText();
+        const double batchedTotal = printLatencies("batched", batchedSeconds, batched.getHistory().getStats().undoGroups);
+
+        // The same keystrokes applied at one cursor after another, last first
+        // so the cursors still to be edited do not move
+        Document sequential{TextBuffer(text)};
+        std::vector<size_t> cursors = offsets;
+        std::vector<size_t> moved(count);
+        std::vector<ptrdiff_t> grown(count);
+        std::vector<double> sequentialSeconds;
+        for (const KeyEvent& event : keystrokes) {
+            const auto start = std::chrono::steady_clock::now();
+            for (size_t i = count; i-- > 0;) {
+                const size_t sizeBefore = sequential.getBuffer().getSize();
+                sequential.setCursor(cursors[i]);
+                static_cast<void>(sequential.handleKey(event));
+                moved[i] = sequential.getCursor();
+                grown[i] = static_cast<ptrdiff_t>(sequential.getBuffer().getSize()) - static_cast<ptrdiff_t>(sizeBefore);
+            }
+            ptrdiff_t shift{0};
+            for (size_t i = 0; i < count; ++i) {
+                cursors[i] = static_cast<size_t>(static_cast<ptrdiff_t>(moved[i]) + shift);
+                shift += grown[i];
+            }
+            static_cast<void>(sequential.takeLineChange());
+            sequentialSeconds.push_back(getSecondsSince(start));
+        }
+        const double sequentialTotal = printLatencies("per cursor", sequentialSeconds, sequential.getHistory().getStats().undoGroups);
+
+        if (sequential.getBuffer().getText() != batchedText) {
+            std::println(stderr, "Cursors: the batched and per-cursor edits produced different text");
+            return 1;
+        }
+
+        // Each batch is one undo step
+        auto start = std::chrono::steady_clock::now();
+        size_t undone{0};
+        while (batched.undo()) {
+            ++undone;
+        }
+        const double undoSeconds = getSecondsSince(start);
+        // Groups dropped to stay within the undo budget cannot be undone, so
+        // the original text only comes back if none were
+        const bool complete = batched.getHistory().getStats().droppedGroups == 0;
+        const bool restored = !complete || (batched.getBuffer().getText() == text && batched.getCursors().size() == count);
+
+        start = std::chrono::steady_clock::now();
+        while (batched.redo()) {
+        }
+        const double redoSeconds = getSecondsSince(start);
+        const bool reapplied = batched.getBuffer().getText() == batchedText && batched.getCursors().size() == count;
+
+        std::println("Cursors: undo {} steps {:.2f} ms, redo {:.2f} ms, {} pieces", undone, undoSeconds * 1000.0, redoSeconds * 1000.0,
+            batched.getBuffer().getPieceCount());
+        if (!complete) {
+            std::println("Cursors: {} early steps exceeded the undo budget and were dropped", batched.getHistory().getStats().droppedGroups);
+        }
+        if (!restored || !reapplied) {
+            std::println(stderr, "Cursors: undo or redo did not restore the text and cursors");
+            return 1;
+        }
+        std::println("Cursors: batched {:.1f}x faster, results match", batchedTotal > 0.0 ? sequentialTotal / batchedTotal : 0.0);
+        return 0;
+    }
+
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include "bench/bench_options.h"
+
+namespace drite {
+
+    /**
+     * @brief Time editing with many cursors for drite-bench cursors.
+     *
+     * Generates one line of code per cursor, puts a cursor after the same
+     * identifier on every line and replays a rename typed as key events:
+     * backspaces, the new name, Home and a line comment. Each keystroke is
+     * applied once as a batch at all cursors, and once as one edit per
+     * cursor through the single-cursor path. The latency per keystroke of
+     * both, undoing and redoing the batches, and whether the results agree
+     * are printed.
+     *
+     * @param options The parsed options.
+     * @return The exit status: 0 on success, 1 if the two ways of editing disagree.
+     */
+    [[nodiscard]] int runCursorBench(const BenchOptions& options);
+
+}
@@ -0,0 +1,259 @@
+#include "bench/draw_bench.h"
+#include "bench/bench_helpers.h"
+#include "editor/document.h"
+#include "graphics/command_buffer.h"
+#include "graphics/instance_ring.h"
+#include "graphics/software/software_graphics_context.h"
+#include "render/builtin_font.h"
+#include "render/glyph_atlas.h"
+#include "render/text_renderer.h"
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <print>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace drite {
+
+    /**
+     * @brief The size of the screen drawn.
+     */
+    static constexpr int ScreenWidth = 1920;
+    static constexpr int ScreenHeight = 1080;
+
+    /**
+     * @brief The font size, small enough for about ten thousand glyphs on the screen.
+     */
+    static constexpr uint16_t FontSize = 14;
+
+    /**
+     * @brief Frames scrolled through, one line each.
+     */
+    static constexpr size_t FrameCount = 300;
+
+    /**
+     * @brief Batches a frame may take before the bench fails.
+     */
+    static constexpr size_t MaxBatches = 8;
+
+    /**
+     * @brief Frames recorded ahead of the GPU, as in the Metal backend.
+     */
+    static constexpr uint64_t FramesInFlight = 3;
+
+    /**
+     * @brief Alignment of each frame's instances in the ring, as in the Metal backend.
+     */
+    static constexpr size_t InstanceAlignment = 256;
+
+    /**
+     * @brief Instance ring size to start with, as in the Metal backend.
+     */
+    static constexpr size_t InitialRingBytes = 4 * 1024 * 1024;
+
+    /**
+     * @brief The identifier underlined as a search match.
+     */
+    static constexpr std::string_view MatchedName = "value";
+
+    /**
+     * @brief Code the generated lines are cut from.
+     */
+    static constexpr std::string_view Snippet =
+        "const auto value = compute(index, offset) * scale + bias; if (value > limit) { result.push_back(value); } ";
+
+    /**
+     * @brief Generate lines of code of varying length, none wider than the screen.
+     * @param lineCount The number of lines.
+     * @param columns The cells across the screen.
+     * @param lengths Receives the length of each line without its terminator.
+     * @return The text.
+     */
+    static std::string generateScreenText(size_t lineCount, size_t columns, std::vector<size_t>& lengths) {
+        std::string text;
+        lengths.clear();
+        for (size_t line = 0; line < lineCount; ++line) {
+            // Between a third of the width and all of it, like real code
+            const size_t length = columns / 3 + (line * 37 % 100) * (columns - columns / 3) / 100;
+            const size_t indent = line % 4 * 4;
+            std::string content(indent, ' ');
+            while (content.size() < length) {
+                content += Snippet.substr((line * 11) % 40);
+            }
+            content.resize(length);
+            text += content;
+            text += '\n';
+            lengths.push_back(length);
+        }
+        return text;
+    }
+
+    /**
+     * @brief Find every occurrence of MatchedName.
+     * @param text The text.
+     * @return The matches in order.
+     */
+    static std::vector<SearchMatch> findMatches(std::string_view text) {
+        std::vector<SearchMatch> matches;
+        for (size_t offset = text.find(MatchedName); offset != std::string_view::npos; offset = text.find(MatchedName, offset + 1)) {
+            matches.push_back(SearchMatch{offset, MatchedName.size()});
+        }
+        return matches;
+    }
+
+    /**
+     * @brief Measure how a full screen of text is batched for drite-bench draw.
+     * @param options The parsed options.
+     * @return The exit status: 0 on success, 1 if the frame takes more than a few batches or the ring stalls.
+     */
+    int runDrawBench(const BenchOptions& /* options */) {
+        BuiltinFontRasterizer font;
+        GlyphAtlas atlas{font};
+        TextRenderer renderer{atlas, FontSize};
+        renderer.setCursorVisible(true);
+
+        const int lineHeight = renderer.getLineHeight();
+        const float advance = renderer.getAdvance();
+        const auto columns = static_cast<size_t>(static_cast<float>(ScreenWidth) / advance);
+        const auto visibleLines = static_cast<size_t>((ScreenHeight + lineHeight - 1) / lineHeight);
+
+        std::vector<size_t> lengths;
+        const std::string text = generateScreenText(visibleLines + FrameCount, columns, lengths);
+        std::vector<size_t> lineStarts{0};
+        for (const size_t length : lengths) {
+            lineStarts.push_back(lineStarts.back() + length + 1);
+        }
+        const std::vector<SearchMatch> matches = findMatches(text);
+
+        // A cursor on every fourth line
+        Document document{TextBuffer(text)};
+        std::vector<size_t> cursors;
+        for (size_t line = 0; line < lengths.size(); line += 4) {
+            cursors.push_back(lineStarts[line] + std::min<size_t>(8, lengths[line]));
+        }
+        document.setCursors(cursors, cursors.front());
+
+        TextDecorations decorations;
+        decorations.matches = matches;
+        decorations.currentMatch = matches.front().offset;
+
+        DrawList textList;
+        DrawList overlayList;
+        std::vector<VisualRow> rows;
+        const auto drawFrame = [&](size_t firstLine) {
+            rows.clear();
+            for (size_t line = firstLine; line < firstLine + visibleLines; ++line) {
+                rows.push_back(VisualRow{line, 0, 0, lengths[line]});
+            }
+            atlas.beginFrame();
+            textList.reset();
+            renderer.drawDocument(document, rows, ScreenWidth, textList, decorations);
+
+            // Matches are also underlined, as diagnostics would be
+            overlayList.reset();
+            const auto first = std::lower_bound(matches.begin(), matches.end(), SearchMatch{lineStarts[firstLine], 0});
+            for (auto match = first; match != matches.end() && match->offset < lineStarts[firstLine + visibleLines]; ++match) {
+                const auto line = static_cast<size_t>(std::upper_bound(lineStarts.begin(), lineStarts.end(), match->offset) - lineStarts.begin() - 1);
+                const auto column = static_cast<float>(match->offset - lineStarts[line]);
+                const int y = static_cast<int>(line - firstLine + 1) * lineHeight - 1;
+                overlayList.addLine(static_cast<int>(column * advance), y, static_cast<int>((column + static_cast<float>(match->length)) * advance), y, 1,
+                                    Color{0.9f, 0.3f, 0.3f, 1.0f}, DrawLayer::Overlay);
+            }
+        };
+
+        // Scroll one line per frame, recording and uploading as a backend
+        // would; the GPU is modelled as finishing each frame FramesInFlight
+        // frames after it was submitted
+        CommandBuffer commands;
+        InstanceRing ring;
+        std::vector<std::byte> ringMemory;
+        std::vector<double> recordSeconds;
+        std::vector<double> writeSeconds;
+        CommandBufferStats worst;
+        size_t totalBatches{0};
+        size_t totalUnsorted{0};
+        size_t totalCommands{0};
+        size_t glyphs{0};
+        size_t growths{0};
+        size_t peakUsed{0};
+        for (uint64_t frame = 1; frame <= FrameCount; ++frame) {
+            drawFrame(static_cast<size_t>(frame - 1));
+
+            auto start = std::chrono::steady_clock::now();
+            commands.reset();
+            commands.record(textList);
+            commands.record(overlayList);
+            commands.finish();
+            recordSeconds.push_back(getSecondsSince(start));
+
+            const CommandBufferStats& stats = commands.getStats();
+            totalBatches += stats.batches;
+            totalUnsorted += stats.unsortedBatches;
+            totalCommands += stats.commands;
+            if (stats.batches >= worst.batches) {
+                worst = stats;
+            }
+            if (frame == 1) {
+                for (const DrawBatch& batch : commands.getBatches()) {
+                    glyphs += batch.type == DrawCommandType::Glyph ? batch.count : 0;
+                }
+            }
+
+            if (frame > FramesInFlight) {
+                ring.retire(frame - FramesInFlight);
+            }
+            const size_t bytes = commands.getCommands().size() * sizeof(QuadInstance);
+            std::optional<size_t> offset = ring.allocate(bytes, InstanceAlignment);
+            if (!offset) {
+                // Sized as the Metal backend does: room for every frame in
+                // flight, the one being written and the padding skipped at
+                // the end of the buffer; after the first frame a growth means
+                // waiting for the GPU to go idle
+                growths += frame > 1;
+                const size_t capacity = std::max({ring.getCapacity() * 2, InitialRingBytes,
+                                                  (bytes + InstanceAlignment - 1) / InstanceAlignment * InstanceAlignment * static_cast<size_t>(FramesInFlight + 1)});
+                ring.reset(capacity);
+                ringMemory.assign(capacity, std::byte{0});
+                offset = ring.allocate(bytes, InstanceAlignment);
+            }
+
+            start = std::chrono::steady_clock::now();
+            writeInstances(commands.getCommands(), reinterpret_cast<QuadInstance*>(ringMemory.data() + *offset));
+            writeSeconds.push_back(getSecondsSince(start));
+            ring.endFrame(frame);
+            peakUsed = std::max(peakUsed, ring.getUsed());
+        }
+
+        const auto perFrame = [](size_t total) { return static_cast<double>(total) / static_cast<double>(FrameCount); };
+        std::println("Draw: {}x{} screen, {} glyphs in {} visible lines, {:.0f} commands per frame", ScreenWidth, ScreenHeight, glyphs, visibleLines,
+            perFrame(totalCommands));
+        std::println("Draw: {:.1f} batches per frame sorted (at most {}), {:.1f} in submission order", perFrame(totalBatches), worst.batches,
+            perFrame(totalUnsorted));
+        std::println("Draw: worst frame {} pipeline and {} texture binds", worst.pipelineChanges, worst.textureChanges);
+        std::println("Draw: record and sort p50 {:.1f} us, instance upload p50 {:.1f} us ({} KiB)", getMedian(recordSeconds) * 1e6,
+            getMedian(writeSeconds) * 1e6, commands.getCommands().size() * sizeof(QuadInstance) / 1024);
+        std::println("Draw: {} frames through a {} KiB instance ring with {} in flight, at most {} KiB in use, {} regrowths", FrameCount,
+            ring.getCapacity() / 1024, FramesInFlight, peakUsed / 1024, growths);
+
+        // The same frame on the CPU, which draws the batches in order too
+        SoftwareGraphicsContext context(ScreenWidth, ScreenHeight);
+        if (context.initialize()) {
+            context.beginFrame();
+            context.clear(ClearColor{0.1f, 0.1f, 0.2f, 1.0f});
+            context.submit(textList);
+            context.submit(overlayList);
+            context.endFrame();
+            std::println("Draw: software rasterizer {:.2f} ms for the last frame", context.getLastRasterTime());
+        }
+
+        if (worst.batches > MaxBatches || growths > 0) {
+            std::println(stderr, "Draw: a frame took {} batches (budget {}) or the instance ring had to grow {} times", worst.batches, MaxBatches,
+                growths);
+            return 1;
+        }
+        return 0;
+    }
+
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include "bench/bench_options.h"
+
+namespace drite {
+
+    /**
+     * @brief Measure how a full screen of text is batched for drite-bench draw.
+     *
+     * Draws a 1920x1080 screen of generated code through the text renderer,
+     * with search matches, cursors and underlines, and records it into a
+     * command buffer as a backend would. Prints the commands, the batches
+     * and state changes with and without sorting, the time to sort and to
+     * write the GPU instances, and replays a scroll through an instance ring
+     * with frames in flight to check that uploads never wait for the GPU.
+     * The frame is also rasterized once in software.
+     *
+     * @param options The parsed options.
+     * @return The exit status: 0 on success, 1 if the frame takes more than a few batches or the ring stalls.
+     */
+    [[nodiscard]] int runDrawBench(const BenchOptions& options);
+
+}
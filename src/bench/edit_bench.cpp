@@ -0,0 +1,276 @@
+#include "bench/edit_bench.h"
+#include "bench/bench_helpers.h"
+#include "editor/text_buffer.h"
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <chrono>
+#include <print>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace drite {
+
+    /**
+     * @brief Sizes of the generated documents, from a small file to one far larger than any edited by hand.
+     */
+    static constexpr std::array<size_t, 5> BenchSizes = {
+        size_t{1} << 10, size_t{32} << 10, size_t{1} << 20, size_t{32} << 20, size_t{1} << 30};
+
+    /**
+     * @brief Timed edits of each kind per document.
+     */
+    static constexpr size_t EditsPerKind = 20000;
+
+    /**
+     * @brief Keystrokes typed at one place before moving to another.
+     */
+    static constexpr size_t TypingRunLength = 16;
+
+    /**
+     * @brief Characters typed in turn, line feeds included.
+     */
+    static constexpr std::string_view TypedCharacters = "abcdefghijklmnopqrstuvwxyz\n";
+
+    /**
+     * @brief Text inserted by each short insert.
+     */
+    static constexpr std::string_view InsertText = "inserted";
+
+    /**
+     * @brief Longest run of bytes one deletion removes.
+     */
+    static constexpr size_t MaxEraseLength = 16;
+
+    /**
+     * @brief Largest document also edited as a plain string to check the result.
+     */
+    static constexpr size_t CheckedSizeLimit = size_t{1} << 20;
+
+    /**
+     * @brief Size of the document the balance check edits.
+     */
+    static constexpr size_t BalanceDocumentSize = size_t{1} << 20;
+
+    /**
+     * @brief Deletions at falling offsets the balance check starts with, as when editing at many cursors last first.
+     */
+    static constexpr size_t BackToFrontEdits = 20000;
+
+    /**
+     * @brief Random inserts and deletions of the balance check.
+     */
+    static constexpr size_t BalanceEdits = 200000;
+
+    /**
+     * @brief Edits between two batched replacements of the balance check.
+     */
+    static constexpr size_t BalanceBatchInterval = 2000;
+
+    /**
+     * @brief Replacements in each batch of the balance check.
+     */
+    static constexpr size_t BalanceBatchSize = 10000;
+
+    /**
+     * @brief Get the deepest the piece tree of a buffer may be while balanced.
+     *
+     * A treap over n pieces is about 3 log2 n deep at worst with random
+     * priorities; one whose heap order was broken degrades towards a list.
+     *
+     * @param pieceCount The number of pieces.
+     * @return The depth limit.
+     */
+    static size_t getDepthLimit(size_t pieceCount) {
+        return 4 * static_cast<size_t>(std::bit_width(pieceCount)) + 4;
+    }
+
+    /**
+     * @brief Print the depth of the piece tree after a run of edits and check it is within its limit.
+     * @param buffer The edited buffer.
+     * @param after What the edits were.
+     * @return True if the tree is balanced.
+     */
+    static bool checkDepth(const TextBuffer& buffer, std::string_view after) {
+        const size_t depth = buffer.getTreeDepth();
+        const size_t limit = getDepthLimit(buffer.getPieceCount());
+        std::println("Edits: after {}: {} pieces, tree depth {} (limit {})", after, buffer.getPieceCount(), depth, limit);
+        if (depth > limit) {
+            std::println(stderr, "Edits: the piece tree is out of balance after {}", after);
+            return false;
+        }
+        return true;
+    }
+
+    /**
+     * @brief Print the median, 99th percentile and worst of a set of edit latencies.
+     * @param size The document size label.
+     * @param kind The kind of edit.
+     * @param seconds The latency of each edit; sorted in place.
+     */
+    static void printLatencies(std::string_view size, std::string_view kind, std::vector<double>& seconds) {
+        const double median = getMedian(seconds);
+        std::println("Edits: {:<8} {:<7} p50 {:8.3f} us  p99 {:8.3f} us  max {:9.3f} us", size, kind, median * 1e6,
+            getPercentile(seconds, 99) * 1e6, seconds.back() * 1e6);
+    }
+
+    /**
+     * @brief Time the edits of every kind on one document size.
+     * @param size The document size in bytes.
+     * @param random The random source.
+     * @return True if the document and its tree are as expected afterwards.
+     */
+    static bool benchSize(size_t size, std::mt19937_64& random) {
+        const std::string label = describeSize(size);
+        std::string text = generateText(size);
+        const bool checked = size <= CheckedSizeLimit;
+        std::string expected = checked ? text : std::string{};
+
+        auto start = std::chrono::steady_clock::now();
+        TextBuffer buffer{std::move(text)};
+        const double loadSeconds = getSecondsSince(start);
+
+        std::vector<double> seconds;
+        seconds.reserve(EditsPerKind);
+
+        // Typing: runs of single characters, each extending the last insert
+        size_t cursor{0};
+        for (size_t i = 0; i < EditsPerKind; ++i) {
+            if (i % TypingRunLength == 0) {
+                cursor = random() % (buffer.getSize() + 1);
+            }
+            const std::string_view character = TypedCharacters.substr(i % TypedCharacters.size(), 1);
+            start = std::chrono::steady_clock::now();
+            buffer.insert(cursor, character);
+            seconds.push_back(getSecondsSince(start));
+            if (checked) {
+                expected.insert(cursor, character);
+            }
+            ++cursor;
+        }
+        printLatencies(label, "typing", seconds);
+
+        seconds.clear();
+        for (size_t i = 0; i < EditsPerKind; ++i) {
+            const size_t offset = random() % (buffer.getSize() + 1);
+            start = std::chrono::steady_clock::now();
+            buffer.insert(offset, InsertText);
+            seconds.push_back(getSecondsSince(start));
+            if (checked) {
+                expected.insert(offset, InsertText);
+            }
+        }
+        printLatencies(label, "insert", seconds);
+
+        seconds.clear();
+        for (size_t i = 0; i < EditsPerKind; ++i) {
+            const size_t offset = random() % (buffer.getSize() + 1);
+            const size_t length = 1 + random() % MaxEraseLength;
+            start = std::chrono::steady_clock::now();
+            buffer.erase(offset, length);
+            seconds.push_back(getSecondsSince(start));
+            if (checked) {
+                expected.erase(offset, length);
+            }
+        }
+        printLatencies(label, "erase", seconds);
+
+        std::println("Edits: {:<8} loaded in {:.2f} ms", label, loadSeconds * 1000.0);
+        if (checked && buffer.getText() != expected) {
+            std::println(stderr, "Edits: the {} document does not match the same edits on a string", label);
+            return false;
+        }
+        return checkDepth(buffer, "editing " + label);
+    }
+
+    /**
+     * @brief Edit one document at length and check its tree stays balanced.
+     *
+     * Deletions applied back to front and batched replacements keep cutting
+     * the remainder of one piece in the middle of a split, which is where the
+     * heap order of the treap is easiest to break.
+     *
+     * @param random The random source.
+     * @return True if the text matches a plain string given the same edits and the tree is within its depth limit.
+     */
+    static bool checkBalance(std::mt19937_64& random) {
+        std::string expected = generateText(BalanceDocumentSize);
+        TextBuffer buffer{expected};
+
+        const size_t step = buffer.getSize() / (BackToFrontEdits + 1);
+        for (size_t i = BackToFrontEdits; i > 0; --i) {
+            buffer.erase(i * step, 2);
+            expected.erase(i * step, 2);
+        }
+        const bool backToFront = checkDepth(buffer, std::to_string(BackToFrontEdits) + " deletions back to front");
+
+        std::vector<size_t> offsets;
+        std::vector<PieceEdit> edits;
+        std::string replaced;
+        size_t batches{0};
+        for (size_t i = 0; i < BalanceEdits; ++i) {
+            // Every so often, replace short ranges at sorted random offsets in one pass
+            if (i % BalanceBatchInterval == 0) {
+                const Piece piece = buffer.appendText(InsertText);
+                offsets.clear();
+                for (size_t j = 0; j < BalanceBatchSize; ++j) {
+                    offsets.push_back(random() % (buffer.getSize() + 1));
+                }
+                std::sort(offsets.begin(), offsets.end());
+                offsets.erase(std::unique(offsets.begin(), offsets.end()), offsets.end());
+
+                edits.clear();
+                replaced.clear();
+                size_t copied{0};
+                for (size_t j = 0; j < offsets.size(); ++j) {
+                    const size_t gap = (j + 1 < offsets.size() ? offsets[j + 1] : buffer.getSize()) - offsets[j];
+                    const size_t length = std::min<size_t>(random() % 4, gap);
+                    edits.push_back({offsets[j], length, std::span<const Piece>(&piece, 1)});
+                    replaced.append(expected, copied, offsets[j] - copied);
+                    replaced += InsertText;
+                    copied = offsets[j] + length;
+                }
+                replaced.append(expected, copied);
+                buffer.replacePieces(edits);
+                expected.swap(replaced);
+                ++batches;
+            }
+
+            const size_t offset = random() % (buffer.getSize() + 1);
+            if (random() % 2 == 0) {
+                buffer.insert(offset, InsertText);
+                expected.insert(offset, InsertText);
+            } else {
+                const size_t length = 1 + random() % MaxEraseLength;
+                buffer.erase(offset, length);
+                expected.erase(offset, length);
+            }
+        }
+
+        const bool scattered =
+            checkDepth(buffer, std::to_string(BalanceEdits) + " random edits and " + std::to_string(batches) + " batches");
+        if (buffer.getText() != expected) {
+            std::println(stderr, "Edits: the balance document does not match the same edits on a string");
+            return false;
+        }
+        return backToFront && scattered;
+    }
+
+    /**
+     * @brief Time single edits on documents from 1 KiB to 1 GiB for drite-bench edits.
+     * @param options The parsed options.
+     * @return The exit status: 0 on success, 1 if the text is wrong or the tree is out of balance.
+     */
+    int runEditBench(const BenchOptions& /* options */) {
+        std::mt19937_64 random{0x5EED};
+        bool passed{true};
+        for (const size_t size : BenchSizes) {
+            passed = benchSize(size, random) && passed;
+        }
+        passed = checkBalance(random) && passed;
+        return passed ? 0 : 1;
+    }
+
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include "bench/bench_options.h"
+
+namespace drite {
+
+    /**
+     * @brief Time single edits on documents from 1 KiB to 1 GiB for drite-bench edits.
+     *
+     * Generates a document of each size and times typing runs, short inserts
+     * and short deletions at random offsets, one edit at a time, printing the
+     * median, 99th percentile and worst latency of each kind. The documents
+     * up to 1 MiB are edited alongside a plain string and compared with it.
+     * Afterwards a long run of random inserts, deletions and batched
+     * replacements checks that the piece tree stays balanced.
+     *
+     * @param options The parsed options.
+     * @return The exit status: 0 on success, 1 if the text is wrong or the tree is out of balance.
+     */
+    [[nodiscard]] int runEditBench(const BenchOptions& options);
+
+}
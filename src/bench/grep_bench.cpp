@@ -0,0 +1,423 @@
+#include "bench/grep_bench.h"
+#include "bench/bench_helpers.h"
+#include "core/job_system.h"
+#include "io/temporary_file.h"
+#include "search/literal_search.h"
+#include "search/project_search.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <fcntl.h>
+#include <mutex>
+#include <optional>
+#include <print>
+#include <random>
+#include <string>
+#include <string_view>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace drite {
+
+    /**
+     * @brief The token planted in the generated files.
+     */
+    static constexpr std::string_view NeedleToken = "needle_token";
+
+    /**
+     * @brief A regular expression matching every planted line.
+     */
+    static constexpr std::string_view NeedleRegex = "needle_token\\(\\d+\\)";
+
+    /**
+     * @brief Files in each leaf directory of the tree.
+     */
+    static constexpr size_t FilesPerDirectory = 40;
+
+    /**
+     * @brief Subdirectories of the root and of each of its subdirectories.
+     */
+    static constexpr size_t DirectoryFanOut = 16;
+
+    /**
+     * @brief Smallest size of an ordinary file.
+     */
+    static constexpr size_t MinFileSize = 256;
+
+    /**
+     * @brief Largest size of an ordinary file.
+     */
+    static constexpr size_t MaxFileSize = 8192;
+
+    /**
+     * @brief Every this many files one is large enough to be mapped.
+     */
+    static constexpr size_t LargeFileInterval = 5000;
+
+    /**
+     * @brief Every this many files one starts with NUL bytes and is binary.
+     */
+    static constexpr size_t BinaryFileInterval = 50;
+
+    /**
+     * @brief Every this many files one is a log file, ignored by the .gitignore.
+     */
+    static constexpr size_t LogFileInterval = 100;
+
+    /**
+     * @brief Files in the ignored build directory.
+     */
+    static constexpr size_t BuildFileCount = 64;
+
+    /**
+     * @brief One line in this many is a planted line.
+     */
+    static constexpr size_t NeedleLineInterval = 64;
+
+    /**
+     * @brief Runs of each search; the fastest is reported.
+     */
+    static constexpr int BenchRuns = 3;
+
+    /**
+     * @brief The generated tree and what a search of it must find.
+     */
+    struct SyntheticTree {
+        std::string root;
+        std::vector<std::string> files;
+        std::vector<std::string> directories;
+        std::vector<std::string> searchedFiles;
+        size_t plantedLines{0};
+        size_t binaryFiles{0};
+        size_t ignoredPaths{0};
+        uint64_t searchedBytes{0};
+    };
+
+    /**
+     * @brief Generate source-like text with planted lines.
+     * @param random The random source.
+     * @param size The number of bytes to generate, at least; lines are never cut.
+     * @param planted Incremented for every planted line.
+     * @return The text.
+     */
+    static std::string generatePlantedText(std::mt19937_64& random, size_t size, size_t& planted) {
+        std::string text;
+        text.reserve(size + 128);
+        for (size_t line = 0; text.size() < size; ++line) {
+            const uint64_t value = random();
+            if (value % NeedleLineInterval == 0) {
+                text += "    result = needle_token(" + std::to_string(value % 100000) + ");\n";
+                ++planted;
+            } else {
+                text += "    const auto value" + std::to_string(line) + " = compute(index, " + std::to_string(value % 100000) +
+                        ") * scale; // adjust\n";
+            }
+        }
+        return text;
+    }
+
+    /**
+     * @brief Write a file of the tree.
+     * @param tree The tree; the file is recorded in it.
+     * @param path The path.
+     * @param text The contents.
+     * @return True if written.
+     */
+    static bool writeTreeFile(SyntheticTree& tree, const std::string& path, std::string_view text) {
+        const int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (fd < 0) {
+            std::println(stderr, "Grep: failed to create {}: {}", path, std::strerror(errno));
+            return false;
+        }
+        tree.files.push_back(path);
+        const bool written = ::write(fd, text.data(), text.size()) == static_cast<ssize_t>(text.size());
+        ::close(fd);
+        if (!written) {
+            std::println(stderr, "Grep: failed to write {}: {}", path, std::strerror(errno));
+        }
+        return written;
+    }
+
+    /**
+     * @brief Create a directory of the tree unless it already exists.
+     * @param tree The tree; a new directory is recorded in it.
+     * @param path The path; its parent must exist.
+     * @return True if the directory exists.
+     */
+    static bool makeTreeDirectory(SyntheticTree& tree, const std::string& path) {
+        if (::mkdir(path.c_str(), 0755) == 0) {
+            tree.directories.push_back(path);
+            return true;
+        }
+        if (errno == EEXIST) {
+            return true;
+        }
+        std::println(stderr, "Grep: failed to create {}: {}", path, std::strerror(errno));
+        return false;
+    }
+
+    /**
+     * @brief Write the generated files below the root of a tree.
+     * @param tree The tree, with its root created.
+     * @param fileCount The number of files outside the build directory.
+     * @return True if every file was written.
+     */
+    static bool writeTree(SyntheticTree& tree, size_t fileCount) {
+        std::mt19937_64 random{0x6E3E};
+        size_t ignoredLines{0};
+        if (!writeTreeFile(tree, tree.root + "/.gitignore", "build/\n*.log\n")) {
+            return false;
+        }
+        tree.searchedFiles.push_back(tree.files.back());
+        tree.searchedBytes += 13;
+
+        // Ignored paths are still on disk and hold the token, so skipping them is checked too
+        const std::string build = tree.root + "/build";
+        if (!makeTreeDirectory(tree, build)) {
+            return false;
+        }
+        ++tree.ignoredPaths;
+        for (size_t index = 0; index < BuildFileCount; ++index) {
+            if (!writeTreeFile(tree, build + "/object-" + std::to_string(index) + ".cpp", generatePlantedText(random, MaxFileSize, ignoredLines))) {
+                return false;
+            }
+        }
+
+        std::string directory;
+        for (size_t index = 0; index < fileCount; ++index) {
+            const size_t leaf = index / FilesPerDirectory;
+            const std::string top = tree.root + "/src" + std::to_string(leaf % DirectoryFanOut);
+            const std::string middle = top + "/module" + std::to_string(leaf / DirectoryFanOut % DirectoryFanOut);
+            const std::string bottom = middle + "/part" + std::to_string(leaf / (DirectoryFanOut * DirectoryFanOut));
+            if (bottom != directory) {
+                if (!makeTreeDirectory(tree, top) || !makeTreeDirectory(tree, middle) || !makeTreeDirectory(tree, bottom)) {
+                    return false;
+                }
+                directory = bottom;
+            }
+
+            const bool large = index % LargeFileInterval == LargeFileInterval - 1;
+            const size_t size = large ? ProjectSearch::MapThreshold * 2 : MinFileSize + random() % (MaxFileSize - MinFileSize);
+            const std::string name = directory + "/file" + std::to_string(index);
+            if (index % LogFileInterval == LogFileInterval / 2) {
+                ++tree.ignoredPaths;
+                if (!writeTreeFile(tree, name + ".log", generatePlantedText(random, size, ignoredLines))) {
+                    return false;
+                }
+            } else if (index % BinaryFileInterval == BinaryFileInterval - 1) {
+                ++tree.binaryFiles;
+                std::string text(16, '\0');
+                text += generatePlantedText(random, size, ignoredLines);
+                if (!writeTreeFile(tree, name + ".bin", text)) {
+                    return false;
+                }
+            } else {
+                const std::string text = generatePlantedText(random, size, tree.plantedLines);
+                if (!writeTreeFile(tree, name + ".cpp", text)) {
+                    return false;
+                }
+                tree.searchedFiles.push_back(tree.files.back());
+                tree.searchedBytes += text.size();
+            }
+        }
+        return true;
+    }
+
+    /**
+     * @brief Remove the files and directories of a tree, and its root.
+     * @param tree The tree.
+     */
+    static void removeTree(const SyntheticTree& tree) {
+        for (const std::string& path : tree.files) {
+            ::unlink(path.c_str());
+        }
+        for (auto it = tree.directories.rbegin(); it != tree.directories.rend(); ++it) {
+            ::rmdir(it->c_str());
+        }
+        ::rmdir(tree.root.c_str());
+    }
+
+    /**
+     * @brief Search a tree once, waiting for the search to finish.
+     * @param tree The tree.
+     * @param query The query.
+     * @param jobs The job system to search on.
+     * @param stats Receives the stats of the search.
+     * @return True if the search found exactly the planted lines and the expected files.
+     */
+    static bool searchTree(const SyntheticTree& tree, const SearchQuery& query, JobSystem& jobs, ProjectSearchStats& stats) {
+        std::mutex mutex;
+        std::condition_variable resultsReady;
+        bool ready{false};
+        ProjectSearch search(jobs);
+        search.setResultCallback([&] {
+            {
+                std::lock_guard lock(mutex);
+                ready = true;
+            }
+            resultsReady.notify_one();
+        });
+        if (!search.start({tree.root}, query)) {
+            std::println(stderr, "Grep: the search of {} did not start", tree.root);
+            return false;
+        }
+
+        std::vector<ProjectFileMatch> results;
+        size_t lines{0};
+        bool planted{true};
+        while (!search.isComplete()) {
+            {
+                std::unique_lock lock(mutex);
+                resultsReady.wait(lock, [&] { return ready; });
+                ready = false;
+            }
+            results.clear();
+            static_cast<void>(search.poll(results));
+            for (const ProjectFileMatch& file : results) {
+                lines += file.lines.size();
+                for (const ProjectLineMatch& line : file.lines) {
+                    planted = planted && line.text.find(NeedleToken) != std::string::npos;
+                }
+            }
+        }
+
+        stats = search.getStats();
+        if (!planted || lines != tree.plantedLines || stats.matchedLines != tree.plantedLines) {
+            std::println(stderr, "Grep: found {} lines, not the {} planted", lines, tree.plantedLines);
+            return false;
+        }
+        if (stats.filesSearched != tree.searchedFiles.size() || stats.binaryFiles != tree.binaryFiles ||
+            stats.ignoredPaths != tree.ignoredPaths || stats.bytesSearched != tree.searchedBytes) {
+            std::println(stderr, "Grep: searched {} files ({} bytes), skipped {} binary and {} ignored; expected {} ({} bytes), {} and {}",
+                stats.filesSearched, stats.bytesSearched, stats.binaryFiles, stats.ignoredPaths, tree.searchedFiles.size(),
+                tree.searchedBytes, tree.binaryFiles, tree.ignoredPaths);
+            return false;
+        }
+        return true;
+    }
+
+    /**
+     * @brief Read and search the searched files of a tree one after another on this thread, as a baseline.
+     * @param tree The tree.
+     * @return The number of lines holding the token.
+     */
+    static size_t searchSequentially(const SyntheticTree& tree) {
+        std::string text;
+        size_t lines{0};
+        for (const std::string& path : tree.searchedFiles) {
+            const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+            if (fd < 0) {
+                continue;
+            }
+            struct stat info{};
+            text.resize(::fstat(fd, &info) == 0 ? static_cast<size_t>(info.st_size) : 0);
+            size_t total{0};
+            while (total < text.size()) {
+                const ssize_t count = ::read(fd, text.data() + total, text.size() - total);
+                if (count <= 0) {
+                    break;
+                }
+                total += static_cast<size_t>(count);
+            }
+            ::close(fd);
+
+            const std::string_view view(text.data(), total);
+            for (size_t found = view.find(NeedleToken); found != std::string_view::npos;) {
+                ++lines;
+                const size_t lineEnd = view.find('\n', found);
+                found = lineEnd == std::string_view::npos ? lineEnd : view.find(NeedleToken, lineEnd);
+            }
+        }
+        return lines;
+    }
+
+    /**
+     * @brief Search a written tree with each query and thread count.
+     * @param tree The tree.
+     * @param options The parsed options.
+     * @return The exit status: 0 on success, 1 if a search found the wrong lines.
+     */
+    static int benchTree(const SyntheticTree& tree, const BenchOptions& options) {
+        const unsigned maxThreads = options.threadCount > 0 ? options.threadCount : std::max(std::thread::hardware_concurrency(), 1u);
+        std::vector<unsigned> threadCounts;
+        for (unsigned count = 1; count < maxThreads; count *= 2) {
+            threadCounts.push_back(count);
+        }
+        threadCounts.push_back(maxThreads);
+
+        constexpr double MiB = 1024.0 * 1024.0;
+        const double megabytes = static_cast<double>(tree.searchedBytes) / MiB;
+        std::println("Grep: {} files in {} directories, {:.1f} MiB searched, {} planted lines, best of {} runs", tree.files.size(),
+            tree.directories.size() + 1, megabytes, tree.plantedLines, BenchRuns);
+
+        double baseline{0.0};
+        for (int run = 0; run < BenchRuns; ++run) {
+            const auto start = std::chrono::steady_clock::now();
+            const size_t lines = searchSequentially(tree);
+            const double seconds = getSecondsSince(start);
+            baseline = run == 0 ? seconds : std::min(baseline, seconds);
+            if (lines != tree.plantedLines) {
+                std::println(stderr, "Grep: the sequential baseline found {} lines, not the {} planted", lines, tree.plantedLines);
+                return 1;
+            }
+        }
+        std::println("Grep: sequential read and find, no walk: {:9.2f} ms {:8.0f} MiB/s", baseline * 1000.0,
+            baseline > 0.0 ? megabytes / baseline : 0.0);
+
+        for (const bool regex : {false, true}) {
+            SearchQuery query;
+            query.pattern = regex ? NeedleRegex : NeedleToken;
+            query.ignoreCase = false;
+            query.regex = regex;
+            for (const unsigned threadCount : threadCounts) {
+                JobSystem jobs(threadCount);
+                double best{0.0};
+                size_t steals{0};
+                for (int run = 0; run < BenchRuns; ++run) {
+                    ProjectSearchStats stats;
+                    if (!searchTree(tree, query, jobs, stats)) {
+                        return 1;
+                    }
+                    if (run == 0 || stats.seconds < best) {
+                        best = stats.seconds;
+                        steals = stats.steals;
+                    }
+                }
+                std::println("Grep: {:<8} {:>3} threads: {:9.2f} ms {:8.0f} MiB/s {:8.0f} files/s, {} steals",
+                    regex ? "regex" : getLiteralSearchName(), threadCount, best * 1000.0, best > 0.0 ? megabytes / best : 0.0,
+                    best > 0.0 ? static_cast<double>(tree.files.size()) / best : 0.0, steals);
+            }
+        }
+        std::println("Grep: every search found the planted lines and skipped the binary and ignored files");
+        return 0;
+    }
+
+    /**
+     * @brief Time project search over a generated directory tree for drite-bench grep.
+     * @param options The parsed options, with the file count.
+     * @return The exit status: 0 on success, 1 if the tree could not be written or a search found the wrong lines.
+     */
+    int runGrepBench(const BenchOptions& options) {
+        const std::optional<std::string> root = createTemporaryDirectory("drite-grep");
+        if (!root) {
+            std::println(stderr, "Grep: failed to create a directory: {}", std::strerror(errno));
+            return 1;
+        }
+
+        SyntheticTree tree;
+        tree.root = *root;
+        const auto start = std::chrono::steady_clock::now();
+        const bool written = writeTree(tree, options.count);
+        if (written) {
+            std::println("Grep: wrote the tree in {:.2f} s; it is searched from the page cache", getSecondsSince(start));
+        }
+        const int status = written ? benchTree(tree, options) : 1;
+        removeTree(tree);
+        return status;
+    }
+
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include "bench/bench_options.h"
+
+namespace drite {
+
+    /**
+     * @brief Time project search over a generated directory tree for drite-bench grep.
+     *
+     * Writes N files of source-like text into a temporary tree three levels
+     * deep, with a .gitignore excluding a build directory and log files, some
+     * binary files and a large file or two that are mapped instead of read.
+     * A known number of lines hold the searched token. The tree is searched
+     * for a literal and a regular expression on 1 to --threads workers, best
+     * of a few runs each, against reading and searching the same files on one
+     * thread without walking. Every run is checked for the expected lines and
+     * file counts, and the tree is removed afterwards.
+     *
+     * @param options The parsed options, with the file count.
+     * @return The exit status: 0 on success, 1 if the tree could not be written or a search found the wrong lines.
+     */
+    [[nodiscard]] int runGrepBench(const BenchOptions& options);
+
+}
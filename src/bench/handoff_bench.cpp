@@ -0,0 +1,278 @@
+#include "bench/handoff_bench.h"
+#include "application/handoff_command.h"
+#include "application/single_instance.h"
+#include "bench/bench_helpers.h"
+#include "io/temporary_file.h"
+#include <chrono>
+#include <climits>
+#include <csignal>
+#include <cstring>
+#include <fcntl.h>
+#include <optional>
+#include <print>
+#include <spawn.h>
+#include <string>
+#include <string_view>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+extern char** environ;
+
+namespace drite {
+
+    /**
+     * @brief Median handoff time the bench fails at, in seconds.
+     */
+    static constexpr double HandoffBudget = 0.001;
+
+    /**
+     * @brief Cold starts timed for comparison.
+     */
+    static constexpr int ColdStarts = 10;
+
+    /**
+     * @brief Time to wait for the editor to start listening, in seconds.
+     */
+    static constexpr double StartTimeout = 10.0;
+
+    /**
+     * @brief Lines in each file handed over.
+     */
+    static constexpr int FileLines = 40;
+
+    /**
+     * @brief Start the editor with its output discarded.
+     * @param executable The editor executable.
+     * @param arguments The arguments after the executable name.
+     * @return The process id, or std::nullopt if it could not be started.
+     */
+    static std::optional<pid_t> spawnEditor(const std::string& executable, const std::vector<std::string>& arguments) {
+        std::vector<char*> argv{const_cast<char*>(executable.c_str())};
+        for (const std::string& argument : arguments) {
+            argv.push_back(const_cast<char*>(argument.c_str()));
+        }
+        argv.push_back(nullptr);
+
+        posix_spawn_file_actions_t actions;
+        posix_spawn_file_actions_init(&actions);
+        posix_spawn_file_actions_addopen(&actions, STDOUT_FILENO, "/dev/null", O_WRONLY, 0);
+
+        pid_t pid{0};
+        const int result = ::posix_spawnp(&pid, executable.c_str(), &actions, nullptr, argv.data(), environ);
+        posix_spawn_file_actions_destroy(&actions);
+        if (result != 0) {
+            std::println(stderr, "Handoff: failed to start {}: {}", executable, std::strerror(result));
+            return std::nullopt;
+        }
+        return pid;
+    }
+
+    /**
+     * @brief Wait for a process to exit.
+     * @param pid The process id.
+     * @return True if it exited with status 0.
+     */
+    static bool waitForExit(pid_t pid) {
+        int status{0};
+        while (::waitpid(pid, &status, 0) < 0) {
+            if (errno != EINTR) {
+                return false;
+            }
+        }
+        return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+    }
+
+    /**
+     * @brief Write the small source files handed over.
+     * @param directory The directory to write them to.
+     * @param count The number of files.
+     * @return The absolute paths, or an empty list if writing failed.
+     */
+    static std::vector<std::string> writeFiles(const std::string& directory, size_t count) {
+        std::string text;
+        for (int line = 0; line < FileLines; ++line) {
+            text += "    const int value" + std::to_string(line) + " = compute(" + std::to_string(line * 3) + ") + offset; // line " + std::to_string(line + 1) + "\n";
+        }
+
+        std::vector<std::string> paths;
+        for (size_t index = 0; index < count; ++index) {
+            std::string path = directory + "/file-" + std::to_string(index) + ".cpp";
+            const int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0600);
+            const bool written = fd >= 0 && ::write(fd, text.data(), text.size()) == static_cast<ssize_t>(text.size());
+            if (fd >= 0) {
+                ::close(fd);
+            }
+            if (!written) {
+                std::println(stderr, "Handoff: failed to write {}: {}", path, std::strerror(errno));
+                return {};
+            }
+            paths.push_back(std::move(path));
+        }
+        return paths;
+    }
+
+    /**
+     * @brief Hand files to a running editor and time each handoff.
+     * @param socketPath The editor's socket.
+     * @param paths The files, one per handoff.
+     * @param seconds Receives the time of each handoff.
+     * @return True if every file was opened.
+     */
+    static bool handOff(const std::string& socketPath, const std::vector<std::string>& paths, std::vector<double>& seconds) {
+        for (const std::string& path : paths) {
+            const auto start = std::chrono::steady_clock::now();
+            InstanceClient client;
+            InstanceRequest request;
+            request.files.push_back(path);
+            request.line = FileLines / 2;
+            const std::optional<std::string> reply = client.connect(socketPath) ? client.send(request) : std::nullopt;
+            seconds.push_back(getSecondsSince(start));
+            if (reply != "ok") {
+                std::println(stderr, "Handoff: {} was not opened: {}", path, reply.value_or("no connection"));
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /**
+     * @brief Check that invocations acting on a new editor's state are not handed to a running one.
+     * @param socketPath The running editor's socket.
+     * @param path A file to open.
+     * @return True if a plain invocation was handed over and none of the others were.
+     */
+    static bool checkExclusions(const std::string& socketPath, const std::string& path) {
+        CommandLineOptions plain;
+        plain.headless = true;
+        plain.socketPath = socketPath;
+        plain.files.push_back(path);
+        if (runHandoff(plain) != 0) {
+            std::println(stderr, "Handoff: a plain invocation was not handed to the running editor");
+            return false;
+        }
+
+        const std::pair<std::string_view, std::string CommandLineOptions::*> exclusions[] = {
+            {"--find", &CommandLineOptions::findPattern},
+            {"--save-as", &CommandLineOptions::saveAsPath},
+            {"--profile", &CommandLineOptions::profilePath},
+            {"--session", &CommandLineOptions::sessionPath},
+        };
+        for (const auto& [option, field] : exclusions) {
+            CommandLineOptions options = plain;
+            options.*field = path + ".excluded";
+            if (runHandoff(options)) {
+                std::println(stderr, "Handoff: a {} invocation was handed to the running editor instead of starting its own", option);
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /**
+     * @brief Check that an editor refuses to listen where another user could replace its socket.
+     * @param directory A private directory to make the shared directory and the link in.
+     * @return True if listening in a directory others can write to, and through a symbolic link, were both refused.
+     */
+    static bool checkPrivateDirectory(const std::string& directory) {
+        const std::string shared = directory + "/shared";
+        const std::string link = directory + "/link";
+        const bool made = ::mkdir(shared.c_str(), S_IRWXU) == 0 && ::chmod(shared.c_str(), S_IRWXU | S_IRWXG | S_IRWXO) == 0 &&
+                          ::symlink(directory.c_str(), link.c_str()) == 0;
+        bool refused{false};
+        if (made) {
+            InstanceServer open;
+            InstanceServer linked;
+            refused = !open.start(shared + "/editor.sock", [](uint64_t, InstanceRequest) {}) &&
+                      !linked.start(link + "/editor.sock", [](uint64_t, InstanceRequest) {});
+        }
+        ::unlink(link.c_str());
+        ::rmdir(shared.c_str());
+        if (!made || !refused) {
+            std::println(stderr, "Handoff: an editor listened in a directory others can write to or through a symbolic link");
+            return false;
+        }
+        return true;
+    }
+
+    /**
+     * @brief Time handing files to a running editor for drite-bench handoff.
+     * @param options The parsed options, with the handoff count.
+     * @return The exit status: 0 on success, 1 if the editor failed or the median handoff took a millisecond or more.
+     */
+    int runHandoffBench(const BenchOptions& options) {
+        const std::optional<std::string> created = createTemporaryDirectory("drite-handoff");
+        if (!created) {
+            std::println(stderr, "Handoff: failed to create a directory: {}", std::strerror(errno));
+            return 1;
+        }
+        const std::string directory = *created;
+        const std::string socketPath = directory + "/editor.sock";
+        const std::vector<std::string> paths = writeFiles(directory, options.count);
+
+        // The editor runs until it is terminated, idle between requests
+        const auto launched = std::chrono::steady_clock::now();
+        const std::optional<pid_t> editor = paths.empty() ? std::nullopt
+            : spawnEditor(options.editorPath, {"--headless", "--duration", "3600", "--socket", socketPath});
+        bool listening{false};
+        while (editor && !listening && getSecondsSince(launched) < StartTimeout) {
+            InstanceClient probe;
+            listening = probe.connect(socketPath);
+            if (!listening) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        }
+        const double readySeconds = getSecondsSince(launched);
+
+        std::vector<double> handoffSeconds;
+        const bool handedOff = listening && handOff(socketPath, paths, handoffSeconds) && checkExclusions(socketPath, paths.front()) &&
+                               checkPrivateDirectory(directory);
+        if (editor) {
+            ::kill(*editor, SIGTERM);
+            static_cast<void>(waitForExit(*editor));
+        }
+
+        // Cold starts render the first frame of the file and exit
+        std::vector<double> coldSeconds;
+        for (int run = 0; handedOff && run < ColdStarts; ++run) {
+            const auto start = std::chrono::steady_clock::now();
+            const std::optional<pid_t> cold = spawnEditor(options.editorPath, {"--headless", "--frames", "1", paths.front()});
+            if (!cold || !waitForExit(*cold)) {
+                break;
+            }
+            coldSeconds.push_back(getSecondsSince(start));
+        }
+
+        for (const std::string& path : paths) {
+            ::unlink(path.c_str());
+        }
+        ::unlink(socketPath.c_str());
+        ::rmdir(directory.c_str());
+
+        if (!listening) {
+            std::println(stderr, "Handoff: the editor did not start listening on {}", socketPath);
+            return 1;
+        }
+        if (!handedOff || coldSeconds.size() != static_cast<size_t>(ColdStarts)) {
+            return 1;
+        }
+
+        const double handoffMedian = getMedian(handoffSeconds) * 1e3;
+        const double coldMedian = getMedian(coldSeconds) * 1e3;
+        std::println("Handoff: editor listening {:.1f} ms after launch", readySeconds * 1e3);
+        std::println("Handoff: {} files handed over, p50 {:.3f} ms, p99 {:.3f} ms, max {:.3f} ms", handoffSeconds.size(), handoffMedian,
+            getPercentile(handoffSeconds, 99) * 1e3, handoffSeconds.back() * 1e3);
+        std::println("Handoff: {} cold starts to the first frame, p50 {:.1f} ms, {:.0f}x the handoff", coldSeconds.size(), coldMedian,
+            coldMedian / handoffMedian);
+
+        if (handoffMedian >= HandoffBudget * 1e3) {
+            std::println(stderr, "Handoff: the median handoff took {:.3f} ms (budget {:.0f} ms)", handoffMedian, HandoffBudget * 1e3);
+            return 1;
+        }
+        return 0;
+    }
+
+}
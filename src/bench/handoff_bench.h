@@ -0,0 +1,23 @@
+#pragma once
+
+#include "bench/bench_options.h"
+
+namespace drite {
+
+    /**
+     * @brief Time handing files to a running editor for drite-bench handoff.
+     *
+     * Starts a headless editor listening on a private socket and hands it N
+     * small files one at a time, as drite-cli would, timing each from
+     * connecting to the editor's reply that the file is open. A few cold
+     * starts of a headless editor rendering one frame of the same file are
+     * timed for comparison. Invocations with --find, --save-as, --profile or
+     * --session are checked to start an editor of their own instead, and an
+     * editor is checked to refuse a socket directory others can write to.
+     *
+     * @param options The parsed options.
+     * @return The exit status: 0 on success, 1 if the editor failed or the median handoff took a millisecond or more.
+     */
+    [[nodiscard]] int runHandoffBench(const BenchOptions& options);
+
+}
@@ -0,0 +1,252 @@
+#include "bench/index_bench.h"
+#include "bench/bench_helpers.h"
+#include "editor/line_index.h"
+#include "editor/newline_scanner.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <print>
+#include <random>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace drite {
+
+    /**
+     * @brief Size of the generated text.
+     */
+    static constexpr size_t BenchTextSize = size_t{256} * 1024 * 1024;
+
+    /**
+     * @brief Longest generated line, excluding its line feed.
+     */
+    static constexpr size_t MaxLineLength = 120;
+
+    /**
+     * @brief Runs of each full scan; the fastest is reported.
+     */
+    static constexpr int BenchRuns = 3;
+
+    /**
+     * @brief Bytes appended at a time when extending an index, about a burst of typing.
+     */
+    static constexpr size_t AppendSize = 32;
+
+    /**
+     * @brief Bytes appended in total when extending an index.
+     */
+    static constexpr size_t AppendTotal = size_t{16} * 1024 * 1024;
+
+    /**
+     * @brief Random range counts and line lookups timed against the index.
+     */
+    static constexpr size_t QueryCount = 1000000;
+
+    /**
+     * @brief Largest line feed index a lookup asks for, relative to its start offset.
+     */
+    static constexpr size_t MaxLookupDistance = 1000;
+
+    /**
+     * @brief Generate lines of random length and record where each line feed is.
+     * @param random The random source.
+     * @param lineFeeds Receives the offset of every line feed in order.
+     * @return The text, exactly BenchTextSize bytes.
+     */
+    static std::string generateRandomLines(std::mt19937_64& random, std::vector<size_t>& lineFeeds) {
+        static constexpr std::string_view Words = "    return compute(value, offset) + table[index] * scale; // adjust the result for the next pass ";
+
+        std::string text;
+        text.reserve(BenchTextSize + MaxLineLength + 1);
+        lineFeeds.clear();
+        lineFeeds.reserve(BenchTextSize / (MaxLineLength / 2));
+        while (text.size() < BenchTextSize) {
+            size_t length = random() % (MaxLineLength + 1);
+            while (length > 0) {
+                const size_t part = std::min(length, Words.size());
+                text.append(Words.substr(0, part));
+                length -= part;
+            }
+            lineFeeds.push_back(text.size());
+            text += '\n';
+        }
+        text.resize(BenchTextSize);
+        while (!lineFeeds.empty() && lineFeeds.back() >= text.size()) {
+            lineFeeds.pop_back();
+        }
+        return text;
+    }
+
+    /**
+     * @brief Count line feeds one byte at a time, as a baseline for the kernels.
+     * @param text The text.
+     * @return The number of line feeds.
+     */
+    static size_t countByteLoop(std::string_view text) {
+        size_t count{0};
+        for (const char byte : text) {
+            count += byte == '\n';
+        }
+        return count;
+    }
+
+    /**
+     * @brief Count line feeds by jumping from one to the next with memchr, as a baseline for the kernels.
+     * @param text The text.
+     * @return The number of line feeds.
+     */
+    static size_t countMemchr(std::string_view text) {
+        size_t count{0};
+        const char* position = text.data();
+        const char* end = text.data() + text.size();
+        while (const void* found = std::memchr(position, '\n', static_cast<size_t>(end - position))) {
+            ++count;
+            position = static_cast<const char*>(found) + 1;
+        }
+        return count;
+    }
+
+    /**
+     * @brief Time a full scan of the text several times and keep the fastest run.
+     * @param scan The scan; returns its result.
+     * @param result Receives the result of the last run.
+     * @return The fastest run in seconds.
+     */
+    template <typename Scan>
+    static double timeScan(const Scan& scan, size_t& result) {
+        double best{0.0};
+        for (int run = 0; run < BenchRuns; ++run) {
+            const auto start = std::chrono::steady_clock::now();
+            result = scan();
+            const double seconds = getSecondsSince(start);
+            best = run == 0 ? seconds : std::min(best, seconds);
+        }
+        return best;
+    }
+
+    /**
+     * @brief Convert bytes scanned in a time to GiB per second.
+     * @param bytes The bytes scanned.
+     * @param seconds The time taken.
+     * @return The throughput.
+     */
+    static double getGibPerSecond(size_t bytes, double seconds) {
+        return seconds > 0.0 ? static_cast<double>(bytes) / (1024.0 * 1024.0 * 1024.0) / seconds : 0.0;
+    }
+
+    /**
+     * @brief Time line feed scanning and the chunked line index for drite-bench index.
+     * @param options The parsed options.
+     * @return The exit status: 0 on success, 1 if a kernel or the index gives a wrong answer.
+     */
+    int runIndexBench(const BenchOptions& /* options */) {
+        std::mt19937_64 random{0x11DE};
+        std::vector<size_t> lineFeeds;
+        const std::string text = generateRandomLines(random, lineFeeds);
+        const std::string_view view{text};
+        const size_t expected = lineFeeds.size();
+        std::println("Index: {}, {} line feeds, {} kernel", describeSize(text.size()), expected, getNewlineScannerName());
+
+        // Whole-text scans with the selected kernel and the two baselines
+        size_t kernelCount{0}, byteCount{0}, memchrCount{0}, lastOffset{0};
+        const double kernelSeconds = timeScan([&] { return countLineFeeds(text.data(), text.size()); }, kernelCount);
+        const double byteSeconds = timeScan([&] { return countByteLoop(view); }, byteCount);
+        const double memchrSeconds = timeScan([&] { return countMemchr(view); }, memchrCount);
+        const double findSeconds = timeScan([&] { return findLineFeed(text.data(), text.size(), expected); }, lastOffset);
+        std::println("Index: count {:6.2f} GiB/s ({} kernel), byte loop {:6.2f} GiB/s, memchr {:6.2f} GiB/s",
+            getGibPerSecond(text.size(), kernelSeconds), getNewlineScannerName(), getGibPerSecond(text.size(), byteSeconds),
+            getGibPerSecond(text.size(), memchrSeconds));
+        std::println("Index: find  {:6.2f} GiB/s to the last line feed", getGibPerSecond(text.size(), findSeconds));
+        if (kernelCount != expected || byteCount != expected || memchrCount != expected ||
+            (expected > 0 && lastOffset != lineFeeds.back())) {
+            std::println(stderr, "Index: the scanners disagree on the line feeds of the text");
+            return 1;
+        }
+
+        // Building an index over the whole text at once
+        LineIndex index;
+        double buildSeconds{0.0};
+        for (int run = 0; run < BenchRuns; ++run) {
+            LineIndex built;
+            const auto start = std::chrono::steady_clock::now();
+            built.update(view);
+            const double seconds = getSecondsSince(start);
+            if (run == 0 || seconds < buildSeconds) {
+                buildSeconds = seconds;
+            }
+            index = std::move(built);
+        }
+        std::println("Index: build {:6.2f} GiB/s, {} KiB of index", getGibPerSecond(text.size(), buildSeconds),
+            index.getChunkPrefix().size() * sizeof(uint64_t) / 1024);
+        if (index.getLineFeedCount() != expected || !index.isConsistent(text.size())) {
+            std::println(stderr, "Index: the built index does not match the text");
+            return 1;
+        }
+
+        // Extending an index by short appends to a buffer that never moves, as an add block grows
+        std::string block;
+        block.reserve(AppendTotal);
+        LineIndex growing;
+        auto start = std::chrono::steady_clock::now();
+        for (size_t offset = 0; offset < AppendTotal; offset += AppendSize) {
+            block.append(view.substr(offset, AppendSize));
+            growing.update(block);
+        }
+        const double appendSeconds = getSecondsSince(start);
+        const size_t appendedLineFeeds =
+            static_cast<size_t>(std::lower_bound(lineFeeds.begin(), lineFeeds.end(), AppendTotal) - lineFeeds.begin());
+        std::println("Index: append {} bytes at a time: {:.1f} ns each, {:.2f} GiB/s", AppendSize,
+            appendSeconds * 1e9 / static_cast<double>(AppendTotal / AppendSize), getGibPerSecond(AppendTotal, appendSeconds));
+        if (growing.getLineFeedCount() != appendedLineFeeds || !growing.isConsistent(AppendTotal)) {
+            std::println(stderr, "Index: the index extended by appends does not match the text");
+            return 1;
+        }
+
+        // Random range counts and line lookups, checked against the line feed offsets
+        std::vector<size_t> starts(QueryCount), ends(QueryCount), counts(QueryCount);
+        for (size_t i = 0; i < QueryCount; ++i) {
+            starts[i] = random() % (text.size() + 1);
+            ends[i] = starts[i] + random() % (text.size() - starts[i] + 1);
+            counts[i] = 1 + random() % MaxLookupDistance;
+        }
+        std::vector<size_t> results(QueryCount);
+
+        start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < QueryCount; ++i) {
+            results[i] = index.countLineFeeds(view, starts[i], ends[i]);
+        }
+        const double countSeconds = getSecondsSince(start);
+        for (size_t i = 0; i < QueryCount; ++i) {
+            const auto first = std::lower_bound(lineFeeds.begin(), lineFeeds.end(), starts[i]);
+            const auto last = std::lower_bound(first, lineFeeds.end(), ends[i]);
+            if (results[i] != static_cast<size_t>(last - first)) {
+                std::println(stderr, "Index: counting the line feeds in [{}, {}) gave {}, not {}", starts[i], ends[i], results[i],
+                    last - first);
+                return 1;
+            }
+        }
+
+        start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < QueryCount; ++i) {
+            results[i] = index.findLineFeed(view, starts[i], counts[i]);
+        }
+        const double lookupSeconds = getSecondsSince(start);
+        for (size_t i = 0; i < QueryCount; ++i) {
+            const size_t first = static_cast<size_t>(std::lower_bound(lineFeeds.begin(), lineFeeds.end(), starts[i]) - lineFeeds.begin());
+            const size_t wanted = first + counts[i] - 1 < lineFeeds.size() ? lineFeeds[first + counts[i] - 1] : text.size();
+            if (results[i] != wanted) {
+                std::println(stderr, "Index: line feed {} from {} was found at {}, not {}", counts[i], starts[i], results[i], wanted);
+                return 1;
+            }
+        }
+
+        std::println("Index: {} random range counts {:.1f} ns each, lookups up to {} lines ahead {:.1f} ns each", QueryCount,
+            countSeconds * 1e9 / static_cast<double>(QueryCount), MaxLookupDistance,
+            lookupSeconds * 1e9 / static_cast<double>(QueryCount));
+        std::println("Index: all results match");
+        return 0;
+    }
+
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include "bench/bench_options.h"
+
+namespace drite {
+
+    /**
+     * @brief Time line feed scanning and the chunked line index for drite-bench index.
+     *
+     * Generates 256 MiB of lines of random length and measures the throughput
+     * of the vector kernel selected for this CPU when counting and locating
+     * line feeds, against a byte loop and memchr. It then times building a
+     * LineIndex over the text, extending one by short appends as typing
+     * does, and answering random range counts and line lookups. Every
+     * result is checked against a table of line feed offsets.
+     *
+     * @param options The parsed options.
+     * @return The exit status: 0 on success, 1 if a kernel or the index gives a wrong answer.
+     */
+    [[nodiscard]] int runIndexBench(const BenchOptions& options);
+
+}
@@ -0,0 +1,167 @@
+#include "bench/job_bench.h"
+#include "bench/bench_helpers.h"
+#include "core/job_system.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <print>
+#include <thread>
+#include <vector>
+
+namespace drite {
+
+    /**
+     * @brief Number of jobs of the empty and independent workloads.
+     */
+    static constexpr size_t BenchJobCount = 20000;
+
+    /**
+     * @brief Rounds of spinWork() per independent job, about 10 µs.
+     */
+    static constexpr unsigned BenchJobRounds = 4000;
+
+    /**
+     * @brief Elements of the parallel-for workload.
+     */
+    static constexpr size_t BenchElementCount = size_t{1} << 22;
+
+    /**
+     * @brief Elements per parallel-for job.
+     */
+    static constexpr size_t BenchGrain = 16384;
+
+    /**
+     * @brief Levels of the dependency tree workload; it has 2^depth - 1 jobs.
+     */
+    static constexpr unsigned BenchTreeDepth = 13;
+
+    /**
+     * @brief Runs of each workload; the fastest is reported.
+     */
+    static constexpr int BenchRuns = 3;
+
+    /**
+     * @brief Burn a fixed amount of CPU time the optimizer cannot remove.
+     * @param seed The starting value.
+     * @param rounds The number of xorshift rounds.
+     * @return The final value.
+     */
+    static uint64_t spinWork(uint64_t seed, unsigned rounds) noexcept {
+        uint64_t value = seed | 1;
+        for (unsigned round = 0; round < rounds; ++round) {
+            value ^= value << 13;
+            value ^= value >> 7;
+            value ^= value << 17;
+        }
+        return value;
+    }
+
+    /**
+     * @brief A benchmarked workload.
+     */
+    struct BenchWorkload {
+        const char* name;
+        size_t jobCount;
+        std::function<void(JobSystem&, std::atomic<uint64_t>&)> run;
+    };
+
+    /**
+     * @brief Submit the jobs of a subtree, each depending on its two children.
+     * @param jobs The job system.
+     * @param depth The levels below and including the root.
+     * @param sink Receives the results of the leaves.
+     * @return The root job.
+     */
+    static JobHandle submitTree(JobSystem& jobs, unsigned depth, std::atomic<uint64_t>& sink) {
+        if (depth == 1) {
+            return jobs.submit([&sink, depth] { sink.fetch_add(spinWork(depth, BenchJobRounds), std::memory_order_relaxed); },
+                               JobPriority::Frame);
+        }
+        const JobHandle children[] = {submitTree(jobs, depth - 1, sink), submitTree(jobs, depth - 1, sink)};
+        return jobs.submit([&sink, depth] { sink.fetch_add(spinWork(depth, BenchJobRounds / 4), std::memory_order_relaxed); },
+                           JobPriority::Frame, children);
+    }
+
+    /**
+     * @brief Time the job system on 1 to N worker threads for drite-bench jobs.
+     * @param options The parsed options.
+     * @return The exit status: 0.
+     */
+    int runJobBench(const BenchOptions& options) {
+        const unsigned maxThreads = options.threadCount > 0 ? options.threadCount : std::max(std::thread::hardware_concurrency(), 1u);
+        std::vector<unsigned> threadCounts;
+        for (unsigned count = 1; count < maxThreads; count *= 2) {
+            threadCounts.push_back(count);
+        }
+        threadCounts.push_back(maxThreads);
+
+        std::vector<uint32_t> elements(BenchElementCount);
+        const std::vector<BenchWorkload> workloads = {
+            {"empty", BenchJobCount, [](JobSystem& jobs, std::atomic<uint64_t>& sink) {
+                std::vector<JobHandle> handles;
+                handles.reserve(BenchJobCount);
+                for (size_t i = 0; i < BenchJobCount; ++i) {
+                    handles.push_back(jobs.submit([&sink] { sink.fetch_add(1, std::memory_order_relaxed); }));
+                }
+                for (const JobHandle& handle : handles) {
+                    jobs.wait(handle);
+                }
+            }},
+            {"independent", BenchJobCount, [](JobSystem& jobs, std::atomic<uint64_t>& sink) {
+                std::vector<JobHandle> handles;
+                handles.reserve(BenchJobCount);
+                for (size_t i = 0; i < BenchJobCount; ++i) {
+                    handles.push_back(jobs.submit([&sink, i] { sink.fetch_add(spinWork(i, BenchJobRounds), std::memory_order_relaxed); }));
+                }
+                for (const JobHandle& handle : handles) {
+                    jobs.wait(handle);
+                }
+            }},
+            {"parallel-for", BenchElementCount / BenchGrain, [&elements](JobSystem& jobs, std::atomic<uint64_t>&) {
+                jobs.parallelFor(elements.size(), BenchGrain, [&elements](size_t begin, size_t end) {
+                    for (size_t i = begin; i < end; ++i) {
+                        elements[i] = static_cast<uint32_t>(spinWork(i, 16));
+                    }
+                });
+            }},
+            {"dependency-tree", (size_t{1} << BenchTreeDepth) - 1, [](JobSystem& jobs, std::atomic<uint64_t>& sink) {
+                jobs.wait(submitTree(jobs, BenchTreeDepth, sink));
+            }},
+        };
+
+        std::println("Jobs: {} hardware threads, benchmarking 1 to {} workers, best of {} runs", std::thread::hardware_concurrency(),
+            maxThreads, BenchRuns);
+        std::vector<double> singleThreadSeconds(workloads.size(), 0.0);
+        std::atomic<uint64_t> sink{0};
+        for (const unsigned threadCount : threadCounts) {
+            JobSystem jobs(threadCount);
+            for (size_t w = 0; w < workloads.size(); ++w) {
+                const BenchWorkload& workload = workloads[w];
+                const uint64_t stolenBefore = jobs.getStats().stolen;
+                double best{0.0};
+                for (int run = 0; run < BenchRuns; ++run) {
+                    const auto startTime = std::chrono::steady_clock::now();
+                    workload.run(jobs, sink);
+                    const double seconds = getSecondsSince(startTime);
+                    best = run == 0 ? seconds : std::min(best, seconds);
+                }
+                if (threadCount == threadCounts.front()) {
+                    singleThreadSeconds[w] = best;
+                }
+
+                std::println("Jobs: {:<15} {:>3} workers {:>6} jobs in {:8.2f} ms ({:8.1f}k jobs/s, {:5.2f}x), {} stolen",
+                    workload.name, threadCount, workload.jobCount, best * 1000.0,
+                    best > 0.0 ? static_cast<double>(workload.jobCount) / best / 1.0e3 : 0.0,
+                    best > 0.0 ? singleThreadSeconds[w] / best : 0.0, (jobs.getStats().stolen - stolenBefore) / BenchRuns);
+            }
+        }
+
+        // The sink keeps the work observable
+        if (sink.load() == 0) {
+            std::println("Jobs: no work done");
+        }
+        return 0;
+    }
+
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include "bench/bench_options.h"
+
+namespace drite {
+
+    /**
+     * @brief Time the job system on 1 to N worker threads for drite-bench jobs.
+     *
+     * Runs empty jobs, independent jobs, a parallel for and a tree of
+     * dependent jobs on each thread count, up to --threads or one per
+     * core, and prints the time and speedup over one thread of each.
+     *
+     * @param options The parsed options.
+     * @return The exit status: 0.
+     */
+    [[nodiscard]] int runJobBench(const BenchOptions& options);
+
+}
@@ -0,0 +1,188 @@
+#include "bench/save_bench.h"
+#include "bench/bench_helpers.h"
+#include "editor/text_snapshot.h"
+#include "io/file_loader.h"
+#include "io/file_saver.h"
+#include "io/mapped_file.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fcntl.h>
+#include <memory>
+#include <optional>
+#include <print>
+#include <string>
+#include <sys/resource.h>
+#include <unistd.h>
+#include <vector>
+
+namespace drite {
+
+    /**
+     * @brief Size of the generated document when no file is given.
+     */
+    static constexpr size_t BenchDocumentSize = size_t{256} * 1024 * 1024;
+
+    /**
+     * @brief Bytes between the edits scattered through the document.
+     */
+    static constexpr size_t BenchEditInterval = 256 * 1024;
+
+    /**
+     * @brief Size of the buffer the raw baseline writes over and over.
+     */
+    static constexpr size_t RawWriteSize = 16 * 1024 * 1024;
+
+    /**
+     * @brief Runs of each writer; the fastest is reported.
+     */
+    static constexpr int BenchRuns = 3;
+
+    /**
+     * @brief Get the peak resident set size of the process.
+     * @return The peak in bytes.
+     */
+    static size_t getPeakResidentBytes() {
+        struct rusage usage{};
+        ::getrusage(RUSAGE_SELF, &usage);
+    #ifdef __APPLE__
+        return static_cast<size_t>(usage.ru_maxrss);
+    #else
+        return static_cast<size_t>(usage.ru_maxrss) * 1024;
+    #endif
+    }
+
+    /**
+     * @brief Write a number of bytes from one reused buffer and sync them: the raw baseline.
+     * @param path The file to write; removed afterwards.
+     * @param size The number of bytes to write.
+     * @param writeSeconds Receives the time spent writing.
+     * @param syncSeconds Receives the time spent syncing.
+     * @return True if everything was written.
+     */
+    static bool writeRaw(const std::string& path, size_t size, double& writeSeconds, double& syncSeconds) {
+        const int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (fd < 0) {
+            return false;
+        }
+
+        const std::vector<char> buffer(RawWriteSize, 'x');
+        const auto writeStart = std::chrono::steady_clock::now();
+        bool success{true};
+        for (size_t written = 0; success && written < size;) {
+            const ssize_t count = ::write(fd, buffer.data(), std::min(buffer.size(), size - written));
+            success = count > 0;
+            written += success ? static_cast<size_t>(count) : 0;
+        }
+        writeSeconds = getSecondsSince(writeStart);
+
+        const auto syncStart = std::chrono::steady_clock::now();
+        success = success && ::fsync(fd) == 0;
+        syncSeconds = getSecondsSince(syncStart);
+        ::close(fd);
+        ::unlink(path.c_str());
+        return success;
+    }
+
+    /**
+     * @brief Check that a file holds exactly the text of a snapshot.
+     * @param path The file.
+     * @param snapshot The expected text.
+     * @return True if the contents match.
+     */
+    static bool verifySaved(const std::string& path, const TextSnapshot& snapshot) {
+        const std::shared_ptr<const MappedFile> mapping = MappedFile::open(path);
+        if (!mapping) {
+            return snapshot.size == 0;
+        }
+
+        const std::string_view data = mapping->getData();
+        if (data.size() != snapshot.size) {
+            return false;
+        }
+        for (size_t i = 0; i < snapshot.chunks.size(); ++i) {
+            const std::string_view chunk = snapshot.chunks[i];
+            if (std::memcmp(data.data() + snapshot.chunkOffsets[i], chunk.data(), chunk.size()) != 0) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /**
+     * @brief Time saving a document for drite-bench save.
+     * @param options The parsed options.
+     * @return The exit status: 0 on success, 1 if a file could not be read, written or verified.
+     */
+    int runSaveBench(const BenchOptions& options) {
+        std::optional<TextBuffer> buffer;
+        if (options.files.empty()) {
+            buffer.emplace(generateText(BenchDocumentSize));
+        } else if (std::optional<LoadedFile> loaded = loadFile(options.files.front(), options.pageCacheMiB * 1024 * 1024)) {
+            buffer.emplace(std::move(loaded->buffer));
+        } else {
+            std::println(stderr, "Failed to open {}", options.files.front());
+            return 1;
+        }
+
+        // Edits spread through the document leave a piece table as fragmented as real editing does
+        const size_t originalSize = buffer->getSize();
+        for (size_t offset = BenchEditInterval / 2; offset < originalSize; offset += BenchEditInterval) {
+            buffer->insert(offset + (buffer->getSize() - originalSize), "edit");
+        }
+
+        const TextSnapshot snapshot = TextSnapshot::capture(*buffer);
+        std::println("Save: {} bytes in {} pieces to {}, best of {} runs", snapshot.size, snapshot.chunks.size(), options.path,
+            BenchRuns);
+
+        const size_t peakBefore = getPeakResidentBytes();
+        std::optional<SaveStats> best;
+        for (int run = 0; run < BenchRuns; ++run) {
+            const std::optional<SaveStats> stats = saveSnapshot(snapshot, options.path, [run](size_t written, size_t total) {
+                if (run == 0 && written < total) {
+                    std::println("Save: {:3}% written", written * 100 / total);
+                }
+            });
+            if (!stats) {
+                return 1;
+            }
+            if (!best || stats->writeSeconds + stats->syncSeconds < best->writeSeconds + best->syncSeconds) {
+                best = stats;
+            }
+        }
+        const size_t peakGrowth = getPeakResidentBytes() - peakBefore;
+
+        if (!verifySaved(options.path, snapshot)) {
+            std::println(stderr, "Save: {} does not match the document", options.path);
+            return 1;
+        }
+
+        double rawWrite{0.0};
+        double rawSync{0.0};
+        for (int run = 0; run < BenchRuns; ++run) {
+            double writeSeconds{0.0};
+            double syncSeconds{0.0};
+            if (!writeRaw(options.path + ".raw", snapshot.size, writeSeconds, syncSeconds)) {
+                std::println(stderr, "Save: raw write to {}.raw failed", options.path);
+                return 1;
+            }
+            if (run == 0 || writeSeconds + syncSeconds < rawWrite + rawSync) {
+                rawWrite = writeSeconds;
+                rawSync = syncSeconds;
+            }
+        }
+
+        constexpr double MiB = 1024.0 * 1024.0;
+        const double bytes = static_cast<double>(snapshot.size);
+        const double saveSeconds = best->writeSeconds + best->syncSeconds;
+        const double rawSeconds = rawWrite + rawSync;
+        std::println("Save: streamed   {:9.2f} ms write + {:9.2f} ms sync = {:8.1f} MiB/s in {} writev calls",
+            best->writeSeconds * 1000.0, best->syncSeconds * 1000.0, saveSeconds > 0.0 ? bytes / saveSeconds / MiB : 0.0, best->writeCalls);
+        std::println("Save: raw write  {:9.2f} ms write + {:9.2f} ms sync = {:8.1f} MiB/s from one {} MiB buffer",
+            rawWrite * 1000.0, rawSync * 1000.0, rawSeconds > 0.0 ? bytes / rawSeconds / MiB : 0.0, RawWriteSize / (1024 * 1024));
+        std::println("Save: {:.0f}% of raw bandwidth, verified, peak memory grew {:.1f} MiB while saving",
+            saveSeconds > 0.0 ? rawSeconds / saveSeconds * 100.0 : 0.0, static_cast<double>(peakGrowth) / MiB);
+        return 0;
+    }
+
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include "bench/bench_options.h"
+
+namespace drite {
+
+    /**
+     * @brief Time saving a document for drite-bench save.
+     *
+     * Loads the first file operand, or generates 256 MiB of text, scatters
+     * small edits through it so the piece table is fragmented as after a
+     * session of typing, and saves it to the given path. The same number of
+     * bytes is then written from one reused buffer with plain write() and
+     * fsync(), the best the disk allows, and both throughputs are printed.
+     *
+     * @param options The parsed options.
+     * @return The exit status: 0 on success, 1 if a file could not be read, written or verified.
+     */
+    [[nodiscard]] int runSaveBench(const BenchOptions& options);
+
+}
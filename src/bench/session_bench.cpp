@@ -0,0 +1,406 @@
+#include "bench/session_bench.h"
+#include "bench/bench_helpers.h"
+#include "editor/document.h"
+#include "io/file_loader.h"
+#include "io/session_snapshot.h"
+#include "io/temporary_file.h"
+#include "syntax/language.h"
+#include "syntax/syntax_highlighter.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <fcntl.h>
+#include <memory>
+#include <optional>
+#include <print>
+#include <string>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+namespace drite {
+
+    /**
+     * @brief Lines of generated code in each document.
+     */
+    static constexpr size_t GeneratedLines = 2000;
+
+    /**
+     * @brief Timed runs of each restore; the first is a warm-up that is not counted.
+     */
+    static constexpr int Runs = 11;
+
+    /**
+     * @brief How long ago the generated files were last modified, as in a session reopened the next day.
+     */
+    static constexpr time_t FileAgeSeconds = 3600;
+
+    /**
+     * @brief A generated document as the editor held it when the session was written.
+     */
+    struct BenchDocument {
+        std::string path;
+        std::unique_ptr<Document> document;
+        std::shared_ptr<const HighlightTable> highlights;
+        FileStamp stamp;
+        int64_t stampedNanoseconds{0};
+        uint64_t contentHash{0};
+    };
+
+    /**
+     * @brief Generate the code of one document, with block comments so lines end in different lexer states.
+     * @param index The document index.
+     * @return The text.
+     */
+    static std::string generateDocument(size_t index) {
+        std::string text;
+        for (size_t line = 0; line < GeneratedLines; ++line) {
+            if (line % 50 == 0) {
+                text += "/* Step " + std::to_string(line) + " of document " + std::to_string(index) + "\n";
+                text += " * scales the value computed for the index.\n */\n";
+                line += 2;
+                continue;
+            }
+            text += "    const auto value" + std::to_string(line) + " = compute(index, " + std::to_string(line * 7 + index) + ") * scale;\n";
+        }
+        return text;
+    }
+
+    /**
+     * @brief Write a file and date its modification time back.
+     * @param path The path.
+     * @param text The contents.
+     * @return True if written.
+     */
+    static bool writeAgedFile(const std::string& path, const std::string& text) {
+        const int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (fd < 0) {
+            std::println(stderr, "Session: failed to create {}: {}", path, std::strerror(errno));
+            return false;
+        }
+        const bool written = ::write(fd, text.data(), text.size()) == static_cast<ssize_t>(text.size());
+        ::close(fd);
+
+        const struct timespec aged{::time(nullptr) - FileAgeSeconds, 0};
+        const struct timespec times[2] = {aged, aged};
+        if (!written || ::utimensat(AT_FDCWD, path.c_str(), times, 0) != 0) {
+            std::println(stderr, "Session: failed to write {}: {}", path, std::strerror(errno));
+            return false;
+        }
+        return true;
+    }
+
+    /**
+     * @brief Lex every line of a buffer from the top, as the highlighter thread does.
+     * @param buffer The buffer.
+     * @param language The language rules.
+     * @return The table of exact end states.
+     */
+    static std::shared_ptr<const HighlightTable> lexBuffer(const TextBuffer& buffer, const Language& language) {
+        auto table = std::make_shared<HighlightTable>();
+        table->revision = buffer.getRevision();
+        table->lineCount = buffer.getLineCount();
+        LexState state = LexNormal;
+        for (size_t first = 0; first < table->lineCount; first += SyntaxHighlighter::BlockLines) {
+            auto block = std::make_shared<HighlightTable::Block>();
+            for (size_t line = first; line < std::min(first + SyntaxHighlighter::BlockLines, table->lineCount); ++line) {
+                state = tokenizeLine(language, buffer.getLine(line), state, nullptr);
+                block->states.push_back(state);
+            }
+            table->blockFirstLines.push_back(first);
+            table->blocks.push_back(std::move(block));
+        }
+        return table;
+    }
+
+    /**
+     * @brief Edit a document as a session would: a few insertions, one at several cursors, one undone.
+     * @param document The document.
+     * @param index The document index, to vary where it is edited.
+     */
+    static void editDocument(Document& document, size_t index) {
+        const TextBuffer& buffer = document.getBuffer();
+        for (size_t edit = 0; edit < 4; ++edit) {
+            document.setCursor(buffer.getLineStart(edit * 97 + index % 50));
+            document.insertAtCursor("    // edited in session " + std::to_string(index) + "\n");
+        }
+
+        const std::vector<size_t> cursors = {buffer.getLineStart(10) + 4, buffer.getLineStart(20) + 4, buffer.getLineStart(30) + 4};
+        document.setCursors(cursors, cursors[1]);
+        document.insertAtCursor("/* renamed */ ");
+        document.setCursor(buffer.getLineStart(40));
+        document.insertAtCursor("    // undone\n");
+        static_cast<void>(document.undo());
+
+        const std::vector<size_t> final = {buffer.getLineStart(60), buffer.getLineStart(61), buffer.getLineStart(62)};
+        document.setCursors(final, final[2]);
+        document.setScrollLine(index * 7 % GeneratedLines);
+    }
+
+    /**
+     * @brief Capture a bench document for the snapshot.
+     * @param bench The document.
+     * @return The state.
+     */
+    static SessionDocumentState captureBench(const BenchDocument& bench) {
+        SessionDocumentState state = captureSessionDocument(*bench.document, bench.highlights);
+        state.stamp = bench.stamp;
+        state.stampedNanoseconds = bench.stampedNanoseconds;
+        state.contentHash = bench.contentHash;
+        return state;
+    }
+
+    /**
+     * @brief Encode and write a snapshot of every bench document.
+     * @param path The snapshot file.
+     * @param documents The documents.
+     * @param sections Receives the encoded sections.
+     * @return The milliseconds spent encoding, or a negative value if writing failed.
+     */
+    static double writeBenchSnapshot(const std::string& path, const std::vector<BenchDocument>& documents,
+                                     std::vector<std::shared_ptr<const SessionSection>>& sections) {
+        const auto startTime = std::chrono::steady_clock::now();
+        sections.clear();
+        for (const BenchDocument& bench : documents) {
+            sections.push_back(std::make_shared<const SessionSection>(encodeSessionDocument(captureBench(bench))));
+        }
+        const double encodeTime = getSecondsSince(startTime) * 1e3;
+        return writeSessionSnapshot(path, sections, 0) ? encodeTime : -1.0;
+    }
+
+    /**
+     * @brief Check a restored document against the one the snapshot was written from.
+     * @param restored The restored document.
+     * @param bench The original.
+     * @return True if the text, cursors, scroll position, history and highlighting match.
+     */
+    static bool matches(const RestoredDocument& restored, const BenchDocument& bench) {
+        const Document& document = *restored.document;
+        const Document& original = *bench.document;
+        if (restored.stale || document.getBuffer().getText() != original.getBuffer().getText() ||
+            !std::ranges::equal(document.getCursors(), original.getCursors()) || document.getCursor() != original.getCursor() ||
+            document.getScrollLine() != original.getScrollLine() ||
+            document.getHistory().getStats().undoGroups != original.getHistory().getStats().undoGroups ||
+            document.getHistory().getStats().redoGroups != original.getHistory().getStats().redoGroups ||
+            !restored.highlights || restored.highlights->lineCount != bench.highlights->lineCount || restored.highlights->inexactLines != 0) {
+            return false;
+        }
+        for (size_t line = 0; line < bench.highlights->lineCount; ++line) {
+            if (restored.highlights->getEndState(line) != bench.highlights->getEndState(line)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /**
+     * @brief Time restoring every document of a snapshot.
+     * @param path The snapshot file.
+     * @param documents The documents it was written from, checked against the last run.
+     * @param hashed Receives the number of files hashed by the last run.
+     * @return The sorted times of the counted runs in milliseconds, or empty if a document failed to restore or differs.
+     */
+    static std::vector<double> timeRestore(const std::string& path, const std::vector<BenchDocument>& documents, size_t& hashed) {
+        std::vector<double> times;
+        for (int run = 0; run < Runs; ++run) {
+            const auto startTime = std::chrono::steady_clock::now();
+            const std::unique_ptr<SessionSnapshot> snapshot = SessionSnapshot::open(path);
+            std::vector<RestoredDocument> restored;
+            for (size_t i = 0; snapshot && i < snapshot->getDocumentCount(); ++i) {
+                if (std::optional<RestoredDocument> document = snapshot->restoreDocument(i, 0)) {
+                    restored.push_back(std::move(*document));
+                }
+            }
+            const double time = getSecondsSince(startTime) * 1e3;
+            if (restored.size() != documents.size()) {
+                std::println(stderr, "Session: restored {} of {} documents", restored.size(), documents.size());
+                return {};
+            }
+            if (run > 0) {
+                times.push_back(time);
+            }
+
+            if (run == Runs - 1) {
+                hashed = static_cast<size_t>(std::ranges::count_if(restored, &RestoredDocument::hashed));
+                for (size_t i = 0; i < documents.size(); ++i) {
+                    if (!matches(restored[i], documents[i])) {
+                        std::println(stderr, "Session: {} differs after restoring", documents[i].path);
+                        return {};
+                    }
+                }
+            }
+        }
+        std::ranges::sort(times);
+        return times;
+    }
+
+    /**
+     * @brief Run the bench in a directory of generated files.
+     * @param directory The directory.
+     * @param count The number of documents.
+     * @param paths Receives every file created, for removal.
+     * @return The exit status.
+     */
+    static int runInDirectory(const std::string& directory, size_t count, std::vector<std::string>& paths) {
+        const Language* language = detectLanguage("bench.cpp");
+        if (language == nullptr) {
+            std::println(stderr, "Session: no language for C++");
+            return 1;
+        }
+
+        size_t textBytes{0};
+        for (size_t i = 0; i < count; ++i) {
+            const std::string& path = paths.emplace_back(directory + "/file" + std::to_string(i) + ".cpp");
+            const std::string text = generateDocument(i);
+            textBytes += text.size();
+            if (!writeAgedFile(path, text)) {
+                return 1;
+            }
+        }
+        const std::string snapshotPath = paths.emplace_back(directory + "/session");
+
+        // Opening afresh maps and indexes every file and lexes it from the top
+        std::vector<double> freshTimes;
+        for (int run = 0; run < Runs; ++run) {
+            const auto startTime = std::chrono::steady_clock::now();
+            for (size_t i = 0; i < count; ++i) {
+                std::optional<LoadedFile> loaded = loadFile(paths[i]);
+                if (!loaded) {
+                    return 1;
+                }
+                static_cast<void>(lexBuffer(loaded->buffer, *language));
+            }
+            if (run > 0) {
+                freshTimes.push_back(getSecondsSince(startTime) * 1e3);
+            }
+        }
+        std::ranges::sort(freshTimes);
+
+        std::vector<BenchDocument> documents;
+        double hashTime{0.0};
+        for (size_t i = 0; i < count; ++i) {
+            std::optional<LoadedFile> loaded = loadFile(paths[i]);
+            if (!loaded) {
+                return 1;
+            }
+            BenchDocument& bench = documents.emplace_back();
+            bench.path = paths[i];
+            bench.stamp = loaded->stamp;
+            bench.stampedNanoseconds = loaded->stampedNanoseconds;
+            const auto hashStart = std::chrono::steady_clock::now();
+            bench.contentHash = hashText(*loaded->buffer.getStorage());
+            hashTime += getSecondsSince(hashStart) * 1e3;
+            bench.document = std::make_unique<Document>(std::move(loaded->buffer), paths[i]);
+            editDocument(*bench.document, i);
+            bench.highlights = lexBuffer(bench.document->getBuffer(), *language);
+        }
+
+        // A full write encodes every document; after one edit only that one is encoded again
+        std::vector<std::shared_ptr<const SessionSection>> sections;
+        auto startTime = std::chrono::steady_clock::now();
+        const double encodeTime = writeBenchSnapshot(snapshotPath, documents, sections);
+        const double fullTime = getSecondsSince(startTime) * 1e3;
+        if (encodeTime < 0.0) {
+            return 1;
+        }
+
+        BenchDocument& edited = documents[count / 2];
+        edited.document->insertAtCursor("x");
+        edited.highlights = lexBuffer(edited.document->getBuffer(), *language);
+        startTime = std::chrono::steady_clock::now();
+        sections[count / 2] = std::make_shared<const SessionSection>(encodeSessionDocument(captureBench(edited)));
+        if (!writeSessionSnapshot(snapshotPath, sections, 0)) {
+            return 1;
+        }
+        const double incrementalTime = getSecondsSince(startTime) * 1e3;
+
+        size_t hashed{0};
+        const std::vector<double> trusted = timeRestore(snapshotPath, documents, hashed);
+        if (trusted.empty()) {
+            return 1;
+        }
+        std::println("Session: {} documents, {} KiB of text; snapshot of {} KiB written in {:.2f} ms ({:.2f} ms encoding), "
+            "{:.2f} ms with one document changed; {:.2f} ms hashing the files once",
+            count, textBytes / 1024, getFileStamp(snapshotPath).value_or(FileStamp{}).size / 1024, fullTime,
+            encodeTime, incrementalTime, hashTime);
+        std::println("Session: restored with edits, undo, line index and highlighting: p50 {:.2f} ms, max {:.2f} ms, min {:.2f} ms ({} hashed)",
+            trusted[trusted.size() / 2], trusted.back(), trusted.front(), hashed);
+
+        // Files stamped within moments of being written are hashed, since a later write may not show in the stamp
+        for (BenchDocument& bench : documents) {
+            bench.stampedNanoseconds = bench.stamp.modifiedNanoseconds;
+        }
+        if (writeBenchSnapshot(snapshotPath, documents, sections) < 0.0) {
+            return 1;
+        }
+        const std::vector<double> racy = timeRestore(snapshotPath, documents, hashed);
+        if (racy.empty()) {
+            return 1;
+        }
+        std::println("Session: restored with every file hashed: p50 {:.2f} ms, max {:.2f} ms ({} hashed)", racy[racy.size() / 2],
+            racy.back(), hashed);
+        std::println("Session: opened and lexed afresh: p50 {:.2f} ms, max {:.2f} ms; restoring is {:.1f}x faster",
+            freshTimes[freshTimes.size() / 2], freshTimes.back(), freshTimes[freshTimes.size() / 2] / trusted[trusted.size() / 2]);
+
+        // Restored sections view the mapping they came from, which stays valid
+        // when a snapshot written from them is renamed over it
+        std::vector<std::shared_ptr<const SessionSection>> restoredSections;
+        if (const std::unique_ptr<SessionSnapshot> restoredSnapshot = SessionSnapshot::open(snapshotPath)) {
+            for (size_t i = 0; i < restoredSnapshot->getDocumentCount(); ++i) {
+                std::optional<RestoredDocument> document = restoredSnapshot->restoreDocument(i, 0);
+                if (document && document->section) {
+                    restoredSections.push_back(std::move(document->section));
+                }
+            }
+        }
+        startTime = std::chrono::steady_clock::now();
+        if (restoredSections.size() != documents.size() || !writeSessionSnapshot(snapshotPath, restoredSections, 0)) {
+            std::println(stderr, "Session: cannot write a snapshot from the restored sections");
+            return 1;
+        }
+        const double rewriteTime = getSecondsSince(startTime) * 1e3;
+        restoredSections.clear();
+        if (timeRestore(snapshotPath, documents, hashed).empty()) {
+            return 1;
+        }
+        std::println("Session: snapshot written again from the restored sections in {:.2f} ms, restoring the same documents", rewriteTime);
+
+        // A file changed on disk comes back as it is now, with only its cursors and scroll position
+        const std::string changedText = generateDocument(count) + "// changed on disk\n";
+        if (!writeAgedFile(paths[0], changedText)) {
+            return 1;
+        }
+        const std::unique_ptr<SessionSnapshot> snapshot = SessionSnapshot::open(snapshotPath);
+        const std::optional<RestoredDocument> changed = snapshot ? snapshot->restoreDocument(0, 0) : std::nullopt;
+        if (!changed || !changed->stale || changed->document->getBuffer().getText() != changedText ||
+            changed->document->getScrollLine() != documents[0].document->getScrollLine()) {
+            std::println(stderr, "Session: a file changed on disk was not restored afresh");
+            return 1;
+        }
+        std::println("Session: a file changed on disk was restored afresh, keeping its scroll position");
+        return 0;
+    }
+
+    /**
+     * @brief Time a session snapshot of edited documents for drite-bench session.
+     * @param options The parsed options, with the document count.
+     * @return The exit status: 0 on success, 1 if a step failed or a restored document differs.
+     */
+    int runSessionBench(const BenchOptions& options) {
+        const std::optional<std::string> directory = createTemporaryDirectory("drite-session");
+        if (!directory) {
+            std::println(stderr, "Session: failed to create a directory: {}", std::strerror(errno));
+            return 1;
+        }
+
+        std::vector<std::string> paths;
+        const int status = runInDirectory(*directory, options.count, paths);
+        for (const std::string& path : paths) {
+            ::unlink(path.c_str());
+        }
+        ::rmdir(directory->c_str());
+        return status;
+    }
+
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include "bench/bench_options.h"
+
+namespace drite {
+
+    /**
+     * @brief Time a session snapshot of edited documents for drite-bench session.
+     *
+     * Generates N code files, edits each one at several cursors and lexes it
+     * as the highlighter would, then times writing the snapshot in full and
+     * with one document changed, and restoring every document with its edits,
+     * undo history, line index and highlighting, checking each against the
+     * original. Restoring is timed with file stamps trusted and with every
+     * file hashed, and compared with opening and lexing the files afresh.
+     *
+     * @param options The parsed options, with the document count.
+     * @return The exit status: 0 on success, 1 if a step failed or a restored document differs.
+     */
+    [[nodiscard]] int runSessionBench(const BenchOptions& options);
+
+}
@@ -0,0 +1,202 @@
+#include "bench/startup_bench.h"
+#include "bench/bench_helpers.h"
+#include "io/temporary_file.h"
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <chrono>
+#include <cstring>
+#include <optional>
+#include <print>
+#include <spawn.h>
+#include <string>
+#include <string_view>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+extern char** environ;
+
+namespace drite {
+
+    /**
+     * @brief Launches timed; the first is a warm-up that is not counted.
+     */
+    static constexpr int Launches = 21;
+
+    /**
+     * @brief Lines of generated code opened when no file is given.
+     */
+    static constexpr int GeneratedLines = 5000;
+
+    /**
+     * @brief The report line carrying the time to the first frame.
+     */
+    static constexpr std::string_view FirstFramePrefix = "Startup: first frame presented ";
+
+    /**
+     * @brief The result of one launch.
+     */
+    struct Launch {
+        double firstFrame{0.0};
+        double wall{0.0};
+        std::vector<std::string> report;
+    };
+
+    /**
+     * @brief Launch a headless editor on a file and read its startup report.
+     * @param executable The editor executable.
+     * @param path The file to open.
+     * @return The launch, or std::nullopt if it failed or reported no frame.
+     */
+    static std::optional<Launch> launchEditor(const std::string& executable, const std::string& path) {
+        int pipe[2];
+        if (::pipe(pipe) != 0) {
+            std::println(stderr, "Startup: failed to create a pipe: {}", std::strerror(errno));
+            return std::nullopt;
+        }
+
+        posix_spawn_file_actions_t actions;
+        posix_spawn_file_actions_init(&actions);
+        posix_spawn_file_actions_adddup2(&actions, pipe[1], STDOUT_FILENO);
+        posix_spawn_file_actions_addclose(&actions, pipe[0]);
+        posix_spawn_file_actions_addclose(&actions, pipe[1]);
+
+        const char* argv[] = {executable.c_str(), "--headless", "--frames", "1", "--trace-startup", path.c_str(), nullptr};
+        const auto start = std::chrono::steady_clock::now();
+        pid_t pid{0};
+        const int result = ::posix_spawnp(&pid, executable.c_str(), &actions, nullptr, const_cast<char* const*>(argv), environ);
+        posix_spawn_file_actions_destroy(&actions);
+        ::close(pipe[1]);
+        if (result != 0) {
+            ::close(pipe[0]);
+            std::println(stderr, "Startup: failed to start {}: {}", executable, std::strerror(result));
+            return std::nullopt;
+        }
+
+        std::string output;
+        char buffer[4096];
+        for (;;) {
+            const ssize_t count = ::read(pipe[0], buffer, sizeof(buffer));
+            if (count < 0 && errno == EINTR) {
+                continue;
+            }
+            if (count <= 0) {
+                break;
+            }
+            output.append(buffer, static_cast<size_t>(count));
+        }
+        ::close(pipe[0]);
+
+        int status{0};
+        while (::waitpid(pid, &status, 0) < 0 && errno == EINTR) {}
+        Launch launch;
+        launch.wall = getSecondsSince(start);
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+            std::println(stderr, "Startup: the editor failed");
+            return std::nullopt;
+        }
+
+        // Only the report is kept; the first frame line holds "X ms after launch"
+        bool presented{false};
+        for (size_t lineStart = 0; lineStart < output.size();) {
+            const size_t lineEnd = std::min(output.find('\n', lineStart), output.size());
+            const std::string_view line(output.data() + lineStart, lineEnd - lineStart);
+            lineStart = lineEnd + 1;
+            if (!line.starts_with("Startup: ")) {
+                continue;
+            }
+            launch.report.emplace_back(line);
+            if (line.starts_with(FirstFramePrefix)) {
+                const std::string_view number = line.substr(FirstFramePrefix.size());
+                double milliseconds{0.0};
+                const auto parsed = std::from_chars(number.data(), number.data() + number.size(), milliseconds);
+                presented = parsed.ec == std::errc();
+                launch.firstFrame = milliseconds / 1e3;
+            }
+        }
+        if (!presented) {
+            std::println(stderr, "Startup: the editor reported no frame");
+            return std::nullopt;
+        }
+        return launch;
+    }
+
+    /**
+     * @brief Write generated code to a temporary file.
+     * @param path Receives the path.
+     * @return True if written.
+     */
+    static bool writeGeneratedFile(std::string& path) {
+        const int fd = createTemporaryFile("drite-startup", ".cpp", path);
+        if (fd < 0) {
+            std::println(stderr, "Startup: failed to create a file: {}", std::strerror(errno));
+            return false;
+        }
+
+        std::string text;
+        for (int line = 0; line < GeneratedLines; ++line) {
+            text += "    const auto value" + std::to_string(line) + " = compute(index, " + std::to_string(line * 7) + ") * scale; // step\n";
+        }
+        const bool written = ::write(fd, text.data(), text.size()) == static_cast<ssize_t>(text.size());
+        ::close(fd);
+        if (!written) {
+            std::println(stderr, "Startup: failed to write {}: {}", path, std::strerror(errno));
+            ::unlink(path.c_str());
+        }
+        return written;
+    }
+
+    /**
+     * @brief Time headless launches to their first frame for drite-bench startup.
+     * @param options The parsed options, with the budget in milliseconds.
+     * @return The exit status: 0 on success, 1 if a launch failed or the median exceeds the budget.
+     */
+    int runStartupBench(const BenchOptions& options) {
+        const bool generated = options.files.empty();
+        std::string path = generated ? std::string() : options.files.back();
+        if (generated && !writeGeneratedFile(path)) {
+            return 1;
+        }
+
+        // The first launch warms the page cache for the executable and file
+        std::vector<Launch> launches;
+        for (int run = 0; run < Launches; ++run) {
+            std::optional<Launch> launch = launchEditor(options.editorPath, path);
+            if (!launch) {
+                break;
+            }
+            if (run > 0) {
+                launches.push_back(std::move(*launch));
+            }
+        }
+        if (generated) {
+            ::unlink(path.c_str());
+        }
+        if (launches.size() != static_cast<size_t>(Launches - 1)) {
+            return 1;
+        }
+
+        std::ranges::sort(launches, {}, &Launch::firstFrame);
+        const Launch& median = launches[launches.size() / 2];
+        for (const std::string& line : median.report) {
+            std::println("{}", line);
+        }
+
+        std::vector<double> walls;
+        for (const Launch& launch : launches) {
+            walls.push_back(launch.wall);
+        }
+        std::println("Startup: {} launches on {}, first frame p50 {:.2f} ms, max {:.2f} ms, min {:.2f} ms; process wall time p50 {:.2f} ms",
+            launches.size(), generated ? "generated code" : path, median.firstFrame * 1e3, launches.back().firstFrame * 1e3,
+            launches.front().firstFrame * 1e3, getMedian(walls) * 1e3);
+
+        if (median.firstFrame * 1e3 > options.budget) {
+            std::println(stderr, "Startup: the median first frame took {:.2f} ms (budget {:.2f} ms)", median.firstFrame * 1e3,
+                options.budget);
+            return 1;
+        }
+        return 0;
+    }
+
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include "bench/bench_options.h"
+
+namespace drite {
+
+    /**
+     * @brief Time headless launches to their first frame for drite-bench startup.
+     *
+     * Launches the editor headless on the given file, or on generated code,
+     * rendering one frame with --trace-startup, and reads each run's time
+     * from launch to the first presented frame. Prints the percentiles, the
+     * phases of the median run and the wall time of each process.
+     *
+     * @param options The parsed options, with the budget in milliseconds.
+     * @return The exit status: 0 on success, 1 if a launch failed or the median exceeds the budget.
+     */
+    [[nodiscard]] int runStartupBench(const BenchOptions& options);
+
+}
@@ -0,0 +1,184 @@
+#include "bench/undo_bench.h"
+#include "bench/bench_helpers.h"
+#include "editor/document.h"
+#include <array>
+#include <chrono>
+#include <memory>
+#include <print>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace drite {
+
+    /**
+     * @brief Size of the document pasted into.
+     */
+    static constexpr size_t BaseDocumentSize = size_t{16} << 20;
+
+    /**
+     * @brief Sizes of the pastes.
+     */
+    static constexpr std::array<size_t, 4> PasteSizes = {size_t{64} << 10, size_t{1} << 20, size_t{16} << 20, size_t{256} << 20};
+
+    /**
+     * @brief Undo and redo cycles timed per paste.
+     */
+    static constexpr int PasteCycles = 5;
+
+    /**
+     * @brief The word typed to check it costs one piece.
+     */
+    static constexpr std::string_view TypedWord = "result";
+
+    /**
+     * @brief Small pastes made under the tight budget.
+     */
+    static constexpr size_t SpillPasteCount = 20000;
+
+    /**
+     * @brief The tight memory budget, far less than the history of the small pastes.
+     */
+    static constexpr size_t SpillBudget = size_t{64} << 10;
+
+    /**
+     * @brief Paste into the middle of the base text, then undo and redo the paste repeatedly.
+     * @param base The base text.
+     * @param size The paste size.
+     * @return True if every undo and redo restored the text.
+     */
+    static bool benchPaste(const std::string& base, size_t size) {
+        const std::string label = describeSize(size);
+        const std::string paste = generateText(size, "pasted");
+        const size_t middle = base.size() / 2;
+
+        Document document{TextBuffer(base)};
+        document.setCursor(middle);
+        auto start = std::chrono::steady_clock::now();
+        document.insertAtCursor(paste);
+        const double pasteSeconds = getSecondsSince(start);
+        const UndoHistoryStats stats = document.getHistory().getStats();
+
+        std::vector<double> undoSeconds;
+        std::vector<double> redoSeconds;
+        bool restored{true};
+        for (int cycle = 0; cycle < PasteCycles && restored; ++cycle) {
+            start = std::chrono::steady_clock::now();
+            restored = document.undo();
+            undoSeconds.push_back(getSecondsSince(start));
+            restored = restored && document.getBuffer().getText() == base && document.getCursor() == middle;
+
+            start = std::chrono::steady_clock::now();
+            restored = restored && document.redo();
+            redoSeconds.push_back(getSecondsSince(start));
+            restored = restored && document.getBuffer().getSize() == base.size() + size && document.getCursor() == middle + size &&
+                       document.getBuffer().getText(middle, size) == paste &&
+                       document.getBuffer().getText(0, middle) == std::string_view(base).substr(0, middle) &&
+                       document.getBuffer().getText(middle + size, base.size() - middle) == std::string_view(base).substr(middle);
+        }
+        if (!restored) {
+            std::println(stderr, "Undo: undoing or redoing the {} paste did not restore the text", label);
+            return false;
+        }
+
+        std::println("Undo: paste {:>7}  paste {:8.3f} ms  undo p50 {:8.3f} ms  redo p50 {:8.3f} ms  history {} bytes", label,
+            pasteSeconds * 1000.0, getMedian(undoSeconds) * 1000.0, getMedian(redoSeconds) * 1000.0, stats.memoryUsage);
+        return true;
+    }
+
+    /**
+     * @brief Type a word and check its undo group holds a single piece.
+     * @param base The base text.
+     * @return True if the word costs one delta and one piece, and undo removes it.
+     */
+    static bool checkTypedWord(const std::string& base) {
+        Document document{TextBuffer(base)};
+        document.setCursor(base.size() / 2);
+        for (const char character : TypedWord) {
+            KeyEvent event;
+            event.key = static_cast<KeyCode>(static_cast<int>(KeyCode::A) + (character - 'a'));
+            event.action = KeyAction::Press;
+            static_cast<void>(document.handleKey(event));
+        }
+
+        const std::vector<std::shared_ptr<const UndoGroup>> groups = document.getHistory().share().undo;
+        const bool single = groups.size() == 1 && groups.back()->deltas.size() == 1 && groups.back()->pieces.size() == 1;
+        std::println("Undo: typing '{}' recorded {} groups, {} deltas, {} pieces", TypedWord, groups.size(),
+            groups.empty() ? 0 : groups.back()->deltas.size(), groups.empty() ? 0 : groups.back()->pieces.size());
+        if (!single) {
+            std::println(stderr, "Undo: a typed word should cost one group of one delta and one piece");
+            return false;
+        }
+        if (!document.undo() || document.getBuffer().getText() != base) {
+            std::println(stderr, "Undo: undoing the typed word did not restore the text");
+            return false;
+        }
+        return true;
+    }
+
+    /**
+     * @brief Make many small pastes under a tight budget, then undo and redo all of them.
+     * @param base The base text.
+     * @return True if the history spilled to disk and undo and redo restored the text.
+     */
+    static bool checkSpill(const std::string& base) {
+        Document document{TextBuffer(base)};
+        document.getHistory().setMemoryBudget(SpillBudget);
+        for (size_t i = 0; i < SpillPasteCount; ++i) {
+            document.setCursor(i * 7919 % (document.getBuffer().getSize() + 1));
+            document.insertAtCursor("pasted " + std::to_string(i) + "\n");
+            document.getHistory().seal();
+        }
+        const std::string edited = document.getBuffer().getText();
+        const UndoHistoryStats stats = document.getHistory().getStats();
+
+        auto start = std::chrono::steady_clock::now();
+        size_t undone{0};
+        while (document.undo()) {
+            ++undone;
+        }
+        const double undoSeconds = getSecondsSince(start);
+        const bool restored = document.getBuffer().getText() == base;
+
+        start = std::chrono::steady_clock::now();
+        size_t redone{0};
+        while (document.redo()) {
+            ++redone;
+        }
+        const double redoSeconds = getSecondsSince(start);
+        const bool reapplied = document.getBuffer().getText() == edited;
+
+        std::println("Undo: {} pastes within {} KiB: {} groups in memory, {} spilled ({} KiB on disk), {} dropped", SpillPasteCount,
+            SpillBudget >> 10, stats.undoGroups, stats.spilledGroups, stats.spilledBytes >> 10, stats.droppedGroups);
+        std::println("Undo: undid {} in {:.2f} ms, redid {} in {:.2f} ms", undone, undoSeconds * 1000.0, redone, redoSeconds * 1000.0);
+        if (stats.spilledGroups == 0 || stats.droppedGroups > 0 || undone != SpillPasteCount || redone != SpillPasteCount) {
+            std::println(stderr, "Undo: every paste should stay undoable, most of them from disk");
+            return false;
+        }
+        if (!restored || !reapplied) {
+            std::println(stderr, "Undo: undoing or redoing the spilled history did not restore the text");
+            return false;
+        }
+        return true;
+    }
+
+    /**
+     * @brief Time undoing and redoing large pastes for drite-bench undo.
+     * @param options The parsed options.
+     * @return The exit status: 0 on success, 1 if undo or redo did not restore the text.
+     */
+    int runUndoBench(const BenchOptions& /* options */) {
+        const std::string base = generateText(BaseDocumentSize);
+        bool passed{true};
+        for (const size_t size : PasteSizes) {
+            passed = benchPaste(base, size) && passed;
+        }
+        passed = checkTypedWord(base) && passed;
+        passed = checkSpill(base) && passed;
+        if (passed) {
+            std::println("Undo: all undo and redo steps restored the text");
+        }
+        return passed ? 0 : 1;
+    }
+
+}
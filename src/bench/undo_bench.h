@@ -0,0 +1,22 @@
+#pragma once
+
+#include "bench/bench_options.h"
+
+namespace drite {
+
+    /**
+     * @brief Time undoing and redoing large pastes for drite-bench undo.
+     *
+     * Pastes 64 KiB to 256 MiB into the middle of a 16 MiB document and
+     * times the paste, its undo and its redo, printing the memory the history
+     * holds for it. A typed word is checked to cost one piece in its undo
+     * group. Finally thousands of small pastes are made under a tight memory
+     * budget, so most of the history is spilled to disk, and all of them are
+     * undone and redone. The text is verified after every step.
+     *
+     * @param options The parsed options.
+     * @return The exit status: 0 on success, 1 if undo or redo did not restore the text.
+     */
+    [[nodiscard]] int runUndoBench(const BenchOptions& options);
+
+}
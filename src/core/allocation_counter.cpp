@@ -0,0 +1,75 @@
+#include "core/allocation_counter.h"
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+namespace drite {
+
+    /**
+     * @brief Heap allocations made by the calling thread.
+     */
+    static thread_local uint64_t s_allocationCount{0};
+
+    /**
+     * @brief Get the number of heap allocations the calling thread has made.
+     * @return The allocations since the thread started.
+     */
+    uint64_t getThreadAllocationCount() noexcept {
+        return s_allocationCount;
+    }
+
+    /**
+     * @brief Allocate memory for operator new, counting the allocation.
+     * @param size The number of bytes.
+     * @param alignment The alignment, at most that of malloc() for the unaligned forms.
+     * @return The memory.
+     */
+    [[maybe_unused]] static void* allocate(size_t size, size_t alignment) {
+        ++s_allocationCount;
+        size = size == 0 ? 1 : size;
+        for (;;) {
+            void* memory = alignment <= alignof(std::max_align_t)
+                ? std::malloc(size)
+                : std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+            if (memory) {
+                return memory;
+            }
+            // As the standard operator new does, give the new handler a chance to free memory
+            const std::new_handler handler = std::get_new_handler();
+            if (!handler) {
+                throw std::bad_alloc();
+            }
+            handler();
+        }
+    }
+
+}
+
+// The array and nothrow forms of the standard library forward to these
+#ifndef DRITE_DISABLE_PROFILER
+
+void* operator new(size_t size) {
+    return drite::allocate(size, alignof(std::max_align_t));
+}
+
+void* operator new(size_t size, std::align_val_t alignment) {
+    return drite::allocate(size, static_cast<size_t>(alignment));
+}
+
+void operator delete(void* memory) noexcept {
+    std::free(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept {
+    std::free(memory);
+}
+
+void operator delete(void* memory, std::align_val_t) noexcept {
+    std::free(memory);
+}
+
+void operator delete(void* memory, size_t, std::align_val_t) noexcept {
+    std::free(memory);
+}
+
+#endif
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <cstdint>
+
+namespace drite {
+
+    /**
+     * @brief Get the number of heap allocations the calling thread has made.
+     *
+     * Counted by the replaced global operator new, one thread-local increment
+     * per allocation, so the difference between two calls is the number of
+     * allocations made in between. Always 0 when built with
+     * DRITE_DISABLE_PROFILER, which keeps the standard operator new.
+     *
+     * @return The allocations since the thread started.
+     */
+    [[nodiscard]] uint64_t getThreadAllocationCount() noexcept;
+
+}
@@ -0,0 +1,31 @@
+#include "core/cpu_features.h"
+
+namespace drite {
+
+    /**
+     * @brief Ask the running CPU which extensions it supports.
+     * @return The features.
+     */
+    static CpuFeatures detectCpuFeatures() noexcept {
+        CpuFeatures features;
+#if DRITE_CPU_X86
+        __builtin_cpu_init();
+        features.sse2 = true;
+        features.popcnt = __builtin_cpu_supports("popcnt");
+        features.avx2 = __builtin_cpu_supports("avx2");
+#elif DRITE_CPU_NEON
+        features.neon = true;
+#endif
+        return features;
+    }
+
+    /**
+     * @brief Get the extensions of the running CPU, detected on first use.
+     * @return The features, the same for the lifetime of the process.
+     */
+    const CpuFeatures& getCpuFeatures() noexcept {
+        static const CpuFeatures features = detectCpuFeatures();
+        return features;
+    }
+
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define DRITE_CPU_X86 1
+#elif defined(__aarch64__)
+#define DRITE_CPU_NEON 1
+#endif
+
+namespace drite {
+
+    /**
+     * @brief Instruction set extensions the vectorized kernels dispatch on.
+     *
+     * SSE2 is part of x86-64 and NEON of AArch64, so they are set whenever
+     * the process runs on those architectures; the rest are detected.
+     */
+    struct CpuFeatures {
+        bool sse2{false};
+        bool popcnt{false};
+        bool avx2{false};
+        bool neon{false};
+    };
+
+    /**
+     * @brief Get the extensions of the running CPU, detected on first use.
+     * @return The features, the same for the lifetime of the process.
+     */
+    [[nodiscard]] const CpuFeatures& getCpuFeatures() noexcept;
+
+    /**
+     * @brief Get a table of kernel entry points, selected for the running CPU on first use.
+     *
+     * Each table type is selected once per process, however many
+     * translation units ask for it.
+     *
+     * @tparam Kernels The table of entry points.
+     * @param select Picks the table for a set of CPU features.
+     * @return The selected table.
+     */
+    template <typename Kernels>
+    [[nodiscard]] const Kernels& getKernelTable(Kernels (*select)(const CpuFeatures&) noexcept) noexcept {
+        static const Kernels kernels = select(getCpuFeatures());
+        return kernels;
+    }
+
+}
@@ -0,0 +1,97 @@
+#include "core/frame_arena.h"
+#include <algorithm>
+#include <new>
+
+namespace drite {
+
+    /**
+     * @brief Construct a new Frame Arena object.
+     * @param blockSize The initial size of each of the two blocks in bytes.
+     */
+    FrameArena::FrameArena(size_t blockSize)
+        : m_buffers{Buffer(blockSize), Buffer(blockSize)} {
+        m_stats.blockSize = blockSize;
+    }
+
+    /**
+     * @brief End the current frame and start the next on the other block, releasing the allocations of the frame before.
+     */
+    void FrameArena::endFrame() {
+        Buffer& ended = m_buffers[m_current];
+        ++m_stats.frames;
+        m_stats.peakFrameBytes = std::max(m_stats.peakFrameBytes, ended.getUsed());
+
+        m_current ^= 1;
+        m_buffers[m_current].rewind();
+        m_stats.overflows = m_buffers[0].getOverflows() + m_buffers[1].getOverflows();
+        m_stats.blockSize = std::max(m_buffers[0].getSize(), m_buffers[1].getSize());
+    }
+
+    /**
+     * @brief Construct a new Buffer object.
+     * @param size The block size in bytes.
+     */
+    FrameArena::Buffer::Buffer(size_t size)
+        : m_block(std::make_unique_for_overwrite<std::byte[]>(size))
+        , m_size(size) {}
+
+    /**
+     * @brief Destroy the Buffer object and its heap allocations.
+     */
+    FrameArena::Buffer::~Buffer() {
+        releaseOverflow();
+    }
+
+    /**
+     * @brief Release every allocation, enlarging the block if the frame outgrew it.
+     */
+    void FrameArena::Buffer::rewind() {
+        // Growing ahead of the frame's need keeps a slowly growing frame from reallocating every time
+        if (m_overflowBytes > 0) {
+            const size_t size = std::max(m_size * 2, getUsed() + getUsed() / 2);
+            releaseOverflow();
+            m_block = std::make_unique_for_overwrite<std::byte[]>(size);
+            m_size = size;
+        }
+        m_used = 0;
+    }
+
+    /**
+     * @brief Allocate from the block, or the heap once it is full.
+     * @param bytes The size in bytes.
+     * @param alignment The alignment.
+     * @return The memory.
+     */
+    void* FrameArena::Buffer::do_allocate(size_t bytes, size_t alignment) {
+        // The address is aligned rather than the offset, for alignments stricter than the block's
+        const auto base = reinterpret_cast<uintptr_t>(m_block.get());
+        const uintptr_t start = (base + m_used + alignment - 1) & ~static_cast<uintptr_t>(alignment - 1);
+        const size_t end = static_cast<size_t>(start - base) + bytes;
+        if (end <= m_size) {
+            m_used = end;
+            return reinterpret_cast<void*>(start);
+        }
+
+        // The header goes in front of the memory, padded so the memory keeps its alignment
+        const size_t headerAlignment = std::max(alignment, alignof(Overflow));
+        const size_t header = (sizeof(Overflow) + headerAlignment - 1) / headerAlignment * headerAlignment;
+        auto* raw = static_cast<std::byte*>(::operator new(header + bytes, std::align_val_t{headerAlignment}));
+        m_overflow = ::new (raw) Overflow{m_overflow, headerAlignment};
+        m_overflowBytes += header + bytes;
+        ++m_overflows;
+        return raw + header;
+    }
+
+    /**
+     * @brief Free the heap allocations.
+     */
+    void FrameArena::Buffer::releaseOverflow() noexcept {
+        while (m_overflow) {
+            Overflow* previous = m_overflow->previous;
+            ::operator delete(static_cast<void*>(m_overflow), std::align_val_t{m_overflow->alignment});
+            m_overflow = previous;
+        }
+        m_overflowBytes = 0;
+    }
+
+}
@@ -0,0 +1,207 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+
+namespace drite {
+
+    /**
+     * @brief Frame arena counters since construction.
+     */
+    struct FrameArenaStats {
+        /**
+         * @brief Frames ended.
+         */
+        uint64_t frames{0};
+
+        /**
+         * @brief Most bytes one frame allocated.
+         */
+        size_t peakFrameBytes{0};
+
+        /**
+         * @brief Allocations that did not fit in a frame's block and went to the heap.
+         */
+        uint64_t overflows{0};
+
+        /**
+         * @brief The size of each of the two blocks.
+         */
+        size_t blockSize{0};
+    };
+
+    /**
+     * @brief Double-buffered bump allocator for data that lives for one frame.
+     *
+     * Each frame allocates from one of two blocks by advancing an offset, and
+     * deallocating is a no-op. Ending a frame switches to the other block and
+     * rewinds it in O(1), so the data of the frame that just ended stays valid
+     * through the next one, for a backend still reading it. Containers use the
+     * arena through std::pmr and must be rebuilt, not cleared, each frame.
+     *
+     * A frame that outgrows its block takes the rest from the heap; the block
+     * is then enlarged when it is rewound, so after the first few frames a
+     * frame makes no heap allocations at all.
+     */
+    class FrameArena {
+        public:
+            /**
+             * @brief Default size of each block.
+             */
+            static constexpr size_t DefaultBlockSize = 256 * 1024;
+
+            /**
+             * @brief Construct a new Frame Arena object.
+             * @param blockSize The initial size of each of the two blocks in bytes.
+             */
+            explicit FrameArena(size_t blockSize = DefaultBlockSize);
+
+            FrameArena(const FrameArena&) = delete;
+            FrameArena& operator=(const FrameArena&) = delete;
+
+            /**
+             * @brief Get the memory resource of the current frame.
+             * @return The resource; its allocations stay valid until the end of the next frame.
+             */
+            [[nodiscard]] std::pmr::memory_resource* getResource() noexcept { return &m_buffers[m_current]; }
+
+            /**
+             * @brief End the current frame and start the next on the other block, releasing the allocations of the frame before.
+             */
+            void endFrame();
+
+            /**
+             * @brief Get the arena counters.
+             * @return The counters.
+             */
+            [[nodiscard]] const FrameArenaStats& getStats() const noexcept { return m_stats; }
+
+        private:
+            /**
+             * @brief One block and the heap allocations of a frame that outgrew it.
+             */
+            class Buffer : public std::pmr::memory_resource {
+                public:
+                    /**
+                     * @brief Construct a new Buffer object.
+                     * @param size The block size in bytes.
+                     */
+                    explicit Buffer(size_t size);
+
+                    Buffer(const Buffer&) = delete;
+                    Buffer& operator=(const Buffer&) = delete;
+
+                    /**
+                     * @brief Destroy the Buffer object and its heap allocations.
+                     */
+                    ~Buffer() override;
+
+                    /**
+                     * @brief Release every allocation, enlarging the block if the frame outgrew it.
+                     */
+                    void rewind();
+
+                    /**
+                     * @brief Get the bytes allocated since the last rewind.
+                     * @return The byte count, including alignment padding.
+                     */
+                    [[nodiscard]] size_t getUsed() const noexcept { return m_used + m_overflowBytes; }
+
+                    /**
+                     * @brief Get the allocations that went to the heap since construction.
+                     * @return The overflow count.
+                     */
+                    [[nodiscard]] uint64_t getOverflows() const noexcept { return m_overflows; }
+
+                    /**
+                     * @brief Get the block size.
+                     * @return The size in bytes.
+                     */
+                    [[nodiscard]] size_t getSize() const noexcept { return m_size; }
+
+                private:
+                    /**
+                     * @brief Allocate from the block, or the heap once it is full.
+                     * @param bytes The size in bytes.
+                     * @param alignment The alignment.
+                     * @return The memory.
+                     */
+                    void* do_allocate(size_t bytes, size_t alignment) override;
+
+                    /**
+                     * @brief Do nothing; memory is released when the buffer is rewound.
+                     */
+                    void do_deallocate(void*, size_t, size_t) override {}
+
+                    /**
+                     * @brief Check whether memory from another resource can be released here.
+                     * @param other The other resource.
+                     * @return True only for the same buffer.
+                     */
+                    [[nodiscard]] bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+                    /**
+                     * @brief Free the heap allocations.
+                     */
+                    void releaseOverflow() noexcept;
+
+                private:
+                    /**
+                     * @brief Header of a heap allocation, linking it to the one before.
+                     */
+                    struct Overflow {
+                        Overflow* previous;
+                        size_t alignment;
+                    };
+
+                    /**
+                     * @brief The block.
+                     */
+                    std::unique_ptr<std::byte[]> m_block;
+
+                    /**
+                     * @brief The block size.
+                     */
+                    size_t m_size{0};
+
+                    /**
+                     * @brief Bytes of the block in use.
+                     */
+                    size_t m_used{0};
+
+                    /**
+                     * @brief The latest heap allocation of the frame, or nullptr.
+                     */
+                    Overflow* m_overflow{nullptr};
+
+                    /**
+                     * @brief Bytes taken from the heap since the last rewind.
+                     */
+                    size_t m_overflowBytes{0};
+
+                    /**
+                     * @brief Allocations that went to the heap.
+                     */
+                    uint64_t m_overflows{0};
+            };
+
+            /**
+             * @brief The two blocks frames alternate between.
+             */
+            std::array<Buffer, 2> m_buffers;
+
+            /**
+             * @brief The block of the current frame.
+             */
+            size_t m_current{0};
+
+            /**
+             * @brief Arena counters.
+             */
+            FrameArenaStats m_stats;
+    };
+
+}
@@ -0,0 +1,367 @@
+#include "core/job_system.h"
+#include "core/profiler.h"
+#include <algorithm>
+#include <string>
+
+namespace drite {
+
+    /**
+     * @brief The job system and worker the calling thread belongs to, if any.
+     */
+    struct WorkerIdentity {
+        const JobSystem* system{nullptr};
+        size_t index{0};
+    };
+
+    /**
+     * @brief Identity of the calling thread, set by worker threads on start.
+     */
+    static thread_local WorkerIdentity currentWorker;
+
+    /**
+     * @brief Construct a new Job System object and start its workers.
+     * @param threadCount The number of worker threads, 0 for one per hardware thread.
+     */
+    JobSystem::JobSystem(unsigned threadCount) {
+        if (threadCount == 0) {
+            threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+        }
+
+        // Every worker exists before any thread starts, since workers steal from each other
+        m_workers.reserve(threadCount);
+        for (unsigned i = 0; i < threadCount; ++i) {
+            m_workers.push_back(std::make_unique<Worker>());
+            m_workers.back()->index = i;
+        }
+        for (size_t i = 0; i < m_workers.size(); ++i) {
+            m_workers[i]->thread = std::thread([this, i] {
+                if (Profiler::isEnabled()) {
+                    Profiler::setThreadName("job " + std::to_string(i));
+                }
+                workerLoop(i);
+            });
+        }
+    }
+
+    /**
+     * @brief Destroy the Job System object, stopping its workers.
+     */
+    JobSystem::~JobSystem() {
+        shutdown();
+    }
+
+    /**
+     * @brief Queue a function to run on a worker once its dependencies finished.
+     * @param function The work.
+     * @param priority The lane to queue it in.
+     * @param dependencies Jobs that must finish first.
+     * @return The job, for waiting on it or chaining after it.
+     */
+    JobHandle JobSystem::submit(std::function<void()> function, JobPriority priority, std::span<const JobHandle> dependencies) {
+        auto job = std::make_shared<Job>();
+        job->m_function = std::move(function);
+        job->m_priority = priority;
+        m_submitted.fetch_add(1, std::memory_order_relaxed);
+
+        // The extra blocker held during submission keeps a dependency that
+        // finishes meanwhile from scheduling the job twice
+        for (const JobHandle& dependency : dependencies) {
+            if (!dependency) {
+                continue;
+            }
+            std::lock_guard lock(dependency->m_mutex);
+            if (!dependency->m_done.load(std::memory_order_relaxed)) {
+                job->m_blockers.fetch_add(1, std::memory_order_relaxed);
+                dependency->m_continuations.push_back(job);
+            }
+        }
+        if (job->m_blockers.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            schedule(job);
+        }
+        return job;
+    }
+
+    /**
+     * @brief Wait for a job, running queued jobs meanwhile.
+     * @param job The job.
+     */
+    void JobSystem::wait(const JobHandle& job) {
+        if (!job) {
+            return;
+        }
+
+        // Helping keeps a waiting worker from idling, and lets the main
+        // thread push Frame work through when every worker is busy
+        Worker* self = getCurrentWorker();
+        while (!job->isDone() && !m_stopping.load(std::memory_order_acquire)) {
+            if (Job* next = takeJob(self)) {
+                execute(next);
+                continue;
+            }
+
+            std::unique_lock lock(m_doneMutex);
+            m_waiters.fetch_add(1);
+            m_jobDone.wait(lock, [&] { return job->isDone() || m_stopping.load() || m_queued.load() > 0; });
+            m_waiters.fetch_sub(1);
+        }
+    }
+
+    /**
+     * @brief Run a function over a range split into chunks on all workers and wait for it.
+     * @param count The size of the range.
+     * @param grain The number of indices per job.
+     * @param body Called with the begin and end of each chunk.
+     * @param priority The lane to queue the chunks in.
+     */
+    void JobSystem::parallelFor(size_t count, size_t grain, const std::function<void(size_t, size_t)>& body, JobPriority priority) {
+        grain = std::max<size_t>(grain, 1);
+        std::vector<JobHandle> chunks;
+        chunks.reserve((count + grain - 1) / grain);
+        for (size_t begin = 0; begin < count; begin += grain) {
+            const size_t end = std::min(count, begin + grain);
+            chunks.push_back(submit([&body, begin, end] { body(begin, end); }, priority));
+        }
+        for (const JobHandle& chunk : chunks) {
+            wait(chunk);
+        }
+    }
+
+    /**
+     * @brief Queue a function for the main thread, e.g. to apply a job's result.
+     * @param function The function; run by the next drainMainThread().
+     */
+    void JobSystem::postToMainThread(std::function<void()> function) {
+        {
+            std::lock_guard lock(m_mainThreadMutex);
+            m_mainThreadQueue.push_back(std::move(function));
+        }
+        if (m_mainThreadCallback) {
+            m_mainThreadCallback();
+        }
+    }
+
+    /**
+     * @brief Run the functions posted to the main thread so far; main thread only.
+     * @return The number of functions run.
+     */
+    size_t JobSystem::drainMainThread() {
+        {
+            std::lock_guard lock(m_mainThreadMutex);
+            if (m_mainThreadQueue.empty()) {
+                return 0;
+            }
+            m_mainThreadBatch.swap(m_mainThreadQueue);
+        }
+
+        // Functions posted while these run wait for the next drain
+        DRITE_PROFILE_ZONE("mainThreadJobs");
+        for (std::function<void()>& function : m_mainThreadBatch) {
+            function();
+        }
+        const size_t count = m_mainThreadBatch.size();
+        m_mainThreadBatch.clear();
+        m_mainThreadCalls.fetch_add(count, std::memory_order_relaxed);
+        return count;
+    }
+
+    /**
+     * @brief Stop the workers; jobs still queued are dropped.
+     */
+    void JobSystem::shutdown() {
+        {
+            std::lock_guard lock(m_sleepMutex);
+            m_stopping = true;
+        }
+        m_jobQueued.notify_all();
+        {
+            std::lock_guard lock(m_doneMutex);
+        }
+        m_jobDone.notify_all();
+
+        for (const std::unique_ptr<Worker>& worker : m_workers) {
+            if (worker->thread.joinable()) {
+                worker->thread.join();
+            }
+        }
+
+        // Dropping the self references frees the queued jobs and, with them,
+        // the continuations only they referenced
+        for (const std::unique_ptr<Worker>& worker : m_workers) {
+            for (WorkStealingDeque<Job*>& deque : worker->deques) {
+                while (const std::optional<Job*> job = deque.steal()) {
+                    (*job)->m_self.reset();
+                }
+            }
+        }
+        std::lock_guard lock(m_injectedMutex);
+        for (size_t lane = 0; lane < JobPriorityCount; ++lane) {
+            for (Job* job : m_injected[lane]) {
+                job->m_self.reset();
+            }
+            m_injected[lane].clear();
+            m_injectedCounts[lane] = 0;
+        }
+        m_queued = 0;
+    }
+
+    /**
+     * @brief Get the job counters.
+     * @return A snapshot of the counters.
+     */
+    JobSystemStats JobSystem::getStats() const noexcept {
+        JobSystemStats stats;
+        stats.submitted = m_submitted.load(std::memory_order_relaxed);
+        stats.executed = m_executed.load(std::memory_order_relaxed);
+        stats.stolen = m_stolen.load(std::memory_order_relaxed);
+        stats.mainThreadCalls = m_mainThreadCalls.load(std::memory_order_relaxed);
+        return stats;
+    }
+
+    /**
+     * @brief Worker thread body: run jobs, sleeping while there are none, until stopped.
+     * @param index The worker index.
+     */
+    void JobSystem::workerLoop(size_t index) {
+        Worker* self = m_workers[index].get();
+        currentWorker = WorkerIdentity{this, index};
+
+        while (!m_stopping.load(std::memory_order_acquire)) {
+            if (Job* job = takeJob(self)) {
+                execute(job);
+                continue;
+            }
+
+            // The sleeper count is raised before the queue count is checked,
+            // and submitters raise the queue count before checking sleepers,
+            // so one of the two always sees the other
+            std::unique_lock lock(m_sleepMutex);
+            m_sleepers.fetch_add(1);
+            m_jobQueued.wait(lock, [&] { return m_stopping.load() || m_queued.load() > 0; });
+            m_sleepers.fetch_sub(1);
+        }
+    }
+
+    /**
+     * @brief Queue a job whose dependencies finished.
+     * @param job The job.
+     */
+    void JobSystem::schedule(JobHandle job) {
+        Job* raw = job.get();
+        const auto lane = static_cast<size_t>(raw->m_priority);
+        raw->m_self = std::move(job);
+
+        m_queued.fetch_add(1);
+        if (Worker* self = getCurrentWorker()) {
+            self->deques[lane].push(raw);
+        } else {
+            std::lock_guard lock(m_injectedMutex);
+            m_injected[lane].push_back(raw);
+            m_injectedCounts[lane].fetch_add(1, std::memory_order_release);
+        }
+
+        if (m_sleepers.load() > 0) {
+            {
+                std::lock_guard lock(m_sleepMutex);
+            }
+            m_jobQueued.notify_one();
+        }
+        if (m_waiters.load() > 0) {
+            {
+                std::lock_guard lock(m_doneMutex);
+            }
+            m_jobDone.notify_all();
+        }
+    }
+
+    /**
+     * @brief Take the next job to run, highest priority lane first.
+     * @param self The calling worker, or nullptr for another thread.
+     * @return The job, or nullptr if none is queued.
+     */
+    Job* JobSystem::takeJob(Worker* self) {
+        if (m_queued.load(std::memory_order_relaxed) <= 0) {
+            return nullptr;
+        }
+
+        const size_t workerCount = m_workers.size();
+        const size_t start = self ? self->index : 0;
+
+        for (size_t lane = 0; lane < JobPriorityCount; ++lane) {
+            // Own work first: the newest job touches the data this worker just touched
+            if (self) {
+                if (const std::optional<Job*> job = self->deques[lane].pop()) {
+                    m_queued.fetch_sub(1);
+                    return *job;
+                }
+            }
+
+            if (m_injectedCounts[lane].load(std::memory_order_acquire) > 0) {
+                std::lock_guard lock(m_injectedMutex);
+                if (!m_injected[lane].empty()) {
+                    Job* job = m_injected[lane].front();
+                    m_injected[lane].pop_front();
+                    m_injectedCounts[lane].fetch_sub(1, std::memory_order_relaxed);
+                    m_queued.fetch_sub(1);
+                    return job;
+                }
+            }
+
+            // Victims are visited round-robin from the next worker, so thieves spread out
+            for (size_t offset = 1; offset <= workerCount; ++offset) {
+                Worker* victim = m_workers[(start + offset) % workerCount].get();
+                if (victim == self) {
+                    continue;
+                }
+                if (const std::optional<Job*> job = victim->deques[lane].steal()) {
+                    m_queued.fetch_sub(1);
+                    m_stolen.fetch_add(1, std::memory_order_relaxed);
+                    return *job;
+                }
+            }
+        }
+        return nullptr;
+    }
+
+    /**
+     * @brief Run a job and release the jobs waiting for it.
+     * @param job The job.
+     */
+    void JobSystem::execute(Job* job) {
+        // Holding the self reference keeps the job alive until it finished
+        const JobHandle keepAlive = std::move(job->m_self);
+        {
+            DRITE_PROFILE_ZONE("job");
+            job->m_function();
+            job->m_function = nullptr;
+        }
+        m_executed.fetch_add(1, std::memory_order_relaxed);
+
+        std::vector<JobHandle> continuations;
+        {
+            std::lock_guard lock(job->m_mutex);
+            job->m_done.store(true, std::memory_order_release);
+            continuations.swap(job->m_continuations);
+        }
+        for (JobHandle& continuation : continuations) {
+            if (continuation->m_blockers.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                schedule(std::move(continuation));
+            }
+        }
+
+        if (m_waiters.load() > 0) {
+            {
+                std::lock_guard lock(m_doneMutex);
+            }
+            m_jobDone.notify_all();
+        }
+    }
+
+    /**
+     * @brief Get the calling thread's worker if it belongs to this system.
+     * @return The worker, or nullptr.
+     */
+    JobSystem::Worker* JobSystem::getCurrentWorker() const noexcept {
+        return currentWorker.system == this ? m_workers[currentWorker.index].get() : nullptr;
+    }
+
+}
@@ -0,0 +1,343 @@
+#pragma once
+
+#include "core/work_stealing_deque.h"
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <thread>
+#include <vector>
+
+namespace drite {
+
+    /**
+     * @brief Lane a job is queued in; workers drain the Frame lane first.
+     */
+    enum class JobPriority : uint8_t {
+        Frame,
+        Background
+    };
+
+    /**
+     * @brief Number of priority lanes.
+     */
+    inline constexpr size_t JobPriorityCount = 2;
+
+    /**
+     * @brief A unit of work submitted to a JobSystem.
+     */
+    class Job {
+        public:
+            /**
+             * @brief Check whether the job ran.
+             * @return True once the function returned; its effects are visible to the caller then.
+             */
+            [[nodiscard]] bool isDone() const noexcept { return m_done.load(std::memory_order_acquire); }
+
+        private:
+            friend class JobSystem;
+
+            /**
+             * @brief The work; released once it ran.
+             */
+            std::function<void()> m_function;
+
+            /**
+             * @brief The lane the job is queued in.
+             */
+            JobPriority m_priority{JobPriority::Background};
+
+            /**
+             * @brief Unfinished dependencies, plus one while the job is being submitted.
+             */
+            std::atomic<uint32_t> m_blockers{1};
+
+            /**
+             * @brief Set once the function returned.
+             */
+            std::atomic<bool> m_done{false};
+
+            /**
+             * @brief Guards m_continuations against the job finishing.
+             */
+            std::mutex m_mutex;
+
+            /**
+             * @brief Jobs waiting for this one; guarded by m_mutex.
+             */
+            std::vector<std::shared_ptr<Job>> m_continuations;
+
+            /**
+             * @brief Keeps the job alive while it is queued.
+             */
+            std::shared_ptr<Job> m_self;
+    };
+
+    /**
+     * @brief Shared ownership of a submitted job, for waiting on it or chaining after it.
+     */
+    using JobHandle = std::shared_ptr<Job>;
+
+    /**
+     * @brief Counters of a job system.
+     */
+    struct JobSystemStats {
+        uint64_t submitted{0};
+        uint64_t executed{0};
+        uint64_t stolen{0};
+        uint64_t mainThreadCalls{0};
+    };
+
+    /**
+     * @brief Worker threads running jobs, with work stealing, dependencies and priority lanes.
+     *
+     * Each worker owns a Chase-Lev deque per lane. Jobs submitted from a
+     * worker, including continuations released by a finishing job, go to
+     * its own deque and run newest first while the data is hot; idle
+     * workers steal the oldest jobs of the others. Jobs submitted from
+     * other threads go to a shared queue per lane. A worker takes Frame jobs,
+     * which the next frame waits for, before any Background job.
+     *
+     * A job runs once all jobs it depends on finished. Results that touch
+     * editor state are handed back with postToMainThread() and applied by
+     * drainMainThread() in the frame loop, so the main thread never locks
+     * against workers.
+     */
+    class JobSystem {
+        public:
+            /**
+             * @brief Construct a new Job System object and start its workers.
+             * @param threadCount The number of worker threads, 0 for one per hardware thread.
+             */
+            explicit JobSystem(unsigned threadCount = 0);
+
+            /**
+             * @brief Destroy the Job System object, stopping its workers.
+             */
+            ~JobSystem();
+
+            JobSystem(const JobSystem&) = delete;
+            JobSystem& operator=(const JobSystem&) = delete;
+
+            /**
+             * @brief Queue a function to run on a worker once its dependencies finished.
+             * @param function The work.
+             * @param priority The lane to queue it in.
+             * @param dependencies Jobs that must finish first.
+             * @return The job, for waiting on it or chaining after it.
+             */
+            JobHandle submit(std::function<void()> function, JobPriority priority = JobPriority::Background,
+                             std::span<const JobHandle> dependencies = {});
+
+            /**
+             * @brief Queue a function to run on a worker once a job finished.
+             * @param job The job to follow.
+             * @param function The work.
+             * @param priority The lane to queue it in.
+             * @return The continuation.
+             */
+            JobHandle then(const JobHandle& job, std::function<void()> function, JobPriority priority = JobPriority::Background) {
+                return submit(std::move(function), priority, std::span<const JobHandle>(&job, 1));
+            }
+
+            /**
+             * @brief Wait for a job, running queued jobs meanwhile.
+             * @param job The job.
+             */
+            void wait(const JobHandle& job);
+
+            /**
+             * @brief Run a function over a range split into chunks on all workers and wait for it.
+             * @param count The size of the range.
+             * @param grain The number of indices per job.
+             * @param body Called with the begin and end of each chunk.
+             * @param priority The lane to queue the chunks in.
+             */
+            void parallelFor(size_t count, size_t grain, const std::function<void(size_t, size_t)>& body,
+                             JobPriority priority = JobPriority::Frame);
+
+            /**
+             * @brief Queue a function for the main thread, e.g. to apply a job's result.
+             * @param function The function; run by the next drainMainThread().
+             */
+            void postToMainThread(std::function<void()> function);
+
+            /**
+             * @brief Set the function called when work is posted to the main thread.
+             * @param callback The callback, e.g. one that wakes the main loop; called from any thread.
+             */
+            void setMainThreadCallback(std::function<void()> callback) { m_mainThreadCallback = std::move(callback); }
+
+            /**
+             * @brief Run the functions posted to the main thread so far; main thread only.
+             * @return The number of functions run.
+             */
+            size_t drainMainThread();
+
+            /**
+             * @brief Stop the workers; jobs still queued are dropped.
+             */
+            void shutdown();
+
+            /**
+             * @brief Get the number of worker threads.
+             * @return The thread count.
+             */
+            [[nodiscard]] unsigned getThreadCount() const noexcept { return static_cast<unsigned>(m_workers.size()); }
+
+            /**
+             * @brief Get the job counters.
+             * @return A snapshot of the counters.
+             */
+            [[nodiscard]] JobSystemStats getStats() const noexcept;
+
+        private:
+            /**
+             * @brief A worker thread and its deques.
+             */
+            struct Worker {
+                std::array<WorkStealingDeque<Job*>, JobPriorityCount> deques;
+                std::thread thread;
+                size_t index{0};
+            };
+
+            /**
+             * @brief Worker thread body: run jobs, sleeping while there are none, until stopped.
+             * @param index The worker index.
+             */
+            void workerLoop(size_t index);
+
+            /**
+             * @brief Queue a job whose dependencies finished.
+             * @param job The job.
+             */
+            void schedule(JobHandle job);
+
+            /**
+             * @brief Take the next job to run, highest priority lane first.
+             * @param self The calling worker, or nullptr for another thread.
+             * @return The job, or nullptr if none is queued.
+             */
+            Job* takeJob(Worker* self);
+
+            /**
+             * @brief Run a job and release the jobs waiting for it.
+             * @param job The job.
+             */
+            void execute(Job* job);
+
+            /**
+             * @brief Get the calling thread's worker if it belongs to this system.
+             * @return The worker, or nullptr.
+             */
+            [[nodiscard]] Worker* getCurrentWorker() const noexcept;
+
+        private:
+            /**
+             * @brief The workers.
+             */
+            std::vector<std::unique_ptr<Worker>> m_workers;
+
+            /**
+             * @brief Guards the shared queues.
+             */
+            std::mutex m_injectedMutex;
+
+            /**
+             * @brief Jobs submitted from threads other than the workers, per lane.
+             */
+            std::array<std::deque<Job*>, JobPriorityCount> m_injected;
+
+            /**
+             * @brief Number of jobs in m_injected per lane, for checking without the lock.
+             */
+            std::array<std::atomic<size_t>, JobPriorityCount> m_injectedCounts{};
+
+            /**
+             * @brief Number of jobs queued and not yet taken.
+             */
+            std::atomic<int64_t> m_queued{0};
+
+            /**
+             * @brief Guards sleeping workers against missed wakeups.
+             */
+            std::mutex m_sleepMutex;
+
+            /**
+             * @brief Signalled when jobs are queued or the workers must stop.
+             */
+            std::condition_variable m_jobQueued;
+
+            /**
+             * @brief Number of workers asleep or about to sleep.
+             */
+            std::atomic<unsigned> m_sleepers{0};
+
+            /**
+             * @brief Guards threads waiting for a job against missed wakeups.
+             */
+            std::mutex m_doneMutex;
+
+            /**
+             * @brief Signalled when a job finishes while a thread waits.
+             */
+            std::condition_variable m_jobDone;
+
+            /**
+             * @brief Number of threads blocked in wait().
+             */
+            std::atomic<unsigned> m_waiters{0};
+
+            /**
+             * @brief Whether the workers must stop.
+             */
+            std::atomic<bool> m_stopping{false};
+
+            /**
+             * @brief Guards m_mainThreadQueue.
+             */
+            std::mutex m_mainThreadMutex;
+
+            /**
+             * @brief Functions posted to the main thread and not yet run.
+             */
+            std::vector<std::function<void()>> m_mainThreadQueue;
+
+            /**
+             * @brief Scratch storage for the functions being run by drainMainThread().
+             */
+            std::vector<std::function<void()>> m_mainThreadBatch;
+
+            /**
+             * @brief Called when work is posted to the main thread.
+             */
+            std::function<void()> m_mainThreadCallback;
+
+            /**
+             * @brief Number of jobs submitted.
+             */
+            std::atomic<uint64_t> m_submitted{0};
+
+            /**
+             * @brief Number of jobs run.
+             */
+            std::atomic<uint64_t> m_executed{0};
+
+            /**
+             * @brief Number of jobs taken from another worker's deque.
+             */
+            std::atomic<uint64_t> m_stolen{0};
+
+            /**
+             * @brief Number of functions run by drainMainThread().
+             */
+            std::atomic<uint64_t> m_mainThreadCalls{0};
+    };
+
+}
@@ -0,0 +1,353 @@
+#include "core/profiler.h"
+#include <algorithm>
+#include <bit>
+#include <cstdio>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <print>
+#include <string_view>
+#include <vector>
+
+namespace drite {
+
+    /**
+     * @brief Zones stored per buffer chunk.
+     */
+    static constexpr size_t ZonesPerChunk = 4096;
+
+    /**
+     * @brief A closed zone.
+     */
+    struct ZoneRecord {
+        const char* name;
+        int64_t start;
+        int64_t end;
+    };
+
+    /**
+     * @brief A fixed block of zones in a thread buffer.
+     *
+     * Only the owning thread appends; readers see the zones below the published
+     * count and follow the published next pointer.
+     */
+    struct ZoneChunk {
+        std::array<ZoneRecord, ZonesPerChunk> zones;
+        std::atomic<size_t> count{0};
+        std::atomic<ZoneChunk*> next{nullptr};
+    };
+
+    /**
+     * @brief The zones recorded by one thread.
+     */
+    struct ThreadBuffer {
+        /**
+         * @brief Destroy the Thread Buffer object and its chunks.
+         */
+        ~ThreadBuffer() {
+            ZoneChunk* chunk = head.next.load(std::memory_order_relaxed);
+            while (chunk) {
+                ZoneChunk* next = chunk->next.load(std::memory_order_relaxed);
+                delete chunk;
+                chunk = next;
+            }
+        }
+
+        ZoneChunk head;
+        ZoneChunk* tail{&head};
+        size_t recorded{0};
+        uint64_t dropped{0};
+        uint32_t id{0};
+        std::string name;
+    };
+
+    /**
+     * @brief The buffers of every thread that recorded a zone.
+     *
+     * Buffers outlive their threads so zones from finished threads still export.
+     */
+    struct ThreadRegistry {
+        std::mutex mutex;
+        std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+    };
+
+    std::atomic<bool> Profiler::s_enabled{false};
+
+    /**
+     * @brief Get the process-wide thread registry.
+     * @return The registry.
+     */
+    static ThreadRegistry& getRegistry() {
+        static ThreadRegistry registry;
+        return registry;
+    }
+
+    /**
+     * @brief Get the buffer of the calling thread, registering it on first use.
+     * @return The thread buffer.
+     */
+    static ThreadBuffer& getThreadBuffer() {
+        thread_local ThreadBuffer* buffer = [] {
+            ThreadRegistry& registry = getRegistry();
+            std::lock_guard lock(registry.mutex);
+            auto& created = registry.buffers.emplace_back(std::make_unique<ThreadBuffer>());
+            created->id = static_cast<uint32_t>(registry.buffers.size());
+            created->name = "thread " + std::to_string(created->id);
+            return created.get();
+        }();
+        return *buffer;
+    }
+
+    /**
+     * @brief Visit every zone published so far.
+     * @param visit The function receiving each thread buffer and zone.
+     */
+    template<typename Visitor>
+    static void forEachZone(Visitor&& visit) {
+        ThreadRegistry& registry = getRegistry();
+        std::lock_guard lock(registry.mutex);
+        for (const auto& buffer : registry.buffers) {
+            for (const ZoneChunk* chunk = &buffer->head; chunk; chunk = chunk->next.load(std::memory_order_acquire)) {
+                const size_t count = chunk->count.load(std::memory_order_acquire);
+                for (size_t i = 0; i < count; ++i) {
+                    visit(*buffer, chunk->zones[i]);
+                }
+            }
+        }
+    }
+
+    /**
+     * @brief Add a sample.
+     * @param nanoseconds The sample in nanoseconds.
+     */
+    void LatencyHistogram::record(uint64_t nanoseconds) noexcept {
+        ++m_buckets[getBucket(nanoseconds)];
+        ++m_count;
+        m_max = std::max(m_max, nanoseconds);
+        m_total += nanoseconds;
+    }
+
+    /**
+     * @brief Get the sample at a percentile.
+     * @param percentile The percentile in [0, 100].
+     * @return The upper bound of the bucket holding the percentile in nanoseconds, or 0 if empty.
+     */
+    uint64_t LatencyHistogram::getPercentile(double percentile) const noexcept {
+        if (m_count == 0) {
+            return 0;
+        }
+
+        const double rank = std::clamp(percentile, 0.0, 100.0) / 100.0 * static_cast<double>(m_count);
+        const uint64_t target = std::max<uint64_t>(static_cast<uint64_t>(rank + 0.999999), 1);
+        uint64_t seen{0};
+        for (size_t bucket = 0; bucket < m_buckets.size(); ++bucket) {
+            seen += m_buckets[bucket];
+            if (seen >= target) {
+                return std::min(getBucketLimit(bucket), m_max);
+            }
+        }
+        return m_max;
+    }
+
+    /**
+     * @brief Get the bucket a sample falls into.
+     * @param nanoseconds The sample.
+     * @return The bucket index.
+     */
+    size_t LatencyHistogram::getBucket(uint64_t nanoseconds) noexcept {
+        if (nanoseconds < SubBuckets) {
+            return static_cast<size_t>(nanoseconds);
+        }
+
+        // The top bit picks the octave, the next four bits the linear sub-bucket
+        const unsigned topBit = static_cast<unsigned>(std::bit_width(nanoseconds)) - 1;
+        const size_t subBucket = static_cast<size_t>(nanoseconds >> (topBit - 4)) & (SubBuckets - 1);
+        const size_t bucket = static_cast<size_t>(topBit - 3) * SubBuckets + subBucket;
+        return std::min<size_t>(bucket, SubBuckets * Octaves - 1);
+    }
+
+    /**
+     * @brief Get the largest sample a bucket holds.
+     * @param bucket The bucket index.
+     * @return The bucket upper bound in nanoseconds.
+     */
+    uint64_t LatencyHistogram::getBucketLimit(size_t bucket) noexcept {
+        if (bucket < SubBuckets) {
+            return bucket;
+        }
+
+        const unsigned shift = static_cast<unsigned>(bucket / SubBuckets) - 1;
+        const uint64_t lower = (SubBuckets + bucket % SubBuckets) << shift;
+        return lower + (uint64_t{1} << shift) - 1;
+    }
+
+    /**
+     * @brief Start or stop recording zones.
+     * @param enabled True to record.
+     */
+    void Profiler::setEnabled(bool enabled) noexcept {
+        // Start the clock so zone times count from when profiling began
+        static_cast<void>(now());
+        s_enabled.store(enabled, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Get the profiler clock.
+     * @return Nanoseconds since the profiler was first used.
+     */
+    int64_t Profiler::now() noexcept {
+        static const auto epoch = std::chrono::steady_clock::now();
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count();
+    }
+
+    /**
+     * @brief Record a closed zone on the calling thread.
+     * @param name The zone name; must outlive the profiler, e.g. a string literal.
+     * @param start The zone start from now().
+     * @param end The zone end from now().
+     */
+    void Profiler::record(const char* name, int64_t start, int64_t end) noexcept {
+        ThreadBuffer& buffer = getThreadBuffer();
+        if (buffer.recorded >= MaxZonesPerThread) {
+            ++buffer.dropped;
+            return;
+        }
+
+        ZoneChunk* chunk = buffer.tail;
+        size_t count = chunk->count.load(std::memory_order_relaxed);
+        if (count == ZonesPerChunk) {
+            ZoneChunk* next = new (std::nothrow) ZoneChunk;
+            if (!next) {
+                ++buffer.dropped;
+                return;
+            }
+            chunk->next.store(next, std::memory_order_release);
+            buffer.tail = chunk = next;
+            count = 0;
+        }
+
+        chunk->zones[count] = ZoneRecord{name, start, end};
+        chunk->count.store(count + 1, std::memory_order_release);
+        ++buffer.recorded;
+    }
+
+    /**
+     * @brief Name the calling thread in the trace.
+     * @param name The thread name.
+     */
+    void Profiler::setThreadName(std::string name) {
+        ThreadBuffer& buffer = getThreadBuffer();
+        std::lock_guard lock(getRegistry().mutex);
+        buffer.name = std::move(name);
+    }
+
+    /**
+     * @brief Print count, p50, p99 and max per zone name to standard output.
+     */
+    void Profiler::printSummary() {
+        std::map<std::string_view, LatencyHistogram> zones;
+        forEachZone([&](const ThreadBuffer&, const ZoneRecord& zone) {
+            zones[zone.name].record(static_cast<uint64_t>(std::max<int64_t>(zone.end - zone.start, 0)));
+        });
+        if (zones.empty()) {
+            return;
+        }
+
+        // Most expensive zones first
+        std::vector<std::pair<std::string_view, const LatencyHistogram*>> sorted;
+        for (const auto& [name, histogram] : zones) {
+            sorted.emplace_back(name, &histogram);
+        }
+        std::ranges::sort(sorted, [](const auto& a, const auto& b) { return a.second->getTotal() > b.second->getTotal(); });
+
+        const auto toMs = [](uint64_t nanoseconds) { return static_cast<double>(nanoseconds) / 1e6; };
+        std::println("Profile: {:<20} {:>8} {:>10} {:>10} {:>10} {:>10}", "zone", "count", "total ms", "p50 ms", "p99 ms", "max ms");
+        for (const auto& [name, histogram] : sorted) {
+            std::println("Profile: {:<20} {:>8} {:>10.2f} {:>10.3f} {:>10.3f} {:>10.3f}",
+                name, histogram->getCount(), toMs(histogram->getTotal()),
+                toMs(histogram->getPercentile(50.0)), toMs(histogram->getPercentile(99.0)), toMs(histogram->getMax()));
+        }
+
+        uint64_t dropped{0};
+        {
+            ThreadRegistry& registry = getRegistry();
+            std::lock_guard lock(registry.mutex);
+            for (const auto& buffer : registry.buffers) {
+                dropped += buffer->dropped;
+            }
+        }
+        if (dropped > 0) {
+            std::println("Profile: {} zones dropped after {} per thread", dropped, MaxZonesPerThread);
+        }
+    }
+
+    /**
+     * @brief Write a string as a JSON string literal.
+     * @param file The output file.
+     * @param text The string.
+     */
+    static void writeJsonString(std::FILE* file, std::string_view text) {
+        std::fputc('"', file);
+        for (const char character : text) {
+            if (character == '"' || character == '\\') {
+                std::fputc('\\', file);
+                std::fputc(character, file);
+            } else if (static_cast<unsigned char>(character) < 0x20) {
+                std::print(file, "\\u{:04x}", static_cast<unsigned>(character));
+            } else {
+                std::fputc(character, file);
+            }
+        }
+        std::fputc('"', file);
+    }
+
+    /**
+     * @brief Write the recorded zones as Chrome trace_event JSON.
+     * @param path The output file path.
+     * @return True if the file was written.
+     */
+    bool Profiler::writeChromeTrace(const std::string& path) {
+        std::FILE* file = std::fopen(path.c_str(), "w");
+        if (!file) {
+            std::println(stderr, "Failed to open trace file: {}", path);
+            return false;
+        }
+
+        // Complete ("X") events with microsecond times, plus one metadata event
+        // per thread so viewers show thread names
+        std::print(file, "{{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+        bool first{true};
+        const auto separate = [&] {
+            std::fputs(first ? "\n" : ",\n", file);
+            first = false;
+        };
+
+        {
+            ThreadRegistry& registry = getRegistry();
+            std::lock_guard lock(registry.mutex);
+            for (const auto& buffer : registry.buffers) {
+                separate();
+                std::print(file, "{{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":{},\"args\":{{\"name\":", buffer->id);
+                writeJsonString(file, buffer->name);
+                std::print(file, "}}}}");
+            }
+        }
+
+        forEachZone([&](const ThreadBuffer& buffer, const ZoneRecord& zone) {
+            separate();
+            std::print(file, "{{\"name\":");
+            writeJsonString(file, zone.name);
+            std::print(file, ",\"ph\":\"X\",\"pid\":1,\"tid\":{},\"ts\":{:.3f},\"dur\":{:.3f}}}",
+                buffer.id, static_cast<double>(zone.start) / 1e3, static_cast<double>(zone.end - zone.start) / 1e3);
+        });
+
+        std::print(file, "\n]}}\n");
+        const bool written = std::ferror(file) == 0;
+        if (std::fclose(file) != 0 || !written) {
+            std::println(stderr, "Failed to write trace file: {}", path);
+            return false;
+        }
+        return true;
+    }
+
+}
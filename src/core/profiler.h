@@ -0,0 +1,219 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace drite {
+
+    /**
+     * @brief Latency histogram with logarithmic buckets.
+     *
+     * Each power of two is split into SubBuckets linear buckets, so percentiles
+     * are accurate to about 6% at any scale while the histogram stays a fixed
+     * array of counters.
+     */
+    class LatencyHistogram {
+        public:
+            /**
+             * @brief Linear buckets per power of two.
+             */
+            static constexpr unsigned SubBuckets = 16;
+
+            /**
+             * @brief Powers of two covered; larger samples land in the last bucket.
+             */
+            static constexpr unsigned Octaves = 48;
+
+            /**
+             * @brief Add a sample.
+             * @param nanoseconds The sample in nanoseconds.
+             */
+            void record(uint64_t nanoseconds) noexcept;
+
+            /**
+             * @brief Get the sample at a percentile.
+             * @param percentile The percentile in [0, 100].
+             * @return The upper bound of the bucket holding the percentile in nanoseconds, or 0 if empty.
+             */
+            [[nodiscard]] uint64_t getPercentile(double percentile) const noexcept;
+
+            /**
+             * @brief Get the number of samples.
+             * @return The sample count.
+             */
+            [[nodiscard]] uint64_t getCount() const noexcept { return m_count; }
+
+            /**
+             * @brief Get the largest sample.
+             * @return The largest sample in nanoseconds.
+             */
+            [[nodiscard]] uint64_t getMax() const noexcept { return m_max; }
+
+            /**
+             * @brief Get the sum of all samples.
+             * @return The total in nanoseconds.
+             */
+            [[nodiscard]] uint64_t getTotal() const noexcept { return m_total; }
+
+        private:
+            /**
+             * @brief Get the bucket a sample falls into.
+             * @param nanoseconds The sample.
+             * @return The bucket index.
+             */
+            [[nodiscard]] static size_t getBucket(uint64_t nanoseconds) noexcept;
+
+            /**
+             * @brief Get the largest sample a bucket holds.
+             * @param bucket The bucket index.
+             * @return The bucket upper bound in nanoseconds.
+             */
+            [[nodiscard]] static uint64_t getBucketLimit(size_t bucket) noexcept;
+
+        private:
+            /**
+             * @brief Sample counts per bucket.
+             */
+            std::array<uint64_t, SubBuckets * Octaves> m_buckets{};
+
+            /**
+             * @brief The number of samples.
+             */
+            uint64_t m_count{0};
+
+            /**
+             * @brief The largest sample.
+             */
+            uint64_t m_max{0};
+
+            /**
+             * @brief The sum of all samples.
+             */
+            uint64_t m_total{0};
+    };
+
+    /**
+     * @brief Process-wide recorder of timed zones.
+     *
+     * Every thread appends the zones it closes to its own buffer, which only
+     * that thread writes, so recording takes no locks. While the profiler is
+     * disabled a zone costs one relaxed atomic load.
+     */
+    class Profiler {
+        public:
+            /**
+             * @brief Zones recorded per thread before further zones are dropped.
+             */
+            static constexpr size_t MaxZonesPerThread = size_t{1} << 20;
+
+            /**
+             * @brief Start or stop recording zones.
+             * @param enabled True to record.
+             */
+            static void setEnabled(bool enabled) noexcept;
+
+            /**
+             * @brief Check whether zones are being recorded.
+             * @return True if recording.
+             */
+            [[nodiscard]] static bool isEnabled() noexcept { return s_enabled.load(std::memory_order_relaxed); }
+
+            /**
+             * @brief Get the profiler clock.
+             * @return Nanoseconds since the profiler was first used.
+             */
+            [[nodiscard]] static int64_t now() noexcept;
+
+            /**
+             * @brief Record a closed zone on the calling thread.
+             * @param name The zone name; must outlive the profiler, e.g. a string literal.
+             * @param start The zone start from now().
+             * @param end The zone end from now().
+             */
+            static void record(const char* name, int64_t start, int64_t end) noexcept;
+
+            /**
+             * @brief Name the calling thread in the trace.
+             * @param name The thread name.
+             */
+            static void setThreadName(std::string name);
+
+            /**
+             * @brief Print count, p50, p99 and max per zone name to standard output.
+             */
+            static void printSummary();
+
+            /**
+             * @brief Write the recorded zones as Chrome trace_event JSON.
+             *
+             * Call while the other threads are idle; zones recorded during the
+             * export may or may not be included.
+             *
+             * @param path The output file path.
+             * @return True if the file was written.
+             */
+            static bool writeChromeTrace(const std::string& path);
+
+        private:
+            /**
+             * @brief Whether zones are being recorded.
+             */
+            static std::atomic<bool> s_enabled;
+    };
+
+    /**
+     * @brief Scoped zone recorded from construction to destruction.
+     */
+    class ProfileZone {
+        public:
+            /**
+             * @brief Open a zone if the profiler is enabled.
+             * @param name The zone name; must outlive the profiler, e.g. a string literal.
+             */
+            explicit ProfileZone(const char* name) noexcept
+                : m_name(Profiler::isEnabled() ? name : nullptr) {
+                if (m_name) {
+                    m_start = Profiler::now();
+                }
+            }
+
+            /**
+             * @brief Close the zone.
+             */
+            ~ProfileZone() {
+                if (m_name) {
+                    Profiler::record(m_name, m_start, Profiler::now());
+                }
+            }
+
+            ProfileZone(const ProfileZone&) = delete;
+            ProfileZone& operator=(const ProfileZone&) = delete;
+
+        private:
+            /**
+             * @brief The zone name, nullptr if the profiler was disabled when opened.
+             */
+            const char* m_name;
+
+            /**
+             * @brief The zone start.
+             */
+            int64_t m_start{0};
+    };
+
+}
+
+#define DRITE_PROFILE_CONCAT_IMPL(a, b) a##b
+#define DRITE_PROFILE_CONCAT(a, b) DRITE_PROFILE_CONCAT_IMPL(a, b)
+
+// Time the rest of the enclosing scope under a string-literal name; compiles to
+// nothing with DRITE_DISABLE_PROFILER
+#ifdef DRITE_DISABLE_PROFILER
+#define DRITE_PROFILE_ZONE(name) ((void)0)
+#else
+#define DRITE_PROFILE_ZONE(name) ::drite::ProfileZone DRITE_PROFILE_CONCAT(driteProfileZone, __LINE__)(name)
+#endif
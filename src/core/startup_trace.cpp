@@ -0,0 +1,123 @@
+#include "core/startup_trace.h"
+#include <algorithm>
+#include <chrono>
+#include <mutex>
+#include <print>
+#include <thread>
+#include <vector>
+
+namespace drite {
+
+    /**
+     * @brief A finished startup phase.
+     */
+    struct StartupRecord {
+        const char* name;
+        double start;
+        double end;
+        bool mainThread;
+    };
+
+    /**
+     * @brief The phases recorded so far and the first frame time.
+     */
+    struct StartupState {
+        std::mutex mutex;
+        std::vector<StartupRecord> phases;
+        std::optional<double> firstFrame;
+    };
+
+    /**
+     * @brief The clock origin, taken during static initialization on the main thread.
+     */
+    static const auto ProcessStart = std::chrono::steady_clock::now();
+
+    /**
+     * @brief The thread running static initialization, which is the main thread.
+     */
+    static const std::thread::id MainThread = std::this_thread::get_id();
+
+    /**
+     * @brief Get the process-wide startup state.
+     * @return The state.
+     */
+    static StartupState& getState() {
+        static StartupState state;
+        return state;
+    }
+
+    /**
+     * @brief Get the startup clock.
+     * @return Seconds since the process started running static initializers.
+     */
+    double StartupTrace::now() noexcept {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - ProcessStart).count();
+    }
+
+    /**
+     * @brief Record a finished phase on the calling thread; ignored if it started after the first frame.
+     * @param name The phase name; must outlive the trace, e.g. a string literal.
+     * @param start The phase start from now().
+     * @param end The phase end from now().
+     */
+    void StartupTrace::record(const char* name, double start, double end) {
+        StartupState& state = getState();
+        std::lock_guard lock(state.mutex);
+
+        // Files opened later in the session are not part of startup
+        if (state.firstFrame && start > *state.firstFrame) {
+            return;
+        }
+        state.phases.push_back(StartupRecord{name, start, end, std::this_thread::get_id() == MainThread});
+    }
+
+    /**
+     * @brief Record that the first frame was presented; later calls are ignored.
+     */
+    void StartupTrace::markFirstFrame() {
+        StartupState& state = getState();
+        std::lock_guard lock(state.mutex);
+        if (!state.firstFrame) {
+            state.firstFrame = now();
+        }
+    }
+
+    /**
+     * @brief Get the time the first frame was presented.
+     * @return Seconds from now()'s origin, or std::nullopt if no frame was presented yet.
+     */
+    std::optional<double> StartupTrace::getFirstFrameTime() {
+        StartupState& state = getState();
+        std::lock_guard lock(state.mutex);
+        return state.firstFrame;
+    }
+
+    /**
+     * @brief Print the phases in start order, with their thread, to standard output.
+     */
+    void StartupTrace::printReport() {
+        StartupState& state = getState();
+        std::lock_guard lock(state.mutex);
+        std::vector<StartupRecord> phases = state.phases;
+        std::ranges::stable_sort(phases, {}, &StartupRecord::start);
+
+        // Main thread time is what the first frame waits for; background
+        // phases only count where the main thread had to wait on them
+        const double end = state.firstFrame.value_or(now());
+        double mainSeconds{0.0};
+        double backgroundSeconds{0.0};
+        std::println("Startup: {:<24} {:<10} {:>10} {:>10}", "phase", "thread", "start ms", "took ms");
+        for (const StartupRecord& phase : phases) {
+            std::println("Startup: {:<24} {:<10} {:>10.2f} {:>10.2f}", phase.name, phase.mainThread ? "main" : "background", phase.start * 1e3,
+                (phase.end - phase.start) * 1e3);
+            (phase.mainThread ? mainSeconds : backgroundSeconds) += phase.end - phase.start;
+        }
+        if (state.firstFrame) {
+            std::println("Startup: first frame presented {:.2f} ms after launch", end * 1e3);
+        } else {
+            std::println("Startup: no frame presented");
+        }
+        std::println("Startup: {:.2f} ms in main thread phases, {:.2f} ms in background phases", mainSeconds * 1e3, backgroundSeconds * 1e3);
+    }
+
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include "core/profiler.h"
+#include <optional>
+
+namespace drite {
+
+    /**
+     * @brief Process-wide record of the phases from launch to the first frame.
+     *
+     * Startup takes a few dozen phases at most, so they are always recorded,
+     * under a lock, and --trace-startup only decides whether the report is
+     * printed. Times count from static initialization, just before main().
+     * Phases are also recorded as profiler zones when profiling.
+     */
+    class StartupTrace {
+        public:
+            /**
+             * @brief Get the startup clock.
+             * @return Seconds since the process started running static initializers.
+             */
+            [[nodiscard]] static double now() noexcept;
+
+            /**
+             * @brief Record a finished phase on the calling thread; ignored if it started after the first frame.
+             * @param name The phase name; must outlive the trace, e.g. a string literal.
+             * @param start The phase start from now().
+             * @param end The phase end from now().
+             */
+            static void record(const char* name, double start, double end);
+
+            /**
+             * @brief Record that the first frame was presented; later calls are ignored.
+             */
+            static void markFirstFrame();
+
+            /**
+             * @brief Get the time the first frame was presented.
+             * @return Seconds from now()'s origin, or std::nullopt if no frame was presented yet.
+             */
+            [[nodiscard]] static std::optional<double> getFirstFrameTime();
+
+            /**
+             * @brief Print the phases in start order, with their thread, to standard output.
+             */
+            static void printReport();
+    };
+
+    /**
+     * @brief Scoped startup phase recorded from construction to destruction.
+     */
+    class StartupPhase {
+        public:
+            /**
+             * @brief Open a phase.
+             * @param name The phase name; must outlive the trace, e.g. a string literal.
+             */
+            explicit StartupPhase(const char* name) noexcept
+                : m_name(name)
+                , m_start(StartupTrace::now())
+                , m_zone(name) {}
+
+            /**
+             * @brief Close the phase.
+             */
+            ~StartupPhase() {
+                StartupTrace::record(m_name, m_start, StartupTrace::now());
+            }
+
+            StartupPhase(const StartupPhase&) = delete;
+            StartupPhase& operator=(const StartupPhase&) = delete;
+
+        private:
+            /**
+             * @brief The phase name.
+             */
+            const char* m_name;
+
+            /**
+             * @brief The phase start.
+             */
+            double m_start;
+
+            /**
+             * @brief The matching profiler zone.
+             */
+            ProfileZone m_zone;
+    };
+
+}
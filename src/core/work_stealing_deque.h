@@ -0,0 +1,196 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <type_traits>
+#include <vector>
+
+namespace drite {
+
+    /**
+     * @brief Chase-Lev work-stealing deque.
+     *
+     * One owner thread pushes and pops at the bottom without locks, like a
+     * stack, so it keeps working on the data it touched last; any other
+     * thread steals the oldest item from the top. Only the last item is
+     * contended, and a compare-and-swap on the top decides who gets it.
+     *
+     * The ring grows when full; outgrown rings stay allocated until the
+     * deque is destroyed, since a thief may still be reading one.
+     *
+     * @tparam T The item type, copied by value; usually a pointer.
+     */
+    template <typename T>
+    class WorkStealingDeque {
+        static_assert(std::is_trivially_copyable_v<T>, "Deque items are copied through atomics");
+
+        public:
+            /**
+             * @brief Construct a new Work Stealing Deque object.
+             * @param capacity The initial capacity, rounded up to a power of two.
+             */
+            explicit WorkStealingDeque(size_t capacity = 256) {
+                size_t rounded{1};
+                while (rounded < capacity) {
+                    rounded <<= 1;
+                }
+                m_rings.push_back(std::make_unique<Ring>(rounded));
+                m_ring.store(m_rings.back().get(), std::memory_order_relaxed);
+            }
+
+            WorkStealingDeque(const WorkStealingDeque&) = delete;
+            WorkStealingDeque& operator=(const WorkStealingDeque&) = delete;
+
+            /**
+             * @brief Push an item at the bottom; owner thread only.
+             * @param item The item.
+             */
+            void push(T item) {
+                const int64_t bottom = m_bottom.load(std::memory_order_relaxed);
+                const int64_t top = m_top.load(std::memory_order_acquire);
+                Ring* ring = m_ring.load(std::memory_order_relaxed);
+                if (bottom - top >= static_cast<int64_t>(ring->capacity)) {
+                    ring = grow(ring, top, bottom);
+                }
+                ring->put(bottom, item);
+
+                // Releasing the bottom publishes the item and what it points to to thieves
+                m_bottom.store(bottom + 1, std::memory_order_release);
+            }
+
+            /**
+             * @brief Pop the newest item from the bottom; owner thread only.
+             * @return The item, or std::nullopt if the deque is empty or a thief took the last item.
+             */
+            [[nodiscard]] std::optional<T> pop() noexcept {
+                // The sequentially consistent store and load order the claim on
+                // the bottom before the look at the top, against steal() doing
+                // the reverse; plain fences would do, but sanitizers miss them
+                const int64_t bottom = m_bottom.load(std::memory_order_relaxed) - 1;
+                Ring* ring = m_ring.load(std::memory_order_relaxed);
+                m_bottom.store(bottom, std::memory_order_seq_cst);
+                int64_t top = m_top.load(std::memory_order_seq_cst);
+
+                if (top > bottom) {
+                    m_bottom.store(bottom + 1, std::memory_order_relaxed);
+                    return std::nullopt;
+                }
+
+                T item = ring->get(bottom);
+                if (top == bottom) {
+                    // The last item: race the thieves for it
+                    const bool won = m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+                    m_bottom.store(bottom + 1, std::memory_order_relaxed);
+                    if (!won) {
+                        return std::nullopt;
+                    }
+                }
+                return item;
+            }
+
+            /**
+             * @brief Steal the oldest item from the top; any thread.
+             * @return The item, or std::nullopt if the deque is empty or another thread took it first.
+             */
+            [[nodiscard]] std::optional<T> steal() noexcept {
+                int64_t top = m_top.load(std::memory_order_seq_cst);
+                const int64_t bottom = m_bottom.load(std::memory_order_seq_cst);
+                if (top >= bottom) {
+                    return std::nullopt;
+                }
+
+                Ring* ring = m_ring.load(std::memory_order_acquire);
+                T item = ring->get(top);
+                if (!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+                    return std::nullopt;
+                }
+                return item;
+            }
+
+            /**
+             * @brief Get the number of items, which other threads may change at any time.
+             * @return The approximate item count.
+             */
+            [[nodiscard]] size_t getSizeEstimate() const noexcept {
+                const int64_t bottom = m_bottom.load(std::memory_order_relaxed);
+                const int64_t top = m_top.load(std::memory_order_relaxed);
+                return bottom > top ? static_cast<size_t>(bottom - top) : 0;
+            }
+
+        private:
+            /**
+             * @brief A power-of-two ring of item slots indexed by unbounded positions.
+             */
+            struct Ring {
+                size_t capacity;
+                std::unique_ptr<std::atomic<T>[]> slots;
+
+                /**
+                 * @brief Construct a new Ring object.
+                 * @param size The capacity; a power of two.
+                 */
+                explicit Ring(size_t size) : capacity(size), slots(std::make_unique<std::atomic<T>[]>(size)) {}
+
+                /**
+                 * @brief Store an item.
+                 * @param position The deque position.
+                 * @param item The item.
+                 */
+                void put(int64_t position, T item) noexcept {
+                    slots[static_cast<size_t>(position) & (capacity - 1)].store(item, std::memory_order_relaxed);
+                }
+
+                /**
+                 * @brief Load an item.
+                 * @param position The deque position.
+                 * @return The item.
+                 */
+                [[nodiscard]] T get(int64_t position) const noexcept {
+                    return slots[static_cast<size_t>(position) & (capacity - 1)].load(std::memory_order_relaxed);
+                }
+            };
+
+            /**
+             * @brief Replace the ring by one of twice the capacity holding the same items.
+             * @param ring The current ring.
+             * @param top The top position.
+             * @param bottom The bottom position.
+             * @return The new ring.
+             */
+            Ring* grow(Ring* ring, int64_t top, int64_t bottom) {
+                auto larger = std::make_unique<Ring>(ring->capacity * 2);
+                for (int64_t position = top; position < bottom; ++position) {
+                    larger->put(position, ring->get(position));
+                }
+                Ring* next = larger.get();
+                m_rings.push_back(std::move(larger));
+                m_ring.store(next, std::memory_order_release);
+                return next;
+            }
+
+        private:
+            /**
+             * @brief Position of the oldest item; advanced by thieves and by the owner taking the last item.
+             */
+            alignas(64) std::atomic<int64_t> m_top{0};
+
+            /**
+             * @brief Position after the newest item; written by the owner only.
+             */
+            alignas(64) std::atomic<int64_t> m_bottom{0};
+
+            /**
+             * @brief The current ring.
+             */
+            std::atomic<Ring*> m_ring{nullptr};
+
+            /**
+             * @brief Every ring allocated, the current one last; touched by the owner only.
+             */
+            std::vector<std::unique_ptr<Ring>> m_rings;
+    };
+
+}
@@ -0,0 +1,411 @@
+#include "editor/document.h"
+#include "input/key_mapping.h"
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+
+namespace drite {
+
+    /**
+     * @brief Marks a cursor whose preferred column is its current column.
+     */
+    static constexpr size_t CurrentColumn = SIZE_MAX;
+
+    /**
+     * @brief Construct an empty Document.
+     */
+    Document::Document() = default;
+
+    /**
+     * @brief Construct a Document over an existing text buffer.
+     * @param buffer The text buffer holding the document contents.
+     * @param path The path the document was loaded from, empty if none.
+     */
+    Document::Document(TextBuffer buffer, std::string path)
+        : m_buffer(std::move(buffer))
+        , m_path(std::move(path)) {}
+
+    /**
+     * @brief Apply a key press to the document.
+     * @param event The key event.
+     * @return True if the document text or cursor changed.
+     */
+    bool Document::handleKey(const KeyEvent& event) {
+        if (event.action == KeyAction::Release) {
+            return false;
+        }
+
+        // Cmd/Ctrl+Z undoes, Shift+Cmd/Ctrl+Z or Ctrl+Y redoes
+        const bool shortcut = event.modifiers.command || event.modifiers.control;
+        if (shortcut && event.key == KeyCode::Z) {
+            return event.modifiers.shift ? redo() : undo();
+        }
+        if (shortcut && event.key == KeyCode::Y) {
+            return redo();
+        }
+
+        // Moving the cursor ends the current run of typing or deleting
+        if (event.key == KeyCode::Left || event.key == KeyCode::Right || event.key == KeyCode::Up ||
+            event.key == KeyCode::Down || event.key == KeyCode::Home || event.key == KeyCode::End) {
+            m_history.seal();
+        }
+
+        // Alt+Shift+Up/Down adds a cursor on the line above or below
+        if (event.modifiers.alt && event.modifiers.shift && (event.key == KeyCode::Up || event.key == KeyCode::Down)) {
+            return addCursorVertically(event.key == KeyCode::Up ? -1 : 1);
+        }
+
+        const size_t size = m_buffer.getSize();
+        const bool multiple = m_cursors.size() > 1;
+        std::vector<size_t> offsets(m_cursors);
+        switch (event.key) {
+            case KeyCode::Backspace:
+                if (multiple) {
+                    return editAtCursors(1, 0, {});
+                }
+                if (getCursor() == 0) {
+                    return false;
+                }
+                eraseText(getCursor() - 1, 1, EditKind::DeleteBackward, getCursor() - 1);
+                return true;
+
+            case KeyCode::Delete:
+                if (multiple) {
+                    return editAtCursors(0, 1, {});
+                }
+                if (getCursor() >= size) {
+                    return false;
+                }
+                eraseText(getCursor(), 1, EditKind::DeleteForward, getCursor());
+                return true;
+
+            case KeyCode::Left:
+                if (m_cursors.back() == 0) {
+                    return false;
+                }
+                for (size_t& offset : offsets) {
+                    offset = offset > 0 ? offset - 1 : 0;
+                }
+                moveCursors(offsets, false);
+                return true;
+
+            case KeyCode::Right:
+                if (m_cursors.front() >= size) {
+                    return false;
+                }
+                for (size_t& offset : offsets) {
+                    offset = std::min(offset + 1, size);
+                }
+                moveCursors(offsets, false);
+                return true;
+
+            case KeyCode::Up:
+                moveCursorVertically(-1);
+                return true;
+
+            case KeyCode::Down:
+                moveCursorVertically(1);
+                return true;
+
+            case KeyCode::Home:
+                for (size_t& offset : offsets) {
+                    offset = m_buffer.getLineStart(m_buffer.offsetToPosition(offset).line);
+                }
+                moveCursors(offsets, false);
+                return true;
+
+            case KeyCode::End:
+                for (size_t& offset : offsets) {
+                    const size_t line = m_buffer.offsetToPosition(offset).line;
+                    offset = m_buffer.getLineStart(line) + m_buffer.getLineLength(line);
+                }
+                moveCursors(offsets, false);
+                return true;
+
+            default:
+                break;
+        }
+
+        const char character = keyToCharacter(event);
+        if (character == '\0') {
+            return false;
+        }
+
+        if (multiple) {
+            return editAtCursors(0, 0, std::string_view(&character, 1));
+        }
+        insertText(getCursor(), std::string_view(&character, 1), EditKind::Typing, getCursor() + 1);
+        return true;
+    }
+
+    /**
+     * @brief Insert text at every cursor and move the cursors past it.
+     * @param text The text to insert.
+     */
+    void Document::insertAtCursor(std::string_view text) {
+        if (m_cursors.size() > 1) {
+            static_cast<void>(editAtCursors(0, 0, text));
+            return;
+        }
+        insertText(getCursor(), text, EditKind::Other, getCursor() + text.size());
+    }
+
+    /**
+     * @brief Revert the most recent undo group and restore the cursors from before it.
+     * @return True if anything was undone.
+     */
+    bool Document::undo() {
+        size_t cursor{0};
+        std::vector<size_t> cursors;
+        if (!m_history.undo(m_buffer, cursor, cursors)) {
+            return false;
+        }
+        setCursors(cursors.empty() ? std::span<const size_t>(&cursor, 1) : std::span<const size_t>(cursors), cursor);
+        return true;
+    }
+
+    /**
+     * @brief Reapply the most recently undone group and restore the cursors from after it.
+     * @return True if anything was redone.
+     */
+    bool Document::redo() {
+        size_t cursor{0};
+        std::vector<size_t> cursors;
+        if (!m_history.redo(m_buffer, cursor, cursors)) {
+            return false;
+        }
+        setCursors(cursors.empty() ? std::span<const size_t>(&cursor, 1) : std::span<const size_t>(cursors), cursor);
+        return true;
+    }
+
+    /**
+     * @brief Move the cursor to the given byte offset, removing any other cursors.
+     * @param offset The new cursor offset, clamped to the document size.
+     */
+    void Document::setCursor(size_t offset) {
+        m_cursors.assign(1, std::min(offset, m_buffer.getSize()));
+        m_preferredColumns.assign(1, CurrentColumn);
+        m_primaryCursor = 0;
+    }
+
+    /**
+     * @brief Replace the cursors.
+     * @param offsets The new cursor offsets in any order, clamped to the document size; duplicates are merged.
+     * @param primary The offset of the cursor the view follows, one of offsets.
+     */
+    void Document::setCursors(std::span<const size_t> offsets, size_t primary) {
+        const size_t size = m_buffer.getSize();
+        m_cursors.clear();
+        for (const size_t offset : offsets) {
+            m_cursors.push_back(std::min(offset, size));
+        }
+        if (m_cursors.empty()) {
+            m_cursors.push_back(std::min(primary, size));
+        }
+        std::sort(m_cursors.begin(), m_cursors.end());
+        m_cursors.erase(std::unique(m_cursors.begin(), m_cursors.end()), m_cursors.end());
+
+        m_preferredColumns.assign(m_cursors.size(), CurrentColumn);
+        const auto found = std::lower_bound(m_cursors.begin(), m_cursors.end(), std::min(primary, size));
+        m_primaryCursor = std::min(static_cast<size_t>(found - m_cursors.begin()), m_cursors.size() - 1);
+    }
+
+    /**
+     * @brief Add a cursor and make it the primary one.
+     * @param offset The cursor offset, clamped to the document size.
+     */
+    void Document::addCursor(size_t offset) {
+        offset = std::min(offset, m_buffer.getSize());
+        const auto found = std::lower_bound(m_cursors.begin(), m_cursors.end(), offset);
+        const size_t index = static_cast<size_t>(found - m_cursors.begin());
+        if (found == m_cursors.end() || *found != offset) {
+            m_cursors.insert(found, offset);
+            m_preferredColumns.insert(m_preferredColumns.begin() + static_cast<ptrdiff_t>(index), CurrentColumn);
+        }
+        m_primaryCursor = index;
+    }
+
+    /**
+     * @brief Move the cursor to the start of a line, removing any other cursors.
+     * @param line The zero-based line number, clamped to the last line.
+     */
+    void Document::goToLine(size_t line) {
+        m_history.seal();
+        setCursor(m_buffer.getLineStart(line));
+    }
+
+    /**
+     * @brief Insert text and record it in the undo history.
+     * @param offset The byte offset to insert at.
+     * @param text The text to insert.
+     * @param kind What the edit does, for coalescing.
+     * @param cursorAfter The cursor offset after the edit.
+     */
+    void Document::insertText(size_t offset, std::string_view text, EditKind kind, size_t cursorAfter) {
+        const size_t cursorBefore = getCursor();
+        m_buffer.insert(offset, text);
+        m_history.record(offset, {}, m_buffer.getPieces(offset, text.size()), kind, cursorBefore, cursorAfter);
+        setCursor(cursorAfter);
+    }
+
+    /**
+     * @brief Erase a byte range and record it in the undo history.
+     * @param offset The byte offset of the range.
+     * @param length The length of the range in bytes.
+     * @param kind What the edit does, for coalescing.
+     * @param cursorAfter The cursor offset after the edit.
+     */
+    void Document::eraseText(size_t offset, size_t length, EditKind kind, size_t cursorAfter) {
+        const size_t cursorBefore = getCursor();
+        const std::vector<Piece> removed = m_buffer.getPieces(offset, length);
+        m_buffer.erase(offset, length);
+        m_history.record(offset, removed, {}, kind, cursorBefore, cursorAfter);
+        setCursor(cursorAfter);
+    }
+
+    /**
+     * @brief Replace text around every cursor in one batch and record it as one undo group.
+     *
+     * The text is appended to the buffer once and every cursor inserts the
+     * same piece of it. Ranges that would overlap a neighbouring cursor's are
+     * cut short, so adjacent cursors never erase the same byte twice.
+     *
+     * @param before The number of bytes to erase before each cursor.
+     * @param after The number of bytes to erase after each cursor.
+     * @param text The text to insert at each cursor.
+     * @return True if the document changed.
+     */
+    bool Document::editAtCursors(size_t before, size_t after, std::string_view text) {
+        const size_t size = m_buffer.getSize();
+        const Piece inserted = text.empty() ? Piece{} : m_buffer.appendText(text);
+        const std::span<const Piece> insertedPieces(&inserted, text.empty() ? 0 : 1);
+
+        std::vector<PieceEdit> edits;
+        std::vector<size_t> cursorsAfter;
+        edits.reserve(m_cursors.size());
+        cursorsAfter.reserve(m_cursors.size());
+        size_t previousEnd{0};
+        ptrdiff_t shift{0};
+        for (const size_t cursor : m_cursors) {
+            const size_t start = std::max(cursor - std::min(cursor, before), previousEnd);
+            const size_t end = std::max(std::min(cursor + after, size), start);
+            if (end == start && text.empty()) {
+                cursorsAfter.push_back(static_cast<size_t>(static_cast<ptrdiff_t>(cursor) + shift));
+                continue;
+            }
+
+            edits.push_back(PieceEdit{start, end - start, insertedPieces});
+            cursorsAfter.push_back(static_cast<size_t>(static_cast<ptrdiff_t>(start) + shift) + text.size());
+            shift += static_cast<ptrdiff_t>(text.size()) - static_cast<ptrdiff_t>(end - start);
+            previousEnd = end;
+        }
+        if (edits.empty()) {
+            return false;
+        }
+
+        RemovedPieces removed;
+        removed.ends.reserve(edits.size());
+        m_buffer.replacePieces(edits, &removed);
+
+        // The history replays deltas one after another, so each is recorded
+        // at its offset once the deltas before it have been applied
+        const std::span<const Piece> removedPieces(removed.pieces);
+        const size_t primaryAfter = cursorsAfter[m_primaryCursor];
+        m_history.beginGroup();
+        shift = 0;
+        for (size_t i = 0, first = 0; i < edits.size(); first = removed.ends[i], ++i) {
+            const size_t offset = static_cast<size_t>(static_cast<ptrdiff_t>(edits[i].offset) + shift);
+            m_history.record(offset, removedPieces.subspan(first, removed.ends[i] - first), insertedPieces, EditKind::Other, getCursor(),
+                             primaryAfter);
+            shift += static_cast<ptrdiff_t>(text.size()) - static_cast<ptrdiff_t>(edits[i].length);
+        }
+        m_history.setGroupCursors(m_cursors, cursorsAfter);
+        m_history.endGroup();
+
+        moveCursors(cursorsAfter, false);
+        return true;
+    }
+
+    /**
+     * @brief Move every cursor, merging cursors that meet.
+     * @param offsets The new offset of each cursor, in the order of m_cursors; sorted here if they crossed.
+     * @param keepColumns True to keep the preferred columns, as vertical movement does.
+     */
+    void Document::moveCursors(std::vector<size_t>& offsets, bool keepColumns) {
+        const size_t size = m_buffer.getSize();
+        const size_t primary = std::min(offsets[m_primaryCursor], size);
+        if (!keepColumns) {
+            std::fill(m_preferredColumns.begin(), m_preferredColumns.end(), CurrentColumn);
+        }
+
+        // Cursors with different preferred columns can pass each other on a short line
+        if (!std::is_sorted(offsets.begin(), offsets.end())) {
+            std::vector<std::pair<size_t, size_t>> cursors;
+            cursors.reserve(offsets.size());
+            for (size_t i = 0; i < offsets.size(); ++i) {
+                cursors.emplace_back(offsets[i], m_preferredColumns[i]);
+            }
+            std::sort(cursors.begin(), cursors.end());
+            for (size_t i = 0; i < offsets.size(); ++i) {
+                offsets[i] = cursors[i].first;
+                m_preferredColumns[i] = cursors[i].second;
+            }
+        }
+
+        size_t count{0};
+        for (size_t i = 0; i < offsets.size(); ++i) {
+            const size_t offset = std::min(offsets[i], size);
+            if (count > 0 && offset == offsets[count - 1]) {
+                continue;
+            }
+            offsets[count] = offset;
+            m_preferredColumns[count] = m_preferredColumns[i];
+            ++count;
+        }
+        offsets.resize(count);
+        m_preferredColumns.resize(count);
+        m_cursors.swap(offsets);
+
+        const auto found = std::lower_bound(m_cursors.begin(), m_cursors.end(), primary);
+        m_primaryCursor = std::min(static_cast<size_t>(found - m_cursors.begin()), m_cursors.size() - 1);
+    }
+
+    /**
+     * @brief Move the cursors vertically, keeping their preferred columns.
+     * @param lines The number of lines to move; negative moves up.
+     */
+    void Document::moveCursorVertically(long lines) {
+        const long lastLine = static_cast<long>(m_buffer.getLineCount()) - 1;
+        std::vector<size_t> offsets(m_cursors.size());
+        for (size_t i = 0; i < m_cursors.size(); ++i) {
+            const TextPosition position = m_buffer.offsetToPosition(m_cursors[i]);
+            if (m_preferredColumns[i] == CurrentColumn) {
+                m_preferredColumns[i] = position.column;
+            }
+            const long target = std::clamp(static_cast<long>(position.line) + lines, 0L, lastLine);
+            offsets[i] = m_buffer.positionToOffset(TextPosition(static_cast<size_t>(target), m_preferredColumns[i]));
+        }
+        moveCursors(offsets, true);
+    }
+
+    /**
+     * @brief Add a cursor on the line above the first cursor or below the last one.
+     * @param lines -1 to add above, 1 to add below.
+     * @return True if a cursor was added.
+     */
+    bool Document::addCursorVertically(long lines) {
+        const size_t index = lines < 0 ? 0 : m_cursors.size() - 1;
+        const TextPosition position = m_buffer.offsetToPosition(m_cursors[index]);
+        const size_t column = m_preferredColumns[index] == CurrentColumn ? position.column : m_preferredColumns[index];
+        if ((lines < 0 && position.line == 0) || (lines > 0 && position.line + 1 >= m_buffer.getLineCount())) {
+            return false;
+        }
+
+        const size_t line = lines < 0 ? position.line - 1 : position.line + 1;
+        m_preferredColumns[index] = column;
+        addCursor(m_buffer.positionToOffset(TextPosition(line, column)));
+        m_preferredColumns[m_primaryCursor] = column;
+        return true;
+    }
+
+}
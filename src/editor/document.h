@@ -0,0 +1,230 @@
+#pragma once
+
+#include "editor/text_buffer.h"
+#include "editor/undo_history.h"
+#include "input/input_types.h"
+#include <cstddef>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace drite {
+
+    /**
+     * @brief An editable document: the text buffer plus the editing state on top of it.
+     *
+     * The document has one or more cursors, kept sorted and distinct. With
+     * several cursors a keystroke edits at all of them in one batch: the piece
+     * tree is edited in a single pass, the line change covers every cursor at
+     * once, and the edit is one undo group.
+     */
+    class Document {
+        public:
+            /**
+             * @brief Construct an empty Document.
+             */
+            Document();
+
+            /**
+             * @brief Construct a Document over an existing text buffer.
+             * @param buffer The text buffer holding the document contents.
+             * @param path The path the document was loaded from, empty if none.
+             */
+            explicit Document(TextBuffer buffer, std::string path = {});
+
+            /**
+             * @brief Apply a key press to the document.
+             * @param event The key event.
+             * @return True if the document text or cursor changed.
+             */
+            bool handleKey(const KeyEvent& event);
+
+            /**
+             * @brief Insert text at every cursor and move the cursors past it.
+             * @param text The text to insert.
+             */
+            void insertAtCursor(std::string_view text);
+
+            /**
+             * @brief Revert the most recent undo group and restore the cursors from before it.
+             * @return True if anything was undone.
+             */
+            bool undo();
+
+            /**
+             * @brief Reapply the most recently undone group and restore the cursors from after it.
+             * @return True if anything was redone.
+             */
+            bool redo();
+
+            /**
+             * @brief Get the undo history.
+             * @return Reference to the undo history.
+             */
+            [[nodiscard]] UndoHistory& getHistory() noexcept { return m_history; }
+
+            /**
+             * @brief Get the undo history.
+             * @return Const reference to the undo history.
+             */
+            [[nodiscard]] const UndoHistory& getHistory() const noexcept { return m_history; }
+
+            /**
+             * @brief Get the document text buffer.
+             * @return Reference to the text buffer.
+             */
+            [[nodiscard]] const TextBuffer& getBuffer() const noexcept { return m_buffer; }
+
+            /**
+             * @brief Take the lines changed since the last call.
+             * @return The accumulated change, or std::nullopt if nothing changed.
+             */
+            [[nodiscard]] std::optional<LineChange> takeLineChange() noexcept { return m_buffer.takeLineChange(); }
+
+            /**
+             * @brief Get the path the document was loaded from or last saved to.
+             * @return The document path, empty for untitled documents.
+             */
+            [[nodiscard]] const std::string& getPath() const noexcept { return m_path; }
+
+            /**
+             * @brief Set the path the document is saved to, e.g. after saving it under a new name.
+             * @param path The new document path.
+             */
+            void setPath(std::string path) { m_path = std::move(path); }
+
+            /**
+             * @brief Get the primary cursor byte offset: the one the view follows.
+             * @return The cursor offset.
+             */
+            [[nodiscard]] size_t getCursor() const noexcept { return m_cursors[m_primaryCursor]; }
+
+            /**
+             * @brief Get every cursor.
+             * @return The cursor byte offsets in ascending order, never empty.
+             */
+            [[nodiscard]] std::span<const size_t> getCursors() const noexcept { return m_cursors; }
+
+            /**
+             * @brief Move the cursor to the given byte offset, removing any other cursors.
+             * @param offset The new cursor offset, clamped to the document size.
+             */
+            void setCursor(size_t offset);
+
+            /**
+             * @brief Replace the cursors.
+             * @param offsets The new cursor offsets in any order, clamped to the document size; duplicates are merged.
+             * @param primary The offset of the cursor the view follows, one of offsets.
+             */
+            void setCursors(std::span<const size_t> offsets, size_t primary);
+
+            /**
+             * @brief Add a cursor and make it the primary one.
+             * @param offset The cursor offset, clamped to the document size.
+             */
+            void addCursor(size_t offset);
+
+            /**
+             * @brief Move the cursor to the start of a line, removing any other cursors.
+             * @param line The zero-based line number, clamped to the last line.
+             */
+            void goToLine(size_t line);
+
+            /**
+             * @brief Get the line at the top of the view when the document was last shown.
+             * @return The zero-based line.
+             */
+            [[nodiscard]] size_t getScrollLine() const noexcept { return m_scrollLine; }
+
+            /**
+             * @brief Remember the line at the top of the view, to scroll back to it when the document is shown again.
+             * @param line The zero-based line.
+             */
+            void setScrollLine(size_t line) noexcept { m_scrollLine = line; }
+
+        private:
+            /**
+             * @brief Insert text and record it in the undo history.
+             * @param offset The byte offset to insert at.
+             * @param text The text to insert.
+             * @param kind What the edit does, for coalescing.
+             * @param cursorAfter The cursor offset after the edit.
+             */
+            void insertText(size_t offset, std::string_view text, EditKind kind, size_t cursorAfter);
+
+            /**
+             * @brief Erase a byte range and record it in the undo history.
+             * @param offset The byte offset of the range.
+             * @param length The length of the range in bytes.
+             * @param kind What the edit does, for coalescing.
+             * @param cursorAfter The cursor offset after the edit.
+             */
+            void eraseText(size_t offset, size_t length, EditKind kind, size_t cursorAfter);
+
+            /**
+             * @brief Replace text around every cursor in one batch and record it as one undo group.
+             * @param before The number of bytes to erase before each cursor.
+             * @param after The number of bytes to erase after each cursor.
+             * @param text The text to insert at each cursor.
+             * @return True if the document changed.
+             */
+            bool editAtCursors(size_t before, size_t after, std::string_view text);
+
+            /**
+             * @brief Move every cursor, merging cursors that meet.
+             * @param offsets The new offset of each cursor, in the order of m_cursors; sorted here if they crossed.
+             * @param keepColumns True to keep the preferred columns, as vertical movement does.
+             */
+            void moveCursors(std::vector<size_t>& offsets, bool keepColumns);
+
+            /**
+             * @brief Move the cursors vertically, keeping their preferred columns.
+             * @param lines The number of lines to move; negative moves up.
+             */
+            void moveCursorVertically(long lines);
+
+            /**
+             * @brief Add a cursor on the line above the first cursor or below the last one.
+             * @param lines -1 to add above, 1 to add below.
+             * @return True if a cursor was added.
+             */
+            bool addCursorVertically(long lines);
+
+        private:
+            /**
+             * @brief The document text.
+             */
+            TextBuffer m_buffer;
+
+            /**
+             * @brief The path the document was loaded from or last saved to.
+             */
+            std::string m_path;
+
+            /**
+             * @brief The cursor byte offsets in ascending order, never empty.
+             */
+            std::vector<size_t> m_cursors{0};
+
+            /**
+             * @brief Column each cursor returns to when moving across shorter lines.
+             */
+            std::vector<size_t> m_preferredColumns{0};
+
+            /**
+             * @brief Index of the primary cursor in m_cursors.
+             */
+            size_t m_primaryCursor{0};
+
+            /**
+             * @brief The line at the top of the view when the document was last shown.
+             */
+            size_t m_scrollLine{0};
+
+            /**
+             * @brief Edits that can be undone and redone.
+             */
+            UndoHistory m_history;
+    };
+
+}
@@ -0,0 +1,121 @@
+#include "editor/line_index.h"
+#include "editor/newline_scanner.h"
+#include <algorithm>
+#include <utility>
+
+namespace drite {
+
+    /**
+     * @brief Construct an empty LineIndex.
+     */
+    LineIndex::LineIndex()
+        : m_chunkPrefix{0} {}
+
+    /**
+     * @brief Construct a LineIndex from the state of an earlier one over the same bytes, without scanning them.
+     * @param chunkPrefix The chunk prefix counts, as returned by getChunkPrefix().
+     * @param lineFeedCount The total number of indexed line feeds.
+     * @param indexedSize The number of indexed bytes.
+     */
+    LineIndex::LineIndex(std::vector<uint64_t> chunkPrefix, size_t lineFeedCount, size_t indexedSize)
+        : m_chunkPrefix(std::move(chunkPrefix))
+        , m_lineFeedCount(lineFeedCount)
+        , m_indexedSize(indexedSize) {}
+
+    /**
+     * @brief Extend the index to cover newly appended bytes.
+     * @param text The whole buffer; bytes past the indexed size are indexed.
+     */
+    void LineIndex::update(std::string_view text) {
+        if (text.size() <= m_indexedSize) {
+            return;
+        }
+
+        m_chunkPrefix.reserve(text.size() / ChunkSize + 2);
+
+        // The trailing partial chunk has no entry of its own until it fills up
+        size_t position = m_indexedSize;
+        while (position < text.size()) {
+            const size_t chunkEnd = std::min((position / ChunkSize + 1) * ChunkSize, text.size());
+            m_lineFeedCount += drite::countLineFeeds(text.data() + position, chunkEnd - position);
+            if (chunkEnd % ChunkSize == 0) {
+                m_chunkPrefix.push_back(m_lineFeedCount);
+            }
+            position = chunkEnd;
+        }
+
+        m_indexedSize = text.size();
+    }
+
+    /**
+     * @brief Check that the index has the shape of an index over a buffer of the given size.
+     * @param size The buffer size in bytes.
+     * @return True if it indexes exactly that many bytes with one prefix count per chunk.
+     */
+    bool LineIndex::isConsistent(size_t size) const noexcept {
+        return m_indexedSize == size && m_chunkPrefix.size() == size / ChunkSize + 1 && m_chunkPrefix.front() == 0 &&
+               std::ranges::is_sorted(m_chunkPrefix) && m_chunkPrefix.back() <= m_lineFeedCount;
+    }
+
+    /**
+     * @brief Count the line feeds in a range of the buffer.
+     * @param text The indexed buffer.
+     * @param start The start offset of the range.
+     * @param end The end offset of the range.
+     * @return The number of line feeds in [start, end).
+     */
+    size_t LineIndex::countLineFeeds(std::string_view text, size_t start, size_t end) const noexcept {
+        if (end <= start) {
+            return 0;
+        }
+
+        // Short ranges are cheaper to scan directly than to resolve twice
+        if (end - start <= ChunkSize) {
+            return drite::countLineFeeds(text.data() + start, end - start);
+        }
+        return countBefore(text, end) - countBefore(text, start);
+    }
+
+    /**
+     * @brief Locate the n-th line feed at or after an offset.
+     * @param text The indexed buffer.
+     * @param start The offset to start counting from.
+     * @param n The one-based index of the line feed.
+     * @return The buffer offset of that line feed, or the indexed size if there is none.
+     */
+    size_t LineIndex::findLineFeed(std::string_view text, size_t start, size_t n) const noexcept {
+        const size_t target = countBefore(text, start) + n;
+        if (n == 0 || target > m_lineFeedCount) {
+            return m_indexedSize;
+        }
+
+        // The chunk holding the target is the last one with fewer line feeds
+        // before it than the target
+        const auto it = std::lower_bound(m_chunkPrefix.begin(), m_chunkPrefix.end(), static_cast<uint64_t>(target));
+        const size_t chunk = static_cast<size_t>(it - m_chunkPrefix.begin()) - 1;
+
+        const size_t from = std::max(chunk * ChunkSize, start);
+        size_t remaining = target - static_cast<size_t>(m_chunkPrefix[chunk]);
+        if (from > chunk * ChunkSize) {
+            remaining = n;
+        }
+
+        const size_t found = drite::findLineFeed(text.data() + from, m_indexedSize - from, remaining);
+        return from + found;
+    }
+
+    /**
+     * @brief Count the line feeds before an offset.
+     * @param text The indexed buffer.
+     * @param offset The offset.
+     * @return The number of line feeds in [0, offset).
+     */
+    size_t LineIndex::countBefore(std::string_view text, size_t offset) const noexcept {
+        offset = std::min(offset, m_indexedSize);
+        const size_t chunk = offset / ChunkSize;
+        const size_t chunkStart = chunk * ChunkSize;
+        return static_cast<size_t>(m_chunkPrefix[chunk]) +
+               drite::countLineFeeds(text.data() + chunkStart, offset - chunkStart);
+    }
+
+}
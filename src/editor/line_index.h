@@ -0,0 +1,115 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace drite {
+
+    /**
+     * @brief Line feed index over an append-only byte buffer.
+     *
+     * The buffer is divided into fixed-size chunks and the index stores the number
+     * of line feeds preceding each chunk. Counting the line feeds in a range or
+     * locating the n-th one is a binary search over the chunk prefix counts plus a
+     * vectorized scan of at most two partial chunks, so both run in O(log n) with
+     * an index of only a few bytes per kilobyte of text. Appending text updates
+     * the trailing chunk and adds new ones incrementally.
+     */
+    class LineIndex {
+        public:
+            /**
+             * @brief Size of an index chunk in bytes.
+             */
+            static constexpr size_t ChunkSize = 4096;
+
+            /**
+             * @brief Construct an empty LineIndex.
+             */
+            LineIndex();
+
+            /**
+             * @brief Construct a LineIndex from the state of an earlier one over the same bytes, without scanning them.
+             * @param chunkPrefix The chunk prefix counts, as returned by getChunkPrefix().
+             * @param lineFeedCount The total number of indexed line feeds.
+             * @param indexedSize The number of indexed bytes.
+             */
+            LineIndex(std::vector<uint64_t> chunkPrefix, size_t lineFeedCount, size_t indexedSize);
+
+            /**
+             * @brief Extend the index to cover newly appended bytes.
+             * @param text The whole buffer; bytes past the indexed size are indexed.
+             */
+            void update(std::string_view text);
+
+            /**
+             * @brief Count the line feeds in a range of the buffer.
+             * @param text The indexed buffer.
+             * @param start The start offset of the range.
+             * @param end The end offset of the range.
+             * @return The number of line feeds in [start, end).
+             */
+            [[nodiscard]] size_t countLineFeeds(std::string_view text, size_t start, size_t end) const noexcept;
+
+            /**
+             * @brief Locate the n-th line feed at or after an offset.
+             * @param text The indexed buffer.
+             * @param start The offset to start counting from.
+             * @param n The one-based index of the line feed.
+             * @return The buffer offset of that line feed, or the indexed size if there is none.
+             */
+            [[nodiscard]] size_t findLineFeed(std::string_view text, size_t start, size_t n) const noexcept;
+
+            /**
+             * @brief Get the total number of indexed line feeds.
+             * @return The line feed count.
+             */
+            [[nodiscard]] size_t getLineFeedCount() const noexcept { return m_lineFeedCount; }
+
+            /**
+             * @brief Get the number of indexed bytes.
+             * @return The indexed size.
+             */
+            [[nodiscard]] size_t getIndexedSize() const noexcept { return m_indexedSize; }
+
+            /**
+             * @brief Get the line feeds preceding each chunk, for saving the index.
+             * @return One count per complete chunk and one for the chunk after them.
+             */
+            [[nodiscard]] const std::vector<uint64_t>& getChunkPrefix() const noexcept { return m_chunkPrefix; }
+
+            /**
+             * @brief Check that the index has the shape of an index over a buffer of the given size.
+             * @param size The buffer size in bytes.
+             * @return True if it indexes exactly that many bytes with one prefix count per chunk.
+             */
+            [[nodiscard]] bool isConsistent(size_t size) const noexcept;
+
+        private:
+            /**
+             * @brief Count the line feeds before an offset.
+             * @param text The indexed buffer.
+             * @param offset The offset.
+             * @return The number of line feeds in [0, offset).
+             */
+            [[nodiscard]] size_t countBefore(std::string_view text, size_t offset) const noexcept;
+
+        private:
+            /**
+             * @brief Line feeds preceding each chunk, for every complete chunk and the one after it.
+             */
+            std::vector<uint64_t> m_chunkPrefix;
+
+            /**
+             * @brief Total number of indexed line feeds.
+             */
+            size_t m_lineFeedCount{0};
+
+            /**
+             * @brief Number of indexed bytes.
+             */
+            size_t m_indexedSize{0};
+    };
+
+}
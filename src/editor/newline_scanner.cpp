@@ -0,0 +1,301 @@
+#include "editor/newline_scanner.h"
+#include "core/cpu_features.h"
+#include <algorithm>
+#include <cstdint>
+
+#if DRITE_CPU_X86
+#include <immintrin.h>
+#elif DRITE_CPU_NEON
+#include <arm_neon.h>
+#endif
+
+namespace drite {
+
+    /**
+     * @brief Kernel entry points selected once per process.
+     */
+    struct ScannerKernels {
+        size_t (*count)(const char*, size_t) noexcept;
+        size_t (*find)(const char*, size_t, size_t) noexcept;
+        const char* name;
+    };
+
+    /**
+     * @brief Count line feeds one byte at a time.
+     * @param data The start of the range.
+     * @param size The size of the range in bytes.
+     * @return The number of line feeds.
+     */
+    static size_t countScalar(const char* data, size_t size) noexcept {
+        size_t count{0};
+        for (size_t i = 0; i < size; ++i) {
+            count += data[i] == '\n';
+        }
+        return count;
+    }
+
+    /**
+     * @brief Locate the n-th line feed one byte at a time.
+     * @param data The start of the range.
+     * @param size The size of the range in bytes.
+     * @param n The one-based line feed index.
+     * @return The offset of the line feed, or size if not found.
+     */
+    static size_t findScalar(const char* data, size_t size, size_t n) noexcept {
+        for (size_t i = 0; i < size; ++i) {
+            if (data[i] == '\n' && --n == 0) {
+                return i;
+            }
+        }
+        return size;
+    }
+
+    /**
+     * @brief Get the position of the n-th set bit of a mask.
+     * @param mask The bit mask, holding at least n set bits.
+     * @param n The one-based index of the set bit.
+     * @return The bit position.
+     */
+    [[maybe_unused]] static unsigned nthSetBit(uint64_t mask, size_t n) noexcept {
+        while (--n) {
+            mask &= mask - 1;
+        }
+        return static_cast<unsigned>(__builtin_ctzll(mask));
+    }
+
+#if DRITE_CPU_X86
+
+    /**
+     * @brief Count line feeds 16 bytes at a time with SSE2.
+     *
+     * Compare results are accumulated per byte lane and folded into the total
+     * with a sum of absolute differences before any lane can overflow.
+     *
+     * @param data The start of the range.
+     * @param size The size of the range in bytes.
+     * @return The number of line feeds.
+     */
+    static size_t countSse2(const char* data, size_t size) noexcept {
+        const __m128i newline = _mm_set1_epi8('\n');
+        const __m128i zero = _mm_setzero_si128();
+        size_t count{0};
+        size_t i{0};
+
+        while (size - i >= 16) {
+            __m128i lanes = zero;
+            const size_t blocks = std::min<size_t>((size - i) / 16, 255);
+            for (size_t block = 0; block < blocks; ++block, i += 16) {
+                const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+                lanes = _mm_sub_epi8(lanes, _mm_cmpeq_epi8(bytes, newline));
+            }
+            const __m128i sums = _mm_sad_epu8(lanes, zero);
+            count += static_cast<size_t>(_mm_cvtsi128_si64(sums)) +
+                     static_cast<size_t>(_mm_cvtsi128_si64(_mm_unpackhi_epi64(sums, sums)));
+        }
+
+        return count + countScalar(data + i, size - i);
+    }
+
+    /**
+     * @brief Locate the n-th line feed 16 bytes at a time with SSE2.
+     * @param data The start of the range.
+     * @param size The size of the range in bytes.
+     * @param n The one-based line feed index.
+     * @return The offset of the line feed, or size if not found.
+     */
+    static size_t findSse2(const char* data, size_t size, size_t n) noexcept {
+        const __m128i newline = _mm_set1_epi8('\n');
+        size_t i{0};
+
+        for (; size - i >= 16; i += 16) {
+            const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+            const uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, newline)));
+            const size_t found = static_cast<size_t>(__builtin_popcount(mask));
+            if (n <= found) {
+                return i + nthSetBit(mask, n);
+            }
+            n -= found;
+        }
+
+        const size_t tail = findScalar(data + i, size - i, n);
+        return i + tail;
+    }
+
+    /**
+     * @brief Count line feeds 32 bytes at a time with AVX2.
+     * @param data The start of the range.
+     * @param size The size of the range in bytes.
+     * @return The number of line feeds.
+     */
+    __attribute__((target("avx2")))
+    static size_t countAvx2(const char* data, size_t size) noexcept {
+        const __m256i newline = _mm256_set1_epi8('\n');
+        const __m256i zero = _mm256_setzero_si256();
+        size_t count{0};
+        size_t i{0};
+
+        while (size - i >= 128) {
+            // Two independent accumulators over an unrolled loop keep both load
+            // ports busy
+            __m256i lanesA = zero;
+            __m256i lanesB = zero;
+            const size_t blocks = std::min<size_t>((size - i) / 128, 127);
+            for (size_t block = 0; block < blocks; ++block, i += 128) {
+                const __m256i b0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+                const __m256i b1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i + 32));
+                const __m256i b2 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i + 64));
+                const __m256i b3 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i + 96));
+                lanesA = _mm256_sub_epi8(lanesA, _mm256_cmpeq_epi8(b0, newline));
+                lanesB = _mm256_sub_epi8(lanesB, _mm256_cmpeq_epi8(b1, newline));
+                lanesA = _mm256_sub_epi8(lanesA, _mm256_cmpeq_epi8(b2, newline));
+                lanesB = _mm256_sub_epi8(lanesB, _mm256_cmpeq_epi8(b3, newline));
+            }
+            const __m256i sums = _mm256_add_epi64(_mm256_sad_epu8(lanesA, zero), _mm256_sad_epu8(lanesB, zero));
+            const __m128i folded = _mm_add_epi64(_mm256_castsi256_si128(sums), _mm256_extracti128_si256(sums, 1));
+            count += static_cast<size_t>(_mm_cvtsi128_si64(folded)) +
+                     static_cast<size_t>(_mm_cvtsi128_si64(_mm_unpackhi_epi64(folded, folded)));
+        }
+
+        return count + countSse2(data + i, size - i);
+    }
+
+    /**
+     * @brief Locate the n-th line feed 32 bytes at a time with AVX2.
+     * @param data The start of the range.
+     * @param size The size of the range in bytes.
+     * @param n The one-based line feed index.
+     * @return The offset of the line feed, or size if not found.
+     */
+    __attribute__((target("avx2,popcnt")))
+    static size_t findAvx2(const char* data, size_t size, size_t n) noexcept {
+        const __m256i newline = _mm256_set1_epi8('\n');
+        size_t i{0};
+
+        for (; size - i >= 32; i += 32) {
+            const __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+            const uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(bytes, newline)));
+            const size_t found = static_cast<size_t>(__builtin_popcount(mask));
+            if (n <= found) {
+                return i + nthSetBit(mask, n);
+            }
+            n -= found;
+        }
+
+        return i + findSse2(data + i, size - i, n);
+    }
+
+#elif DRITE_CPU_NEON
+
+    /**
+     * @brief Count line feeds 16 bytes at a time with NEON.
+     * @param data The start of the range.
+     * @param size The size of the range in bytes.
+     * @return The number of line feeds.
+     */
+    static size_t countNeon(const char* data, size_t size) noexcept {
+        const uint8x16_t newline = vdupq_n_u8('\n');
+        size_t count{0};
+        size_t i{0};
+
+        while (size - i >= 16) {
+            uint8x16_t lanes = vdupq_n_u8(0);
+            const size_t blocks = std::min<size_t>((size - i) / 16, 255);
+            for (size_t block = 0; block < blocks; ++block, i += 16) {
+                const uint8x16_t bytes = vld1q_u8(reinterpret_cast<const uint8_t*>(data + i));
+                lanes = vsubq_u8(lanes, vceqq_u8(bytes, newline));
+            }
+            count += vaddlvq_u8(lanes);
+        }
+
+        return count + countScalar(data + i, size - i);
+    }
+
+    /**
+     * @brief Locate the n-th line feed 16 bytes at a time with NEON.
+     * @param data The start of the range.
+     * @param size The size of the range in bytes.
+     * @param n The one-based line feed index.
+     * @return The offset of the line feed, or size if not found.
+     */
+    static size_t findNeon(const char* data, size_t size, size_t n) noexcept {
+        const uint8x16_t newline = vdupq_n_u8('\n');
+        size_t i{0};
+
+        for (; size - i >= 16; i += 16) {
+            const uint8x16_t bytes = vld1q_u8(reinterpret_cast<const uint8_t*>(data + i));
+            const uint8x16_t matches = vceqq_u8(bytes, newline);
+
+            // Narrow each byte lane to a nibble to get a 64-bit mask
+            const uint8x8_t narrowed = vshrn_n_u16(vreinterpretq_u16_u8(matches), 4);
+            const uint64_t mask = vget_lane_u64(vreinterpret_u64_u8(narrowed), 0) & 0x8888888888888888ull;
+            const size_t found = static_cast<size_t>(__builtin_popcountll(mask));
+            if (n <= found) {
+                return i + nthSetBit(mask, n) / 4;
+            }
+            n -= found;
+        }
+
+        return i + findScalar(data + i, size - i, n);
+    }
+
+#endif
+
+    /**
+     * @brief Pick the widest kernels the running CPU supports.
+     * @param cpu The features of the running CPU.
+     * @return The selected kernels.
+     */
+    static ScannerKernels selectKernels([[maybe_unused]] const CpuFeatures& cpu) noexcept {
+#if DRITE_CPU_X86
+        if (cpu.avx2 && cpu.popcnt) {
+            return ScannerKernels{countAvx2, findAvx2, "avx2"};
+        }
+        return ScannerKernels{countSse2, findSse2, "sse2"};
+#elif DRITE_CPU_NEON
+        return ScannerKernels{countNeon, findNeon, "neon"};
+#else
+        return ScannerKernels{countScalar, findScalar, "scalar"};
+#endif
+    }
+
+    /**
+     * @brief Get the kernels selected for this process.
+     * @return The selected kernels.
+     */
+    static const ScannerKernels& getKernels() noexcept {
+        return getKernelTable(selectKernels);
+    }
+
+    /**
+     * @brief Count the line feeds in a byte range.
+     * @param data The start of the range.
+     * @param size The size of the range in bytes.
+     * @return The number of '\n' bytes in the range.
+     */
+    size_t countLineFeeds(const char* data, size_t size) noexcept {
+        return getKernels().count(data, size);
+    }
+
+    /**
+     * @brief Locate the n-th line feed in a byte range.
+     * @param data The start of the range.
+     * @param size The size of the range in bytes.
+     * @param n The one-based index of the line feed to find.
+     * @return The offset of the n-th '\n', or size if the range holds fewer than n.
+     */
+    size_t findLineFeed(const char* data, size_t size, size_t n) noexcept {
+        if (n == 0) {
+            return size;
+        }
+        return getKernels().find(data, size, n);
+    }
+
+    /**
+     * @brief Get the name of the scanning kernel selected for this CPU.
+     * @return The kernel name, e.g. "avx2".
+     */
+    const char* getNewlineScannerName() noexcept {
+        return getKernels().name;
+    }
+
+}
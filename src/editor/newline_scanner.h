@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstddef>
+
+namespace drite {
+
+    /**
+     * @brief Count the line feeds in a byte range.
+     *
+     * Uses the widest vector kernel supported by the running CPU (AVX2 or SSE2 on
+     * x86-64, NEON on ARM64), falling back to a scalar loop elsewhere. "\r\n" line
+     * endings are counted once, through their line feed.
+     *
+     * @param data The start of the range.
+     * @param size The size of the range in bytes.
+     * @return The number of '\n' bytes in the range.
+     */
+    [[nodiscard]] size_t countLineFeeds(const char* data, size_t size) noexcept;
+
+    /**
+     * @brief Locate the n-th line feed in a byte range.
+     * @param data The start of the range.
+     * @param size The size of the range in bytes.
+     * @param n The one-based index of the line feed to find.
+     * @return The offset of the n-th '\n', or size if the range holds fewer than n.
+     */
+    [[nodiscard]] size_t findLineFeed(const char* data, size_t size, size_t n) noexcept;
+
+    /**
+     * @brief Get the name of the scanning kernel selected for this CPU.
+     * @return The kernel name, e.g. "avx2".
+     */
+    [[nodiscard]] const char* getNewlineScannerName() noexcept;
+
+}
@@ -0,0 +1,1074 @@
+#include "editor/text_buffer.h"
+#include <algorithm>
+#include <array>
+#include <memory_resource>
+#include <utility>
+
+namespace drite {
+
+    /**
+     * @brief Bytes of external storage indexed per step when a buffer is created.
+     */
+    static constexpr size_t IndexStep = size_t{4} << 20;
+
+    /**
+     * @brief Tree depth visitChunks() keeps on the stack before its path spills to the heap.
+     */
+    static constexpr size_t VisitStackDepth = 128;
+
+    /**
+     * @brief Extend this change with a later one.
+     * @param later A change made after this one, in the numbering that followed this change.
+     */
+    void LineChange::merge(const LineChange& later) noexcept {
+        // Map the end of this change through the later edit, which replaced
+        // lines [first, first + removed] with [first, last]
+        const size_t removedEnd = static_cast<size_t>(static_cast<ptrdiff_t>(later.lastLine) - later.lineDelta);
+        size_t mappedLast = lastLine;
+        if (lastLine > removedEnd) {
+            mappedLast = static_cast<size_t>(static_cast<ptrdiff_t>(lastLine) + later.lineDelta);
+        } else if (lastLine >= later.firstLine) {
+            mappedLast = later.lastLine;
+        }
+
+        firstLine = std::min(firstLine, later.firstLine);
+        lastLine = std::max(mappedLast, later.lastLine);
+        lineDelta += later.lineDelta;
+    }
+
+    /**
+     * @brief Construct an empty TextBuffer.
+     */
+    TextBuffer::TextBuffer() : TextBuffer(std::string()) {}
+
+    /**
+     * @brief Construct a TextBuffer whose original buffer holds the given text.
+     * @param text The initial document contents.
+     */
+    TextBuffer::TextBuffer(std::string text) {
+        Buffer original;
+        *original.owned = std::move(text);
+        initialize(std::move(original));
+    }
+
+    /**
+     * @brief Construct a TextBuffer using external storage as its original buffer.
+     * @param storage The storage holding the initial document contents.
+     */
+    TextBuffer::TextBuffer(std::shared_ptr<const TextStorage> storage) {
+        Buffer original;
+        original.external = std::move(storage);
+        initialize(std::move(original));
+    }
+
+    /**
+     * @brief Construct a TextBuffer over external storage with a line index saved from an earlier buffer over it.
+     * @param storage The storage holding the initial document contents.
+     * @param lineIndex The index of the storage, from getOriginalLineIndex().
+     */
+    TextBuffer::TextBuffer(std::shared_ptr<const TextStorage> storage, LineIndex lineIndex) {
+        Buffer original;
+        original.external = std::move(storage);
+        if (lineIndex.isConsistent(original.text().size())) {
+            original.lineIndex = std::move(lineIndex);
+        }
+        initialize(std::move(original));
+    }
+
+    /**
+     * @brief Destroy the TextBuffer object.
+     */
+    TextBuffer::~TextBuffer() = default;
+
+    TextBuffer::TextBuffer(TextBuffer&&) noexcept = default;
+    TextBuffer& TextBuffer::operator=(TextBuffer&&) noexcept = default;
+
+    /**
+     * @brief Insert text at the given byte offset.
+     * @param offset The byte offset to insert at, clamped to the document size.
+     * @param text The text to insert.
+     */
+    void TextBuffer::insert(size_t offset, std::string_view text) {
+        if (text.empty()) {
+            return;
+        }
+
+        offset = std::min(offset, getSize());
+        const size_t line = offsetToPosition(offset).line;
+        const size_t lineFeeds = lineFeedsOf(m_root);
+
+        // Consecutive typing lands at the end of the previous insertion, so grow
+        // that piece instead of adding a node per keystroke
+        if (!tryExtendLastInsert(offset, text)) {
+            const Piece piece = appendToAddBlock(text);
+
+            uint32_t left{0}, right{0};
+            split(m_root, offset, left, right);
+            m_root = merge(merge(left, allocateNode(piece)), right);
+        }
+
+        noteEdit(line, 0, lineFeedsOf(m_root) - lineFeeds);
+    }
+
+    /**
+     * @brief Erase a range of bytes from the document.
+     * @param offset The byte offset of the first byte to erase.
+     * @param length The number of bytes to erase, clamped to the document end.
+     */
+    void TextBuffer::erase(size_t offset, size_t length) {
+        const size_t size = getSize();
+        if (offset >= size || length == 0) {
+            return;
+        }
+        length = std::min(length, size - offset);
+        const size_t line = offsetToPosition(offset).line;
+
+        uint32_t left{0}, middle{0}, right{0};
+        split(m_root, offset, left, right);
+        split(right, length, middle, right);
+        const size_t removedLineFeeds = lineFeedsOf(middle);
+        freeSubtree(middle);
+        m_root = merge(left, right);
+
+        noteEdit(line, removedLineFeeds, 0);
+    }
+
+    /**
+     * @brief Get the pieces describing a range of the document.
+     * @param offset The byte offset of the range.
+     * @param length The length of the range in bytes.
+     * @return The pieces in document order.
+     */
+    std::vector<Piece> TextBuffer::getPieces(size_t offset, size_t length) const {
+        std::vector<Piece> pieces;
+        const size_t size = getSize();
+        if (offset >= size || length == 0) {
+            return pieces;
+        }
+        const size_t end = offset + std::min(length, size - offset);
+
+        // In-order walk that skips subtrees lying entirely outside the range
+        struct Frame {
+            uint32_t node;
+            size_t position;
+        };
+        std::vector<Frame> stack;
+        uint32_t node = m_root;
+        size_t position{0};
+        while (node || !stack.empty()) {
+            while (node) {
+                const Node& n = m_nodes[node];
+                const size_t leftLength = lengthOf(n.left);
+                if (offset >= position + leftLength) {
+                    // The whole left subtree precedes the range
+                    stack.push_back(Frame{node, position + leftLength});
+                    node = 0;
+                } else {
+                    stack.push_back(Frame{node, position + leftLength});
+                    node = n.left;
+                }
+            }
+
+            const Frame frame = stack.back();
+            stack.pop_back();
+            if (frame.position >= end) {
+                break;
+            }
+
+            const Node& n = m_nodes[frame.node];
+            const size_t pieceEnd = frame.position + n.piece.length;
+            if (pieceEnd > offset) {
+                Piece piece = n.piece;
+                const size_t trimStart = offset > frame.position ? offset - frame.position : 0;
+                const size_t trimEnd = pieceEnd > end ? pieceEnd - end : 0;
+                if (trimStart > 0 || trimEnd > 0) {
+                    piece.start += trimStart;
+                    piece.length -= trimStart + trimEnd;
+                    piece.lineFeeds = countLineFeeds(piece.buffer, piece.start, piece.start + piece.length);
+                }
+                pieces.push_back(piece);
+            }
+
+            node = n.right;
+            position = pieceEnd;
+        }
+
+        return pieces;
+    }
+
+    /**
+     * @brief Insert previously obtained pieces at the given byte offset without copying text.
+     * @param offset The byte offset to insert at, clamped to the document size.
+     * @param pieces Pieces returned by getPieces() on this buffer.
+     */
+    void TextBuffer::insertPieces(size_t offset, std::span<const Piece> pieces) {
+        offset = std::min(offset, getSize());
+
+        uint32_t inserted{0};
+        for (const Piece& piece : pieces) {
+            if (piece.length > 0) {
+                inserted = merge(inserted, allocateNode(piece));
+            }
+        }
+        if (!inserted) {
+            return;
+        }
+
+        const size_t line = offsetToPosition(offset).line;
+        const size_t insertedLineFeeds = lineFeedsOf(inserted);
+        uint32_t left{0}, right{0};
+        split(m_root, offset, left, right);
+        m_root = merge(merge(left, inserted), right);
+
+        noteEdit(line, 0, insertedLineFeeds);
+    }
+
+    /**
+     * @brief Replace several ranges of the document in one pass over the piece tree.
+     *
+     * The part of the tree not yet reached is split off at each edit, so
+     * every split and merge works on the edge between the edited text and
+     * the rest instead of starting from the root.
+     *
+     * @param edits The edits, sorted by offset and not overlapping, with
+     * offsets into the document as it was before any of them.
+     * @param removed If not null, receives the pieces each edit removed, for undoing the batch.
+     */
+    void TextBuffer::replacePieces(std::span<const PieceEdit> edits, RemovedPieces* removed) {
+        if (edits.empty()) {
+            return;
+        }
+
+        // The text after the last edit is unchanged, so its length locates
+        // the end of the change in the new document
+        const size_t size = getSize();
+        const size_t lineFeeds = lineFeedsOf(m_root);
+        const size_t firstLine = offsetToPosition(edits.front().offset).line;
+        const size_t lastOffset = std::min(edits.back().offset, size);
+        const size_t unchangedTail = size - lastOffset - std::min(edits.back().length, size - lastOffset);
+
+        // `rest` holds the document from `consumed` on, `done` everything
+        // before it with the edits applied
+        uint32_t done{0};
+        uint32_t rest = m_root;
+        size_t consumed{0};
+        for (const PieceEdit& edit : edits) {
+            const size_t offset = std::clamp(edit.offset, consumed, size);
+            const size_t length = std::min(edit.length, size - offset);
+
+            uint32_t kept{0}, cut{0};
+            split(rest, offset - consumed, kept, rest);
+            split(rest, length, cut, rest);
+            done = merge(done, kept);
+            if (removed) {
+                collectPieces(cut, removed->pieces);
+                removed->ends.push_back(removed->pieces.size());
+            }
+            freeSubtree(cut);
+
+            for (const Piece& piece : edit.pieces) {
+                if (piece.length > 0) {
+                    done = merge(done, allocateNode(piece));
+                }
+            }
+            consumed = offset + length;
+        }
+        m_root = merge(done, rest);
+
+        LineChange change;
+        change.firstLine = firstLine;
+        change.lastLine = offsetToPosition(getSize() - unchangedTail).line;
+        change.lineDelta = static_cast<ptrdiff_t>(lineFeedsOf(m_root)) - static_cast<ptrdiff_t>(lineFeeds);
+        noteEdit(change);
+    }
+
+    /**
+     * @brief Get the text of every add block, for saving the buffer.
+     * @return The add blocks, oldest first.
+     */
+    std::vector<std::string_view> TextBuffer::getAddBlocks() const {
+        std::vector<std::string_view> blocks;
+        blocks.reserve(m_buffers.size() - 1);
+        for (size_t block = 1; block < m_buffers.size(); ++block) {
+            blocks.push_back(m_buffers[block].text());
+        }
+        return blocks;
+    }
+
+    /**
+     * @brief Share the text the buffer owns, so views of it can outlive the buffer.
+     * @return The original text if the buffer owns it, then every add block.
+     */
+    std::vector<std::shared_ptr<const std::string>> TextBuffer::shareOwnedText() const {
+        std::vector<std::shared_ptr<const std::string>> owners;
+        owners.reserve(m_buffers.size());
+        for (const Buffer& buffer : m_buffers) {
+            if (!buffer.external) {
+                owners.push_back(buffer.owned);
+            }
+        }
+        return owners;
+    }
+
+    /**
+     * @brief Check whether a piece references text inside one of the backing buffers.
+     * @param piece The piece.
+     * @return True if the piece can be inserted into this buffer.
+     */
+    bool TextBuffer::isValidPiece(const Piece& piece) const noexcept {
+        if (piece.buffer >= m_buffers.size()) {
+            return false;
+        }
+        const size_t size = m_buffers[piece.buffer].text().size();
+        return piece.start <= size && piece.length <= size - piece.start && piece.lineFeeds <= piece.length;
+    }
+
+    /**
+     * @brief Rebuild the edits of an earlier buffer over the same original text.
+     *
+     * Piece line feed counts are taken as given rather than recounted, so
+     * the original text is not read.
+     *
+     * @param addBlocks The text of each add block, from getAddBlocks().
+     * @param pieces The pieces of the whole document in order, from getPieces().
+     * @return True if restored; false if the buffer was already edited or a piece is out of range, leaving it unchanged.
+     */
+    bool TextBuffer::restorePieces(std::span<const std::string_view> addBlocks, std::span<const Piece> pieces) {
+        if (m_buffers.size() != 1 || m_revision != 0) {
+            return false;
+        }
+
+        for (const std::string_view text : addBlocks) {
+            Buffer block;
+            block.capacity = std::max(AddBlockSize, text.size());
+            block.owned->reserve(block.capacity);
+            block.owned->assign(text);
+            block.lineIndex.update(block.text());
+            m_buffers.push_back(std::move(block));
+        }
+        if (!std::ranges::all_of(pieces, [this](const Piece& piece) { return isValidPiece(piece); })) {
+            m_buffers.resize(1);
+            return false;
+        }
+
+        freeSubtree(m_root);
+        m_root = 0;
+        for (const Piece& piece : pieces) {
+            if (piece.length > 0) {
+                m_root = merge(m_root, allocateNode(piece));
+            }
+        }
+        return true;
+    }
+
+    /**
+     * @brief Take the lines changed since the last call.
+     * @return The accumulated change, or std::nullopt if nothing changed.
+     */
+    std::optional<LineChange> TextBuffer::takeLineChange() noexcept {
+        return std::exchange(m_lineChange, std::nullopt);
+    }
+
+    /**
+     * @brief Get the size of the document in bytes.
+     * @return The document size in bytes.
+     */
+    size_t TextBuffer::getSize() const noexcept {
+        return lengthOf(m_root);
+    }
+
+    /**
+     * @brief Get the number of lines in the document (line feeds + 1).
+     * @return The number of lines.
+     */
+    size_t TextBuffer::getLineCount() const noexcept {
+        return lineFeedsOf(m_root) + 1;
+    }
+
+    /**
+     * @brief Get the number of nodes on the longest path from the root of the piece tree to a leaf.
+     * @return The tree depth, 0 for an empty document.
+     */
+    size_t TextBuffer::getTreeDepth() const {
+        size_t depth{0};
+        std::vector<std::pair<uint32_t, size_t>> pending;
+        if (m_root) {
+            pending.emplace_back(m_root, 1);
+        }
+        while (!pending.empty()) {
+            const auto [node, level] = pending.back();
+            pending.pop_back();
+            depth = std::max(depth, level);
+            if (m_nodes[node].left) {
+                pending.emplace_back(m_nodes[node].left, level + 1);
+            }
+            if (m_nodes[node].right) {
+                pending.emplace_back(m_nodes[node].right, level + 1);
+            }
+        }
+        return depth;
+    }
+
+    /**
+     * @brief Get the byte at the given offset.
+     * @param offset The byte offset, must be less than getSize().
+     * @return The byte at the offset.
+     */
+    char TextBuffer::getChar(size_t offset) const {
+        uint32_t node = m_root;
+        while (node) {
+            const Node& n = m_nodes[node];
+            const size_t leftLength = lengthOf(n.left);
+            if (offset < leftLength) {
+                node = n.left;
+                continue;
+            }
+            offset -= leftLength;
+            if (offset < n.piece.length) {
+                return m_buffers[n.piece.buffer].text()[n.piece.start + offset];
+            }
+            offset -= n.piece.length;
+            node = n.right;
+        }
+        return '\0';
+    }
+
+    /**
+     * @brief Copy a range of the document into a string.
+     * @param offset The byte offset of the range.
+     * @param length The length of the range in bytes.
+     * @return The text of the range.
+     */
+    std::string TextBuffer::getText(size_t offset, size_t length) const {
+        std::string result;
+        const size_t size = getSize();
+        if (offset >= size) {
+            return result;
+        }
+        length = std::min(length, size - offset);
+        result.reserve(length);
+
+        visitChunks(offset, length, [&result](std::string_view chunk) {
+            result.append(chunk);
+            return true;
+        });
+        return result;
+    }
+
+    /**
+     * @brief Copy a range of the document into a string, reusing its storage.
+     * @param offset The byte offset of the range.
+     * @param length The length of the range in bytes.
+     * @param text Receives the text of the range.
+     */
+    void TextBuffer::getText(size_t offset, size_t length, std::pmr::string& text) const {
+        text.clear();
+        const size_t size = getSize();
+        if (offset >= size) {
+            return;
+        }
+        length = std::min(length, size - offset);
+        text.reserve(length);
+
+        visitChunks(offset, length, [&text](std::string_view chunk) {
+            text.append(chunk);
+            return true;
+        });
+    }
+
+    /**
+     * @brief Copy the whole document into a string.
+     * @return The document text.
+     */
+    std::string TextBuffer::getText() const {
+        return getText(0, getSize());
+    }
+
+    /**
+     * @brief Get the text of a line, without its line terminator.
+     * @param line The zero-based line number.
+     * @return The line text.
+     */
+    std::string TextBuffer::getLine(size_t line) const {
+        if (line >= getLineCount()) {
+            return {};
+        }
+        return getText(getLineStart(line), getLineLength(line));
+    }
+
+    /**
+     * @brief Visit the document text in the range as a sequence of chunks.
+     * @param offset The byte offset of the range.
+     * @param length The length of the range in bytes.
+     * @param visitor Callback invoked with each chunk in document order.
+     */
+    void TextBuffer::visitChunks(size_t offset, size_t length, const ChunkVisitor& visitor) const {
+        const size_t size = getSize();
+        if (offset >= size || length == 0) {
+            return;
+        }
+        const size_t end = offset + std::min(length, size - offset);
+
+        // Walk down to the piece containing the start offset, remembering the
+        // ancestors whose piece and right subtree still have to be visited;
+        // the path of a balanced tree fits in a local buffer, so reading a
+        // line does not touch the heap
+        std::array<std::byte, VisitStackDepth * sizeof(uint32_t)> storage;
+        std::pmr::monotonic_buffer_resource memory(storage.data(), storage.size());
+        std::pmr::vector<uint32_t> stack(&memory);
+        stack.reserve(VisitStackDepth);
+        size_t position{0};
+        uint32_t node = m_root;
+        while (node) {
+            const Node& n = m_nodes[node];
+            const size_t leftLength = lengthOf(n.left);
+            if (offset < position + leftLength) {
+                stack.push_back(node);
+                node = n.left;
+            } else if (offset < position + leftLength + n.piece.length) {
+                stack.push_back(node);
+                position += leftLength;
+                break;
+            } else {
+                position += leftLength + n.piece.length;
+                node = n.right;
+            }
+        }
+
+        // In-order iteration from the starting piece; `position` tracks the
+        // document offset of the piece on top of the stack
+        while (!stack.empty() && position < end) {
+            const uint32_t current = stack.back();
+            stack.pop_back();
+            const Node& n = m_nodes[current];
+
+            const std::string_view text = pieceText(n.piece);
+            const size_t from = offset > position ? offset - position : 0;
+            const size_t to = std::min(n.piece.length, end - position);
+            if (from < to) {
+                touchPiece(n.piece, from, to - from);
+                if (!visitor(text.substr(from, to - from))) {
+                    return;
+                }
+            }
+            position += n.piece.length;
+
+            // Push the leftmost path of the right subtree
+            uint32_t next = n.right;
+            while (next) {
+                stack.push_back(next);
+                next = m_nodes[next].left;
+            }
+        }
+    }
+
+    /**
+     * @brief Convert a byte offset to a line/column position.
+     * @param offset The byte offset, clamped to the document size.
+     * @return The position of the offset.
+     */
+    TextPosition TextBuffer::offsetToPosition(size_t offset) const {
+        offset = std::min(offset, getSize());
+
+        size_t line{0};
+        size_t remaining = offset;
+        uint32_t node = m_root;
+        while (node) {
+            const Node& n = m_nodes[node];
+            const size_t leftLength = lengthOf(n.left);
+            if (remaining <= leftLength) {
+                node = n.left;
+                continue;
+            }
+            line += lineFeedsOf(n.left);
+            remaining -= leftLength;
+            if (remaining <= n.piece.length) {
+                line += countLineFeeds(n.piece.buffer, n.piece.start, n.piece.start + remaining);
+                break;
+            }
+            line += n.piece.lineFeeds;
+            remaining -= n.piece.length;
+            node = n.right;
+        }
+
+        return TextPosition(line, offset - getLineStart(line));
+    }
+
+    /**
+     * @brief Convert a line/column position to a byte offset.
+     * @param position The position, clamped to the document.
+     * @return The byte offset of the position.
+     */
+    size_t TextBuffer::positionToOffset(const TextPosition& position) const {
+        const size_t line = std::min(position.line, getLineCount() - 1);
+        return getLineStart(line) + std::min(position.column, getLineLength(line));
+    }
+
+    /**
+     * @brief Get the byte offset of the first character of a line.
+     * @param line The zero-based line number, clamped to the last line.
+     * @return The byte offset of the line start.
+     */
+    size_t TextBuffer::getLineStart(size_t line) const {
+        line = std::min(line, getLineCount() - 1);
+        if (line == 0) {
+            return 0;
+        }
+
+        size_t remaining = line;
+        size_t offset{0};
+        uint32_t node = m_root;
+        while (node) {
+            const Node& n = m_nodes[node];
+            const size_t leftLineFeeds = lineFeedsOf(n.left);
+            if (remaining <= leftLineFeeds) {
+                node = n.left;
+                continue;
+            }
+            remaining -= leftLineFeeds;
+            offset += lengthOf(n.left);
+            if (remaining <= n.piece.lineFeeds) {
+                return offset + offsetAfterLineFeed(n.piece, remaining);
+            }
+            remaining -= n.piece.lineFeeds;
+            offset += n.piece.length;
+            node = n.right;
+        }
+        return offset;
+    }
+
+    /**
+     * @brief Get the length of a line in bytes, excluding its "\n" or "\r\n" terminator.
+     * @param line The zero-based line number.
+     * @return The line length in bytes.
+     */
+    size_t TextBuffer::getLineLength(size_t line) const {
+        const size_t lineCount = getLineCount();
+        if (line >= lineCount) {
+            return 0;
+        }
+        const size_t start = getLineStart(line);
+        if (line + 1 >= lineCount) {
+            return getSize() - start;
+        }
+
+        size_t end = getLineStart(line + 1) - 1;
+        if (end > start && getChar(end - 1) == '\r') {
+            --end;
+        }
+        return end - start;
+    }
+
+    /**
+     * @brief Index the original buffer and build the tree describing it.
+     * @param original The original buffer.
+     */
+    void TextBuffer::initialize(Buffer original) {
+        m_nodes.emplace_back();
+
+        original.capacity = original.text().size();
+
+        // External storage is indexed a step at a time, so paged storage never
+        // needs all of it in memory at once; a restored index is already complete
+        const std::string_view text = original.text();
+        for (size_t indexed = original.lineIndex.getIndexedSize(); indexed < text.size();) {
+            const size_t step = std::min(IndexStep, text.size() - indexed);
+            if (original.external) {
+                original.external->touch(indexed, step);
+            }
+            indexed += step;
+            original.lineIndex.update(text.substr(0, indexed));
+        }
+        m_buffers.push_back(std::move(original));
+
+        if (m_buffers[0].capacity == 0) {
+            return;
+        }
+
+        Piece piece;
+        piece.buffer = 0;
+        piece.start = 0;
+        piece.length = m_buffers[0].capacity;
+        piece.lineFeeds = m_buffers[0].lineIndex.getLineFeedCount();
+        m_root = allocateNode(piece);
+    }
+
+    /**
+     * @brief Append text to the add blocks, producing the piece that references it.
+     *
+     * Blocks are never reallocated once created; text that does not fit into the
+     * current block goes into a new block sized for it.
+     *
+     * @param text The text to append.
+     * @return The piece referencing the appended text.
+     */
+    Piece TextBuffer::appendToAddBlock(std::string_view text) {
+        if (m_buffers.size() == 1 || m_buffers.back().capacity - m_buffers.back().owned->size() < text.size()) {
+            Buffer block;
+            block.capacity = std::max(AddBlockSize, text.size());
+            block.owned->reserve(block.capacity);
+            m_buffers.push_back(std::move(block));
+        }
+
+        Buffer& block = m_buffers.back();
+        const size_t start = block.owned->size();
+        block.owned->append(text);
+        const size_t previousLineFeeds = block.lineIndex.getLineFeedCount();
+        block.lineIndex.update(block.text());
+
+        Piece piece;
+        piece.buffer = static_cast<uint32_t>(m_buffers.size() - 1);
+        piece.start = start;
+        piece.length = text.size();
+        piece.lineFeeds = block.lineIndex.getLineFeedCount() - previousLineFeeds;
+        return piece;
+    }
+
+    /**
+     * @brief Try to extend the piece ending at the given offset in place.
+     *
+     * Succeeds when that piece ends exactly at the tail of the newest add block
+     * and the block still has room for the text.
+     *
+     * @param offset The document offset the text is inserted at.
+     * @param text The text being inserted.
+     * @return True if the text was absorbed into an existing piece.
+     */
+    bool TextBuffer::tryExtendLastInsert(size_t offset, std::string_view text) {
+        if (offset == 0 || m_buffers.size() == 1) {
+            return false;
+        }
+
+        const uint32_t blockIndex = static_cast<uint32_t>(m_buffers.size() - 1);
+        Buffer& block = m_buffers[blockIndex];
+        if (block.capacity - block.owned->size() < text.size()) {
+            return false;
+        }
+
+        // Find the piece containing offset - 1, remembering the path for the
+        // aggregate update
+        m_path.clear();
+        size_t remaining = offset - 1;
+        uint32_t node = m_root;
+        while (node) {
+            m_path.push_back(node);
+            const Node& n = m_nodes[node];
+            const size_t leftLength = lengthOf(n.left);
+            if (remaining < leftLength) {
+                node = n.left;
+                continue;
+            }
+            remaining -= leftLength;
+            if (remaining < n.piece.length) {
+                break;
+            }
+            remaining -= n.piece.length;
+            node = n.right;
+        }
+
+        if (!node) {
+            return false;
+        }
+
+        Piece& piece = m_nodes[node].piece;
+        if (piece.buffer != blockIndex || remaining + 1 != piece.length ||
+            piece.start + piece.length != block.owned->size()) {
+            return false;
+        }
+
+        const size_t previousLineFeeds = block.lineIndex.getLineFeedCount();
+        block.owned->append(text);
+        block.lineIndex.update(block.text());
+
+        piece.length += text.size();
+        piece.lineFeeds += block.lineIndex.getLineFeedCount() - previousLineFeeds;
+
+        for (auto it = m_path.rbegin(); it != m_path.rend(); ++it) {
+            update(*it);
+        }
+        return true;
+    }
+
+    /**
+     * @brief Count line feeds in a range of a backing buffer.
+     * @param buffer The backing buffer index.
+     * @param start The start offset within the buffer.
+     * @param end The end offset within the buffer.
+     * @return The number of line feeds in [start, end).
+     */
+    size_t TextBuffer::countLineFeeds(uint32_t buffer, size_t start, size_t end) const {
+        const Buffer& source = m_buffers[buffer];
+        return source.lineIndex.countLineFeeds(source.text(), start, end);
+    }
+
+    /**
+     * @brief Find the offset just past the n-th line feed of a piece.
+     * @param piece The piece to search.
+     * @param n The one-based line feed index within the piece.
+     * @return The offset within the piece just after that line feed.
+     */
+    size_t TextBuffer::offsetAfterLineFeed(const Piece& piece, size_t n) const {
+        const Buffer& source = m_buffers[piece.buffer];
+        return source.lineIndex.findLineFeed(source.text(), piece.start, n) + 1 - piece.start;
+    }
+
+    /**
+     * @brief Get a view of the text referenced by a piece.
+     * @param piece The piece.
+     * @return The piece text.
+     */
+    std::string_view TextBuffer::pieceText(const Piece& piece) const {
+        return m_buffers[piece.buffer].text().substr(piece.start, piece.length);
+    }
+
+    /**
+     * @brief Tell external storage that part of a piece is about to be read.
+     * @param piece The piece.
+     * @param from The offset of the part within the piece.
+     * @param length The length of the part in bytes.
+     */
+    void TextBuffer::touchPiece(const Piece& piece, size_t from, size_t length) const noexcept {
+        if (const TextStorage* storage = m_buffers[piece.buffer].external.get()) {
+            storage->touch(piece.start + from, length);
+        }
+    }
+
+    /**
+     * @brief Allocate a tree node for a piece, reusing released nodes when possible.
+     * @param piece The piece the node holds.
+     * @return The node index.
+     */
+    uint32_t TextBuffer::allocateNode(const Piece& piece) {
+        uint32_t index;
+        if (!m_freeNodes.empty()) {
+            index = m_freeNodes.back();
+            m_freeNodes.pop_back();
+        } else {
+            index = static_cast<uint32_t>(m_nodes.size());
+            m_nodes.emplace_back();
+        }
+
+        Node& node = m_nodes[index];
+        node.piece = piece;
+        node.priority = nextPriority();
+        node.left = 0;
+        node.right = 0;
+        update(index);
+        ++m_pieceCount;
+        return index;
+    }
+
+    /**
+     * @brief Append the pieces of a subtree to a vector in document order.
+     * @param node The subtree root.
+     * @param pieces The vector.
+     */
+    void TextBuffer::collectPieces(uint32_t node, std::vector<Piece>& pieces) const {
+        std::vector<uint32_t> stack;
+        while (node || !stack.empty()) {
+            while (node) {
+                stack.push_back(node);
+                node = m_nodes[node].left;
+            }
+            node = stack.back();
+            stack.pop_back();
+            pieces.push_back(m_nodes[node].piece);
+            node = m_nodes[node].right;
+        }
+    }
+
+    /**
+     * @brief Release every node of a subtree back to the pool.
+     * @param node The subtree root.
+     */
+    void TextBuffer::freeSubtree(uint32_t node) {
+        if (!node) {
+            return;
+        }
+
+        std::vector<uint32_t> pending{node};
+        while (!pending.empty()) {
+            const uint32_t current = pending.back();
+            pending.pop_back();
+            if (m_nodes[current].left) {
+                pending.push_back(m_nodes[current].left);
+            }
+            if (m_nodes[current].right) {
+                pending.push_back(m_nodes[current].right);
+            }
+            m_freeNodes.push_back(current);
+            --m_pieceCount;
+        }
+    }
+
+    /**
+     * @brief Recompute the subtree aggregates of a node from its children.
+     * @param node The node index.
+     */
+    void TextBuffer::update(uint32_t node) {
+        Node& n = m_nodes[node];
+        n.subtreeLength = lengthOf(n.left) + n.piece.length + lengthOf(n.right);
+        n.subtreeLineFeeds = lineFeedsOf(n.left) + n.piece.lineFeeds + lineFeedsOf(n.right);
+    }
+
+    /**
+     * @brief Merge two treaps where every offset of the left precedes the right.
+     * @param left The left treap root.
+     * @param right The right treap root.
+     * @return The merged treap root.
+     */
+    uint32_t TextBuffer::merge(uint32_t left, uint32_t right) {
+        if (!left) {
+            return right;
+        }
+        if (!right) {
+            return left;
+        }
+
+        if (m_nodes[left].priority > m_nodes[right].priority) {
+            const uint32_t merged = merge(m_nodes[left].right, right);
+            m_nodes[left].right = merged;
+            update(left);
+            return left;
+        }
+
+        const uint32_t merged = merge(left, m_nodes[right].left);
+        m_nodes[right].left = merged;
+        update(right);
+        return right;
+    }
+
+    /**
+     * @brief Split a treap so the left part holds exactly the first `offset` bytes.
+     *
+     * A piece straddling the split offset is cut in two.
+     *
+     * @param node The treap root.
+     * @param offset The byte offset to split at.
+     * @param left Receives the root of the first `offset` bytes.
+     * @param right Receives the root of the remaining bytes.
+     */
+    void TextBuffer::split(uint32_t node, size_t offset, uint32_t& left, uint32_t& right) {
+        if (!node) {
+            left = 0;
+            right = 0;
+            return;
+        }
+
+        const size_t leftLength = lengthOf(m_nodes[node].left);
+        const size_t pieceLength = m_nodes[node].piece.length;
+
+        // The piece cut below may come back with a higher priority than this
+        // node; merging instead of attaching it keeps the heap order, without
+        // which repeated cuts of one piece degrade the tree into a list
+        if (offset <= leftLength) {
+            uint32_t subtreeRight{0};
+            split(m_nodes[node].left, offset, left, subtreeRight);
+            if (subtreeRight && m_nodes[subtreeRight].priority > m_nodes[node].priority) {
+                m_nodes[node].left = 0;
+                update(node);
+                right = merge(subtreeRight, node);
+            } else {
+                m_nodes[node].left = subtreeRight;
+                update(node);
+                right = node;
+            }
+            return;
+        }
+
+        if (offset >= leftLength + pieceLength) {
+            uint32_t subtreeLeft{0};
+            split(m_nodes[node].right, offset - leftLength - pieceLength, subtreeLeft, right);
+            if (subtreeLeft && m_nodes[subtreeLeft].priority > m_nodes[node].priority) {
+                m_nodes[node].right = 0;
+                update(node);
+                left = merge(node, subtreeLeft);
+            } else {
+                m_nodes[node].right = subtreeLeft;
+                update(node);
+                left = node;
+            }
+            return;
+        }
+
+        // The split point falls inside this node's piece
+        const size_t within = offset - leftLength;
+        const Piece original = m_nodes[node].piece;
+
+        Piece head = original;
+        head.length = within;
+        head.lineFeeds = countLineFeeds(original.buffer, original.start, original.start + within);
+
+        Piece tail = original;
+        tail.start = original.start + within;
+        tail.length = original.length - within;
+        tail.lineFeeds = original.lineFeeds - head.lineFeeds;
+
+        const uint32_t tailNode = allocateNode(tail);
+        const uint32_t oldRight = m_nodes[node].right;
+
+        m_nodes[node].piece = head;
+        m_nodes[node].right = 0;
+        update(node);
+
+        left = node;
+        right = merge(tailNode, oldRight);
+    }
+
+    /**
+     * @brief Generate the next pseudo-random treap priority.
+     * @return The priority.
+     */
+    uint32_t TextBuffer::nextPriority() {
+        m_randomState ^= m_randomState << 13;
+        m_randomState ^= m_randomState >> 17;
+        m_randomState ^= m_randomState << 5;
+        return m_randomState;
+    }
+
+    /**
+     * @brief Get the byte length of a subtree.
+     * @param node The subtree root, may be the null sentinel.
+     * @return The subtree length.
+     */
+    size_t TextBuffer::lengthOf(uint32_t node) const noexcept {
+        return node ? m_nodes[node].subtreeLength : 0;
+    }
+
+    /**
+     * @brief Get the line feed count of a subtree.
+     * @param node The subtree root, may be the null sentinel.
+     * @return The subtree line feed count.
+     */
+    size_t TextBuffer::lineFeedsOf(uint32_t node) const noexcept {
+        return node ? m_nodes[node].subtreeLineFeeds : 0;
+    }
+
+    /**
+     * @brief Record an edit in the revision and the pending line change.
+     * @param line The line the edit starts on.
+     * @param removedLineFeeds The number of line feeds the edit removed.
+     * @param insertedLineFeeds The number of line feeds the edit inserted.
+     */
+    void TextBuffer::noteEdit(size_t line, size_t removedLineFeeds, size_t insertedLineFeeds) noexcept {
+        LineChange change;
+        change.firstLine = line;
+        change.lastLine = line + insertedLineFeeds;
+        change.lineDelta = static_cast<ptrdiff_t>(insertedLineFeeds) - static_cast<ptrdiff_t>(removedLineFeeds);
+        noteEdit(change);
+    }
+
+    /**
+     * @brief Record an edit in the revision and the pending line change.
+     * @param change The lines the edit changed.
+     */
+    void TextBuffer::noteEdit(const LineChange& change) noexcept {
+        ++m_revision;
+        if (m_lineChange) {
+            m_lineChange->merge(change);
+        } else {
+            m_lineChange = change;
+        }
+    }
+
+}
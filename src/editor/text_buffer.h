@@ -0,0 +1,627 @@
+#pragma once
+
+#include "editor/line_index.h"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <memory_resource>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace drite {
+
+    /**
+     * @brief A zero-based line/column location inside a text buffer.
+     *
+     * Columns are measured in bytes from the start of the line.
+     */
+    struct TextPosition {
+        size_t line{0};
+        size_t column{0};
+
+        constexpr TextPosition() = default;
+        constexpr TextPosition(size_t line, size_t column)
+            : line(line), column(column) {}
+
+        constexpr bool operator==(const TextPosition&) const = default;
+    };
+
+    /**
+     * @brief Read-only storage that can back the original buffer of a TextBuffer
+     * without copying, such as a memory-mapped file.
+     */
+    class TextStorage {
+        public:
+            /**
+             * @brief Destroy the TextStorage object.
+             */
+            virtual ~TextStorage() = default;
+
+            /**
+             * @brief Get the stored bytes.
+             * @return A view of the stored bytes, valid for the lifetime of the storage.
+             */
+            [[nodiscard]] virtual std::string_view getData() const noexcept = 0;
+
+            /**
+             * @brief Note that a range of the stored bytes is about to be read.
+             *
+             * Storage keeping only part of its bytes in memory, such as a paged
+             * file, loads the range and may release others; views stay valid
+             * either way. Any thread may call it. The default does nothing.
+             *
+             * @param offset The byte offset of the range.
+             * @param length The length of the range in bytes.
+             */
+            virtual void touch(size_t /* offset */, size_t /* length */) const noexcept {}
+    };
+
+    /**
+     * @brief Lines affected by the edits made to a text buffer since the change was last taken.
+     *
+     * Lines [firstLine, lastLine] in the current numbering hold changed text;
+     * every line after lastLine is unchanged and moved by lineDelta lines.
+     */
+    struct LineChange {
+        size_t firstLine{0};
+        size_t lastLine{0};
+        ptrdiff_t lineDelta{0};
+
+        /**
+         * @brief Extend this change with a later one.
+         * @param later A change made after this one, in the numbering that followed this change.
+         */
+        void merge(const LineChange& later) noexcept;
+    };
+
+    /**
+     * @brief A contiguous slice of one of the backing buffers of a piece table.
+     */
+    struct Piece {
+        uint32_t buffer{0};
+        size_t start{0};
+        size_t length{0};
+        size_t lineFeeds{0};
+    };
+
+    /**
+     * @brief One replacement in a batch of edits: a range of the document and the pieces replacing it.
+     */
+    struct PieceEdit {
+        size_t offset{0};
+        size_t length{0};
+        std::span<const Piece> pieces;
+    };
+
+    /**
+     * @brief The pieces removed by a batch of edits.
+     */
+    struct RemovedPieces {
+        /**
+         * @brief Every removed piece, in document order.
+         */
+        std::vector<Piece> pieces;
+
+        /**
+         * @brief The end of each edit's run of pieces in pieces.
+         */
+        std::vector<size_t> ends;
+    };
+
+    /**
+     * @brief Piece table text storage.
+     *
+     * The document is described as a sequence of pieces referencing either the
+     * immutable original buffer or one of the append-only add blocks. Pieces are
+     * held in a treap keyed implicitly by document offset, with every node caching
+     * the byte length and line feed count of its subtree, so insertion, deletion
+     * and offset/position conversion all run in O(log n) in the number of pieces,
+     * independent of the document size.
+     */
+    class TextBuffer {
+        public:
+            /**
+             * @brief Callback receiving consecutive chunks of document text.
+             * Returning false stops the traversal.
+             */
+            using ChunkVisitor = std::function<bool(std::string_view chunk)>;
+
+            /**
+             * @brief Construct an empty TextBuffer.
+             */
+            TextBuffer();
+
+            /**
+             * @brief Construct a TextBuffer whose original buffer holds the given text.
+             * @param text The initial document contents.
+             */
+            explicit TextBuffer(std::string text);
+
+            /**
+             * @brief Construct a TextBuffer using external storage as its original buffer.
+             *
+             * The storage is referenced in place and kept alive by the buffer.
+             *
+             * @param storage The storage holding the initial document contents.
+             */
+            explicit TextBuffer(std::shared_ptr<const TextStorage> storage);
+
+            /**
+             * @brief Construct a TextBuffer over external storage with a line index saved from an earlier buffer over it.
+             *
+             * The storage is not scanned unless the index does not cover it exactly.
+             *
+             * @param storage The storage holding the initial document contents.
+             * @param lineIndex The index of the storage, from getOriginalLineIndex().
+             */
+            TextBuffer(std::shared_ptr<const TextStorage> storage, LineIndex lineIndex);
+
+            /**
+             * @brief Destroy the TextBuffer object.
+             */
+            ~TextBuffer();
+
+            TextBuffer(TextBuffer&&) noexcept;
+            TextBuffer& operator=(TextBuffer&&) noexcept;
+            TextBuffer(const TextBuffer&) = delete;
+            TextBuffer& operator=(const TextBuffer&) = delete;
+
+            /**
+             * @brief Insert text at the given byte offset.
+             * @param offset The byte offset to insert at, clamped to the document size.
+             * @param text The text to insert.
+             */
+            void insert(size_t offset, std::string_view text);
+
+            /**
+             * @brief Erase a range of bytes from the document.
+             * @param offset The byte offset of the first byte to erase.
+             * @param length The number of bytes to erase, clamped to the document end.
+             */
+            void erase(size_t offset, size_t length);
+
+            /**
+             * @brief Get the pieces describing a range of the document.
+             *
+             * Pieces at the ends are trimmed to the range. Backing buffers are
+             * append-only, so the pieces stay valid for the lifetime of the
+             * buffer and can later be re-inserted with insertPieces().
+             *
+             * @param offset The byte offset of the range.
+             * @param length The length of the range in bytes.
+             * @return The pieces in document order.
+             */
+            [[nodiscard]] std::vector<Piece> getPieces(size_t offset, size_t length) const;
+
+            /**
+             * @brief Insert previously obtained pieces at the given byte offset without copying text.
+             * @param offset The byte offset to insert at, clamped to the document size.
+             * @param pieces Pieces returned by getPieces() on this buffer.
+             */
+            void insertPieces(size_t offset, std::span<const Piece> pieces);
+
+            /**
+             * @brief Replace several ranges of the document in one pass over the piece tree.
+             *
+             * The edits are applied left to right while the tree is split and
+             * merged once along the way, and count as a single edit: the
+             * revision increases once and one line change covers them all.
+             *
+             * @param edits The edits, sorted by offset and not overlapping, with
+             * offsets into the document as it was before any of them.
+             * @param removed If not null, receives the pieces each edit removed, for undoing the batch.
+             */
+            void replacePieces(std::span<const PieceEdit> edits, RemovedPieces* removed = nullptr);
+
+            /**
+             * @brief Append text to the add blocks without inserting it anywhere.
+             *
+             * The returned piece can be inserted with insertPieces() or
+             * replacePieces(), as many times as needed.
+             *
+             * @param text The text to append.
+             * @return The piece referencing the appended text.
+             */
+            [[nodiscard]] Piece appendText(std::string_view text) { return appendToAddBlock(text); }
+
+            /**
+             * @brief Get the text a piece references.
+             *
+             * The view stays valid for the lifetime of the buffer, even across
+             * later edits, because backing buffers are append-only and never move.
+             *
+             * @param piece A piece returned by getPieces() on this buffer.
+             * @return The piece text.
+             */
+            [[nodiscard]] std::string_view getPieceText(const Piece& piece) const { return pieceText(piece); }
+
+            /**
+             * @brief Get the text of every add block, for saving the buffer.
+             *
+             * Pieces reference add blocks by their position in this list, counting
+             * from 1; the views stay valid for the lifetime of the buffer.
+             *
+             * @return The add blocks, oldest first.
+             */
+            [[nodiscard]] std::vector<std::string_view> getAddBlocks() const;
+
+            /**
+             * @brief Share the text the buffer owns, so views of it can outlive the buffer.
+             *
+             * Owned text is only ever appended to, so views taken before the call
+             * stay valid for as long as the returned owners are held.
+             *
+             * @return The original text if the buffer owns it, then every add block.
+             */
+            [[nodiscard]] std::vector<std::shared_ptr<const std::string>> shareOwnedText() const;
+
+            /**
+             * @brief Get the text of the original buffer, for saving a buffer without external storage.
+             * @return The original text, valid for the lifetime of the buffer.
+             */
+            [[nodiscard]] std::string_view getOriginalText() const noexcept { return m_buffers[0].text(); }
+
+            /**
+             * @brief Get the line index of the original buffer, for saving the buffer.
+             * @return The index; it never changes after construction.
+             */
+            [[nodiscard]] const LineIndex& getOriginalLineIndex() const noexcept { return m_buffers[0].lineIndex; }
+
+            /**
+             * @brief Check whether a piece references text inside one of the backing buffers.
+             * @param piece The piece.
+             * @return True if the piece can be inserted into this buffer.
+             */
+            [[nodiscard]] bool isValidPiece(const Piece& piece) const noexcept;
+
+            /**
+             * @brief Rebuild the edits of an earlier buffer over the same original text.
+             *
+             * The add blocks are recreated as given so the pieces, and any undo
+             * history referencing them, resolve to the same text. This is part of
+             * construction: the revision and the pending line change are untouched.
+             *
+             * @param addBlocks The text of each add block, from getAddBlocks().
+             * @param pieces The pieces of the whole document in order, from getPieces().
+             * @return True if restored; false if the buffer was already edited or a piece is out of range, leaving it unchanged.
+             */
+            [[nodiscard]] bool restorePieces(std::span<const std::string_view> addBlocks, std::span<const Piece> pieces);
+
+            /**
+             * @brief Get the external storage of the original buffer.
+             * @return The storage, or nullptr if the buffer owns its original text.
+             */
+            [[nodiscard]] const std::shared_ptr<const TextStorage>& getStorage() const noexcept { return m_buffers[0].external; }
+
+            /**
+             * @brief Get a counter that increases with every edit.
+             * @return The revision.
+             */
+            [[nodiscard]] uint64_t getRevision() const noexcept { return m_revision; }
+
+            /**
+             * @brief Take the lines changed since the last call.
+             * @return The accumulated change, or std::nullopt if nothing changed.
+             */
+            [[nodiscard]] std::optional<LineChange> takeLineChange() noexcept;
+
+            /**
+             * @brief Get the size of the document in bytes.
+             * @return The document size in bytes.
+             */
+            [[nodiscard]] size_t getSize() const noexcept;
+
+            /**
+             * @brief Get the number of lines in the document (line feeds + 1).
+             * @return The number of lines.
+             */
+            [[nodiscard]] size_t getLineCount() const noexcept;
+
+            /**
+             * @brief Get the number of pieces currently describing the document.
+             * @return The piece count.
+             */
+            [[nodiscard]] size_t getPieceCount() const noexcept { return m_pieceCount; }
+
+            /**
+             * @brief Get the number of nodes on the longest path from the root of the piece tree to a leaf.
+             *
+             * Walks the whole tree; the treap keeps it logarithmic in the piece
+             * count, which benchmarks check after long runs of edits.
+             *
+             * @return The tree depth, 0 for an empty document.
+             */
+            [[nodiscard]] size_t getTreeDepth() const;
+
+            /**
+             * @brief Get the byte at the given offset.
+             * @param offset The byte offset, must be less than getSize().
+             * @return The byte at the offset.
+             */
+            [[nodiscard]] char getChar(size_t offset) const;
+
+            /**
+             * @brief Copy a range of the document into a string.
+             * @param offset The byte offset of the range.
+             * @param length The length of the range in bytes.
+             * @return The text of the range.
+             */
+            [[nodiscard]] std::string getText(size_t offset, size_t length) const;
+
+            /**
+             * @brief Copy a range of the document into a string, reusing its storage.
+             * @param offset The byte offset of the range.
+             * @param length The length of the range in bytes.
+             * @param text Receives the text of the range.
+             */
+            void getText(size_t offset, size_t length, std::pmr::string& text) const;
+
+            /**
+             * @brief Copy the whole document into a string.
+             * @return The document text.
+             */
+            [[nodiscard]] std::string getText() const;
+
+            /**
+             * @brief Get the text of a line, without its line terminator.
+             * @param line The zero-based line number.
+             * @return The line text.
+             */
+            [[nodiscard]] std::string getLine(size_t line) const;
+
+            /**
+             * @brief Visit the document text in the range as a sequence of chunks.
+             * @param offset The byte offset of the range.
+             * @param length The length of the range in bytes.
+             * @param visitor Callback invoked with each chunk in document order.
+             */
+            void visitChunks(size_t offset, size_t length, const ChunkVisitor& visitor) const;
+
+            /**
+             * @brief Convert a byte offset to a line/column position.
+             * @param offset The byte offset, clamped to the document size.
+             * @return The position of the offset.
+             */
+            [[nodiscard]] TextPosition offsetToPosition(size_t offset) const;
+
+            /**
+             * @brief Convert a line/column position to a byte offset.
+             * @param position The position, clamped to the document.
+             * @return The byte offset of the position.
+             */
+            [[nodiscard]] size_t positionToOffset(const TextPosition& position) const;
+
+            /**
+             * @brief Get the byte offset of the first character of a line.
+             * @param line The zero-based line number, clamped to the last line.
+             * @return The byte offset of the line start.
+             */
+            [[nodiscard]] size_t getLineStart(size_t line) const;
+
+            /**
+             * @brief Get the length of a line in bytes, excluding its "\n" or "\r\n" terminator.
+             * @param line The zero-based line number.
+             * @return The line length in bytes.
+             */
+            [[nodiscard]] size_t getLineLength(size_t line) const;
+
+        private:
+            /**
+             * @brief A backing buffer referenced by pieces.
+             *
+             * Add blocks reserve their capacity up front and are never grown past it,
+             * so appended text never moves and piece references stay valid. Owned
+             * text is shared so snapshots can keep it alive after the buffer is
+             * gone. The original buffer either owns its text or references
+             * external storage.
+             */
+            struct Buffer {
+                std::shared_ptr<std::string> owned = std::make_shared<std::string>();
+                std::shared_ptr<const TextStorage> external;
+                size_t capacity{0};
+                LineIndex lineIndex;
+
+                [[nodiscard]] std::string_view text() const noexcept {
+                    return external ? external->getData() : std::string_view(*owned);
+                }
+            };
+
+            /**
+             * @brief A treap node holding one piece and its subtree aggregates.
+             */
+            struct Node {
+                Piece piece;
+                uint32_t priority{0};
+                uint32_t left{0};
+                uint32_t right{0};
+                size_t subtreeLength{0};
+                size_t subtreeLineFeeds{0};
+            };
+
+            /**
+             * @brief Index the original buffer and build the tree describing it.
+             * @param original The original buffer.
+             */
+            void initialize(Buffer original);
+
+            /**
+             * @brief Append text to the add blocks, producing the piece that references it.
+             * @param text The text to append.
+             * @return The piece referencing the appended text.
+             */
+            [[nodiscard]] Piece appendToAddBlock(std::string_view text);
+
+            /**
+             * @brief Try to extend the piece ending at the given offset in place.
+             * @param offset The document offset the text is inserted at.
+             * @param text The text being inserted.
+             * @return True if the text was absorbed into an existing piece.
+             */
+            [[nodiscard]] bool tryExtendLastInsert(size_t offset, std::string_view text);
+
+            /**
+             * @brief Count line feeds in a range of a backing buffer.
+             * @param buffer The backing buffer index.
+             * @param start The start offset within the buffer.
+             * @param end The end offset within the buffer.
+             * @return The number of line feeds in [start, end).
+             */
+            [[nodiscard]] size_t countLineFeeds(uint32_t buffer, size_t start, size_t end) const;
+
+            /**
+             * @brief Find the offset just past the n-th line feed of a piece.
+             * @param piece The piece to search.
+             * @param n The one-based line feed index within the piece.
+             * @return The offset within the piece just after that line feed.
+             */
+            [[nodiscard]] size_t offsetAfterLineFeed(const Piece& piece, size_t n) const;
+
+            /**
+             * @brief Get a view of the text referenced by a piece.
+             * @param piece The piece.
+             * @return The piece text.
+             */
+            [[nodiscard]] std::string_view pieceText(const Piece& piece) const;
+
+            /**
+             * @brief Tell external storage that part of a piece is about to be read.
+             * @param piece The piece.
+             * @param from The offset of the part within the piece.
+             * @param length The length of the part in bytes.
+             */
+            void touchPiece(const Piece& piece, size_t from, size_t length) const noexcept;
+
+            /**
+             * @brief Allocate a tree node for a piece, reusing released nodes when possible.
+             * @param piece The piece the node holds.
+             * @return The node index.
+             */
+            [[nodiscard]] uint32_t allocateNode(const Piece& piece);
+
+            /**
+             * @brief Append the pieces of a subtree to a vector in document order.
+             * @param node The subtree root.
+             * @param pieces The vector.
+             */
+            void collectPieces(uint32_t node, std::vector<Piece>& pieces) const;
+
+            /**
+             * @brief Release every node of a subtree back to the pool.
+             * @param node The subtree root.
+             */
+            void freeSubtree(uint32_t node);
+
+            /**
+             * @brief Recompute the subtree aggregates of a node from its children.
+             * @param node The node index.
+             */
+            void update(uint32_t node);
+
+            /**
+             * @brief Merge two treaps where every offset of the left precedes the right.
+             * @param left The left treap root.
+             * @param right The right treap root.
+             * @return The merged treap root.
+             */
+            [[nodiscard]] uint32_t merge(uint32_t left, uint32_t right);
+
+            /**
+             * @brief Split a treap so the left part holds exactly the first `offset` bytes.
+             * @param node The treap root.
+             * @param offset The byte offset to split at.
+             * @param left Receives the root of the first `offset` bytes.
+             * @param right Receives the root of the remaining bytes.
+             */
+            void split(uint32_t node, size_t offset, uint32_t& left, uint32_t& right);
+
+            /**
+             * @brief Generate the next pseudo-random treap priority.
+             * @return The priority.
+             */
+            [[nodiscard]] uint32_t nextPriority();
+
+            /**
+             * @brief Get the byte length of a subtree.
+             * @param node The subtree root, may be the null sentinel.
+             * @return The subtree length.
+             */
+            [[nodiscard]] size_t lengthOf(uint32_t node) const noexcept;
+
+            /**
+             * @brief Get the line feed count of a subtree.
+             * @param node The subtree root, may be the null sentinel.
+             * @return The subtree line feed count.
+             */
+            [[nodiscard]] size_t lineFeedsOf(uint32_t node) const noexcept;
+
+            /**
+             * @brief Record an edit in the revision and the pending line change.
+             * @param line The line the edit starts on.
+             * @param removedLineFeeds The number of line feeds the edit removed.
+             * @param insertedLineFeeds The number of line feeds the edit inserted.
+             */
+            void noteEdit(size_t line, size_t removedLineFeeds, size_t insertedLineFeeds) noexcept;
+
+            /**
+             * @brief Record an edit in the revision and the pending line change.
+             * @param change The lines the edit changed.
+             */
+            void noteEdit(const LineChange& change) noexcept;
+
+        private:
+            /**
+             * @brief Size of a freshly allocated add block in bytes.
+             */
+            static constexpr size_t AddBlockSize = 64 * 1024;
+
+            /**
+             * @brief Backing buffers; index 0 is the original buffer, the rest are add blocks.
+             */
+            std::vector<Buffer> m_buffers;
+
+            /**
+             * @brief Node pool; index 0 is the null sentinel.
+             */
+            std::vector<Node> m_nodes;
+
+            /**
+             * @brief Indices of released nodes available for reuse.
+             */
+            std::vector<uint32_t> m_freeNodes;
+
+            /**
+             * @brief Scratch path from the root to a node, reused so typing allocates nothing once it has grown.
+             */
+            std::vector<uint32_t> m_path;
+
+            /**
+             * @brief Root node of the piece tree.
+             */
+            uint32_t m_root{0};
+
+            /**
+             * @brief Number of pieces in the tree.
+             */
+            size_t m_pieceCount{0};
+
+            /**
+             * @brief State of the priority generator.
+             */
+            uint32_t m_randomState{0x9E3779B9u};
+
+            /**
+             * @brief Counter increased by every edit.
+             */
+            uint64_t m_revision{0};
+
+            /**
+             * @brief Lines changed since takeLineChange() was last called.
+             */
+            std::optional<LineChange> m_lineChange;
+    };
+
+}
@@ -0,0 +1,122 @@
+#include "editor/text_snapshot.h"
+#include <algorithm>
+#include <cstring>
+
+namespace drite {
+
+    /**
+     * @brief Bytes scanned per step by find().
+     */
+    static constexpr size_t FindStep = 64 * 1024;
+
+    /**
+     * @brief Capture the text of a buffer.
+     * @param buffer The buffer.
+     * @return The snapshot.
+     */
+    TextSnapshot TextSnapshot::capture(const TextBuffer& buffer) {
+        TextSnapshot snapshot;
+        const std::vector<Piece> pieces = buffer.getPieces(0, buffer.getSize());
+        snapshot.chunks.reserve(pieces.size());
+        snapshot.chunkOffsets.reserve(pieces.size());
+        snapshot.chunkLineFeeds.reserve(pieces.size() + 1);
+
+        size_t offset{0};
+        size_t lineFeeds{0};
+        for (const Piece& piece : pieces) {
+            snapshot.chunks.push_back(buffer.getPieceText(piece));
+            snapshot.chunkOffsets.push_back(offset);
+            snapshot.chunkLineFeeds.push_back(lineFeeds);
+            offset += piece.length;
+            lineFeeds += piece.lineFeeds;
+        }
+        snapshot.chunkLineFeeds.push_back(lineFeeds);
+        snapshot.size = offset;
+        snapshot.lineCount = lineFeeds + 1;
+        snapshot.storage = buffer.getStorage();
+        snapshot.ownedText = buffer.shareOwnedText();
+        return snapshot;
+    }
+
+    /**
+     * @brief Get the chunk holding a byte offset.
+     * @param offset The byte offset, below the snapshot size.
+     * @return The chunk index.
+     */
+    size_t TextSnapshot::findChunk(size_t offset) const noexcept {
+        return static_cast<size_t>(std::upper_bound(chunkOffsets.begin(), chunkOffsets.end(), offset) - chunkOffsets.begin()) - 1;
+    }
+
+    /**
+     * @brief Read a byte range as one contiguous view.
+     * @param offset The byte offset of the range.
+     * @param length The length of the range, clamped to the snapshot size.
+     * @param scratch Storage for ranges spanning chunks.
+     * @return A view of the chunk when the range lies in one, otherwise of scratch.
+     */
+    std::string_view TextSnapshot::read(size_t offset, size_t length, std::string& scratch) const {
+        if (offset >= size) {
+            return {};
+        }
+        length = std::min(length, size - offset);
+
+        size_t chunk = findChunk(offset);
+        size_t inChunk = offset - chunkOffsets[chunk];
+        if (chunks[chunk].size() - inChunk >= length) {
+            const std::string_view text = chunks[chunk].substr(inChunk, length);
+            touch(text);
+            return text;
+        }
+
+        scratch.clear();
+        scratch.reserve(length);
+        while (scratch.size() < length) {
+            const std::string_view text = chunks[chunk].substr(inChunk, length - scratch.size());
+            touch(text);
+            scratch.append(text);
+            ++chunk;
+            inChunk = 0;
+        }
+        return scratch;
+    }
+
+    /**
+     * @brief Find the first occurrence of a byte at or after an offset.
+     * @param byte The byte.
+     * @param offset The offset to start from.
+     * @return The offset of the byte, or the snapshot size if not found.
+     */
+    size_t TextSnapshot::find(char byte, size_t offset) const noexcept {
+        if (offset >= size) {
+            return size;
+        }
+
+        // Long chunks are scanned a step at a time, so only what is scanned gets touched
+        for (size_t chunk = findChunk(offset); chunk < chunks.size(); ++chunk) {
+            const std::string_view text = chunks[chunk];
+            for (size_t inChunk = offset > chunkOffsets[chunk] ? offset - chunkOffsets[chunk] : 0; inChunk < text.size(); inChunk += FindStep) {
+                const std::string_view step = text.substr(inChunk, FindStep);
+                touch(step);
+                if (const void* found = std::memchr(step.data(), byte, step.size())) {
+                    return chunkOffsets[chunk] + static_cast<size_t>(static_cast<const char*>(found) - text.data());
+                }
+            }
+        }
+        return size;
+    }
+
+    /**
+     * @brief Note that part of a chunk is about to be read.
+     * @param text A view into one of the chunks.
+     */
+    void TextSnapshot::touch(std::string_view text) const noexcept {
+        if (!storage) {
+            return;
+        }
+        const std::string_view data = storage->getData();
+        if (text.data() >= data.data() && text.data() < data.data() + data.size()) {
+            storage->touch(static_cast<size_t>(text.data() - data.data()), text.size());
+        }
+    }
+
+}
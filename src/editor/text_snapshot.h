@@ -0,0 +1,68 @@
+#pragma once
+
+#include "editor/text_buffer.h"
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace drite {
+
+    /**
+     * @brief The text of a buffer at one revision, as views of its pieces.
+     *
+     * Piece text is append-only, so a snapshot stays valid while the buffer is
+     * edited and can be read from other threads. It shares ownership of the
+     * text it views, so it also stays valid after the buffer is closed.
+     * Chunks of external storage should be read through touch(), as read() and
+     * find() do, so paged storage can load them.
+     */
+    struct TextSnapshot {
+        std::vector<std::string_view> chunks;
+        std::vector<size_t> chunkOffsets;
+        std::vector<size_t> chunkLineFeeds;
+        size_t size{0};
+        size_t lineCount{1};
+        std::shared_ptr<const TextStorage> storage;
+        std::vector<std::shared_ptr<const std::string>> ownedText;
+
+        /**
+         * @brief Capture the text of a buffer.
+         * @param buffer The buffer.
+         * @return The snapshot.
+         */
+        [[nodiscard]] static TextSnapshot capture(const TextBuffer& buffer);
+
+        /**
+         * @brief Get the chunk holding a byte offset.
+         * @param offset The byte offset, below the snapshot size.
+         * @return The chunk index.
+         */
+        [[nodiscard]] size_t findChunk(size_t offset) const noexcept;
+
+        /**
+         * @brief Read a byte range as one contiguous view.
+         * @param offset The byte offset of the range.
+         * @param length The length of the range, clamped to the snapshot size.
+         * @param scratch Storage for ranges spanning chunks.
+         * @return A view of the chunk when the range lies in one, otherwise of scratch.
+         */
+        [[nodiscard]] std::string_view read(size_t offset, size_t length, std::string& scratch) const;
+
+        /**
+         * @brief Find the first occurrence of a byte at or after an offset.
+         * @param byte The byte.
+         * @param offset The offset to start from.
+         * @return The offset of the byte, or the snapshot size if not found.
+         */
+        [[nodiscard]] size_t find(char byte, size_t offset) const noexcept;
+
+        /**
+         * @brief Note that part of a chunk is about to be read.
+         * @param text A view into one of the chunks.
+         */
+        void touch(std::string_view text) const noexcept;
+    };
+
+}
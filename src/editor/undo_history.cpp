@@ -0,0 +1,531 @@
+#include "editor/undo_history.h"
+#include "editor/undo_spill.h"
+#include <algorithm>
+#include <optional>
+
+namespace drite {
+
+    /**
+     * @brief Check whether a piece continues right where another ends in the same backing buffer.
+     * @param first The earlier piece.
+     * @param second The later piece.
+     * @return True if the two can be merged into one piece.
+     */
+    static bool isContiguous(const Piece& first, const Piece& second) noexcept {
+        return first.buffer == second.buffer && first.start + first.length == second.start;
+    }
+
+    /**
+     * @brief Get the total byte length of a run of pieces.
+     * @param pieces The pieces.
+     * @return The summed length.
+     */
+    static size_t totalLength(std::span<const Piece> pieces) noexcept {
+        size_t length{0};
+        for (const Piece& piece : pieces) {
+            length += piece.length;
+        }
+        return length;
+    }
+
+    /**
+     * @brief Append pieces to the run at the end of a pool, merging each into the last piece of the run if contiguous.
+     * @param pool The piece pool.
+     * @param runStart The index of the first piece of the run; pieces before it belong to other runs and are never merged into.
+     * @param pieces The pieces to append.
+     * @return The number of pieces the pool grew by.
+     */
+    static uint32_t appendPieces(std::vector<Piece>& pool, size_t runStart, std::span<const Piece> pieces) {
+        const size_t before = pool.size();
+        for (const Piece& piece : pieces) {
+            if (pool.size() > runStart && isContiguous(pool.back(), piece)) {
+                pool.back().length += piece.length;
+                pool.back().lineFeeds += piece.lineFeeds;
+            } else {
+                pool.push_back(piece);
+            }
+        }
+        return static_cast<uint32_t>(pool.size() - before);
+    }
+
+    /**
+     * @brief Get the heap and inline memory held by the group.
+     * @return The size in bytes.
+     */
+    size_t UndoGroup::getMemoryUsage() const noexcept {
+        return sizeof(UndoGroup) + deltas.capacity() * sizeof(EditDelta) + pieces.capacity() * sizeof(Piece) +
+            (cursorsBefore.capacity() + cursorsAfter.capacity()) * sizeof(size_t);
+    }
+
+    /**
+     * @brief Construct a new Undo History object.
+     * @param memoryBudget The most memory the history may hold in bytes.
+     */
+    UndoHistory::UndoHistory(size_t memoryBudget)
+        : m_memoryBudget(memoryBudget) {}
+
+    /**
+     * @brief Destroy the Undo History object, deleting its spill file.
+     */
+    UndoHistory::~UndoHistory() = default;
+
+    UndoHistory::UndoHistory(UndoHistory&&) noexcept = default;
+    UndoHistory& UndoHistory::operator=(UndoHistory&&) noexcept = default;
+
+    /**
+     * @brief Record an edit already applied to the buffer, clearing the redo stack.
+     * @param offset The byte offset of the edit.
+     * @param removed The pieces the edit removed, obtained before the edit.
+     * @param inserted The pieces the edit inserted, obtained after the edit.
+     * @param kind What the edit did.
+     * @param cursorBefore The cursor offset before the edit.
+     * @param cursorAfter The cursor offset after the edit.
+     */
+    void UndoHistory::record(size_t offset, std::span<const Piece> removed, std::span<const Piece> inserted,
+                             EditKind kind, size_t cursorBefore, size_t cursorAfter) {
+        if (removed.empty() && inserted.empty()) {
+            return;
+        }
+        clearRedo();
+
+        // Explicit groups take every edit; otherwise only runs of one kind of
+        // edit at adjoining offsets extend the open group
+        if (!m_undo.empty() && !m_undo.back()->sealed) {
+            UndoGroup& open = *m_undo.back();
+            const size_t before = open.getMemoryUsage();
+            const bool sameRun = m_groupDepth > 0 || (open.kind == kind && kind != EditKind::Other);
+            if (sameRun && tryCoalesce(open, offset, removed, inserted, kind)) {
+                open.cursorAfter = cursorAfter;
+            } else if (m_groupDepth > 0) {
+                if (open.deltas.empty()) {
+                    open.cursorBefore = cursorBefore;
+                }
+                appendDelta(open, offset, removed, inserted);
+                open.cursorAfter = cursorAfter;
+            } else {
+                compact(open);
+            }
+
+            m_memoryUsage = m_memoryUsage - before + open.getMemoryUsage();
+            if (!open.sealed) {
+                enforceBudget();
+                return;
+            }
+        }
+
+        UndoGroup& group = *m_undo.emplace_back(std::make_shared<UndoGroup>());
+        group.cursorBefore = cursorBefore;
+        group.cursorAfter = cursorAfter;
+        group.kind = kind;
+        appendDelta(group, offset, removed, inserted);
+
+        m_memoryUsage += group.getMemoryUsage();
+        enforceBudget();
+    }
+
+    /**
+     * @brief Close the current group so the next edit starts a new one.
+     */
+    void UndoHistory::seal() {
+        if (m_groupDepth == 0 && !m_undo.empty() && !m_undo.back()->sealed) {
+            UndoGroup& open = *m_undo.back();
+            const size_t before = open.getMemoryUsage();
+            compact(open);
+            m_memoryUsage = m_memoryUsage - before + open.getMemoryUsage();
+        }
+    }
+
+    /**
+     * @brief Start a group that collects every edit until endGroup(), regardless of kind.
+     */
+    void UndoHistory::beginGroup() {
+        if (m_groupDepth++ > 0) {
+            return;
+        }
+
+        seal();
+        clearRedo();
+
+        UndoGroup& group = *m_undo.emplace_back(std::make_shared<UndoGroup>());
+        group.kind = EditKind::Other;
+        m_memoryUsage += group.getMemoryUsage();
+    }
+
+    /**
+     * @brief Close the group opened with beginGroup().
+     */
+    void UndoHistory::endGroup() {
+        if (m_groupDepth == 0 || --m_groupDepth > 0) {
+            return;
+        }
+
+        // A group that recorded nothing is not worth an undo step
+        if (m_undo.back()->deltas.empty()) {
+            m_memoryUsage -= m_undo.back()->getMemoryUsage();
+            m_undo.pop_back();
+            return;
+        }
+        seal();
+    }
+
+    /**
+     * @brief Remember every cursor of an edit made with several cursors in the group opened with beginGroup().
+     * @param before The cursor offsets before the group.
+     * @param after The cursor offsets after the group.
+     */
+    void UndoHistory::setGroupCursors(std::span<const size_t> before, std::span<const size_t> after) {
+        if (m_groupDepth == 0) {
+            return;
+        }
+
+        UndoGroup& group = *m_undo.back();
+        const size_t usage = group.getMemoryUsage();
+        group.cursorsBefore.assign(before.begin(), before.end());
+        group.cursorsAfter.assign(after.begin(), after.end());
+        m_memoryUsage = m_memoryUsage - usage + group.getMemoryUsage();
+        enforceBudget();
+    }
+
+    /**
+     * @brief Revert the most recent group.
+     * @param buffer The buffer the edits were applied to.
+     * @param cursor Receives the primary cursor offset from before the group.
+     * @param cursors Receives every cursor offset from before the group, or nothing for a group edited with one cursor.
+     * @return True if a group was undone.
+     */
+    bool UndoHistory::undo(TextBuffer& buffer, size_t& cursor, std::vector<size_t>& cursors) {
+        if (!canUndo() || m_groupDepth > 0) {
+            return false;
+        }
+
+        std::shared_ptr<UndoGroup> held;
+        if (!m_undo.empty()) {
+            held = std::move(m_undo.back());
+            m_undo.pop_back();
+            if (!held->sealed) {
+                const size_t before = held->getMemoryUsage();
+                compact(*held);
+                m_memoryUsage = m_memoryUsage - before + held->getMemoryUsage();
+            }
+        } else if (std::optional<UndoGroup> spilled = m_spill->pop()) {
+            // Back in memory on the redo stack, where it may stay over budget
+            // until the next edit clears the redo stack
+            held = std::make_shared<UndoGroup>(std::move(*spilled));
+            m_memoryUsage += held->getMemoryUsage();
+        } else {
+            dropSpilled();
+            return false;
+        }
+
+        // Later deltas of a batch lie after the earlier ones, so each delta's
+        // offset is already where its text is in the current document
+        const UndoGroup& group = *held;
+        const std::span<const Piece> pieces(group.pieces);
+        if (isBatch(group)) {
+            std::vector<PieceEdit> edits;
+            edits.reserve(group.deltas.size());
+            for (const EditDelta& delta : group.deltas) {
+                edits.push_back(PieceEdit{delta.offset, delta.insertedLength, pieces.subspan(delta.removedFirst, delta.removedCount)});
+            }
+            buffer.replacePieces(edits);
+        } else {
+            for (auto delta = group.deltas.rbegin(); delta != group.deltas.rend(); ++delta) {
+                buffer.erase(delta->offset, delta->insertedLength);
+                buffer.insertPieces(delta->offset, pieces.subspan(delta->removedFirst, delta->removedCount));
+            }
+        }
+
+        cursor = group.cursorBefore;
+        cursors = group.cursorsBefore;
+        m_redo.push_back(std::move(held));
+        return true;
+    }
+
+    /**
+     * @brief Reapply the most recently undone group.
+     * @param buffer The buffer the edits were applied to.
+     * @param cursor Receives the primary cursor offset from after the group.
+     * @param cursors Receives every cursor offset from after the group, or nothing for a group edited with one cursor.
+     * @return True if a group was redone.
+     */
+    bool UndoHistory::redo(TextBuffer& buffer, size_t& cursor, std::vector<size_t>& cursors) {
+        if (m_redo.empty() || m_groupDepth > 0) {
+            return false;
+        }
+
+        std::shared_ptr<UndoGroup> held = std::move(m_redo.back());
+        m_redo.pop_back();
+        const UndoGroup& group = *held;
+
+        // A batch is reapplied to the document from before it, where each
+        // delta's offset has not yet been moved by the deltas in front of it
+        const std::span<const Piece> pieces(group.pieces);
+        if (isBatch(group)) {
+            std::vector<PieceEdit> edits;
+            edits.reserve(group.deltas.size());
+            ptrdiff_t shift{0};
+            for (const EditDelta& delta : group.deltas) {
+                const size_t offset = static_cast<size_t>(static_cast<ptrdiff_t>(delta.offset) - shift);
+                edits.push_back(PieceEdit{offset, delta.removedLength, pieces.subspan(delta.insertedFirst, delta.insertedCount)});
+                shift += static_cast<ptrdiff_t>(delta.insertedLength) - static_cast<ptrdiff_t>(delta.removedLength);
+            }
+            buffer.replacePieces(edits);
+        } else {
+            for (const EditDelta& delta : group.deltas) {
+                buffer.erase(delta.offset, delta.removedLength);
+                buffer.insertPieces(delta.offset, pieces.subspan(delta.insertedFirst, delta.insertedCount));
+            }
+        }
+
+        cursor = group.cursorAfter;
+        cursors = group.cursorsAfter;
+        m_undo.push_back(std::move(held));
+        return true;
+    }
+
+    /**
+     * @brief Change the memory budget, discarding old groups if needed.
+     * @param bytes The most memory the history may hold in bytes.
+     */
+    void UndoHistory::setMemoryBudget(size_t bytes) {
+        m_memoryBudget = bytes;
+        enforceBudget();
+    }
+
+    /**
+     * @brief Discard all history.
+     */
+    void UndoHistory::clear() {
+        m_undo.clear();
+        m_redo.clear();
+        m_memoryUsage = 0;
+        m_groupDepth = 0;
+        if (m_spill) {
+            m_spill->clear();
+        }
+    }
+
+    /**
+     * @brief Check whether there is anything to undo.
+     * @return True if undo() would succeed.
+     */
+    bool UndoHistory::canUndo() const noexcept {
+        return !m_undo.empty() || (m_spill && m_spill->getGroupCount() > 0);
+    }
+
+    /**
+     * @brief Get the history counters.
+     * @return A snapshot of the counters.
+     */
+    UndoHistoryStats UndoHistory::getStats() const noexcept {
+        return UndoHistoryStats{m_undo.size(), m_redo.size(), m_memoryUsage, m_droppedGroups,
+                                m_spill ? m_spill->getGroupCount() : 0, m_spill ? m_spill->getSize() : 0};
+    }
+
+    /**
+     * @brief Share the groups in memory, for saving the history on another thread.
+     * @return The groups that can be undone and redone.
+     */
+    UndoHistorySnapshot UndoHistory::share() const {
+        UndoHistorySnapshot snapshot;
+        snapshot.undo.reserve(m_undo.size());
+        for (const std::shared_ptr<UndoGroup>& group : m_undo) {
+            snapshot.undo.push_back(group->sealed ? group : std::make_shared<const UndoGroup>(*group));
+        }
+        snapshot.redo.assign(m_redo.begin(), m_redo.end());
+        return snapshot;
+    }
+
+    /**
+     * @brief Replace the history with groups saved from an earlier one over the same buffer text.
+     * @param undo The groups that can be undone, oldest first.
+     * @param redo The groups that can be redone, most recently undone last.
+     */
+    void UndoHistory::restore(std::deque<UndoGroup> undo, std::vector<UndoGroup> redo) {
+        clear();
+        for (UndoGroup& group : undo) {
+            group.sealed = true;
+            m_memoryUsage += group.getMemoryUsage();
+            m_undo.push_back(std::make_shared<UndoGroup>(std::move(group)));
+        }
+        for (UndoGroup& group : redo) {
+            group.sealed = true;
+            m_memoryUsage += group.getMemoryUsage();
+            m_redo.push_back(std::make_shared<UndoGroup>(std::move(group)));
+        }
+        enforceBudget();
+    }
+
+    /**
+     * @brief Try to fold an edit into the last delta of the open group.
+     *
+     * The pieces of the last delta sit at the end of the group pool, so typing
+     * and forward deletes append there and backspaces insert in front of the
+     * last delta's removed run.
+     *
+     * @param group The open group.
+     * @param offset The byte offset of the edit.
+     * @param removed The removed pieces.
+     * @param inserted The inserted pieces.
+     * @param kind What the edit did.
+     * @return True if the edit was merged.
+     */
+    bool UndoHistory::tryCoalesce(UndoGroup& group, size_t offset, std::span<const Piece> removed,
+                                  std::span<const Piece> inserted, EditKind kind) {
+        if (group.deltas.empty()) {
+            return false;
+        }
+
+        EditDelta& last = group.deltas.back();
+        switch (kind) {
+            case EditKind::Typing:
+                if (!removed.empty() || offset != last.offset + last.insertedLength) {
+                    return false;
+                }
+                last.insertedCount += appendPieces(group.pieces, last.insertedFirst, inserted);
+                last.insertedLength += totalLength(inserted);
+                return true;
+
+            case EditKind::DeleteForward:
+                if (!inserted.empty() || last.insertedCount > 0 || offset != last.offset) {
+                    return false;
+                }
+                last.removedCount += appendPieces(group.pieces, last.removedFirst, removed);
+                last.removedLength += totalLength(removed);
+                return true;
+
+            case EditKind::DeleteBackward: {
+                if (!inserted.empty() || last.insertedCount > 0 || offset + totalLength(removed) != last.offset) {
+                    return false;
+                }
+
+                // Put the newly removed text in front, merging into the old first piece
+                std::vector<Piece> merged(removed.begin(), removed.end());
+                const auto previous = group.pieces.begin() + last.removedFirst;
+                size_t skip{0};
+                if (!merged.empty() && last.removedCount > 0 && isContiguous(merged.back(), *previous)) {
+                    merged.back().length += previous->length;
+                    merged.back().lineFeeds += previous->lineFeeds;
+                    skip = 1;
+                }
+                group.pieces.erase(previous, previous + static_cast<ptrdiff_t>(skip));
+                group.pieces.insert(group.pieces.begin() + last.removedFirst, merged.begin(), merged.end());
+
+                last.removedCount = static_cast<uint32_t>(last.removedCount - skip + merged.size());
+                last.removedLength += totalLength(removed);
+                last.offset = offset;
+                last.insertedFirst = last.removedFirst + last.removedCount;
+                return true;
+            }
+
+            case EditKind::Other:
+                break;
+        }
+        return false;
+    }
+
+    /**
+     * @brief Seal a group and release its spare capacity; the caller updates the accounting.
+     * @param group The group.
+     */
+    void UndoHistory::compact(UndoGroup& group) {
+        group.deltas.shrink_to_fit();
+        group.pieces.shrink_to_fit();
+        group.sealed = true;
+    }
+
+    /**
+     * @brief Check whether the deltas of a group can be applied as one batch.
+     * @param group The group.
+     * @return True if there are several deltas, each starting at or after the text the previous one inserted.
+     */
+    bool UndoHistory::isBatch(const UndoGroup& group) noexcept {
+        if (group.deltas.size() < 2) {
+            return false;
+        }
+        for (size_t i = 1; i < group.deltas.size(); ++i) {
+            const EditDelta& previous = group.deltas[i - 1];
+            if (group.deltas[i].offset < previous.offset + previous.insertedLength) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /**
+     * @brief Append a delta for an edit to a group.
+     * @param group The group.
+     * @param offset The byte offset of the edit.
+     * @param removed The removed pieces.
+     * @param inserted The inserted pieces.
+     */
+    void UndoHistory::appendDelta(UndoGroup& group, size_t offset, std::span<const Piece> removed,
+                                  std::span<const Piece> inserted) {
+        EditDelta delta;
+        delta.offset = offset;
+        delta.removedLength = totalLength(removed);
+        delta.insertedLength = totalLength(inserted);
+        delta.removedFirst = static_cast<uint32_t>(group.pieces.size());
+        delta.removedCount = appendPieces(group.pieces, delta.removedFirst, removed);
+        delta.insertedFirst = static_cast<uint32_t>(group.pieces.size());
+        delta.insertedCount = appendPieces(group.pieces, delta.insertedFirst, inserted);
+        group.deltas.push_back(delta);
+    }
+
+    /**
+     * @brief Discard the redo stack.
+     */
+    void UndoHistory::clearRedo() {
+        for (const std::shared_ptr<UndoGroup>& group : m_redo) {
+            m_memoryUsage -= group->getMemoryUsage();
+        }
+        m_redo.clear();
+    }
+
+    /**
+     * @brief Spill the oldest undo groups, or discard them or redo groups, until the history fits its budget.
+     *
+     * The newest undo group is always kept in memory so the last edit can be
+     * undone even when it alone exceeds the budget.
+     */
+    void UndoHistory::enforceBudget() {
+        while (m_memoryUsage > m_memoryBudget && !m_redo.empty()) {
+            m_memoryUsage -= m_redo.front()->getMemoryUsage();
+            m_redo.erase(m_redo.begin());
+            ++m_droppedGroups;
+        }
+
+        while (m_memoryUsage > m_memoryBudget && m_undo.size() > 1) {
+            spillOldest();
+        }
+    }
+
+    /**
+     * @brief Move the oldest undo group in memory to the spill file, discarding it if that fails.
+     */
+    void UndoHistory::spillOldest() {
+        if (!m_spill) {
+            m_spill = UndoSpill::create();
+        }
+
+        // The spilled groups are older still, so once this one is lost they
+        // could no longer be undone either
+        if (!m_spill || !m_spill->push(*m_undo.front())) {
+            dropSpilled();
+            ++m_droppedGroups;
+        }
+        m_memoryUsage -= m_undo.front()->getMemoryUsage();
+        m_undo.pop_front();
+    }
+
+    /**
+     * @brief Discard every spilled group, counting them as dropped.
+     */
+    void UndoHistory::dropSpilled() {
+        if (m_spill) {
+            m_droppedGroups += m_spill->getGroupCount();
+            m_spill->clear();
+        }
+    }
+
+}
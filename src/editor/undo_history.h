@@ -0,0 +1,334 @@
+#pragma once
+
+#include "editor/text_buffer.h"
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <span>
+#include <vector>
+
+namespace drite {
+
+    class UndoSpill;
+
+    /**
+     * @brief What an edit did, used to decide whether it extends the previous undo group.
+     */
+    enum class EditKind {
+        Typing,
+        DeleteBackward,
+        DeleteForward,
+        Other
+    };
+
+    /**
+     * @brief One replacement of a document range, stored as piece references.
+     *
+     * The removed and inserted text is never copied: the pieces reference the
+     * append-only backing buffers of the TextBuffer, and live in the piece pool
+     * of the owning UndoGroup.
+     */
+    struct EditDelta {
+        size_t offset{0};
+        size_t removedLength{0};
+        size_t insertedLength{0};
+        uint32_t removedFirst{0};
+        uint32_t removedCount{0};
+        uint32_t insertedFirst{0};
+        uint32_t insertedCount{0};
+    };
+
+    /**
+     * @brief Edits undone and redone as one step.
+     */
+    struct UndoGroup {
+        std::vector<EditDelta> deltas;
+        std::vector<Piece> pieces;
+        size_t cursorBefore{0};
+        size_t cursorAfter{0};
+
+        /**
+         * @brief Every cursor from before and from after a group edited with several cursors; empty otherwise.
+         */
+        std::vector<size_t> cursorsBefore;
+        std::vector<size_t> cursorsAfter;
+
+        EditKind kind{EditKind::Other};
+        bool sealed{false};
+
+        /**
+         * @brief Get the heap and inline memory held by the group.
+         * @return The size in bytes.
+         */
+        [[nodiscard]] size_t getMemoryUsage() const noexcept;
+    };
+
+    /**
+     * @brief Undo history counters.
+     */
+    struct UndoHistoryStats {
+        size_t undoGroups{0};
+        size_t redoGroups{0};
+        size_t memoryUsage{0};
+        uint64_t droppedGroups{0};
+
+        /**
+         * @brief The oldest undo groups, moved to disk to stay within the budget; undoable, and not counted in undoGroups.
+         */
+        size_t spilledGroups{0};
+        uint64_t spilledBytes{0};
+    };
+
+    /**
+     * @brief The groups of an undo history in memory, shared with it.
+     */
+    struct UndoHistorySnapshot {
+        /**
+         * @brief Groups that can be undone, oldest first.
+         */
+        std::vector<std::shared_ptr<const UndoGroup>> undo;
+
+        /**
+         * @brief Groups that can be redone, most recently undone last.
+         */
+        std::vector<std::shared_ptr<const UndoGroup>> redo;
+    };
+
+    /**
+     * @brief Undo/redo stacks of piece-reference deltas under a memory budget.
+     *
+     * Consecutive typing, backspacing or forward-deleting at adjoining offsets
+     * is coalesced into one group, with adjoining pieces merged, so a typed word
+     * costs a single delta referencing a single piece. Once the history outgrows
+     * its budget the oldest undo groups move to a temporary file, from which
+     * undo reads them back in turn; they are only discarded if the file cannot
+     * be written, and redo groups over the budget are discarded.
+     *
+     * Groups are held by shared pointer so share() can hand sealed ones to
+     * another thread without copying them.
+     *
+     * A group whose deltas run left to right without overlapping, such as an
+     * edit made at many cursors at once, is undone and redone as one batch
+     * with TextBuffer::replacePieces().
+     */
+    class UndoHistory {
+        public:
+            /**
+             * @brief Default memory budget in bytes.
+             */
+            static constexpr size_t DefaultMemoryBudget = 64 * 1024 * 1024;
+
+            /**
+             * @brief Construct a new Undo History object.
+             * @param memoryBudget The most memory the history may hold in bytes.
+             */
+            explicit UndoHistory(size_t memoryBudget = DefaultMemoryBudget);
+
+            /**
+             * @brief Destroy the Undo History object, deleting its spill file.
+             */
+            ~UndoHistory();
+
+            UndoHistory(UndoHistory&&) noexcept;
+            UndoHistory& operator=(UndoHistory&&) noexcept;
+            UndoHistory(const UndoHistory&) = delete;
+            UndoHistory& operator=(const UndoHistory&) = delete;
+
+            /**
+             * @brief Record an edit already applied to the buffer, clearing the redo stack.
+             * @param offset The byte offset of the edit.
+             * @param removed The pieces the edit removed, obtained before the edit.
+             * @param inserted The pieces the edit inserted, obtained after the edit.
+             * @param kind What the edit did.
+             * @param cursorBefore The cursor offset before the edit.
+             * @param cursorAfter The cursor offset after the edit.
+             */
+            void record(size_t offset, std::span<const Piece> removed, std::span<const Piece> inserted,
+                        EditKind kind, size_t cursorBefore, size_t cursorAfter);
+
+            /**
+             * @brief Close the current group so the next edit starts a new one.
+             */
+            void seal();
+
+            /**
+             * @brief Start a group that collects every edit until endGroup(), regardless of kind.
+             */
+            void beginGroup();
+
+            /**
+             * @brief Close the group opened with beginGroup().
+             */
+            void endGroup();
+
+            /**
+             * @brief Remember every cursor of an edit made with several cursors in the group opened with beginGroup().
+             * @param before The cursor offsets before the group.
+             * @param after The cursor offsets after the group.
+             */
+            void setGroupCursors(std::span<const size_t> before, std::span<const size_t> after);
+
+            /**
+             * @brief Revert the most recent group.
+             * @param buffer The buffer the edits were applied to.
+             * @param cursor Receives the primary cursor offset from before the group.
+             * @param cursors Receives every cursor offset from before the group, or nothing for a group edited with one cursor.
+             * @return True if a group was undone.
+             */
+            bool undo(TextBuffer& buffer, size_t& cursor, std::vector<size_t>& cursors);
+
+            /**
+             * @brief Reapply the most recently undone group.
+             * @param buffer The buffer the edits were applied to.
+             * @param cursor Receives the primary cursor offset from after the group.
+             * @param cursors Receives every cursor offset from after the group, or nothing for a group edited with one cursor.
+             * @return True if a group was redone.
+             */
+            bool redo(TextBuffer& buffer, size_t& cursor, std::vector<size_t>& cursors);
+
+            /**
+             * @brief Check whether there is anything to undo.
+             * @return True if undo() would succeed.
+             */
+            [[nodiscard]] bool canUndo() const noexcept;
+
+            /**
+             * @brief Check whether there is anything to redo.
+             * @return True if redo() would succeed.
+             */
+            [[nodiscard]] bool canRedo() const noexcept { return !m_redo.empty(); }
+
+            /**
+             * @brief Change the memory budget, discarding old groups if needed.
+             * @param bytes The most memory the history may hold in bytes.
+             */
+            void setMemoryBudget(size_t bytes);
+
+            /**
+             * @brief Discard all history.
+             */
+            void clear();
+
+            /**
+             * @brief Get the history counters.
+             * @return A snapshot of the counters.
+             */
+            [[nodiscard]] UndoHistoryStats getStats() const noexcept;
+
+            /**
+             * @brief Share the groups in memory, for saving the history on another thread.
+             *
+             * Sealed groups never change again, so they are shared as they are;
+             * only the open group is copied. Groups spilled to disk are older
+             * than all of these and are not included.
+             *
+             * @return The groups that can be undone and redone.
+             */
+            [[nodiscard]] UndoHistorySnapshot share() const;
+
+            /**
+             * @brief Replace the history with groups saved from an earlier one over the same buffer text.
+             *
+             * Every group is sealed, so the next edit starts a new one; the
+             * oldest groups are discarded if they do not fit the budget.
+             *
+             * @param undo The groups that can be undone, oldest first.
+             * @param redo The groups that can be redone, most recently undone last.
+             */
+            void restore(std::deque<UndoGroup> undo, std::vector<UndoGroup> redo);
+
+        private:
+            /**
+             * @brief Try to fold an edit into the last delta of the open group.
+             * @param group The open group.
+             * @param offset The byte offset of the edit.
+             * @param removed The removed pieces.
+             * @param inserted The inserted pieces.
+             * @param kind What the edit did.
+             * @return True if the edit was merged.
+             */
+            [[nodiscard]] static bool tryCoalesce(UndoGroup& group, size_t offset, std::span<const Piece> removed,
+                                                  std::span<const Piece> inserted, EditKind kind);
+
+            /**
+             * @brief Seal a group and release its spare capacity; the caller updates the accounting.
+             * @param group The group.
+             */
+            static void compact(UndoGroup& group);
+
+            /**
+             * @brief Check whether the deltas of a group can be applied as one batch.
+             * @param group The group.
+             * @return True if there are several deltas, each starting at or after the text the previous one inserted.
+             */
+            [[nodiscard]] static bool isBatch(const UndoGroup& group) noexcept;
+
+            /**
+             * @brief Append a delta for an edit to a group.
+             * @param group The group.
+             * @param offset The byte offset of the edit.
+             * @param removed The removed pieces.
+             * @param inserted The inserted pieces.
+             */
+            static void appendDelta(UndoGroup& group, size_t offset, std::span<const Piece> removed,
+                                    std::span<const Piece> inserted);
+
+            /**
+             * @brief Discard the redo stack.
+             */
+            void clearRedo();
+
+            /**
+             * @brief Spill the oldest undo groups, or discard them or redo groups, until the history fits its budget.
+             */
+            void enforceBudget();
+
+            /**
+             * @brief Move the oldest undo group in memory to the spill file, discarding it if that fails.
+             */
+            void spillOldest();
+
+            /**
+             * @brief Discard every spilled group, counting them as dropped.
+             */
+            void dropSpilled();
+
+        private:
+            /**
+             * @brief Groups that can be undone, oldest first.
+             */
+            std::deque<std::shared_ptr<UndoGroup>> m_undo;
+
+            /**
+             * @brief Groups that can be redone, most recently undone last.
+             */
+            std::vector<std::shared_ptr<UndoGroup>> m_redo;
+
+            /**
+             * @brief The most memory the history may hold in bytes.
+             */
+            size_t m_memoryBudget;
+
+            /**
+             * @brief Memory held by both stacks in bytes.
+             */
+            size_t m_memoryUsage{0};
+
+            /**
+             * @brief Nesting depth of beginGroup().
+             */
+            uint32_t m_groupDepth{0};
+
+            /**
+             * @brief Groups discarded to stay within the budget.
+             */
+            uint64_t m_droppedGroups{0};
+
+            /**
+             * @brief The oldest undo groups, moved out of memory; created on first use.
+             */
+            std::unique_ptr<UndoSpill> m_spill;
+    };
+
+}
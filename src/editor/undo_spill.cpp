@@ -0,0 +1,187 @@
+#include "editor/undo_spill.h"
+#include "io/temporary_file.h"
+#include <cerrno>
+#include <cstring>
+#include <print>
+#include <string>
+#include <type_traits>
+#include <unistd.h>
+
+namespace drite {
+
+    /**
+     * @brief The fixed part of a spilled group, followed by its deltas, pieces and cursors.
+     */
+    struct SpillRecord {
+        uint64_t deltaCount{0};
+        uint64_t pieceCount{0};
+        uint64_t cursorsBefore{0};
+        uint64_t cursorsAfter{0};
+        uint64_t cursorBefore{0};
+        uint64_t cursorAfter{0};
+        uint32_t kind{0};
+        uint32_t reserved{0};
+    };
+
+    static_assert(std::is_trivially_copyable_v<SpillRecord> && std::is_trivially_copyable_v<EditDelta> &&
+                  std::is_trivially_copyable_v<Piece>);
+
+    /**
+     * @brief Append the bytes of an array of trivially copyable values.
+     * @param bytes The record being built.
+     * @param values The values.
+     */
+    template <typename T>
+    static void appendArray(std::string& bytes, const std::vector<T>& values) {
+        bytes.append(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(T));
+    }
+
+    /**
+     * @brief Read an array of trivially copyable values from a record.
+     * @param bytes The record.
+     * @param offset The offset of the array; advanced past it.
+     * @param count The number of values.
+     * @param values Receives the values.
+     */
+    template <typename T>
+    static void readArray(const std::string& bytes, size_t& offset, size_t count, std::vector<T>& values) {
+        values.resize(count);
+        std::memcpy(values.data(), bytes.data() + offset, count * sizeof(T));
+        offset += count * sizeof(T);
+    }
+
+    /**
+     * @brief Create a spill file in $TMPDIR, or /tmp.
+     * @return The spill, or nullptr if no file could be created.
+     */
+    std::unique_ptr<UndoSpill> UndoSpill::create() {
+        std::string path;
+        const int file = createTemporaryFile("drite-undo", "", path);
+        if (file < 0) {
+            std::println(stderr, "Undo: failed to create a spill file: {}", std::strerror(errno));
+            return nullptr;
+        }
+
+        // Nothing else ever opens it, so it can go before it is used
+        ::unlink(path.c_str());
+        return std::unique_ptr<UndoSpill>(new UndoSpill(file));
+    }
+
+    /**
+     * @brief Construct an UndoSpill over an open, unlinked file.
+     * @param file The file descriptor, owned from now on.
+     */
+    UndoSpill::UndoSpill(int file) noexcept
+        : m_file(file) {}
+
+    /**
+     * @brief Close and so delete the spill file.
+     */
+    UndoSpill::~UndoSpill() {
+        ::close(m_file);
+    }
+
+    /**
+     * @brief Write a group on top of the stack.
+     * @param group The group; it is newer than every group already on the stack.
+     * @return True if written; false on a write error, leaving the stack unchanged.
+     */
+    bool UndoSpill::push(const UndoGroup& group) {
+        SpillRecord record;
+        record.deltaCount = group.deltas.size();
+        record.pieceCount = group.pieces.size();
+        record.cursorsBefore = group.cursorsBefore.size();
+        record.cursorsAfter = group.cursorsAfter.size();
+        record.cursorBefore = group.cursorBefore;
+        record.cursorAfter = group.cursorAfter;
+        record.kind = static_cast<uint32_t>(group.kind);
+
+        std::string bytes(reinterpret_cast<const char*>(&record), sizeof(record));
+        appendArray(bytes, group.deltas);
+        appendArray(bytes, group.pieces);
+        appendArray(bytes, group.cursorsBefore);
+        appendArray(bytes, group.cursorsAfter);
+
+        size_t written{0};
+        while (written < bytes.size()) {
+            const ssize_t result = ::pwrite(m_file, bytes.data() + written, bytes.size() - written,
+                                            static_cast<off_t>(m_size + written));
+            if (result < 0 && errno == EINTR) {
+                continue;
+            }
+            if (result <= 0) {
+                std::println(stderr, "Undo: failed to write to the spill file: {}", std::strerror(errno));
+                return false;
+            }
+            written += static_cast<size_t>(result);
+        }
+
+        m_offsets.push_back(m_size);
+        m_size += bytes.size();
+        return true;
+    }
+
+    /**
+     * @brief Read back the group on top of the stack and remove it.
+     * @return The group, or std::nullopt if the stack is empty or the record could not be read.
+     */
+    std::optional<UndoGroup> UndoSpill::pop() {
+        if (m_offsets.empty()) {
+            return std::nullopt;
+        }
+
+        const uint64_t offset = m_offsets.back();
+        std::string bytes(static_cast<size_t>(m_size - offset), '\0');
+        size_t read{0};
+        while (read < bytes.size()) {
+            const ssize_t result = ::pread(m_file, bytes.data() + read, bytes.size() - read, static_cast<off_t>(offset + read));
+            if (result < 0 && errno == EINTR) {
+                continue;
+            }
+            if (result <= 0) {
+                std::println(stderr, "Undo: failed to read from the spill file: {}", std::strerror(errno));
+                return std::nullopt;
+            }
+            read += static_cast<size_t>(result);
+        }
+
+        SpillRecord record;
+        if (bytes.size() < sizeof(record)) {
+            return std::nullopt;
+        }
+        std::memcpy(&record, bytes.data(), sizeof(record));
+        const uint64_t expected = sizeof(record) + record.deltaCount * sizeof(EditDelta) + record.pieceCount * sizeof(Piece) +
+                                  (record.cursorsBefore + record.cursorsAfter) * sizeof(size_t);
+        if (expected != bytes.size()) {
+            std::println(stderr, "Undo: the spill file holds a damaged group");
+            return std::nullopt;
+        }
+
+        UndoGroup group;
+        size_t position = sizeof(record);
+        readArray(bytes, position, static_cast<size_t>(record.deltaCount), group.deltas);
+        readArray(bytes, position, static_cast<size_t>(record.pieceCount), group.pieces);
+        readArray(bytes, position, static_cast<size_t>(record.cursorsBefore), group.cursorsBefore);
+        readArray(bytes, position, static_cast<size_t>(record.cursorsAfter), group.cursorsAfter);
+        group.cursorBefore = static_cast<size_t>(record.cursorBefore);
+        group.cursorAfter = static_cast<size_t>(record.cursorAfter);
+        group.kind = static_cast<EditKind>(record.kind);
+        group.sealed = true;
+
+        // Give the space back; the next push writes over it anyway
+        m_offsets.pop_back();
+        m_size = offset;
+        static_cast<void>(::ftruncate(m_file, static_cast<off_t>(m_size)));
+        return group;
+    }
+
+    /**
+     * @brief Remove every group.
+     */
+    void UndoSpill::clear() {
+        m_offsets.clear();
+        m_size = 0;
+        static_cast<void>(::ftruncate(m_file, 0));
+    }
+
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include "editor/undo_history.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <vector>
+
+namespace drite {
+
+    /**
+     * @brief Stack of undo groups moved out of memory into an anonymous temporary file.
+     *
+     * A history that outgrows its memory budget pushes its oldest groups here
+     * and pops them back when undo reaches them, so old edits stay undoable
+     * at the cost of disk space. Groups hold piece references rather than
+     * text, so each record is small. The file is unlinked as soon as it is
+     * created and only this process reads it, so records are raw copies of
+     * the group's arrays with no versioning, and nothing is left behind.
+     */
+    class UndoSpill {
+        public:
+            /**
+             * @brief Create a spill file in $TMPDIR, or /tmp.
+             * @return The spill, or nullptr if no file could be created.
+             */
+            [[nodiscard]] static std::unique_ptr<UndoSpill> create();
+
+            /**
+             * @brief Close and so delete the spill file.
+             */
+            ~UndoSpill();
+
+            UndoSpill(const UndoSpill&) = delete;
+            UndoSpill& operator=(const UndoSpill&) = delete;
+
+            /**
+             * @brief Write a group on top of the stack.
+             * @param group The group; it is newer than every group already on the stack.
+             * @return True if written; false on a write error, leaving the stack unchanged.
+             */
+            [[nodiscard]] bool push(const UndoGroup& group);
+
+            /**
+             * @brief Read back the group on top of the stack and remove it.
+             * @return The group, or std::nullopt if the stack is empty or the record could not be read.
+             */
+            [[nodiscard]] std::optional<UndoGroup> pop();
+
+            /**
+             * @brief Remove every group.
+             */
+            void clear();
+
+            /**
+             * @brief Get the number of groups on the stack.
+             * @return The group count.
+             */
+            [[nodiscard]] size_t getGroupCount() const noexcept { return m_offsets.size(); }
+
+            /**
+             * @brief Get the bytes the groups take on disk.
+             * @return The file size.
+             */
+            [[nodiscard]] uint64_t getSize() const noexcept { return m_size; }
+
+        private:
+            /**
+             * @brief Construct an UndoSpill over an open, unlinked file.
+             * @param file The file descriptor, owned from now on.
+             */
+            explicit UndoSpill(int file) noexcept;
+
+        private:
+            /**
+             * @brief The spill file descriptor.
+             */
+            int m_file;
+
+            /**
+             * @brief The offset of each group's record, oldest first.
+             */
+            std::vector<uint64_t> m_offsets;
+
+            /**
+             * @brief The end of the last record, and the size of the file.
+             */
+            uint64_t m_size{0};
+    };
+
+}
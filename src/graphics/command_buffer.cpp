@@ -0,0 +1,155 @@
+#include "graphics/command_buffer.h"
+#include <algorithm>
+#include <array>
+
+namespace drite {
+
+    /**
+     * @brief Convert a normalized color channel to an 8-bit value.
+     * @param value The channel value in [0, 1].
+     * @return The 8-bit channel value.
+     */
+    static uint32_t toChannel(float value) noexcept {
+        // Rounds like lround for the non-negative values left after clamping, without the library call
+        return static_cast<uint32_t>(std::clamp(value, 0.0f, 1.0f) * 255.0f + 0.5f);
+    }
+
+    /**
+     * @brief Forget the recorded commands, keeping the storage.
+     */
+    void CommandBuffer::reset() {
+        m_recorded.clear();
+        m_textureSlots.clear();
+        m_textures.resize(1);
+        m_sorted.clear();
+        m_batches.clear();
+        m_stats = CommandBufferStats{};
+    }
+
+    /**
+     * @brief Append the commands of a draw list.
+     * @param drawList The commands; glyphs are skipped if it has no glyph texture.
+     */
+    void CommandBuffer::record(const DrawList& drawList) {
+        const AlphaTexture* texture = drawList.getGlyphTexture();
+        uint16_t slot{0};
+        if (texture) {
+            const auto found = std::find(m_textures.begin(), m_textures.end(), texture);
+            slot = static_cast<uint16_t>(found - m_textures.begin());
+            if (found == m_textures.end()) {
+                m_textures.push_back(texture);
+            }
+        }
+
+        for (const DrawCommand& command : drawList.getCommands()) {
+            const bool glyph = command.type == DrawCommandType::Glyph;
+            if (glyph && !texture) {
+                continue;
+            }
+            m_recorded.push_back(command);
+            m_textureSlots.push_back(glyph ? slot : 0);
+        }
+    }
+
+    /**
+     * @brief Sort the recorded commands into batches.
+     */
+    void CommandBuffer::finish() {
+        const size_t textureCount = m_textures.size();
+        const auto keyOf = [&](size_t index) {
+            const DrawCommand& command = m_recorded[index];
+            const size_t group = static_cast<size_t>(command.layer) * DrawCommandTypeCount + static_cast<size_t>(command.type);
+            return static_cast<uint32_t>(group * textureCount + m_textureSlots[index]);
+        };
+
+        m_keyStarts.assign(DrawLayerCount * DrawCommandTypeCount * textureCount, 0);
+        for (size_t i = 0; i < m_recorded.size(); ++i) {
+            ++m_keyStarts[keyOf(i)];
+        }
+
+        // Each layer starts with the kind and texture the one below ended
+        // with, so the two can share a batch
+        m_keyOrder.clear();
+        auto lastType = DrawCommandType::Rect;
+        uint16_t lastSlot{0};
+        for (size_t layer = 0; layer < DrawLayerCount; ++layer) {
+            std::array<DrawCommandType, DrawCommandTypeCount> types{lastType};
+            size_t typeCount{1};
+            for (size_t type = 0; type < DrawCommandTypeCount; ++type) {
+                if (static_cast<DrawCommandType>(type) != lastType) {
+                    types[typeCount++] = static_cast<DrawCommandType>(type);
+                }
+            }
+
+            const uint16_t layerSlot = lastSlot;
+            for (const DrawCommandType type : types) {
+                const size_t group = layer * DrawCommandTypeCount + static_cast<size_t>(type);
+                const size_t slots = type == DrawCommandType::Glyph ? textureCount : 1;
+                for (size_t i = 0; i < slots; ++i) {
+                    // Texture slots are visited starting from the one still bound
+                    const size_t slot = slots == 1 ? 0 : (layerSlot + i) % slots;
+                    const auto key = static_cast<uint32_t>(group * textureCount + slot);
+                    if (m_keyStarts[key] > 0) {
+                        m_keyOrder.push_back(key);
+                        lastType = type;
+                        lastSlot = slots == 1 ? lastSlot : static_cast<uint16_t>(slot);
+                    }
+                }
+            }
+        }
+
+        // Batches and the first index of every key, in drawing order
+        m_batches.clear();
+        m_stats = CommandBufferStats{};
+        m_stats.commands = m_recorded.size();
+        const AlphaTexture* boundTexture{nullptr};
+        uint32_t offset{0};
+        for (const uint32_t key : m_keyOrder) {
+            const uint32_t count = m_keyStarts[key];
+            const auto type = static_cast<DrawCommandType>(key / textureCount % DrawCommandTypeCount);
+            const AlphaTexture* texture = m_textures[key % textureCount];
+            if (!m_batches.empty() && m_batches.back().type == type && m_batches.back().texture == texture) {
+                m_batches.back().count += count;
+            } else {
+                m_stats.pipelineChanges += m_batches.empty() || m_batches.back().type != type;
+                m_stats.textureChanges += texture && texture != boundTexture;
+                boundTexture = texture ? texture : boundTexture;
+                m_batches.push_back(DrawBatch{type, texture, offset, count});
+            }
+            m_keyStarts[key] = offset;
+            offset += count;
+        }
+        m_stats.batches = m_batches.size();
+
+        m_sorted.resize(m_recorded.size());
+        for (size_t i = 0; i < m_recorded.size(); ++i) {
+            m_sorted[m_keyStarts[keyOf(i)]++] = m_recorded[i];
+        }
+
+        for (size_t i = 0; i < m_recorded.size(); ++i) {
+            m_stats.unsortedBatches += i == 0 || m_recorded[i].type != m_recorded[i - 1].type ||
+                                       m_textureSlots[i] != m_textureSlots[i - 1];
+        }
+    }
+
+    /**
+     * @brief Convert sorted commands to GPU instances.
+     * @param commands The commands.
+     * @param instances Receives one instance per command; at least as long as commands.
+     */
+    void writeInstances(std::span<const DrawCommand> commands, QuadInstance* instances) noexcept {
+        for (const DrawCommand& command : commands) {
+            QuadInstance& instance = *instances++;
+            instance.x0 = static_cast<float>(command.x);
+            instance.y0 = static_cast<float>(command.y);
+            instance.x1 = static_cast<float>(command.x + command.width);
+            instance.y1 = static_cast<float>(command.y + command.height);
+            instance.u = static_cast<float>(command.u);
+            instance.v = static_cast<float>(command.v);
+            instance.color = toChannel(command.color.r) | (toChannel(command.color.g) << 8) |
+                             (toChannel(command.color.b) << 16) | (toChannel(command.color.a) << 24);
+            instance.type = static_cast<uint32_t>(command.type);
+        }
+    }
+
+}
@@ -0,0 +1,168 @@
+#pragma once
+
+#include "graphics/draw_list.h"
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace drite {
+
+    /**
+     * @brief A run of sorted commands drawn with one pipeline and texture, e.g. one instanced draw call.
+     */
+    struct DrawBatch {
+        DrawCommandType type{DrawCommandType::Rect};
+        const AlphaTexture* texture{nullptr};
+        uint32_t first{0};
+        uint32_t count{0};
+    };
+
+    /**
+     * @brief What drawing the recorded frame costs a backend.
+     */
+    struct CommandBufferStats {
+        /**
+         * @brief Commands recorded.
+         */
+        size_t commands{0};
+
+        /**
+         * @brief Batches they were sorted into.
+         */
+        size_t batches{0};
+
+        /**
+         * @brief Batches the commands would take if drawn in the order they were added.
+         */
+        size_t unsortedBatches{0};
+
+        /**
+         * @brief Pipeline binds between batches, including the first.
+         */
+        size_t pipelineChanges{0};
+
+        /**
+         * @brief Glyph texture binds between batches, including the first.
+         */
+        size_t textureChanges{0};
+    };
+
+    /**
+     * @brief One command as a GPU instance: a quad expanded by the vertex shader.
+     *
+     * Rects and glyphs span (x0, y0) to (x1, y1), glyphs sampling the texture
+     * from (u, v); lines run from (x0, y0) to (x1, y1) and are u pixels thick.
+     * The color is RGBA8, red in the lowest byte.
+     */
+    struct QuadInstance {
+        float x0{0.0f};
+        float y0{0.0f};
+        float x1{0.0f};
+        float y1{0.0f};
+        float u{0.0f};
+        float v{0.0f};
+        uint32_t color{0};
+        uint32_t type{0};
+    };
+
+    /**
+     * @brief Records the draw lists of a frame and sorts them into batches.
+     *
+     * Commands are sorted by layer, then kind, then glyph texture, keeping
+     * the order they were added within each group, as DrawList allows. The
+     * sort is a counting sort over the few distinct keys, so it costs one
+     * pass over the commands. To save state changes each layer starts with
+     * the kind, and glyphs with the texture, the layer below ended with, and
+     * a run of the same kind and texture across layers is one batch; a
+     * screen of text is then a few batches however many glyphs it has.
+     *
+     * The recorder is independent of any graphics API, so backends share it
+     * and batching can be measured without a GPU.
+     */
+    class CommandBuffer {
+        public:
+            /**
+             * @brief Forget the recorded commands, keeping the storage.
+             */
+            void reset();
+
+            /**
+             * @brief Append the commands of a draw list.
+             * @param drawList The commands; glyphs are skipped if it has no glyph texture.
+             */
+            void record(const DrawList& drawList);
+
+            /**
+             * @brief Sort the recorded commands into batches.
+             */
+            void finish();
+
+            /**
+             * @brief Get the sorted commands; valid after finish().
+             * @return The commands in drawing order.
+             */
+            [[nodiscard]] std::span<const DrawCommand> getCommands() const noexcept { return m_sorted; }
+
+            /**
+             * @brief Get the batches; valid after finish().
+             * @return The batches in drawing order, covering getCommands().
+             */
+            [[nodiscard]] std::span<const DrawBatch> getBatches() const noexcept { return m_batches; }
+
+            /**
+             * @brief Get the cost of the frame; valid after finish().
+             * @return The counters.
+             */
+            [[nodiscard]] const CommandBufferStats& getStats() const noexcept { return m_stats; }
+
+        private:
+            /**
+             * @brief The commands in the order they were recorded.
+             */
+            std::vector<DrawCommand> m_recorded;
+
+            /**
+             * @brief The index in m_textures of each recorded command's texture, 0 for none.
+             */
+            std::vector<uint16_t> m_textureSlots;
+
+            /**
+             * @brief The distinct glyph textures recorded, after nullptr at index 0.
+             */
+            std::vector<const AlphaTexture*> m_textures{nullptr};
+
+            /**
+             * @brief Commands per sort key, then the first index of each key.
+             */
+            std::vector<uint32_t> m_keyStarts;
+
+            /**
+             * @brief The sort keys in drawing order.
+             */
+            std::vector<uint32_t> m_keyOrder;
+
+            /**
+             * @brief The commands in drawing order.
+             */
+            std::vector<DrawCommand> m_sorted;
+
+            /**
+             * @brief The batches in drawing order.
+             */
+            std::vector<DrawBatch> m_batches;
+
+            /**
+             * @brief The cost of the frame.
+             */
+            CommandBufferStats m_stats;
+    };
+
+    /**
+     * @brief Convert sorted commands to GPU instances.
+     * @param commands The commands.
+     * @param instances Receives one instance per command; at least as long as commands.
+     */
+    void writeInstances(std::span<const DrawCommand> commands, QuadInstance* instances) noexcept;
+
+}
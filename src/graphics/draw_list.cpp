@@ -0,0 +1,72 @@
+#include "graphics/draw_list.h"
+#include <memory>
+
+namespace drite {
+
+    /**
+     * @brief Remove all commands and store the next ones in a new resource.
+     * @param resource The memory for the commands, e.g. of the frame arena; must outlive the list's use of it.
+     */
+    void DrawList::reset(std::pmr::memory_resource* resource) {
+        // The old storage may belong to an arena block that has since been
+        // rewound, so the vector is rebuilt on the new resource instead of
+        // cleared, reserving room for as many commands as last time
+        const size_t count = m_commands.size();
+        std::destroy_at(&m_commands);
+        std::construct_at(&m_commands, resource);
+        m_commands.reserve(count);
+        m_glyphTexture = nullptr;
+    }
+
+    /**
+     * @brief Add a filled rectangle.
+     * @param x The left edge in pixels.
+     * @param y The top edge in pixels.
+     * @param width The width in pixels.
+     * @param height The height in pixels.
+     * @param color The fill color; alpha below 1 blends with what is underneath.
+     * @param layer The layer to draw in.
+     */
+    void DrawList::addRect(int x, int y, int width, int height, const Color& color, DrawLayer layer) {
+        if (width <= 0 || height <= 0 || color.a <= 0.0f) {
+            return;
+        }
+        m_commands.push_back(DrawCommand{DrawCommandType::Rect, layer, x, y, width, height, 0, 0, color});
+    }
+
+    /**
+     * @brief Add an antialiased line segment.
+     * @param x0 The x of the start in pixels.
+     * @param y0 The y of the start in pixels.
+     * @param x1 The x of the end in pixels.
+     * @param y1 The y of the end in pixels.
+     * @param thickness The thickness in pixels.
+     * @param color The line color.
+     * @param layer The layer to draw in.
+     */
+    void DrawList::addLine(int x0, int y0, int x1, int y1, int thickness, const Color& color, DrawLayer layer) {
+        if (thickness <= 0 || color.a <= 0.0f) {
+            return;
+        }
+        m_commands.push_back(DrawCommand{DrawCommandType::Line, layer, x0, y0, x1 - x0, y1 - y0, thickness, 0, color});
+    }
+
+    /**
+     * @brief Add a glyph quad sampling coverage from the glyph texture.
+     * @param x The left edge in pixels.
+     * @param y The top edge in pixels.
+     * @param width The width in pixels.
+     * @param height The height in pixels.
+     * @param u The left edge of the glyph in the texture.
+     * @param v The top edge of the glyph in the texture.
+     * @param color The text color.
+     * @param layer The layer to draw in.
+     */
+    void DrawList::addGlyph(int x, int y, int width, int height, int u, int v, const Color& color, DrawLayer layer) {
+        if (width <= 0 || height <= 0 || color.a <= 0.0f) {
+            return;
+        }
+        m_commands.push_back(DrawCommand{DrawCommandType::Glyph, layer, x, y, width, height, u, v, color});
+    }
+
+}
@@ -0,0 +1,168 @@
+#pragma once
+
+#include "graphics/graphics_context.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <span>
+#include <vector>
+
+namespace drite {
+
+    /**
+     * @struct AlphaTexture
+     * @brief A CPU-side 8-bit coverage image, such as a glyph atlas.
+     * 
+     * Backends sample glyph coverage from it directly (software) or upload it when
+     * the version changes (GPU).
+     */
+    struct AlphaTexture {
+        const uint8_t* pixels{nullptr};
+        int width{0};
+        int height{0};
+        int stride{0};
+        uint64_t version{0};
+    };
+
+    /**
+     * @brief Kinds of draw commands.
+     */
+    enum class DrawCommandType : uint8_t {
+        Rect,
+        Line,
+        Glyph
+    };
+
+    /**
+     * @brief Number of draw command kinds.
+     */
+    inline constexpr size_t DrawCommandTypeCount = 3;
+
+    /**
+     * @brief Depth of a draw command; each layer is drawn over the ones before it.
+     */
+    enum class DrawLayer : uint8_t {
+        Background,
+        Text,
+        Overlay
+    };
+
+    /**
+     * @brief Number of draw layers.
+     */
+    inline constexpr size_t DrawLayerCount = 3;
+
+    /**
+     * @struct DrawCommand
+     * @brief A single primitive in framebuffer pixel coordinates.
+     * 
+     * Rects fill their area with the color; glyphs modulate the color by the
+     * coverage read from the glyph texture at (u, v). Lines draw an
+     * antialiased segment from (x, y) to (x + width, y + height), u pixels
+     * thick.
+     */
+    struct DrawCommand {
+        DrawCommandType type{DrawCommandType::Rect};
+        DrawLayer layer{DrawLayer::Text};
+        int x{0};
+        int y{0};
+        int width{0};
+        int height{0};
+        int u{0};
+        int v{0};
+        Color color;
+    };
+
+    /**
+     * @class DrawList
+     * @brief The draw commands of one frame.
+     *
+     * Layers are drawn back to front. Within a layer, commands of one kind
+     * are drawn in the order they were added, but backends may draw the
+     * kinds in any order to batch them, so commands that must cover others
+     * of a different kind go in a higher layer.
+     *
+     * Commands are stored in memory from a std::pmr resource, usually the
+     * frame arena, given again at every reset.
+     */
+    class DrawList {
+        public:
+            /**
+             * @brief Remove all commands and store the next ones in a new resource.
+             * @param resource The memory for the commands, e.g. of the frame arena; must outlive the list's use of it.
+             */
+            void reset(std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+            /**
+             * @brief Add a filled rectangle.
+             * @param x The left edge in pixels.
+             * @param y The top edge in pixels.
+             * @param width The width in pixels.
+             * @param height The height in pixels.
+             * @param color The fill color; alpha below 1 blends with what is underneath.
+             * @param layer The layer to draw in.
+             */
+            void addRect(int x, int y, int width, int height, const Color& color, DrawLayer layer = DrawLayer::Text);
+
+            /**
+             * @brief Add an antialiased line segment.
+             * @param x0 The x of the start in pixels.
+             * @param y0 The y of the start in pixels.
+             * @param x1 The x of the end in pixels.
+             * @param y1 The y of the end in pixels.
+             * @param thickness The thickness in pixels.
+             * @param color The line color.
+             * @param layer The layer to draw in.
+             */
+            void addLine(int x0, int y0, int x1, int y1, int thickness, const Color& color, DrawLayer layer = DrawLayer::Text);
+
+            /**
+             * @brief Add a glyph quad sampling coverage from the glyph texture.
+             * @param x The left edge in pixels.
+             * @param y The top edge in pixels.
+             * @param width The width in pixels.
+             * @param height The height in pixels.
+             * @param u The left edge of the glyph in the texture.
+             * @param v The top edge of the glyph in the texture.
+             * @param color The text color.
+             * @param layer The layer to draw in.
+             */
+            void addGlyph(int x, int y, int width, int height, int u, int v, const Color& color, DrawLayer layer = DrawLayer::Text);
+
+            /**
+             * @brief Set the texture glyph quads sample their coverage from.
+             * @param texture The glyph texture; must outlive the frame.
+             */
+            void setGlyphTexture(const AlphaTexture* texture) noexcept { m_glyphTexture = texture; }
+
+            /**
+             * @brief Get the texture glyph quads sample their coverage from.
+             * @return The glyph texture, or nullptr if none was set.
+             */
+            [[nodiscard]] const AlphaTexture* getGlyphTexture() const noexcept { return m_glyphTexture; }
+
+            /**
+             * @brief Get the recorded commands.
+             * @return The commands in the order they were added.
+             */
+            [[nodiscard]] std::span<const DrawCommand> getCommands() const noexcept { return m_commands; }
+
+            /**
+             * @brief Check whether the list holds no commands.
+             * @return True if the list is empty.
+             */
+            [[nodiscard]] bool isEmpty() const noexcept { return m_commands.empty(); }
+
+        private:
+            /**
+             * @brief The recorded commands.
+             */
+            std::pmr::vector<DrawCommand> m_commands;
+
+            /**
+             * @brief The texture glyph quads sample their coverage from.
+             */
+            const AlphaTexture* m_glyphTexture{nullptr};
+    };
+
+}
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <span>
+
 namespace drite {
 
     /**
@@ -25,6 +27,31 @@ namespace drite {
             : r(r), g(g), b(b), a(a) {}
     };
 
+    /**
+     * @brief Colors of draw commands share the ClearColor representation.
+     */
+    using Color = ClearColor;
+
+    /**
+     * @struct Rect
+     * @brief An axis-aligned rectangle in framebuffer pixels.
+     */
+    struct Rect {
+        int x{0};
+        int y{0};
+        int width{0};
+        int height{0};
+
+        /**
+         * @brief Check whether the rectangle covers no pixels.
+         * @return True if the width or height is not positive.
+         */
+        [[nodiscard]] constexpr bool isEmpty() const noexcept { return width <= 0 || height <= 0; }
+    };
+
+    class DrawList;
+    struct CommandBufferStats;
+
     
     /**
      * @class GraphicsContext
@@ -59,6 +86,23 @@ namespace drite {
          */
         virtual void clear(const ClearColor& color) = 0;
 
+        /**
+         * @brief Submit draw commands for the current frame, drawn after the clear.
+         * @param drawList The commands to draw; only needs to live until the call returns.
+         */
+        virtual void submit(const DrawList& drawList) = 0;
+
+        /**
+         * @brief Limit the current frame to the given damaged regions.
+         * 
+         * Pixels outside the rects keep their contents from the previous frame.
+         * Contexts that cannot preserve contents redraw everything. Resets to the
+         * full surface at every beginFrame().
+         * 
+         * @param rects The damaged regions; empty redraws the full surface.
+         */
+        virtual void setDamage(std::span<const Rect> rects) = 0;
+
         /**
          * @brief Enable or disable vertical synchronization (VSync).
          * @param enabled True to enable VSync, false to disable.
@@ -72,6 +116,12 @@ namespace drite {
          */
         virtual void getViewportSize(int& width, int& height) const = 0;
 
+        /**
+         * @brief Get how the draw commands of the last frame were batched.
+         * @return The counters of the last ended frame.
+         */
+        [[nodiscard]] virtual const CommandBufferStats& getDrawStats() const = 0;
+
         /**
          * @brief Get the native graphics device handle.
          * @return Pointer to the native device.
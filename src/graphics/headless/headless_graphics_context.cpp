@@ -0,0 +1,18 @@
+#include "graphics/headless/headless_graphics_context.h"
+
+namespace drite {
+
+    /**
+     * @brief Construct a new Headless Graphics Context object.
+     * @param width The framebuffer width in pixels.
+     * @param height The framebuffer height in pixels.
+     */
+    HeadlessGraphicsContext::HeadlessGraphicsContext(int width, int height)
+        : SoftwareGraphicsContext(width, height) {}
+
+
+    /**
+     * @brief Destroy the Headless Graphics Context object.
+     */
+    HeadlessGraphicsContext::~HeadlessGraphicsContext() = default;
+}
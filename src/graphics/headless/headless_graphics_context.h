@@ -0,0 +1,30 @@
+#pragma once
+
+#include "graphics/software/software_graphics_context.h"
+
+namespace drite {
+
+    /**
+    * @class HeadlessGraphicsContext
+    * @brief Offscreen graphics context for the headless platform.
+    * 
+    * Renders with the software rasterizer into a CPU-side BGRA8 framebuffer
+    * instead of a display surface, so frames can be produced and inspected
+    * without a GPU. Nothing is presented.
+    */
+    class HeadlessGraphicsContext : public SoftwareGraphicsContext {
+        public:
+
+            /**
+            * @brief Construct a new Headless Graphics Context object.
+            * @param width The framebuffer width in pixels.
+            * @param height The framebuffer height in pixels.
+            */
+            HeadlessGraphicsContext(int width, int height);
+
+            /**
+            * @brief Destroy the Headless Graphics Context object.
+            */
+            ~HeadlessGraphicsContext() override;
+    };
+}
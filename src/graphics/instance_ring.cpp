@@ -0,0 +1,73 @@
+#include "graphics/instance_ring.h"
+#include <algorithm>
+#include <iterator>
+
+namespace drite {
+
+    /**
+     * @brief Construct a new Instance Ring object.
+     * @param capacity The buffer size in bytes, a multiple of every alignment asked for.
+     */
+    InstanceRing::InstanceRing(size_t capacity)
+        : m_capacity(capacity) {}
+
+    /**
+     * @brief Forget every allocation and use a buffer of a new size; only once the GPU is idle.
+     * @param capacity The buffer size in bytes, a multiple of every alignment asked for.
+     */
+    void InstanceRing::reset(size_t capacity) {
+        m_capacity = capacity;
+        m_head = 0;
+        m_tail = 0;
+        m_pending.clear();
+    }
+
+    /**
+     * @brief Reserve contiguous space for the current frame.
+     * @param bytes The size in bytes.
+     * @param alignment The alignment of the offset, a power of two.
+     * @return The offset in the buffer, or nullopt if frames in flight hold too much of it.
+     */
+    std::optional<size_t> InstanceRing::allocate(size_t bytes, size_t alignment) {
+        if (m_capacity == 0 || bytes > m_capacity) {
+            return std::nullopt;
+        }
+
+        // An allocation never straddles the end of the buffer; the rest of the
+        // buffer is skipped instead
+        uint64_t start = (m_head + alignment - 1) & ~static_cast<uint64_t>(alignment - 1);
+        if (start % m_capacity + bytes > m_capacity) {
+            start += m_capacity - start % m_capacity;
+        }
+        if (start + bytes - m_tail > m_capacity) {
+            return std::nullopt;
+        }
+
+        m_head = start + bytes;
+        return static_cast<size_t>(start % m_capacity);
+    }
+
+    /**
+     * @brief Close the current frame; its space stays reserved until it is retired.
+     * @param frame The frame number, increasing from frame to frame.
+     */
+    void InstanceRing::endFrame(uint64_t frame) {
+        m_pending.push_back(PendingFrame{frame, m_head});
+    }
+
+    /**
+     * @brief Release the space of the frames the GPU finished.
+     * @param frame The latest finished frame; earlier frames are finished too.
+     */
+    void InstanceRing::retire(uint64_t frame) {
+        const auto finished = std::find_if(m_pending.begin(), m_pending.end(), [frame](const PendingFrame& pending) {
+            return pending.frame > frame;
+        });
+        if (finished == m_pending.begin()) {
+            return;
+        }
+        m_tail = std::prev(finished)->end;
+        m_pending.erase(m_pending.begin(), finished);
+    }
+
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+namespace drite {
+
+    /**
+     * @brief Hands out space in a persistent buffer the CPU fills while the GPU reads earlier frames.
+     *
+     * The buffer is used as a ring: each frame's allocations follow the
+     * previous frame's, wrapping to the start when they reach the end, and
+     * space is reclaimed only once the GPU reports that it finished the frame
+     * that used it. Positions are kept as ever-growing byte counts, so a full
+     * ring and an empty one are never confused.
+     *
+     * The class only does the bookkeeping; the backend owns the buffer, e.g.
+     * a shared MTLBuffer, and reports finished frames with retire().
+     */
+    class InstanceRing {
+        public:
+            /**
+             * @brief Construct a new Instance Ring object.
+             * @param capacity The buffer size in bytes, a multiple of every alignment asked for.
+             */
+            explicit InstanceRing(size_t capacity = 0);
+
+            /**
+             * @brief Forget every allocation and use a buffer of a new size; only once the GPU is idle.
+             * @param capacity The buffer size in bytes, a multiple of every alignment asked for.
+             */
+            void reset(size_t capacity);
+
+            /**
+             * @brief Reserve contiguous space for the current frame.
+             * @param bytes The size in bytes.
+             * @param alignment The alignment of the offset, a power of two.
+             * @return The offset in the buffer, or nullopt if frames in flight hold too much of it.
+             */
+            [[nodiscard]] std::optional<size_t> allocate(size_t bytes, size_t alignment = 16);
+
+            /**
+             * @brief Close the current frame; its space stays reserved until it is retired.
+             * @param frame The frame number, increasing from frame to frame.
+             */
+            void endFrame(uint64_t frame);
+
+            /**
+             * @brief Release the space of the frames the GPU finished.
+             * @param frame The latest finished frame; earlier frames are finished too.
+             */
+            void retire(uint64_t frame);
+
+            /**
+             * @brief Get the buffer size.
+             * @return The size in bytes.
+             */
+            [[nodiscard]] size_t getCapacity() const noexcept { return m_capacity; }
+
+            /**
+             * @brief Get the space held by unfinished frames, including padding skipped at the end of the buffer.
+             * @return The size in bytes.
+             */
+            [[nodiscard]] size_t getUsed() const noexcept { return static_cast<size_t>(m_head - m_tail); }
+
+        private:
+            /**
+             * @brief A closed frame waiting for the GPU.
+             */
+            struct PendingFrame {
+                uint64_t frame{0};
+                uint64_t end{0};
+            };
+
+            /**
+             * @brief The buffer size.
+             */
+            size_t m_capacity{0};
+
+            /**
+             * @brief Bytes handed out since the last reset; the buffer offset is this modulo the capacity.
+             */
+            uint64_t m_head{0};
+
+            /**
+             * @brief The value of m_head when the last retired frame ended; the space before it is free.
+             */
+            uint64_t m_tail{0};
+
+            /**
+             * @brief Closed frames not yet retired, oldest first.
+             */
+            std::vector<PendingFrame> m_pending;
+    };
+
+}
@@ -1,6 +1,13 @@
 #pragma once
 
+#include "graphics/command_buffer.h"
 #include "graphics/graphics_context.h"
+#include "graphics/instance_ring.h"
+#include <array>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <optional>
 
 /**
  * Forward declarations for Metal objects used in the graphics context.
@@ -8,10 +15,16 @@
 #ifdef __OBJC__
 @protocol MTLDevice;
 @protocol MTLCommandQueue;
+@protocol MTLRenderPipelineState;
+@protocol MTLBuffer;
+@protocol MTLTexture;
 @class MTKView;
 #else
 typedef struct objc_object MTLDevice;
 typedef struct objc_object MTLCommandQueue;
+typedef struct objc_object MTLRenderPipelineState;
+typedef struct objc_object MTLBuffer;
+typedef struct objc_object MTLTexture;
 typedef struct objc_object MTKView;
 #endif
 
@@ -23,6 +36,12 @@ namespace drite {
     * 
     * Implements the GraphicsContext interface using Apple's Metal API.
     * Manages the Metal device, command queue, and drawable view for rendering.
+    * 
+    * Draw lists are recorded into a CommandBuffer and each of its batches is
+    * one instanced draw of a quad, with one pipeline per command kind. The
+    * instances are written into a persistent shared buffer used as a ring, so
+    * the CPU fills the next frame while the GPU still reads up to
+    * MaxFramesInFlight earlier ones.
     */
     class MetalGraphicsContext : public GraphicsContext {
         public:
@@ -60,6 +79,18 @@ namespace drite {
             */
             void clear(const ClearColor& color) override;
 
+            /**
+            * @brief Submit draw commands for the current frame.
+            * @param drawList The commands to draw.
+            */
+            void submit(const DrawList& drawList) override;
+
+            /**
+            * @brief Limit the current frame to damaged regions; ignored, every frame is redrawn in full.
+            * @param rects The damaged regions.
+            */
+            void setDamage(std::span<const Rect> rects) override;
+
             /**
             * @brief Enable or disable vertical synchronization (VSync).
             * @param enabled True to enable VSync, false to disable.
@@ -73,6 +104,12 @@ namespace drite {
             */
             void getViewportSize(int& width, int& height) const override;
 
+            /**
+            * @brief Get how the draw commands of the last frame were batched.
+            * @return The counters of the last ended frame.
+            */
+            [[nodiscard]] const CommandBufferStats& getDrawStats() const override;
+
             /**
             * @brief Get the native Metal device handle.
             * @return Pointer to the native Metal device.
@@ -89,9 +126,51 @@ namespace drite {
         * @brief Private members for the Metal graphics context.
         */
         private:
+            /**
+            * @brief Frames the CPU may record ahead of the GPU.
+            */
+            static constexpr uint64_t MaxFramesInFlight = 3;
+
+            /**
+            * @brief Compile the shaders and create one pipeline per command kind.
+            * @return True if every pipeline was created, false otherwise.
+            */
+            [[nodiscard]] bool createPipelines();
+
+            /**
+            * @brief Create the GPU copy of a glyph texture, or reuse it if the texture did not change.
+            * @param texture The CPU-side texture.
+            * @return The GPU texture, or nil if it could not be created.
+            */
+            [[nodiscard]] id<MTLTexture> uploadTexture(const AlphaTexture& texture);
+
+            /**
+            * @brief Reserve ring space for the instances of the frame, growing the ring if it is too small.
+            * @param bytes The size in bytes.
+            * @return The offset in the instance buffer, or nullopt if no buffer could be created.
+            */
+            [[nodiscard]] std::optional<size_t> allocateInstances(size_t bytes);
+
+            /**
+            * @brief Block until the GPU finished a frame.
+            * @param frame The frame number.
+            */
+            void waitForFrame(uint64_t frame);
+
             MTKView* m_view{nullptr};
             id<MTLDevice> m_device;
             id<MTLCommandQueue> m_commandQueue;
+            std::array<id<MTLRenderPipelineState>, DrawCommandTypeCount> m_pipelines{};
+            id<MTLBuffer> m_instanceBuffer{nullptr};
+            id<MTLTexture> m_glyphTexture{nullptr};
+            const AlphaTexture* m_glyphSource{nullptr};
+            uint64_t m_glyphVersion{0};
+            CommandBuffer m_commands;
+            InstanceRing m_ring;
+            std::mutex m_completionMutex;
+            std::condition_variable m_completion;
+            uint64_t m_completedFrame{0};
+            uint64_t m_frameIndex{0};
             ClearColor m_clearColor{0.1f, 0.1f, 0.2f, 1.0f};
             bool m_initialized{false};
     };
@@ -1,9 +1,99 @@
 #import "graphics/macos/metal_graphics_context.h"
+#import "core/profiler.h"
 #import <Metal/Metal.h>
 #import <MetalKit/MetalKit.h>
+#include <algorithm>
 
 namespace drite {
 
+    /**
+     * @brief Instance ring size to start with; grown when a frame does not fit.
+     */
+    static constexpr size_t InitialRingBytes = 4 * 1024 * 1024;
+
+    /**
+     * @brief Alignment of each frame's instances in the ring, the strictest Metal asks of a buffer offset.
+     */
+    static constexpr size_t InstanceAlignment = 256;
+
+    /**
+     * @brief The shaders of every command kind; the kind is a function constant, so each pipeline keeps only its branch.
+     *
+     * Every instance is a quad of four vertices drawn as a triangle strip.
+     * Rects and glyphs cover their rectangle; lines cover the bounds of the
+     * segment widened by half the thickness and one pixel, and their coverage
+     * falls off with the distance to the segment, as in the software
+     * rasterizer.
+     */
+    static constexpr const char* ShaderSource = R"(
+#include <metal_stdlib>
+using namespace metal;
+
+constant uint kind [[function_constant(0)]];
+
+struct QuadInstance {
+    float x0;
+    float y0;
+    float x1;
+    float y1;
+    float u;
+    float v;
+    uint color;
+    uint type;
+};
+
+struct Fragment {
+    float4 position [[position]];
+    float2 pixel;
+    float4 color [[flat]];
+    float2 start [[flat]];
+    float2 end [[flat]];
+    float2 texel [[flat]];
+    float halfThickness [[flat]];
+};
+
+vertex Fragment quadVertex(uint vertexId [[vertex_id]],
+                           uint instanceId [[instance_id]],
+                           const device QuadInstance* instances [[buffer(0)]],
+                           constant float2& viewport [[buffer(1)]]) {
+    const QuadInstance quad = instances[instanceId];
+    const float2 start = float2(quad.x0, quad.y0);
+    const float2 end = float2(quad.x1, quad.y1);
+    float2 low = start;
+    float2 high = end;
+    if (kind == 1) {
+        const float reach = quad.u * 0.5 + 1.0;
+        low = min(start, end) - reach;
+        high = max(start, end) + reach;
+    }
+
+    const float2 pixel = mix(low, high, float2(vertexId & 1, vertexId >> 1));
+    Fragment out;
+    out.position = float4(pixel.x / viewport.x * 2.0 - 1.0, 1.0 - pixel.y / viewport.y * 2.0, 0.0, 1.0);
+    out.pixel = pixel;
+    out.color = unpack_unorm4x8_to_float(quad.color);
+    out.start = start;
+    out.end = end;
+    out.texel = float2(quad.u, quad.v);
+    out.halfThickness = quad.u * 0.5;
+    return out;
+}
+
+fragment float4 quadFragment(Fragment in [[stage_in]], texture2d<float, access::read> atlas [[texture(0)]]) {
+    float coverage = 1.0;
+    if (kind == 1) {
+        const float2 direction = in.end - in.start;
+        const float2 offset = in.pixel - in.start;
+        const float lengthSquared = dot(direction, direction);
+        const float t = lengthSquared > 0.0 ? saturate(dot(offset, direction) / lengthSquared) : 0.0;
+        coverage = saturate(in.halfThickness + 0.5 - length(offset - t * direction));
+    } else if (kind == 2) {
+        coverage = atlas.read(uint2(in.texel + floor(in.pixel - in.start))).r;
+    }
+    return float4(in.color.rgb, in.color.a * coverage);
+}
+)";
+
     /**
      * @brief Construct a new Metal Graphics Context object.
      * @param view The MTKView to render into.
@@ -20,6 +110,26 @@ namespace drite {
      * @brief Destroy the Metal Graphics Context object.
      */
     MetalGraphicsContext::~MetalGraphicsContext() {
+        // Completion handlers refer to this object
+        waitForFrame(m_frameIndex);
+
+        if (m_glyphTexture) {
+            [m_glyphTexture release];
+            m_glyphTexture = nil;
+        }
+
+        if (m_instanceBuffer) {
+            [m_instanceBuffer release];
+            m_instanceBuffer = nil;
+        }
+
+        for (id<MTLRenderPipelineState>& pipeline : m_pipelines) {
+            if (pipeline) {
+                [pipeline release];
+                pipeline = nil;
+            }
+        }
+
         if (m_commandQueue) {
             [m_commandQueue release];
             m_commandQueue = nil;
@@ -60,31 +170,231 @@ namespace drite {
                 return false;
             }
 
-            // Configure MTKView
+            // Configure MTKView; frames are drawn when the application ends them, not on the view's timer
             m_view.device = m_device;
             m_view.colorPixelFormat = MTLPixelFormatBGRA8Unorm;
             m_view.depthStencilPixelFormat = MTLPixelFormatDepth32Float;
             m_view.clearColor = MTLClearColorMake(m_clearColor.r, m_clearColor.g,
                                                 m_clearColor.b, m_clearColor.a);
+            m_view.paused = YES;
+            m_view.enableSetNeedsDisplay = NO;
+
+            if (!createPipelines()) {
+                return false;
+            }
 
             m_initialized = true;
             return true;
         }
     }
 
+    /**
+     * @brief Compile the shaders and create one pipeline per command kind.
+     * @return True if every pipeline was created, false otherwise.
+     */
+    bool MetalGraphicsContext::createPipelines() {
+        NSError* error = nil;
+        id<MTLLibrary> library = [m_device newLibraryWithSource:@(ShaderSource) options:nil error:&error];
+        if (!library) {
+            NSLog(@"Failed to compile shaders: %@", error);
+            return false;
+        }
+
+        bool created = true;
+        for (uint32_t kind = 0; created && kind < DrawCommandTypeCount; ++kind) {
+            MTLFunctionConstantValues* constants = [[MTLFunctionConstantValues alloc] init];
+            [constants setConstantValue:&kind type:MTLDataTypeUInt atIndex:0];
+            id<MTLFunction> vertexFunction = [library newFunctionWithName:@"quadVertex" constantValues:constants error:&error];
+            id<MTLFunction> fragmentFunction = [library newFunctionWithName:@"quadFragment" constantValues:constants error:&error];
+            [constants release];
+
+            if (vertexFunction && fragmentFunction) {
+                MTLRenderPipelineDescriptor* descriptor = [[MTLRenderPipelineDescriptor alloc] init];
+                descriptor.vertexFunction = vertexFunction;
+                descriptor.fragmentFunction = fragmentFunction;
+                descriptor.depthAttachmentPixelFormat = m_view.depthStencilPixelFormat;
+
+                MTLRenderPipelineColorAttachmentDescriptor* color = descriptor.colorAttachments[0];
+                color.pixelFormat = m_view.colorPixelFormat;
+                color.blendingEnabled = YES;
+                color.sourceRGBBlendFactor = MTLBlendFactorSourceAlpha;
+                color.destinationRGBBlendFactor = MTLBlendFactorOneMinusSourceAlpha;
+                color.sourceAlphaBlendFactor = MTLBlendFactorOne;
+                color.destinationAlphaBlendFactor = MTLBlendFactorOneMinusSourceAlpha;
+
+                m_pipelines[kind] = [m_device newRenderPipelineStateWithDescriptor:descriptor error:&error];
+                [descriptor release];
+            }
+            if (!m_pipelines[kind]) {
+                NSLog(@"Failed to create pipeline: %@", error);
+                created = false;
+            }
+
+            [vertexFunction release];
+            [fragmentFunction release];
+        }
+
+        [library release];
+        return created;
+    }
+
+    /**
+     * @brief Create the GPU copy of a glyph texture, or reuse it if the texture did not change.
+     * @param texture The CPU-side texture.
+     * @return The GPU texture, or nil if it could not be created.
+     */
+    id<MTLTexture> MetalGraphicsContext::uploadTexture(const AlphaTexture& texture) {
+        if (m_glyphTexture && m_glyphSource == &texture && m_glyphVersion == texture.version) {
+            return m_glyphTexture;
+        }
+
+        // A new texture rather than an update, since frames in flight still read the old one;
+        // their command buffers keep it alive
+        MTLTextureDescriptor* descriptor = [MTLTextureDescriptor texture2DDescriptorWithPixelFormat:MTLPixelFormatR8Unorm
+                                                                                             width:static_cast<NSUInteger>(texture.width)
+                                                                                            height:static_cast<NSUInteger>(texture.height)
+                                                                                         mipmapped:NO];
+        descriptor.usage = MTLTextureUsageShaderRead;
+        id<MTLTexture> uploaded = [m_device newTextureWithDescriptor:descriptor];
+        if (!uploaded) {
+            return nil;
+        }
+        [uploaded replaceRegion:MTLRegionMake2D(0, 0, static_cast<NSUInteger>(texture.width), static_cast<NSUInteger>(texture.height))
+                    mipmapLevel:0
+                      withBytes:texture.pixels
+                    bytesPerRow:static_cast<NSUInteger>(texture.stride)];
+
+        if (m_glyphTexture) {
+            [m_glyphTexture release];
+        }
+        m_glyphTexture = uploaded;
+        m_glyphSource = &texture;
+        m_glyphVersion = texture.version;
+        return m_glyphTexture;
+    }
+
+    /**
+     * @brief Reserve ring space for the instances of the frame, growing the ring if it is too small.
+     * @param bytes The size in bytes.
+     * @return The offset in the instance buffer, or nullopt if no buffer could be created.
+     */
+    std::optional<size_t> MetalGraphicsContext::allocateInstances(size_t bytes) {
+        {
+            std::lock_guard lock(m_completionMutex);
+            m_ring.retire(m_completedFrame);
+        }
+        if (std::optional<size_t> offset = m_ring.allocate(bytes, InstanceAlignment)) {
+            return offset;
+        }
+
+        // Too big for the space left: let the GPU drain, then make room for
+        // this frame in every slot in flight
+        waitForFrame(m_frameIndex);
+        const size_t capacity = std::max({m_ring.getCapacity() * 2, InitialRingBytes,
+                                          (bytes + InstanceAlignment - 1) / InstanceAlignment * InstanceAlignment * static_cast<size_t>(MaxFramesInFlight + 1)});
+        if (m_instanceBuffer) {
+            [m_instanceBuffer release];
+        }
+        m_instanceBuffer = [m_device newBufferWithLength:capacity options:MTLResourceStorageModeShared];
+        if (!m_instanceBuffer) {
+            m_ring.reset(0);
+            return std::nullopt;
+        }
+        m_ring.reset(capacity);
+        return m_ring.allocate(bytes, InstanceAlignment);
+    }
+
+    /**
+     * @brief Block until the GPU finished a frame.
+     * @param frame The frame number.
+     */
+    void MetalGraphicsContext::waitForFrame(uint64_t frame) {
+        std::unique_lock lock(m_completionMutex);
+        m_completion.wait(lock, [this, frame] { return m_completedFrame >= frame; });
+    }
+
 
     /**
      * @brief Begin a new frame for rendering.
      */
     void MetalGraphicsContext::beginFrame() {
-        // Frame setup is handled by MTKView's draw callback
+        m_commands.reset();
     }
 
     /**
      * @brief End the current frame and present it to the screen.
      */
     void MetalGraphicsContext::endFrame() {
-        // Frame presentation is handled automatically by MTKView
+        m_commands.finish();
+        if (!m_initialized) {
+            return;
+        }
+
+        // The oldest frame in flight must finish before its ring space and drawable are reused
+        if (m_frameIndex >= MaxFramesInFlight) {
+            DRITE_PROFILE_ZONE("waitForGPU");
+            waitForFrame(m_frameIndex + 1 - MaxFramesInFlight);
+        }
+
+        @autoreleasepool {
+            MTLRenderPassDescriptor* renderPass = m_view.currentRenderPassDescriptor;
+            id<CAMetalDrawable> drawable = m_view.currentDrawable;
+            if (!renderPass || !drawable) {
+                return;
+            }
+
+            const std::span<const DrawCommand> commands = m_commands.getCommands();
+            std::optional<size_t> offset;
+            if (!commands.empty()) {
+                offset = allocateInstances(commands.size() * sizeof(QuadInstance));
+                if (offset) {
+                    writeInstances(commands, reinterpret_cast<QuadInstance*>(static_cast<std::byte*>([m_instanceBuffer contents]) + *offset));
+                }
+            }
+
+            const uint64_t frame = ++m_frameIndex;
+            id<MTLCommandBuffer> commandBuffer = [m_commandQueue commandBuffer];
+            id<MTLRenderCommandEncoder> encoder = [commandBuffer renderCommandEncoderWithDescriptor:renderPass];
+            if (offset) {
+                const CGSize size = m_view.drawableSize;
+                const simd_float2 viewport = {static_cast<float>(size.width), static_cast<float>(size.height)};
+                [encoder setVertexBuffer:m_instanceBuffer offset:*offset atIndex:0];
+                [encoder setVertexBytes:&viewport length:sizeof(viewport) atIndex:1];
+
+                // Batches come sorted to keep the pipeline and texture binds below few
+                std::optional<DrawCommandType> boundType;
+                const AlphaTexture* boundTexture{nullptr};
+                for (const DrawBatch& batch : m_commands.getBatches()) {
+                    if (batch.type != boundType) {
+                        [encoder setRenderPipelineState:m_pipelines[static_cast<size_t>(batch.type)]];
+                        boundType = batch.type;
+                    }
+                    if (batch.texture && batch.texture != boundTexture) {
+                        id<MTLTexture> texture = uploadTexture(*batch.texture);
+                        if (!texture) {
+                            continue;
+                        }
+                        [encoder setFragmentTexture:texture atIndex:0];
+                        boundTexture = batch.texture;
+                    }
+                    [encoder drawPrimitives:MTLPrimitiveTypeTriangleStrip
+                                vertexStart:0
+                                vertexCount:4
+                              instanceCount:batch.count
+                               baseInstance:batch.first];
+                }
+            }
+            [encoder endEncoding];
+
+            [commandBuffer presentDrawable:drawable];
+            [commandBuffer addCompletedHandler:^(id<MTLCommandBuffer>) {
+                std::lock_guard lock(m_completionMutex);
+                m_completedFrame = std::max(m_completedFrame, frame);
+                m_completion.notify_all();
+            }];
+            [commandBuffer commit];
+            m_ring.endFrame(frame);
+        }
     }
 
     /**
@@ -98,6 +408,22 @@ namespace drite {
         }
     }
 
+    /**
+     * @brief Submit draw commands for the current frame.
+     * @param drawList The commands to draw.
+     */
+    void MetalGraphicsContext::submit(const DrawList& drawList) {
+        m_commands.record(drawList);
+    }
+
+    /**
+     * @brief Limit the current frame to damaged regions; ignored, every frame is redrawn in full.
+     * @param rects The damaged regions.
+     */
+    void MetalGraphicsContext::setDamage(std::span<const Rect> /* rects */) {
+        // Each frame renders into a fresh drawable, so there is nothing to preserve
+    }
+
     /**
      * @brief Enable or disable vertical synchronization (VSync).
      * @param enabled True to enable VSync, false to disable.
@@ -124,6 +450,14 @@ namespace drite {
         }
     }
 
+    /**
+     * @brief Get how the draw commands of the last frame were batched.
+     * @return The counters of the last ended frame.
+     */
+    const CommandBufferStats& MetalGraphicsContext::getDrawStats() const {
+        return m_commands.getStats();
+    }
+
     /**
      * @brief Get the native Metal device handle.
      * @return Pointer to the native Metal device.
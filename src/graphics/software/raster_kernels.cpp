@@ -0,0 +1,249 @@
+#include "graphics/software/raster_kernels.h"
+#include "core/cpu_features.h"
+#include <algorithm>
+
+#if DRITE_CPU_X86
+#include <immintrin.h>
+#endif
+
+namespace drite {
+
+    /**
+     * @brief Kernel entry points selected once per process.
+     */
+    struct RasterKernels {
+        void (*blend)(uint32_t*, int, uint32_t, uint8_t) noexcept;
+        void (*blendCoverage)(uint32_t*, const uint8_t*, int, uint32_t, uint8_t) noexcept;
+        const char* name;
+    };
+
+    /**
+     * @brief Divide a product of two 8-bit values by 255 with rounding.
+     * @param value The product, at most 255 * 255.
+     * @return The rounded quotient.
+     */
+    static inline uint32_t divide255(uint32_t value) noexcept {
+        value += 128;
+        return (value + (value >> 8)) >> 8;
+    }
+
+    /**
+     * @brief Blend one color over one pixel.
+     * @param destination The destination pixel.
+     * @param color The packed color.
+     * @param alpha The opacity in [0, 255].
+     * @return The blended pixel.
+     */
+    static inline uint32_t blendPixel(uint32_t destination, uint32_t color, uint32_t alpha) noexcept {
+        const uint32_t inverse = 255 - alpha;
+        uint32_t result{0};
+        for (int shift = 0; shift < 32; shift += 8) {
+            const uint32_t source = (color >> shift) & 0xFF;
+            const uint32_t target = (destination >> shift) & 0xFF;
+            result |= divide255(source * alpha + target * inverse) << shift;
+        }
+        return result;
+    }
+
+    /**
+     * @brief Blend with constant opacity one pixel at a time.
+     * @param destination The first pixel of the span.
+     * @param count The number of pixels.
+     * @param color The packed color.
+     * @param alpha The opacity.
+     */
+    static void blendScalar(uint32_t* destination, int count, uint32_t color, uint8_t alpha) noexcept {
+        for (int i = 0; i < count; ++i) {
+            destination[i] = blendPixel(destination[i], color, alpha);
+        }
+    }
+
+    /**
+     * @brief Blend with per-pixel coverage one pixel at a time.
+     * @param destination The first pixel of the span.
+     * @param coverage The coverage values.
+     * @param count The number of pixels.
+     * @param color The packed color.
+     * @param alpha The color opacity.
+     */
+    static void blendCoverageScalar(uint32_t* destination, const uint8_t* coverage, int count,
+                                    uint32_t color, uint8_t alpha) noexcept {
+        for (int i = 0; i < count; ++i) {
+            const uint32_t opacity = divide255(static_cast<uint32_t>(coverage[i]) * alpha);
+            if (opacity == 255) {
+                destination[i] = color;
+            } else if (opacity != 0) {
+                destination[i] = blendPixel(destination[i], color, opacity);
+            }
+        }
+    }
+
+#if DRITE_CPU_X86
+
+    /**
+     * @brief Blend 8 pixels with per-pixel opacity using 16-bit lanes.
+     *
+     * Computes (source * a + destination * (255 - a)) / 255 per channel; the
+     * unpack/pack pair keeps pixels in their original order within each 128-bit lane.
+     *
+     * @param destination The destination pixels.
+     * @param color The color broadcast to every pixel.
+     * @param opacity The per-pixel opacity, replicated into each byte of its pixel.
+     * @return The blended pixels.
+     */
+    __attribute__((target("avx2")))
+    static inline __m256i blend8(__m256i destination, __m256i color, __m256i opacity) noexcept {
+        const __m256i zero = _mm256_setzero_si256();
+        const __m256i max = _mm256_set1_epi16(255);
+        const __m256i bias = _mm256_set1_epi16(128);
+
+        const __m256i alphaLo = _mm256_unpacklo_epi8(opacity, zero);
+        const __m256i alphaHi = _mm256_unpackhi_epi8(opacity, zero);
+        const __m256i sourceLo = _mm256_unpacklo_epi8(color, zero);
+        const __m256i sourceHi = _mm256_unpackhi_epi8(color, zero);
+        const __m256i targetLo = _mm256_unpacklo_epi8(destination, zero);
+        const __m256i targetHi = _mm256_unpackhi_epi8(destination, zero);
+
+        __m256i lo = _mm256_add_epi16(_mm256_mullo_epi16(sourceLo, alphaLo),
+                                      _mm256_mullo_epi16(targetLo, _mm256_sub_epi16(max, alphaLo)));
+        __m256i hi = _mm256_add_epi16(_mm256_mullo_epi16(sourceHi, alphaHi),
+                                      _mm256_mullo_epi16(targetHi, _mm256_sub_epi16(max, alphaHi)));
+
+        lo = _mm256_add_epi16(lo, bias);
+        hi = _mm256_add_epi16(hi, bias);
+        lo = _mm256_srli_epi16(_mm256_add_epi16(lo, _mm256_srli_epi16(lo, 8)), 8);
+        hi = _mm256_srli_epi16(_mm256_add_epi16(hi, _mm256_srli_epi16(hi, 8)), 8);
+
+        return _mm256_packus_epi16(lo, hi);
+    }
+
+    /**
+     * @brief Blend with constant opacity 8 pixels at a time with AVX2.
+     * @param destination The first pixel of the span.
+     * @param count The number of pixels.
+     * @param color The packed color.
+     * @param alpha The opacity.
+     */
+    __attribute__((target("avx2")))
+    static void blendAvx2(uint32_t* destination, int count, uint32_t color, uint8_t alpha) noexcept {
+        const __m256i source = _mm256_set1_epi32(static_cast<int>(color));
+        const __m256i opacity = _mm256_set1_epi8(static_cast<char>(alpha));
+
+        int i{0};
+        for (; i + 8 <= count; i += 8) {
+            __m256i* pixels = reinterpret_cast<__m256i*>(destination + i);
+            _mm256_storeu_si256(pixels, blend8(_mm256_loadu_si256(pixels), source, opacity));
+        }
+        blendScalar(destination + i, count - i, color, alpha);
+    }
+
+    /**
+     * @brief Blend with per-pixel coverage 8 pixels at a time with AVX2.
+     * @param destination The first pixel of the span.
+     * @param coverage The coverage values.
+     * @param count The number of pixels.
+     * @param color The packed color.
+     * @param alpha The color opacity.
+     */
+    __attribute__((target("avx2")))
+    static void blendCoverageAvx2(uint32_t* destination, const uint8_t* coverage, int count,
+                                  uint32_t color, uint8_t alpha) noexcept {
+        const __m256i source = _mm256_set1_epi32(static_cast<int>(color));
+        const __m256i colorAlpha = _mm256_set1_epi32(alpha);
+        const __m256i replicate = _mm256_set1_epi32(0x01010101);
+        const __m256i bias = _mm256_set1_epi32(128);
+
+        int i{0};
+        for (; i + 8 <= count; i += 8) {
+            // Widen 8 coverage bytes to 32-bit lanes and scale by the color alpha
+            const __m128i packedCoverage = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(coverage + i));
+            __m256i opacity = _mm256_mullo_epi32(_mm256_cvtepu8_epi32(packedCoverage), colorAlpha);
+            opacity = _mm256_add_epi32(opacity, bias);
+            opacity = _mm256_srli_epi32(_mm256_add_epi32(opacity, _mm256_srli_epi32(opacity, 8)), 8);
+
+            // Fully transparent runs are common between glyph strokes
+            if (_mm256_testz_si256(opacity, opacity)) {
+                continue;
+            }
+
+            __m256i* pixels = reinterpret_cast<__m256i*>(destination + i);
+            const __m256i replicated = _mm256_mullo_epi32(opacity, replicate);
+            _mm256_storeu_si256(pixels, blend8(_mm256_loadu_si256(pixels), source, replicated));
+        }
+        blendCoverageScalar(destination + i, coverage + i, count - i, color, alpha);
+    }
+
+#endif
+
+    /**
+     * @brief Pick the widest kernels the running CPU supports.
+     * @param cpu The features of the running CPU.
+     * @return The selected kernels.
+     */
+    static RasterKernels selectKernels([[maybe_unused]] const CpuFeatures& cpu) noexcept {
+#if DRITE_CPU_X86
+        if (cpu.avx2) {
+            return RasterKernels{blendAvx2, blendCoverageAvx2, "avx2"};
+        }
+#endif
+        return RasterKernels{blendScalar, blendCoverageScalar, "scalar"};
+    }
+
+    /**
+     * @brief Get the kernels selected for this process.
+     * @return The selected kernels.
+     */
+    static const RasterKernels& getKernels() noexcept {
+        return getKernelTable(selectKernels);
+    }
+
+    /**
+     * @brief Fill a span of BGRA8 pixels with an opaque color.
+     * @param destination The first pixel of the span.
+     * @param count The number of pixels.
+     * @param color The packed BGRA8 color.
+     */
+    void fillSpan(uint32_t* destination, int count, uint32_t color) noexcept {
+        // Compilers turn this into wide vector stores at every optimization level we ship
+        std::fill(destination, destination + count, color);
+    }
+
+    /**
+     * @brief Blend a color over a span of BGRA8 pixels with constant opacity.
+     * @param destination The first pixel of the span.
+     * @param count The number of pixels.
+     * @param color The packed BGRA8 color.
+     * @param alpha The opacity in [0, 255].
+     */
+    void blendSpan(uint32_t* destination, int count, uint32_t color, uint8_t alpha) noexcept {
+        if (alpha == 255) {
+            fillSpan(destination, count, color);
+        } else if (alpha != 0) {
+            getKernels().blend(destination, count, color, alpha);
+        }
+    }
+
+    /**
+     * @brief Blend a color over a span of BGRA8 pixels modulated by per-pixel coverage.
+     * @param destination The first pixel of the span.
+     * @param coverage One 8-bit coverage value per pixel.
+     * @param count The number of pixels.
+     * @param color The packed BGRA8 color.
+     * @param alpha The color opacity in [0, 255], multiplied with the coverage.
+     */
+    void blendCoverageSpan(uint32_t* destination, const uint8_t* coverage, int count,
+                           uint32_t color, uint8_t alpha) noexcept {
+        if (alpha != 0) {
+            getKernels().blendCoverage(destination, coverage, count, color, alpha);
+        }
+    }
+
+    /**
+     * @brief Get the name of the blending kernels selected for this CPU.
+     * @return The kernel name, e.g. "avx2".
+     */
+    const char* getRasterKernelName() noexcept {
+        return getKernels().name;
+    }
+
+}
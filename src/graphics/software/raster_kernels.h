@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstdint>
+
+namespace drite {
+
+    /**
+     * @brief Fill a span of BGRA8 pixels with an opaque color.
+     * @param destination The first pixel of the span.
+     * @param count The number of pixels.
+     * @param color The packed BGRA8 color.
+     */
+    void fillSpan(uint32_t* destination, int count, uint32_t color) noexcept;
+
+    /**
+     * @brief Blend a color over a span of BGRA8 pixels with constant opacity.
+     * @param destination The first pixel of the span.
+     * @param count The number of pixels.
+     * @param color The packed BGRA8 color.
+     * @param alpha The opacity in [0, 255].
+     */
+    void blendSpan(uint32_t* destination, int count, uint32_t color, uint8_t alpha) noexcept;
+
+    /**
+     * @brief Blend a color over a span of BGRA8 pixels modulated by per-pixel coverage.
+     * @param destination The first pixel of the span.
+     * @param coverage One 8-bit coverage value per pixel.
+     * @param count The number of pixels.
+     * @param color The packed BGRA8 color.
+     * @param alpha The color opacity in [0, 255], multiplied with the coverage.
+     */
+    void blendCoverageSpan(uint32_t* destination, const uint8_t* coverage, int count,
+                           uint32_t color, uint8_t alpha) noexcept;
+
+    /**
+     * @brief Get the name of the blending kernels selected for this CPU.
+     * @return The kernel name, e.g. "avx2".
+     */
+    [[nodiscard]] const char* getRasterKernelName() noexcept;
+
+}
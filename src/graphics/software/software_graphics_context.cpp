@@ -0,0 +1,212 @@
+#include "graphics/software/software_graphics_context.h"
+#include "core/profiler.h"
+#include "graphics/draw_list.h"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <print>
+
+namespace drite {
+
+    /**
+     * @brief Magic bytes at the start of a framebuffer dump.
+     */
+    static constexpr char DumpMagic[8] = {'D', 'R', 'I', 'T', 'E', 'F', 'B', '1'};
+
+    /**
+     * @brief Encode a 32-bit value as little-endian bytes.
+     * @param value The value to encode.
+     * @return The encoded bytes.
+     */
+    static std::array<unsigned char, 4> toLittleEndian(uint32_t value) {
+        return {static_cast<unsigned char>(value), static_cast<unsigned char>(value >> 8),
+                static_cast<unsigned char>(value >> 16), static_cast<unsigned char>(value >> 24)};
+    }
+
+    /**
+     * @brief Construct a new Software Graphics Context object.
+     * @param width The framebuffer width in pixels.
+     * @param height The framebuffer height in pixels.
+     * @param threadCount Number of rasterizer threads, including the caller; 0 picks one per core.
+     */
+    SoftwareGraphicsContext::SoftwareGraphicsContext(int width, int height, unsigned threadCount)
+        : m_rasterizer(threadCount)
+        , m_width(std::max(width, 0))
+        , m_height(std::max(height, 0)) {}
+
+
+    /**
+     * @brief Destroy the Software Graphics Context object.
+     */
+    SoftwareGraphicsContext::~SoftwareGraphicsContext() = default;
+
+
+    /**
+     * @brief Initialize the software graphics context, allocating the framebuffer.
+     * @return True if initialization was successful, false otherwise.
+     */
+    bool SoftwareGraphicsContext::initialize() {
+        if (m_initialized) {
+            return true;
+        }
+
+        m_rasterizer.resize(m_width, m_height);
+        m_initialized = true;
+        return true;
+    }
+
+
+    /**
+     * @brief Begin a new frame, discarding commands left from the previous one.
+     */
+    void SoftwareGraphicsContext::beginFrame() {
+        m_commands.reset();
+        m_damage.clear();
+    }
+
+    /**
+     * @brief Rasterize the recorded frame and present it.
+     */
+    void SoftwareGraphicsContext::endFrame() {
+        const auto start = std::chrono::steady_clock::now();
+        // Partial redraws need the previous frame underneath; after a resize there is none
+        if (m_contentsLost) {
+            m_damage.clear();
+            m_contentsLost = false;
+        }
+        m_commands.finish();
+        m_rasterizer.render(m_clearColor, m_commands, m_damage);
+        m_lastRasterTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        if (m_presentCallback) {
+            DRITE_PROFILE_ZONE("present");
+            m_presentCallback(m_rasterizer.getPixels().data(), m_width, m_height);
+        }
+
+        m_damage.clear();
+        ++m_frameCount;
+    }
+
+    /**
+     * @brief Set the color the frame is cleared to before drawing.
+     * @param color The color to clear the framebuffer with.
+     */
+    void SoftwareGraphicsContext::clear(const ClearColor& color) {
+        m_clearColor = SoftwareRasterizer::packColor(color);
+    }
+
+    /**
+     * @brief Append draw commands to the current frame.
+     * @param drawList The commands to draw.
+     */
+    void SoftwareGraphicsContext::submit(const DrawList& drawList) {
+        m_commands.record(drawList);
+    }
+
+    /**
+     * @brief Limit the current frame to damaged regions; the rest keeps the previous frame.
+     * @param rects The damaged regions; empty redraws the full surface.
+     */
+    void SoftwareGraphicsContext::setDamage(std::span<const Rect> rects) {
+        m_damage.assign(rects.begin(), rects.end());
+    }
+
+    /**
+     * @brief Record the vertical synchronization (VSync) setting.
+     * @param enabled True to enable VSync, false to disable.
+     */
+    void SoftwareGraphicsContext::setVSync(bool enabled) {
+        m_vsync = enabled;
+    }
+
+    /**
+     * @brief Get the framebuffer size.
+     * @param width Reference to store the width.
+     * @param height Reference to store the height.
+     */
+    void SoftwareGraphicsContext::getViewportSize(int& width, int& height) const {
+        width = m_width;
+        height = m_height;
+    }
+
+    /**
+     * @brief Get how the draw commands of the last frame were batched.
+     * @return The counters of the last ended frame.
+     */
+    const CommandBufferStats& SoftwareGraphicsContext::getDrawStats() const {
+        return m_commands.getStats();
+    }
+
+    /**
+     * @brief Get the native graphics device handle.
+     * @return Always nullptr; there is no device.
+     */
+    void* SoftwareGraphicsContext::getNativeDevice() {
+        return nullptr;
+    }
+
+    /**
+     * @brief Get the native graphics command queue handle.
+     * @return Always nullptr; there is no command queue.
+     */
+    void* SoftwareGraphicsContext::getNativeCommandQueue() {
+        return nullptr;
+    }
+
+    /**
+     * @brief Resize the framebuffer.
+     * @param width The new width in pixels.
+     * @param height The new height in pixels.
+     */
+    void SoftwareGraphicsContext::resize(int width, int height) {
+        m_width = std::max(width, 0);
+        m_height = std::max(height, 0);
+        m_rasterizer.resize(m_width, m_height);
+        m_contentsLost = true;
+    }
+
+    /**
+     * @brief Set the callback receiving each finished frame.
+     * @param callback The present callback; empty to render offscreen only.
+     */
+    void SoftwareGraphicsContext::setPresentCallback(PresentCallback callback) {
+        m_presentCallback = std::move(callback);
+    }
+
+    /**
+     * @brief Write the framebuffer to a file for golden-image comparison.
+     * @param path The output file path.
+     * @return True if the file was written, false otherwise.
+     */
+    bool SoftwareGraphicsContext::dumpFramebuffer(const std::string& path) const {
+        std::FILE* file = std::fopen(path.c_str(), "wb");
+        if (file == nullptr) {
+            std::println(stderr, "Failed to open framebuffer dump: {}", path);
+            return false;
+        }
+
+        const auto width = toLittleEndian(static_cast<uint32_t>(m_width));
+        const auto height = toLittleEndian(static_cast<uint32_t>(m_height));
+        bool written = std::fwrite(DumpMagic, 1, sizeof(DumpMagic), file) == sizeof(DumpMagic) &&
+                       std::fwrite(width.data(), 1, width.size(), file) == width.size() &&
+                       std::fwrite(height.data(), 1, height.size(), file) == height.size();
+
+        // Pixels are stored as B, G, R, A bytes regardless of host byte order
+        std::vector<unsigned char> row(static_cast<size_t>(m_width) * 4);
+        const std::vector<uint32_t>& pixels = m_rasterizer.getPixels();
+        for (int y = 0; written && y < m_height; ++y) {
+            for (int x = 0; x < m_width; ++x) {
+                const auto bytes = toLittleEndian(pixels[static_cast<size_t>(y) * static_cast<size_t>(m_width) + x]);
+                std::copy(bytes.begin(), bytes.end(), row.begin() + static_cast<ptrdiff_t>(x) * 4);
+            }
+            written = std::fwrite(row.data(), 1, row.size(), file) == row.size();
+        }
+
+        if (std::fclose(file) != 0 || !written) {
+            std::println(stderr, "Failed to write framebuffer dump: {}", path);
+            return false;
+        }
+        return true;
+    }
+}
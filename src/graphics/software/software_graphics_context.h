@@ -0,0 +1,187 @@
+#pragma once
+
+#include "graphics/graphics_context.h"
+#include "graphics/software/software_rasterizer.h"
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace drite {
+
+    /**
+    * @class SoftwareGraphicsContext
+    * @brief Graphics context that rasterizes on the CPU into a BGRA8 framebuffer.
+    * 
+    * Clears and draw lists are recorded into a CommandBuffer during the frame
+    * and rasterized batch by batch in endFrame(); the finished frame is then
+    * handed to the present callback, if any, so a window without GPU access
+    * can blit it to the screen.
+    */
+    class SoftwareGraphicsContext : public GraphicsContext {
+        public:
+            /**
+            * @brief Callback receiving each finished frame.
+            * @param pixels The BGRA8 pixels in row-major order.
+            * @param width The frame width in pixels.
+            * @param height The frame height in pixels.
+            */
+            using PresentCallback = std::function<void(const uint32_t* pixels, int width, int height)>;
+
+            /**
+            * @brief Construct a new Software Graphics Context object.
+            * @param width The framebuffer width in pixels.
+            * @param height The framebuffer height in pixels.
+            * @param threadCount Number of rasterizer threads, including the caller; 0 picks one per core.
+            */
+            SoftwareGraphicsContext(int width, int height, unsigned threadCount = 0);
+
+            /**
+            * @brief Destroy the Software Graphics Context object.
+            */
+            ~SoftwareGraphicsContext() override;
+
+            /**
+            * @brief Initialize the software graphics context, allocating the framebuffer.
+            * @return True if initialization was successful, false otherwise.
+            */
+            [[nodiscard]] bool initialize() override;
+
+            /**
+            * @brief Begin a new frame, discarding commands left from the previous one.
+            */
+            void beginFrame() override;
+
+            /**
+            * @brief Rasterize the recorded frame and present it.
+            */
+            void endFrame() override;
+
+            /**
+            * @brief Set the color the frame is cleared to before drawing.
+            * @param color The color to clear the framebuffer with.
+            */
+            void clear(const ClearColor& color) override;
+
+            /**
+            * @brief Append draw commands to the current frame.
+            * @param drawList The commands to draw.
+            */
+            void submit(const DrawList& drawList) override;
+
+            /**
+            * @brief Limit the current frame to damaged regions; the rest keeps the previous frame.
+            * @param rects The damaged regions; empty redraws the full surface.
+            */
+            void setDamage(std::span<const Rect> rects) override;
+
+            /**
+            * @brief Record the vertical synchronization (VSync) setting.
+            * @param enabled True to enable VSync, false to disable.
+            */
+            void setVSync(bool enabled) override;
+
+            /**
+            * @brief Get the framebuffer size.
+            * @param width Reference to store the width.
+            * @param height Reference to store the height.
+            */
+            void getViewportSize(int& width, int& height) const override;
+
+            /**
+            * @brief Get how the draw commands of the last frame were batched.
+            * @return The counters of the last ended frame.
+            */
+            [[nodiscard]] const CommandBufferStats& getDrawStats() const override;
+
+            /**
+            * @brief Get the native graphics device handle.
+            * @return Always nullptr; there is no device.
+            */
+            [[nodiscard]] void* getNativeDevice() override;
+
+            /**
+            * @brief Get the native graphics command queue handle.
+            * @return Always nullptr; there is no command queue.
+            */
+            [[nodiscard]] void* getNativeCommandQueue() override;
+
+            /**
+            * @brief Resize the framebuffer.
+            * @param width The new width in pixels.
+            * @param height The new height in pixels.
+            */
+            void resize(int width, int height);
+
+            /**
+            * @brief Set the callback receiving each finished frame.
+            * @param callback The present callback; empty to render offscreen only.
+            */
+            void setPresentCallback(PresentCallback callback);
+
+            /**
+            * @brief Write the framebuffer to a file for golden-image comparison.
+            * 
+            * The format is raw and byte-exact: the 8-byte magic "DRITEFB1", the
+            * width and height as little-endian 32-bit integers, then width * height
+            * BGRA8 pixels in row-major order.
+            * 
+            * @param path The output file path.
+            * @return True if the file was written, false otherwise.
+            */
+            [[nodiscard]] bool dumpFramebuffer(const std::string& path) const;
+
+            /**
+            * @brief Get the framebuffer pixels, one BGRA8 value per pixel in row-major order.
+            * @return The framebuffer pixels.
+            */
+            [[nodiscard]] const std::vector<uint32_t>& getFramebuffer() const noexcept { return m_rasterizer.getPixels(); }
+
+            /**
+            * @brief Check whether VSync was requested.
+            * @return True if VSync is enabled.
+            */
+            [[nodiscard]] bool isVSyncEnabled() const noexcept { return m_vsync; }
+
+            /**
+            * @brief Get the number of frames completed.
+            * @return The frame count.
+            */
+            [[nodiscard]] uint64_t getFrameCount() const noexcept { return m_frameCount; }
+
+            /**
+            * @brief Get the time spent rasterizing the last frame.
+            * @return The raster time in milliseconds.
+            */
+            [[nodiscard]] double getLastRasterTime() const noexcept { return m_lastRasterTime; }
+
+            /**
+            * @brief Get the number of pixels redrawn in the last frame.
+            * @return The pixel count.
+            */
+            [[nodiscard]] size_t getLastPixelsRedrawn() const noexcept { return m_rasterizer.getLastPixelsRedrawn(); }
+
+            /**
+            * @brief Get the rasterizer drawing the frames.
+            * @return Reference to the rasterizer.
+            */
+            [[nodiscard]] const SoftwareRasterizer& getRasterizer() const noexcept { return m_rasterizer; }
+
+        /**
+        * @brief Private members for the software graphics context.
+        */
+        private:
+            SoftwareRasterizer m_rasterizer;
+            CommandBuffer m_commands;
+            std::vector<Rect> m_damage;
+            PresentCallback m_presentCallback;
+            uint32_t m_clearColor{0};
+            int m_width{0};
+            int m_height{0};
+            uint64_t m_frameCount{0};
+            double m_lastRasterTime{0.0};
+            bool m_vsync{true};
+            bool m_contentsLost{true};
+            bool m_initialized{false};
+    };
+}
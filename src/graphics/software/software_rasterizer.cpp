@@ -0,0 +1,391 @@
+#include "graphics/software/software_rasterizer.h"
+#include "core/profiler.h"
+#include "graphics/software/raster_kernels.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <string>
+
+namespace drite {
+
+    /**
+     * @brief Jobs with fewer items than this run on the calling thread.
+     */
+    static constexpr size_t MinParallelItems = 4;
+
+    /**
+     * @brief Convert a normalized color channel to an 8-bit value.
+     * @param value The channel value in [0, 1].
+     * @return The 8-bit channel value.
+     */
+    static uint32_t toChannel(float value) noexcept {
+        return static_cast<uint32_t>(std::lround(std::clamp(value, 0.0f, 1.0f) * 255.0f));
+    }
+
+    /**
+     * @brief Construct a new Software Rasterizer object.
+     * @param threadCount Number of threads rasterizing tiles, including the caller; 0 picks one per core.
+     */
+    SoftwareRasterizer::SoftwareRasterizer(unsigned threadCount) {
+        if (threadCount == 0) {
+            threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+        }
+
+        m_workers.reserve(threadCount - 1);
+        for (unsigned i = 1; i < threadCount; ++i) {
+            m_workers.emplace_back([this, i] {
+                if (Profiler::isEnabled()) {
+                    Profiler::setThreadName("raster " + std::to_string(i));
+                }
+                workerLoop();
+            });
+        }
+    }
+
+    /**
+     * @brief Destroy the Software Rasterizer object, joining the workers.
+     */
+    SoftwareRasterizer::~SoftwareRasterizer() {
+        {
+            std::lock_guard lock(m_mutex);
+            m_stopping = true;
+        }
+        m_jobReady.notify_all();
+
+        for (std::thread& worker : m_workers) {
+            worker.join();
+        }
+    }
+
+    /**
+     * @brief Resize the framebuffer, clearing it to transparent black.
+     * @param width The new width in pixels.
+     * @param height The new height in pixels.
+     */
+    void SoftwareRasterizer::resize(int width, int height) {
+        m_width = std::max(width, 0);
+        m_height = std::max(height, 0);
+        m_pixels.assign(static_cast<size_t>(m_width) * static_cast<size_t>(m_height), 0);
+
+        m_tileColumns = (m_width + TileSize - 1) / TileSize;
+        m_tileRows = (m_height + TileSize - 1) / TileSize;
+        m_bins.resize(static_cast<size_t>(m_tileColumns) * static_cast<size_t>(m_tileRows));
+        m_tileClips.resize(m_bins.size());
+    }
+
+    /**
+     * @brief Clear the framebuffer and draw a frame.
+     * @param clearColor The packed BGRA8 clear color.
+     * @param commands The finished commands to draw, in batch order.
+     * @param damage The regions to redraw; empty redraws the whole framebuffer.
+     */
+    void SoftwareRasterizer::render(uint32_t clearColor, const CommandBuffer& commands, std::span<const Rect> damage) {
+        m_clearColor = clearColor;
+
+        clipTiles(damage);
+        {
+            DRITE_PROFILE_ZONE("binCommands");
+            binCommands(commands);
+        }
+        {
+            DRITE_PROFILE_ZONE("rasterizeTiles");
+            parallelFor(m_bins.size(), [this](size_t tile) { rasterizeTile(tile); });
+        }
+    }
+
+    /**
+     * @brief Pack a color into a BGRA8 pixel.
+     * @param color The color with channels in [0, 1].
+     * @return The packed pixel.
+     */
+    uint32_t SoftwareRasterizer::packColor(const Color& color) noexcept {
+        return toChannel(color.b) | (toChannel(color.g) << 8) | (toChannel(color.r) << 16) | (toChannel(color.a) << 24);
+    }
+
+    /**
+     * @brief Compute the part of each tile to redraw.
+     *
+     * Several rects touching one tile are merged into their bounding box within
+     * it; redrawing a few extra pixels is cheaper than clipping every span
+     * against a list.
+     *
+     * @param damage The damaged regions; empty marks every tile fully.
+     */
+    void SoftwareRasterizer::clipTiles(std::span<const Rect> damage) {
+        m_pixelsRedrawn = 0;
+
+        for (int row = 0; row < m_tileRows; ++row) {
+            for (int column = 0; column < m_tileColumns; ++column) {
+                const int tileLeft = column * TileSize;
+                const int tileTop = row * TileSize;
+                const int tileRight = std::min(tileLeft + TileSize, m_width);
+                const int tileBottom = std::min(tileTop + TileSize, m_height);
+
+                int left{tileRight};
+                int top{tileBottom};
+                int right{tileLeft};
+                int bottom{tileTop};
+                if (damage.empty()) {
+                    left = tileLeft;
+                    top = tileTop;
+                    right = tileRight;
+                    bottom = tileBottom;
+                }
+                for (const Rect& rect : damage) {
+                    const int clipLeft = std::max(rect.x, tileLeft);
+                    const int clipTop = std::max(rect.y, tileTop);
+                    const int clipRight = std::min(rect.x + rect.width, tileRight);
+                    const int clipBottom = std::min(rect.y + rect.height, tileBottom);
+                    if (clipLeft < clipRight && clipTop < clipBottom) {
+                        left = std::min(left, clipLeft);
+                        top = std::min(top, clipTop);
+                        right = std::max(right, clipRight);
+                        bottom = std::max(bottom, clipBottom);
+                    }
+                }
+
+                Rect& clip = m_tileClips[static_cast<size_t>(row * m_tileColumns + column)];
+                clip = Rect{left, top, std::max(right - left, 0), std::max(bottom - top, 0)};
+                m_pixelsRedrawn += static_cast<size_t>(clip.width) * static_cast<size_t>(clip.height);
+            }
+        }
+    }
+
+    /**
+     * @brief Clip and pack the commands and bin them into the tiles they overlap.
+     * @param commands The commands to draw.
+     */
+    void SoftwareRasterizer::binCommands(const CommandBuffer& commands) {
+        m_prepared.clear();
+        for (std::vector<uint32_t>& bin : m_bins) {
+            bin.clear();
+        }
+
+        const std::span<const DrawCommand> sorted = commands.getCommands();
+        for (const DrawBatch& batch : commands.getBatches()) {
+            for (const DrawCommand& command : sorted.subspan(batch.first, batch.count)) {
+                PreparedCommand prepared;
+                if (!prepareCommand(command, batch.texture, prepared)) {
+                    continue;
+                }
+
+                const uint32_t index = static_cast<uint32_t>(m_prepared.size());
+                m_prepared.push_back(prepared);
+
+                const int firstColumn = prepared.left / TileSize;
+                const int lastColumn = (prepared.right - 1) / TileSize;
+                const int firstRow = prepared.top / TileSize;
+                const int lastRow = (prepared.bottom - 1) / TileSize;
+                for (int row = firstRow; row <= lastRow; ++row) {
+                    for (int column = firstColumn; column <= lastColumn; ++column) {
+                        const size_t tile = static_cast<size_t>(row * m_tileColumns + column);
+                        const Rect& clip = m_tileClips[tile];
+                        if (prepared.left < clip.x + clip.width && prepared.right > clip.x &&
+                            prepared.top < clip.y + clip.height && prepared.bottom > clip.y) {
+                            m_bins[tile].push_back(index);
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    /**
+     * @brief Clip and pack one command.
+     * @param command The command.
+     * @param texture The glyph texture of its batch.
+     * @param prepared Receives the packed command.
+     * @return False if nothing of it is visible.
+     */
+    bool SoftwareRasterizer::prepareCommand(const DrawCommand& command, const AlphaTexture* texture, PreparedCommand& prepared) const {
+        if (command.type == DrawCommandType::Glyph && texture == nullptr) {
+            return false;
+        }
+
+        prepared.type = command.type;
+        prepared.texture = texture;
+        if (command.type == DrawCommandType::Line) {
+            // The bounds cover the thickness and the antialiased edge on every side
+            const float half = static_cast<float>(command.u) * 0.5f;
+            const int reach = static_cast<int>(std::ceil(half)) + 1;
+            prepared.left = std::max(std::min(command.x, command.x + command.width) - reach, 0);
+            prepared.top = std::max(std::min(command.y, command.y + command.height) - reach, 0);
+            prepared.right = std::min(std::max(command.x, command.x + command.width) + reach, m_width);
+            prepared.bottom = std::min(std::max(command.y, command.y + command.height) + reach, m_height);
+            prepared.lineX = static_cast<float>(command.x);
+            prepared.lineY = static_cast<float>(command.y);
+            prepared.lineDx = static_cast<float>(command.width);
+            prepared.lineDy = static_cast<float>(command.height);
+            prepared.halfThickness = half;
+        } else {
+            prepared.left = std::max(command.x, 0);
+            prepared.top = std::max(command.y, 0);
+            prepared.right = std::min(command.x + command.width, m_width);
+            prepared.bottom = std::min(command.y + command.height, m_height);
+            prepared.u = command.u - command.x;
+            prepared.v = command.v - command.y;
+        }
+
+        // Glyphs may not sample outside the texture
+        if (command.type == DrawCommandType::Glyph) {
+            prepared.left = std::max(prepared.left, -prepared.u);
+            prepared.top = std::max(prepared.top, -prepared.v);
+            prepared.right = std::min(prepared.right, texture->width - prepared.u);
+            prepared.bottom = std::min(prepared.bottom, texture->height - prepared.v);
+        }
+
+        if (prepared.left >= prepared.right || prepared.top >= prepared.bottom) {
+            return false;
+        }
+
+        // The framebuffer stays opaque; the command alpha only controls blending
+        Color opaque = command.color;
+        opaque.a = 1.0f;
+        prepared.color = packColor(opaque);
+        prepared.alpha = static_cast<uint8_t>(toChannel(command.color.a));
+        return true;
+    }
+
+    /**
+     * @brief Draw the part of a line inside a row span.
+     *
+     * Coverage falls off over one pixel with the distance from the pixel
+     * center to the segment, which also rounds the ends.
+     *
+     * @param command The line.
+     * @param row The first pixel of the span.
+     * @param x The x of the first pixel.
+     * @param y The y of the row.
+     * @param width The span width, at most TileSize.
+     */
+    void SoftwareRasterizer::drawLineSpan(const PreparedCommand& command, uint32_t* row, int x, int y, int width) noexcept {
+        std::array<uint8_t, TileSize> coverage;
+        const float lengthSquared = command.lineDx * command.lineDx + command.lineDy * command.lineDy;
+        const float py = static_cast<float>(y) + 0.5f - command.lineY;
+        for (int i = 0; i < width; ++i) {
+            const float px = static_cast<float>(x + i) + 0.5f - command.lineX;
+            const float t = lengthSquared > 0.0f ? std::clamp((px * command.lineDx + py * command.lineDy) / lengthSquared, 0.0f, 1.0f) : 0.0f;
+            const float distance = std::hypot(px - t * command.lineDx, py - t * command.lineDy);
+            coverage[static_cast<size_t>(i)] = static_cast<uint8_t>(toChannel(command.halfThickness + 0.5f - distance));
+        }
+        blendCoverageSpan(row, coverage.data(), width, command.color, command.alpha);
+    }
+
+    /**
+     * @brief Clear the damaged part of one tile and draw every command binned into it.
+     * @param tile The tile index.
+     */
+    void SoftwareRasterizer::rasterizeTile(size_t tile) {
+        const Rect& clip = m_tileClips[tile];
+        if (clip.isEmpty()) {
+            return;
+        }
+
+        DRITE_PROFILE_ZONE("rasterizeTile");
+
+        const int clipLeft = clip.x;
+        const int clipTop = clip.y;
+        const int clipRight = clip.x + clip.width;
+        const int clipBottom = clip.y + clip.height;
+
+        uint32_t* pixels = m_pixels.data();
+        const size_t stride = static_cast<size_t>(m_width);
+
+        for (int y = clipTop; y < clipBottom; ++y) {
+            fillSpan(pixels + static_cast<size_t>(y) * stride + clipLeft, clipRight - clipLeft, m_clearColor);
+        }
+
+        for (const uint32_t index : m_bins[tile]) {
+            const PreparedCommand& command = m_prepared[index];
+            const int left = std::max(command.left, clipLeft);
+            const int top = std::max(command.top, clipTop);
+            const int right = std::min(command.right, clipRight);
+            const int bottom = std::min(command.bottom, clipBottom);
+            const int width = right - left;
+
+            for (int y = top; y < bottom; ++y) {
+                uint32_t* row = pixels + static_cast<size_t>(y) * stride + left;
+                if (command.type == DrawCommandType::Rect) {
+                    blendSpan(row, width, command.color, command.alpha);
+                } else if (command.type == DrawCommandType::Line) {
+                    drawLineSpan(command, row, left, y, width);
+                } else {
+                    const uint8_t* coverage = command.texture->pixels +
+                                              static_cast<size_t>(y + command.v) * static_cast<size_t>(command.texture->stride) +
+                                              (left + command.u);
+                    blendCoverageSpan(row, coverage, width, command.color, command.alpha);
+                }
+            }
+        }
+    }
+
+    /**
+     * @brief Run a task for every index in [0, count) across the worker pool.
+     * @param count The number of indices.
+     * @param task The task; called concurrently for distinct indices.
+     */
+    void SoftwareRasterizer::parallelFor(size_t count, const std::function<void(size_t)>& task) {
+        if (m_workers.empty() || count < MinParallelItems) {
+            for (size_t i = 0; i < count; ++i) {
+                task(i);
+            }
+            return;
+        }
+
+        {
+            std::lock_guard lock(m_mutex);
+            m_task = &task;
+            m_jobSize = count;
+            m_nextItem.store(0, std::memory_order_relaxed);
+            m_busyWorkers = static_cast<unsigned>(m_workers.size());
+            ++m_generation;
+        }
+        m_jobReady.notify_all();
+
+        // The caller works on the job too instead of idling until it finishes
+        runJobItems();
+
+        std::unique_lock lock(m_mutex);
+        m_jobDone.wait(lock, [this] { return m_busyWorkers == 0; });
+        m_task = nullptr;
+    }
+
+    /**
+     * @brief Claim and run indices of the current parallel job until none are left.
+     */
+    void SoftwareRasterizer::runJobItems() {
+        for (;;) {
+            const size_t item = m_nextItem.fetch_add(1, std::memory_order_relaxed);
+            if (item >= m_jobSize) {
+                return;
+            }
+            (*m_task)(item);
+        }
+    }
+
+    /**
+     * @brief Worker thread body: wait for a job, help run it, repeat until stopped.
+     */
+    void SoftwareRasterizer::workerLoop() {
+        uint64_t seenGeneration{0};
+
+        for (;;) {
+            {
+                std::unique_lock lock(m_mutex);
+                m_jobReady.wait(lock, [&] { return m_stopping || m_generation != seenGeneration; });
+                if (m_stopping) {
+                    return;
+                }
+                seenGeneration = m_generation;
+            }
+
+            runJobItems();
+
+            std::lock_guard lock(m_mutex);
+            if (--m_busyWorkers == 0) {
+                m_jobDone.notify_one();
+            }
+        }
+    }
+
+}
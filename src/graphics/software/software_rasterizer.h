@@ -0,0 +1,282 @@
+#pragma once
+
+#include "graphics/command_buffer.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <span>
+#include <thread>
+#include <vector>
+
+namespace drite {
+
+    /**
+     * @class SoftwareRasterizer
+     * @brief Draws batched draw commands into a BGRA8 framebuffer on the CPU.
+     *
+     * The framebuffer is split into square tiles. Each frame the commands are
+     * binned into the tiles they overlap, then tiles are rasterized independently
+     * on a small worker pool, each tile clipping every command in its bin to its
+     * own bounds so no two threads ever write the same pixel. When a frame
+     * carries damage rects, only the damaged part of each tile is cleared and
+     * redrawn and the rest keeps the previous frame.
+     */
+    class SoftwareRasterizer {
+        public:
+            /**
+             * @brief Edge length of a tile in pixels.
+             */
+            static constexpr int TileSize = 64;
+
+            /**
+             * @brief Construct a new Software Rasterizer object.
+             * @param threadCount Number of threads rasterizing tiles, including the caller; 0 picks one per core.
+             */
+            explicit SoftwareRasterizer(unsigned threadCount = 0);
+
+            /**
+             * @brief Destroy the Software Rasterizer object, joining the workers.
+             */
+            ~SoftwareRasterizer();
+
+            SoftwareRasterizer(const SoftwareRasterizer&) = delete;
+            SoftwareRasterizer& operator=(const SoftwareRasterizer&) = delete;
+
+            /**
+             * @brief Resize the framebuffer, clearing it to transparent black.
+             * @param width The new width in pixels.
+             * @param height The new height in pixels.
+             */
+            void resize(int width, int height);
+
+            /**
+             * @brief Clear the framebuffer and draw a frame.
+             * @param clearColor The packed BGRA8 clear color.
+             * @param commands The finished commands to draw, in batch order.
+             * @param damage The regions to redraw; empty redraws the whole framebuffer.
+             */
+            void render(uint32_t clearColor, const CommandBuffer& commands, std::span<const Rect> damage = {});
+
+            /**
+             * @brief Get the number of pixels cleared and redrawn by the last render().
+             * @return The pixel count.
+             */
+            [[nodiscard]] size_t getLastPixelsRedrawn() const noexcept { return m_pixelsRedrawn; }
+
+            /**
+             * @brief Get the framebuffer pixels, one BGRA8 value per pixel in row-major order.
+             * @return The framebuffer pixels.
+             */
+            [[nodiscard]] const std::vector<uint32_t>& getPixels() const noexcept { return m_pixels; }
+
+            /**
+             * @brief Get the framebuffer width.
+             * @return The width in pixels.
+             */
+            [[nodiscard]] int getWidth() const noexcept { return m_width; }
+
+            /**
+             * @brief Get the framebuffer height.
+             * @return The height in pixels.
+             */
+            [[nodiscard]] int getHeight() const noexcept { return m_height; }
+
+            /**
+             * @brief Get the number of threads rasterizing tiles, including the caller.
+             * @return The thread count.
+             */
+            [[nodiscard]] unsigned getThreadCount() const noexcept { return static_cast<unsigned>(m_workers.size()) + 1; }
+
+            /**
+             * @brief Pack a color into a BGRA8 pixel.
+             * @param color The color with channels in [0, 1].
+             * @return The packed pixel.
+             */
+            [[nodiscard]] static uint32_t packColor(const Color& color) noexcept;
+
+        private:
+            /**
+             * @brief A command clipped to the framebuffer with its color pre-packed.
+             */
+            struct PreparedCommand {
+                DrawCommandType type{DrawCommandType::Rect};
+                int left{0};
+                int top{0};
+                int right{0};
+                int bottom{0};
+                int u{0};
+                int v{0};
+                uint32_t color{0};
+                uint8_t alpha{0};
+                const AlphaTexture* texture{nullptr};
+
+                /**
+                 * @brief For lines, the start, the direction to the end and half the thickness.
+                 */
+                float lineX{0.0f};
+                float lineY{0.0f};
+                float lineDx{0.0f};
+                float lineDy{0.0f};
+                float halfThickness{0.0f};
+            };
+
+            /**
+             * @brief Compute the part of each tile to redraw.
+             * @param damage The damaged regions; empty marks every tile fully.
+             */
+            void clipTiles(std::span<const Rect> damage);
+
+            /**
+             * @brief Clip and pack the commands and bin them into the tiles they overlap.
+             * @param commands The commands to draw.
+             */
+            void binCommands(const CommandBuffer& commands);
+
+            /**
+             * @brief Clip and pack one command.
+             * @param command The command.
+             * @param texture The glyph texture of its batch.
+             * @param prepared Receives the packed command.
+             * @return False if nothing of it is visible.
+             */
+            [[nodiscard]] bool prepareCommand(const DrawCommand& command, const AlphaTexture* texture, PreparedCommand& prepared) const;
+
+            /**
+             * @brief Draw the part of a line inside a row span.
+             * @param command The line.
+             * @param row The first pixel of the span.
+             * @param x The x of the first pixel.
+             * @param y The y of the row.
+             * @param width The span width, at most TileSize.
+             */
+            static void drawLineSpan(const PreparedCommand& command, uint32_t* row, int x, int y, int width) noexcept;
+
+            /**
+             * @brief Clear the damaged part of one tile and draw every command binned into it.
+             * @param tile The tile index.
+             */
+            void rasterizeTile(size_t tile);
+
+            /**
+             * @brief Run a task for every index in [0, count) across the worker pool.
+             * @param count The number of indices.
+             * @param task The task; called concurrently for distinct indices.
+             */
+            void parallelFor(size_t count, const std::function<void(size_t)>& task);
+
+            /**
+             * @brief Claim and run indices of the current parallel job until none are left.
+             */
+            void runJobItems();
+
+            /**
+             * @brief Worker thread body: wait for a job, help run it, repeat until stopped.
+             */
+            void workerLoop();
+
+        private:
+            /**
+             * @brief The framebuffer pixels.
+             */
+            std::vector<uint32_t> m_pixels;
+
+            /**
+             * @brief Framebuffer width in pixels.
+             */
+            int m_width{0};
+
+            /**
+             * @brief Framebuffer height in pixels.
+             */
+            int m_height{0};
+
+            /**
+             * @brief Number of tile columns.
+             */
+            int m_tileColumns{0};
+
+            /**
+             * @brief Number of tile rows.
+             */
+            int m_tileRows{0};
+
+            /**
+             * @brief The clear color of the frame being drawn.
+             */
+            uint32_t m_clearColor{0};
+
+            /**
+             * @brief The commands of the frame being drawn.
+             */
+            std::vector<PreparedCommand> m_prepared;
+
+            /**
+             * @brief Per tile, indices into m_prepared in draw order; storage is reused across frames.
+             */
+            std::vector<std::vector<uint32_t>> m_bins;
+
+            /**
+             * @brief Per tile, the bounds of its damaged pixels; empty for tiles left untouched.
+             */
+            std::vector<Rect> m_tileClips;
+
+            /**
+             * @brief Pixels cleared and redrawn by the last render().
+             */
+            size_t m_pixelsRedrawn{0};
+
+            /**
+             * @brief The worker threads.
+             */
+            std::vector<std::thread> m_workers;
+
+            /**
+             * @brief Guards the job state below.
+             */
+            std::mutex m_mutex;
+
+            /**
+             * @brief Signals workers that a job was posted or that they should stop.
+             */
+            std::condition_variable m_jobReady;
+
+            /**
+             * @brief Signals the caller that every worker left the current job.
+             */
+            std::condition_variable m_jobDone;
+
+            /**
+             * @brief The task of the current job.
+             */
+            const std::function<void(size_t)>* m_task{nullptr};
+
+            /**
+             * @brief Number of indices in the current job.
+             */
+            size_t m_jobSize{0};
+
+            /**
+             * @brief The next unclaimed index of the current job.
+             */
+            std::atomic<size_t> m_nextItem{0};
+
+            /**
+             * @brief Incremented for each job so workers can tell a new one was posted.
+             */
+            uint64_t m_generation{0};
+
+            /**
+             * @brief Number of workers still running items of the current job.
+             */
+            unsigned m_busyWorkers{0};
+
+            /**
+             * @brief Whether the workers should exit.
+             */
+            bool m_stopping{false};
+    };
+
+}
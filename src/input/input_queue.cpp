@@ -0,0 +1,208 @@
+#include "input/input_queue.h"
+#include <algorithm>
+#include <bit>
+#include <optional>
+#include <variant>
+
+namespace drite {
+
+    /**
+     * @brief Construct a new Input Queue object.
+     * @param capacity The number of slots, rounded up to a power of two.
+     */
+    InputQueue::InputQueue(size_t capacity)
+        : m_slots(std::bit_ceil(std::max<size_t>(capacity, 2)))
+        , m_mask(m_slots.size() - 1) {}
+
+    /**
+     * @brief Check whether an event is pointer motion, which a later move or scroll supersedes.
+     * @param event The event.
+     * @return True for mouse moves and scrolls.
+     */
+    static bool isMotion(const InputEvent& event) noexcept {
+        if (const auto* mouse = std::get_if<MouseEvent>(&event)) {
+            return mouse->action == MouseAction::Move;
+        }
+        return std::holds_alternative<ScrollEvent>(event);
+    }
+
+    /**
+     * @brief Append an event; producer thread only.
+     * @param event The event.
+     * @return True if the event was queued, false if it was pointer motion and the queue was full.
+     */
+    bool InputQueue::push(const InputEvent& event) {
+        const size_t tail = m_tail.load(std::memory_order_relaxed);
+        bool full{false};
+        if (tail - m_cachedHead == m_slots.size()) {
+            m_cachedHead = m_head.load(std::memory_order_acquire);
+            full = tail - m_cachedHead == m_slots.size();
+        }
+
+        if (full || m_spilling.load(std::memory_order_acquire)) {
+            if (trySpill(event, full)) {
+                return true;
+            }
+            // Only this thread starts a spill, so one still in progress means
+            // the list is at its bound for motion
+            if (full || m_spilling.load(std::memory_order_relaxed)) {
+                m_dropped.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+        }
+
+        m_slots[tail & m_mask] = event;
+        m_tail.store(tail + 1, std::memory_order_release);
+        m_pushed.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    /**
+     * @brief Append an event to the overflow list if it is in use or the ring is full; producer thread only.
+     * @param event The event.
+     * @param ringFull Whether the ring has no free slot.
+     * @return True if the event went to the overflow list; false if it belongs in the ring, or is motion to drop.
+     */
+    bool InputQueue::trySpill(const InputEvent& event, bool ringFull) {
+        std::lock_guard lock(m_overflowMutex);
+        if (!m_spilling.load(std::memory_order_relaxed)) {
+            // The consumer took the list; motion is dropped rather than
+            // starting a new one, anything else starts it after the ring
+            if (!ringFull || isMotion(event)) {
+                return false;
+            }
+            m_overflowStart = m_tail.load(std::memory_order_relaxed);
+            m_spilling.store(true, std::memory_order_release);
+        } else if (isMotion(event) && m_overflow.size() >= m_slots.size()) {
+            // A flood of motion stays bounded; keys and clicks are never dropped
+            return false;
+        }
+
+        m_overflow.push_back(event);
+        m_spilled.fetch_add(1, std::memory_order_relaxed);
+        m_pushed.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    /**
+     * @brief Deliver the queued events, coalescing pointer motion; consumer thread only.
+     * @param handler The function receiving each delivered event.
+     * @return The number of events delivered.
+     */
+    size_t InputQueue::drain(const Handler& handler) {
+        size_t head = m_head.load(std::memory_order_relaxed);
+
+        // Take the overflow list before reading the tail: the ring slots before
+        // its start were written before it, and every slot from there on after
+        size_t overflowStart{0};
+        if (m_spilling.load(std::memory_order_acquire)) {
+            std::lock_guard lock(m_overflowMutex);
+            m_drainedOverflow.swap(m_overflow);
+            overflowStart = m_overflowStart;
+            m_spilling.store(false, std::memory_order_release);
+        }
+
+        m_cachedTail = m_tail.load(std::memory_order_acquire);
+        if (head == m_cachedTail && m_drainedOverflow.empty()) {
+            return 0;
+        }
+
+        // Within a run of pointer motion the latest move and the summed scroll
+        // are held back; anything else, such as a key or a click, first flushes
+        // them so events of different kinds are never reordered across it
+        std::optional<MouseEvent> move;
+        std::optional<ScrollEvent> scroll;
+        bool scrollIsNewer{false};
+        size_t delivered{0};
+
+        const auto flush = [&] {
+            if (move && scroll && scrollIsNewer) {
+                handler(*move);
+                handler(*scroll);
+            } else if (move && scroll) {
+                handler(*scroll);
+                handler(*move);
+            } else if (move) {
+                handler(*move);
+            } else if (scroll) {
+                handler(*scroll);
+            }
+            delivered += move.has_value() + scroll.has_value();
+            move.reset();
+            scroll.reset();
+        };
+
+        const auto consume = [&](const InputEvent& event) {
+            if (const auto* next = std::get_if<MouseEvent>(&event); next && next->action == MouseAction::Move) {
+                if (move && move->modifiers != next->modifiers) {
+                    flush();
+                }
+                m_coalesced += move.has_value();
+                move = *next;
+                scrollIsNewer = false;
+            } else if (const auto* next = std::get_if<ScrollEvent>(&event)) {
+                if (scroll) {
+                    scroll->xOffset += next->xOffset;
+                    scroll->yOffset += next->yOffset;
+                    scroll->x = next->x;
+                    scroll->y = next->y;
+                    ++m_coalesced;
+                } else {
+                    scroll = *next;
+                }
+                scrollIsNewer = true;
+            } else {
+                flush();
+                handler(event);
+                ++delivered;
+            }
+        };
+
+        const auto consumeOverflow = [&] {
+            for (const InputEvent& event : m_drainedOverflow) {
+                consume(event);
+            }
+            m_drainedOverflow.clear();
+        };
+
+        for (; head != m_cachedTail; ++head) {
+            if (head == overflowStart) {
+                consumeOverflow();
+            }
+            consume(m_slots[head & m_mask]);
+        }
+        consumeOverflow();
+
+        // Publish the consumed slots before delivering the held-back motion so
+        // the producer can refill them while the application handles it
+        m_head.store(head, std::memory_order_release);
+        flush();
+
+        m_delivered += delivered;
+        return delivered;
+    }
+
+    /**
+     * @brief Check whether events are waiting; exact on the consumer thread.
+     * @return True if the queue is empty.
+     */
+    bool InputQueue::isEmpty() const noexcept {
+        return m_head.load(std::memory_order_relaxed) == m_tail.load(std::memory_order_acquire) &&
+               !m_spilling.load(std::memory_order_acquire);
+    }
+
+    /**
+     * @brief Get the queue counters.
+     * @return A snapshot of the counters.
+     */
+    InputQueueStats InputQueue::getStats() const noexcept {
+        return InputQueueStats{
+            m_pushed.load(std::memory_order_relaxed),
+            m_dropped.load(std::memory_order_relaxed),
+            m_spilled.load(std::memory_order_relaxed),
+            m_delivered,
+            m_coalesced,
+        };
+    }
+
+}
@@ -0,0 +1,218 @@
+#pragma once
+
+#include "input/input_types.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <variant>
+#include <vector>
+
+namespace drite {
+
+    /**
+     * @brief An input event travelling from the platform layer to the application.
+     */
+    using InputEvent = std::variant<KeyEvent, MouseEvent, ScrollEvent>;
+
+    /**
+     * @brief Input queue counters.
+     */
+    struct InputQueueStats {
+        /**
+         * @brief Events accepted by push().
+         */
+        uint64_t pushed{0};
+
+        /**
+         * @brief Events rejected by push() because the queue was full; only pointer motion is ever rejected.
+         */
+        uint64_t dropped{0};
+
+        /**
+         * @brief Events accepted by push() into the overflow list: keys and clicks that found the queue full, and what followed them.
+         */
+        uint64_t spilled{0};
+
+        /**
+         * @brief Events handed to the drain handler.
+         */
+        uint64_t delivered{0};
+
+        /**
+         * @brief Events merged into a later event instead of being delivered.
+         */
+        uint64_t coalesced{0};
+    };
+
+    /**
+     * @brief Lock-free single-producer/single-consumer ring of input events.
+     *
+     * The platform layer pushes events as they arrive; the application drains
+     * them once per frame. While draining, a run of consecutive pointer motion
+     * collapses into the last mouse move plus one scroll with the summed
+     * offsets, so a high-rate mouse or a trackpad fling costs at most two
+     * handler calls per frame instead of hundreds. Keys, clicks and modifier
+     * changes end a run, so they keep their order relative to the motion.
+     *
+     * When the ring is full, pointer motion is dropped since the next move or
+     * scroll supersedes it, but keys and clicks are never lost: they spill
+     * into an overflow list behind a mutex, and every later event follows
+     * them there until the consumer takes the list, so the order holds.
+     *
+     * Today both ends run on the main thread: the window callbacks push from
+     * inside Platform::pollEvents() and the application drains later in the
+     * same frame. The queue therefore buys coalescing, overflow and bounded
+     * draining, not concurrency. The lock-free protocol keeps it correct for
+     * a backend that pumps events on a thread of its own, which none does yet.
+     */
+    class InputQueue {
+        public:
+            /**
+             * @brief Function receiving drained events.
+             */
+            using Handler = std::function<void(const InputEvent&)>;
+
+            /**
+             * @brief Default number of slots.
+             */
+            static constexpr size_t DefaultCapacity = 4096;
+
+            /**
+             * @brief Construct a new Input Queue object.
+             * @param capacity The number of slots, rounded up to a power of two.
+             */
+            explicit InputQueue(size_t capacity = DefaultCapacity);
+
+            InputQueue(const InputQueue&) = delete;
+            InputQueue& operator=(const InputQueue&) = delete;
+
+            /**
+             * @brief Append an event; producer thread only.
+             * @param event The event.
+             * @return True if the event was queued, false if it was pointer motion and the queue was full.
+             */
+            bool push(const InputEvent& event);
+
+            /**
+             * @brief Deliver the queued events, coalescing pointer motion; consumer thread only.
+             *
+             * Only events queued before the call are delivered, so a producer
+             * flooding the queue cannot keep the consumer draining forever.
+             *
+             * @param handler The function receiving each delivered event.
+             * @return The number of events delivered.
+             */
+            size_t drain(const Handler& handler);
+
+            /**
+             * @brief Check whether events are waiting; exact on the consumer thread.
+             * @return True if the queue is empty.
+             */
+            [[nodiscard]] bool isEmpty() const noexcept;
+
+            /**
+             * @brief Get the number of slots.
+             * @return The capacity.
+             */
+            [[nodiscard]] size_t getCapacity() const noexcept { return m_slots.size(); }
+
+            /**
+             * @brief Get the queue counters.
+             * @return A snapshot of the counters.
+             */
+            [[nodiscard]] InputQueueStats getStats() const noexcept;
+
+        private:
+            /**
+             * @brief Append an event to the overflow list if it is in use or the ring is full; producer thread only.
+             * @param event The event.
+             * @param ringFull Whether the ring has no free slot.
+             * @return True if the event went to the overflow list; false if it belongs in the ring, or is motion to drop.
+             */
+            bool trySpill(const InputEvent& event, bool ringFull);
+
+        private:
+            /**
+             * @brief The event slots; the size is a power of two.
+             */
+            std::vector<InputEvent> m_slots;
+
+            /**
+             * @brief Index mask for the slots.
+             */
+            size_t m_mask{0};
+
+            /**
+             * @brief Next slot to read, written by the consumer only.
+             */
+            alignas(64) std::atomic<size_t> m_head{0};
+
+            /**
+             * @brief The consumer's last observed tail.
+             */
+            size_t m_cachedTail{0};
+
+            /**
+             * @brief Events delivered by drain().
+             */
+            uint64_t m_delivered{0};
+
+            /**
+             * @brief Events coalesced by drain().
+             */
+            uint64_t m_coalesced{0};
+
+            /**
+             * @brief The overflow list taken by drain(), kept to reuse its storage.
+             */
+            std::vector<InputEvent> m_drainedOverflow;
+
+            /**
+             * @brief Next slot to write, written by the producer only.
+             */
+            alignas(64) std::atomic<size_t> m_tail{0};
+
+            /**
+             * @brief The producer's last observed head, refreshed only when the ring looks full.
+             */
+            size_t m_cachedHead{0};
+
+            /**
+             * @brief Events accepted by push().
+             */
+            std::atomic<uint64_t> m_pushed{0};
+
+            /**
+             * @brief Events rejected by push().
+             */
+            std::atomic<uint64_t> m_dropped{0};
+
+            /**
+             * @brief Guards the overflow list and its start.
+             */
+            std::mutex m_overflowMutex;
+
+            /**
+             * @brief Events that arrived while the ring was full, or after others that did, in order.
+             */
+            std::vector<InputEvent> m_overflow;
+
+            /**
+             * @brief The ring position the overflow list follows: every slot before it was written earlier, every one after later.
+             */
+            size_t m_overflowStart{0};
+
+            /**
+             * @brief Whether the overflow list holds events, so the producer only locks while it is in use.
+             */
+            std::atomic<bool> m_spilling{false};
+
+            /**
+             * @brief Events added to the overflow list.
+             */
+            std::atomic<uint64_t> m_spilled{0};
+    };
+
+}
@@ -74,6 +74,8 @@ namespace drite {
         constexpr KeyModifiers() = default;
         constexpr KeyModifiers(bool shift, bool control, bool alt, bool command)
             : shift(shift), control(control), alt(alt), command(command) {}
+
+        constexpr bool operator==(const KeyModifiers&) const = default;
     };
 
     /**
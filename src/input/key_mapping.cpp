@@ -0,0 +1,49 @@
+#include "input/key_mapping.h"
+
+namespace drite {
+
+    /**
+     * @brief Translate a key event into the character it types on a US layout.
+     * @param event The key event.
+     * @return The typed character, or '\0' if the key does not produce text.
+     */
+    char keyToCharacter(const KeyEvent& event) noexcept {
+        // Shortcuts never insert text
+        if (event.modifiers.command || event.modifiers.control) {
+            return '\0';
+        }
+
+        const bool shift = event.modifiers.shift;
+        const KeyCode key = event.key;
+
+        if (key >= KeyCode::A && key <= KeyCode::Z) {
+            const char offset = static_cast<char>(static_cast<int>(key) - static_cast<int>(KeyCode::A));
+            return static_cast<char>((shift ? 'A' : 'a') + offset);
+        }
+
+        if (key >= KeyCode::Num0 && key <= KeyCode::Num9) {
+            constexpr char shifted[] = ")!@#$%^&*(";
+            const int digit = static_cast<int>(key) - static_cast<int>(KeyCode::Num0);
+            return shift ? shifted[digit] : static_cast<char>('0' + digit);
+        }
+
+        switch (key) {
+            case KeyCode::Space: return ' ';
+            case KeyCode::Enter: return '\n';
+            case KeyCode::Tab: return '\t';
+            case KeyCode::Minus: return shift ? '_' : '-';
+            case KeyCode::Equal: return shift ? '+' : '=';
+            case KeyCode::LeftBracket: return shift ? '{' : '[';
+            case KeyCode::RightBracket: return shift ? '}' : ']';
+            case KeyCode::Semicolon: return shift ? ':' : ';';
+            case KeyCode::Quote: return shift ? '"' : '\'';
+            case KeyCode::Comma: return shift ? '<' : ',';
+            case KeyCode::Period: return shift ? '>' : '.';
+            case KeyCode::Slash: return shift ? '?' : '/';
+            case KeyCode::Backslash: return shift ? '|' : '\\';
+            case KeyCode::Grave: return shift ? '~' : '`';
+            default: return '\0';
+        }
+    }
+
+}
@@ -0,0 +1,14 @@
+#pragma once
+
+#include "input/input_types.h"
+
+namespace drite {
+
+    /**
+     * @brief Translate a key event into the character it types on a US layout.
+     * @param event The key event.
+     * @return The typed character, or '\0' if the key does not produce text.
+     */
+    [[nodiscard]] char keyToCharacter(const KeyEvent& event) noexcept;
+
+}
@@ -0,0 +1,162 @@
+#include "io/file_loader.h"
+#include "io/mapped_file.h"
+#include "io/paged_file.h"
+#include <cerrno>
+#include <chrono>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace drite {
+
+    /**
+     * @brief Resident limit of files paged for being larger than memory.
+     */
+    static constexpr size_t DefaultPageCacheLimit = size_t{256} << 20;
+
+    /**
+     * @brief Read a file descriptor to the end.
+     * @param fd The file descriptor.
+     * @param text Receives the contents.
+     * @return True if the descriptor was read to the end without error.
+     */
+    static bool readAll(int fd, std::string& text) {
+        constexpr size_t ChunkSize = 1024 * 1024;
+
+        size_t used{0};
+        for (;;) {
+            if (text.size() - used < ChunkSize) {
+                text.resize(used + ChunkSize);
+            }
+
+            const ssize_t count = ::read(fd, text.data() + used, text.size() - used);
+            if (count < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return false;
+            }
+            if (count == 0) {
+                break;
+            }
+            used += static_cast<size_t>(count);
+        }
+
+        text.resize(used);
+        return true;
+    }
+
+    /**
+     * @brief Decide whether a file is paged rather than mapped whole, and with what limit.
+     * @param path The path of the file.
+     * @param pageCacheLimit The requested limit, 0 for the default policy.
+     * @return The resident limit to page the file with, or 0 to map it whole.
+     */
+    static size_t getPagedLimit(const std::string& path, size_t pageCacheLimit) {
+        struct stat info{};
+        if (::stat(path.c_str(), &info) != 0 || !S_ISREG(info.st_mode)) {
+            return 0;
+        }
+        const auto size = static_cast<size_t>(info.st_size);
+        if (pageCacheLimit > 0) {
+            return size > pageCacheLimit ? pageCacheLimit : 0;
+        }
+
+        // A file that would crowd out everything else if it were resident
+        const long pages = ::sysconf(_SC_PHYS_PAGES);
+        const long pageSize = ::sysconf(_SC_PAGESIZE);
+        const size_t memory = pages > 0 && pageSize > 0 ? static_cast<size_t>(pages) * static_cast<size_t>(pageSize) : 0;
+        return memory > 0 && size > memory / 2 ? DefaultPageCacheLimit : 0;
+    }
+
+    /**
+     * @brief Build a text buffer over storage, with a saved line index when there is one.
+     * @param storage The storage.
+     * @param lineIndex The saved line index, or std::nullopt to scan the storage.
+     * @return The buffer.
+     */
+    static TextBuffer makeBuffer(std::shared_ptr<const TextStorage> storage, std::optional<LineIndex>& lineIndex) {
+        return lineIndex ? TextBuffer(std::move(storage), std::move(*lineIndex)) : TextBuffer(std::move(storage));
+    }
+
+    /**
+     * @brief Get the stamp of a file.
+     * @param path The path of the file.
+     * @return The stamp, or std::nullopt if the file does not exist.
+     */
+    std::optional<FileStamp> getFileStamp(const std::string& path) {
+        struct stat info{};
+        if (::stat(path.c_str(), &info) != 0) {
+            return std::nullopt;
+        }
+
+        FileStamp stamp;
+        stamp.size = static_cast<uint64_t>(info.st_size);
+    #ifdef __APPLE__
+        stamp.modifiedNanoseconds = static_cast<int64_t>(info.st_mtimespec.tv_sec) * 1000000000 + info.st_mtimespec.tv_nsec;
+    #else
+        stamp.modifiedNanoseconds = static_cast<int64_t>(info.st_mtim.tv_sec) * 1000000000 + info.st_mtim.tv_nsec;
+    #endif
+        stamp.inode = static_cast<uint64_t>(info.st_ino);
+        stamp.device = static_cast<uint64_t>(info.st_dev);
+        return stamp;
+    }
+
+    /**
+     * @brief Load a file into a text buffer.
+     * @param path The path of the file, or "-" for standard input.
+     * @param pageCacheLimit The most bytes of a paged file to keep resident, 0 to page only files larger than memory.
+     * @param lineIndex The line index of the file from an earlier load, so a mapped or paged file is not scanned.
+     * @return The loaded file, or std::nullopt if it could not be read.
+     */
+    std::optional<LoadedFile> loadFile(const std::string& path, size_t pageCacheLimit, std::optional<LineIndex> lineIndex) {
+        // Stamped first, so a write racing the load leaves an outdated stamp rather than an outdated text
+        const FileStamp stamp = path != "-" ? getFileStamp(path).value_or(FileStamp{}) : FileStamp{};
+        const int64_t stamped = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+        if (path != "-") {
+            if (const size_t limit = getPagedLimit(path, pageCacheLimit); limit > 0) {
+                if (std::shared_ptr<const PagedFile> paged = PagedFile::open(path, limit)) {
+                    return LoadedFile{makeBuffer(std::move(paged), lineIndex), LoadMethod::Paged, stamp, stamped};
+                }
+            }
+            if (std::shared_ptr<const MappedFile> mapping = MappedFile::open(path)) {
+                return LoadedFile{makeBuffer(std::move(mapping), lineIndex), LoadMethod::Mapped, stamp, stamped};
+            }
+        }
+
+        // Streaming fallback for stdin, pipes and files that cannot be mapped
+        const bool useStdin = path == "-";
+        const int fd = useStdin ? STDIN_FILENO : ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            return std::nullopt;
+        }
+
+        std::string text;
+        const bool success = readAll(fd, text);
+        if (!useStdin) {
+            ::close(fd);
+        }
+
+        if (!success) {
+            return std::nullopt;
+        }
+
+        return LoadedFile{TextBuffer(std::move(text)), LoadMethod::Streamed, stamp, stamped};
+    }
+
+    /**
+     * @brief Get a human-readable name for a load method.
+     * @param method The load method.
+     * @return The method name.
+     */
+    const char* getLoadMethodName(LoadMethod method) noexcept {
+        switch (method) {
+            case LoadMethod::Mapped: return "mapped";
+            case LoadMethod::Paged: return "paged";
+            case LoadMethod::Streamed: return "streamed";
+        }
+        return "unknown";
+    }
+
+}
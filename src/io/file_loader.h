@@ -0,0 +1,82 @@
+#pragma once
+
+#include "editor/text_buffer.h"
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+
+namespace drite {
+
+    /**
+     * @brief How a file's contents were brought into memory.
+     */
+    enum class LoadMethod {
+        Mapped,
+        Paged,
+        Streamed
+    };
+
+    /**
+     * @brief What identifies the version of a file on disk: it changes whenever the file is written or replaced.
+     */
+    struct FileStamp {
+        uint64_t size{0};
+        int64_t modifiedNanoseconds{0};
+        uint64_t inode{0};
+        uint64_t device{0};
+
+        constexpr bool operator==(const FileStamp&) const = default;
+    };
+
+    /**
+     * @brief The result of loading a file into a text buffer.
+     */
+    struct LoadedFile {
+        TextBuffer buffer;
+        LoadMethod method{LoadMethod::Mapped};
+
+        /**
+         * @brief The file as it was before loading; all zero for standard input.
+         */
+        FileStamp stamp;
+
+        /**
+         * @brief Wall clock time the stamp was taken, in nanoseconds since the epoch.
+         */
+        int64_t stampedNanoseconds{0};
+    };
+
+    /**
+     * @brief Get the stamp of a file.
+     * @param path The path of the file.
+     * @return The stamp, or std::nullopt if the file does not exist.
+     */
+    [[nodiscard]] std::optional<FileStamp> getFileStamp(const std::string& path);
+
+    /**
+     * @brief Load a file into a text buffer.
+     *
+     * Regular files are memory-mapped and used in place as the original buffer.
+     * Files larger than the page cache limit, or without one larger than half
+     * the physical memory, are paged so only part of them stays resident.
+     * Pipes, character devices, empty or size-less files and "-" (standard input)
+     * fall back to a streaming read.
+     *
+     * @param path The path of the file, or "-" for standard input.
+     * @param pageCacheLimit The most bytes of a paged file to keep resident, 0 to page only files larger than memory.
+     * @param lineIndex The line index of the file from an earlier load, so a mapped or paged file is not scanned; only
+     * valid while the file keeps the stamp it had then, which the caller checks against the returned one.
+     * @return The loaded file, or std::nullopt if it could not be read.
+     */
+    [[nodiscard]] std::optional<LoadedFile> loadFile(const std::string& path, size_t pageCacheLimit = 0,
+                                                     std::optional<LineIndex> lineIndex = std::nullopt);
+
+    /**
+     * @brief Get a human-readable name for a load method.
+     * @param method The load method.
+     * @return The method name.
+     */
+    [[nodiscard]] const char* getLoadMethodName(LoadMethod method) noexcept;
+
+}
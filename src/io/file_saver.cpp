@@ -0,0 +1,261 @@
+#include "io/file_saver.h"
+#include "core/profiler.h"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <print>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <vector>
+
+namespace drite {
+
+    /**
+     * @brief Most vectors per writev() call; IOV_MAX on Linux and macOS.
+     */
+    static constexpr size_t MaxWriteVectors = 1024;
+
+    /**
+     * @brief Most bytes per writev() call, so progress stays smooth when one piece spans the whole file.
+     */
+    static constexpr size_t MaxWriteBytes = 16 * 1024 * 1024;
+
+    /**
+     * @brief Bytes written between progress reports.
+     */
+    static constexpr size_t ProgressInterval = 64 * 1024 * 1024;
+
+    /**
+     * @brief Attempts at finding an unused temporary file name.
+     */
+    static constexpr int TemporaryNameAttempts = 16;
+
+    /**
+     * @brief Distinguishes the temporary files of saves running at the same time.
+     */
+    static std::atomic<unsigned> temporaryCounter{0};
+
+    /**
+     * @brief Get the seconds elapsed since a time point.
+     * @param start The time point.
+     * @return The elapsed seconds.
+     */
+    static double getSecondsSince(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    /**
+     * @brief Resolve symbolic links, so saving through one replaces the file it points to.
+     * @param path The path to save to.
+     * @return The canonical path if the file exists, otherwise the path unchanged.
+     */
+    static std::string resolveTarget(const std::string& path) {
+        char* resolved = ::realpath(path.c_str(), nullptr);
+        if (!resolved) {
+            return path;
+        }
+        std::string target(resolved);
+        std::free(resolved);
+        return target;
+    }
+
+    /**
+     * @brief Get the directory part of a path.
+     * @param path The path.
+     * @return The directory, "." for a bare file name.
+     */
+    static std::string getDirectory(const std::string& path) {
+        const size_t slash = path.rfind('/');
+        if (slash == std::string::npos) {
+            return ".";
+        }
+        return slash == 0 ? std::string("/") : path.substr(0, slash);
+    }
+
+    /**
+     * @brief Create a new, unused temporary file next to the target, on the same file system so it can be renamed over it.
+     * @param target The file being saved.
+     * @param mode The permissions to create it with.
+     * @param temporaryPath Receives the temporary file path.
+     * @return The open file descriptor, or -1 with errno set.
+     */
+    static int createTemporary(const std::string& target, mode_t mode, std::string& temporaryPath) {
+        const size_t slash = target.rfind('/');
+        const std::string prefix = slash == std::string::npos ? "." + target : target.substr(0, slash + 1) + "." + target.substr(slash + 1);
+        for (int attempt = 0; attempt < TemporaryNameAttempts; ++attempt) {
+            temporaryPath = prefix + ".drite-" + std::to_string(::getpid()) + "-" + std::to_string(temporaryCounter.fetch_add(1));
+            const int fd = ::open(temporaryPath.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, mode);
+            if (fd >= 0 || errno != EEXIST) {
+                return fd;
+            }
+        }
+        return -1;
+    }
+
+    /**
+     * @brief Flush a file's data and metadata to the storage device.
+     * @param fd The file descriptor.
+     * @return True on success, false with errno set.
+     */
+    static bool syncFile(int fd) {
+    #ifdef __APPLE__
+        // fsync() on macOS leaves the data in the drive's cache
+        if (::fcntl(fd, F_FULLFSYNC) == 0) {
+            return true;
+        }
+    #endif
+        while (::fsync(fd) != 0) {
+            if (errno != EINTR) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /**
+     * @brief Stream the snapshot chunks to a file with vectored writes.
+     * @param fd The file descriptor.
+     * @param snapshot The text to write.
+     * @param progress Called after every ProgressInterval bytes; may be empty.
+     * @param stats Receives the write counters.
+     * @return True if everything was written, false with errno set.
+     */
+    static bool writeChunks(int fd, const TextSnapshot& snapshot, const SaveProgress& progress, SaveStats& stats) {
+        std::vector<iovec> vectors;
+        vectors.reserve(MaxWriteVectors);
+
+        // The position of the next unwritten byte
+        size_t chunk{0};
+        size_t inChunk{0};
+        size_t written{0};
+        size_t nextReport{ProgressInterval};
+        const size_t chunkCount = snapshot.chunks.size();
+
+        while (chunk < chunkCount) {
+            // Gather the following chunks, pointing into the backing buffers
+            vectors.clear();
+            size_t batch{0};
+            for (size_t next = chunk, offset = inChunk; next < chunkCount && vectors.size() < MaxWriteVectors && batch < MaxWriteBytes;
+                 ++next, offset = 0) {
+                const std::string_view text = snapshot.chunks[next];
+                const size_t length = std::min(text.size() - offset, MaxWriteBytes - batch);
+                if (length > 0) {
+                    snapshot.touch(text.substr(offset, length));
+                    vectors.push_back(iovec{const_cast<char*>(text.data() + offset), length});
+                    batch += length;
+                }
+            }
+            if (vectors.empty()) {
+                break;
+            }
+
+            const ssize_t count = ::writev(fd, vectors.data(), static_cast<int>(vectors.size()));
+            if (count < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return false;
+            }
+            if (count == 0) {
+                errno = EIO;
+                return false;
+            }
+            ++stats.writeCalls;
+
+            // Short writes resume mid-chunk on the next call
+            size_t remaining = static_cast<size_t>(count);
+            written += remaining;
+            while (remaining > 0) {
+                const size_t take = std::min(remaining, snapshot.chunks[chunk].size() - inChunk);
+                inChunk += take;
+                remaining -= take;
+                if (inChunk == snapshot.chunks[chunk].size()) {
+                    ++chunk;
+                    inChunk = 0;
+                }
+            }
+
+            if (progress && written >= nextReport) {
+                progress(written, snapshot.size);
+                nextReport = written + ProgressInterval;
+            }
+        }
+
+        stats.bytes = written;
+        stats.chunks = chunkCount;
+        return true;
+    }
+
+    /**
+     * @brief Write the text of a snapshot to a file, replacing it atomically.
+     * @param snapshot The text to write.
+     * @param path The file to write.
+     * @param progress Called after every few megabytes written, and once at the end; may be empty.
+     * @return The save counters, or std::nullopt if the file could not be written; the old file is then untouched.
+     */
+    std::optional<SaveStats> saveSnapshot(const TextSnapshot& snapshot, const std::string& path, const SaveProgress& progress) {
+        DRITE_PROFILE_ZONE("saveFile");
+
+        const std::string target = resolveTarget(path);
+        struct stat info{};
+        const bool existing = ::stat(target.c_str(), &info) == 0;
+        if (existing && !S_ISREG(info.st_mode)) {
+            std::println(stderr, "Save: {} is not a regular file", path);
+            return std::nullopt;
+        }
+
+        // A new file gets the usual permissions less the umask; an existing one keeps its own
+        const mode_t mode = existing ? static_cast<mode_t>(info.st_mode & 07777) : 0666;
+        std::string temporaryPath;
+        const int fd = createTemporary(target, mode, temporaryPath);
+        if (fd < 0) {
+            std::println(stderr, "Save: cannot create a temporary file next to {}: {}", path, std::strerror(errno));
+            return std::nullopt;
+        }
+
+        SaveStats stats;
+        const auto writeStart = std::chrono::steady_clock::now();
+        bool success = (!existing || ::fchmod(fd, mode) == 0) && writeChunks(fd, snapshot, progress, stats);
+        stats.writeSeconds = getSecondsSince(writeStart);
+
+        // The data must be durable before the rename makes it the file's contents
+        const auto syncStart = std::chrono::steady_clock::now();
+        success = success && syncFile(fd);
+        int error = success ? 0 : errno;
+        if (::close(fd) != 0 && success) {
+            success = false;
+            error = errno;
+        }
+        if (success && ::rename(temporaryPath.c_str(), target.c_str()) != 0) {
+            success = false;
+            error = errno;
+        }
+        if (!success) {
+            ::unlink(temporaryPath.c_str());
+            std::println(stderr, "Save: failed to write {}: {}", path, std::strerror(error));
+            return std::nullopt;
+        }
+
+        // Syncing the directory makes the rename itself survive a crash
+        const std::string directory = getDirectory(target);
+        const int directoryFd = ::open(directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (directoryFd < 0 || !syncFile(directoryFd)) {
+            std::println(stderr, "Save: wrote {}, but could not sync {}: {}", path, directory, std::strerror(errno));
+        }
+        if (directoryFd >= 0) {
+            ::close(directoryFd);
+        }
+        stats.syncSeconds = getSecondsSince(syncStart);
+
+        if (progress) {
+            progress(stats.bytes, snapshot.size);
+        }
+        return stats;
+    }
+
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "editor/text_snapshot.h"
+#include <cstddef>
+#include <functional>
+#include <optional>
+#include <string>
+
+namespace drite {
+
+    /**
+     * @brief Callback receiving the bytes written so far and the total while a file is saved.
+     */
+    using SaveProgress = std::function<void(size_t written, size_t total)>;
+
+    /**
+     * @brief Counters describing a completed save.
+     */
+    struct SaveStats {
+        size_t bytes{0};
+        size_t chunks{0};
+        size_t writeCalls{0};
+        double writeSeconds{0.0};
+        double syncSeconds{0.0};
+    };
+
+    /**
+     * @brief Write the text of a snapshot to a file, replacing it atomically.
+     *
+     * The chunks are streamed straight from the piece table's backing buffers
+     * with vectored writes, so the document is never copied into one string.
+     * They go to a temporary file next to the target, which is synced and then
+     * renamed over it: readers and crashes see either the old file or the new
+     * one, never a mix. The target keeps its permissions, and a symbolic link
+     * is followed rather than replaced.
+     *
+     * Safe to call from any thread while the snapshot's buffer lives. A
+     * document mapped from the target stays valid, since the rename leaves the
+     * old file's pages in place.
+     *
+     * @param snapshot The text to write.
+     * @param path The file to write.
+     * @param progress Called after every few megabytes written, and once at the end; may be empty.
+     * @return The save counters, or std::nullopt if the file could not be written; the old file is then untouched.
+     */
+    [[nodiscard]] std::optional<SaveStats> saveSnapshot(const TextSnapshot& snapshot, const std::string& path,
+                                                        const SaveProgress& progress = {});
+
+}
@@ -0,0 +1,66 @@
+#include "io/mapped_file.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace drite {
+
+    /**
+     * @brief Map a file read-only.
+     * @param path The path of the file to map.
+     * @return The mapped file, or nullptr if the file is not a mappable regular file.
+     */
+    std::unique_ptr<MappedFile> MappedFile::open(const std::string& path) {
+        const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            return nullptr;
+        }
+
+        // Pipes, devices and empty files cannot be mapped
+        struct stat info{};
+        if (::fstat(fd, &info) != 0 || !S_ISREG(info.st_mode) || info.st_size <= 0) {
+            ::close(fd);
+            return nullptr;
+        }
+
+        const size_t size = static_cast<size_t>(info.st_size);
+        void* data = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+        // The mapping keeps its own reference to the file
+        ::close(fd);
+
+        if (data == MAP_FAILED) {
+            return nullptr;
+        }
+
+        return std::unique_ptr<MappedFile>(new MappedFile(static_cast<const char*>(data), size));
+    }
+
+    /**
+     * @brief Construct a MappedFile from an existing mapping.
+     * @param data The start of the mapping.
+     * @param size The size of the mapping in bytes.
+     */
+    MappedFile::MappedFile(const char* data, size_t size)
+        : m_data(data)
+        , m_size(size) {}
+
+    /**
+     * @brief Destroy the MappedFile object, unmapping the file.
+     */
+    MappedFile::~MappedFile() {
+        if (m_data) {
+            ::munmap(const_cast<char*>(m_data), m_size);
+        }
+    }
+
+    /**
+     * @brief Get the mapped bytes.
+     * @return A view of the whole file.
+     */
+    std::string_view MappedFile::getData() const noexcept {
+        return std::string_view(m_data, m_size);
+    }
+
+}
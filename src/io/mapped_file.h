@@ -0,0 +1,65 @@
+#pragma once
+
+#include "editor/text_buffer.h"
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace drite {
+
+    /**
+     * @brief A read-only memory mapping of a regular file.
+     *
+     * The mapping is used directly as the original buffer of a TextBuffer, so opening
+     * a file only sets up page tables; pages are faulted in as they are read.
+     */
+    class MappedFile : public TextStorage {
+        public:
+            /**
+             * @brief Map a file read-only.
+             * @param path The path of the file to map.
+             * @return The mapped file, or nullptr if the file is not a mappable regular file.
+             */
+            [[nodiscard]] static std::unique_ptr<MappedFile> open(const std::string& path);
+
+            /**
+             * @brief Destroy the MappedFile object, unmapping the file.
+             */
+            ~MappedFile() override;
+
+            MappedFile(const MappedFile&) = delete;
+            MappedFile& operator=(const MappedFile&) = delete;
+
+            /**
+             * @brief Get the mapped bytes.
+             * @return A view of the whole file.
+             */
+            [[nodiscard]] std::string_view getData() const noexcept override;
+
+            /**
+             * @brief Get the size of the mapping in bytes.
+             * @return The mapped file size.
+             */
+            [[nodiscard]] size_t getSize() const noexcept { return m_size; }
+
+        private:
+            /**
+             * @brief Construct a MappedFile from an existing mapping.
+             * @param data The start of the mapping.
+             * @param size The size of the mapping in bytes.
+             */
+            MappedFile(const char* data, size_t size);
+
+        private:
+            /**
+             * @brief The start of the mapping.
+             */
+            const char* m_data{nullptr};
+
+            /**
+             * @brief The size of the mapping in bytes.
+             */
+            size_t m_size{0};
+    };
+
+}
@@ -0,0 +1,197 @@
+#include "io/paged_file.h"
+#include <algorithm>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace drite {
+
+    /**
+     * @brief The fewest pages kept loaded, so a read spanning a page boundary never evicts itself.
+     */
+    static constexpr size_t MinResidentPages = 4;
+
+    /**
+     * @brief Map a file read-only with a bounded resident size.
+     * @param path The path of the file to map.
+     * @param residentLimit The most bytes of the file to keep loaded; at least a few pages are always allowed.
+     * @return The paged file, or nullptr if the file is not a mappable regular file.
+     */
+    std::unique_ptr<PagedFile> PagedFile::open(const std::string& path, size_t residentLimit) {
+        const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            return nullptr;
+        }
+
+        // Pipes, devices and empty files cannot be mapped
+        struct stat info{};
+        if (::fstat(fd, &info) != 0 || !S_ISREG(info.st_mode) || info.st_size <= 0) {
+            ::close(fd);
+            return nullptr;
+        }
+
+        const size_t size = static_cast<size_t>(info.st_size);
+        void* data = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+        // The mapping keeps its own reference to the file
+        ::close(fd);
+
+        if (data == MAP_FAILED) {
+            return nullptr;
+        }
+
+        // The cache reads whole pages ahead itself; kernel read-ahead would
+        // only pull in more than the limit allows
+        ::madvise(data, size, MADV_RANDOM);
+
+        return std::unique_ptr<PagedFile>(new PagedFile(static_cast<const char*>(data), size, residentLimit));
+    }
+
+    /**
+     * @brief Construct a PagedFile from an existing mapping.
+     * @param data The start of the mapping.
+     * @param size The size of the mapping in bytes.
+     * @param residentLimit The most bytes to keep loaded.
+     */
+    PagedFile::PagedFile(const char* data, size_t size, size_t residentLimit)
+        : m_data(data)
+        , m_size(size)
+        , m_residentLimit(std::max(residentLimit / PageSize, MinResidentPages))
+        , m_pages((size + PageSize - 1) / PageSize) {}
+
+    /**
+     * @brief Destroy the PagedFile object, unmapping the file.
+     */
+    PagedFile::~PagedFile() {
+        if (m_data) {
+            ::munmap(const_cast<char*>(m_data), m_size);
+        }
+    }
+
+    /**
+     * @brief Get the mapped bytes.
+     * @return A view of the whole file; read ranges of it through touch() first.
+     */
+    std::string_view PagedFile::getData() const noexcept {
+        return std::string_view(m_data, m_size);
+    }
+
+    /**
+     * @brief Load the pages of a range and mark them most recently used, evicting others over the limit.
+     * @param offset The byte offset of the range.
+     * @param length The length of the range in bytes.
+     */
+    void PagedFile::touch(size_t offset, size_t length) const noexcept {
+        if (length == 0 || offset >= m_size) {
+            return;
+        }
+        length = std::min(length, m_size - offset);
+        const auto first = static_cast<uint32_t>(offset / PageSize);
+        const auto last = static_cast<uint32_t>((offset + length - 1) / PageSize);
+
+        // Rendering and lexing read many short lines in a row from one page
+        if (first == last && m_lastPage.load(std::memory_order_relaxed) == first) {
+            m_hits.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        std::lock_guard lock(m_mutex);
+        for (uint32_t page = first; page <= last; ++page) {
+            if (m_pages[page].resident) {
+                m_hits.fetch_add(1, std::memory_order_relaxed);
+                unlink(page);
+                linkFront(page);
+            } else {
+                load(page);
+            }
+        }
+
+        // The pages just read are the newest, so only a range larger than the
+        // limit makes the oldest one of them; it is then kept over the limit
+        while (m_residentPages > m_residentLimit && m_oldest != NoPage && (m_oldest < first || m_oldest > last)) {
+            const uint32_t page = m_oldest;
+            unlink(page);
+            m_pages[page].resident = false;
+            --m_residentPages;
+            ++m_evictions;
+
+            // Unmodified private file pages are dropped and re-read from the file on the next access
+            const size_t start = static_cast<size_t>(page) * PageSize;
+            ::madvise(const_cast<char*>(m_data) + start, std::min(PageSize, m_size - start), MADV_DONTNEED);
+            if (m_lastPage.load(std::memory_order_relaxed) == page) {
+                m_lastPage.store(NoPage, std::memory_order_relaxed);
+            }
+        }
+        m_lastPage.store(last, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Get the page cache counters.
+     * @return A snapshot of the counters.
+     */
+    PageCacheStats PagedFile::getStats() const {
+        std::lock_guard lock(m_mutex);
+        PageCacheStats stats;
+        stats.pageSize = PageSize;
+        stats.residentLimit = m_residentLimit * PageSize;
+        stats.residentPages = m_residentPages;
+        stats.peakResidentPages = m_peakResidentPages;
+        stats.hits = m_hits.load(std::memory_order_relaxed);
+        stats.faults = m_faults;
+        stats.evictions = m_evictions;
+        return stats;
+    }
+
+    /**
+     * @brief Load a page and link it as most recently used; the mutex must be held.
+     * @param page The page index.
+     */
+    void PagedFile::load(uint32_t page) const noexcept {
+        // One read of the whole page instead of a fault per memory page
+        const size_t start = static_cast<size_t>(page) * PageSize;
+        ::madvise(const_cast<char*>(m_data) + start, std::min(PageSize, m_size - start), MADV_WILLNEED);
+
+        m_pages[page].resident = true;
+        linkFront(page);
+        ++m_faults;
+        m_peakResidentPages = std::max(m_peakResidentPages, ++m_residentPages);
+    }
+
+    /**
+     * @brief Unlink a page from the recency list; the mutex must be held.
+     * @param page The page index.
+     */
+    void PagedFile::unlink(uint32_t page) const noexcept {
+        PageEntry& entry = m_pages[page];
+        if (entry.newer != NoPage) {
+            m_pages[entry.newer].older = entry.older;
+        } else {
+            m_newest = entry.older;
+        }
+        if (entry.older != NoPage) {
+            m_pages[entry.older].newer = entry.newer;
+        } else {
+            m_oldest = entry.newer;
+        }
+        entry.newer = NoPage;
+        entry.older = NoPage;
+    }
+
+    /**
+     * @brief Link a page as most recently used; the mutex must be held.
+     * @param page The page index.
+     */
+    void PagedFile::linkFront(uint32_t page) const noexcept {
+        PageEntry& entry = m_pages[page];
+        entry.newer = NoPage;
+        entry.older = m_newest;
+        if (m_newest != NoPage) {
+            m_pages[m_newest].newer = page;
+        } else {
+            m_oldest = page;
+        }
+        m_newest = page;
+    }
+
+}
@@ -0,0 +1,180 @@
+#pragma once
+
+#include "editor/text_buffer.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace drite {
+
+    /**
+     * @brief Counters of a paged file's page cache.
+     */
+    struct PageCacheStats {
+        size_t pageSize{0};
+        size_t residentLimit{0};
+        size_t residentPages{0};
+        size_t peakResidentPages{0};
+        uint64_t hits{0};
+        uint64_t faults{0};
+        uint64_t evictions{0};
+    };
+
+    /**
+     * @brief A read-only file mapping of which at most a fixed amount stays resident.
+     *
+     * The file is mapped whole, so piece views into it stay contiguous, but
+     * the mapping is divided into fixed-size pages managed by an LRU cache.
+     * Reading through touch() loads the pages of a range on demand and,
+     * once more than the resident limit is loaded, drops the least recently
+     * used pages from memory. A dropped page is re-read from the file when
+     * next read, so views into it never dangle; a view read without touch()
+     * works but escapes the limit.
+     *
+     * This lets a file far larger than memory be opened, scrolled, searched
+     * and saved; edits live in the text buffer's add blocks as usual.
+     */
+    class PagedFile : public TextStorage {
+        public:
+            /**
+             * @brief Size of a cache page in bytes.
+             */
+            static constexpr size_t PageSize = size_t{1} << 20;
+
+            /**
+             * @brief Map a file read-only with a bounded resident size.
+             * @param path The path of the file to map.
+             * @param residentLimit The most bytes of the file to keep loaded; at least a few pages are always allowed.
+             * @return The paged file, or nullptr if the file is not a mappable regular file.
+             */
+            [[nodiscard]] static std::unique_ptr<PagedFile> open(const std::string& path, size_t residentLimit);
+
+            /**
+             * @brief Destroy the PagedFile object, unmapping the file.
+             */
+            ~PagedFile() override;
+
+            PagedFile(const PagedFile&) = delete;
+            PagedFile& operator=(const PagedFile&) = delete;
+
+            /**
+             * @brief Get the mapped bytes.
+             * @return A view of the whole file; read ranges of it through touch() first.
+             */
+            [[nodiscard]] std::string_view getData() const noexcept override;
+
+            /**
+             * @brief Load the pages of a range and mark them most recently used, evicting others over the limit.
+             * @param offset The byte offset of the range.
+             * @param length The length of the range in bytes.
+             */
+            void touch(size_t offset, size_t length) const noexcept override;
+
+            /**
+             * @brief Get the page cache counters.
+             * @return A snapshot of the counters.
+             */
+            [[nodiscard]] PageCacheStats getStats() const;
+
+        private:
+            /**
+             * @brief Construct a PagedFile from an existing mapping.
+             * @param data The start of the mapping.
+             * @param size The size of the mapping in bytes.
+             * @param residentLimit The most bytes to keep loaded.
+             */
+            PagedFile(const char* data, size_t size, size_t residentLimit);
+
+            /**
+             * @brief Load a page and link it as most recently used; the mutex must be held.
+             * @param page The page index.
+             */
+            void load(uint32_t page) const noexcept;
+
+            /**
+             * @brief Unlink a page from the recency list; the mutex must be held.
+             * @param page The page index.
+             */
+            void unlink(uint32_t page) const noexcept;
+
+            /**
+             * @brief Link a page as most recently used; the mutex must be held.
+             * @param page The page index.
+             */
+            void linkFront(uint32_t page) const noexcept;
+
+        private:
+            /**
+             * @brief Marks a page absent from the recency list, and the ends of the list.
+             */
+            static constexpr uint32_t NoPage = UINT32_MAX;
+
+            /**
+             * @brief A cache page: its neighbours in recency order, most recent first.
+             */
+            struct PageEntry {
+                uint32_t newer{NoPage};
+                uint32_t older{NoPage};
+                bool resident{false};
+            };
+
+            /**
+             * @brief The start of the mapping.
+             */
+            const char* m_data{nullptr};
+
+            /**
+             * @brief The size of the mapping in bytes.
+             */
+            size_t m_size{0};
+
+            /**
+             * @brief The most pages kept loaded.
+             */
+            size_t m_residentLimit{0};
+
+            /**
+             * @brief Guards the pages, the recency list and the counters below it.
+             */
+            mutable std::mutex m_mutex;
+
+            /**
+             * @brief Every page of the file.
+             */
+            mutable std::vector<PageEntry> m_pages;
+
+            /**
+             * @brief The most and least recently used resident pages.
+             */
+            mutable uint32_t m_newest{NoPage};
+            mutable uint32_t m_oldest{NoPage};
+
+            /**
+             * @brief The number of resident pages, and the most there ever were.
+             */
+            mutable size_t m_residentPages{0};
+            mutable size_t m_peakResidentPages{0};
+
+            /**
+             * @brief Pages loaded on demand and dropped over the limit.
+             */
+            mutable uint64_t m_faults{0};
+            mutable uint64_t m_evictions{0};
+
+            /**
+             * @brief The most recently used page, read without locking so runs of reads within one page skip the mutex.
+             */
+            mutable std::atomic<uint32_t> m_lastPage{NoPage};
+
+            /**
+             * @brief Reads of pages already loaded.
+             */
+            mutable std::atomic<uint64_t> m_hits{0};
+    };
+
+}
@@ -0,0 +1,812 @@
+#include "io/session_snapshot.h"
+#include "core/profiler.h"
+#include "editor/text_snapshot.h"
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <deque>
+#include <iterator>
+#include <print>
+#include <sys/stat.h>
+#include <type_traits>
+#include <utility>
+
+namespace drite {
+
+    /**
+     * @brief The first bytes of every session snapshot.
+     */
+    static constexpr char SessionMagic[8] = {'D', 'R', 'I', 'T', 'E', 'S', 'E', 'S'};
+
+    /**
+     * @brief How long after a file was modified its stamp is not trusted without hashing, in nanoseconds.
+     *
+     * A write landing within the timestamp granularity of the previous one can
+     * leave the size and modification time unchanged; two seconds covers the
+     * coarsest file systems.
+     */
+    static constexpr int64_t RacyNanoseconds = 2'000'000'000;
+
+    /**
+     * @brief Bytes of storage hashed per step.
+     */
+    static constexpr size_t HashStep = size_t{4} << 20;
+
+    /**
+     * @brief Alignment of every array and section in a snapshot.
+     */
+    static constexpr size_t SessionAlignment = 8;
+
+    /**
+     * @brief The xxHash64 primes.
+     */
+    static constexpr uint64_t HashPrime1 = 0x9E3779B185EBCA87ULL;
+    static constexpr uint64_t HashPrime2 = 0xC2B2AE3D27D4EB4FULL;
+    static constexpr uint64_t HashPrime3 = 0x165667B19E3779F9ULL;
+    static constexpr uint64_t HashPrime4 = 0x85EBCA77C2B2AE63ULL;
+    static constexpr uint64_t HashPrime5 = 0x27D4EB2F165667C5ULL;
+
+    /**
+     * @brief A run of records in a section: a byte offset from the section start and a record count.
+     */
+    struct SessionRange {
+        uint64_t offset{0};
+        uint64_t count{0};
+    };
+
+    /**
+     * @brief The start of a snapshot file, followed by the section directory.
+     *
+     * The checksum covers the header, with the checksum itself zeroed, and the directory.
+     */
+    struct SessionHeader {
+        char magic[8]{};
+        uint32_t version{0};
+        uint32_t documentCount{0};
+        uint64_t fileSize{0};
+        uint64_t checksum{0};
+        uint64_t activeDocument{0};
+    };
+
+    /**
+     * @brief Where a document section lies in the file, and its checksum.
+     */
+    struct SessionDirectoryEntry {
+        uint64_t offset{0};
+        uint64_t size{0};
+        uint64_t checksum{0};
+    };
+
+    /**
+     * @brief Flags of a document section.
+     */
+    enum SessionDocumentFlags : uint64_t {
+        /**
+         * @brief The original text is stored in the section rather than read from the file.
+         */
+        SessionInlineOriginal = 1
+    };
+
+    /**
+     * @brief The start of a document section.
+     */
+    struct SessionDocumentHeader {
+        FileStamp stamp;
+        int64_t stampedNanoseconds{0};
+        uint64_t contentHash{0};
+        uint64_t flags{0};
+        uint64_t primaryCursor{0};
+        uint64_t scrollLine{0};
+        uint64_t lineFeedCount{0};
+        uint64_t indexedSize{0};
+        SessionRange path;
+        SessionRange original;
+        SessionRange cursors;
+        SessionRange addBlocks;
+        SessionRange pieces;
+        SessionRange lineIndex;
+        SessionRange undoGroups;
+        SessionRange redoGroups;
+        SessionRange deltas;
+        SessionRange groupPieces;
+        SessionRange groupCursors;
+        SessionRange lexStates;
+    };
+
+    /**
+     * @brief A piece of the document or of an undo group.
+     */
+    struct SessionPiece {
+        uint64_t buffer{0};
+        uint64_t start{0};
+        uint64_t length{0};
+        uint64_t lineFeeds{0};
+    };
+
+    /**
+     * @brief An undo delta; its piece indices are relative to the group's first piece.
+     */
+    struct SessionDelta {
+        uint64_t offset{0};
+        uint64_t removedLength{0};
+        uint64_t insertedLength{0};
+        uint32_t removedFirst{0};
+        uint32_t removedCount{0};
+        uint32_t insertedFirst{0};
+        uint32_t insertedCount{0};
+    };
+
+    /**
+     * @brief An undo group: runs of the shared delta, piece and cursor arrays.
+     */
+    struct SessionUndoGroup {
+        uint64_t firstDelta{0};
+        uint64_t deltaCount{0};
+        uint64_t firstPiece{0};
+        uint64_t pieceCount{0};
+        uint64_t firstCursor{0};
+        uint64_t cursorsBefore{0};
+        uint64_t cursorsAfter{0};
+        uint64_t cursorBefore{0};
+        uint64_t cursorAfter{0};
+        uint32_t kind{0};
+        uint32_t padding{0};
+    };
+
+    static_assert(std::is_trivially_copyable_v<SessionHeader> && sizeof(SessionHeader) % SessionAlignment == 0);
+    static_assert(std::is_trivially_copyable_v<SessionDirectoryEntry> && sizeof(SessionDirectoryEntry) % SessionAlignment == 0);
+    static_assert(std::is_trivially_copyable_v<SessionDocumentHeader> && sizeof(SessionDocumentHeader) % SessionAlignment == 0);
+    static_assert(std::is_trivially_copyable_v<SessionPiece> && std::is_trivially_copyable_v<SessionDelta>);
+    static_assert(std::is_trivially_copyable_v<SessionUndoGroup> && sizeof(SessionUndoGroup) % SessionAlignment == 0);
+
+    /**
+     * @brief Read 8 bytes in native byte order.
+     * @param data The bytes.
+     * @return The value.
+     */
+    static uint64_t read64(const char* data) noexcept {
+        uint64_t value;
+        std::memcpy(&value, data, sizeof(value));
+        return value;
+    }
+
+    /**
+     * @brief Read 4 bytes in native byte order.
+     * @param data The bytes.
+     * @return The value.
+     */
+    static uint32_t read32(const char* data) noexcept {
+        uint32_t value;
+        std::memcpy(&value, data, sizeof(value));
+        return value;
+    }
+
+    /**
+     * @brief Mix 8 bytes of input into an xxHash64 lane.
+     * @param lane The lane.
+     * @param input The input.
+     * @return The new lane.
+     */
+    static uint64_t hashRound(uint64_t lane, uint64_t input) noexcept {
+        lane += input * HashPrime2;
+        lane = std::rotl(lane, 31);
+        return lane * HashPrime1;
+    }
+
+    /**
+     * @brief Fold an xxHash64 lane into the hash.
+     * @param hash The hash.
+     * @param lane The lane.
+     * @return The new hash.
+     */
+    static uint64_t hashMerge(uint64_t hash, uint64_t lane) noexcept {
+        hash ^= hashRound(0, lane);
+        return hash * HashPrime1 + HashPrime4;
+    }
+
+    /**
+     * @brief Hash bytes with 64-bit xxHash, which is stable across builds and platforms.
+     * @param bytes The bytes.
+     * @param seed The seed, e.g. the hash of the bytes before them.
+     * @return The hash.
+     */
+    uint64_t hashBytes(std::string_view bytes, uint64_t seed) noexcept {
+        const char* data = bytes.data();
+        const char* const end = data + bytes.size();
+        uint64_t hash;
+
+        if (bytes.size() >= 32) {
+            uint64_t lanes[4] = {seed + HashPrime1 + HashPrime2, seed + HashPrime2, seed, seed - HashPrime1};
+            for (; end - data >= 32; data += 32) {
+                for (size_t lane = 0; lane < 4; ++lane) {
+                    lanes[lane] = hashRound(lanes[lane], read64(data + lane * 8));
+                }
+            }
+            hash = std::rotl(lanes[0], 1) + std::rotl(lanes[1], 7) + std::rotl(lanes[2], 12) + std::rotl(lanes[3], 18);
+            for (const uint64_t lane : lanes) {
+                hash = hashMerge(hash, lane);
+            }
+        } else {
+            hash = seed + HashPrime5;
+        }
+        hash += bytes.size();
+
+        for (; end - data >= 8; data += 8) {
+            hash ^= hashRound(0, read64(data));
+            hash = std::rotl(hash, 27) * HashPrime1 + HashPrime4;
+        }
+        if (end - data >= 4) {
+            hash ^= read32(data) * HashPrime1;
+            hash = std::rotl(hash, 23) * HashPrime2 + HashPrime3;
+            data += 4;
+        }
+        for (; data < end; ++data) {
+            hash ^= static_cast<uint8_t>(*data) * HashPrime5;
+            hash = std::rotl(hash, 11) * HashPrime1;
+        }
+
+        hash ^= hash >> 33;
+        hash *= HashPrime2;
+        hash ^= hash >> 29;
+        hash *= HashPrime3;
+        hash ^= hash >> 32;
+        return hash;
+    }
+
+    /**
+     * @brief Hash the text of storage a few megabytes at a time, so paged storage is never resident at once.
+     * @param storage The storage.
+     * @return The hash, never 0.
+     */
+    uint64_t hashText(const TextStorage& storage) {
+        DRITE_PROFILE_ZONE("hashText");
+        const std::string_view text = storage.getData();
+        uint64_t hash{0};
+        for (size_t offset = 0; offset < text.size(); offset += HashStep) {
+            const size_t step = std::min(HashStep, text.size() - offset);
+            storage.touch(offset, step);
+            hash = hashBytes(text.substr(offset, step), hash);
+        }
+        return hash != 0 ? hash : 1;
+    }
+
+    /**
+     * @brief Append records to a section, aligned.
+     * @param bytes The section.
+     * @param records The records.
+     * @return The range of the records.
+     */
+    template <typename T>
+    static SessionRange appendRecords(std::string& bytes, std::span<const T> records) {
+        bytes.resize((bytes.size() + SessionAlignment - 1) / SessionAlignment * SessionAlignment);
+        const SessionRange range{bytes.size(), records.size()};
+        bytes.append(reinterpret_cast<const char*>(records.data()), records.size_bytes());
+        return range;
+    }
+
+    /**
+     * @brief Append text to a section, aligned.
+     * @param bytes The section.
+     * @param text The text.
+     * @return The range of the text.
+     */
+    static SessionRange appendText(std::string& bytes, std::string_view text) {
+        return appendRecords(bytes, std::span<const char>(text.data(), text.size()));
+    }
+
+    /**
+     * @brief Convert offsets to the 64-bit records of a snapshot.
+     * @param offsets The offsets.
+     * @param records Receives the records.
+     */
+    static void appendOffsets(std::span<const size_t> offsets, std::vector<uint64_t>& records) {
+        records.insert(records.end(), offsets.begin(), offsets.end());
+    }
+
+    /**
+     * @brief Convert a piece to its record.
+     * @param piece The piece.
+     * @return The record.
+     */
+    static SessionPiece toRecord(const Piece& piece) noexcept {
+        return SessionPiece{piece.buffer, piece.start, piece.length, piece.lineFeeds};
+    }
+
+    /**
+     * @brief Convert a piece record back to a piece.
+     * @param record The record.
+     * @return The piece.
+     */
+    static Piece fromRecord(const SessionPiece& record) noexcept {
+        return Piece{static_cast<uint32_t>(std::min<uint64_t>(record.buffer, UINT32_MAX)), record.start, record.length, record.lineFeeds};
+    }
+
+    /**
+     * @brief Capture what a session snapshot keeps of a document, leaving the stamp and content hash to the caller.
+     * @param document The document.
+     * @param highlights The highlighting results for the document, kept only if they match its text.
+     * @param lineIndex The index of the original text from an earlier capture of the document, or nullptr to copy it.
+     * @return The state.
+     */
+    SessionDocumentState captureSessionDocument(const Document& document, std::shared_ptr<const HighlightTable> highlights,
+                                                std::shared_ptr<const LineIndex> lineIndex) {
+        DRITE_PROFILE_ZONE("captureSession");
+        const TextBuffer& buffer = document.getBuffer();
+        SessionDocumentState state;
+        state.path = document.getPath();
+        state.storage = buffer.getStorage();
+        state.ownedText = buffer.shareOwnedText();
+        if (state.storage) {
+            state.lineIndex = lineIndex ? std::move(lineIndex) : std::make_shared<const LineIndex>(buffer.getOriginalLineIndex());
+        } else {
+            state.originalText = buffer.getOriginalText();
+        }
+        state.addBlocks = buffer.getAddBlocks();
+        state.pieces = buffer.getPieces(0, buffer.getSize());
+        state.history = document.getHistory().share();
+        state.cursors.assign(document.getCursors().begin(), document.getCursors().end());
+        state.primaryCursor = document.getCursor();
+        state.scrollLine = document.getScrollLine();
+        if (highlights && highlights->revision == buffer.getRevision() && highlights->lineCount == buffer.getLineCount()) {
+            state.highlights = std::move(highlights);
+        }
+        return state;
+    }
+
+    /**
+     * @brief Encode one document as a self-contained, checksummed section of a session snapshot.
+     * @param state The document; its contentHash must be set if it has storage.
+     * @return The section.
+     */
+    SessionSection encodeSessionDocument(const SessionDocumentState& state) {
+        DRITE_PROFILE_ZONE("encodeSession");
+        SessionDocumentHeader header;
+        header.stamp = state.stamp;
+        header.stampedNanoseconds = state.stampedNanoseconds;
+        header.contentHash = state.contentHash;
+        header.primaryCursor = state.primaryCursor;
+        header.scrollLine = state.scrollLine;
+
+        SessionSection section;
+        std::string& bytes = section.encoded;
+        bytes.resize(sizeof(SessionDocumentHeader));
+        header.path = appendText(bytes, state.path);
+
+        // A document with its original text stored here needs no line index: the text is indexed on restore
+        if (!state.storage) {
+            header.flags |= SessionInlineOriginal;
+            header.original = appendText(bytes, state.originalText);
+        } else {
+            header.lineFeedCount = state.lineIndex->getLineFeedCount();
+            header.indexedSize = state.lineIndex->getIndexedSize();
+            header.lineIndex = appendRecords(bytes, std::span<const uint64_t>(state.lineIndex->getChunkPrefix()));
+        }
+
+        std::vector<uint64_t> cursors;
+        appendOffsets(state.cursors, cursors);
+        header.cursors = appendRecords(bytes, std::span<const uint64_t>(cursors));
+
+        std::vector<SessionRange> blocks;
+        blocks.reserve(state.addBlocks.size());
+        for (const std::string_view block : state.addBlocks) {
+            blocks.push_back(appendText(bytes, block));
+        }
+        header.addBlocks = appendRecords(bytes, std::span<const SessionRange>(blocks));
+
+        std::vector<SessionPiece> pieces;
+        pieces.reserve(state.pieces.size());
+        std::ranges::transform(state.pieces, std::back_inserter(pieces), toRecord);
+        header.pieces = appendRecords(bytes, std::span<const SessionPiece>(pieces));
+
+        // Undo and redo groups share one array each of deltas, pieces and cursors
+        std::vector<SessionUndoGroup> groups;
+        std::vector<SessionDelta> deltas;
+        std::vector<uint64_t> groupCursors;
+        pieces.clear();
+        const auto appendGroup = [&](const std::shared_ptr<const UndoGroup>& shared) {
+            const UndoGroup& group = *shared;
+            SessionUndoGroup record;
+            record.firstDelta = deltas.size();
+            record.deltaCount = group.deltas.size();
+            record.firstPiece = pieces.size();
+            record.pieceCount = group.pieces.size();
+            record.firstCursor = groupCursors.size();
+            record.cursorsBefore = group.cursorsBefore.size();
+            record.cursorsAfter = group.cursorsAfter.size();
+            record.cursorBefore = group.cursorBefore;
+            record.cursorAfter = group.cursorAfter;
+            record.kind = static_cast<uint32_t>(group.kind);
+            groups.push_back(record);
+
+            for (const EditDelta& delta : group.deltas) {
+                deltas.push_back(SessionDelta{delta.offset, delta.removedLength, delta.insertedLength, delta.removedFirst,
+                                              delta.removedCount, delta.insertedFirst, delta.insertedCount});
+            }
+            std::ranges::transform(group.pieces, std::back_inserter(pieces), toRecord);
+            appendOffsets(group.cursorsBefore, groupCursors);
+            appendOffsets(group.cursorsAfter, groupCursors);
+        };
+        std::ranges::for_each(state.history.undo, appendGroup);
+        header.undoGroups = appendRecords(bytes, std::span<const SessionUndoGroup>(groups));
+        groups.clear();
+        std::ranges::for_each(state.history.redo, appendGroup);
+        header.redoGroups = appendRecords(bytes, std::span<const SessionUndoGroup>(groups));
+        header.deltas = appendRecords(bytes, std::span<const SessionDelta>(deltas));
+        header.groupPieces = appendRecords(bytes, std::span<const SessionPiece>(pieces));
+        header.groupCursors = appendRecords(bytes, std::span<const uint64_t>(groupCursors));
+
+        // Only exact states are kept; guessed ones are lexed again
+        if (state.highlights) {
+            std::vector<LexState> states;
+            states.reserve(state.highlights->lineCount);
+            for (const std::shared_ptr<const HighlightTable::Block>& block : state.highlights->blocks) {
+                for (const LexState lexState : block->states) {
+                    states.push_back(lexState & LexProvisional ? LexUnknown : lexState);
+                }
+            }
+            header.lexStates = appendRecords(bytes, std::span<const LexState>(states));
+        }
+
+        bytes.resize((bytes.size() + SessionAlignment - 1) / SessionAlignment * SessionAlignment);
+        std::memcpy(bytes.data(), &header, sizeof(header));
+        section.checksum = hashBytes(bytes);
+        return section;
+    }
+
+    /**
+     * @brief Write a session snapshot, replacing the previous one atomically.
+     * @param path The snapshot file.
+     * @param sections The documents in order.
+     * @param activeDocument The index of the active document.
+     * @return The save counters, or std::nullopt if the file could not be written.
+     */
+    std::optional<SaveStats> writeSessionSnapshot(const std::string& path,
+                                                  std::span<const std::shared_ptr<const SessionSection>> sections,
+                                                  size_t activeDocument) {
+        DRITE_PROFILE_ZONE("writeSession");
+
+        // Parent directories are created as needed, e.g. ~/.cache/drite on first use
+        for (size_t slash = path.find('/', 1); slash != std::string::npos; slash = path.find('/', slash + 1)) {
+            ::mkdir(path.substr(0, slash).c_str(), 0755);
+        }
+
+        SessionHeader header;
+        std::memcpy(header.magic, SessionMagic, sizeof(SessionMagic));
+        header.version = SessionVersion;
+        header.documentCount = static_cast<uint32_t>(sections.size());
+        header.activeDocument = activeDocument;
+
+        std::vector<SessionDirectoryEntry> directory;
+        directory.reserve(sections.size());
+        uint64_t offset = sizeof(SessionHeader) + sections.size() * sizeof(SessionDirectoryEntry);
+        for (const std::shared_ptr<const SessionSection>& section : sections) {
+            directory.push_back(SessionDirectoryEntry{offset, section->getBytes().size(), section->checksum});
+            offset += section->getBytes().size();
+        }
+        header.fileSize = offset;
+
+        const std::string_view directoryBytes(reinterpret_cast<const char*>(directory.data()), directory.size() * sizeof(SessionDirectoryEntry));
+        header.checksum = hashBytes(directoryBytes, hashBytes(std::string_view(reinterpret_cast<const char*>(&header), sizeof(header))));
+        std::string prefix(reinterpret_cast<const char*>(&header), sizeof(header));
+        prefix.append(directoryBytes);
+
+        // The cached sections are written where they lie
+        TextSnapshot snapshot;
+        snapshot.chunks.reserve(sections.size() + 1);
+        snapshot.chunks.push_back(prefix);
+        for (const std::shared_ptr<const SessionSection>& section : sections) {
+            snapshot.chunks.push_back(section->getBytes());
+        }
+        snapshot.size = static_cast<size_t>(header.fileSize);
+        return saveSnapshot(snapshot, path);
+    }
+
+    /**
+     * @brief Check that a range of records lies inside a section.
+     * @param section The section.
+     * @param range The range.
+     * @return True if every record is inside and aligned.
+     */
+    template <typename T>
+    static bool isInside(std::string_view section, const SessionRange& range) noexcept {
+        return range.offset % alignof(T) == 0 && range.offset <= section.size() && range.count <= (section.size() - range.offset) / sizeof(T);
+    }
+
+    /**
+     * @brief Get the records of a range checked with isInside().
+     *
+     * The mapping is page aligned and every array in it is aligned for its
+     * records, which are trivially copyable, so they are read where they lie.
+     *
+     * @param section The section.
+     * @param range The range.
+     * @return The records.
+     */
+    template <typename T>
+    static std::span<const T> getRecords(std::string_view section, const SessionRange& range) noexcept {
+        return std::span<const T>(reinterpret_cast<const T*>(section.data() + range.offset), static_cast<size_t>(range.count));
+    }
+
+    /**
+     * @brief Get the text of a range checked with isInside().
+     * @param section The section.
+     * @param range The range.
+     * @return The text.
+     */
+    static std::string_view getText(std::string_view section, const SessionRange& range) noexcept {
+        return section.substr(static_cast<size_t>(range.offset), static_cast<size_t>(range.count));
+    }
+
+    /**
+     * @brief Check that every range of a document section lies inside it.
+     * @param section The section, at least as large as its header.
+     * @param header The section header.
+     * @return True if all ranges are inside.
+     */
+    static bool hasValidRanges(std::string_view section, const SessionDocumentHeader& header) noexcept {
+        if (!isInside<char>(section, header.path) || !isInside<char>(section, header.original) ||
+            !isInside<uint64_t>(section, header.cursors) || !isInside<SessionRange>(section, header.addBlocks) ||
+            !isInside<SessionPiece>(section, header.pieces) || !isInside<uint64_t>(section, header.lineIndex) ||
+            !isInside<SessionUndoGroup>(section, header.undoGroups) || !isInside<SessionUndoGroup>(section, header.redoGroups) ||
+            !isInside<SessionDelta>(section, header.deltas) || !isInside<SessionPiece>(section, header.groupPieces) ||
+            !isInside<uint64_t>(section, header.groupCursors) || !isInside<LexState>(section, header.lexStates)) {
+            return false;
+        }
+        return std::ranges::all_of(getRecords<SessionRange>(section, header.addBlocks),
+                                   [&](const SessionRange& block) { return isInside<char>(section, block); });
+    }
+
+    /**
+     * @brief Rebuild undo groups from their records.
+     * @param records The group records.
+     * @param deltas The shared delta records.
+     * @param pieces The shared piece records.
+     * @param cursors The shared cursor records.
+     * @param buffer The restored buffer the pieces must reference.
+     * @param groups Receives the groups.
+     * @return True if every group is consistent with the arrays and the buffer.
+     */
+    template <typename Groups>
+    static bool restoreGroups(std::span<const SessionUndoGroup> records, std::span<const SessionDelta> deltas,
+                              std::span<const SessionPiece> pieces, std::span<const uint64_t> cursors,
+                              const TextBuffer& buffer, Groups& groups) {
+        for (const SessionUndoGroup& record : records) {
+            if (record.firstDelta > deltas.size() || record.deltaCount > deltas.size() - record.firstDelta ||
+                record.firstPiece > pieces.size() || record.pieceCount > pieces.size() - record.firstPiece ||
+                record.firstCursor > cursors.size() || record.cursorsBefore > cursors.size() - record.firstCursor ||
+                record.cursorsAfter > cursors.size() - record.firstCursor - record.cursorsBefore ||
+                record.kind > static_cast<uint32_t>(EditKind::Other)) {
+                return false;
+            }
+
+            UndoGroup& group = groups.emplace_back();
+            group.cursorBefore = static_cast<size_t>(record.cursorBefore);
+            group.cursorAfter = static_cast<size_t>(record.cursorAfter);
+            group.kind = static_cast<EditKind>(record.kind);
+            group.sealed = true;
+
+            group.pieces.reserve(static_cast<size_t>(record.pieceCount));
+            for (const SessionPiece& piece : pieces.subspan(static_cast<size_t>(record.firstPiece), static_cast<size_t>(record.pieceCount))) {
+                group.pieces.push_back(fromRecord(piece));
+                if (!buffer.isValidPiece(group.pieces.back())) {
+                    return false;
+                }
+            }
+            group.deltas.reserve(static_cast<size_t>(record.deltaCount));
+            for (const SessionDelta& delta : deltas.subspan(static_cast<size_t>(record.firstDelta), static_cast<size_t>(record.deltaCount))) {
+                if (uint64_t{delta.removedFirst} + delta.removedCount > record.pieceCount ||
+                    uint64_t{delta.insertedFirst} + delta.insertedCount > record.pieceCount) {
+                    return false;
+                }
+                group.deltas.push_back(EditDelta{static_cast<size_t>(delta.offset), static_cast<size_t>(delta.removedLength),
+                                                 static_cast<size_t>(delta.insertedLength), delta.removedFirst, delta.removedCount,
+                                                 delta.insertedFirst, delta.insertedCount});
+            }
+            const std::span<const uint64_t> groupCursors = cursors.subspan(static_cast<size_t>(record.firstCursor),
+                                                                           static_cast<size_t>(record.cursorsBefore + record.cursorsAfter));
+            group.cursorsBefore.assign(groupCursors.begin(), groupCursors.begin() + static_cast<ptrdiff_t>(record.cursorsBefore));
+            group.cursorsAfter.assign(groupCursors.begin() + static_cast<ptrdiff_t>(record.cursorsBefore), groupCursors.end());
+        }
+        return true;
+    }
+
+    /**
+     * @brief Build a highlight table from saved line states.
+     * @param states The end state of every line, LexUnknown where not exact.
+     * @param revision The revision of the buffer the states belong to.
+     * @return The table.
+     */
+    static std::shared_ptr<const HighlightTable> makeHighlightTable(std::span<const LexState> states, uint64_t revision) {
+        auto table = std::make_shared<HighlightTable>();
+        table->revision = revision;
+        table->lineCount = states.size();
+        for (size_t first = 0; first < states.size() || table->blocks.empty(); first += SyntaxHighlighter::BlockLines) {
+            auto block = std::make_shared<HighlightTable::Block>();
+            const std::span<const LexState> run = states.subspan(first, std::min(SyntaxHighlighter::BlockLines, states.size() - first));
+            block->states.assign(run.begin(), run.end());
+            block->inexact = static_cast<size_t>(std::ranges::count_if(run, [](LexState state) { return (state & LexProvisional) != 0; }));
+            table->inexactLines += block->inexact;
+            table->blockFirstLines.push_back(first);
+            table->blocks.push_back(std::move(block));
+        }
+        return table;
+    }
+
+    /**
+     * @brief Map and check a session snapshot.
+     * @param path The snapshot file.
+     * @return The snapshot, or nullptr if there is none or it is damaged or of another version.
+     */
+    std::unique_ptr<SessionSnapshot> SessionSnapshot::open(const std::string& path) {
+        if (!getFileStamp(path)) {
+            return nullptr;
+        }
+        std::unique_ptr<MappedFile> file = MappedFile::open(path);
+        const std::string_view data = file ? file->getData() : std::string_view();
+        if (data.size() < sizeof(SessionHeader)) {
+            std::println(stderr, "Session: {} is not a session snapshot", path);
+            return nullptr;
+        }
+
+        SessionHeader header;
+        std::memcpy(&header, data.data(), sizeof(header));
+        if (std::memcmp(header.magic, SessionMagic, sizeof(SessionMagic)) != 0 || header.version != SessionVersion) {
+            std::println(stderr, "Session: {} is not a version {} session snapshot", path, SessionVersion);
+            return nullptr;
+        }
+
+        const uint64_t directorySize = uint64_t{header.documentCount} * sizeof(SessionDirectoryEntry);
+        const uint64_t checksum = std::exchange(header.checksum, 0);
+        if (header.fileSize != data.size() || directorySize > data.size() - sizeof(SessionHeader) ||
+            checksum != hashBytes(data.substr(sizeof(SessionHeader), static_cast<size_t>(directorySize)),
+                                  hashBytes(std::string_view(reinterpret_cast<const char*>(&header), sizeof(header))))) {
+            std::println(stderr, "Session: {} is damaged", path);
+            return nullptr;
+        }
+        return std::unique_ptr<SessionSnapshot>(new SessionSnapshot(std::move(file)));
+    }
+
+    /**
+     * @brief Construct a SessionSnapshot over a checked mapping.
+     * @param file The mapping.
+     */
+    SessionSnapshot::SessionSnapshot(std::shared_ptr<const MappedFile> file)
+        : m_file(std::move(file)) {}
+
+    /**
+     * @brief Get the number of documents in the snapshot.
+     * @return The document count.
+     */
+    size_t SessionSnapshot::getDocumentCount() const noexcept {
+        return reinterpret_cast<const SessionHeader*>(m_file->getData().data())->documentCount;
+    }
+
+    /**
+     * @brief Get the document that was active.
+     * @return Its index.
+     */
+    size_t SessionSnapshot::getActiveDocument() const noexcept {
+        return static_cast<size_t>(reinterpret_cast<const SessionHeader*>(m_file->getData().data())->activeDocument);
+    }
+
+    /**
+     * @brief Rebuild a document of the snapshot.
+     * @param index The document index.
+     * @param pageCacheLimit The resident limit of paged files, as for loadFile().
+     * @return The document, or std::nullopt if its section is damaged or its file cannot be read.
+     */
+    std::optional<RestoredDocument> SessionSnapshot::restoreDocument(size_t index, size_t pageCacheLimit) const {
+        DRITE_PROFILE_ZONE("restoreDocument");
+        const std::string_view data = m_file->getData();
+        const SessionDirectoryEntry& entry = getRecords<SessionDirectoryEntry>(data, SessionRange{sizeof(SessionHeader), getDocumentCount()})[index];
+        if (entry.offset % SessionAlignment != 0 || entry.offset > data.size() || entry.size > data.size() - entry.offset ||
+            entry.size < sizeof(SessionDocumentHeader) ||
+            hashBytes(data.substr(static_cast<size_t>(entry.offset), static_cast<size_t>(entry.size))) != entry.checksum) {
+            std::println(stderr, "Session: document {} is damaged", index + 1);
+            return std::nullopt;
+        }
+        const std::string_view section = data.substr(static_cast<size_t>(entry.offset), static_cast<size_t>(entry.size));
+        const SessionDocumentHeader& header = getRecords<SessionDocumentHeader>(section, SessionRange{0, 1})[0];
+        if (!hasValidRanges(section, header)) {
+            std::println(stderr, "Session: document {} is damaged", index + 1);
+            return std::nullopt;
+        }
+        const std::string path(getText(section, header.path));
+
+        RestoredDocument restored;
+        std::optional<TextBuffer> buffer;
+        if (header.flags & SessionInlineOriginal) {
+            restored.method = LoadMethod::Streamed;
+            buffer.emplace(std::string(getText(section, header.original)));
+        } else if (getFileStamp(path) == header.stamp) {
+            // The file looks unchanged: map it with its saved index
+            const std::span<const uint64_t> prefix = getRecords<uint64_t>(section, header.lineIndex);
+            LineIndex lineIndex(std::vector<uint64_t>(prefix.begin(), prefix.end()), static_cast<size_t>(header.lineFeedCount),
+                                static_cast<size_t>(header.indexedSize));
+            std::optional<LoadedFile> loaded = loadFile(path, pageCacheLimit, std::move(lineIndex));
+            bool unchanged = loaded && loaded->stamp == header.stamp && loaded->buffer.getStorage();
+            if (unchanged && header.stamp.modifiedNanoseconds + RacyNanoseconds > header.stampedNanoseconds) {
+                restored.hashed = true;
+                unchanged = hashText(*loaded->buffer.getStorage()) == header.contentHash;
+            }
+            if (unchanged) {
+                restored.method = loaded->method;
+                restored.stamp = loaded->stamp;
+                restored.stampedNanoseconds = restored.hashed ? loaded->stampedNanoseconds : header.stampedNanoseconds;
+                restored.contentHash = header.contentHash;
+                buffer.emplace(std::move(loaded->buffer));
+            }
+        }
+
+        // A changed or vanished file is loaded as it is now, keeping only the view
+        if (!buffer) {
+            restored.stale = true;
+            std::optional<LoadedFile> loaded = loadFile(path, pageCacheLimit);
+            if (!loaded) {
+                std::println(stderr, "Session: cannot open {}", path);
+                return std::nullopt;
+            }
+            restored.method = loaded->method;
+            restored.stamp = loaded->stamp;
+            restored.stampedNanoseconds = loaded->stampedNanoseconds;
+            buffer.emplace(std::move(loaded->buffer));
+        }
+
+        if (!restored.stale) {
+            const std::span<const SessionRange> blockRanges = getRecords<SessionRange>(section, header.addBlocks);
+            std::vector<std::string_view> blocks;
+            blocks.reserve(blockRanges.size());
+            for (const SessionRange& block : blockRanges) {
+                blocks.push_back(getText(section, block));
+            }
+            std::vector<Piece> pieces;
+            const std::span<const SessionPiece> pieceRecords = getRecords<SessionPiece>(section, header.pieces);
+            pieces.reserve(pieceRecords.size());
+            std::ranges::transform(pieceRecords, std::back_inserter(pieces), fromRecord);
+            if (!buffer->restorePieces(blocks, pieces)) {
+                std::println(stderr, "Session: the edits of {} do not fit its text; dropped them", path);
+                restored.stale = true;
+            }
+        }
+
+        restored.document = std::make_unique<Document>(std::move(*buffer), path);
+        Document& document = *restored.document;
+        if (!restored.stale) {
+            const std::span<const SessionDelta> deltas = getRecords<SessionDelta>(section, header.deltas);
+            const std::span<const SessionPiece> groupPieces = getRecords<SessionPiece>(section, header.groupPieces);
+            const std::span<const uint64_t> groupCursors = getRecords<uint64_t>(section, header.groupCursors);
+            std::deque<UndoGroup> undo;
+            std::vector<UndoGroup> redo;
+            if (restoreGroups(getRecords<SessionUndoGroup>(section, header.undoGroups), deltas, groupPieces, groupCursors,
+                              document.getBuffer(), undo) &&
+                restoreGroups(getRecords<SessionUndoGroup>(section, header.redoGroups), deltas, groupPieces, groupCursors,
+                              document.getBuffer(), redo)) {
+                document.getHistory().restore(std::move(undo), std::move(redo));
+            } else {
+                std::println(stderr, "Session: the undo history of {} is damaged; dropped it", path);
+            }
+
+            const std::span<const LexState> states = getRecords<LexState>(section, header.lexStates);
+            if (!states.empty() && states.size() == document.getBuffer().getLineCount()) {
+                restored.highlights = makeHighlightTable(states, document.getBuffer().getRevision());
+            }
+        }
+
+        // Cursors and scroll position survive even a changed file, clamped to it
+        const std::span<const uint64_t> cursorRecords = getRecords<uint64_t>(section, header.cursors);
+        if (!cursorRecords.empty()) {
+            const std::vector<size_t> cursors(cursorRecords.begin(), cursorRecords.end());
+            document.setCursors(cursors, static_cast<size_t>(header.primaryCursor));
+        }
+        document.setScrollLine(std::min(static_cast<size_t>(header.scrollLine), document.getBuffer().getLineCount() - 1));
+        if (!restored.stale) {
+            auto mapped = std::make_shared<SessionSection>();
+            mapped->mapping = m_file;
+            mapped->mapped = section;
+            mapped->checksum = entry.checksum;
+            restored.section = std::move(mapped);
+        }
+        return restored;
+    }
+
+}
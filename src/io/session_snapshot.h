@@ -0,0 +1,258 @@
+#pragma once
+
+#include "editor/document.h"
+#include "editor/line_index.h"
+#include "editor/undo_history.h"
+#include "io/file_loader.h"
+#include "io/file_saver.h"
+#include "io/mapped_file.h"
+#include "syntax/syntax_highlighter.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace drite {
+
+    /**
+     * @brief Layout version of session snapshots; snapshots of any other version are ignored.
+     */
+    inline constexpr uint32_t SessionVersion = 1;
+
+    /**
+     * @brief Everything a session snapshot keeps of one open document.
+     *
+     * Captured on the main thread and encoded on a worker. Only the pieces
+     * and cursors are copied: text the buffer owns is append-only, so it is
+     * viewed and kept alive through ownedText, and sealed undo groups, the
+     * line index and the highlight table are immutable once shared.
+     */
+    struct SessionDocumentState {
+        std::string path;
+
+        /**
+         * @brief The file the original text was loaded from, and when it was stamped; unused without storage.
+         */
+        FileStamp stamp;
+        int64_t stampedNanoseconds{0};
+
+        /**
+         * @brief Hash of the original text, from hashText(); 0 if it still has to be computed from storage.
+         */
+        uint64_t contentHash{0};
+
+        /**
+         * @brief The storage of the original text, for hashing it; nullptr if the buffer owns its original text.
+         */
+        std::shared_ptr<const TextStorage> storage;
+
+        /**
+         * @brief The text the buffer owns, keeping originalText and addBlocks valid.
+         */
+        std::vector<std::shared_ptr<const std::string>> ownedText;
+
+        /**
+         * @brief The original text of a document not backed by a file, such as standard input, stored in the snapshot; used without storage.
+         */
+        std::string_view originalText;
+
+        /**
+         * @brief The index of the original text in storage, shared by every capture of the document; nullptr without storage.
+         */
+        std::shared_ptr<const LineIndex> lineIndex;
+
+        std::vector<std::string_view> addBlocks;
+        std::vector<Piece> pieces;
+        UndoHistorySnapshot history;
+        std::vector<size_t> cursors;
+        size_t primaryCursor{0};
+        size_t scrollLine{0};
+
+        /**
+         * @brief Highlighting results for the document text, or nullptr.
+         */
+        std::shared_ptr<const HighlightTable> highlights;
+    };
+
+    /**
+     * @brief One encoded document of a session snapshot, reused verbatim until the document changes.
+     *
+     * A section encoded in memory owns its bytes; one restored from a snapshot
+     * views them where they lie in the mapping, which it keeps alive. Snapshots
+     * are replaced by renaming a new file over them, so the mapping never
+     * changes under it.
+     */
+    struct SessionSection {
+        std::string encoded;
+        std::shared_ptr<const MappedFile> mapping;
+        std::string_view mapped;
+        uint64_t checksum{0};
+
+        /**
+         * @brief Get the bytes of the section.
+         * @return The encoded bytes, or the mapped ones of a restored section.
+         */
+        [[nodiscard]] std::string_view getBytes() const noexcept { return mapping ? mapped : std::string_view(encoded); }
+    };
+
+    /**
+     * @brief A document rebuilt from a session snapshot.
+     */
+    struct RestoredDocument {
+        std::unique_ptr<Document> document;
+
+        /**
+         * @brief Highlighting results matching the restored text, or nullptr.
+         */
+        std::shared_ptr<const HighlightTable> highlights;
+
+        LoadMethod method{LoadMethod::Mapped};
+        FileStamp stamp;
+        int64_t stampedNanoseconds{0};
+        uint64_t contentHash{0};
+
+        /**
+         * @brief The section the document was restored from, to write again while it is unchanged; nullptr if stale.
+         */
+        std::shared_ptr<const SessionSection> section;
+
+        /**
+         * @brief Whether the file changed since the snapshot, so it was loaded afresh without the saved edits, history or caches.
+         */
+        bool stale{false};
+
+        /**
+         * @brief Whether the file had to be hashed because it was modified too close to being stamped to trust its stamp.
+         */
+        bool hashed{false};
+    };
+
+    /**
+     * @brief Hash bytes with 64-bit xxHash, which is stable across builds and platforms.
+     * @param bytes The bytes.
+     * @param seed The seed, e.g. the hash of the bytes before them.
+     * @return The hash.
+     */
+    [[nodiscard]] uint64_t hashBytes(std::string_view bytes, uint64_t seed = 0) noexcept;
+
+    /**
+     * @brief Hash the text of storage a few megabytes at a time, so paged storage is never resident at once.
+     * @param storage The storage.
+     * @return The hash, never 0.
+     */
+    [[nodiscard]] uint64_t hashText(const TextStorage& storage);
+
+    /**
+     * @brief Capture what a session snapshot keeps of a document, leaving the stamp and content hash to the caller.
+     *
+     * Cheap enough to call on the main thread after every change: text and
+     * sealed undo groups are shared rather than copied.
+     *
+     * @param document The document.
+     * @param highlights The highlighting results for the document, kept only if they match its text.
+     * @param lineIndex The index of the original text from an earlier capture of the document, or nullptr to copy it.
+     * @return The state.
+     */
+    [[nodiscard]] SessionDocumentState captureSessionDocument(const Document& document, std::shared_ptr<const HighlightTable> highlights,
+                                                              std::shared_ptr<const LineIndex> lineIndex = nullptr);
+
+    /**
+     * @brief Encode one document as a self-contained, checksummed section of a session snapshot.
+     * @param state The document; its contentHash must be set if it has storage.
+     * @return The section.
+     */
+    [[nodiscard]] SessionSection encodeSessionDocument(const SessionDocumentState& state);
+
+    /**
+     * @brief Write a session snapshot, replacing the previous one atomically.
+     *
+     * The header and section directory are written in front of the sections,
+     * which go out with vectored writes straight from where they are cached.
+     *
+     * @param path The snapshot file.
+     * @param sections The documents in order.
+     * @param activeDocument The index of the active document.
+     * @return The save counters, or std::nullopt if the file could not be written.
+     */
+    [[nodiscard]] std::optional<SaveStats> writeSessionSnapshot(const std::string& path,
+                                                                std::span<const std::shared_ptr<const SessionSection>> sections,
+                                                                size_t activeDocument);
+
+    /**
+     * @brief A session snapshot mapped read-only and used in place.
+     *
+     * The snapshot is a fixed header and a directory of document sections.
+     * Each section is a header of offsets into arrays of plain 64-bit-aligned
+     * records: cursors, add block text, pieces, the original line index, undo
+     * groups with their deltas, pieces and cursors, and the lexer state of
+     * every line. Nothing is parsed; restoring a document reads the arrays
+     * where they lie in the mapping and copies out only what the live
+     * structures own.
+     *
+     * The header carries a magic number, the layout version and a checksum of
+     * itself and the directory; every section has its own checksum in the
+     * directory, verified when it is restored, so a damaged section loses only
+     * its document.
+     */
+    class SessionSnapshot {
+        public:
+            /**
+             * @brief Map and check a session snapshot.
+             * @param path The snapshot file.
+             * @return The snapshot, or nullptr if there is none or it is damaged or of another version.
+             */
+            [[nodiscard]] static std::unique_ptr<SessionSnapshot> open(const std::string& path);
+
+            /**
+             * @brief Get the number of documents in the snapshot.
+             * @return The document count.
+             */
+            [[nodiscard]] size_t getDocumentCount() const noexcept;
+
+            /**
+             * @brief Get the document that was active.
+             * @return Its index.
+             */
+            [[nodiscard]] size_t getActiveDocument() const noexcept;
+
+            /**
+             * @brief Get the size of the snapshot file.
+             * @return The size in bytes.
+             */
+            [[nodiscard]] size_t getSize() const noexcept { return m_file->getSize(); }
+
+            /**
+             * @brief Rebuild a document of the snapshot.
+             *
+             * A document backed by a file whose stamp still matches is mapped
+             * with its saved line index, so its text is never read; a file
+             * modified within a couple of seconds of being stamped is hashed
+             * first, since its stamp may have missed a later write. A file that
+             * changed is loaded and indexed afresh with only its cursors and
+             * scroll position, clamped.
+             *
+             * @param index The document index.
+             * @param pageCacheLimit The resident limit of paged files, as for loadFile().
+             * @return The document, or std::nullopt if its section is damaged or its file cannot be read.
+             */
+            [[nodiscard]] std::optional<RestoredDocument> restoreDocument(size_t index, size_t pageCacheLimit) const;
+
+        private:
+            /**
+             * @brief Construct a SessionSnapshot over a checked mapping.
+             * @param file The mapping.
+             */
+            explicit SessionSnapshot(std::shared_ptr<const MappedFile> file);
+
+        private:
+            /**
+             * @brief The mapped snapshot file, shared with the sections of restored documents.
+             */
+            std::shared_ptr<const MappedFile> m_file;
+    };
+
+}
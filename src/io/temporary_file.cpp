@@ -0,0 +1,47 @@
+#include "io/temporary_file.h"
+#include <cstdlib>
+#include <fcntl.h>
+
+namespace drite {
+
+    /**
+     * @brief Get the directory temporary files go in.
+     * @return $TMPDIR without trailing slashes, or /tmp if it is unset or empty.
+     */
+    std::string getTemporaryDirectory() {
+        const char* temporary = std::getenv("TMPDIR");
+        std::string directory = temporary != nullptr && *temporary != '\0' ? temporary : "/tmp";
+        while (directory.size() > 1 && directory.back() == '/') {
+            directory.pop_back();
+        }
+        return directory;
+    }
+
+    /**
+     * @brief Create a temporary directory only the current user can read, write or enter.
+     * @param prefix The start of its name, followed by random characters, e.g. "drite-grep".
+     * @return The path of the new directory, or std::nullopt with errno set if none could be created.
+     */
+    std::optional<std::string> createTemporaryDirectory(std::string_view prefix) {
+        // mkdtemp creates it with mode 0700 whatever the umask
+        std::string path = getTemporaryDirectory() + "/" + std::string(prefix) + "-XXXXXX";
+        if (::mkdtemp(path.data()) == nullptr) {
+            return std::nullopt;
+        }
+        return path;
+    }
+
+    /**
+     * @brief Create and open a temporary file only the current user can read or write.
+     * @param prefix The start of its name, followed by random characters, e.g. "drite-undo".
+     * @param suffix The end of its name, e.g. ".cpp"; may be empty.
+     * @param path Receives the path of the new file.
+     * @return The open file descriptor, or -1 with errno set if no file could be created.
+     */
+    int createTemporaryFile(std::string_view prefix, std::string_view suffix, std::string& path) {
+        // mkostemps creates it with mode 0600 and O_EXCL, so an existing file or link is never opened
+        path = getTemporaryDirectory() + "/" + std::string(prefix) + "-XXXXXX" + std::string(suffix);
+        return ::mkostemps(path.data(), static_cast<int>(suffix.size()), O_CLOEXEC);
+    }
+
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace drite {
+
+    /**
+     * @brief Get the directory temporary files go in.
+     * @return $TMPDIR without trailing slashes, or /tmp if it is unset or empty.
+     */
+    [[nodiscard]] std::string getTemporaryDirectory();
+
+    /**
+     * @brief Create a temporary directory only the current user can read, write or enter.
+     * @param prefix The start of its name, followed by random characters, e.g. "drite-grep".
+     * @return The path of the new directory, or std::nullopt with errno set if none could be created.
+     */
+    [[nodiscard]] std::optional<std::string> createTemporaryDirectory(std::string_view prefix);
+
+    /**
+     * @brief Create and open a temporary file only the current user can read or write.
+     *
+     * The file is opened for reading and writing with O_CLOEXEC, so children
+     * started later do not inherit it.
+     *
+     * @param prefix The start of its name, followed by random characters, e.g. "drite-undo".
+     * @param suffix The end of its name, e.g. ".cpp"; may be empty.
+     * @param path Receives the path of the new file.
+     * @return The open file descriptor, or -1 with errno set if no file could be created.
+     */
+    [[nodiscard]] int createTemporaryFile(std::string_view prefix, std::string_view suffix, std::string& path);
+
+}
@@ -1,9 +1,67 @@
 #include "application/application.h"
+#include "application/command_line.h"
+#include "application/find_file_command.h"
+#include "application/grep_command.h"
+#include "application/handoff_command.h"
+#include "core/profiler.h"
+#include "core/startup_trace.h"
+#include "platform/platform_factory.h"
+#include <optional>
 #include <print>
 
-int main() {
+int main(int argc, char** argv) {
+    // Parse the command line; startup phases are timed from here to the first frame
+    const double parseStart = drite::StartupTrace::now();
+    const auto options = drite::parseCommandLine(argc, argv);
+    drite::StartupTrace::record("command line", parseStart, drite::StartupTrace::now());
+    if (!options) {
+        drite::printUsage();
+        return 1;
+    }
+
+    if (options->showHelp) {
+        drite::printUsage();
+        return 0;
+    }
+
+    // Grep and find-file modes exit without opening a window
+    if (!options->grepPattern.empty()) {
+        return drite::runGrep(*options);
+    }
+    if (!options->findFilePattern.empty()) {
+        return drite::runFindFile(*options);
+    }
+
+    // An editor already running takes the files, before any window is made
+    const double handoffStart = drite::StartupTrace::now();
+    if (const std::optional<int> status = drite::runHandoff(*options)) {
+        return *status;
+    }
+    drite::StartupTrace::record("handoff", handoffStart, drite::StartupTrace::now());
+
+    // Record zones from the start so initialization shows up in the trace
+    if (!options->profilePath.empty()) {
+        drite::Profiler::setEnabled(true);
+        drite::Profiler::setThreadName("main");
+    }
+
+    // Select the platform backend
+    drite::HeadlessConfig headless;
+    headless.frameLimit = options->frameLimit;
+    headless.timeStep = options->timeStep;
+    headless.duration = options->duration;
+    headless.dumpFramePath = options->dumpFramePath;
+    headless.inputFloodRate = options->inputFloodRate;
+    drite::PlatformFactory::select(options->headless ? drite::PlatformType::Headless : drite::PlatformType::Native, headless);
+
     // Create the application instance
+    const double constructStart = drite::StartupTrace::now();
     drite::Application app;
+    drite::StartupTrace::record("construct", constructStart, drite::StartupTrace::now());
+
+    // The files load on worker threads while the window is created
+    app.setPageCacheLimit(options->pageCacheMiB * 1024 * 1024);
+    app.preloadFiles(options->files);
 
     // Set up the window configuration
     drite::WindowConfig config;
@@ -16,9 +74,58 @@ int main() {
 
     std::println("Initialized {} successfully.", config.title);
 
+    // Later invocations hand their files to this editor; if another one
+    // started listening in the meantime, this one simply runs on its own
+    if (drite::usesSingleInstance(*options)) {
+        drite::StartupPhase phase("listen");
+        static_cast<void>(app.listenForInstances(drite::getHandoffSocketPath(*options)));
+    }
+
+    // The session comes back first, so the files given on the command line open on top of it
+    if (!options->sessionPath.empty()) {
+        static_cast<void>(app.restoreSession(options->sessionPath));
+    }
+
+    // Open the files given on the command line; failures are reported and skipped
+    {
+        drite::StartupPhase phase("open files");
+        for (const std::string& path : options->files) {
+            app.openFile(path);
+        }
+        if (options->gotoLine > 0) {
+            app.goToLine(options->gotoLine, options->gotoColumn);
+        }
+    }
+
+    // Search the active document as if the query had been typed into the find bar
+    if (!options->findPattern.empty()) {
+        drite::SearchQuery query;
+        query.pattern = options->findPattern;
+        query.regex = options->findRegex;
+        app.find(query);
+    }
+
+    // Save the active document as if Cmd/Ctrl+S had been pressed
+    if (!options->saveAsPath.empty()) {
+        app.save(options->saveAsPath);
+    }
+
     // Run the main loop
     app.run();
 
     // Shutdown the application
     app.shutdown();
+
+    if (options->traceStartup) {
+        drite::StartupTrace::printReport();
+    }
+
+    // Export the profile once every thread that recorded zones has stopped
+    if (!options->profilePath.empty()) {
+        drite::Profiler::setEnabled(false);
+        drite::Profiler::printSummary();
+        if (drite::Profiler::writeChromeTrace(options->profilePath)) {
+            std::println("Profile: wrote Chrome trace to {}", options->profilePath);
+        }
+    }
 }
@@ -0,0 +1,282 @@
+#include "platform/headless/headless_platform.h"
+#include "window/headless/headless_window.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <print>
+#include <thread>
+
+namespace drite {
+
+    /**
+     * @brief Construct a new HeadlessPlatform object.
+     * @param config The headless configuration.
+     */
+    HeadlessPlatform::HeadlessPlatform(const HeadlessConfig& config)
+        : m_config(config) {}
+
+    /**
+     * @brief Destroy the HeadlessPlatform object.
+     */
+    HeadlessPlatform::~HeadlessPlatform() {
+        if (m_initialized) {
+            shutdown();
+        }
+    }
+
+    /**
+     * @brief Initialize the HeadlessPlatform.
+     * @return True if initialization was successful, false otherwise.
+     */
+    bool HeadlessPlatform::initialize() {
+        if (m_initialized) {
+            return true;
+        }
+
+        m_startTime = std::chrono::steady_clock::now();
+        m_virtualTime = 0.0;
+        m_pollCount = 0;
+        m_nextFloodTime = 0.0;
+        m_floodCount = 0;
+
+        m_initialized = true;
+        return true;
+    }
+
+    /**
+     * @brief Shutdown the HeadlessPlatform and report frame statistics.
+     */
+    void HeadlessPlatform::shutdown() {
+        if (!m_initialized) {
+            return;
+        }
+
+        const std::chrono::duration<double, std::milli> wallTime = std::chrono::steady_clock::now() - m_startTime;
+        if (m_pollCount > 0) {
+            std::println("Headless: {} frames in {:.2f} ms wall time ({:.3f} ms/frame)",
+                m_pollCount, wallTime.count(), wallTime.count() / static_cast<double>(m_pollCount));
+        }
+        if (m_floodCount > 0) {
+            std::println("Headless: injected {} synthetic input events", m_floodCount);
+        }
+
+        m_initialized = false;
+    }
+
+    /**
+     * @brief Create a new offscreen window with the specified configuration.
+     * @param config The configuration for the window.
+     * @return A unique pointer to the created window.
+     */
+    std::unique_ptr<Window> HeadlessPlatform::createWindow(const WindowConfig& config) {
+        if (!m_initialized) {
+            return nullptr;
+        }
+
+        auto window = std::make_unique<HeadlessWindow>(*this);
+        if (!window->initialize(config)) {
+            return nullptr;
+        }
+
+        return window;
+    }
+
+    /**
+     * @brief Dispatch injected events that are due, advancing the virtual clock by one step.
+     */
+    void HeadlessPlatform::pollEvents() {
+        ++m_pollCount;
+        if (usesVirtualClock()) {
+            m_virtualTime += m_config.timeStep;
+        }
+
+        dispatchEvents();
+    }
+
+    /**
+     * @brief Wait until the next injected event is due, then dispatch it.
+     *
+     * Returns immediately when no events are queued, so a headless run can never
+     * block forever.
+     */
+    void HeadlessPlatform::waitEvents() {
+        waitEventsTimeout(std::numeric_limits<double>::infinity());
+    }
+
+    /**
+     * @brief Wait until the next injected event is due or the timeout expires, then dispatch due events.
+     *
+     * The virtual clock jumps straight to the end of the wait. The wall clock
+     * blocks on a condition variable, so an idle run costs no CPU and
+     * postEmptyEvent() can end the wait early. Without a timeout and with no
+     * events queued it returns immediately, so a headless run can never block
+     * forever.
+     *
+     * @param timeout Maximum time to wait in seconds.
+     */
+    void HeadlessPlatform::waitEventsTimeout(double timeout) {
+        const double now = getTime();
+        double deadline = now + std::max(timeout, 0.0);
+        for (const HeadlessWindow* window : m_windows) {
+            if (window->hasPendingEvents()) {
+                deadline = std::min(deadline, window->getNextEventTime());
+            }
+        }
+        if (m_config.inputFloodRate > 0.0 && !m_windows.empty()) {
+            deadline = std::min(deadline, m_nextFloodTime);
+        }
+
+        if (deadline > now && deadline != std::numeric_limits<double>::infinity()) {
+            if (usesVirtualClock()) {
+                m_virtualTime = deadline;
+            } else {
+                std::unique_lock lock(m_wakeMutex);
+                m_wakeCondition.wait_for(lock, std::chrono::duration<double>(deadline - now), [this] { return m_wakeRequested; });
+            }
+        }
+
+        {
+            std::lock_guard lock(m_wakeMutex);
+            m_wakeRequested = false;
+        }
+
+        ++m_pollCount;
+        dispatchEvents();
+    }
+
+    /**
+     * @brief Wake the main thread if it is blocked waiting for events.
+     */
+    void HeadlessPlatform::postEmptyEvent() {
+        {
+            std::lock_guard lock(m_wakeMutex);
+            m_wakeRequested = true;
+        }
+        m_wakeCondition.notify_one();
+    }
+
+    /**
+     * @brief Get the current time in seconds since the platform was initialized.
+     * @return The current time in seconds.
+     */
+    double HeadlessPlatform::getTime() const {
+        if (usesVirtualClock()) {
+            return m_virtualTime;
+        }
+
+        auto now = std::chrono::steady_clock::now();
+        auto duration = std::chrono::duration_cast<std::chrono::microseconds>(now - m_startTime);
+        return duration.count() / 1000000.0;
+    }
+
+    /**
+     * @brief Sleep for the specified number of milliseconds.
+     *
+     * On the virtual clock this only advances time.
+     *
+     * @param milliseconds The number of milliseconds to sleep.
+     */
+    void HeadlessPlatform::sleep(int milliseconds) {
+        if (usesVirtualClock()) {
+            advanceTime(milliseconds / 1000.0);
+            return;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(milliseconds));
+    }
+
+    /**
+     * @brief Get the name of the platform.
+     * @return The name of the platform.
+     */
+    const char* HeadlessPlatform::getPlatformName() const {
+        return "Headless";
+    }
+
+    /**
+     * @brief Advance the virtual clock.
+     * @param seconds The number of seconds to advance by.
+     */
+    void HeadlessPlatform::advanceTime(double seconds) {
+        m_virtualTime += seconds;
+    }
+
+    /**
+     * @brief Register a window so it receives dispatched events.
+     * @param window The window to register.
+     */
+    void HeadlessPlatform::registerWindow(HeadlessWindow* window) {
+        m_windows.push_back(window);
+
+        if (m_config.duration > 0.0) {
+            window->injectClose(m_config.duration);
+        }
+    }
+
+    /**
+     * @brief Unregister a window that is being destroyed, dumping its last frame if configured.
+     * @param window The window to unregister.
+     */
+    void HeadlessPlatform::unregisterWindow(HeadlessWindow* window) {
+        if (!m_config.dumpFramePath.empty() && window->dumpFramebuffer(m_config.dumpFramePath)) {
+            std::println("Headless: wrote last frame to {}", m_config.dumpFramePath);
+        }
+        std::erase(m_windows, window);
+    }
+
+    /**
+     * @brief Dispatch due events on every window and enforce the frame limit.
+     */
+    void HeadlessPlatform::dispatchEvents() {
+        // Callbacks may create or destroy windows, so iterate over a copy
+        const double now = getTime();
+        injectFlood(now);
+
+        const std::vector<HeadlessWindow*> windows = m_windows;
+        for (HeadlessWindow* window : windows) {
+            window->dispatchEvents(now);
+        }
+
+        if (m_config.frameLimit > 0 && m_pollCount >= m_config.frameLimit) {
+            for (HeadlessWindow* window : m_windows) {
+                window->injectClose(now);
+                window->dispatchEvents(now);
+            }
+        }
+    }
+
+    /**
+     * @brief Inject the synthetic flood events due up to the given time.
+     *
+     * Every window gets a stream of pointer moves tracing a circle with a small
+     * scroll after every ninth move, the pattern of a high-rate mouse or a
+     * trackpad fling. Events are injected lazily up to the current time, so a
+     * slow frame sees the whole backlog at once like it would on a real device.
+     *
+     * @param now The current platform time in seconds.
+     */
+    void HeadlessPlatform::injectFlood(double now) {
+        if (m_config.inputFloodRate <= 0.0) {
+            return;
+        }
+
+        const double interval = 1.0 / m_config.inputFloodRate;
+        for (; m_nextFloodTime <= now; m_nextFloodTime += interval, ++m_floodCount) {
+            const double angle = static_cast<double>(m_floodCount) * 0.01;
+            for (HeadlessWindow* window : m_windows) {
+                int width{0}, height{0};
+                window->getSize(width, height);
+                const double x = width * (0.5 + 0.4 * std::cos(angle));
+                const double y = height * (0.5 + 0.4 * std::sin(angle));
+
+                if (m_floodCount % 10 == 9) {
+                    // Scroll down for a while, then back up
+                    const double direction = (m_floodCount / 1000) % 2 == 0 ? -1.0 : 1.0;
+                    window->injectScrollEvent(ScrollEvent{0.0, direction, x, y}, m_nextFloodTime);
+                } else {
+                    window->injectMouseEvent(MouseEvent{MouseAction::Move, MouseButton::Left, x, y, KeyModifiers()}, m_nextFloodTime);
+                }
+            }
+        }
+    }
+
+}
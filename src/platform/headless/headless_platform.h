@@ -0,0 +1,221 @@
+#pragma once
+
+#include "platform/platform.h"
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace drite {
+
+    class HeadlessWindow;
+
+    /**
+     * @brief Configuration of the headless platform.
+     */
+    struct HeadlessConfig {
+        /**
+         * @brief Number of event polls (frames) after which all windows are asked to close; 0 for no limit.
+         */
+        uint64_t frameLimit{0};
+
+        /**
+         * @brief Virtual clock step per event poll in seconds; 0 uses the wall clock.
+         */
+        double timeStep{0.0};
+
+        /**
+         * @brief Platform time in seconds after which all windows are asked to close; 0 for no limit.
+         */
+        double duration{0.0};
+
+        /**
+         * @brief File the last frame of each window is dumped to when it is destroyed; empty to disable.
+         */
+        std::string dumpFramePath;
+
+        /**
+         * @brief Rate of synthetic mouse moves and scrolls injected into every window, in events per second; 0 to disable.
+         */
+        double inputFloodRate{0.0};
+    };
+
+    /**
+     * @brief Platform implementation without a display, for benchmarking and CI.
+     *
+     * Windows render into offscreen framebuffers, input is injected through
+     * HeadlessWindow, and time comes either from the wall clock or from a virtual
+     * clock advanced by a fixed step per frame or explicitly via advanceTime().
+     */
+    class HeadlessPlatform : public Platform {
+        public:
+            /**
+             * @brief Construct a new HeadlessPlatform object.
+             * @param config The headless configuration.
+             */
+            explicit HeadlessPlatform(const HeadlessConfig& config = HeadlessConfig());
+
+            /**
+             * @brief Destroy the HeadlessPlatform object.
+             */
+            ~HeadlessPlatform() override;
+
+            /**
+             * @brief Initialize the HeadlessPlatform.
+             * @return True if initialization was successful, false otherwise.
+             */
+            [[nodiscard]] bool initialize() override;
+
+            /**
+             * @brief Shutdown the HeadlessPlatform and report frame statistics.
+             */
+            void shutdown() override;
+
+            /**
+             * @brief Create a new offscreen window with the specified configuration.
+             * @param config The configuration for the window.
+             * @return A unique pointer to the created window.
+             */
+            [[nodiscard]] std::unique_ptr<Window> createWindow(const WindowConfig& config) override;
+
+            /**
+             * @brief Dispatch injected events that are due, advancing the virtual clock by one step.
+             */
+            void pollEvents() override;
+
+            /**
+             * @brief Wait until the next injected event is due, then dispatch it.
+             */
+            void waitEvents() override;
+
+            /**
+             * @brief Wait until the next injected event is due or the timeout expires, then dispatch due events.
+             * @param timeout Maximum time to wait in seconds.
+             */
+            void waitEventsTimeout(double timeout) override;
+
+            /**
+             * @brief Wake the main thread if it is blocked waiting for events.
+             */
+            void postEmptyEvent() override;
+
+            /**
+             * @brief Get the current time in seconds since the platform was initialized.
+             * @return The current time in seconds.
+             */
+            [[nodiscard]] double getTime() const override;
+
+            /**
+             * @brief Sleep for the specified number of milliseconds.
+             * @param milliseconds The number of milliseconds to sleep.
+             */
+            void sleep(int milliseconds) override;
+
+            /**
+             * @brief Get the name of the platform.
+             * @return The name of the platform.
+             */
+            [[nodiscard]] const char* getPlatformName() const override;
+
+            /**
+             * @brief Advance the virtual clock.
+             * @param seconds The number of seconds to advance by.
+             */
+            void advanceTime(double seconds);
+
+            /**
+             * @brief Get the number of event polls since initialization.
+             * @return The poll count.
+             */
+            [[nodiscard]] uint64_t getPollCount() const noexcept { return m_pollCount; }
+
+            /**
+             * @brief Register a window so it receives dispatched events.
+             * @param window The window to register.
+             */
+            void registerWindow(HeadlessWindow* window);
+
+            /**
+             * @brief Unregister a window that is being destroyed, dumping its last frame if configured.
+             * @param window The window to unregister.
+             */
+            void unregisterWindow(HeadlessWindow* window);
+
+        private:
+            /**
+             * @brief Check whether the platform runs on the virtual clock.
+             * @return True if time is virtual.
+             */
+            [[nodiscard]] bool usesVirtualClock() const noexcept { return m_config.timeStep > 0.0; }
+
+            /**
+             * @brief Dispatch due events on every window and enforce the frame limit.
+             */
+            void dispatchEvents();
+
+            /**
+             * @brief Inject the synthetic flood events due up to the given time.
+             * @param now The current platform time in seconds.
+             */
+            void injectFlood(double now);
+
+        private:
+            /**
+             * @brief The headless configuration.
+             */
+            HeadlessConfig m_config;
+
+            /**
+             * @brief The windows receiving events.
+             */
+            std::vector<HeadlessWindow*> m_windows;
+
+            /**
+             * @brief The time point when the platform was initialized.
+             */
+            std::chrono::steady_clock::time_point m_startTime;
+
+            /**
+             * @brief The current virtual time in seconds.
+             */
+            double m_virtualTime{0.0};
+
+            /**
+             * @brief The number of event polls since initialization.
+             */
+            uint64_t m_pollCount{0};
+
+            /**
+             * @brief Platform time of the next synthetic flood event.
+             */
+            double m_nextFloodTime{0.0};
+
+            /**
+             * @brief The number of synthetic flood events injected.
+             */
+            uint64_t m_floodCount{0};
+
+            /**
+             * @brief Guards m_wakeRequested.
+             */
+            std::mutex m_wakeMutex;
+
+            /**
+             * @brief Signalled by postEmptyEvent() to end a wall-clock wait early.
+             */
+            std::condition_variable m_wakeCondition;
+
+            /**
+             * @brief Whether postEmptyEvent() was called since the last wait.
+             */
+            bool m_wakeRequested{false};
+
+            /**
+             * @brief Whether the platform has been initialized.
+             */
+            bool m_initialized{false};
+        };
+
+}
@@ -59,6 +59,17 @@ namespace drite {
              */
             void waitEvents() override;
 
+            /**
+             * @brief Wait for events, blocking until events arrive or the timeout expires.
+             * @param timeout Maximum time to wait in seconds.
+             */
+            void waitEventsTimeout(double timeout) override;
+
+            /**
+             * @brief Wake the main thread if it is blocked waiting for events.
+             */
+            void postEmptyEvent() override;
+
             /**
              * @brief Get the current time in seconds since the platform was initialized.
              * @return The current time in seconds.
@@ -1,6 +1,7 @@
 #import "platform/macos/macos_platform.h"
 #import "window/macos/macos_window.h"
 #import <Cocoa/Cocoa.h>
+#import <cmath>
 #import <thread>
 
 /* 
@@ -172,6 +173,48 @@ namespace drite {
         }
     }
 
+    /**
+     * @brief Wait for events, blocking until events arrive or the timeout expires.
+     * @param timeout Maximum time to wait in seconds.
+     */
+    void MacOSPlatform::waitEventsTimeout(double timeout) {
+        if (!std::isfinite(timeout)) {
+            waitEvents();
+            return;
+        }
+
+        @autoreleasepool {
+            NSEvent* event = [NSApp nextEventMatchingMask:NSEventMaskAny
+                                                untilDate:[NSDate dateWithTimeIntervalSinceNow:timeout]
+                                                inMode:NSDefaultRunLoopMode
+                                                dequeue:YES];
+            if (event) {
+                [NSApp sendEvent:event];
+            }
+
+            // Process any other pending events
+            pollEvents();
+        }
+    }
+
+    /**
+     * @brief Wake the main thread if it is blocked waiting for events.
+     */
+    void MacOSPlatform::postEmptyEvent() {
+        @autoreleasepool {
+            NSEvent* event = [NSEvent otherEventWithType:NSEventTypeApplicationDefined
+                                                location:NSMakePoint(0, 0)
+                                           modifierFlags:0
+                                               timestamp:0
+                                            windowNumber:0
+                                                 context:nil
+                                                 subtype:0
+                                                   data1:0
+                                                   data2:0];
+            [NSApp postEvent:event atStart:YES];
+        }
+    }
+
     /**
      * @brief Get the current time in seconds since the platform was initialized.
      * @return The current time in seconds.
@@ -44,6 +44,19 @@ namespace drite {
          */
         virtual void waitEvents() = 0;
 
+        /**
+         * @brief Wait for events, blocking until events arrive or the timeout expires.
+         * @param timeout Maximum time to wait in seconds.
+         */
+        virtual void waitEventsTimeout(double timeout) = 0;
+
+        /**
+         * @brief Wake the main thread if it is blocked waiting for events.
+         * 
+         * Safe to call from any thread, e.g. when background work completes.
+         */
+        virtual void postEmptyEvent() = 0;
+
         /**
          * @brief Get time in seconds since platform initialization.
          * @return Time in seconds.
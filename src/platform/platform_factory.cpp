@@ -14,14 +14,43 @@ namespace drite {
      */
     std::unique_ptr<Platform> PlatformFactory::instance = nullptr;
 
+    /**
+     * @brief The selected platform type.
+     */
+    PlatformType PlatformFactory::selectedType = PlatformType::Native;
+
+    /**
+     * @brief Configuration for the headless platform.
+     */
+    HeadlessConfig PlatformFactory::headlessConfig;
+
 
     /**
-     * @brief Create platform instance for current OS.
+     * @brief Select the kind of platform created by subsequent calls.
+     * @param type The platform type.
+     * @param config The configuration used when the headless platform is created.
+     */
+    void PlatformFactory::select(PlatformType type, const HeadlessConfig& config) {
+        selectedType = type;
+        headlessConfig = config;
+    }
+
+    /**
+     * @brief Create platform instance of the selected type.
+     *
+     * Platforms without a native backend yet (Linux) run headless.
+     *
      * @return A unique pointer to the created platform instance.
      */
     std::unique_ptr<Platform> PlatformFactory::create() {
+        if (selectedType == PlatformType::Headless) {
+            return std::make_unique<HeadlessPlatform>(headlessConfig);
+        }
+
     #ifdef __APPLE__
         return std::make_unique<MacOSPlatform>();
+    #elif defined(__linux__)
+        return std::make_unique<HeadlessPlatform>(headlessConfig);
     #else
         #error "Unsupported platform"
     #endif
@@ -1,17 +1,33 @@
 #pragma once
 
 #include "platform/platform.h"
+#include "platform/headless/headless_platform.h"
 #include <memory>
 
 namespace drite {
 
+    /**
+     * @brief Kinds of platform the factory can create.
+     */
+    enum class PlatformType {
+        Native,
+        Headless
+    };
+
     /**
      * @brief Factory for creating platform-specific implementations.
      */
     class PlatformFactory {
         public:
             /**
-             * @brief Create platform instance for current OS.
+             * @brief Select the kind of platform created by subsequent calls.
+             * @param type The platform type.
+             * @param config The configuration used when the headless platform is created.
+             */
+            static void select(PlatformType type, const HeadlessConfig& config = HeadlessConfig());
+
+            /**
+             * @brief Create platform instance of the selected type.
              * @return A unique pointer to the created platform instance.
              */
             [[nodiscard]] static std::unique_ptr<Platform> create();
@@ -28,6 +44,16 @@ namespace drite {
              * @brief Singleton instance of the platform.
              */
             static std::unique_ptr<Platform> instance;
+
+            /**
+             * @brief The selected platform type.
+             */
+            static PlatformType selectedType;
+
+            /**
+             * @brief Configuration for the headless platform.
+             */
+            static HeadlessConfig headlessConfig;
     };
 
 }
@@ -0,0 +1,223 @@
+#include "render/builtin_font.h"
+#include <algorithm>
+#include <cmath>
+
+namespace drite {
+
+    /**
+     * @brief Width of a glyph in the embedded master bitmaps.
+     */
+    static constexpr int MasterWidth = 8;
+
+    /**
+     * @brief Height of a glyph in the embedded master bitmaps.
+     */
+    static constexpr int MasterHeight = 16;
+
+    /**
+     * @brief First codepoint in the embedded font.
+     */
+    static constexpr uint32_t FirstCodepoint = 0x20;
+
+    /**
+     * @brief Last codepoint in the embedded font.
+     */
+    static constexpr uint32_t LastCodepoint = 0x7E;
+
+    /**
+     * @brief Samples per axis taken for each output pixel.
+     */
+    static constexpr int Supersampling = 4;
+
+    /**
+     * @brief Printable ASCII as 8x16 one-bit bitmaps, most significant bit leftmost.
+     *
+     * Rendered from DejaVu Sans Mono at 14 px with the baseline at row 12.
+     */
+    static constexpr uint8_t MasterGlyphs[LastCodepoint - FirstCodepoint + 1][MasterHeight] = {
+        {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, // ' '
+        {0x00, 0x00, 0x08, 0x08, 0x08, 0x08, 0x08, 0x08, 0x00, 0x00, 0x08, 0x08, 0x00, 0x00, 0x00, 0x00}, // '!'
+        {0x00, 0x00, 0x14, 0x14, 0x14, 0x14, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, // '"'
+        {0x00, 0x00, 0x12, 0x12, 0x16, 0x7F, 0x24, 0x24, 0xFE, 0x28, 0x48, 0x48, 0x00, 0x00, 0x00, 0x00}, // '#'
+        {0x00, 0x08, 0x08, 0x3E, 0x49, 0x48, 0x68, 0x3E, 0x0B, 0x09, 0x49, 0x3E, 0x08, 0x08, 0x00, 0x00}, // '$'
+        {0x00, 0x00, 0x60, 0x90, 0x90, 0x62, 0x0C, 0x30, 0x46, 0x09, 0x09, 0x06, 0x00, 0x00, 0x00, 0x00}, // '%'
+        {0x00, 0x00, 0x1C, 0x20, 0x20, 0x30, 0x30, 0x49, 0x45, 0x45, 0x62, 0x3D, 0x00, 0x00, 0x00, 0x00}, // '&'
+        {0x00, 0x00, 0x08, 0x08, 0x08, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, // '\''
+        {0x00, 0x0C, 0x08, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x08, 0x08, 0x04, 0x00, 0x00, 0x00}, // '('
+        {0x00, 0x30, 0x10, 0x10, 0x08, 0x08, 0x08, 0x08, 0x08, 0x08, 0x10, 0x10, 0x30, 0x00, 0x00, 0x00}, // ')'
+        {0x00, 0x00, 0x08, 0x49, 0x3E, 0x1C, 0x6B, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, // '*'
+        {0x00, 0x00, 0x00, 0x00, 0x08, 0x08, 0x08, 0x7F, 0x08, 0x08, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00}, // '+'
+        {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x18, 0x18, 0x10, 0x20, 0x00, 0x00}, // ','
+        {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x3C, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, // '-'
+        {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x18, 0x18, 0x00, 0x00, 0x00, 0x00}, // '.'
+        {0x00, 0x00, 0x02, 0x04, 0x04, 0x04, 0x08, 0x08, 0x10, 0x10, 0x20, 0x20, 0x20, 0x40, 0x00, 0x00}, // '/'
+        {0x00, 0x00, 0x1C, 0x22, 0x41, 0x41, 0x49, 0x41, 0x41, 0x41, 0x22, 0x1C, 0x00, 0x00, 0x00, 0x00}, // '0'
+        {0x00, 0x00, 0x18, 0x28, 0x08, 0x08, 0x08, 0x08, 0x08, 0x08, 0x08, 0x3E, 0x00, 0x00, 0x00, 0x00}, // '1'
+        {0x00, 0x00, 0x3E, 0x43, 0x01, 0x01, 0x02, 0x06, 0x0C, 0x10, 0x20, 0x7F, 0x00, 0x00, 0x00, 0x00}, // '2'
+        {0x00, 0x00, 0x3E, 0x41, 0x01, 0x03, 0x1C, 0x03, 0x01, 0x01, 0x43, 0x3E, 0x00, 0x00, 0x00, 0x00}, // '3'
+        {0x00, 0x00, 0x06, 0x0A, 0x1A, 0x12, 0x22, 0x42, 0x7F, 0x02, 0x02, 0x02, 0x00, 0x00, 0x00, 0x00}, // '4'
+        {0x00, 0x00, 0x7E, 0x40, 0x40, 0x7C, 0x42, 0x01, 0x01, 0x01, 0x42, 0x3C, 0x00, 0x00, 0x00, 0x00}, // '5'
+        {0x00, 0x00, 0x1E, 0x31, 0x60, 0x40, 0x5E, 0x63, 0x41, 0x41, 0x23, 0x1E, 0x00, 0x00, 0x00, 0x00}, // '6'
+        {0x00, 0x00, 0x7F, 0x03, 0x02, 0x04, 0x04, 0x08, 0x08, 0x10, 0x10, 0x20, 0x00, 0x00, 0x00, 0x00}, // '7'
+        {0x00, 0x00, 0x3E, 0x41, 0x41, 0x41, 0x3E, 0x63, 0x41, 0x41, 0x63, 0x3E, 0x00, 0x00, 0x00, 0x00}, // '8'
+        {0x00, 0x00, 0x3C, 0x62, 0x41, 0x41, 0x63, 0x3D, 0x01, 0x03, 0x46, 0x3C, 0x00, 0x00, 0x00, 0x00}, // '9'
+        {0x00, 0x00, 0x00, 0x00, 0x00, 0x18, 0x18, 0x00, 0x00, 0x00, 0x18, 0x18, 0x00, 0x00, 0x00, 0x00}, // ':'
+        {0x00, 0x00, 0x00, 0x00, 0x00, 0x18, 0x18, 0x00, 0x00, 0x00, 0x18, 0x18, 0x10, 0x20, 0x00, 0x00}, // ';'
+        {0x00, 0x00, 0x00, 0x00, 0x01, 0x0E, 0x38, 0x40, 0x38, 0x0E, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00}, // '<'
+        {0x00, 0x00, 0x00, 0x00, 0x00, 0x7F, 0x00, 0x00, 0x7F, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, // '='
+        {0x00, 0x00, 0x00, 0x00, 0x40, 0x38, 0x0E, 0x01, 0x0E, 0x38, 0x40, 0x00, 0x00, 0x00, 0x00, 0x00}, // '>'
+        {0x00, 0x00, 0x38, 0x44, 0x04, 0x0C, 0x18, 0x10, 0x10, 0x00, 0x10, 0x10, 0x00, 0x00, 0x00, 0x00}, // '?'
+        {0x00, 0x00, 0x1E, 0x33, 0x21, 0x47, 0x49, 0x49, 0x49, 0x49, 0x47, 0x20, 0x30, 0x0E, 0x00, 0x00}, // '@'
+        {0x00, 0x00, 0x08, 0x14, 0x14, 0x14, 0x14, 0x22, 0x3E, 0x22, 0x41, 0x41, 0x00, 0x00, 0x00, 0x00}, // 'A'
+        {0x00, 0x00, 0x7E, 0x41, 0x41, 0x41, 0x7E, 0x43, 0x41, 0x41, 0x43, 0x7E, 0x00, 0x00, 0x00, 0x00}, // 'B'
+        {0x00, 0x00, 0x1E, 0x21, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x21, 0x1E, 0x00, 0x00, 0x00, 0x00}, // 'C'
+        {0x00, 0x00, 0x7C, 0x42, 0x41, 0x41, 0x41, 0x41, 0x41, 0x41, 0x42, 0x7C, 0x00, 0x00, 0x00, 0x00}, // 'D'
+        {0x00, 0x00, 0x7F, 0x40, 0x40, 0x40, 0x7F, 0x40, 0x40, 0x40, 0x40, 0x7F, 0x00, 0x00, 0x00, 0x00}, // 'E'
+        {0x00, 0x00, 0x7F, 0x40, 0x40, 0x40, 0x7F, 0x40, 0x40, 0x40, 0x40, 0x40, 0x00, 0x00, 0x00, 0x00}, // 'F'
+        {0x00, 0x00, 0x1E, 0x21, 0x40, 0x40, 0x40, 0x43, 0x41, 0x41, 0x21, 0x1E, 0x00, 0x00, 0x00, 0x00}, // 'G'
+        {0x00, 0x00, 0x41, 0x41, 0x41, 0x41, 0x7F, 0x41, 0x41, 0x41, 0x41, 0x41, 0x00, 0x00, 0x00, 0x00}, // 'H'
+        {0x00, 0x00, 0x3E, 0x08, 0x08, 0x08, 0x08, 0x08, 0x08, 0x08, 0x08, 0x3E, 0x00, 0x00, 0x00, 0x00}, // 'I'
+        {0x00, 0x00, 0x1E, 0x02, 0x02, 0x02, 0x02, 0x02, 0x02, 0x02, 0x46, 0x3C, 0x00, 0x00, 0x00, 0x00}, // 'J'
+        {0x00, 0x00, 0x42, 0x44, 0x48, 0x50, 0x70, 0x48, 0x4C, 0x44, 0x42, 0x41, 0x00, 0x00, 0x00, 0x00}, // 'K'
+        {0x00, 0x00, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x7F, 0x00, 0x00, 0x00, 0x00}, // 'L'
+        {0x00, 0x00, 0x63, 0x63, 0x55, 0x55, 0x55, 0x49, 0x41, 0x41, 0x41, 0x41, 0x00, 0x00, 0x00, 0x00}, // 'M'
+        {0x00, 0x00, 0x61, 0x61, 0x51, 0x51, 0x49, 0x49, 0x45, 0x45, 0x43, 0x43, 0x00, 0x00, 0x00, 0x00}, // 'N'
+        {0x00, 0x00, 0x1C, 0x22, 0x41, 0x41, 0x41, 0x41, 0x41, 0x41, 0x22, 0x1C, 0x00, 0x00, 0x00, 0x00}, // 'O'
+        {0x00, 0x00, 0x7E, 0x43, 0x41, 0x41, 0x43, 0x7E, 0x40, 0x40, 0x40, 0x40, 0x00, 0x00, 0x00, 0x00}, // 'P'
+        {0x00, 0x00, 0x1C, 0x22, 0x41, 0x41, 0x41, 0x41, 0x41, 0x41, 0x22, 0x1E, 0x06, 0x02, 0x00, 0x00}, // 'Q'
+        {0x00, 0x00, 0x7E, 0x43, 0x41, 0x41, 0x43, 0x7C, 0x42, 0x41, 0x41, 0x40, 0x00, 0x00, 0x00, 0x00}, // 'R'
+        {0x00, 0x00, 0x1E, 0x61, 0x40, 0x40, 0x30, 0x0E, 0x01, 0x01, 0x43, 0x3E, 0x00, 0x00, 0x00, 0x00}, // 'S'
+        {0x00, 0x00, 0x7F, 0x08, 0x08, 0x08, 0x08, 0x08, 0x08, 0x08, 0x08, 0x08, 0x00, 0x00, 0x00, 0x00}, // 'T'
+        {0x00, 0x00, 0x41, 0x41, 0x41, 0x41, 0x41, 0x41, 0x41, 0x41, 0x63, 0x3E, 0x00, 0x00, 0x00, 0x00}, // 'U'
+        {0x00, 0x00, 0x41, 0x41, 0x22, 0x22, 0x22, 0x14, 0x14, 0x14, 0x14, 0x08, 0x00, 0x00, 0x00, 0x00}, // 'V'
+        {0x00, 0x00, 0x81, 0x81, 0x81, 0x99, 0x5A, 0x5A, 0x5A, 0x24, 0x24, 0x24, 0x00, 0x00, 0x00, 0x00}, // 'W'
+        {0x00, 0x00, 0x41, 0x22, 0x14, 0x14, 0x08, 0x14, 0x14, 0x22, 0x22, 0x41, 0x00, 0x00, 0x00, 0x00}, // 'X'
+        {0x00, 0x00, 0x41, 0x22, 0x22, 0x14, 0x1C, 0x08, 0x08, 0x08, 0x08, 0x08, 0x00, 0x00, 0x00, 0x00}, // 'Y'
+        {0x00, 0x00, 0x7F, 0x03, 0x02, 0x04, 0x08, 0x08, 0x10, 0x20, 0x60, 0x7F, 0x00, 0x00, 0x00, 0x00}, // 'Z'
+        {0x00, 0x1C, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x1C, 0x00, 0x00, 0x00}, // '['
+        {0x00, 0x00, 0x40, 0x20, 0x20, 0x20, 0x10, 0x10, 0x08, 0x08, 0x04, 0x04, 0x04, 0x02, 0x00, 0x00}, // '\\'
+        {0x00, 0x38, 0x08, 0x08, 0x08, 0x08, 0x08, 0x08, 0x08, 0x08, 0x08, 0x08, 0x38, 0x00, 0x00, 0x00}, // ']'
+        {0x00, 0x00, 0x08, 0x14, 0x22, 0x63, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, // '^'
+        {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0x00}, // '_'
+        {0x30, 0x10, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, // '`'
+        {0x00, 0x00, 0x00, 0x00, 0x1C, 0x22, 0x02, 0x3E, 0x42, 0x42, 0x46, 0x3A, 0x00, 0x00, 0x00, 0x00}, // 'a'
+        {0x00, 0x40, 0x40, 0x40, 0x7C, 0x64, 0x42, 0x42, 0x42, 0x42, 0x64, 0x5C, 0x00, 0x00, 0x00, 0x00}, // 'b'
+        {0x00, 0x00, 0x00, 0x00, 0x1C, 0x22, 0x40, 0x40, 0x40, 0x40, 0x22, 0x1C, 0x00, 0x00, 0x00, 0x00}, // 'c'
+        {0x00, 0x02, 0x02, 0x02, 0x3E, 0x26, 0x42, 0x42, 0x42, 0x42, 0x26, 0x3A, 0x00, 0x00, 0x00, 0x00}, // 'd'
+        {0x00, 0x00, 0x00, 0x00, 0x3C, 0x26, 0x42, 0x7E, 0x40, 0x40, 0x22, 0x1C, 0x00, 0x00, 0x00, 0x00}, // 'e'
+        {0x00, 0x0E, 0x10, 0x10, 0x7E, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x00, 0x00, 0x00, 0x00}, // 'f'
+        {0x00, 0x00, 0x00, 0x00, 0x3A, 0x26, 0x42, 0x42, 0x42, 0x42, 0x26, 0x3A, 0x02, 0x22, 0x1C, 0x00}, // 'g'
+        {0x00, 0x40, 0x40, 0x40, 0x5C, 0x62, 0x42, 0x42, 0x42, 0x42, 0x42, 0x42, 0x00, 0x00, 0x00, 0x00}, // 'h'
+        {0x00, 0x08, 0x08, 0x00, 0x38, 0x08, 0x08, 0x08, 0x08, 0x08, 0x08, 0x7F, 0x00, 0x00, 0x00, 0x00}, // 'i'
+        {0x00, 0x08, 0x08, 0x00, 0x38, 0x08, 0x08, 0x08, 0x08, 0x08, 0x08, 0x08, 0x08, 0x08, 0x70, 0x00}, // 'j'
+        {0x00, 0x40, 0x40, 0x40, 0x44, 0x48, 0x50, 0x70, 0x48, 0x48, 0x44, 0x42, 0x00, 0x00, 0x00, 0x00}, // 'k'
+        {0x00, 0xF0, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x0E, 0x00, 0x00, 0x00, 0x00}, // 'l'
+        {0x00, 0x00, 0x00, 0x00, 0x7E, 0x49, 0x49, 0x49, 0x49, 0x49, 0x49, 0x49, 0x00, 0x00, 0x00, 0x00}, // 'm'
+        {0x00, 0x00, 0x00, 0x00, 0x5C, 0x62, 0x42, 0x42, 0x42, 0x42, 0x42, 0x42, 0x00, 0x00, 0x00, 0x00}, // 'n'
+        {0x00, 0x00, 0x00, 0x00, 0x3C, 0x66, 0x42, 0x42, 0x42, 0x42, 0x66, 0x3C, 0x00, 0x00, 0x00, 0x00}, // 'o'
+        {0x00, 0x00, 0x00, 0x00, 0x5C, 0x64, 0x42, 0x42, 0x42, 0x42, 0x64, 0x7C, 0x40, 0x40, 0x40, 0x00}, // 'p'
+        {0x00, 0x00, 0x00, 0x00, 0x3A, 0x26, 0x42, 0x42, 0x42, 0x42, 0x26, 0x3A, 0x02, 0x02, 0x02, 0x00}, // 'q'
+        {0x00, 0x00, 0x00, 0x00, 0x3C, 0x32, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x00, 0x00, 0x00, 0x00}, // 'r'
+        {0x00, 0x00, 0x00, 0x00, 0x3C, 0x42, 0x40, 0x70, 0x0E, 0x02, 0x42, 0x3C, 0x00, 0x00, 0x00, 0x00}, // 's'
+        {0x00, 0x00, 0x10, 0x10, 0x7E, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x0E, 0x00, 0x00, 0x00, 0x00}, // 't'
+        {0x00, 0x00, 0x00, 0x00, 0x42, 0x42, 0x42, 0x42, 0x42, 0x42, 0x46, 0x3A, 0x00, 0x00, 0x00, 0x00}, // 'u'
+        {0x00, 0x00, 0x00, 0x00, 0x42, 0x42, 0x24, 0x24, 0x24, 0x18, 0x18, 0x18, 0x00, 0x00, 0x00, 0x00}, // 'v'
+        {0x00, 0x00, 0x00, 0x00, 0x81, 0x81, 0x5A, 0x5A, 0x5A, 0x5A, 0x24, 0x24, 0x00, 0x00, 0x00, 0x00}, // 'w'
+        {0x00, 0x00, 0x00, 0x00, 0x42, 0x24, 0x18, 0x18, 0x18, 0x24, 0x24, 0x42, 0x00, 0x00, 0x00, 0x00}, // 'x'
+        {0x00, 0x00, 0x00, 0x00, 0x42, 0x22, 0x24, 0x24, 0x14, 0x18, 0x08, 0x08, 0x08, 0x10, 0x30, 0x00}, // 'y'
+        {0x00, 0x00, 0x00, 0x00, 0x7E, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x7E, 0x00, 0x00, 0x00, 0x00}, // 'z'
+        {0x00, 0x06, 0x08, 0x08, 0x08, 0x08, 0x08, 0x30, 0x08, 0x08, 0x08, 0x08, 0x08, 0x06, 0x00, 0x00}, // '{'
+        {0x00, 0x08, 0x08, 0x08, 0x08, 0x08, 0x08, 0x08, 0x08, 0x08, 0x08, 0x08, 0x08, 0x08, 0x08, 0x00}, // '|'
+        {0x00, 0x30, 0x08, 0x08, 0x08, 0x08, 0x08, 0x06, 0x08, 0x08, 0x08, 0x08, 0x08, 0x30, 0x00, 0x00}, // '}'
+        {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x39, 0x46, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, // '~'
+    };
+
+    /**
+     * @brief Check whether a master bitmap pixel is set.
+     * @param glyph The master glyph.
+     * @param x The column; out-of-range columns are blank.
+     * @param y The row; out-of-range rows are blank.
+     * @return True if the pixel is set.
+     */
+    static bool isMasterPixelSet(const uint8_t (&glyph)[MasterHeight], int x, int y) noexcept {
+        if (x < 0 || x >= MasterWidth || y < 0 || y >= MasterHeight) {
+            return false;
+        }
+        return (glyph[y] & (0x80 >> x)) != 0;
+    }
+
+    /**
+     * @brief Rasterize a glyph.
+     * @param key The glyph to rasterize, including its horizontal subpixel offset.
+     * @param bitmap Receives the glyph image; may be empty for blank glyphs.
+     * @return True if the glyph exists in the font, false otherwise.
+     */
+    bool BuiltinFontRasterizer::rasterize(const GlyphKey& key, GlyphBitmap& bitmap) {
+        // Unknown codepoints render as a replacement box
+        const bool known = key.codepoint >= FirstCodepoint && key.codepoint <= LastCodepoint;
+        static constexpr uint8_t Replacement[MasterHeight] = {
+            0x00, 0x00, 0x7E, 0x42, 0x42, 0x42, 0x42, 0x42, 0x42, 0x42, 0x42, 0x7E, 0x00, 0x00, 0x00, 0x00
+        };
+        const uint8_t (&glyph)[MasterHeight] = known ? MasterGlyphs[key.codepoint - FirstCodepoint] : Replacement;
+
+        const int cellWidth = std::max(1, static_cast<int>(std::lround(getAdvance(key.fontId, key.size))));
+        const int cellHeight = std::max(1, getLineHeight(key.fontId, key.size));
+        const float offset = static_cast<float>(key.subpixel % GlyphKey::SubpixelSteps) / GlyphKey::SubpixelSteps;
+        const float scaleX = static_cast<float>(MasterWidth) / static_cast<float>(cellWidth);
+        const float scaleY = static_cast<float>(MasterHeight) / static_cast<float>(cellHeight);
+
+        // A subpixel offset can push coverage into one extra column
+        bitmap.width = cellWidth + (key.subpixel != 0 ? 1 : 0);
+        bitmap.height = cellHeight;
+        bitmap.bearingX = 0;
+        bitmap.bearingY = 0;
+        bitmap.coverage.assign(static_cast<size_t>(bitmap.width) * static_cast<size_t>(bitmap.height), 0);
+
+        bool blank{true};
+        for (int y = 0; y < bitmap.height; ++y) {
+            for (int x = 0; x < bitmap.width; ++x) {
+                int samples{0};
+                for (int sy = 0; sy < Supersampling; ++sy) {
+                    const float my = (static_cast<float>(y) + (sy + 0.5f) / Supersampling) * scaleY;
+                    for (int sx = 0; sx < Supersampling; ++sx) {
+                        const float mx = (static_cast<float>(x) + (sx + 0.5f) / Supersampling - offset) * scaleX;
+                        samples += isMasterPixelSet(glyph, static_cast<int>(std::floor(mx)), static_cast<int>(my));
+                    }
+                }
+
+                const uint8_t value = static_cast<uint8_t>(samples * 255 / (Supersampling * Supersampling));
+                bitmap.coverage[static_cast<size_t>(y) * static_cast<size_t>(bitmap.width) + x] = value;
+                blank = blank && value == 0;
+            }
+        }
+
+        // Blank glyphs such as the space need no atlas space
+        if (blank) {
+            bitmap.width = 0;
+            bitmap.height = 0;
+            bitmap.coverage.clear();
+        }
+        return known;
+    }
+
+    /**
+     * @brief Get the horizontal advance of a monospaced cell.
+     * @param fontId The font; the embedded font ignores it.
+     * @param size The font size in pixels.
+     * @return The advance in pixels.
+     */
+    float BuiltinFontRasterizer::getAdvance(uint16_t /* fontId */, uint16_t size) const {
+        return std::round(static_cast<float>(size) * MasterWidth / MasterHeight);
+    }
+
+    /**
+     * @brief Get the distance between baselines.
+     * @param fontId The font; the embedded font ignores it.
+     * @param size The font size in pixels.
+     * @return The line height in pixels.
+     */
+    int BuiltinFontRasterizer::getLineHeight(uint16_t /* fontId */, uint16_t size) const {
+        return size;
+    }
+
+}
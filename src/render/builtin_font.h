@@ -0,0 +1,42 @@
+#pragma once
+
+#include "render/glyph_rasterizer.h"
+
+namespace drite {
+
+    /**
+     * @brief Glyph rasterizer for a small monospaced font compiled into the binary.
+     *
+     * Covers printable ASCII and draws a box for anything else. Glyphs are
+     * resampled from 8x16 one-bit masters with box filtering, so any size and
+     * subpixel offset works without a font engine. Used until platform font
+     * rasterizers exist, and on headless runs.
+     */
+    class BuiltinFontRasterizer : public GlyphRasterizer {
+        public:
+            /**
+             * @brief Rasterize a glyph.
+             * @param key The glyph to rasterize, including its horizontal subpixel offset.
+             * @param bitmap Receives the glyph image; may be empty for blank glyphs.
+             * @return True if the glyph exists in the font, false otherwise.
+             */
+            [[nodiscard]] bool rasterize(const GlyphKey& key, GlyphBitmap& bitmap) override;
+
+            /**
+             * @brief Get the horizontal advance of a monospaced cell.
+             * @param fontId The font; the embedded font ignores it.
+             * @param size The font size in pixels.
+             * @return The advance in pixels.
+             */
+            [[nodiscard]] float getAdvance(uint16_t fontId, uint16_t size) const override;
+
+            /**
+             * @brief Get the distance between baselines.
+             * @param fontId The font; the embedded font ignores it.
+             * @param size The font size in pixels.
+             * @return The line height in pixels.
+             */
+            [[nodiscard]] int getLineHeight(uint16_t fontId, uint16_t size) const override;
+    };
+
+}
@@ -0,0 +1,141 @@
+#include "render/damage_tracker.h"
+#include <algorithm>
+
+namespace drite {
+
+    /**
+     * @brief Check whether two rects overlap or touch.
+     * @param a The first rect.
+     * @param b The second rect.
+     * @return True if merging them would not cover pixels between them.
+     */
+    static bool touches(const Rect& a, const Rect& b) noexcept {
+        return a.x <= b.x + b.width && b.x <= a.x + a.width && a.y <= b.y + b.height && b.y <= a.y + a.height;
+    }
+
+    /**
+     * @brief Get the bounding box of two rects.
+     * @param a The first rect.
+     * @param b The second rect.
+     * @return The smallest rect containing both.
+     */
+    static Rect unite(const Rect& a, const Rect& b) noexcept {
+        const int left = std::min(a.x, b.x);
+        const int top = std::min(a.y, b.y);
+        const int right = std::max(a.x + a.width, b.x + b.width);
+        const int bottom = std::max(a.y + a.height, b.y + b.height);
+        return Rect{left, top, right - left, bottom - top};
+    }
+
+    /**
+     * @brief Mark a range of document lines as damaged, across the full view width.
+     * @param first The first damaged line.
+     * @param last The last damaged line, inclusive, or ToEnd.
+     */
+    void DamageTracker::markLines(size_t first, size_t last) {
+        if (m_full) {
+            return;
+        }
+        if (first > last) {
+            std::swap(first, last);
+        }
+
+        // Insert in order, absorbing every range that overlaps or touches the new one
+        LineRange range{first, last};
+        auto it = std::lower_bound(m_lines.begin(), m_lines.end(), range.first,
+                                   [](const LineRange& existing, size_t line) { return existing.last != ToEnd && existing.last + 1 < line; });
+        while (it != m_lines.end() && (range.last == ToEnd || it->first <= range.last + 1)) {
+            range.first = std::min(range.first, it->first);
+            range.last = std::max(range.last, it->last);
+            it = m_lines.erase(it);
+        }
+        m_lines.insert(it, range);
+    }
+
+    /**
+     * @brief Mark a framebuffer region as damaged.
+     * @param rect The region in pixels.
+     */
+    void DamageTracker::markRect(const Rect& rect) {
+        if (!m_full && !rect.isEmpty()) {
+            m_rects.push_back(rect);
+        }
+    }
+
+    /**
+     * @brief Convert the damage into disjoint framebuffer rects.
+     * @param rows The visual rows of the view, from the top down.
+     * @param lineHeight The row height in pixels.
+     * @param width The view width in pixels.
+     * @param height The view height in pixels.
+     * @return The damaged rects clipped to the view; valid until the next call.
+     */
+    const std::vector<Rect>& DamageTracker::resolve(std::span<const VisualRow> rows, int lineHeight, int width, int height) {
+        m_resolved.clear();
+        const Rect view{0, 0, width, height};
+        if (view.isEmpty()) {
+            return m_resolved;
+        }
+
+        if (m_full) {
+            m_resolved.push_back(view);
+            return m_resolved;
+        }
+
+        // Ranges past the last row, such as lines just deleted, reach the bottom of the view
+        const size_t lastLine = rows.empty() ? 0 : rows.back().line;
+        for (const LineRange& range : m_lines) {
+            const auto begin = std::partition_point(rows.begin(), rows.end(), [&](const VisualRow& row) { return row.line < range.first; });
+            const auto end = std::partition_point(begin, rows.end(), [&](const VisualRow& row) { return row.line <= range.last; });
+            const int top = std::min(static_cast<int>(begin - rows.begin()) * lineHeight, height);
+            const int bottom = rows.empty() || range.last > lastLine ? height : std::min(static_cast<int>(end - rows.begin()) * lineHeight, height);
+            if (top < bottom) {
+                m_resolved.push_back(Rect{0, top, width, bottom - top});
+            }
+        }
+
+        for (const Rect& rect : m_rects) {
+            const int left = std::max(rect.x, 0);
+            const int top = std::max(rect.y, 0);
+            const int right = std::min(rect.x + rect.width, width);
+            const int bottom = std::min(rect.y + rect.height, height);
+            if (left < right && top < bottom) {
+                m_resolved.push_back(Rect{left, top, right - left, bottom - top});
+            }
+        }
+
+        // Merge touching rects until the set is disjoint, so no pixel is redrawn or counted twice
+        for (bool merged = true; merged;) {
+            merged = false;
+            for (size_t i = 0; i < m_resolved.size() && !merged; ++i) {
+                for (size_t j = i + 1; j < m_resolved.size(); ++j) {
+                    if (touches(m_resolved[i], m_resolved[j])) {
+                        m_resolved[i] = unite(m_resolved[i], m_resolved[j]);
+                        m_resolved.erase(m_resolved.begin() + static_cast<ptrdiff_t>(j));
+                        merged = true;
+                        break;
+                    }
+                }
+            }
+        }
+
+        if (m_resolved.size() > MaxRects) {
+            Rect bounds = m_resolved.front();
+            for (const Rect& rect : m_resolved) {
+                bounds = unite(bounds, rect);
+            }
+            m_resolved.assign(1, bounds);
+        }
+        return m_resolved;
+    }
+
+    /**
+     * @brief Forget all damage, typically after a frame was drawn.
+     */
+    void DamageTracker::clear() noexcept {
+        m_full = false;
+        m_lines.clear();
+        m_rects.clear();
+    }
+
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#include "graphics/graphics_context.h"
+#include "render/text_layout.h"
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace drite {
+
+    /**
+     * @brief Collects the parts of the view that changed since the last frame.
+     *
+     * Editing code marks document line ranges, which stay valid across scrolling
+     * within the frame; rendering resolves them into framebuffer rects through
+     * the visual rows of the current viewport, so a damaged wrapped line
+     * covers all of its rows. A frame with no damage does not need to be drawn.
+     */
+    class DamageTracker {
+        public:
+            /**
+             * @brief Marks a line range that extends to the end of the document.
+             */
+            static constexpr size_t ToEnd = SIZE_MAX;
+
+            /**
+             * @brief Resolved rects beyond this count are merged into their bounding box.
+             */
+            static constexpr size_t MaxRects = 16;
+
+            /**
+             * @brief Mark the whole view as damaged.
+             */
+            void markAll() noexcept { m_full = true; }
+
+            /**
+             * @brief Mark a range of document lines as damaged, across the full view width.
+             * @param first The first damaged line.
+             * @param last The last damaged line, inclusive, or ToEnd.
+             */
+            void markLines(size_t first, size_t last);
+
+            /**
+             * @brief Mark a framebuffer region as damaged.
+             * @param rect The region in pixels.
+             */
+            void markRect(const Rect& rect);
+
+            /**
+             * @brief Check whether anything was marked since the last clear().
+             * @return True if nothing needs to be redrawn.
+             */
+            [[nodiscard]] bool isEmpty() const noexcept { return !m_full && m_lines.empty() && m_rects.empty(); }
+
+            /**
+             * @brief Convert the damage into disjoint framebuffer rects.
+             * @param rows The visual rows of the view, from the top down.
+             * @param lineHeight The row height in pixels.
+             * @param width The view width in pixels.
+             * @param height The view height in pixels.
+             * @return The damaged rects clipped to the view; valid until the next call.
+             */
+            [[nodiscard]] const std::vector<Rect>& resolve(std::span<const VisualRow> rows, int lineHeight, int width, int height);
+
+            /**
+             * @brief Forget all damage, typically after a frame was drawn.
+             */
+            void clear() noexcept;
+
+        private:
+            /**
+             * @brief An inclusive range of document lines.
+             */
+            struct LineRange {
+                size_t first{0};
+                size_t last{0};
+            };
+
+            /**
+             * @brief Whether the whole view is damaged.
+             */
+            bool m_full{true};
+
+            /**
+             * @brief Damaged line ranges, sorted and disjoint.
+             */
+            std::vector<LineRange> m_lines;
+
+            /**
+             * @brief Damaged framebuffer regions.
+             */
+            std::vector<Rect> m_rects;
+
+            /**
+             * @brief The rects produced by the last resolve().
+             */
+            std::vector<Rect> m_resolved;
+    };
+
+}
@@ -0,0 +1,414 @@
+#include "render/glyph_atlas.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+namespace drite {
+
+    /**
+     * @brief Initial number of hash map slots.
+     */
+    static constexpr size_t InitialSlots = 256;
+
+    /**
+     * @brief Empty pixels kept right of and below each glyph so filtered sampling never bleeds into a neighbour.
+     */
+    static constexpr int GlyphPadding = 1;
+
+    /**
+     * @brief Mix the bits of a packed key into a well-distributed hash.
+     * @param key The packed glyph key.
+     * @return The hash.
+     */
+    static uint64_t hashKey(uint64_t key) noexcept {
+        key ^= key >> 33;
+        key *= 0xFF51AFD7ED558CCDull;
+        key ^= key >> 33;
+        key *= 0xC4CEB9FE1A85EC53ull;
+        key ^= key >> 33;
+        return key;
+    }
+
+    /**
+     * @brief Construct a new Glyph Atlas object.
+     * @param rasterizer The rasterizer producing glyphs on misses; must outlive the atlas.
+     * @param width The atlas width in pixels.
+     * @param height The atlas height in pixels.
+     */
+    GlyphAtlas::GlyphAtlas(GlyphRasterizer& rasterizer, int width, int height)
+        : m_rasterizer(rasterizer)
+        , m_slots(InitialSlots, None) {
+        // Zeroed pages come from the kernel on first touch, so startup does
+        // not clear the whole atlas and only rows glyphs land in are faulted in
+        m_pixels.reset(static_cast<uint8_t*>(std::calloc(static_cast<size_t>(std::max(width, 1)) * static_cast<size_t>(std::max(height, 1)), 1)));
+        if (!m_pixels) {
+            throw std::bad_alloc();
+        }
+        m_texture.pixels = m_pixels.get();
+        m_texture.width = std::max(width, 1);
+        m_texture.height = std::max(height, 1);
+        m_texture.stride = m_texture.width;
+        m_texture.version = 1;
+    }
+
+    /**
+     * @brief Release the atlas pixels.
+     * @param pixels The pixels from std::calloc.
+     */
+    void GlyphAtlas::FreeDeleter::operator()(uint8_t* pixels) const noexcept {
+        std::free(pixels);
+    }
+
+    /**
+     * @brief Start a new frame; glyphs from earlier frames become evictable.
+     */
+    void GlyphAtlas::beginFrame() noexcept {
+        ++m_frame;
+    }
+
+    /**
+     * @brief Look up a glyph, rasterizing and packing it on a miss.
+     * @param key The glyph.
+     * @return The glyph placement, or std::nullopt if it cannot be cached this frame.
+     */
+    std::optional<AtlasGlyph> GlyphAtlas::getGlyph(const GlyphKey& key) {
+        const uint64_t packed = key.pack();
+        const uint32_t found = m_slots[findSlot(packed)];
+        if (found != None) {
+            ++m_stats.hits;
+            Entry& entry = m_entries[found];
+            entry.lastUsedFrame = m_frame;
+            if (m_mostRecent != found) {
+                unlink(found);
+                pushFront(found);
+            }
+            return entry.glyph;
+        }
+
+        ++m_stats.misses;
+        (void)m_rasterizer.rasterize(key, m_bitmap);
+
+        Entry entry;
+        entry.key = packed;
+        entry.lastUsedFrame = m_frame;
+        entry.glyph.width = m_bitmap.width;
+        entry.glyph.height = m_bitmap.height;
+        entry.glyph.bearingX = m_bitmap.bearingX;
+        entry.glyph.bearingY = m_bitmap.bearingY;
+
+        // Blank glyphs are cached without claiming atlas space
+        if (m_bitmap.width > 0 && m_bitmap.height > 0) {
+            int x{0};
+            if (!allocate(m_bitmap.width + GlyphPadding, m_bitmap.height + GlyphPadding, entry.shelf, x)) {
+                ++m_stats.failures;
+                return std::nullopt;
+            }
+
+            entry.glyph.u = x;
+            entry.glyph.v = m_shelves[entry.shelf].y;
+            for (int row = 0; row < m_bitmap.height; ++row) {
+                std::memcpy(m_pixels.get() + static_cast<size_t>(entry.glyph.v + row) * static_cast<size_t>(m_texture.stride) + entry.glyph.u,
+                            m_bitmap.coverage.data() + static_cast<size_t>(row) * static_cast<size_t>(m_bitmap.width),
+                            static_cast<size_t>(m_bitmap.width));
+            }
+            ++m_texture.version;
+            m_stats.usedPixels += static_cast<size_t>(m_bitmap.width) * static_cast<size_t>(m_bitmap.height);
+        }
+
+        uint32_t index{0};
+        if (!m_freeEntries.empty()) {
+            index = m_freeEntries.back();
+            m_freeEntries.pop_back();
+            m_entries[index] = entry;
+        } else {
+            index = static_cast<uint32_t>(m_entries.size());
+            m_entries.push_back(entry);
+        }
+
+        insertSlot(packed, index);
+        pushFront(index);
+        ++m_stats.glyphCount;
+        return entry.glyph;
+    }
+
+    /**
+     * @brief Drop every cached glyph, keeping the counters.
+     */
+    void GlyphAtlas::clear() {
+        m_entries.clear();
+        m_freeEntries.clear();
+        std::fill(m_slots.begin(), m_slots.end(), None);
+        m_slotCount = 0;
+        m_shelves.clear();
+        m_nextShelfY = 0;
+        m_mostRecent = None;
+        m_leastRecent = None;
+        m_stats.glyphCount = 0;
+        m_stats.usedPixels = 0;
+        ++m_texture.version;
+    }
+
+    /**
+     * @brief Reset the hit, miss, eviction and failure counters.
+     */
+    void GlyphAtlas::resetStats() noexcept {
+        m_stats.hits = 0;
+        m_stats.misses = 0;
+        m_stats.evictions = 0;
+        m_stats.failures = 0;
+    }
+
+    /**
+     * @brief Reserve atlas space, evicting least recently used glyphs as needed.
+     * @param width The width in pixels.
+     * @param height The height in pixels.
+     * @param shelf Receives the shelf index.
+     * @param x Receives the left edge.
+     * @return True if space was found.
+     */
+    bool GlyphAtlas::allocate(int width, int height, uint32_t& shelf, int& x) {
+        if (width > m_texture.width || height > m_texture.height) {
+            return false;
+        }
+
+        while (!tryAllocate(width, height, shelf, x)) {
+            if (!evictLeastRecent()) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /**
+     * @brief Reserve atlas space without evicting.
+     *
+     * Picks the lowest shelf that fits the glyph without wasting more than a
+     * quarter of its height, falling back to an empty shelf of any height, then
+     * to a new shelf below the last one.
+     *
+     * @param width The width in pixels.
+     * @param height The height in pixels.
+     * @param shelf Receives the shelf index.
+     * @param x Receives the left edge.
+     * @return True if space was found.
+     */
+    bool GlyphAtlas::tryAllocate(int width, int height, uint32_t& shelf, int& x) {
+        uint32_t best{None};
+        size_t bestSpan{0};
+        for (uint32_t i = 0; i < m_shelves.size(); ++i) {
+            const Shelf& candidate = m_shelves[i];
+            const bool snug = candidate.height >= height && candidate.height <= height + height / 4;
+            const bool empty = candidate.glyphCount == 0 && candidate.height >= height;
+            if (!snug && !empty) {
+                continue;
+            }
+            if (best != None && m_shelves[best].height <= candidate.height) {
+                continue;
+            }
+
+            for (size_t span = 0; span < candidate.freeSpans.size(); ++span) {
+                if (candidate.freeSpans[span].width >= width) {
+                    best = i;
+                    bestSpan = span;
+                    break;
+                }
+            }
+        }
+
+        if (best == None) {
+            if (m_nextShelfY + height > m_texture.height) {
+                return false;
+            }
+
+            Shelf created;
+            created.y = m_nextShelfY;
+            created.height = height;
+            created.freeSpans.push_back(Span{0, m_texture.width});
+            m_nextShelfY += height;
+
+            best = static_cast<uint32_t>(m_shelves.size());
+            bestSpan = 0;
+            m_shelves.push_back(std::move(created));
+        }
+
+        Shelf& target = m_shelves[best];
+        Span& span = target.freeSpans[bestSpan];
+        x = span.x;
+        span.x += width;
+        span.width -= width;
+        if (span.width == 0) {
+            target.freeSpans.erase(target.freeSpans.begin() + static_cast<ptrdiff_t>(bestSpan));
+        }
+
+        ++target.glyphCount;
+        shelf = best;
+        return true;
+    }
+
+    /**
+     * @brief Return a range to its shelf's free list, merging with neighbours.
+     * @param shelf The shelf index.
+     * @param x The left edge.
+     * @param width The width in pixels.
+     */
+    void GlyphAtlas::release(uint32_t shelf, int x, int width) {
+        Shelf& target = m_shelves[shelf];
+        std::vector<Span>& spans = target.freeSpans;
+
+        auto next = std::lower_bound(spans.begin(), spans.end(), x,
+                                     [](const Span& span, int value) { return span.x < value; });
+        next = spans.insert(next, Span{x, width});
+
+        if (next + 1 != spans.end() && next->x + next->width == (next + 1)->x) {
+            next->width += (next + 1)->width;
+            spans.erase(next + 1);
+        }
+        if (next != spans.begin() && (next - 1)->x + (next - 1)->width == next->x) {
+            (next - 1)->width += next->width;
+            spans.erase(next);
+        }
+
+        --target.glyphCount;
+
+        // Trailing empty shelves give their rows back so any glyph height can use them
+        while (!m_shelves.empty() && m_shelves.back().glyphCount == 0) {
+            m_nextShelfY = m_shelves.back().y;
+            m_shelves.pop_back();
+        }
+    }
+
+    /**
+     * @brief Evict the least recently used glyph not used this frame.
+     * @return True if a glyph was evicted.
+     */
+    bool GlyphAtlas::evictLeastRecent() {
+        if (m_leastRecent == None || m_entries[m_leastRecent].lastUsedFrame == m_frame) {
+            return false;
+        }
+
+        removeEntry(m_leastRecent);
+        ++m_stats.evictions;
+        return true;
+    }
+
+    /**
+     * @brief Find the hash map slot holding a key or the empty slot where it belongs.
+     * @param key The packed glyph key.
+     * @return The slot index.
+     */
+    size_t GlyphAtlas::findSlot(uint64_t key) const noexcept {
+        const size_t mask = m_slots.size() - 1;
+        size_t slot = static_cast<size_t>(hashKey(key)) & mask;
+        while (m_slots[slot] != None && m_entries[m_slots[slot]].key != key) {
+            slot = (slot + 1) & mask;
+        }
+        return slot;
+    }
+
+    /**
+     * @brief Insert an entry into the hash map, growing it if needed.
+     * @param key The packed glyph key.
+     * @param entry The entry index.
+     */
+    void GlyphAtlas::insertSlot(uint64_t key, uint32_t entry) {
+        // Keep the load factor at or below one half so probe sequences stay short
+        if ((m_slotCount + 1) * 2 > m_slots.size()) {
+            std::vector<uint32_t> previous(m_slots.size() * 2, None);
+            previous.swap(m_slots);
+            for (const uint32_t index : previous) {
+                if (index != None) {
+                    m_slots[findSlot(m_entries[index].key)] = index;
+                }
+            }
+        }
+
+        m_slots[findSlot(key)] = entry;
+        ++m_slotCount;
+    }
+
+    /**
+     * @brief Remove a key from the hash map, shifting later probes back.
+     *
+     * Backward-shift deletion keeps every probe sequence unbroken without
+     * tombstones, so lookups never degrade as glyphs churn.
+     *
+     * @param key The packed glyph key.
+     */
+    void GlyphAtlas::eraseSlot(uint64_t key) {
+        const size_t mask = m_slots.size() - 1;
+        size_t hole = findSlot(key);
+        if (m_slots[hole] == None) {
+            return;
+        }
+
+        for (size_t slot = (hole + 1) & mask; m_slots[slot] != None; slot = (slot + 1) & mask) {
+            const size_t home = static_cast<size_t>(hashKey(m_entries[m_slots[slot]].key)) & mask;
+
+            // Move the entry into the hole unless its home lies cyclically within (hole, slot]
+            const bool homeInRange = hole <= slot ? (home > hole && home <= slot) : (home > hole || home <= slot);
+            if (!homeInRange) {
+                m_slots[hole] = m_slots[slot];
+                hole = slot;
+            }
+        }
+
+        m_slots[hole] = None;
+        --m_slotCount;
+    }
+
+    /**
+     * @brief Unlink an entry from the LRU list.
+     * @param entry The entry index.
+     */
+    void GlyphAtlas::unlink(uint32_t entry) noexcept {
+        Entry& target = m_entries[entry];
+        if (target.previous != None) {
+            m_entries[target.previous].next = target.next;
+        } else {
+            m_mostRecent = target.next;
+        }
+        if (target.next != None) {
+            m_entries[target.next].previous = target.previous;
+        } else {
+            m_leastRecent = target.previous;
+        }
+        target.previous = None;
+        target.next = None;
+    }
+
+    /**
+     * @brief Link an entry at the most recent end of the LRU list.
+     * @param entry The entry index.
+     */
+    void GlyphAtlas::pushFront(uint32_t entry) noexcept {
+        Entry& target = m_entries[entry];
+        target.previous = None;
+        target.next = m_mostRecent;
+        if (m_mostRecent != None) {
+            m_entries[m_mostRecent].previous = entry;
+        } else {
+            m_leastRecent = entry;
+        }
+        m_mostRecent = entry;
+    }
+
+    /**
+     * @brief Remove an entry from the map and the LRU list and free its space.
+     * @param entry The entry index.
+     */
+    void GlyphAtlas::removeEntry(uint32_t entry) {
+        const Entry& target = m_entries[entry];
+        eraseSlot(target.key);
+        unlink(entry);
+
+        if (target.shelf != None) {
+            release(target.shelf, target.glyph.u, target.glyph.width + GlyphPadding);
+            m_stats.usedPixels -= static_cast<size_t>(target.glyph.width) * static_cast<size_t>(target.glyph.height);
+        }
+
+        m_freeEntries.push_back(entry);
+        --m_stats.glyphCount;
+    }
+
+}
@@ -0,0 +1,297 @@
+#pragma once
+
+#include "graphics/draw_list.h"
+#include "render/glyph_rasterizer.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <vector>
+
+namespace drite {
+
+    /**
+     * @brief Where a cached glyph lives in the atlas and how to place it.
+     */
+    struct AtlasGlyph {
+        int u{0};
+        int v{0};
+        int width{0};
+        int height{0};
+        int bearingX{0};
+        int bearingY{0};
+    };
+
+    /**
+     * @brief Glyph atlas counters since construction or the last resetStats().
+     */
+    struct GlyphAtlasStats {
+        uint64_t hits{0};
+        uint64_t misses{0};
+        uint64_t evictions{0};
+
+        /**
+         * @brief Lookups that could not be served because every slot was in use this frame.
+         */
+        uint64_t failures{0};
+
+        size_t glyphCount{0};
+
+        /**
+         * @brief Pixels of the atlas held by cached glyphs.
+         */
+        size_t usedPixels{0};
+    };
+
+    /**
+     * @brief Cache of rasterized glyphs packed into a single coverage texture.
+     *
+     * Each (font, size, glyph, subpixel offset) is rasterized once and packed into
+     * a shelf of the atlas. Lookups go through a flat open-addressing hash map.
+     * When a glyph does not fit, the least recently used glyphs are evicted and
+     * their space reused in place, so the atlas never has to be rebuilt. Glyphs
+     * used since the last beginFrame() are never evicted, because queued draw
+     * commands still reference them.
+     */
+    class GlyphAtlas {
+        public:
+            /**
+             * @brief Construct a new Glyph Atlas object.
+             * @param rasterizer The rasterizer producing glyphs on misses; must outlive the atlas.
+             * @param width The atlas width in pixels.
+             * @param height The atlas height in pixels.
+             */
+            GlyphAtlas(GlyphRasterizer& rasterizer, int width = 1024, int height = 1024);
+
+            /**
+             * @brief Start a new frame; glyphs from earlier frames become evictable.
+             */
+            void beginFrame() noexcept;
+
+            /**
+             * @brief Look up a glyph, rasterizing and packing it on a miss.
+             * @param key The glyph.
+             * @return The glyph placement, or std::nullopt if it cannot be cached this frame.
+             */
+            [[nodiscard]] std::optional<AtlasGlyph> getGlyph(const GlyphKey& key);
+
+            /**
+             * @brief Drop every cached glyph, keeping the counters.
+             */
+            void clear();
+
+            /**
+             * @brief Get the atlas texture for draw lists.
+             * @return The texture; its version changes whenever pixels change.
+             */
+            [[nodiscard]] const AlphaTexture& getTexture() const noexcept { return m_texture; }
+
+            /**
+             * @brief Get the rasterizer producing glyphs.
+             * @return Reference to the rasterizer.
+             */
+            [[nodiscard]] GlyphRasterizer& getRasterizer() const noexcept { return m_rasterizer; }
+
+            /**
+             * @brief Get the atlas counters.
+             * @return The counters.
+             */
+            [[nodiscard]] const GlyphAtlasStats& getStats() const noexcept { return m_stats; }
+
+            /**
+             * @brief Reset the hit, miss, eviction and failure counters.
+             */
+            void resetStats() noexcept;
+
+        private:
+            /**
+             * @brief Marks an empty hash map slot and the end of the LRU list.
+             */
+            static constexpr uint32_t None = UINT32_MAX;
+
+            /**
+             * @brief A cached glyph; entries are linked into the LRU list, most recent first.
+             */
+            struct Entry {
+                uint64_t key{0};
+                AtlasGlyph glyph;
+                uint64_t lastUsedFrame{0};
+                uint32_t shelf{None};
+                uint32_t previous{None};
+                uint32_t next{None};
+            };
+
+            /**
+             * @brief A free horizontal range of a shelf.
+             */
+            struct Span {
+                int x{0};
+                int width{0};
+            };
+
+            /**
+             * @brief A horizontal band of the atlas holding glyphs of similar height.
+             */
+            struct Shelf {
+                int y{0};
+                int height{0};
+                int glyphCount{0};
+
+                /**
+                 * @brief Free ranges, sorted by x and never adjacent.
+                 */
+                std::vector<Span> freeSpans;
+            };
+
+            /**
+             * @brief Reserve atlas space, evicting least recently used glyphs as needed.
+             * @param width The width in pixels.
+             * @param height The height in pixels.
+             * @param shelf Receives the shelf index.
+             * @param x Receives the left edge.
+             * @return True if space was found.
+             */
+            bool allocate(int width, int height, uint32_t& shelf, int& x);
+
+            /**
+             * @brief Reserve atlas space without evicting.
+             * @param width The width in pixels.
+             * @param height The height in pixels.
+             * @param shelf Receives the shelf index.
+             * @param x Receives the left edge.
+             * @return True if space was found.
+             */
+            bool tryAllocate(int width, int height, uint32_t& shelf, int& x);
+
+            /**
+             * @brief Return a range to its shelf's free list, merging with neighbours.
+             * @param shelf The shelf index.
+             * @param x The left edge.
+             * @param width The width in pixels.
+             */
+            void release(uint32_t shelf, int x, int width);
+
+            /**
+             * @brief Evict the least recently used glyph not used this frame.
+             * @return True if a glyph was evicted.
+             */
+            bool evictLeastRecent();
+
+            /**
+             * @brief Find the hash map slot holding a key or the empty slot where it belongs.
+             * @param key The packed glyph key.
+             * @return The slot index.
+             */
+            [[nodiscard]] size_t findSlot(uint64_t key) const noexcept;
+
+            /**
+             * @brief Insert an entry into the hash map, growing it if needed.
+             * @param key The packed glyph key.
+             * @param entry The entry index.
+             */
+            void insertSlot(uint64_t key, uint32_t entry);
+
+            /**
+             * @brief Remove a key from the hash map, shifting later probes back.
+             * @param key The packed glyph key.
+             */
+            void eraseSlot(uint64_t key);
+
+            /**
+             * @brief Unlink an entry from the LRU list.
+             * @param entry The entry index.
+             */
+            void unlink(uint32_t entry) noexcept;
+
+            /**
+             * @brief Link an entry at the most recent end of the LRU list.
+             * @param entry The entry index.
+             */
+            void pushFront(uint32_t entry) noexcept;
+
+            /**
+             * @brief Remove an entry from the map and the LRU list and free its space.
+             * @param entry The entry index.
+             */
+            void removeEntry(uint32_t entry);
+
+        private:
+            /**
+             * @brief Releases memory from std::calloc.
+             */
+            struct FreeDeleter {
+                void operator()(uint8_t* pixels) const noexcept;
+            };
+
+            /**
+             * @brief The rasterizer producing glyphs on misses.
+             */
+            GlyphRasterizer& m_rasterizer;
+
+            /**
+             * @brief The atlas pixels, one coverage byte each.
+             */
+            std::unique_ptr<uint8_t[], FreeDeleter> m_pixels;
+
+            /**
+             * @brief View of m_pixels handed to draw lists.
+             */
+            AlphaTexture m_texture;
+
+            /**
+             * @brief Cached glyphs; removed entries are recycled through m_freeEntries.
+             */
+            std::vector<Entry> m_entries;
+
+            /**
+             * @brief Indices of unused entries.
+             */
+            std::vector<uint32_t> m_freeEntries;
+
+            /**
+             * @brief Hash map slots holding entry indices; the size is a power of two.
+             */
+            std::vector<uint32_t> m_slots;
+
+            /**
+             * @brief Number of occupied hash map slots.
+             */
+            size_t m_slotCount{0};
+
+            /**
+             * @brief The shelves, top to bottom.
+             */
+            std::vector<Shelf> m_shelves;
+
+            /**
+             * @brief Top of the space not yet claimed by any shelf.
+             */
+            int m_nextShelfY{0};
+
+            /**
+             * @brief Head of the LRU list.
+             */
+            uint32_t m_mostRecent{None};
+
+            /**
+             * @brief Tail of the LRU list, the next eviction candidate.
+             */
+            uint32_t m_leastRecent{None};
+
+            /**
+             * @brief The current frame number.
+             */
+            uint64_t m_frame{1};
+
+            /**
+             * @brief Scratch bitmap reused across misses.
+             */
+            GlyphBitmap m_bitmap;
+
+            /**
+             * @brief The atlas counters.
+             */
+            GlyphAtlasStats m_stats;
+    };
+
+}
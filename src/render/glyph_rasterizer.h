@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace drite {
+
+    /**
+     * @brief Identifies one rasterized glyph image.
+     */
+    struct GlyphKey {
+        /**
+         * @brief Number of horizontal subpixel positions glyphs are rasterized at.
+         */
+        static constexpr uint32_t SubpixelSteps = 4;
+
+        uint16_t fontId{0};
+        uint16_t size{0};
+        uint8_t subpixel{0};
+        uint32_t codepoint{0};
+
+        /**
+         * @brief Pack the key into a single integer; distinct keys pack to distinct values.
+         * @return The packed key.
+         */
+        [[nodiscard]] constexpr uint64_t pack() const noexcept {
+            return static_cast<uint64_t>(codepoint & 0x1FFFFF) |
+                   (static_cast<uint64_t>(subpixel & 0x7) << 21) |
+                   (static_cast<uint64_t>(size) << 24) |
+                   (static_cast<uint64_t>(fontId) << 40);
+        }
+    };
+
+    /**
+     * @brief An 8-bit coverage image of one glyph, positioned relative to the pen.
+     */
+    struct GlyphBitmap {
+        int width{0};
+        int height{0};
+
+        /**
+         * @brief Offset from the pen position to the left edge of the image.
+         */
+        int bearingX{0};
+
+        /**
+         * @brief Offset from the top of the line to the top edge of the image.
+         */
+        int bearingY{0};
+
+        /**
+         * @brief Coverage values, width * height in row-major order.
+         */
+        std::vector<uint8_t> coverage;
+    };
+
+    /**
+     * @brief Produces glyph images for the glyph atlas.
+     *
+     * Implementations wrap a font engine (CoreText, FreeType, ...) or an
+     * embedded font. They are only called on atlas misses.
+     */
+    class GlyphRasterizer {
+        public:
+            virtual ~GlyphRasterizer() = default;
+
+            /**
+             * @brief Rasterize a glyph.
+             * @param key The glyph to rasterize, including its horizontal subpixel offset.
+             * @param bitmap Receives the glyph image; may be empty for blank glyphs.
+             * @return True if the glyph exists in the font, false otherwise.
+             */
+            [[nodiscard]] virtual bool rasterize(const GlyphKey& key, GlyphBitmap& bitmap) = 0;
+
+            /**
+             * @brief Get the horizontal advance of a monospaced cell.
+             * @param fontId The font.
+             * @param size The font size in pixels.
+             * @return The advance in pixels.
+             */
+            [[nodiscard]] virtual float getAdvance(uint16_t fontId, uint16_t size) const = 0;
+
+            /**
+             * @brief Get the distance between baselines.
+             * @param fontId The font.
+             * @param size The font size in pixels.
+             * @return The line height in pixels.
+             */
+            [[nodiscard]] virtual int getLineHeight(uint16_t fontId, uint16_t size) const = 0;
+    };
+
+}
@@ -0,0 +1,487 @@
+#include "render/text_layout.h"
+#include <algorithm>
+#include <bit>
+#include <functional>
+
+namespace drite {
+
+    /**
+     * @brief Scrolls up to this many rows wrap every line passed over; longer ones jump through the row index.
+     */
+    static constexpr ptrdiff_t MaxWalkRows = 1024;
+
+    /**
+     * @brief Decode one UTF-8 sequence.
+     * @param text The text.
+     * @param offset The offset of the sequence; advanced past it.
+     * @return The codepoint, or U+FFFD for malformed input.
+     */
+    uint32_t decodeUtf8(std::string_view text, size_t& offset) noexcept {
+        const auto lead = static_cast<uint8_t>(text[offset++]);
+        if (lead < 0x80) {
+            return lead;
+        }
+
+        size_t length{0};
+        uint32_t codepoint{0};
+        if ((lead & 0xE0) == 0xC0) {
+            length = 1;
+            codepoint = lead & 0x1F;
+        } else if ((lead & 0xF0) == 0xE0) {
+            length = 2;
+            codepoint = lead & 0x0F;
+        } else if ((lead & 0xF8) == 0xF0) {
+            length = 3;
+            codepoint = lead & 0x07;
+        } else {
+            return 0xFFFD;
+        }
+
+        for (size_t i = 0; i < length; ++i) {
+            if (offset >= text.size() || (static_cast<uint8_t>(text[offset]) & 0xC0) != 0x80) {
+                return 0xFFFD;
+            }
+            codepoint = (codepoint << 6) | (static_cast<uint8_t>(text[offset++]) & 0x3F);
+        }
+        return codepoint;
+    }
+
+    /**
+     * @brief Set the document line count, forgetting every measured line.
+     * @param lineCount The number of lines in the document.
+     */
+    void TextLayout::reset(size_t lineCount) {
+        m_lineCount = std::max<size_t>(lineCount, 1);
+
+        // The per-line arrays are only allocated once a line wraps, so a
+        // large file does not fill them with zeros before its first frame
+        m_extraRows.clear();
+        m_tree.clear();
+        m_wrappedLines.clear();
+        m_extraRowCount = 0;
+    }
+
+    /**
+     * @brief Set the wrap width.
+     * @param columns The number of cells per row, or 0 to disable wrapping.
+     */
+    void TextLayout::setWrapColumns(size_t columns) {
+        if (columns == m_columns) {
+            return;
+        }
+        m_columns = columns;
+
+        // Taking the wrapped lines out of the tree one by one is cheaper
+        // than clearing it, unless most of the document was measured
+        if (m_wrappedLines.size() * static_cast<size_t>(std::bit_width(m_lineCount)) < m_lineCount) {
+            for (const size_t line : m_wrappedLines) {
+                if (m_extraRows[line] != 0) {
+                    ++m_stats.invalidated;
+                    addExtraRows(line, 0 - static_cast<size_t>(m_extraRows[line]));
+                    m_extraRows[line] = 0;
+                }
+            }
+        } else {
+            m_stats.invalidated += static_cast<uint64_t>(std::ranges::count_if(m_extraRows, [](uint32_t rows) { return rows != 0; }));
+            std::ranges::fill(m_extraRows, 0);
+            std::ranges::fill(m_tree, 0);
+        }
+        m_wrappedLines.clear();
+        m_extraRowCount = 0;
+    }
+
+    /**
+     * @brief Forget the rows of edited lines and renumber the lines after them.
+     * @param change The lines affected by the edits.
+     * @param lineCount The number of lines in the document after the edits.
+     */
+    void TextLayout::applyLineChange(const LineChange& change, size_t lineCount) {
+        lineCount = std::max<size_t>(lineCount, 1);
+        const size_t lastLine = std::min(change.lastLine, lineCount - 1);
+
+        // Edits within lines keep the numbering, so only the edited lines are taken out of the tree
+        if (change.lineDelta == 0 && lineCount == m_lineCount && (lastLine - change.firstLine) < m_lineCount / 16) {
+            for (size_t line = change.firstLine; line <= lastLine; ++line) {
+                setExtraRows(line, 0);
+            }
+            return;
+        }
+
+        if (m_extraRows.empty()) {
+            m_lineCount = lineCount;
+            return;
+        }
+
+        // The edits replaced lines [firstLine, removedEnd] with [firstLine, lastLine]
+        const auto removedEnd = static_cast<size_t>(static_cast<ptrdiff_t>(change.lastLine) - change.lineDelta);
+        const auto first = m_extraRows.begin() + static_cast<ptrdiff_t>(std::min(change.firstLine, m_extraRows.size()));
+        const auto last = m_extraRows.begin() + static_cast<ptrdiff_t>(std::min(removedEnd + 1, m_extraRows.size()));
+        m_extraRows.insert(m_extraRows.erase(first, last), change.lastLine - change.firstLine + 1, 0);
+        m_extraRows.resize(lineCount, 0);
+        m_lineCount = lineCount;
+        rebuildTree();
+    }
+
+    /**
+     * @brief Wrap a line and record its row count.
+     * @param line The line index.
+     * @param text The line text without its terminator.
+     * @return The byte offset of each row in the line, starting with 0; valid until the next call.
+     */
+    std::span<const size_t> TextLayout::layoutLine(size_t line, std::string_view text) {
+        // A line with no more bytes than columns fits in one row unless a tab widens it
+        if (m_columns == 0 || text.size() > MaxWrappedLineBytes || (text.size() <= m_columns && text.find('\t') == std::string_view::npos)) {
+            setExtraRows(line, 0);
+            return m_singleRow;
+        }
+
+        const uint64_t key = std::hash<std::string_view>{}(text) ^ (m_columns * 0x9E3779B97F4A7C15ULL);
+        const auto found = m_index.find(key);
+        if (found != m_index.end()) {
+            Entry& entry = m_entries[found->second];
+            if (entry.length == text.size() && entry.columns == m_columns) {
+                ++m_stats.hits;
+                unlink(found->second);
+                linkFront(found->second);
+                setExtraRows(line, entry.starts.size() - 1);
+                return entry.starts;
+            }
+        }
+        ++m_stats.misses;
+
+        // A colliding entry is replaced; otherwise a new one is added, or the least recently used one recycled
+        uint32_t index{None};
+        if (found != m_index.end()) {
+            index = found->second;
+            unlink(index);
+        } else if (m_entries.size() < CacheCapacity) {
+            index = static_cast<uint32_t>(m_entries.size());
+            m_entries.emplace_back();
+            m_index.emplace(key, index);
+        } else {
+            index = m_leastRecent;
+            unlink(index);
+            m_index.erase(m_entries[index].key);
+            m_index.emplace(key, index);
+            ++m_stats.evictions;
+        }
+
+        Entry& entry = m_entries[index];
+        entry.key = key;
+        entry.length = text.size();
+        entry.columns = m_columns;
+        wrap(text, entry.starts);
+        linkFront(index);
+        setExtraRows(line, entry.starts.size() - 1);
+        return entry.starts;
+    }
+
+    /**
+     * @brief Get the visual rows from a position down.
+     * @param buffer The document text.
+     * @param top The first row to get.
+     * @param count The number of rows to get.
+     * @param rows Receives the rows; fewer than count at the end of the document.
+     */
+    void TextLayout::layoutRows(const TextBuffer& buffer, LayoutPosition top, size_t count, std::vector<VisualRow>& rows) {
+        rows.clear();
+        const size_t lineCount = buffer.getLineCount();
+        for (size_t line = top.line, row = top.row; rows.size() < count && line < lineCount; ++line, row = 0) {
+            const std::span<const size_t> starts = measureLine(buffer, line);
+            const size_t length = buffer.getLineLength(line);
+
+            // A position left past the end of its line by an edit shows the line's last row
+            for (row = std::min(row, starts.size() - 1); row < starts.size() && rows.size() < count; ++row) {
+                rows.push_back(VisualRow{line, row, starts[row], row + 1 < starts.size() ? starts[row + 1] : length});
+            }
+        }
+    }
+
+    /**
+     * @brief Move a position by a number of visual rows.
+     * @param buffer The document text.
+     * @param position The position to move from.
+     * @param rows The number of rows to move, negative to move up.
+     * @return The new position, clamped to the first and last rows of the document.
+     */
+    LayoutPosition TextLayout::scroll(const TextBuffer& buffer, LayoutPosition position, ptrdiff_t rows) {
+        const size_t lastLine = buffer.getLineCount() - 1;
+        position.line = std::min(position.line, lastLine);
+
+        // A long jump lands through the row index, where lines not yet wrapped count as one row
+        if (rows > MaxWalkRows || rows < -MaxWalkRows) {
+            const size_t current = getRowOfLine(position.line) + position.row;
+            const size_t distance = static_cast<size_t>(rows < 0 ? -rows : rows);
+            const size_t target = rows < 0 ? current - std::min(current, distance) : std::min(current + distance, getRowCount() - 1);
+            position = findRow(target);
+            position.line = std::min(position.line, lastLine);
+            position.row = std::min(position.row, measureLine(buffer, position.line).size() - 1);
+            return position;
+        }
+
+        if (rows > 0) {
+            auto remaining = static_cast<size_t>(rows);
+            while (remaining > 0) {
+                const size_t lineRows = measureLine(buffer, position.line).size();
+                const size_t below = lineRows - 1 - std::min(position.row, lineRows - 1);
+                if (remaining <= below) {
+                    position.row += remaining;
+                    break;
+                }
+                if (position.line == lastLine) {
+                    position.row = lineRows - 1;
+                    break;
+                }
+                remaining -= below + 1;
+                ++position.line;
+                position.row = 0;
+            }
+        } else {
+            auto remaining = static_cast<size_t>(-rows);
+            position.row = std::min(position.row, measureLine(buffer, position.line).size() - 1);
+            while (remaining > 0) {
+                if (remaining <= position.row) {
+                    position.row -= remaining;
+                    break;
+                }
+                if (position.line == 0) {
+                    position.row = 0;
+                    break;
+                }
+                remaining -= position.row + 1;
+                --position.line;
+                position.row = measureLine(buffer, position.line).size() - 1;
+            }
+        }
+        return position;
+    }
+
+    /**
+     * @brief Get the visual row holding a document offset.
+     * @param buffer The document text.
+     * @param offset The byte offset.
+     * @return The position; an offset at a wrap belongs to the row it starts.
+     */
+    LayoutPosition TextLayout::locate(const TextBuffer& buffer, size_t offset) {
+        const TextPosition position = buffer.offsetToPosition(offset);
+        const std::span<const size_t> starts = measureLine(buffer, position.line);
+        const auto row = std::upper_bound(starts.begin(), starts.end(), position.column) - starts.begin() - 1;
+        return LayoutPosition{position.line, static_cast<size_t>(row)};
+    }
+
+    /**
+     * @brief Get the document offset a visual row starts at.
+     * @param buffer The document text.
+     * @param position The row; clamped to the rows of its line.
+     * @return The byte offset.
+     */
+    size_t TextLayout::getRowStart(const TextBuffer& buffer, LayoutPosition position) {
+        const size_t line = std::min(position.line, buffer.getLineCount() - 1);
+        const std::span<const size_t> starts = measureLine(buffer, line);
+        return buffer.getLineStart(line) + starts[std::min(position.row, starts.size() - 1)];
+    }
+
+    /**
+     * @brief Get the visual row a line starts on.
+     * @param line The line index.
+     * @return The row index, counting lines not yet wrapped as one row.
+     */
+    size_t TextLayout::getRowOfLine(size_t line) const noexcept {
+        line = std::min(line, m_lineCount);
+        if (m_tree.empty()) {
+            return line;
+        }
+        size_t extraRows{0};
+        for (size_t node = line; node > 0; node -= node & (0 - node)) {
+            extraRows += m_tree[node];
+        }
+        return line + extraRows;
+    }
+
+    /**
+     * @brief Find the line holding a visual row.
+     * @param row The row index.
+     * @return The position, clamped to the last row of the document.
+     */
+    LayoutPosition TextLayout::findRow(size_t row) const noexcept {
+        if (m_tree.empty()) {
+            return row < m_lineCount ? LayoutPosition{row, 0} : LayoutPosition{m_lineCount - 1, 0};
+        }
+
+        // Descend the tree for the most lines whose rows all lie before the target
+        size_t lines{0};
+        size_t rows{0};
+        for (size_t step = std::bit_floor(m_lineCount); step > 0; step >>= 1) {
+            const size_t node = lines + step;
+            if (node <= m_lineCount && rows + step + m_tree[node] <= row) {
+                lines = node;
+                rows += step + m_tree[node];
+            }
+        }
+
+        if (lines >= m_lineCount) {
+            return LayoutPosition{m_lineCount - 1, m_extraRows[m_lineCount - 1]};
+        }
+        return LayoutPosition{lines, row - rows};
+    }
+
+    /**
+     * @brief Wrap a line of the document and record its row count.
+     * @param buffer The document text.
+     * @param line The line index.
+     * @return The byte offset of each row in the line; valid until the next call.
+     */
+    std::span<const size_t> TextLayout::measureLine(const TextBuffer& buffer, size_t line) {
+        // Huge lines are not copied out of the buffer only to be drawn on one row
+        const size_t length = buffer.getLineLength(line);
+        if (m_columns == 0 || length > MaxWrappedLineBytes) {
+            setExtraRows(line, 0);
+            return m_singleRow;
+        }
+        buffer.getText(buffer.getLineStart(line), length, m_lineText);
+        return layoutLine(line, m_lineText);
+    }
+
+    /**
+     * @brief Break a line into rows of at most m_columns cells.
+     * @param text The line text.
+     * @param starts Receives the byte offset of each row.
+     */
+    void TextLayout::wrap(std::string_view text, std::vector<size_t>& starts) const {
+        starts.assign(1, 0);
+        size_t rowStart{0};
+        size_t cell{0};
+
+        // The offset just past the last space or tab of the row, where it breaks if it can
+        size_t breakAt{0};
+
+        size_t offset{0};
+        while (offset < text.size()) {
+            const size_t glyph = offset;
+            const uint32_t codepoint = decodeUtf8(text, offset);
+            const bool blank = codepoint == ' ' || codepoint == '\t';
+
+            // Blanks hang past the edge, so a row never starts with the space that ended a word
+            if (!blank && glyph > rowStart && cell + 1 > m_columns) {
+                rowStart = breakAt > rowStart ? breakAt : glyph;
+                starts.push_back(rowStart);
+
+                // The word carried to the new row has no tabs, so each of its codepoints is one cell
+                cell = 0;
+                for (size_t i = rowStart; i < glyph; ++i) {
+                    cell += (static_cast<uint8_t>(text[i]) & 0xC0) != 0x80 ? 1 : 0;
+                }
+            }
+
+            cell += codepoint == '\t' ? TabWidth - cell % TabWidth : 1;
+            if (blank) {
+                breakAt = offset;
+            }
+        }
+    }
+
+    /**
+     * @brief Record the number of rows past the first a line takes.
+     * @param line The line index.
+     * @param extraRows The number of extra rows.
+     */
+    void TextLayout::setExtraRows(size_t line, size_t extraRows) {
+        if (line >= m_lineCount || (m_extraRows.empty() ? 0 : m_extraRows[line]) == extraRows) {
+            return;
+        }
+        if (m_extraRows.empty()) {
+            m_extraRows.assign(m_lineCount, 0);
+            m_tree.assign(m_lineCount + 1, 0);
+        }
+
+        // Lines that keep being edited are listed again each time; a list
+        // longer than the document is scanned down to the wrapped lines
+        const size_t previous = m_extraRows[line];
+        if (previous == 0) {
+            m_wrappedLines.push_back(line);
+            if (m_wrappedLines.size() > m_lineCount) {
+                m_wrappedLines.clear();
+                for (size_t wrapped = 0; wrapped < m_lineCount; ++wrapped) {
+                    if (m_extraRows[wrapped] != 0 || wrapped == line) {
+                        m_wrappedLines.push_back(wrapped);
+                    }
+                }
+            }
+        }
+        addExtraRows(line, extraRows - previous);
+        m_extraRowCount += extraRows - previous;
+        m_extraRows[line] = static_cast<uint32_t>(extraRows);
+    }
+
+    /**
+     * @brief Add to the extra rows of a line in the Fenwick tree.
+     * @param line The line index.
+     * @param delta The change, wrapping around for a decrease.
+     */
+    void TextLayout::addExtraRows(size_t line, size_t delta) noexcept {
+        for (size_t node = line + 1; node <= m_lineCount; node += node & (0 - node)) {
+            m_tree[node] += delta;
+        }
+    }
+
+    /**
+     * @brief Rebuild the Fenwick tree from the measured lines.
+     */
+    void TextLayout::rebuildTree() {
+        m_tree.assign(m_lineCount + 1, 0);
+        m_wrappedLines.clear();
+        m_extraRowCount = 0;
+        for (size_t line = 0; line < m_lineCount; ++line) {
+            if (m_extraRows[line] != 0) {
+                m_tree[line + 1] = m_extraRows[line];
+                m_extraRowCount += m_extraRows[line];
+                m_wrappedLines.push_back(line);
+            }
+        }
+
+        // Each node passes its sum on to its parent, building the tree in one pass
+        for (size_t node = 1; node <= m_lineCount; ++node) {
+            const size_t parent = node + (node & (0 - node));
+            if (parent <= m_lineCount) {
+                m_tree[parent] += m_tree[node];
+            }
+        }
+    }
+
+    /**
+     * @brief Unlink a cache entry from the recency list.
+     * @param index The entry index.
+     */
+    void TextLayout::unlink(uint32_t index) noexcept {
+        Entry& entry = m_entries[index];
+        if (entry.previous != None) {
+            m_entries[entry.previous].next = entry.next;
+        } else {
+            m_mostRecent = entry.next;
+        }
+        if (entry.next != None) {
+            m_entries[entry.next].previous = entry.previous;
+        } else {
+            m_leastRecent = entry.previous;
+        }
+        entry.previous = None;
+        entry.next = None;
+    }
+
+    /**
+     * @brief Link a cache entry as most recently used.
+     * @param index The entry index.
+     */
+    void TextLayout::linkFront(uint32_t index) noexcept {
+        Entry& entry = m_entries[index];
+        entry.previous = None;
+        entry.next = m_mostRecent;
+        if (m_mostRecent != None) {
+            m_entries[m_mostRecent].previous = index;
+        } else {
+            m_leastRecent = index;
+        }
+        m_mostRecent = index;
+    }
+
+}
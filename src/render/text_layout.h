@@ -0,0 +1,313 @@
+#pragma once
+
+#include "editor/text_buffer.h"
+#include <compare>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace drite {
+
+    /**
+     * @brief Decode one UTF-8 sequence.
+     * @param text The text.
+     * @param offset The offset of the sequence; advanced past it.
+     * @return The codepoint, or U+FFFD for malformed input.
+     */
+    [[nodiscard]] uint32_t decodeUtf8(std::string_view text, size_t& offset) noexcept;
+
+    /**
+     * @brief A place in the wrapped view: a document line and a visual row within it.
+     */
+    struct LayoutPosition {
+        size_t line{0};
+        size_t row{0};
+
+        auto operator<=>(const LayoutPosition&) const = default;
+    };
+
+    /**
+     * @brief One visual row of the view: a byte range of a document line.
+     */
+    struct VisualRow {
+        size_t line{0};
+        size_t row{0};
+        size_t start{0};
+        size_t end{0};
+
+        bool operator==(const VisualRow&) const = default;
+    };
+
+    /**
+     * @brief Text layout counters since construction.
+     */
+    struct TextLayoutStats {
+        uint64_t hits{0};
+        uint64_t misses{0};
+        uint64_t evictions{0};
+
+        /**
+         * @brief Measured lines forgotten because the wrap width changed.
+         */
+        uint64_t invalidated{0};
+    };
+
+    /**
+     * @brief Soft-wraps document lines to the view width and maps visual rows to lines.
+     *
+     * Lines are wrapped on the renderer's monospaced grid, after the last
+     * space or tab that fits, or mid-word when a word is wider than the view.
+     * Wrapping is computed lazily, only for the lines that are drawn or
+     * scrolled over, and cached by line content and width in a fixed-size
+     * LRU cache, so redrawing or revisiting a line does not wrap it again.
+     *
+     * A Fenwick tree holds the extra rows of every measured line; lines never
+     * measured count as one row. It maps a line to its first visual row and a
+     * visual row back to its line in O(log n), which lets a large scroll jump
+     * straight to its target. When the width changes only the measured lines
+     * are taken out of the tree, and the lines near the viewport are wrapped
+     * again as they are drawn, so resizing does not depend on the document size.
+     */
+    class TextLayout {
+        public:
+            /**
+             * @brief Number of cells between tab stops.
+             */
+            static constexpr size_t TabWidth = 4;
+
+            /**
+             * @brief Number of wrapped lines kept in the cache.
+             */
+            static constexpr size_t CacheCapacity = 4096;
+
+            /**
+             * @brief Lines longer than this are drawn on one row instead of being wrapped.
+             */
+            static constexpr size_t MaxWrappedLineBytes = 1024 * 1024;
+
+            /**
+             * @brief Set the document line count, forgetting every measured line.
+             * @param lineCount The number of lines in the document.
+             */
+            void reset(size_t lineCount);
+
+            /**
+             * @brief Set the wrap width.
+             * @param columns The number of cells per row, or 0 to disable wrapping.
+             */
+            void setWrapColumns(size_t columns);
+
+            /**
+             * @brief Get the wrap width.
+             * @return The number of cells per row, or 0 if wrapping is disabled.
+             */
+            [[nodiscard]] size_t getWrapColumns() const noexcept { return m_columns; }
+
+            /**
+             * @brief Forget the rows of edited lines and renumber the lines after them.
+             * @param change The lines affected by the edits.
+             * @param lineCount The number of lines in the document after the edits.
+             */
+            void applyLineChange(const LineChange& change, size_t lineCount);
+
+            /**
+             * @brief Wrap a line and record its row count.
+             * @param line The line index.
+             * @param text The line text without its terminator.
+             * @return The byte offset of each row in the line, starting with 0; valid until the next call.
+             */
+            [[nodiscard]] std::span<const size_t> layoutLine(size_t line, std::string_view text);
+
+            /**
+             * @brief Get the visual rows from a position down.
+             * @param buffer The document text.
+             * @param top The first row to get.
+             * @param count The number of rows to get.
+             * @param rows Receives the rows; fewer than count at the end of the document.
+             */
+            void layoutRows(const TextBuffer& buffer, LayoutPosition top, size_t count, std::vector<VisualRow>& rows);
+
+            /**
+             * @brief Move a position by a number of visual rows.
+             * @param buffer The document text.
+             * @param position The position to move from.
+             * @param rows The number of rows to move, negative to move up.
+             * @return The new position, clamped to the first and last rows of the document.
+             */
+            [[nodiscard]] LayoutPosition scroll(const TextBuffer& buffer, LayoutPosition position, ptrdiff_t rows);
+
+            /**
+             * @brief Get the visual row holding a document offset.
+             * @param buffer The document text.
+             * @param offset The byte offset.
+             * @return The position; an offset at a wrap belongs to the row it starts.
+             */
+            [[nodiscard]] LayoutPosition locate(const TextBuffer& buffer, size_t offset);
+
+            /**
+             * @brief Get the document offset a visual row starts at.
+             * @param buffer The document text.
+             * @param position The row; clamped to the rows of its line.
+             * @return The byte offset.
+             */
+            [[nodiscard]] size_t getRowStart(const TextBuffer& buffer, LayoutPosition position);
+
+            /**
+             * @brief Get the visual row a line starts on.
+             * @param line The line index.
+             * @return The row index, counting lines not yet wrapped as one row.
+             */
+            [[nodiscard]] size_t getRowOfLine(size_t line) const noexcept;
+
+            /**
+             * @brief Find the line holding a visual row.
+             * @param row The row index.
+             * @return The position, clamped to the last row of the document.
+             */
+            [[nodiscard]] LayoutPosition findRow(size_t row) const noexcept;
+
+            /**
+             * @brief Get the number of visual rows in the document.
+             * @return The row count, counting lines not yet wrapped as one row.
+             */
+            [[nodiscard]] size_t getRowCount() const noexcept { return m_lineCount + m_extraRowCount; }
+
+            /**
+             * @brief Get the cache counters.
+             * @return The counters.
+             */
+            [[nodiscard]] const TextLayoutStats& getStats() const noexcept { return m_stats; }
+
+        private:
+            /**
+             * @brief Wrap a line of the document and record its row count.
+             * @param buffer The document text.
+             * @param line The line index.
+             * @return The byte offset of each row in the line; valid until the next call.
+             */
+            std::span<const size_t> measureLine(const TextBuffer& buffer, size_t line);
+
+            /**
+             * @brief Break a line into rows of at most m_columns cells.
+             * @param text The line text.
+             * @param starts Receives the byte offset of each row.
+             */
+            void wrap(std::string_view text, std::vector<size_t>& starts) const;
+
+            /**
+             * @brief Record the number of rows past the first a line takes.
+             * @param line The line index.
+             * @param extraRows The number of extra rows.
+             */
+            void setExtraRows(size_t line, size_t extraRows);
+
+            /**
+             * @brief Add to the extra rows of a line in the Fenwick tree.
+             * @param line The line index.
+             * @param delta The change, wrapping around for a decrease.
+             */
+            void addExtraRows(size_t line, size_t delta) noexcept;
+
+            /**
+             * @brief Rebuild the Fenwick tree from the measured lines.
+             */
+            void rebuildTree();
+
+            /**
+             * @brief Unlink a cache entry from the recency list.
+             * @param index The entry index.
+             */
+            void unlink(uint32_t index) noexcept;
+
+            /**
+             * @brief Link a cache entry as most recently used.
+             * @param index The entry index.
+             */
+            void linkFront(uint32_t index) noexcept;
+
+        private:
+            /**
+             * @brief Marks the ends of the recency list.
+             */
+            static constexpr uint32_t None = UINT32_MAX;
+
+            /**
+             * @brief A wrapped line in the cache.
+             */
+            struct Entry {
+                uint64_t key{0};
+                size_t length{0};
+                size_t columns{0};
+                uint32_t previous{None};
+                uint32_t next{None};
+                std::vector<size_t> starts;
+            };
+
+            /**
+             * @brief The number of cells per row, 0 for no wrapping.
+             */
+            size_t m_columns{0};
+
+            /**
+             * @brief The number of document lines.
+             */
+            size_t m_lineCount{1};
+
+            /**
+             * @brief Fenwick tree over the extra rows of each line, indexed from 1; empty while m_extraRows is.
+             */
+            std::vector<size_t> m_tree;
+
+            /**
+             * @brief The rows past the first of each line, 0 for lines not measured; empty until a line wraps.
+             */
+            std::vector<uint32_t> m_extraRows;
+
+            /**
+             * @brief Lines given extra rows since the tree was last cleared; some may since have been reset or listed twice.
+             */
+            std::vector<size_t> m_wrappedLines;
+
+            /**
+             * @brief The sum of m_extraRows.
+             */
+            size_t m_extraRowCount{0};
+
+            /**
+             * @brief Cached wrapped lines.
+             */
+            std::vector<Entry> m_entries;
+
+            /**
+             * @brief Maps a line hash to its entry in m_entries.
+             */
+            std::unordered_map<uint64_t, uint32_t> m_index;
+
+            /**
+             * @brief The most and least recently used entries.
+             */
+            uint32_t m_mostRecent{None};
+            uint32_t m_leastRecent{None};
+
+            /**
+             * @brief The rows of a line that is not wrapped.
+             */
+            std::vector<size_t> m_singleRow{0};
+
+            /**
+             * @brief Text of the line being wrapped; storage is reused across lines.
+             */
+            std::pmr::string m_lineText;
+
+            /**
+             * @brief Cache counters.
+             */
+            TextLayoutStats m_stats;
+    };
+
+}
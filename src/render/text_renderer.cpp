@@ -0,0 +1,210 @@
+#include "render/text_renderer.h"
+#include <algorithm>
+#include <cmath>
+#include <string>
+
+namespace drite {
+
+    /**
+     * @brief Width of the cursor bar in pixels.
+     */
+    static constexpr int CursorWidth = 2;
+
+    /**
+     * @brief Get the color of a token kind.
+     * @param kind The token kind.
+     * @return The color.
+     */
+    const Color& TextTheme::getTokenColor(TokenKind kind) const noexcept {
+        switch (kind) {
+            case TokenKind::Keyword: return keyword;
+            case TokenKind::Type: return type;
+            case TokenKind::String: return string;
+            case TokenKind::Number: return number;
+            case TokenKind::Comment: return comment;
+            case TokenKind::Preprocessor: return preprocessor;
+            case TokenKind::Text: break;
+        }
+        return text;
+    }
+
+    /**
+     * @brief Construct a new Text Renderer object.
+     * @param atlas The glyph atlas to draw from; must outlive the renderer.
+     * @param fontSize The font size in pixels.
+     */
+    TextRenderer::TextRenderer(GlyphAtlas& atlas, uint16_t fontSize)
+        : m_atlas(atlas)
+        , m_fontSize(fontSize) {}
+
+    /**
+     * @brief Get the height of a text line.
+     * @return The line height in pixels.
+     */
+    int TextRenderer::getLineHeight() const {
+        return std::max(1, m_atlas.getRasterizer().getLineHeight(0, m_fontSize));
+    }
+
+    /**
+     * @brief Get the width of a text cell.
+     * @return The cell advance in pixels.
+     */
+    float TextRenderer::getAdvance() const {
+        return std::max(1.0f, m_atlas.getRasterizer().getAdvance(0, m_fontSize));
+    }
+
+    /**
+     * @brief Get the number of whole lines that fit in a viewport.
+     * @param height The viewport height in pixels.
+     * @return The number of visible lines, at least 1.
+     */
+    size_t TextRenderer::getVisibleLineCount(int height) const {
+        return static_cast<size_t>(std::max(1, height / getLineHeight()));
+    }
+
+    /**
+     * @brief Draw visual rows of a document and its cursors.
+     * @param document The document.
+     * @param rows The rows to draw, from the top of the viewport down.
+     * @param width The viewport width in pixels.
+     * @param drawList The draw list receiving the commands.
+     * @param decorations Highlighting and search matches to draw.
+     * @param scratch Memory for the line text, e.g. of the frame arena.
+     */
+    void TextRenderer::drawDocument(const Document& document, std::span<const VisualRow> rows, int width, DrawList& drawList,
+                                    const TextDecorations& decorations, std::pmr::memory_resource* scratch) {
+        const TextBuffer& buffer = document.getBuffer();
+        const std::span<const size_t> cursors = m_cursorVisible ? document.getCursors() : std::span<const size_t>();
+        const int lineHeight = getLineHeight();
+
+        drawList.setGlyphTexture(&m_atlas.getTexture());
+        if (rows.empty()) {
+            return;
+        }
+
+        // A wrapped line is read and tokenized once for all of its rows
+        const size_t firstLine = rows.front().line;
+        const std::span<const SearchMatch> matches = decorations.matches;
+        size_t textLine{SIZE_MAX};
+        size_t lineStart{0};
+        std::pmr::string text(scratch);
+        for (size_t i = 0; i < rows.size(); ++i) {
+            const VisualRow& row = rows[i];
+            if (row.line != textLine) {
+                textLine = row.line;
+                lineStart = buffer.getLineStart(row.line);
+                buffer.getText(lineStart, buffer.getLineLength(row.line), text);
+
+                m_tokens.clear();
+                const size_t index = row.line - firstLine;
+                if (decorations.language && index < decorations.lineStates.size() && decorations.lineStates[index] != LexUnknown) {
+                    static_cast<void>(tokenizeLine(*decorations.language, text, decorations.lineStates[index], &m_tokens));
+                }
+            }
+            const int y = static_cast<int>(i) * lineHeight;
+
+            // Matches do not overlap, so their ends are sorted too
+            const auto first = std::partition_point(matches.begin(), matches.end(), [&](const SearchMatch& match) {
+                return match.offset + match.length <= lineStart + row.start;
+            });
+            const auto last = std::partition_point(first, matches.end(), [&](const SearchMatch& match) {
+                return match.offset < lineStart + row.end;
+            });
+
+            // A cursor at a wrap is drawn at the start of the next row, and one at the end of the line after its last row
+            const bool lastRow = row.end == text.size();
+            const auto firstCursor = std::partition_point(cursors.begin(), cursors.end(), [&](size_t cursor) {
+                return cursor < lineStart + row.start;
+            });
+            const auto lastCursor = std::partition_point(firstCursor, cursors.end(), [&](size_t cursor) {
+                return cursor < lineStart + row.end || (lastRow && cursor == lineStart + row.end);
+            });
+            drawLine(text, lineStart, row.start, row.end, y, width, std::span<const size_t>(firstCursor, lastCursor), m_tokens,
+                     std::span<const SearchMatch>(first, last), decorations.currentMatch, drawList);
+        }
+    }
+
+    /**
+     * @brief Draw one visual row of a line.
+     * @param text The line text without its terminator.
+     * @param lineStart The document offset of the line.
+     * @param rowStart The byte offset in the line where the row starts.
+     * @param rowEnd The byte offset in the line where the row ends.
+     * @param y The top of the row in pixels.
+     * @param width The viewport width in pixels.
+     * @param cursors The document offsets of the cursors on the row, in order.
+     * @param tokens The highlighted runs of the line, in order.
+     * @param matches The search matches overlapping the line, in order.
+     * @param currentMatch Offset of the match drawn as current, or SIZE_MAX for none.
+     * @param drawList The draw list receiving the commands.
+     */
+    void TextRenderer::drawLine(std::string_view text, size_t lineStart, size_t rowStart, size_t rowEnd, int y, int width, std::span<const size_t> cursors,
+                                std::span<const Token> tokens, std::span<const SearchMatch> matches, size_t currentMatch, DrawList& drawList) {
+        const float advance = getAdvance();
+        const int lineHeight = getLineHeight();
+        size_t cell{0};
+        size_t offset{rowStart};
+        size_t token{0};
+        size_t match{0};
+        size_t cursor{0};
+
+        while (offset < rowEnd) {
+            // Tokens are sorted, so the one covering this glyph is found by walking forward
+            while (token < tokens.size() && tokens[token].start + tokens[token].length <= offset) {
+                ++token;
+            }
+            const bool highlighted = token < tokens.size() && tokens[token].start <= offset;
+            const Color& color = highlighted ? m_theme.getTokenColor(tokens[token].kind) : m_theme.text;
+
+            // Matches are walked the same way; their cells are filled in the background layer, under the glyphs
+            const size_t documentOffset = lineStart + offset;
+            while (match < matches.size() && matches[match].offset + matches[match].length <= documentOffset) {
+                ++match;
+            }
+            const bool matched = match < matches.size() && matches[match].offset <= documentOffset;
+
+            const uint32_t codepoint = decodeUtf8(text, offset);
+            const float x = static_cast<float>(cell) * advance;
+            if (x >= static_cast<float>(width)) {
+                return;
+            }
+
+            const size_t cells = codepoint == '\t' ? TabWidth - cell % TabWidth : 1;
+            if (matched) {
+                const int left = static_cast<int>(std::floor(x));
+                const int right = static_cast<int>(std::floor(static_cast<float>(cell + cells) * advance));
+                drawList.addRect(left, y, right - left, lineHeight, matches[match].offset == currentMatch ? m_theme.currentMatch : m_theme.match,
+                                 DrawLayer::Background);
+            }
+            // Cursors at the glyph, or inside its multi-byte sequence, are drawn under it
+            while (cursor < cursors.size() && cursors[cursor] < lineStart + offset) {
+                drawList.addRect(static_cast<int>(std::floor(x)), y, CursorWidth, lineHeight, m_theme.cursor, DrawLayer::Background);
+                ++cursor;
+            }
+            cell += cells;
+            if (codepoint == '\t') {
+                continue;
+            }
+
+            GlyphKey key;
+            key.size = m_fontSize;
+            key.codepoint = codepoint;
+            const float pixel = std::floor(x);
+            key.subpixel = static_cast<uint8_t>((x - pixel) * GlyphKey::SubpixelSteps);
+
+            const std::optional<AtlasGlyph> glyph = m_atlas.getGlyph(key);
+            if (!glyph || glyph->width == 0) {
+                continue;
+            }
+
+            drawList.addGlyph(static_cast<int>(pixel) + glyph->bearingX, y + glyph->bearingY,
+                              glyph->width, glyph->height, glyph->u, glyph->v, color);
+        }
+
+        if (cursor < cursors.size()) {
+            drawList.addRect(static_cast<int>(std::floor(static_cast<float>(cell) * advance)), y, CursorWidth, lineHeight, m_theme.cursor,
+                             DrawLayer::Background);
+        }
+    }
+
+}
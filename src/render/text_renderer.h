@@ -0,0 +1,188 @@
+#pragma once
+
+#include "editor/document.h"
+#include "graphics/draw_list.h"
+#include "render/glyph_atlas.h"
+#include "render/text_layout.h"
+#include "search/search_match.h"
+#include "syntax/language.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <span>
+#include <vector>
+
+namespace drite {
+
+    /**
+     * @brief Colors used to draw a document.
+     */
+    struct TextTheme {
+        Color text{0.85f, 0.85f, 0.88f, 1.0f};
+        Color cursor{0.95f, 0.75f, 0.3f, 1.0f};
+        Color keyword{0.78f, 0.52f, 0.92f, 1.0f};
+        Color type{0.35f, 0.75f, 0.85f, 1.0f};
+        Color string{0.6f, 0.82f, 0.45f, 1.0f};
+        Color number{0.95f, 0.6f, 0.4f, 1.0f};
+        Color comment{0.45f, 0.5f, 0.58f, 1.0f};
+        Color preprocessor{0.9f, 0.45f, 0.55f, 1.0f};
+        Color match{0.3f, 0.3f, 0.22f, 1.0f};
+        Color currentMatch{0.55f, 0.4f, 0.12f, 1.0f};
+
+        /**
+         * @brief Get the color of a token kind.
+         * @param kind The token kind.
+         * @return The color.
+         */
+        [[nodiscard]] const Color& getTokenColor(TokenKind kind) const noexcept;
+    };
+
+    /**
+     * @brief Highlighting and search results drawn over the plain text of a document.
+     */
+    struct TextDecorations {
+        /**
+         * @brief The language to highlight, or nullptr for plain text.
+         */
+        const Language* language{nullptr};
+
+        /**
+         * @brief The lexer state at the start of each visible line, from the line of the first row; lines without a known state are drawn plain.
+         */
+        std::span<const LexState> lineStates;
+
+        /**
+         * @brief Search matches to underlay, sorted by offset and not overlapping.
+         */
+        std::span<const SearchMatch> matches;
+
+        /**
+         * @brief Offset of the match drawn as current, or SIZE_MAX for none.
+         */
+        size_t currentMatch{SIZE_MAX};
+    };
+
+    /**
+     * @brief Turns the visible rows of a document into glyph draw commands.
+     *
+     * Text is laid out on a monospaced grid: one cell per codepoint, tabs
+     * advancing to the next multiple of TabWidth cells from the start of the
+     * row. Which part of a line each row shows is decided by the text layout.
+     * Glyph images come from the glyph atlas, which is also set as the draw
+     * list's glyph texture.
+     */
+    class TextRenderer {
+        public:
+            /**
+             * @brief Number of cells between tab stops.
+             */
+            static constexpr size_t TabWidth = TextLayout::TabWidth;
+
+            /**
+             * @brief Construct a new Text Renderer object.
+             * @param atlas The glyph atlas to draw from; must outlive the renderer.
+             * @param fontSize The font size in pixels.
+             */
+            explicit TextRenderer(GlyphAtlas& atlas, uint16_t fontSize = 16);
+
+            /**
+             * @brief Set the font size.
+             * @param fontSize The font size in pixels.
+             */
+            void setFontSize(uint16_t fontSize) noexcept { m_fontSize = fontSize; }
+
+            /**
+             * @brief Get the font size.
+             * @return The font size in pixels.
+             */
+            [[nodiscard]] uint16_t getFontSize() const noexcept { return m_fontSize; }
+
+            /**
+             * @brief Get the height of a text line.
+             * @return The line height in pixels.
+             */
+            [[nodiscard]] int getLineHeight() const;
+
+            /**
+             * @brief Get the width of a text cell.
+             * @return The cell advance in pixels.
+             */
+            [[nodiscard]] float getAdvance() const;
+
+            /**
+             * @brief Get the number of whole lines that fit in a viewport.
+             * @param height The viewport height in pixels.
+             * @return The number of visible lines, at least 1.
+             */
+            [[nodiscard]] size_t getVisibleLineCount(int height) const;
+
+            /**
+             * @brief Draw visual rows of a document and its cursors.
+             * @param document The document.
+             * @param rows The rows to draw, from the top of the viewport down.
+             * @param width The viewport width in pixels.
+             * @param drawList The draw list receiving the commands.
+             * @param decorations Highlighting and search matches to draw.
+             * @param scratch Memory for the line text, e.g. of the frame arena.
+             */
+            void drawDocument(const Document& document, std::span<const VisualRow> rows, int width, DrawList& drawList,
+                              const TextDecorations& decorations = {}, std::pmr::memory_resource* scratch = std::pmr::get_default_resource());
+
+            /**
+             * @brief Show or hide the cursor, e.g. while it blinks.
+             * @param visible True to draw the cursor.
+             */
+            void setCursorVisible(bool visible) noexcept { m_cursorVisible = visible; }
+
+            /**
+             * @brief Set the colors used to draw.
+             * @param theme The colors.
+             */
+            void setTheme(const TextTheme& theme) noexcept { m_theme = theme; }
+
+        private:
+            /**
+             * @brief Draw one visual row of a line.
+             * @param text The line text without its terminator.
+             * @param lineStart The document offset of the line.
+             * @param rowStart The byte offset in the line where the row starts.
+             * @param rowEnd The byte offset in the line where the row ends.
+             * @param y The top of the row in pixels.
+             * @param width The viewport width in pixels.
+             * @param cursors The document offsets of the cursors on the row, in order.
+             * @param tokens The highlighted runs of the line, in order.
+             * @param matches The search matches overlapping the line, in order.
+             * @param currentMatch Offset of the match drawn as current, or SIZE_MAX for none.
+             * @param drawList The draw list receiving the commands.
+             */
+            void drawLine(std::string_view text, size_t lineStart, size_t rowStart, size_t rowEnd, int y, int width, std::span<const size_t> cursors,
+                          std::span<const Token> tokens, std::span<const SearchMatch> matches, size_t currentMatch, DrawList& drawList);
+
+        private:
+            /**
+             * @brief The glyph atlas glyphs are drawn from.
+             */
+            GlyphAtlas& m_atlas;
+
+            /**
+             * @brief The font size in pixels.
+             */
+            uint16_t m_fontSize{16};
+
+            /**
+             * @brief The colors used to draw.
+             */
+            TextTheme m_theme;
+
+            /**
+             * @brief Whether the cursor is drawn.
+             */
+            bool m_cursorVisible{true};
+
+            /**
+             * @brief Tokens of the line being drawn; storage is reused across lines.
+             */
+            std::vector<Token> m_tokens;
+    };
+
+}
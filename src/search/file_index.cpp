@@ -0,0 +1,688 @@
+#include "search/file_index.h"
+#include "core/profiler.h"
+#include "search/fuzzy_match.h"
+#include "search/ignore_rules.h"
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <chrono>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <print>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <unordered_map>
+
+namespace drite {
+
+    /**
+     * @brief First bytes of every index image.
+     */
+    static constexpr char ImageMagic[8] = {'D', 'R', 'I', 'T', 'E', 'I', 'D', 'X'};
+
+    /**
+     * @brief Number of uint64_t mask arrays in an index image.
+     */
+    static constexpr uint64_t MaskSections = 5;
+
+    /**
+     * @brief Round a size up to the 8-byte alignment of image sections.
+     * @param size The size in bytes.
+     * @return The aligned size.
+     */
+    static constexpr uint64_t alignSection(uint64_t size) noexcept {
+        return (size + 7) & ~uint64_t{7};
+    }
+
+    /**
+     * @brief Get the seconds elapsed since a point in time.
+     * @param startTime The start time.
+     * @return The elapsed time in seconds.
+     */
+    static double getSecondsSince(std::chrono::steady_clock::time_point startTime) noexcept {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+    }
+
+    /**
+     * @brief Get the modification time of a stat result.
+     * @param info The stat result.
+     * @return The time in nanoseconds since the epoch.
+     */
+    static int64_t getModifiedTime(const struct stat& info) noexcept {
+        return static_cast<int64_t>(info.st_mtim.tv_sec) * 1'000'000'000 + info.st_mtim.tv_nsec;
+    }
+
+    /**
+     * @brief Join a directory and an entry name.
+     * @param directory The directory path, empty for the current one.
+     * @param name The entry name.
+     * @return The entry path.
+     */
+    static std::string joinPath(std::string_view directory, std::string_view name) {
+        std::string path;
+        path.reserve(directory.size() + name.size() + 1);
+        path += directory;
+        if (!path.empty() && !path.ends_with('/')) {
+            path += '/';
+        }
+        path += name;
+        return path;
+    }
+
+    /**
+     * @brief Read a small file into a string.
+     * @param path The file path.
+     * @param text Receives the contents.
+     * @return False if the file could not be opened.
+     */
+    static bool readFile(const std::string& path, std::string& text) {
+        const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            return false;
+        }
+
+        text.clear();
+        char chunk[4096];
+        for (;;) {
+            const ssize_t count = ::read(fd, chunk, sizeof(chunk));
+            if (count < 0 && errno == EINTR) {
+                continue;
+            }
+            if (count <= 0) {
+                break;
+            }
+            text.append(chunk, static_cast<size_t>(count));
+        }
+        ::close(fd);
+        return true;
+    }
+
+    /**
+     * @brief Point the sections into an image, checking its bounds.
+     * @param data The image bytes; must stay valid while attached.
+     * @return False if the image is malformed or of another version.
+     */
+    bool FileIndex::Image::attach(std::string_view data) {
+        Header header{};
+        if (data.size() < sizeof(Header)) {
+            return false;
+        }
+        std::memcpy(&header, data.data(), sizeof(Header));
+        if (std::memcmp(header.magic, ImageMagic, sizeof(ImageMagic)) != 0 || header.version != FormatVersion) {
+            return false;
+        }
+
+        // Section sizes come from the file, so they are checked in 64 bits before any is used
+        const uint64_t count = header.fileCount;
+        const uint64_t masksOffset = sizeof(Header);
+        const uint64_t offsetsOffset = masksOffset + MaskSections * count * sizeof(uint64_t);
+        const uint64_t lengthsOffset = offsetsOffset + alignSection((count + 1) * sizeof(uint32_t));
+        const uint64_t directoriesOffset = lengthsOffset + alignSection(count);
+        const uint64_t pathsOffset = directoriesOffset + uint64_t{header.directoryCount} * sizeof(DirectoryRecord);
+        if (header.pathBytes > data.size() || pathsOffset > data.size() - header.pathBytes || header.rootLength > header.pathBytes) {
+            return false;
+        }
+
+        masks = reinterpret_cast<const uint64_t*>(data.data() + masksOffset);
+        startMasks = masks + count;
+        nameMasks = startMasks + count;
+        nameStartMasks = nameMasks + count;
+        pairMasks = nameStartMasks + count;
+        fileOffsets = reinterpret_cast<const uint32_t*>(data.data() + offsetsOffset);
+        nameLengths = reinterpret_cast<const uint8_t*>(data.data() + lengthsOffset);
+        directories = reinterpret_cast<const DirectoryRecord*>(data.data() + directoriesOffset);
+        paths = data.data() + pathsOffset;
+        fileCount = header.fileCount;
+        directoryCount = header.directoryCount;
+
+        // Offsets are checked once here so lookups need no bounds checks
+        if (fileOffsets[0] != 0) {
+            return false;
+        }
+        for (uint32_t file = 0; file < fileCount; ++file) {
+            if (fileOffsets[file + 1] < fileOffsets[file]) {
+                return false;
+            }
+        }
+        if (fileOffsets[fileCount] > header.pathBytes) {
+            return false;
+        }
+        for (uint32_t directory = 0; directory < directoryCount; ++directory) {
+            const DirectoryRecord& record = directories[directory];
+            if (uint64_t{record.pathOffset} + record.pathLength > header.pathBytes ||
+                uint64_t{record.firstFile} + record.fileCount > fileCount) {
+                return false;
+            }
+        }
+
+        root = std::string_view(paths + header.pathBytes - header.rootLength, header.rootLength);
+        bytes = data.substr(0, pathsOffset + header.pathBytes);
+        return true;
+    }
+
+    /**
+     * @brief Construct a new File Index object; its thread starts with the first refresh.
+     */
+    FileIndex::FileIndex() = default;
+
+    /**
+     * @brief Destroy the File Index object, stopping its thread.
+     */
+    FileIndex::~FileIndex() {
+        shutdown();
+    }
+
+    /**
+     * @brief Stop the index thread, abandoning a running refresh.
+     */
+    void FileIndex::shutdown() {
+        {
+            std::lock_guard lock(m_mutex);
+            m_stopping = true;
+        }
+        m_requestReady.notify_all();
+
+        if (m_worker.joinable()) {
+            m_worker.join();
+        }
+    }
+
+    /**
+     * @brief Load the cached index of a directory and start refreshing it.
+     * @param root The directory to index.
+     * @param cachePath The cache file, or empty for none.
+     * @return True if a cached index was loaded.
+     */
+    bool FileIndex::open(const std::string& root, const std::string& cachePath) {
+        DRITE_PROFILE_ZONE("openFileIndex");
+        const auto startTime = std::chrono::steady_clock::now();
+        m_image.reset();
+        m_candidatesValid = false;
+        m_stats = FileIndexStats{};
+
+        // The cached image is used in place; only its offsets are read to check it
+        if (!cachePath.empty()) {
+            auto image = std::make_shared<Image>();
+            image->mapping = MappedFile::open(cachePath);
+            if (image->mapping && image->attach(image->mapping->getData()) && image->root == root) {
+                m_image = std::move(image);
+                m_stats.files = m_image->fileCount;
+                m_stats.directories = m_image->directoryCount;
+            }
+        }
+        m_stats.loadSeconds = getSecondsSince(startTime);
+
+        {
+            std::lock_guard lock(m_mutex);
+            m_root = root;
+            m_cachePath = cachePath;
+            m_baseImage = m_image;
+            m_result.reset();
+        }
+        refresh();
+        return m_image != nullptr;
+    }
+
+    /**
+     * @brief Start refreshing the index in the background.
+     */
+    void FileIndex::refresh() {
+        {
+            std::lock_guard lock(m_mutex);
+            m_requested = true;
+        }
+        m_refreshing = true;
+        m_requestReady.notify_all();
+
+        if (!m_worker.joinable()) {
+            m_worker = std::thread([this] {
+                if (Profiler::isEnabled()) {
+                    Profiler::setThreadName("file index");
+                }
+                workerLoop();
+            });
+        }
+    }
+
+    /**
+     * @brief Pick up a finished refresh.
+     * @return True if the index changed.
+     */
+    bool FileIndex::poll() {
+        std::unique_ptr<RefreshResult> result;
+        {
+            std::lock_guard lock(m_mutex);
+            result = std::move(m_result);
+            if (result) {
+                m_refreshing = m_requested;
+            }
+        }
+        if (!result || !result->image) {
+            return false;
+        }
+
+        m_image = std::move(result->image);
+        m_candidatesValid = false;
+        m_stats.files = m_image->fileCount;
+        m_stats.directories = m_image->directoryCount;
+        m_stats.rescannedDirectories = result->rescannedDirectories;
+        m_stats.reusedDirectories = result->reusedDirectories;
+        m_stats.refreshSeconds = result->seconds;
+        return true;
+    }
+
+    /**
+     * @brief Rank the paths matching a fuzzy query.
+     * @param query The query; ASCII case is ignored.
+     * @param limit The number of best matches returned.
+     * @param matches Receives the matches, best first.
+     */
+    void FileIndex::find(std::string_view query, size_t limit, std::vector<FileMatch>& matches) {
+        DRITE_PROFILE_ZONE("findFile");
+        const auto startTime = std::chrono::steady_clock::now();
+        matches.clear();
+        if (!m_image) {
+            return;
+        }
+        const Image& image = *m_image;
+
+        std::string folded(query);
+        for (char& character : folded) {
+            character = character >= 'A' && character <= 'Z' ? static_cast<char>(character | 0x20) : character;
+        }
+        const FuzzyPathTable table{image.masks, image.startMasks, image.nameMasks, image.nameStartMasks, image.pairMasks,
+                                     image.fileOffsets, image.nameLengths};
+
+        // Typing usually extends the query, and every match of the longer
+        // query is a match of the shorter one
+        const bool narrowing = m_candidatesValid && folded.starts_with(m_lastQuery);
+        const size_t tested = narrowing ? m_candidates.size() : image.fileCount;
+        m_nextCandidates.resize(tested);
+        m_bounds.resize(tested);
+        const size_t found = boundFuzzyMatches(folded, table, narrowing ? m_candidates.data() : nullptr, tested, m_nextCandidates.data(),
+                                               m_bounds.data());
+        m_nextCandidates.resize(found);
+
+        // Candidates are scored in order of falling bound, counting sorted,
+        // so the scan stops at the first bound that cannot beat the worst of
+        // the best matches kept in a min-heap of the limit size. Each bound
+        // keeps file order, and ties of equal score go to the earlier file.
+        int32_t lowest{INT32_MAX};
+        int32_t highest{INT32_MIN};
+        for (size_t i = 0; i < found; ++i) {
+            lowest = std::min(lowest, m_bounds[i]);
+            highest = std::max(highest, m_bounds[i]);
+        }
+        m_order.resize(found);
+        if (found > 0) {
+            std::vector<uint32_t> starts(static_cast<size_t>(highest - lowest) + 2, 0);
+            for (size_t i = 0; i < found; ++i) {
+                ++starts[static_cast<size_t>(highest - m_bounds[i]) + 1];
+            }
+            for (size_t i = 1; i < starts.size(); ++i) {
+                starts[i] += starts[i - 1];
+            }
+            for (size_t i = 0; i < found; ++i) {
+                m_order[starts[static_cast<size_t>(highest - m_bounds[i])]++] = static_cast<uint32_t>(i);
+            }
+        }
+
+        std::vector<std::pair<int32_t, uint32_t>> best;
+        best.reserve(limit + 1);
+        const auto worse = [](const std::pair<int32_t, uint32_t>& a, const std::pair<int32_t, uint32_t>& b) {
+            return a.first != b.first ? a.first > b.first : a.second < b.second;
+        };
+        size_t scored{0};
+        for (const uint32_t candidate : m_order) {
+            if (limit == 0) {
+                break;
+            }
+            const uint32_t file = m_nextCandidates[candidate];
+            if (best.size() == limit) {
+                const int32_t bound = m_bounds[candidate];
+                if (bound < best.front().first) {
+                    break;
+                }
+                if (bound == best.front().first && file > best.front().second) {
+                    continue;
+                }
+            }
+
+            ++scored;
+            const int32_t score = scoreFuzzy(image.getFile(file), folded);
+            if (score != NoFuzzyMatch && (best.size() < limit || worse(std::pair{score, file}, best.front()))) {
+                best.emplace_back(score, file);
+                std::push_heap(best.begin(), best.end(), worse);
+                if (best.size() > limit) {
+                    std::pop_heap(best.begin(), best.end(), worse);
+                    best.pop_back();
+                }
+            }
+        }
+        m_stats.candidates = m_nextCandidates.size();
+        m_stats.scored = scored;
+        m_candidates.swap(m_nextCandidates);
+        m_lastQuery = std::move(folded);
+        m_candidatesValid = true;
+
+        std::sort_heap(best.begin(), best.end(), worse);
+        matches.reserve(best.size());
+        for (const auto& [score, file] : best) {
+            matches.push_back(FileMatch{std::string(image.getFile(file)), score});
+        }
+        m_stats.findSeconds = getSecondsSince(startTime);
+    }
+
+    /**
+     * @brief Get the cache file used for a directory.
+     * @param root The directory.
+     * @return A path below $XDG_CACHE_HOME or ~/.cache, or empty if neither is set.
+     */
+    std::string FileIndex::getDefaultCachePath(const std::string& root) {
+        std::string base;
+        if (const char* cache = std::getenv("XDG_CACHE_HOME"); cache && *cache) {
+            base = cache;
+        } else if (const char* home = std::getenv("HOME"); home && *home) {
+            base = std::string(home) + "/.cache";
+        } else {
+            return {};
+        }
+
+        // The same directory reached through different paths shares one cache
+        char* resolved = ::realpath(root.c_str(), nullptr);
+        const std::string canonical = resolved ? resolved : root;
+        std::free(resolved);
+
+        char hash[16];
+        const auto result = std::to_chars(hash, hash + sizeof(hash), std::hash<std::string>{}(canonical), 16);
+        return base + "/drite/file-index-" + std::string(hash, result.ptr);
+    }
+
+    /**
+     * @brief Index thread body: wait for refresh requests and run them until stopped.
+     */
+    void FileIndex::workerLoop() {
+        for (;;) {
+            std::string root;
+            std::string cachePath;
+            std::shared_ptr<const Image> base;
+            {
+                std::unique_lock lock(m_mutex);
+                m_requestReady.wait(lock, [&] { return m_stopping || m_requested; });
+                if (m_stopping) {
+                    return;
+                }
+                m_requested = false;
+                root = m_root;
+                cachePath = m_cachePath;
+                base = m_baseImage;
+            }
+
+            RefreshResult result = buildImage(root, base.get(), m_stopping);
+            if (m_stopping) {
+                return;
+            }
+            if (result.image && !cachePath.empty()) {
+                static_cast<void>(writeImage(*result.image, cachePath));
+            }
+
+            // A result for a root replaced by open() meanwhile is dropped
+            {
+                std::lock_guard lock(m_mutex);
+                if (root != m_root) {
+                    continue;
+                }
+                if (result.image) {
+                    m_baseImage = result.image;
+                }
+                m_result = std::make_unique<RefreshResult>(std::move(result));
+            }
+            if (m_readyCallback) {
+                m_readyCallback();
+            }
+        }
+    }
+
+    /**
+     * @brief Walk the root, reusing unchanged directories of the previous image.
+     * @param root The directory to index.
+     * @param previous The previous image, or nullptr.
+     * @param stopping Checked between directories; the walk is abandoned once set.
+     * @return The new image and counters; no image if abandoned.
+     */
+    FileIndex::RefreshResult FileIndex::buildImage(const std::string& root, const Image* previous, const std::atomic<bool>& stopping) {
+        DRITE_PROFILE_ZONE("buildFileIndex");
+        const auto startTime = std::chrono::steady_clock::now();
+        RefreshResult result;
+
+        // Directories of the previous image by path, and the subdirectories of each
+        std::unordered_map<std::string_view, uint32_t> previousDirectories;
+        std::unordered_map<std::string_view, std::vector<uint32_t>> previousChildren;
+        if (previous) {
+            previousDirectories.reserve(previous->directoryCount);
+            for (uint32_t directory = 0; directory < previous->directoryCount; ++directory) {
+                const std::string_view path = previous->getDirectory(directory);
+                previousDirectories.emplace(path, directory);
+                if (!path.empty()) {
+                    const size_t slash = path.rfind('/');
+                    previousChildren[slash == std::string_view::npos ? std::string_view() : path.substr(0, slash)].push_back(directory);
+                }
+            }
+        }
+
+        struct PendingDirectory {
+            std::string path;
+            std::shared_ptr<const IgnoreRules> ignore;
+            bool ignoreChanged{false};
+        };
+        std::vector<PendingDirectory> stack;
+        stack.push_back(PendingDirectory{});
+
+        std::vector<uint64_t> masks;
+        std::vector<uint64_t> startMasks;
+        std::vector<uint64_t> nameMasks;
+        std::vector<uint64_t> nameStartMasks;
+        std::vector<uint64_t> pairMasks;
+        std::vector<uint8_t> nameLengths;
+        std::vector<uint32_t> fileOffsets{0};
+        std::vector<DirectoryRecord> directories;
+        std::string filePaths;
+        std::string directoryPaths;
+        std::string scratch;
+
+        const auto addFile = [&](std::string_view path) {
+            const size_t slash = path.rfind('/');
+            const std::string_view name = slash == std::string_view::npos ? path : path.substr(slash + 1);
+            masks.push_back(getCharacterMask(path));
+            startMasks.push_back(getWordStartMask(path));
+            nameMasks.push_back(getCharacterMask(name));
+            nameStartMasks.push_back(getWordStartMask(name));
+            pairMasks.push_back(getPairMask(path));
+            nameLengths.push_back(static_cast<uint8_t>(std::min<size_t>(name.size(), UINT8_MAX)));
+            filePaths += path;
+            fileOffsets.push_back(static_cast<uint32_t>(std::min<size_t>(filePaths.size(), UINT32_MAX)));
+        };
+        const auto copyFile = [&](uint32_t file) {
+            masks.push_back(previous->masks[file]);
+            startMasks.push_back(previous->startMasks[file]);
+            nameMasks.push_back(previous->nameMasks[file]);
+            nameStartMasks.push_back(previous->nameStartMasks[file]);
+            pairMasks.push_back(previous->pairMasks[file]);
+            nameLengths.push_back(previous->nameLengths[file]);
+            filePaths += previous->getFile(file);
+            fileOffsets.push_back(static_cast<uint32_t>(std::min<size_t>(filePaths.size(), UINT32_MAX)));
+        };
+
+        while (!stack.empty()) {
+            if (stopping.load(std::memory_order_relaxed)) {
+                return result;
+            }
+            PendingDirectory pending = std::move(stack.back());
+            stack.pop_back();
+
+            const std::string fullPath = pending.path.empty() ? root : joinPath(root, pending.path);
+            struct stat info{};
+            if (::stat(fullPath.c_str(), &info) != 0 || !S_ISDIR(info.st_mode)) {
+                continue;
+            }
+
+            DirectoryRecord record{};
+            record.modified = getModifiedTime(info);
+            const std::string ignorePath = joinPath(fullPath, ".gitignore");
+            std::shared_ptr<const IgnoreRules> rules = std::move(pending.ignore);
+            if (::stat(ignorePath.c_str(), &info) == 0 && S_ISREG(info.st_mode)) {
+                record.ignoreModified = getModifiedTime(info);
+                if (readFile(ignorePath, scratch)) {
+                    rules = IgnoreRules::parse(scratch, fullPath, std::move(rules));
+                }
+            }
+            record.pathOffset = static_cast<uint32_t>(directoryPaths.size());
+            record.pathLength = static_cast<uint32_t>(pending.path.size());
+            record.firstFile = static_cast<uint32_t>(masks.size());
+            directoryPaths += pending.path;
+
+            // A directory's own time changes when entries are added, removed
+            // or renamed, so an unchanged one can be copied over; rules from
+            // a changed .gitignore above it may hide or reveal entries though
+            const auto found = previousDirectories.find(pending.path);
+            const DirectoryRecord* old = found != previousDirectories.end() ? &previous->directories[found->second] : nullptr;
+            const bool ignoreChanged = pending.ignoreChanged || (old && old->ignoreModified != record.ignoreModified);
+            if (old && !ignoreChanged && old->modified == record.modified) {
+                for (uint32_t file = old->firstFile; file < old->firstFile + old->fileCount; ++file) {
+                    copyFile(file);
+                }
+                if (const auto children = previousChildren.find(pending.path); children != previousChildren.end()) {
+                    for (const uint32_t child : children->second) {
+                        stack.push_back(PendingDirectory{std::string(previous->getDirectory(child)), rules, false});
+                    }
+                }
+                ++result.reusedDirectories;
+            } else if (DIR* directory = ::opendir(fullPath.c_str())) {
+                while (const dirent* entry = ::readdir(directory)) {
+                    const std::string_view name = entry->d_name;
+                    if (name == "." || name == ".." || name == ".git") {
+                        continue;
+                    }
+
+                    std::string path = joinPath(pending.path, name);
+                    const std::string entryPath = joinPath(fullPath, name);
+                    unsigned char type = entry->d_type;
+                    if (type == DT_UNKNOWN) {
+                        if (::lstat(entryPath.c_str(), &info) != 0) {
+                            continue;
+                        }
+                        type = S_ISDIR(info.st_mode) ? DT_DIR : S_ISREG(info.st_mode) ? DT_REG : DT_LNK;
+                    }
+                    if ((type != DT_DIR && type != DT_REG) || (rules && rules->isIgnored(entryPath, type == DT_DIR))) {
+                        continue;
+                    }
+
+                    if (type == DT_DIR) {
+                        stack.push_back(PendingDirectory{std::move(path), rules, ignoreChanged});
+                    } else {
+                        addFile(path);
+                    }
+                }
+                ::closedir(directory);
+                ++result.rescannedDirectories;
+            }
+            record.fileCount = static_cast<uint32_t>(masks.size() - record.firstFile);
+            directories.push_back(record);
+        }
+
+        // Offsets are 32 bits, which holds paths of far more files than a workspace has
+        const uint64_t pathBytes = uint64_t{filePaths.size()} + directoryPaths.size() + root.size();
+        if (pathBytes > UINT32_MAX) {
+            std::println(stderr, "File index of {} is too large", root);
+            return result;
+        }
+        for (DirectoryRecord& record : directories) {
+            record.pathOffset += static_cast<uint32_t>(filePaths.size());
+        }
+
+        Header header{};
+        std::memcpy(header.magic, ImageMagic, sizeof(ImageMagic));
+        header.version = FormatVersion;
+        header.fileCount = static_cast<uint32_t>(masks.size());
+        header.directoryCount = static_cast<uint32_t>(directories.size());
+        header.rootLength = static_cast<uint32_t>(root.size());
+        header.pathBytes = pathBytes;
+
+        const uint64_t count = masks.size();
+        const uint64_t offsetsOffset = sizeof(Header) + MaskSections * count * sizeof(uint64_t);
+        const uint64_t lengthsOffset = offsetsOffset + alignSection((count + 1) * sizeof(uint32_t));
+        const uint64_t directoriesOffset = lengthsOffset + alignSection(count);
+        const uint64_t pathsOffset = directoriesOffset + directories.size() * sizeof(DirectoryRecord);
+
+        auto image = std::make_shared<Image>();
+        image->storage.resize(alignSection(pathsOffset + pathBytes) / sizeof(uint64_t));
+        char* data = reinterpret_cast<char*>(image->storage.data());
+        std::memcpy(data, &header, sizeof(Header));
+        char* maskSections = data + sizeof(Header);
+        for (const std::vector<uint64_t>* section : {&masks, &startMasks, &nameMasks, &nameStartMasks, &pairMasks}) {
+            std::memcpy(maskSections, section->data(), count * sizeof(uint64_t));
+            maskSections += count * sizeof(uint64_t);
+        }
+        std::memcpy(data + offsetsOffset, fileOffsets.data(), fileOffsets.size() * sizeof(uint32_t));
+        std::memcpy(data + lengthsOffset, nameLengths.data(), count);
+        std::memcpy(data + directoriesOffset, directories.data(), directories.size() * sizeof(DirectoryRecord));
+        char* paths = data + pathsOffset;
+        std::memcpy(paths, filePaths.data(), filePaths.size());
+        std::memcpy(paths + filePaths.size(), directoryPaths.data(), directoryPaths.size());
+        std::memcpy(paths + filePaths.size() + directoryPaths.size(), root.data(), root.size());
+
+        if (!image->attach(std::string_view(data, pathsOffset + pathBytes))) {
+            return result;
+        }
+        result.image = std::move(image);
+        result.seconds = getSecondsSince(startTime);
+        return result;
+    }
+
+    /**
+     * @brief Write an image to a file, replacing it atomically.
+     * @param image The image.
+     * @param path The file path.
+     * @return False if the file could not be written.
+     */
+    bool FileIndex::writeImage(const Image& image, const std::string& path) {
+        DRITE_PROFILE_ZONE("writeFileIndex");
+
+        // Parent directories are created as needed, e.g. ~/.cache/drite on first use
+        for (size_t slash = path.find('/', 1); slash != std::string::npos; slash = path.find('/', slash + 1)) {
+            ::mkdir(path.substr(0, slash).c_str(), 0755);
+        }
+
+        // Readers that mapped the old file keep it until they unmap it
+        const std::string temporaryPath = path + ".tmp";
+        const int fd = ::open(temporaryPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (fd < 0) {
+            std::println(stderr, "Failed to write file index {}: {}", temporaryPath, std::strerror(errno));
+            return false;
+        }
+
+        size_t written{0};
+        while (written < image.bytes.size()) {
+            const ssize_t count = ::write(fd, image.bytes.data() + written, image.bytes.size() - written);
+            if (count < 0 && errno == EINTR) {
+                continue;
+            }
+            if (count <= 0) {
+                break;
+            }
+            written += static_cast<size_t>(count);
+        }
+        const bool complete = written == image.bytes.size();
+        const bool closed = ::close(fd) == 0;
+        if (!complete || !closed || ::rename(temporaryPath.c_str(), path.c_str()) != 0) {
+            std::println(stderr, "Failed to write file index {}: {}", path, std::strerror(errno));
+            ::unlink(temporaryPath.c_str());
+            return false;
+        }
+        return true;
+    }
+
+}
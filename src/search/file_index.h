@@ -0,0 +1,353 @@
+#pragma once
+
+#include "io/mapped_file.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace drite {
+
+    /**
+     * @brief A path ranked by FileIndex::find().
+     */
+    struct FileMatch {
+        std::string path;
+        int32_t score{0};
+    };
+
+    /**
+     * @brief Size and timing of a file index.
+     */
+    struct FileIndexStats {
+        size_t files{0};
+        size_t directories{0};
+        size_t rescannedDirectories{0};
+        size_t reusedDirectories{0};
+        double loadSeconds{0.0};
+        double refreshSeconds{0.0};
+        double findSeconds{0.0};
+        size_t candidates{0};
+        size_t scored{0};
+    };
+
+    /**
+     * @brief Index of the file paths below a directory for fuzzy opening by name.
+     *
+     * The index is one flat image: a header, character masks per path, path
+     * offsets, a record per directory and the path bytes. The same image is
+     * kept in memory and written to the cache file, so a cached index is
+     * mapped and usable at startup without parsing.
+     *
+     * Refreshing runs on a background thread and only lists directories whose
+     * modification time or .gitignore changed since the current image;
+     * the files and subdirectories of the others are copied over. The new
+     * image is written to the cache and swapped in by poll().
+     *
+     * Queries first drop paths missing any character of the query by their
+     * masks and bound the score of the rest from the masks. Paths are then
+     * scored with scoreFuzzy() in order of falling bound until no bound can
+     * beat the worst of the best matches. A query extending the previous one
+     * only rescans the previous candidates.
+     */
+    class FileIndex {
+        public:
+            /**
+             * @brief Version of the image format; images of other versions are rebuilt.
+             */
+            static constexpr uint32_t FormatVersion = 2;
+
+            /**
+             * @brief Construct a new File Index object; its thread starts with the first refresh.
+             */
+            FileIndex();
+
+            /**
+             * @brief Destroy the File Index object, stopping its thread.
+             */
+            ~FileIndex();
+
+            /**
+             * @brief Stop the index thread, abandoning a running refresh.
+             */
+            void shutdown();
+
+            FileIndex(const FileIndex&) = delete;
+            FileIndex& operator=(const FileIndex&) = delete;
+
+            /**
+             * @brief Set the function called from the index thread when a refresh finished.
+             * @param callback The callback, e.g. one that wakes the main loop.
+             */
+            void setReadyCallback(std::function<void()> callback) { m_readyCallback = std::move(callback); }
+
+            /**
+             * @brief Load the cached index of a directory and start refreshing it.
+             * @param root The directory to index.
+             * @param cachePath The cache file, or empty for none.
+             * @return True if a cached index was loaded.
+             */
+            bool open(const std::string& root, const std::string& cachePath);
+
+            /**
+             * @brief Start refreshing the index in the background.
+             */
+            void refresh();
+
+            /**
+             * @brief Pick up a finished refresh.
+             * @return True if the index changed.
+             */
+            bool poll();
+
+            /**
+             * @brief Rank the paths matching a fuzzy query.
+             * @param query The query; ASCII case is ignored.
+             * @param limit The number of best matches returned.
+             * @param matches Receives the matches, best first.
+             */
+            void find(std::string_view query, size_t limit, std::vector<FileMatch>& matches);
+
+            /**
+             * @brief Check whether a refresh is running.
+             * @return True from refresh() until poll() picks up its result.
+             */
+            [[nodiscard]] bool isRefreshing() const noexcept { return m_refreshing; }
+
+            /**
+             * @brief Get the indexed directory.
+             * @return The directory, as given to open().
+             */
+            [[nodiscard]] const std::string& getRoot() const noexcept { return m_root; }
+
+            /**
+             * @brief Get the size of the index and the timing of the last load, refresh and find.
+             * @return The stats.
+             */
+            [[nodiscard]] const FileIndexStats& getStats() const noexcept { return m_stats; }
+
+            /**
+             * @brief Get the cache file used for a directory.
+             * @param root The directory.
+             * @return A path below $XDG_CACHE_HOME or ~/.cache, or empty if neither is set.
+             */
+            [[nodiscard]] static std::string getDefaultCachePath(const std::string& root);
+
+        private:
+            /**
+             * @brief Start of an index image.
+             */
+            struct Header {
+                char magic[8];
+                uint32_t version;
+                uint32_t fileCount;
+                uint32_t directoryCount;
+                uint32_t rootLength;
+                uint64_t pathBytes;
+            };
+
+            /**
+             * @brief A listed directory, with its files stored contiguously.
+             */
+            struct DirectoryRecord {
+                int64_t modified;
+                int64_t ignoreModified;
+                uint32_t pathOffset;
+                uint32_t pathLength;
+                uint32_t firstFile;
+                uint32_t fileCount;
+            };
+
+            /**
+             * @brief An immutable index image, owned or mapped.
+             *
+             * Sections, each 8-byte aligned: Header, uint64_t masks[fileCount]
+             * and startMasks[fileCount] of whole paths, uint64_t
+             * nameMasks[fileCount] and nameStartMasks[fileCount] of file
+             * names, uint64_t pairMasks[fileCount] of whole paths, uint32_t
+             * fileOffsets[fileCount + 1], uint8_t nameLengths[fileCount]
+             * capped at 255, DirectoryRecord directories[directoryCount], then
+             * the path bytes: file paths, directory paths and the root. Paths
+             * are relative to the root.
+             */
+            struct Image {
+                std::unique_ptr<MappedFile> mapping;
+                std::vector<uint64_t> storage;
+                std::string_view bytes;
+                const uint64_t* masks{nullptr};
+                const uint64_t* startMasks{nullptr};
+                const uint64_t* nameMasks{nullptr};
+                const uint64_t* nameStartMasks{nullptr};
+                const uint64_t* pairMasks{nullptr};
+                const uint32_t* fileOffsets{nullptr};
+                const uint8_t* nameLengths{nullptr};
+                const DirectoryRecord* directories{nullptr};
+                const char* paths{nullptr};
+                uint32_t fileCount{0};
+                uint32_t directoryCount{0};
+                std::string_view root;
+
+                /**
+                 * @brief Point the sections into an image, checking its bounds.
+                 * @param data The image bytes; must stay valid while attached.
+                 * @return False if the image is malformed or of another version.
+                 */
+                bool attach(std::string_view data);
+
+                /**
+                 * @brief Get a file path.
+                 * @param file The file index.
+                 * @return The path relative to the root.
+                 */
+                [[nodiscard]] std::string_view getFile(uint32_t file) const noexcept {
+                    return std::string_view(paths + fileOffsets[file], fileOffsets[file + 1] - fileOffsets[file]);
+                }
+
+                /**
+                 * @brief Get a directory path.
+                 * @param directory The directory index.
+                 * @return The path relative to the root, empty for the root itself.
+                 */
+                [[nodiscard]] std::string_view getDirectory(uint32_t directory) const noexcept {
+                    return std::string_view(paths + directories[directory].pathOffset, directories[directory].pathLength);
+                }
+            };
+
+            /**
+             * @brief Result of a background refresh.
+             */
+            struct RefreshResult {
+                std::shared_ptr<const Image> image;
+                size_t rescannedDirectories{0};
+                size_t reusedDirectories{0};
+                double seconds{0.0};
+            };
+
+            /**
+             * @brief Index thread body: wait for refresh requests and run them until stopped.
+             */
+            void workerLoop();
+
+            /**
+             * @brief Walk the root, reusing unchanged directories of the previous image.
+             * @param root The directory to index.
+             * @param previous The previous image, or nullptr.
+             * @param stopping Checked between directories; the walk is abandoned once set.
+             * @return The new image and counters; no image if abandoned.
+             */
+            static RefreshResult buildImage(const std::string& root, const Image* previous, const std::atomic<bool>& stopping);
+
+            /**
+             * @brief Write an image to a file, replacing it atomically.
+             * @param image The image.
+             * @param path The file path.
+             * @return False if the file could not be written.
+             */
+            static bool writeImage(const Image& image, const std::string& path);
+
+        private:
+            /**
+             * @brief Called from the index thread when a refresh finished.
+             */
+            std::function<void()> m_readyCallback;
+
+            /**
+             * @brief The index thread, not started until the first refresh.
+             */
+            std::thread m_worker;
+
+            /**
+             * @brief Guards the request and result shared with the index thread.
+             */
+            std::mutex m_mutex;
+
+            /**
+             * @brief Signalled when a refresh is requested or the thread must stop.
+             */
+            std::condition_variable m_requestReady;
+
+            /**
+             * @brief Whether a refresh is requested and not yet started.
+             */
+            bool m_requested{false};
+
+            /**
+             * @brief Whether the thread must stop; written under m_mutex, read by refreshes without it.
+             */
+            std::atomic<bool> m_stopping{false};
+
+            /**
+             * @brief The finished refresh, or nullptr; guarded by m_mutex.
+             */
+            std::unique_ptr<RefreshResult> m_result;
+
+            /**
+             * @brief The image the next refresh starts from; guarded by m_mutex.
+             */
+            std::shared_ptr<const Image> m_baseImage;
+
+            /**
+             * @brief The indexed directory.
+             */
+            std::string m_root;
+
+            /**
+             * @brief The cache file, or empty for none.
+             */
+            std::string m_cachePath;
+
+            /**
+             * @brief The image queries run on.
+             */
+            std::shared_ptr<const Image> m_image;
+
+            /**
+             * @brief Whether a refresh is running, as seen by the UI thread.
+             */
+            bool m_refreshing{false};
+
+            /**
+             * @brief The lower case query of the last find().
+             */
+            std::string m_lastQuery;
+
+            /**
+             * @brief Files holding every character of the last query, for narrowing when it is extended.
+             */
+            std::vector<uint32_t> m_candidates;
+
+            /**
+             * @brief Whether m_candidates belongs to m_lastQuery on the current image.
+             */
+            bool m_candidatesValid{false};
+
+            /**
+             * @brief Scratch storage for the candidates of the next query.
+             */
+            std::vector<uint32_t> m_nextCandidates;
+
+            /**
+             * @brief Scratch storage for the score bounds of the next candidates.
+             */
+            std::vector<int32_t> m_bounds;
+
+            /**
+             * @brief Scratch storage for the candidates in order of falling bound.
+             */
+            std::vector<uint32_t> m_order;
+
+            /**
+             * @brief Size and timing of the index.
+             */
+            FileIndexStats m_stats;
+    };
+
+}
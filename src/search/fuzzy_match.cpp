@@ -0,0 +1,617 @@
+#include "search/fuzzy_match.h"
+#include "core/cpu_features.h"
+#include <algorithm>
+#include <array>
+
+#if DRITE_CPU_X86
+#include <immintrin.h>
+#elif DRITE_CPU_NEON
+#include <arm_neon.h>
+#endif
+
+namespace drite {
+
+    /**
+     * @brief Score of each matched character.
+     */
+    static constexpr int32_t ScoreMatch = 16;
+
+    /**
+     * @brief Bonus for a character starting a path segment.
+     */
+    static constexpr int32_t BonusSegmentStart = 10;
+
+    /**
+     * @brief Bonus for a character starting a word after punctuation or a lower to upper case change.
+     */
+    static constexpr int32_t BonusWordStart = 8;
+
+    /**
+     * @brief Bonus for a character right after the previous matched one.
+     */
+    static constexpr int32_t BonusAdjacent = 6;
+
+    /**
+     * @brief Bonus for a query matched inside the file name.
+     */
+    static constexpr int32_t BonusFileName = 48;
+
+    /**
+     * @brief Penalty for a gap between matched characters, plus one per skipped character.
+     */
+    static constexpr int32_t PenaltyGapStart = 3;
+
+    /**
+     * @brief Largest penalty of a single gap.
+     */
+    static constexpr int32_t PenaltyGapMax = 12;
+
+    /**
+     * @brief Build the table mapping each byte to its character mask bit.
+     * @return The bit index of every byte value.
+     */
+    static constexpr std::array<uint8_t, 256> makeMaskBits() noexcept {
+        std::array<uint8_t, 256> bits{};
+        for (unsigned byte = 0; byte < 256; ++byte) {
+            // Bytes without a bit of their own share the 22 bits left below the live bit
+            bits[byte] = static_cast<uint8_t>(41 + byte % 22);
+        }
+        for (unsigned letter = 0; letter < 26; ++letter) {
+            bits['a' + letter] = static_cast<uint8_t>(letter);
+            bits['A' + letter] = static_cast<uint8_t>(letter);
+        }
+        for (unsigned digit = 0; digit < 10; ++digit) {
+            bits['0' + digit] = static_cast<uint8_t>(26 + digit);
+        }
+        bits['_'] = 36;
+        bits['-'] = 37;
+        bits['.'] = 38;
+        bits['/'] = 39;
+        bits[' '] = 40;
+        return bits;
+    }
+
+    /**
+     * @brief Character mask bit of every byte value.
+     */
+    static constexpr std::array<uint8_t, 256> MaskBits = makeMaskBits();
+
+    /**
+     * @brief Get the penalty breaking ties between equal matches.
+     * @param pathLength The length of the path.
+     * @param nameLength The length of the file name.
+     * @return The penalty, larger for longer names and deeper paths.
+     */
+    static int32_t getLengthPenalty(size_t pathLength, size_t nameLength) noexcept {
+        return static_cast<int32_t>(std::min<size_t>(nameLength, 64) / 2 + std::min<size_t>(pathLength, 256) / 16);
+    }
+
+    /**
+     * @brief Number of query character multiplicities a score bound tells apart.
+     */
+    static constexpr size_t MaxBoundLayers = 4;
+
+    /**
+     * @brief Bits counted with the multiplicity of a query.
+     *
+     * Layer k holds the bits occurring more than k times in the query, so
+     * summing the bits of a mask found in every layer counts the query
+     * occurrences the mask holds. The last layer is weighted for all higher
+     * multiplicities.
+     */
+    struct LayeredBits {
+        std::array<uint64_t, MaxBoundLayers> layers{};
+        size_t layerCount{0};
+        int32_t lastLayerWeight{1};
+    };
+
+    /**
+     * @brief A query prepared for computing score bounds.
+     */
+    struct BoundQuery {
+        uint64_t required{0};
+        uint64_t queryMask{0};
+        LayeredBits starts;
+        LayeredBits pairs;
+        int32_t length{0};
+    };
+
+    /**
+     * @brief Kernel entry points selected once per process.
+     */
+    struct MaskFilterKernels {
+        size_t (*filter)(const uint64_t*, size_t, uint64_t, uint32_t*) noexcept;
+        void (*bound)(const BoundQuery&, const FuzzyPathTable&, const uint32_t*, size_t, int32_t*) noexcept;
+        const char* name;
+    };
+
+    /**
+     * @brief Get the set of character classes occurring in a text.
+     * @param text The text.
+     * @return The mask, with LiveMaskBit set.
+     */
+    uint64_t getCharacterMask(std::string_view text) noexcept {
+        uint64_t mask{LiveMaskBit};
+        for (const char character : text) {
+            mask |= uint64_t{1} << MaskBits[static_cast<uint8_t>(character)];
+        }
+        return mask;
+    }
+
+    /**
+     * @brief Check whether a character starts a word.
+     * @param before The preceding character, '/' at the start of the text.
+     * @param character The character.
+     * @return True if scoreFuzzy() awards a start bonus for the character.
+     */
+    static bool isWordStart(char before, char character) noexcept {
+        return before == '/' || before == '_' || before == '-' || before == '.' || before == ' ' ||
+               (before >= 'a' && before <= 'z' && character >= 'A' && character <= 'Z');
+    }
+
+    /**
+     * @brief Get the set of character classes starting a word in a text.
+     * @param text The text.
+     * @return The mask, without LiveMaskBit.
+     */
+    uint64_t getWordStartMask(std::string_view text) noexcept {
+        uint64_t mask{0};
+        char before{'/'};
+        for (const char character : text) {
+            if (isWordStart(before, character)) {
+                mask |= uint64_t{1} << MaskBits[static_cast<uint8_t>(character)];
+            }
+            before = character;
+        }
+        return mask;
+    }
+
+    /**
+     * @brief Get the pair mask bit of two adjacent character classes.
+     * @param first The bit index of the first character.
+     * @param second The bit index of the second character.
+     * @return The bit index of the pair.
+     */
+    static unsigned getPairBit(uint8_t first, uint8_t second) noexcept {
+        return static_cast<unsigned>(((uint64_t{first} << 6 | second) * 0x9E3779B97F4A7C15) >> 58);
+    }
+
+    /**
+     * @brief Get the set of adjacent character class pairs in a text, hashed to 64 bits.
+     * @param text The text.
+     * @return The mask.
+     */
+    uint64_t getPairMask(std::string_view text) noexcept {
+        uint64_t mask{0};
+        for (size_t i = 1; i < text.size(); ++i) {
+            mask |= uint64_t{1} << getPairBit(MaskBits[static_cast<uint8_t>(text[i - 1])], MaskBits[static_cast<uint8_t>(text[i])]);
+        }
+        return mask;
+    }
+
+    /**
+     * @brief Collect the indices of masks holding every required bit, one mask at a time.
+     * @param masks The masks.
+     * @param count The number of masks.
+     * @param required The bits that must be set.
+     * @param indices Receives the passing indices.
+     * @return The number of passing indices.
+     */
+    static size_t filterScalar(const uint64_t* masks, size_t count, uint64_t required, uint32_t* indices) noexcept {
+        // Every index is written and only passing ones are kept, so there is no branch to mispredict
+        size_t found{0};
+        for (size_t i = 0; i < count; ++i) {
+            indices[found] = static_cast<uint32_t>(i);
+            found += (masks[i] & required) == required;
+        }
+        return found;
+    }
+
+    /**
+     * @brief Append the indices of the set bits of a compare mask.
+     * @param bits The compare mask, one bit per mask.
+     * @param base The index of the first mask.
+     * @param indices The output array.
+     * @param found The number of indices written so far; advanced.
+     */
+    [[maybe_unused]] static void appendSetBits(unsigned bits, size_t base, uint32_t* indices, size_t& found) noexcept {
+        while (bits) {
+            indices[found++] = static_cast<uint32_t>(base + static_cast<size_t>(__builtin_ctz(bits)));
+            bits &= bits - 1;
+        }
+    }
+
+#if DRITE_CPU_X86
+
+    /**
+     * @brief Collect the indices of masks holding every required bit, two masks at a time with SSE2.
+     *
+     * SSE2 has no 64-bit compare, so both 32-bit halves are compared and the
+     * results of each pair combined.
+     *
+     * @param masks The masks.
+     * @param count The number of masks.
+     * @param required The bits that must be set.
+     * @param indices Receives the passing indices.
+     * @return The number of passing indices.
+     */
+    static size_t filterSse2(const uint64_t* masks, size_t count, uint64_t required, uint32_t* indices) noexcept {
+        const __m128i wanted = _mm_set1_epi64x(static_cast<long long>(required));
+        size_t found{0};
+        size_t i{0};
+
+        for (; count - i >= 2; i += 2) {
+            const __m128i values = _mm_loadu_si128(reinterpret_cast<const __m128i*>(masks + i));
+            const __m128i halves = _mm_cmpeq_epi32(_mm_and_si128(values, wanted), wanted);
+            const __m128i equal = _mm_and_si128(halves, _mm_shuffle_epi32(halves, _MM_SHUFFLE(2, 3, 0, 1)));
+            appendSetBits(static_cast<unsigned>(_mm_movemask_pd(_mm_castsi128_pd(equal))), i, indices, found);
+        }
+
+        const size_t tail = filterScalar(masks + i, count - i, required, indices + found);
+        for (size_t j = 0; j < tail; ++j) {
+            indices[found + j] += static_cast<uint32_t>(i);
+        }
+        return found + tail;
+    }
+
+    /**
+     * @brief Collect the indices of masks holding every required bit, eight masks at a time with AVX2.
+     * @param masks The masks.
+     * @param count The number of masks.
+     * @param required The bits that must be set.
+     * @param indices Receives the passing indices.
+     * @return The number of passing indices.
+     */
+    __attribute__((target("avx2")))
+    static size_t filterAvx2(const uint64_t* masks, size_t count, uint64_t required, uint32_t* indices) noexcept {
+        const __m256i wanted = _mm256_set1_epi64x(static_cast<long long>(required));
+        size_t found{0};
+        size_t i{0};
+
+        for (; count - i >= 8; i += 8) {
+            const __m256i low = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(masks + i));
+            const __m256i high = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(masks + i + 4));
+            const __m256i equalLow = _mm256_cmpeq_epi64(_mm256_and_si256(low, wanted), wanted);
+            const __m256i equalHigh = _mm256_cmpeq_epi64(_mm256_and_si256(high, wanted), wanted);
+            const auto bits = static_cast<unsigned>(_mm256_movemask_pd(_mm256_castsi256_pd(equalLow))) |
+                              static_cast<unsigned>(_mm256_movemask_pd(_mm256_castsi256_pd(equalHigh))) << 4;
+            appendSetBits(bits, i, indices, found);
+        }
+
+        const size_t tail = filterScalar(masks + i, count - i, required, indices + found);
+        for (size_t j = 0; j < tail; ++j) {
+            indices[found + j] += static_cast<uint32_t>(i);
+        }
+        return found + tail;
+    }
+
+#elif DRITE_CPU_NEON
+
+    /**
+     * @brief Collect the indices of masks holding every required bit, two masks at a time with NEON.
+     * @param masks The masks.
+     * @param count The number of masks.
+     * @param required The bits that must be set.
+     * @param indices Receives the passing indices.
+     * @return The number of passing indices.
+     */
+    static size_t filterNeon(const uint64_t* masks, size_t count, uint64_t required, uint32_t* indices) noexcept {
+        const uint64x2_t wanted = vdupq_n_u64(required);
+        size_t found{0};
+        size_t i{0};
+
+        for (; count - i >= 2; i += 2) {
+            const uint64x2_t equal = vceqq_u64(vandq_u64(vld1q_u64(masks + i), wanted), wanted);
+            const unsigned bits = static_cast<unsigned>(vgetq_lane_u64(equal, 0) & 1) | static_cast<unsigned>(vgetq_lane_u64(equal, 1) & 1) << 1;
+            appendSetBits(bits, i, indices, found);
+        }
+
+        const size_t tail = filterScalar(masks + i, count - i, required, indices + found);
+        for (size_t j = 0; j < tail; ++j) {
+            indices[found + j] += static_cast<uint32_t>(i);
+        }
+        return found + tail;
+    }
+
+#endif
+
+    /**
+     * @brief Count the query occurrences of the bits set in a mask.
+     * @param bits The layered query bits.
+     * @param mask The mask.
+     * @return The count.
+     */
+    __attribute__((always_inline))
+    static inline int32_t countLayered(const LayeredBits& bits, uint64_t mask) noexcept {
+        int32_t count{0};
+        for (size_t layer = 0; layer < bits.layerCount; ++layer) {
+            const int32_t weight = layer + 1 == bits.layerCount ? bits.lastLayerWeight : 1;
+            count += weight * __builtin_popcountll(mask & bits.layers[layer]);
+        }
+        return count;
+    }
+
+    /**
+     * @brief Compute the score bounds of paths known to hold every query character.
+     * @param query The prepared query.
+     * @param table The masks of the paths.
+     * @param indices The paths.
+     * @param count The number of paths.
+     * @param bounds Receives the bound of each path.
+     */
+    __attribute__((always_inline))
+    static inline void computeBounds(const BoundQuery& query, const FuzzyPathTable& table, const uint32_t* indices, size_t count,
+                                     int32_t* bounds) noexcept {
+        for (size_t i = 0; i < count; ++i) {
+            const uint32_t path = indices[i];
+
+            // Characters whose pair is missing are at least one apart, which
+            // costs the smallest gap penalty instead of earning the bonus
+            const int32_t adjacent = countLayered(query.pairs, table.pairMasks[path]);
+            const int32_t separated = std::max(query.length - 1, 0) - adjacent;
+            const int32_t matched = query.length * ScoreMatch + adjacent * BonusAdjacent - separated * (PenaltyGapStart + 1);
+
+            int32_t bound = matched + countLayered(query.starts, table.startMasks[path]) * BonusSegmentStart;
+            if ((table.nameMasks[path] & query.queryMask) == query.queryMask) {
+                bound = std::max(bound, BonusFileName + matched + countLayered(query.starts, table.nameStartMasks[path]) * BonusSegmentStart);
+            }
+            bounds[i] = bound - getLengthPenalty(table.offsets[path + 1] - table.offsets[path], table.nameLengths[path]);
+        }
+    }
+
+    /**
+     * @brief Compute score bounds, counting bits portably.
+     * @param query The prepared query.
+     * @param table The masks of the paths.
+     * @param indices The paths.
+     * @param count The number of paths.
+     * @param bounds Receives the bound of each path.
+     */
+    static void boundPortable(const BoundQuery& query, const FuzzyPathTable& table, const uint32_t* indices, size_t count,
+                              int32_t* bounds) noexcept {
+        computeBounds(query, table, indices, count, bounds);
+    }
+
+#if DRITE_CPU_X86
+
+    /**
+     * @brief Compute score bounds, counting bits with the POPCNT instruction.
+     *
+     * Without it every count is a library call, which costs more than the
+     * rest of the bound.
+     *
+     * @param query The prepared query.
+     * @param table The masks of the paths.
+     * @param indices The paths.
+     * @param count The number of paths.
+     * @param bounds Receives the bound of each path.
+     */
+    __attribute__((target("popcnt")))
+    static void boundPopcnt(const BoundQuery& query, const FuzzyPathTable& table, const uint32_t* indices, size_t count,
+                            int32_t* bounds) noexcept {
+        computeBounds(query, table, indices, count, bounds);
+    }
+
+#endif
+
+    /**
+     * @brief Pick the widest kernel the running CPU supports.
+     * @param cpu The features of the running CPU.
+     * @return The selected kernels.
+     */
+    static MaskFilterKernels selectKernels([[maybe_unused]] const CpuFeatures& cpu) noexcept {
+#if DRITE_CPU_X86
+        const auto bound = cpu.popcnt ? boundPopcnt : boundPortable;
+        if (cpu.avx2) {
+            return MaskFilterKernels{filterAvx2, bound, "avx2"};
+        }
+        return MaskFilterKernels{filterSse2, bound, "sse2"};
+#elif DRITE_CPU_NEON
+        return MaskFilterKernels{filterNeon, boundPortable, "neon"};
+#else
+        return MaskFilterKernels{filterScalar, boundPortable, "scalar"};
+#endif
+    }
+
+    /**
+     * @brief Get the kernels selected for this process.
+     * @return The selected kernels.
+     */
+    static const MaskFilterKernels& getKernels() noexcept {
+        return getKernelTable(selectKernels);
+    }
+
+    /**
+     * @brief Collect the indices of masks holding every required bit.
+     * @param masks The masks.
+     * @param count The number of masks.
+     * @param required The bits that must be set.
+     * @param indices Receives the passing indices, in order; must hold count entries.
+     * @return The number of passing indices.
+     */
+    size_t filterByMask(const uint64_t* masks, size_t count, uint64_t required, uint32_t* indices) noexcept {
+        return getKernels().filter(masks, count, required, indices);
+    }
+
+    /**
+     * @brief Get the name of the mask filter kernel selected for this CPU.
+     * @return The kernel name, e.g. "avx2".
+     */
+    const char* getMaskFilterName() noexcept {
+        return getKernels().name;
+    }
+
+    /**
+     * @brief Fold an ASCII letter to lower case.
+     * @param character The character.
+     * @return The folded character.
+     */
+    static char foldCase(char character) noexcept {
+        return character >= 'A' && character <= 'Z' ? static_cast<char>(character | 0x20) : character;
+    }
+
+    /**
+     * @brief Find the end of the first occurrence of a query as a subsequence.
+     * @param path The path.
+     * @param begin The offset to search from.
+     * @param query The lower case query.
+     * @return The offset after the last matched character, or 0 if the query does not occur.
+     */
+    static size_t findSubsequenceEnd(std::string_view path, size_t begin, std::string_view query) noexcept {
+        size_t matched{0};
+        for (size_t i = begin; i < path.size(); ++i) {
+            if (foldCase(path[i]) == query[matched] && ++matched == query.size()) {
+                return i + 1;
+            }
+        }
+        return 0;
+    }
+
+    /**
+     * @brief Score the shortest window ending at a match end that holds a query.
+     * @param path The path.
+     * @param end The offset after the last matched character.
+     * @param query The lower case query.
+     * @return The score of the window.
+     */
+    static int32_t scoreWindow(std::string_view path, size_t end, std::string_view query) noexcept {
+        // Walking back from the end finds the latest start, so a scattered
+        // early occurrence does not hide a tight one near the end
+        size_t start{end};
+        for (size_t remaining = query.size(); remaining > 0;) {
+            --start;
+            if (foldCase(path[start]) == query[remaining - 1]) {
+                --remaining;
+            }
+        }
+
+        int32_t score{0};
+        size_t matched{0};
+        size_t previous{start};
+        for (size_t i = start; i < end && matched < query.size(); ++i) {
+            const char character = path[i];
+            if (foldCase(character) != query[matched]) {
+                continue;
+            }
+
+            score += ScoreMatch;
+            const char before = i > 0 ? path[i - 1] : '/';
+            if (before == '/') {
+                score += BonusSegmentStart;
+            } else if (isWordStart(before, character)) {
+                score += BonusWordStart;
+            }
+            if (matched > 0) {
+                const auto gap = static_cast<int32_t>(std::min<size_t>(i - previous - 1, PenaltyGapMax));
+                score += gap == 0 ? BonusAdjacent : -std::min(PenaltyGapStart + gap, PenaltyGapMax);
+            }
+            previous = i;
+            ++matched;
+        }
+        return score;
+    }
+
+    /**
+     * @brief Score a path against a fuzzy query.
+     * @param path The path.
+     * @param query The query, already in lower case.
+     * @return The score, higher is better, or NoFuzzyMatch.
+     */
+    int32_t scoreFuzzy(std::string_view path, std::string_view query) noexcept {
+        const size_t slash = path.rfind('/');
+        const size_t name = slash == std::string_view::npos ? 0 : slash + 1;
+
+        const int32_t lengthPenalty = getLengthPenalty(path.size(), path.size() - name);
+        if (query.empty()) {
+            return -lengthPenalty;
+        }
+
+        // The file name is short, so trying it first is cheap and usually the
+        // only scan needed
+        if (query.size() <= path.size() - name) {
+            if (const size_t end = findSubsequenceEnd(path, name, query)) {
+                return BonusFileName + scoreWindow(path, end, query) - lengthPenalty;
+            }
+        }
+        const size_t end = findSubsequenceEnd(path, 0, query);
+        if (end == 0) {
+            return NoFuzzyMatch;
+        }
+        return scoreWindow(path, end, query) - lengthPenalty;
+    }
+
+    /**
+     * @brief Layer bits by how often a query holds them.
+     * @param counts The number of occurrences of every bit.
+     * @return The layered bits.
+     */
+    static LayeredBits makeLayeredBits(const std::array<uint32_t, 64>& counts) noexcept {
+        LayeredBits bits;
+        size_t highest{0};
+        for (size_t bit = 0; bit < counts.size(); ++bit) {
+            highest = std::max<size_t>(highest, counts[bit]);
+            for (size_t layer = 0; layer < std::min<size_t>(counts[bit], MaxBoundLayers); ++layer) {
+                bits.layers[layer] |= uint64_t{1} << bit;
+            }
+        }
+        bits.layerCount = std::min(highest, MaxBoundLayers);
+        bits.lastLayerWeight = static_cast<int32_t>(highest - bits.layerCount + 1);
+        return bits;
+    }
+
+    /**
+     * @brief Prepare a query for computing score bounds.
+     * @param query The query, already in lower case.
+     * @return The prepared query.
+     */
+    static BoundQuery prepareBoundQuery(std::string_view query) noexcept {
+        BoundQuery prepared;
+        prepared.required = getCharacterMask(query);
+        prepared.queryMask = prepared.required & ~LiveMaskBit;
+        prepared.length = static_cast<int32_t>(query.size());
+
+        std::array<uint32_t, 64> starts{};
+        std::array<uint32_t, 64> pairs{};
+        for (size_t i = 0; i < query.size(); ++i) {
+            const uint8_t bit = MaskBits[static_cast<uint8_t>(query[i])];
+            ++starts[bit];
+            if (i > 0) {
+                ++pairs[getPairBit(MaskBits[static_cast<uint8_t>(query[i - 1])], bit)];
+            }
+        }
+        prepared.starts = makeLayeredBits(starts);
+        prepared.pairs = makeLayeredBits(pairs);
+        return prepared;
+    }
+
+    /**
+     * @brief Collect the paths holding every character of a query, with an upper bound of their scoreFuzzy().
+     * @param query The query, already in lower case.
+     * @param table The masks of the paths; offsets holds one entry more than there are paths.
+     * @param subset The paths to test, or nullptr for the first count paths.
+     * @param count The number of paths to test.
+     * @param indices Receives the passing paths, in order; must hold count entries.
+     * @param bounds Receives the bound of each passing path; must hold count entries.
+     * @return The number of passing paths.
+     */
+    size_t boundFuzzyMatches(std::string_view query, const FuzzyPathTable& table, const uint32_t* subset, size_t count,
+                             uint32_t* indices, int32_t* bounds) noexcept {
+        const BoundQuery prepared = prepareBoundQuery(query);
+        const MaskFilterKernels& kernels = getKernels();
+
+        size_t found{0};
+        if (subset) {
+            // Written branchless like filterScalar(); subset may be indices itself
+            for (size_t i = 0; i < count; ++i) {
+                const uint32_t path = subset[i];
+                indices[found] = path;
+                found += (table.masks[path] & prepared.required) == prepared.required;
+            }
+        } else {
+            found = kernels.filter(table.masks, count, prepared.required, indices);
+        }
+        kernels.bound(prepared, table, indices, found, bounds);
+        return found;
+    }
+
+}
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace drite {
+
+    /**
+     * @brief Score returned by scoreFuzzy() for text not matching the query.
+     */
+    inline constexpr int32_t NoFuzzyMatch = INT32_MIN;
+
+    /**
+     * @brief Bit of a character mask set for every live entry.
+     *
+     * Queries require it too, so entries with a cleared mask never pass
+     * filterByMask().
+     */
+    inline constexpr uint64_t LiveMaskBit = uint64_t{1} << 63;
+
+    /**
+     * @brief Get the set of character classes occurring in a text.
+     *
+     * ASCII letters are folded to lower case and digits, letters and common
+     * path punctuation get a bit each; other bytes share the remaining bits.
+     * Text holding a query as a subsequence holds all of its bits, so masks
+     * reject most non-matches before any text is read.
+     *
+     * @param text The text.
+     * @return The mask, with LiveMaskBit set.
+     */
+    [[nodiscard]] uint64_t getCharacterMask(std::string_view text) noexcept;
+
+    /**
+     * @brief Get the set of character classes starting a word in a text.
+     *
+     * A word starts at the beginning, after a slash or punctuation, and at a
+     * change from lower to upper case, where scoreFuzzy() awards a bonus.
+     *
+     * @param text The text.
+     * @return The mask, without LiveMaskBit.
+     */
+    [[nodiscard]] uint64_t getWordStartMask(std::string_view text) noexcept;
+
+    /**
+     * @brief Get the set of adjacent character class pairs in a text, hashed to 64 bits.
+     *
+     * A query character can only follow the previous one directly if the
+     * text holds their pair, which bounds the adjacency bonus of scoreFuzzy().
+     *
+     * @param text The text.
+     * @return The mask.
+     */
+    [[nodiscard]] uint64_t getPairMask(std::string_view text) noexcept;
+
+    /**
+     * @brief Collect the indices of masks holding every required bit.
+     *
+     * Compares a whole vector of masks at once, using the widest kernel
+     * supported by the running CPU (AVX2 or SSE2 on x86-64, NEON on ARM64).
+     *
+     * @param masks The masks.
+     * @param count The number of masks.
+     * @param required The bits that must be set.
+     * @param indices Receives the passing indices, in order; must hold count entries.
+     * @return The number of passing indices.
+     */
+    [[nodiscard]] size_t filterByMask(const uint64_t* masks, size_t count, uint64_t required, uint32_t* indices) noexcept;
+
+    /**
+     * @brief Get the name of the mask filter kernel selected for this CPU.
+     * @return The kernel name, e.g. "avx2".
+     */
+    [[nodiscard]] const char* getMaskFilterName() noexcept;
+
+    /**
+     * @brief Score a path against a fuzzy query.
+     *
+     * The query matches if its characters occur in the path in order,
+     * ignoring ASCII case. Matches inside the file name rank above matches
+     * spread over directories; within either, the shortest window holding the
+     * query is scored, rewarding characters at word starts and runs of
+     * adjacent characters and penalizing gaps and long paths.
+     *
+     * @param path The path.
+     * @param query The query, already in lower case.
+     * @return The score, higher is better, or NoFuzzyMatch.
+     */
+    [[nodiscard]] int32_t scoreFuzzy(std::string_view path, std::string_view query) noexcept;
+
+    /**
+     * @brief Masks and lengths of a set of paths, as parallel arrays indexed by path.
+     */
+    struct FuzzyPathTable {
+        const uint64_t* masks{nullptr};
+        const uint64_t* startMasks{nullptr};
+        const uint64_t* nameMasks{nullptr};
+        const uint64_t* nameStartMasks{nullptr};
+        const uint64_t* pairMasks{nullptr};
+        const uint32_t* offsets{nullptr};
+        const uint8_t* nameLengths{nullptr};
+    };
+
+    /**
+     * @brief Collect the paths holding every character of a query, with an upper bound of their scoreFuzzy().
+     *
+     * The bound is computed from the masks alone, assuming every character
+     * follows the previous one directly where the path holds their pair and
+     * starts a word where its class does.
+     * Ranking keeps the best few scores, so paths whose bound is below the
+     * worst kept score need not be read.
+     *
+     * @param query The query, already in lower case.
+     * @param table The masks of the paths; offsets holds one entry more than there are paths.
+     * @param subset The paths to test, or nullptr for the first count paths.
+     * @param count The number of paths to test.
+     * @param indices Receives the passing paths, in order; must hold count entries.
+     * @param bounds Receives the bound of each passing path; must hold count entries.
+     * @return The number of passing paths.
+     */
+    [[nodiscard]] size_t boundFuzzyMatches(std::string_view query, const FuzzyPathTable& table, const uint32_t* subset, size_t count,
+                                           uint32_t* indices, int32_t* bounds) noexcept;
+
+}
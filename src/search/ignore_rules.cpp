@@ -0,0 +1,217 @@
+#include "search/ignore_rules.h"
+
+namespace drite {
+
+    /**
+     * @brief Match one bracket expression against a character.
+     * @param pattern The pattern, starting just after the opening '['; advanced past the closing ']'.
+     * @param character The character.
+     * @param matched Receives whether the character is in the set.
+     * @return False if the expression is not terminated.
+     */
+    static bool matchClass(std::string_view& pattern, char character, bool& matched) {
+        const bool negated = !pattern.empty() && (pattern[0] == '!' || pattern[0] == '^');
+        if (negated) {
+            pattern.remove_prefix(1);
+        }
+
+        matched = false;
+        bool first{true};
+        while (!pattern.empty() && (pattern[0] != ']' || first)) {
+            first = false;
+            char low = pattern[0];
+            if (low == '\\' && pattern.size() > 1) {
+                pattern.remove_prefix(1);
+                low = pattern[0];
+            }
+            pattern.remove_prefix(1);
+
+            char high = low;
+            if (pattern.size() > 1 && pattern[0] == '-' && pattern[1] != ']') {
+                high = pattern[1];
+                pattern.remove_prefix(2);
+            }
+            matched = matched || (character >= low && character <= high);
+        }
+        if (pattern.empty()) {
+            return false;
+        }
+
+        pattern.remove_prefix(1);
+        matched = matched != negated;
+        return true;
+    }
+
+    /**
+     * @brief Match a path against a gitignore glob.
+     * @param pattern The glob; "*" and "?" stop at "/", "**" does not.
+     * @param path The path.
+     * @return True if the whole path matches.
+     */
+    bool IgnoreRules::matchGlob(std::string_view pattern, std::string_view path) {
+        while (!pattern.empty()) {
+            if (pattern.starts_with("**")) {
+                pattern.remove_prefix(2);
+
+                // "**/" matches zero or more whole directories
+                if (pattern.starts_with('/')) {
+                    pattern.remove_prefix(1);
+                    for (size_t start{0};;) {
+                        if (matchGlob(pattern, path.substr(start))) {
+                            return true;
+                        }
+                        start = path.find('/', start);
+                        if (start == std::string_view::npos) {
+                            return false;
+                        }
+                        ++start;
+                    }
+                }
+
+                for (size_t start = 0; start <= path.size(); ++start) {
+                    if (matchGlob(pattern, path.substr(start))) {
+                        return true;
+                    }
+                }
+                return false;
+            }
+
+            if (pattern[0] == '*') {
+                pattern.remove_prefix(1);
+                for (size_t start = 0; start <= path.size(); ++start) {
+                    if (matchGlob(pattern, path.substr(start))) {
+                        return true;
+                    }
+                    if (start < path.size() && path[start] == '/') {
+                        return false;
+                    }
+                }
+                return false;
+            }
+
+            if (path.empty()) {
+                return false;
+            }
+
+            const char character = path[0];
+            if (pattern[0] == '?') {
+                if (character == '/') {
+                    return false;
+                }
+                pattern.remove_prefix(1);
+            } else if (pattern[0] == '[') {
+                std::string_view rest = pattern.substr(1);
+                bool matched{false};
+                if (matchClass(rest, character, matched)) {
+                    if (!matched || character == '/') {
+                        return false;
+                    }
+                    pattern = rest;
+                } else if (character != '[') {
+                    return false;
+                } else {
+                    pattern.remove_prefix(1);
+                }
+            } else {
+                if (pattern[0] == '\\' && pattern.size() > 1) {
+                    pattern.remove_prefix(1);
+                }
+                if (pattern[0] != character) {
+                    return false;
+                }
+                pattern.remove_prefix(1);
+            }
+            path.remove_prefix(1);
+        }
+        return path.empty();
+    }
+
+    /**
+     * @brief Parse the contents of a .gitignore file.
+     * @param text The file contents.
+     * @param directory The path of the directory holding the file, as walked.
+     * @param parent The rules of the enclosing directories, or nullptr.
+     * @return The rules, or parent if the file holds no patterns.
+     */
+    std::shared_ptr<const IgnoreRules> IgnoreRules::parse(std::string_view text, std::string directory,
+                                                          std::shared_ptr<const IgnoreRules> parent) {
+        auto rules = std::make_shared<IgnoreRules>();
+        while (!text.empty()) {
+            const size_t lineFeed = text.find('\n');
+            std::string_view line = text.substr(0, lineFeed);
+            text.remove_prefix(lineFeed == std::string_view::npos ? text.size() : lineFeed + 1);
+
+            // Trailing spaces are dropped unless escaped
+            if (line.ends_with('\r')) {
+                line.remove_suffix(1);
+            }
+            while (line.ends_with(' ') && !line.ends_with("\\ ")) {
+                line.remove_suffix(1);
+            }
+            if (line.empty() || line[0] == '#') {
+                continue;
+            }
+
+            Pattern pattern;
+            if (line[0] == '!') {
+                pattern.negated = true;
+                line.remove_prefix(1);
+            } else if (line.starts_with("\\!") || line.starts_with("\\#")) {
+                line.remove_prefix(1);
+            }
+            if (line.ends_with('/')) {
+                pattern.directoryOnly = true;
+                line.remove_suffix(1);
+            }
+
+            // A slash anywhere but the end ties the pattern to this directory
+            pattern.anchored = line.find('/') != std::string_view::npos;
+            if (line.starts_with('/')) {
+                line.remove_prefix(1);
+            }
+            if (line.empty()) {
+                continue;
+            }
+            pattern.glob = line;
+            rules->m_patterns.push_back(std::move(pattern));
+        }
+
+        if (rules->m_patterns.empty()) {
+            return parent;
+        }
+        rules->m_directory = std::move(directory);
+        rules->m_parent = std::move(parent);
+        return rules;
+    }
+
+    /**
+     * @brief Check whether a path below the directory of these rules is ignored.
+     * @param path The path as walked, starting with the directory of these rules.
+     * @param directory Whether the path is a directory.
+     * @return True if the path is ignored.
+     */
+    bool IgnoreRules::isIgnored(std::string_view path, bool directory) const {
+        const size_t slash = path.rfind('/');
+        const std::string_view name = slash == std::string_view::npos ? path : path.substr(slash + 1);
+
+        for (const IgnoreRules* rules = this; rules; rules = rules->m_parent.get()) {
+            const std::string_view base = rules->m_directory;
+            const size_t prefix = base.ends_with('/') ? base.size() : base.size() + 1;
+            if (path.size() <= prefix || !path.starts_with(base) || path[prefix - 1] != '/') {
+                continue;
+            }
+
+            const std::string_view relative = path.substr(prefix);
+            for (auto pattern = rules->m_patterns.rbegin(); pattern != rules->m_patterns.rend(); ++pattern) {
+                if (pattern->directoryOnly && !directory) {
+                    continue;
+                }
+                if (matchGlob(pattern->glob, pattern->anchored ? relative : name)) {
+                    return !pattern->negated;
+                }
+            }
+        }
+        return false;
+    }
+
+}
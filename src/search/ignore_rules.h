@@ -0,0 +1,73 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace drite {
+
+    /**
+     * @brief The patterns of one .gitignore file, chained to those of the directories above it.
+     *
+     * Supports comments, blank lines, "!" negation, trailing "/" for
+     * directories only, patterns anchored by a leading or inner "/", the
+     * wildcards "*", "?" and "[...]", and "**" spanning directories. As in git,
+     * the last matching pattern of the deepest file with a match decides.
+     */
+    class IgnoreRules {
+        public:
+            /**
+             * @brief Parse the contents of a .gitignore file.
+             * @param text The file contents.
+             * @param directory The path of the directory holding the file, as walked.
+             * @param parent The rules of the enclosing directories, or nullptr.
+             * @return The rules, or parent if the file holds no patterns.
+             */
+            [[nodiscard]] static std::shared_ptr<const IgnoreRules> parse(std::string_view text, std::string directory,
+                                                                          std::shared_ptr<const IgnoreRules> parent);
+
+            /**
+             * @brief Check whether a path below the directory of these rules is ignored.
+             * @param path The path as walked, starting with the directory of these rules.
+             * @param directory Whether the path is a directory.
+             * @return True if the path is ignored.
+             */
+            [[nodiscard]] bool isIgnored(std::string_view path, bool directory) const;
+
+            /**
+             * @brief Match a path against a gitignore glob.
+             * @param pattern The glob; "*" and "?" stop at "/", "**" does not.
+             * @param path The path.
+             * @return True if the whole path matches.
+             */
+            [[nodiscard]] static bool matchGlob(std::string_view pattern, std::string_view path);
+
+        private:
+            /**
+             * @brief One line of a .gitignore file.
+             */
+            struct Pattern {
+                std::string glob;
+                bool negated{false};
+                bool directoryOnly{false};
+                bool anchored{false};
+            };
+
+            /**
+             * @brief The rules of the enclosing directories.
+             */
+            std::shared_ptr<const IgnoreRules> m_parent;
+
+            /**
+             * @brief The path of the directory holding the .gitignore file.
+             */
+            std::string m_directory;
+
+            /**
+             * @brief The patterns in file order.
+             */
+            std::vector<Pattern> m_patterns;
+    };
+
+}
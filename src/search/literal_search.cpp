@@ -0,0 +1,248 @@
+#include "search/literal_search.h"
+#include "core/cpu_features.h"
+#include <cstdint>
+#include <cstring>
+
+#if DRITE_CPU_X86
+#include <immintrin.h>
+#elif DRITE_CPU_NEON
+#include <arm_neon.h>
+#endif
+
+namespace drite {
+
+    /**
+     * @brief Kernel entry points selected once per process.
+     */
+    struct SearchKernels {
+        size_t (*find)(const char*, size_t, const char*, size_t, bool) noexcept;
+        const char* name;
+    };
+
+    /**
+     * @brief Get the bit OR-ed into a byte to fold its case.
+     * @param byte The literal byte.
+     * @param ignoreCase Whether case is ignored.
+     * @return 0x20 for ASCII letters when ignoring case, otherwise 0.
+     */
+    static uint8_t getFoldBit(char byte, bool ignoreCase) noexcept {
+        const uint8_t lower = static_cast<uint8_t>(byte) | 0x20;
+        return ignoreCase && lower >= 'a' && lower <= 'z' ? 0x20 : 0;
+    }
+
+    /**
+     * @brief Check whether a literal occurs at a position.
+     * @param data The position.
+     * @param literal The literal.
+     * @param length The length of the literal.
+     * @param ignoreCase Whether ASCII letters match regardless of case.
+     * @return True if the bytes match.
+     */
+    static bool matchesAt(const char* data, const char* literal, size_t length, bool ignoreCase) noexcept {
+        if (!ignoreCase) {
+            return std::memcmp(data, literal, length) == 0;
+        }
+        for (size_t i = 0; i < length; ++i) {
+            const uint8_t fold = getFoldBit(literal[i], true);
+            if ((static_cast<uint8_t>(data[i]) | fold) != (static_cast<uint8_t>(literal[i]) | fold)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /**
+     * @brief Find a literal one position at a time.
+     * @param data The start of the range.
+     * @param size The size of the range, at least the literal length.
+     * @param literal The literal.
+     * @param length The length of the literal, at least one.
+     * @param ignoreCase Whether ASCII letters match regardless of case.
+     * @return The offset of the first occurrence, or size if not found.
+     */
+    static size_t findScalar(const char* data, size_t size, const char* literal, size_t length, bool ignoreCase) noexcept {
+        const uint8_t fold = getFoldBit(literal[0], ignoreCase);
+        const uint8_t first = static_cast<uint8_t>(literal[0]) | fold;
+        for (size_t i = 0; i + length <= size; ++i) {
+            if ((static_cast<uint8_t>(data[i]) | fold) == first && matchesAt(data + i, literal, length, ignoreCase)) {
+                return i;
+            }
+        }
+        return size;
+    }
+
+    /**
+     * @brief Verify the candidate positions of a filter mask.
+     * @param data The position of the first mask bit.
+     * @param mask One bit per candidate position.
+     * @param stride The number of positions per mask bit.
+     * @param literal The literal.
+     * @param length The length of the literal.
+     * @param ignoreCase Whether ASCII letters match regardless of case.
+     * @return The offset of the first verified candidate, or SIZE_MAX if none matches.
+     */
+    [[maybe_unused]] static size_t verifyCandidates(const char* data, uint64_t mask, unsigned stride, const char* literal, size_t length, bool ignoreCase) noexcept {
+        while (mask) {
+            const size_t offset = static_cast<size_t>(__builtin_ctzll(mask)) / stride;
+            if (matchesAt(data + offset, literal, length, ignoreCase)) {
+                return offset;
+            }
+            mask &= mask - 1;
+        }
+        return SIZE_MAX;
+    }
+
+#if DRITE_CPU_X86
+
+    /**
+     * @brief Find a literal 16 positions at a time with SSE2.
+     * @param data The start of the range.
+     * @param size The size of the range, at least the literal length.
+     * @param literal The literal.
+     * @param length The length of the literal, at least one.
+     * @param ignoreCase Whether ASCII letters match regardless of case.
+     * @return The offset of the first occurrence, or size if not found.
+     */
+    static size_t findSse2(const char* data, size_t size, const char* literal, size_t length, bool ignoreCase) noexcept {
+        const uint8_t firstFold = getFoldBit(literal[0], ignoreCase);
+        const uint8_t lastFold = getFoldBit(literal[length - 1], ignoreCase);
+        const __m128i first = _mm_set1_epi8(static_cast<char>(static_cast<uint8_t>(literal[0]) | firstFold));
+        const __m128i last = _mm_set1_epi8(static_cast<char>(static_cast<uint8_t>(literal[length - 1]) | lastFold));
+        const __m128i firstBit = _mm_set1_epi8(static_cast<char>(firstFold));
+        const __m128i lastBit = _mm_set1_epi8(static_cast<char>(lastFold));
+        size_t i{0};
+
+        for (; i + length + 15 <= size; i += 16) {
+            const __m128i head = _mm_or_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i)), firstBit);
+            const __m128i tail = _mm_or_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i + length - 1)), lastBit);
+            const uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(head, first), _mm_cmpeq_epi8(tail, last))));
+            const size_t found = verifyCandidates(data + i, mask, 1, literal, length, ignoreCase);
+            if (found != SIZE_MAX) {
+                return i + found;
+            }
+        }
+
+        return i + findScalar(data + i, size - i, literal, length, ignoreCase);
+    }
+
+    /**
+     * @brief Find a literal 32 positions at a time with AVX2.
+     * @param data The start of the range.
+     * @param size The size of the range, at least the literal length.
+     * @param literal The literal.
+     * @param length The length of the literal, at least one.
+     * @param ignoreCase Whether ASCII letters match regardless of case.
+     * @return The offset of the first occurrence, or size if not found.
+     */
+    __attribute__((target("avx2")))
+    static size_t findAvx2(const char* data, size_t size, const char* literal, size_t length, bool ignoreCase) noexcept {
+        const uint8_t firstFold = getFoldBit(literal[0], ignoreCase);
+        const uint8_t lastFold = getFoldBit(literal[length - 1], ignoreCase);
+        const __m256i first = _mm256_set1_epi8(static_cast<char>(static_cast<uint8_t>(literal[0]) | firstFold));
+        const __m256i last = _mm256_set1_epi8(static_cast<char>(static_cast<uint8_t>(literal[length - 1]) | lastFold));
+        const __m256i firstBit = _mm256_set1_epi8(static_cast<char>(firstFold));
+        const __m256i lastBit = _mm256_set1_epi8(static_cast<char>(lastFold));
+        size_t i{0};
+
+        for (; i + length + 31 <= size; i += 32) {
+            const __m256i head = _mm256_or_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i)), firstBit);
+            const __m256i tail = _mm256_or_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i + length - 1)), lastBit);
+            const uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi8(head, first), _mm256_cmpeq_epi8(tail, last))));
+            const size_t found = verifyCandidates(data + i, mask, 1, literal, length, ignoreCase);
+            if (found != SIZE_MAX) {
+                return i + found;
+            }
+        }
+
+        return i + findSse2(data + i, size - i, literal, length, ignoreCase);
+    }
+
+#elif DRITE_CPU_NEON
+
+    /**
+     * @brief Find a literal 16 positions at a time with NEON.
+     * @param data The start of the range.
+     * @param size The size of the range, at least the literal length.
+     * @param literal The literal.
+     * @param length The length of the literal, at least one.
+     * @param ignoreCase Whether ASCII letters match regardless of case.
+     * @return The offset of the first occurrence, or size if not found.
+     */
+    static size_t findNeon(const char* data, size_t size, const char* literal, size_t length, bool ignoreCase) noexcept {
+        const uint8_t firstFold = getFoldBit(literal[0], ignoreCase);
+        const uint8_t lastFold = getFoldBit(literal[length - 1], ignoreCase);
+        const uint8x16_t first = vdupq_n_u8(static_cast<uint8_t>(literal[0]) | firstFold);
+        const uint8x16_t last = vdupq_n_u8(static_cast<uint8_t>(literal[length - 1]) | lastFold);
+        const uint8x16_t firstBit = vdupq_n_u8(firstFold);
+        const uint8x16_t lastBit = vdupq_n_u8(lastFold);
+        size_t i{0};
+
+        for (; i + length + 15 <= size; i += 16) {
+            const uint8x16_t head = vorrq_u8(vld1q_u8(reinterpret_cast<const uint8_t*>(data + i)), firstBit);
+            const uint8x16_t tail = vorrq_u8(vld1q_u8(reinterpret_cast<const uint8_t*>(data + i + length - 1)), lastBit);
+            const uint8x16_t candidates = vandq_u8(vceqq_u8(head, first), vceqq_u8(tail, last));
+
+            // Narrow each byte lane to a nibble to get a 64-bit mask
+            const uint8x8_t narrowed = vshrn_n_u16(vreinterpretq_u16_u8(candidates), 4);
+            const uint64_t mask = vget_lane_u64(vreinterpret_u64_u8(narrowed), 0) & 0x8888888888888888ull;
+            const size_t found = verifyCandidates(data + i, mask, 4, literal, length, ignoreCase);
+            if (found != SIZE_MAX) {
+                return i + found;
+            }
+        }
+
+        return i + findScalar(data + i, size - i, literal, length, ignoreCase);
+    }
+
+#endif
+
+    /**
+     * @brief Pick the widest kernel the running CPU supports.
+     * @param cpu The features of the running CPU.
+     * @return The selected kernels.
+     */
+    static SearchKernels selectKernels([[maybe_unused]] const CpuFeatures& cpu) noexcept {
+#if DRITE_CPU_X86
+        if (cpu.avx2) {
+            return SearchKernels{findAvx2, "avx2"};
+        }
+        return SearchKernels{findSse2, "sse2"};
+#elif DRITE_CPU_NEON
+        return SearchKernels{findNeon, "neon"};
+#else
+        return SearchKernels{findScalar, "scalar"};
+#endif
+    }
+
+    /**
+     * @brief Get the kernels selected for this process.
+     * @return The selected kernels.
+     */
+    static const SearchKernels& getKernels() noexcept {
+        return getKernelTable(selectKernels);
+    }
+
+    /**
+     * @brief Find the first occurrence of a literal in a byte range.
+     * @param data The start of the range.
+     * @param size The size of the range in bytes.
+     * @param literal The bytes to find.
+     * @param ignoreCase Whether ASCII letters match regardless of case.
+     * @return The offset of the first occurrence, or size if there is none.
+     */
+    size_t findLiteral(const char* data, size_t size, std::string_view literal, bool ignoreCase) noexcept {
+        if (literal.empty() || literal.size() > size) {
+            return size;
+        }
+        return getKernels().find(data, size, literal.data(), literal.size(), ignoreCase);
+    }
+
+    /**
+     * @brief Get the name of the literal search kernel selected for this CPU.
+     * @return The kernel name, e.g. "avx2".
+     */
+    const char* getLiteralSearchName() noexcept {
+        return getKernels().name;
+    }
+
+}
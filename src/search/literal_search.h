@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstddef>
+#include <string_view>
+
+namespace drite {
+
+    /**
+     * @brief Find the first occurrence of a literal in a byte range.
+     *
+     * Candidates are filtered by comparing the first and last byte of the
+     * literal against a whole vector of positions at once, using the widest
+     * kernel supported by the running CPU (AVX2 or SSE2 on x86-64, NEON on
+     * ARM64), and only positions passing both compares are verified. Case is
+     * folded for ASCII letters only.
+     *
+     * @param data The start of the range.
+     * @param size The size of the range in bytes.
+     * @param literal The bytes to find.
+     * @param ignoreCase Whether ASCII letters match regardless of case.
+     * @return The offset of the first occurrence, or size if there is none.
+     */
+    [[nodiscard]] size_t findLiteral(const char* data, size_t size, std::string_view literal, bool ignoreCase) noexcept;
+
+    /**
+     * @brief Get the name of the literal search kernel selected for this CPU.
+     * @return The kernel name, e.g. "avx2".
+     */
+    [[nodiscard]] const char* getLiteralSearchName() noexcept;
+
+}
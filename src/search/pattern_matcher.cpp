@@ -0,0 +1,169 @@
+#include "search/pattern_matcher.h"
+#include "search/literal_search.h"
+#include <algorithm>
+#include <cstring>
+#include <print>
+
+namespace drite {
+
+    /**
+     * @brief Get the literal text every match of a regular expression starts with.
+     *
+     * Only a run of plain characters at the start of a pattern without
+     * top-level alternatives is taken, less a last character made optional by a
+     * quantifier, so lines without it can be skipped with findLiteral().
+     *
+     * @param pattern The ECMAScript pattern.
+     * @return The literal prefix, possibly empty.
+     */
+    static std::string getRegexLiteral(std::string_view pattern) {
+        // An alternative outside any group makes the prefix optional
+        int depth{0};
+        bool inClass{false};
+        for (size_t i = 0; i < pattern.size(); ++i) {
+            const char character = pattern[i];
+            if (character == '\\') {
+                ++i;
+            } else if (inClass) {
+                inClass = character != ']';
+            } else if (character == '[') {
+                inClass = true;
+            } else if (character == '(') {
+                ++depth;
+            } else if (character == ')') {
+                --depth;
+            } else if (character == '|' && depth == 0) {
+                return {};
+            }
+        }
+
+        // A line start anchor still leaves the literal required
+        constexpr std::string_view Special = "\\^$.|?*+()[]{}";
+        const size_t start = pattern.starts_with('^') ? 1 : 0;
+        size_t end{start};
+        while (end < pattern.size() && pattern[end] >= ' ' && pattern[end] < 0x7F &&
+               Special.find(pattern[end]) == std::string_view::npos) {
+            ++end;
+        }
+        if (end > start && end < pattern.size() && (pattern[end] == '?' || pattern[end] == '*' || pattern[end] == '{')) {
+            --end;
+        }
+        return std::string(pattern.substr(start, end - start));
+    }
+
+    /**
+     * @brief Compile a query.
+     * @param query The query.
+     * @return False if the query is not a valid regular expression.
+     */
+    bool PatternMatcher::compile(const SearchQuery& query) {
+        m_query = query;
+        m_regex.reset();
+        m_regexLiteral.clear();
+        if (!query.regex) {
+            return true;
+        }
+
+        auto flags = std::regex_constants::ECMAScript | std::regex_constants::optimize;
+        if (query.ignoreCase) {
+            flags |= std::regex_constants::icase;
+        }
+        try {
+            m_regex.emplace(query.pattern, flags);
+        } catch (const std::regex_error& error) {
+            std::println(stderr, "Invalid regular expression {}: {}", query.pattern, error.what());
+            return false;
+        }
+        m_regexLiteral = getRegexLiteral(query.pattern);
+        return true;
+    }
+
+    /**
+     * @brief Find the matches starting in the first bytes of a text.
+     * @param text The text; regular expressions see it split into lines.
+     * @param limit Only matches starting before this offset are reported.
+     * @param base Added to the offsets of the reported matches.
+     * @param firstPerLine Whether to report only the first match of each line.
+     * @param maxMatches Stop after this many matches in found.
+     * @param cancelled Checked between lines of regular expression searches; may be nullptr.
+     * @param found Receives the matches, in offset order.
+     * @return The number of lines skipped as too long or too complex for the regular expression.
+     */
+    size_t PatternMatcher::findMatches(std::string_view text, size_t limit, size_t base, bool firstPerLine, size_t maxMatches,
+                                       const std::atomic<bool>* cancelled, std::vector<SearchMatch>& found) const {
+        const std::string& pattern = m_query.pattern;
+        if (pattern.empty()) {
+            return 0;
+        }
+        limit = std::min(limit, text.size());
+
+        if (!m_regex) {
+            size_t position{0};
+            while (position < limit && found.size() < maxMatches) {
+                const size_t match = position + findLiteral(text.data() + position, text.size() - position, pattern, m_query.ignoreCase);
+                if (match >= limit) {
+                    break;
+                }
+                found.push_back(SearchMatch{base + match, pattern.size()});
+                position = match + pattern.size();
+                if (firstPerLine) {
+                    const size_t lineFeed = text.find('\n', match);
+                    position = lineFeed == std::string_view::npos ? text.size() : std::max(position, lineFeed + 1);
+                }
+            }
+            return 0;
+        }
+
+        const char* line = text.data();
+        const char* const stop = text.data() + limit;
+        size_t skipped{0};
+        while (line < stop && found.size() < maxMatches) {
+            if (cancelled && cancelled->load(std::memory_order_relaxed)) {
+                break;
+            }
+
+            // Skip straight to the next line holding the literal every match starts with
+            if (!m_regexLiteral.empty()) {
+                const size_t remaining = static_cast<size_t>(text.data() + text.size() - line);
+                const size_t hit = findLiteral(line, remaining, m_regexLiteral, m_query.ignoreCase);
+                if (hit >= static_cast<size_t>(stop - line)) {
+                    break;
+                }
+                const size_t lineFeed = std::string_view(line, hit).rfind('\n');
+                line += lineFeed == std::string_view::npos ? 0 : lineFeed + 1;
+            }
+
+            const auto* lineFeed = static_cast<const char*>(std::memchr(line, '\n', static_cast<size_t>(text.data() + text.size() - line)));
+            const char* lineEnd = lineFeed ? lineFeed : text.data() + text.size();
+            const char* next = lineFeed ? lineFeed + 1 : lineEnd;
+            if (lineEnd > line && lineEnd[-1] == '\r') {
+                --lineEnd;
+            }
+
+            // std::regex recurses per character and can exhaust the stack on
+            // very long lines, so those are skipped and reported
+            if (static_cast<size_t>(lineEnd - line) > MaxRegexLineBytes) {
+                ++skipped;
+                line = next;
+                continue;
+            }
+
+            try {
+                for (std::cregex_iterator it(line, lineEnd, *m_regex), itEnd; it != itEnd; ++it) {
+                    if (it->length(0) > 0) {
+                        const size_t offset = static_cast<size_t>(line - text.data()) + static_cast<size_t>(it->position(0));
+                        found.push_back(SearchMatch{base + offset, static_cast<size_t>(it->length(0))});
+                        if (firstPerLine) {
+                            break;
+                        }
+                    }
+                }
+            } catch (const std::regex_error&) {
+                ++skipped;
+            }
+            line = next;
+        }
+        return skipped;
+    }
+
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include "search/search_match.h"
+#include <atomic>
+#include <cstddef>
+#include <optional>
+#include <regex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace drite {
+
+    /**
+     * @brief What to search for.
+     */
+    struct SearchQuery {
+        std::string pattern;
+        bool ignoreCase{true};
+        bool regex{false};
+    };
+
+    /**
+     * @brief A compiled search query that finds matches in contiguous text.
+     *
+     * Literals are found with findLiteral(). Regular expressions are matched
+     * one line at a time with std::regex; when every match must start with a
+     * literal prefix, lines without it are skipped with findLiteral() first.
+     */
+    class PatternMatcher {
+        public:
+            /**
+             * @brief Lines longer than this are skipped by regular expression searches.
+             */
+            static constexpr size_t MaxRegexLineBytes = 64 * 1024;
+
+            /**
+             * @brief Compile a query.
+             * @param query The query.
+             * @return False if the query is not a valid regular expression.
+             */
+            [[nodiscard]] bool compile(const SearchQuery& query);
+
+            /**
+             * @brief Get the compiled query.
+             * @return The query.
+             */
+            [[nodiscard]] const SearchQuery& getQuery() const noexcept { return m_query; }
+
+            /**
+             * @brief Get how far past the end of a range a match starting in it may extend.
+             * @return The literal length less one, or 0 for regular expressions, which never span lines.
+             */
+            [[nodiscard]] size_t getOverlap() const noexcept { return m_regex || m_query.pattern.empty() ? 0 : m_query.pattern.size() - 1; }
+
+            /**
+             * @brief Find the matches starting in the first bytes of a text.
+             * @param text The text; regular expressions see it split into lines.
+             * @param limit Only matches starting before this offset are reported.
+             * @param base Added to the offsets of the reported matches.
+             * @param firstPerLine Whether to report only the first match of each line.
+             * @param maxMatches Stop after this many matches in found.
+             * @param cancelled Checked between lines of regular expression searches; may be nullptr.
+             * @param found Receives the matches, in offset order.
+             * @return The number of lines skipped as too long or too complex for the regular expression.
+             */
+            size_t findMatches(std::string_view text, size_t limit, size_t base, bool firstPerLine, size_t maxMatches,
+                               const std::atomic<bool>* cancelled, std::vector<SearchMatch>& found) const;
+
+        private:
+            /**
+             * @brief The compiled query.
+             */
+            SearchQuery m_query;
+
+            /**
+             * @brief The regular expression of a regex query.
+             */
+            std::optional<std::regex> m_regex;
+
+            /**
+             * @brief Literal every match of the regular expression starts with, possibly empty.
+             */
+            std::string m_regexLiteral;
+    };
+
+}
@@ -0,0 +1,442 @@
+#include "search/project_search.h"
+#include "core/profiler.h"
+#include "editor/newline_scanner.h"
+#include "io/mapped_file.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <print>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace drite {
+
+    /**
+     * @brief Get the seconds elapsed since a search started.
+     * @param startTime The start time of the search.
+     * @return The elapsed time in seconds.
+     */
+    static double getSecondsSince(std::chrono::steady_clock::time_point startTime) noexcept {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+    }
+
+    /**
+     * @brief Read an open file into a string.
+     * @param fd The file descriptor.
+     * @param size The expected size; only a hint, as the file may change meanwhile.
+     * @param text Receives the contents; its storage is reused.
+     */
+    static void readDescriptor(int fd, size_t size, std::string& text) {
+        text.resize(size);
+        size_t total{0};
+        while (total < text.size()) {
+            const ssize_t count = ::read(fd, text.data() + total, text.size() - total);
+            if (count < 0 && errno == EINTR) {
+                continue;
+            }
+            if (count <= 0) {
+                break;
+            }
+            total += static_cast<size_t>(count);
+        }
+        text.resize(total);
+    }
+
+    /**
+     * @brief Read a whole file into a string.
+     * @param path The file path.
+     * @param text Receives the contents; its storage is reused.
+     * @return False if the file could not be opened or is not a regular file.
+     */
+    static bool readFile(const std::string& path, std::string& text) {
+        const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            return false;
+        }
+
+        struct stat info{};
+        const bool regular = ::fstat(fd, &info) == 0 && S_ISREG(info.st_mode);
+        if (regular) {
+            readDescriptor(fd, static_cast<size_t>(info.st_size), text);
+        }
+        ::close(fd);
+        return regular;
+    }
+
+    /**
+     * @brief Join a directory and an entry name.
+     * @param directory The directory path.
+     * @param name The entry name.
+     * @return The entry path.
+     */
+    static std::string joinPath(const std::string& directory, std::string_view name) {
+        std::string path;
+        path.reserve(directory.size() + name.size() + 1);
+        path += directory;
+        if (!path.ends_with('/')) {
+            path += '/';
+        }
+        path += name;
+        return path;
+    }
+
+    /**
+     * @brief Construct a new Project Search object.
+     * @param jobs The job system running the searches; must outlive this object.
+     */
+    ProjectSearch::ProjectSearch(JobSystem& jobs)
+        : m_jobs(jobs), m_resultCallback(std::make_shared<ResultCallback>()) {}
+
+    /**
+     * @brief Destroy the Project Search object, cancelling the search.
+     */
+    ProjectSearch::~ProjectSearch() {
+        cancel();
+
+        // A job may be about to call the callback; once cleared under its lock none will
+        std::lock_guard lock(m_resultCallback->mutex);
+        m_resultCallback->function = nullptr;
+    }
+
+    /**
+     * @brief Set the function called from a worker when results are ready for poll().
+     * @param callback The callback, e.g. one that wakes the main loop.
+     */
+    void ProjectSearch::setResultCallback(std::function<void()> callback) {
+        std::lock_guard lock(m_resultCallback->mutex);
+        m_resultCallback->function = std::move(callback);
+    }
+
+    /**
+     * @brief Cancel the current search and start a new one.
+     * @param roots The directories or files to search.
+     * @param query The query.
+     * @return False if the query is not a valid regular expression or no root exists.
+     */
+    bool ProjectSearch::start(const std::vector<std::string>& roots, const SearchQuery& query) {
+        DRITE_PROFILE_ZONE("startProjectSearch");
+        cancel();
+
+        auto search = std::make_shared<Search>();
+        if (query.pattern.empty() || !search->matcher.compile(query)) {
+            return false;
+        }
+
+        // Roots are followed even if they are links; entries below them are not
+        std::vector<WalkItem> items;
+        for (const std::string& root : roots) {
+            struct stat info{};
+            if (::stat(root.c_str(), &info) != 0) {
+                std::println(stderr, "Failed to open {}: {}", root, std::strerror(errno));
+                continue;
+            }
+            if (!S_ISDIR(info.st_mode) && !S_ISREG(info.st_mode)) {
+                continue;
+            }
+
+            std::string path = root;
+            while (path.size() > 1 && path.ends_with('/')) {
+                path.pop_back();
+            }
+            items.push_back(WalkItem{std::move(path), nullptr, S_ISDIR(info.st_mode)});
+        }
+        if (items.empty()) {
+            return false;
+        }
+
+        search->callback = m_resultCallback;
+        search->pending.store(items.size(), std::memory_order_relaxed);
+        search->startTime = std::chrono::steady_clock::now();
+        m_stolenAtStart = m_jobs.getStats().stolen;
+        m_search = search;
+        submitItems(m_jobs, search, items);
+        return true;
+    }
+
+    /**
+     * @brief Cancel the current search.
+     */
+    void ProjectSearch::cancel() {
+        // Queued jobs see the flag and return without touching the file system
+        if (m_search) {
+            m_search->cancelled.store(true, std::memory_order_relaxed);
+            m_search.reset();
+        }
+
+        m_complete = false;
+        m_stats = ProjectSearchStats{};
+    }
+
+    /**
+     * @brief Pick up the files matched since the last call.
+     * @param results Receives the new matches.
+     * @return True if files were added or the search finished.
+     */
+    bool ProjectSearch::poll(std::vector<ProjectFileMatch>& results) {
+        if (!m_search || m_complete) {
+            return false;
+        }
+
+        const size_t previousCount = results.size();
+        bool finished{false};
+        {
+            std::lock_guard lock(m_search->resultMutex);
+            if (results.empty()) {
+                results.swap(m_search->results);
+            } else {
+                std::move(m_search->results.begin(), m_search->results.end(), std::back_inserter(results));
+                m_search->results.clear();
+            }
+            m_stats.filesMatched = m_search->filesMatched;
+            m_stats.matchedLines = m_search->matchedLines;
+            m_stats.skippedLines = m_search->skippedLines;
+            m_stats.seconds = m_search->finished ? m_search->seconds : getSecondsSince(m_search->startTime);
+            finished = m_search->finished;
+            m_search->notified = false;
+        }
+        m_stats.directories = m_search->directories.load(std::memory_order_relaxed);
+        m_stats.filesSearched = m_search->filesSearched.load(std::memory_order_relaxed);
+        m_stats.binaryFiles = m_search->binaryFiles.load(std::memory_order_relaxed);
+        m_stats.ignoredPaths = m_search->ignoredPaths.load(std::memory_order_relaxed);
+        m_stats.bytesSearched = m_search->bytesSearched.load(std::memory_order_relaxed);
+
+        // The job system counts steals of all its jobs; other work rarely runs during a search
+        m_stats.steals = static_cast<size_t>(m_jobs.getStats().stolen - m_stolenAtStart);
+
+        m_complete = finished;
+        return finished || results.size() != previousCount;
+    }
+
+    /**
+     * @brief Queue jobs for walk items: one per directory and one per FileBatchSize files.
+     * @param jobs The job system.
+     * @param search The search; the items must already be counted in its pending count.
+     * @param items The items; emptied.
+     */
+    void ProjectSearch::submitItems(JobSystem& jobs, const std::shared_ptr<Search>& search, std::vector<WalkItem>& items) {
+        std::vector<WalkItem> files;
+        for (WalkItem& item : items) {
+            if (item.directory) {
+                std::vector<WalkItem> directory;
+                directory.push_back(std::move(item));
+                jobs.submit([&jobs, search, batch = std::move(directory)] { runItems(jobs, search, batch); });
+                continue;
+            }
+            files.push_back(std::move(item));
+            if (files.size() == FileBatchSize) {
+                jobs.submit([&jobs, search, batch = std::move(files)] { runItems(jobs, search, batch); });
+                files.clear();
+            }
+        }
+        if (!files.empty()) {
+            jobs.submit([&jobs, search, batch = std::move(files)] { runItems(jobs, search, batch); });
+        }
+        items.clear();
+    }
+
+    /**
+     * @brief Job body: list the directories or search the files of a batch, then count it done.
+     * @param jobs The job system, for the jobs of the entries found.
+     * @param search The search.
+     * @param items The batch.
+     */
+    void ProjectSearch::runItems(JobSystem& jobs, const std::shared_ptr<Search>& search, const std::vector<WalkItem>& items) {
+        // Scratch storage lives as long as the worker, so files are read without allocating
+        static thread_local std::string buffer;
+        static thread_local std::vector<SearchMatch> found;
+        std::vector<WalkItem> children;
+
+        for (const WalkItem& item : items) {
+            if (search->cancelled.load(std::memory_order_relaxed)) {
+                break;
+            }
+            if (item.directory) {
+                walkDirectory(*search, item, children, buffer);
+                continue;
+            }
+
+            ProjectFileMatch match = searchFile(*search, item, buffer, found);
+            if (!match.lines.empty() && !search->cancelled.load(std::memory_order_relaxed)) {
+                {
+                    std::lock_guard lock(search->resultMutex);
+                    ++search->filesMatched;
+                    search->matchedLines += match.lines.size();
+                    search->results.push_back(std::move(match));
+                }
+                notifyResults(*search);
+            }
+        }
+
+        // Pending is raised before the children are queued so it cannot reach zero early
+        if (!children.empty() && !search->cancelled.load(std::memory_order_relaxed)) {
+            search->pending.fetch_add(children.size(), std::memory_order_relaxed);
+            submitItems(jobs, search, children);
+        }
+
+        // The job finishing the last item records the end
+        if (search->pending.fetch_sub(items.size(), std::memory_order_acq_rel) == items.size()) {
+            {
+                std::lock_guard lock(search->resultMutex);
+                search->seconds = getSecondsSince(search->startTime);
+                search->finished = true;
+            }
+            notifyResults(*search);
+        }
+    }
+
+    /**
+     * @brief Wake the UI if it has not been woken since its last poll().
+     * @param search The search.
+     */
+    void ProjectSearch::notifyResults(Search& search) {
+        {
+            std::lock_guard lock(search.resultMutex);
+            if (search.notified) {
+                return;
+            }
+            search.notified = true;
+        }
+
+        std::lock_guard lock(search.callback->mutex);
+        if (search.callback->function) {
+            search.callback->function();
+        }
+    }
+
+    /**
+     * @brief List a directory, collecting the entries not ignored.
+     * @param job The search.
+     * @param item The directory.
+     * @param children Receives the entries.
+     * @param scratch Scratch storage for reading .gitignore.
+     */
+    void ProjectSearch::walkDirectory(Search& search, const WalkItem& item, std::vector<WalkItem>& children, std::string& scratch) {
+        DRITE_PROFILE_ZONE("walkDirectory");
+        DIR* directory = ::opendir(item.path.c_str());
+        if (!directory) {
+            return;
+        }
+        search.directories.fetch_add(1, std::memory_order_relaxed);
+
+        // The directory's own rules apply to its entries and everything below
+        std::shared_ptr<const IgnoreRules> rules = item.ignore;
+        if (readFile(joinPath(item.path, ".gitignore"), scratch)) {
+            rules = IgnoreRules::parse(scratch, item.path, std::move(rules));
+        }
+
+        while (const dirent* entry = ::readdir(directory)) {
+            const std::string_view name = entry->d_name;
+            if (name == "." || name == ".." || name == ".git") {
+                continue;
+            }
+
+            std::string path = joinPath(item.path, name);
+            unsigned char type = entry->d_type;
+            if (type == DT_UNKNOWN) {
+                struct stat info{};
+                if (::lstat(path.c_str(), &info) != 0) {
+                    continue;
+                }
+                type = S_ISDIR(info.st_mode) ? DT_DIR : S_ISREG(info.st_mode) ? DT_REG : DT_LNK;
+            }
+            if (type != DT_DIR && type != DT_REG) {
+                continue;
+            }
+
+            const bool isDirectory = type == DT_DIR;
+            if (rules && rules->isIgnored(path, isDirectory)) {
+                search.ignoredPaths.fetch_add(1, std::memory_order_relaxed);
+                continue;
+            }
+            children.push_back(WalkItem{std::move(path), rules, isDirectory});
+        }
+        ::closedir(directory);
+    }
+
+    /**
+     * @brief Search one file.
+     * @param job The search.
+     * @param item The file.
+     * @param buffer Storage for files read instead of mapped.
+     * @param found Scratch storage for the matches.
+     * @return The matching lines, with no lines if there are none.
+     */
+    ProjectFileMatch ProjectSearch::searchFile(Search& search, const WalkItem& item, std::string& buffer, std::vector<SearchMatch>& found) {
+        DRITE_PROFILE_ZONE("searchFile");
+        ProjectFileMatch result;
+
+        const int fd = ::open(item.path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            return result;
+        }
+        struct stat info{};
+        if (::fstat(fd, &info) != 0 || !S_ISREG(info.st_mode) || info.st_size == 0) {
+            ::close(fd);
+            return result;
+        }
+
+        // Mapping costs page faults and a TLB shootdown on unmap, which only
+        // pays off over copying for large files
+        std::unique_ptr<MappedFile> mapped;
+        std::string_view text;
+        if (static_cast<size_t>(info.st_size) >= MapThreshold) {
+            ::close(fd);
+            mapped = MappedFile::open(item.path);
+            if (!mapped) {
+                return result;
+            }
+            text = mapped->getData();
+        } else {
+            readDescriptor(fd, static_cast<size_t>(info.st_size), buffer);
+            ::close(fd);
+            text = buffer;
+        }
+        if (text.empty()) {
+            return result;
+        }
+
+        if (std::memchr(text.data(), '\0', std::min(text.size(), SniffBytes))) {
+            search.binaryFiles.fetch_add(1, std::memory_order_relaxed);
+            return result;
+        }
+        search.filesSearched.fetch_add(1, std::memory_order_relaxed);
+        search.bytesSearched.fetch_add(text.size(), std::memory_order_relaxed);
+
+        found.clear();
+        const size_t skipped = search.matcher.findMatches(text, text.size(), 0, true, SIZE_MAX, &search.cancelled, found);
+        if (skipped > 0) {
+            std::lock_guard lock(search.resultMutex);
+            search.skippedLines += skipped;
+        }
+        if (found.empty()) {
+            return result;
+        }
+
+        // Line numbers are counted between matches, so files with few
+        // matches are scanned for line feeds only once
+        result.path = item.path;
+        result.lines.reserve(found.size());
+        size_t line{0};
+        size_t counted{0};
+        for (const SearchMatch& match : found) {
+            line += countLineFeeds(text.data() + counted, match.offset - counted);
+            counted = match.offset;
+
+            const size_t lineFeed = match.offset == 0 ? std::string_view::npos : text.rfind('\n', match.offset - 1);
+            const size_t lineStart = lineFeed == std::string_view::npos ? 0 : lineFeed + 1;
+            size_t lineEnd = std::min(text.find('\n', match.offset), text.size());
+            if (lineEnd > lineStart && text[lineEnd - 1] == '\r') {
+                --lineEnd;
+            }
+            size_t kept = std::min(lineEnd - lineStart, MaxLineBytes);
+            while (kept < lineEnd - lineStart && (static_cast<uint8_t>(text[lineStart + kept]) & 0xC0) == 0x80) {
+                --kept;
+            }
+            result.lines.push_back(ProjectLineMatch{line + 1, match.offset - lineStart + 1, std::string(text.substr(lineStart, kept))});
+        }
+        return result;
+    }
+
+}
@@ -0,0 +1,274 @@
+#pragma once
+
+#include "core/job_system.h"
+#include "search/ignore_rules.h"
+#include "search/pattern_matcher.h"
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace drite {
+
+    /**
+     * @brief A line of a file holding a match.
+     */
+    struct ProjectLineMatch {
+        size_t line{0};
+        size_t column{0};
+        std::string text;
+    };
+
+    /**
+     * @brief The matching lines of one file, in line order.
+     */
+    struct ProjectFileMatch {
+        std::string path;
+        std::vector<ProjectLineMatch> lines;
+    };
+
+    /**
+     * @brief Progress and timing of a project search.
+     */
+    struct ProjectSearchStats {
+        size_t directories{0};
+        size_t filesSearched{0};
+        size_t filesMatched{0};
+        size_t binaryFiles{0};
+        size_t ignoredPaths{0};
+        size_t matchedLines{0};
+        size_t skippedLines{0};
+        size_t steals{0};
+        uint64_t bytesSearched{0};
+        double seconds{0.0};
+    };
+
+    /**
+     * @brief Searches the files below a set of directories on a pool of worker threads.
+     *
+     * Directories and batches of files are Background jobs on a JobSystem. A
+     * job listing a directory submits a job per subdirectory and per
+     * FileBatchSize files; submitted from a worker, they go to its own deque
+     * and run newest first, walking depth first, while idle workers steal
+     * the oldest and usually largest subtrees.
+     *
+     * Entries matched by a .gitignore file and the .git directory are skipped,
+     * as are symbolic links. Files of at least MapThreshold bytes are mapped,
+     * smaller ones read whole; files with a NUL byte in their first SniffBytes
+     * bytes are taken as binary and skipped. Each file's matching lines are
+     * streamed to poll() as soon as the file is searched.
+     */
+    class ProjectSearch {
+        public:
+            /**
+             * @brief Files at least this large are mapped instead of read.
+             */
+            static constexpr size_t MapThreshold = size_t{1} << 20;
+
+            /**
+             * @brief Bytes at the start of a file checked for a NUL byte.
+             */
+            static constexpr size_t SniffBytes = 8192;
+
+            /**
+             * @brief Longest line text kept per match; longer lines are cut.
+             */
+            static constexpr size_t MaxLineBytes = 512;
+
+            /**
+             * @brief Files searched by one job, so small files do not cost a job each.
+             */
+            static constexpr size_t FileBatchSize = 16;
+
+            /**
+             * @brief Construct a new Project Search object.
+             * @param jobs The job system running the searches; must outlive this object.
+             */
+            explicit ProjectSearch(JobSystem& jobs);
+
+            /**
+             * @brief Destroy the Project Search object, cancelling the search.
+             *
+             * Jobs still queued keep the search state alive and return as soon
+             * as they run; the result callback is not called after this.
+             */
+            ~ProjectSearch();
+
+            ProjectSearch(const ProjectSearch&) = delete;
+            ProjectSearch& operator=(const ProjectSearch&) = delete;
+
+            /**
+             * @brief Set the function called from a worker when results are ready for poll().
+             * @param callback The callback, e.g. one that wakes the main loop.
+             */
+            void setResultCallback(std::function<void()> callback);
+
+            /**
+             * @brief Cancel the current search and start a new one.
+             * @param roots The directories or files to search.
+             * @param query The query.
+             * @return False if the query is not a valid regular expression or no root exists.
+             */
+            bool start(const std::vector<std::string>& roots, const SearchQuery& query);
+
+            /**
+             * @brief Cancel the current search.
+             */
+            void cancel();
+
+            /**
+             * @brief Pick up the files matched since the last call.
+             * @param results Receives the new matches.
+             * @return True if files were added or the search finished.
+             */
+            bool poll(std::vector<ProjectFileMatch>& results);
+
+            /**
+             * @brief Check whether a search is active.
+             * @return True between start() and cancel(), including after the search finished.
+             */
+            [[nodiscard]] bool isActive() const noexcept { return m_search != nullptr; }
+
+            /**
+             * @brief Check whether every file was searched.
+             * @return True once poll() saw the search finish.
+             */
+            [[nodiscard]] bool isComplete() const noexcept { return m_search && m_complete; }
+
+            /**
+             * @brief Get the progress and timing of the current search.
+             * @return The stats, as of the last poll().
+             */
+            [[nodiscard]] const ProjectSearchStats& getStats() const noexcept { return m_stats; }
+
+            /**
+             * @brief Get the number of worker threads.
+             * @return The thread count of the job system.
+             */
+            [[nodiscard]] unsigned getThreadCount() const noexcept { return m_jobs.getThreadCount(); }
+
+        private:
+            /**
+             * @brief A directory to list or a file to search.
+             */
+            struct WalkItem {
+                std::string path;
+                std::shared_ptr<const IgnoreRules> ignore;
+                bool directory{false};
+            };
+
+            /**
+             * @brief The result callback, shared with the jobs so it can be cleared while they run.
+             */
+            struct ResultCallback {
+                std::mutex mutex;
+                std::function<void()> function;
+            };
+
+            /**
+             * @brief One search, shared by the UI thread and its jobs.
+             */
+            struct Search {
+                PatternMatcher matcher;
+                std::chrono::steady_clock::time_point startTime;
+                std::shared_ptr<ResultCallback> callback;
+                std::atomic<size_t> pending{0};
+                std::atomic<bool> cancelled{false};
+
+                // Counters updated without the result lock
+                std::atomic<size_t> directories{0};
+                std::atomic<size_t> filesSearched{0};
+                std::atomic<size_t> binaryFiles{0};
+                std::atomic<size_t> ignoredPaths{0};
+                std::atomic<uint64_t> bytesSearched{0};
+
+                // Guarded by resultMutex
+                std::mutex resultMutex;
+                std::vector<ProjectFileMatch> results;
+                size_t filesMatched{0};
+                size_t matchedLines{0};
+                size_t skippedLines{0};
+                double seconds{0.0};
+                bool finished{false};
+                bool notified{false};
+            };
+
+            /**
+             * @brief Queue jobs for walk items: one per directory and one per FileBatchSize files.
+             * @param jobs The job system.
+             * @param search The search; the items must already be counted in its pending count.
+             * @param items The items; emptied.
+             */
+            static void submitItems(JobSystem& jobs, const std::shared_ptr<Search>& search, std::vector<WalkItem>& items);
+
+            /**
+             * @brief Job body: list the directories or search the files of a batch, then count it done.
+             * @param jobs The job system, for the jobs of the entries found.
+             * @param search The search.
+             * @param items The batch.
+             */
+            static void runItems(JobSystem& jobs, const std::shared_ptr<Search>& search, const std::vector<WalkItem>& items);
+
+            /**
+             * @brief Wake the UI if it has not been woken since its last poll().
+             * @param search The search.
+             */
+            static void notifyResults(Search& search);
+
+            /**
+             * @brief List a directory, collecting the entries not ignored.
+             * @param search The search.
+             * @param item The directory.
+             * @param children Receives the entries.
+             * @param scratch Scratch storage for reading .gitignore.
+             */
+            static void walkDirectory(Search& search, const WalkItem& item, std::vector<WalkItem>& children, std::string& scratch);
+
+            /**
+             * @brief Search one file.
+             * @param search The search.
+             * @param item The file.
+             * @param buffer Storage for files read instead of mapped.
+             * @param found Scratch storage for the matches.
+             * @return The matching lines, with no lines if there are none.
+             */
+            static ProjectFileMatch searchFile(Search& search, const WalkItem& item, std::string& buffer, std::vector<SearchMatch>& found);
+
+        private:
+            /**
+             * @brief The job system running the searches.
+             */
+            JobSystem& m_jobs;
+
+            /**
+             * @brief Called from a worker when results are ready for poll().
+             */
+            std::shared_ptr<ResultCallback> m_resultCallback;
+
+            /**
+             * @brief The current search, or nullptr when idle.
+             */
+            std::shared_ptr<Search> m_search;
+
+            /**
+             * @brief Jobs stolen in the job system when the current search started.
+             */
+            uint64_t m_stolenAtStart{0};
+
+            /**
+             * @brief Whether poll() saw the current search finish.
+             */
+            bool m_complete{false};
+
+            /**
+             * @brief Stats as of the last poll().
+             */
+            ProjectSearchStats m_stats;
+    };
+
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <compare>
+#include <cstddef>
+
+namespace drite {
+
+    /**
+     * @brief A matched byte range of the searched text.
+     */
+    struct SearchMatch {
+        size_t offset{0};
+        size_t length{0};
+
+        constexpr auto operator<=>(const SearchMatch&) const = default;
+    };
+
+}
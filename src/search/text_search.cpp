@@ -0,0 +1,293 @@
+#include "search/text_search.h"
+#include "core/profiler.h"
+#include <algorithm>
+
+namespace drite {
+
+    /**
+     * @brief Get the seconds elapsed since a job started.
+     * @param startTime The start time of the job.
+     * @return The elapsed time in seconds.
+     */
+    static double getSecondsSince(std::chrono::steady_clock::time_point startTime) noexcept {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+    }
+
+    /**
+     * @brief Construct a new Text Search object; the workers start with the first search.
+     * @param threadCount Number of worker threads; 0 picks one per core.
+     */
+    TextSearch::TextSearch(unsigned threadCount)
+        : m_threadCount(threadCount > 0 ? threadCount : std::max(std::thread::hardware_concurrency(), 1u)) {}
+
+    /**
+     * @brief Start the worker threads if they are not running yet.
+     */
+    void TextSearch::startWorkers() {
+        if (!m_workers.empty()) {
+            return;
+        }
+
+        m_workers.reserve(m_threadCount);
+        for (unsigned i = 0; i < m_threadCount; ++i) {
+            m_workers.emplace_back([this, i] {
+                if (Profiler::isEnabled()) {
+                    Profiler::setThreadName("search " + std::to_string(i));
+                }
+                workerLoop();
+            });
+        }
+    }
+
+    /**
+     * @brief Destroy the Text Search object, cancelling the search and joining the workers.
+     */
+    TextSearch::~TextSearch() {
+        cancel();
+        {
+            std::lock_guard lock(m_mutex);
+            m_stopping = true;
+        }
+        m_jobReady.notify_all();
+
+        for (std::thread& worker : m_workers) {
+            worker.join();
+        }
+    }
+
+    /**
+     * @brief Cancel the current search and start a new one.
+     * @param buffer The buffer to search; its text is captured, so it may be closed while the search runs.
+     * @param query The query; an empty pattern only cancels.
+     * @param startOffset The offset searched first, usually the cursor.
+     * @return False if the query is not a valid regular expression.
+     */
+    bool TextSearch::start(const TextBuffer& buffer, const SearchQuery& query, size_t startOffset) {
+        DRITE_PROFILE_ZONE("startSearch");
+        cancel();
+        if (query.pattern.empty()) {
+            return true;
+        }
+
+        auto job = std::make_shared<Job>();
+        if (!job->matcher.compile(query)) {
+            return false;
+        }
+
+        // Segment ends are moved forward to the next line start so regular
+        // expressions see whole lines and literals never straddle two segments
+        job->snapshot = TextSnapshot::capture(buffer);
+        const size_t size = job->snapshot.size;
+        const size_t segmentCount = std::max<size_t>((size + SegmentBytes - 1) / SegmentBytes, 1);
+        job->boundaries.reserve(segmentCount + 1);
+        job->boundaries.push_back(0);
+        for (size_t segment = 1; segment < segmentCount; ++segment) {
+            const size_t lineFeed = job->snapshot.find('\n', segment * SegmentBytes - 1);
+            const size_t boundary = lineFeed < size ? lineFeed + 1 : size;
+            job->boundaries.push_back(std::max(boundary, job->boundaries.back()));
+        }
+        job->boundaries.push_back(size);
+
+        job->startOffset = std::min(startOffset, size);
+        const auto last = job->boundaries.begin() + static_cast<std::ptrdiff_t>(segmentCount);
+        job->firstSegment = static_cast<size_t>(std::upper_bound(job->boundaries.begin(), last, job->startOffset) - job->boundaries.begin()) - 1;
+        job->id = ++m_nextJobId;
+        job->startTime = std::chrono::steady_clock::now();
+
+        startWorkers();
+        m_job = job;
+        m_finished.assign(segmentCount, 0);
+        {
+            std::lock_guard lock(m_mutex);
+            m_postedJob = std::move(job);
+        }
+        m_jobReady.notify_all();
+        return true;
+    }
+
+    /**
+     * @brief Cancel the current search and drop its matches.
+     */
+    void TextSearch::cancel() {
+        if (m_job) {
+            m_job->cancelled.store(true, std::memory_order_relaxed);
+            m_job.reset();
+        }
+        {
+            std::lock_guard lock(m_mutex);
+            m_postedJob.reset();
+        }
+
+        m_matches.clear();
+        m_finished.clear();
+        m_finishedCount = 0;
+        m_finishedPrefix = 0;
+        m_stats = SearchStats{};
+    }
+
+    /**
+     * @brief Pick up the matches found since the last call.
+     * @return True if matches were added or the search finished.
+     */
+    bool TextSearch::poll() {
+        if (!m_job || isComplete()) {
+            return false;
+        }
+
+        std::vector<SearchMatch> results;
+        std::vector<size_t> finished;
+        {
+            std::lock_guard lock(m_job->resultMutex);
+            results.swap(m_job->results);
+            finished.swap(m_job->finishedSegments);
+            m_stats.matchCount = m_job->matchCount;
+            m_stats.skippedLines = m_job->skippedLines;
+            m_stats.firstResultSeconds = m_job->firstResultSeconds;
+            m_stats.seconds = m_job->finishedCount == m_finished.size() ? m_job->seconds : getSecondsSince(m_job->startTime);
+            m_job->notified = false;
+        }
+        if (results.empty() && finished.empty()) {
+            return false;
+        }
+
+        // Segments finish out of order; each batch is sorted, so merge it in
+        const auto middle = static_cast<std::ptrdiff_t>(m_matches.size());
+        m_matches.insert(m_matches.end(), results.begin(), results.end());
+        std::sort(m_matches.begin() + middle, m_matches.end());
+        std::inplace_merge(m_matches.begin(), m_matches.begin() + middle, m_matches.end());
+
+        for (const size_t segment : finished) {
+            m_finished[segment] = 1;
+            m_stats.bytesSearched += m_job->boundaries[segment + 1] - m_job->boundaries[segment];
+        }
+        m_finishedCount += finished.size();
+        while (m_finishedPrefix < m_finished.size() && m_finished[(m_job->firstSegment + m_finishedPrefix) % m_finished.size()]) {
+            ++m_finishedPrefix;
+        }
+        return true;
+    }
+
+    /**
+     * @brief Get the first match at or after the start offset, wrapping around.
+     * @return The match, or nullptr if not yet known or there is none.
+     */
+    const SearchMatch* TextSearch::getFirstMatch() const noexcept {
+        if (!m_job) {
+            return nullptr;
+        }
+
+        // The finished prefix covers the text from the first segment up to
+        // searchedEnd, then continues from the top if it wrapped
+        const size_t segmentCount = m_finished.size();
+        const size_t prefixEnd = m_job->firstSegment + m_finishedPrefix;
+        const std::vector<size_t>& boundaries = m_job->boundaries;
+        const size_t searchedEnd = boundaries[std::min(prefixEnd, segmentCount)];
+
+        const auto next = std::lower_bound(m_matches.begin(), m_matches.end(), SearchMatch{m_job->startOffset, 0});
+        if (next != m_matches.end() && next->offset < searchedEnd) {
+            return &*next;
+        }
+        if (prefixEnd < segmentCount || m_matches.empty()) {
+            return nullptr;
+        }
+
+        // Nothing after the start offset, so the answer is the first match
+        // from the top once the text before it has been searched
+        const size_t wrappedEnd = m_finishedPrefix == segmentCount ? boundaries.back() : boundaries[prefixEnd - segmentCount];
+        return m_matches.front().offset < wrappedEnd ? &m_matches.front() : nullptr;
+    }
+
+    /**
+     * @brief Worker thread body: wait for a search, help run it, repeat until stopped.
+     */
+    void TextSearch::workerLoop() {
+        uint64_t seenId{0};
+
+        for (;;) {
+            std::shared_ptr<Job> job;
+            {
+                std::unique_lock lock(m_mutex);
+                m_jobReady.wait(lock, [&] { return m_stopping || (m_postedJob && m_postedJob->id != seenId); });
+                if (m_stopping) {
+                    return;
+                }
+                job = m_postedJob;
+                seenId = job->id;
+            }
+
+            runJob(*job);
+        }
+    }
+
+    /**
+     * @brief Claim and search segments of a job until none are left or it is cancelled.
+     * @param job The job.
+     */
+    void TextSearch::runJob(Job& job) {
+        const size_t segmentCount = job.boundaries.size() - 1;
+        std::string scratch;
+        std::vector<SearchMatch> found;
+
+        for (;;) {
+            const size_t claimed = job.nextSegment.fetch_add(1, std::memory_order_relaxed);
+            if (claimed >= segmentCount || job.cancelled.load(std::memory_order_relaxed)) {
+                return;
+            }
+
+            const size_t segment = (job.firstSegment + claimed) % segmentCount;
+            found.clear();
+            size_t skipped{0};
+            {
+                DRITE_PROFILE_ZONE("searchSegment");
+                skipped = searchSegment(job, segment, scratch, found);
+            }
+            if (job.cancelled.load(std::memory_order_relaxed)) {
+                return;
+            }
+
+            // Only the first result since the last poll() wakes the UI
+            bool notify{false};
+            {
+                std::lock_guard lock(job.resultMutex);
+                const size_t kept = job.matchCount < MaxMatches ? std::min(found.size(), MaxMatches - job.matchCount) : 0;
+                job.results.insert(job.results.end(), found.begin(), found.begin() + static_cast<std::ptrdiff_t>(kept));
+                if (job.matchCount == 0 && !found.empty()) {
+                    job.firstResultSeconds = getSecondsSince(job.startTime);
+                }
+                job.matchCount += found.size();
+                job.skippedLines += skipped;
+                job.finishedSegments.push_back(segment);
+                if (++job.finishedCount == segmentCount) {
+                    job.seconds = getSecondsSince(job.startTime);
+                }
+                notify = !job.notified;
+                job.notified = true;
+            }
+            if (notify && m_resultCallback) {
+                m_resultCallback();
+            }
+        }
+    }
+
+    /**
+     * @brief Search one segment.
+     * @param job The job.
+     * @param segment The segment index.
+     * @param scratch Storage for segments spanning buffer pieces.
+     * @param found Receives the matches, in offset order.
+     * @return The number of lines skipped as too long.
+     */
+    size_t TextSearch::searchSegment(const Job& job, size_t segment, std::string& scratch, std::vector<SearchMatch>& found) {
+        const size_t begin = job.boundaries[segment];
+        const size_t end = job.boundaries[segment + 1];
+        if (begin == end) {
+            return 0;
+        }
+
+        // Read past the end so a literal holding a line feed can still match
+        // across the boundary; only matches starting in the segment count
+        const std::string_view text = job.snapshot.read(begin, end - begin + job.matcher.getOverlap(), scratch);
+        return job.matcher.findMatches(text, end - begin, begin, false, MaxMatches, &job.cancelled, found);
+    }
+
+}
@@ -0,0 +1,261 @@
+#pragma once
+
+#include "editor/text_buffer.h"
+#include "editor/text_snapshot.h"
+#include "search/pattern_matcher.h"
+#include "search/search_match.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace drite {
+
+    /**
+     * @brief Progress and timing of the current search.
+     */
+    struct SearchStats {
+        size_t bytesSearched{0};
+        size_t matchCount{0};
+        size_t skippedLines{0};
+        double firstResultSeconds{0.0};
+        double seconds{0.0};
+    };
+
+    /**
+     * @brief Searches a buffer on a pool of worker threads, streaming matches to the UI.
+     *
+     * The text is split into segments of about SegmentBytes that end at line
+     * boundaries. Workers claim segments in order starting from the one holding
+     * the start offset and wrapping around, so matches near the cursor arrive
+     * first. Each segment is matched by a PatternMatcher.
+     *
+     * Starting a search cancels the previous one: workers drop it after the
+     * segment, or for regular expressions the line, they are working on.
+     */
+    class TextSearch {
+        public:
+            /**
+             * @brief Target size of the segments claimed by workers.
+             */
+            static constexpr size_t SegmentBytes = size_t{1} << 20;
+
+            /**
+             * @brief Matches kept per search; later ones are only counted.
+             */
+            static constexpr size_t MaxMatches = 1'000'000;
+
+            /**
+             * @brief Construct a new Text Search object; the workers start with the first search.
+             * @param threadCount Number of worker threads; 0 picks one per core.
+             */
+            explicit TextSearch(unsigned threadCount = 0);
+
+            /**
+             * @brief Destroy the Text Search object, cancelling the search and joining the workers.
+             */
+            ~TextSearch();
+
+            TextSearch(const TextSearch&) = delete;
+            TextSearch& operator=(const TextSearch&) = delete;
+
+            /**
+             * @brief Set the function called from a worker when results are ready for poll().
+             * @param callback The callback, e.g. one that wakes the main loop.
+             */
+            void setResultCallback(std::function<void()> callback) { m_resultCallback = std::move(callback); }
+
+            /**
+             * @brief Cancel the current search and start a new one.
+             * @param buffer The buffer to search; its text is captured, so it may be closed while the search runs.
+             * @param query The query; an empty pattern only cancels.
+             * @param startOffset The offset searched first, usually the cursor.
+             * @return False if the query is not a valid regular expression.
+             */
+            bool start(const TextBuffer& buffer, const SearchQuery& query, size_t startOffset);
+
+            /**
+             * @brief Cancel the current search and drop its matches.
+             */
+            void cancel();
+
+            /**
+             * @brief Pick up the matches found since the last call.
+             * @return True if matches were added or the search finished.
+             */
+            bool poll();
+
+            /**
+             * @brief Check whether a search is active.
+             * @return True between start() and cancel(), including after the search finished.
+             */
+            [[nodiscard]] bool isActive() const noexcept { return m_job != nullptr; }
+
+            /**
+             * @brief Check whether every segment was searched.
+             * @return True once poll() saw the last segment finish.
+             */
+            [[nodiscard]] bool isComplete() const noexcept { return m_job && m_finishedCount == m_finished.size(); }
+
+            /**
+             * @brief Get the matches picked up so far, sorted by offset.
+             * @return The matches.
+             */
+            [[nodiscard]] const std::vector<SearchMatch>& getMatches() const noexcept { return m_matches; }
+
+            /**
+             * @brief Get the first match at or after the start offset, wrapping around.
+             *
+             * A match is only returned once every segment searched before it has
+             * finished, so a closer match cannot arrive later.
+             *
+             * @return The match, or nullptr if not yet known or there is none.
+             */
+            [[nodiscard]] const SearchMatch* getFirstMatch() const noexcept;
+
+            /**
+             * @brief Get the progress and timing of the current search.
+             * @return The stats, as of the last poll().
+             */
+            [[nodiscard]] const SearchStats& getStats() const noexcept { return m_stats; }
+
+            /**
+             * @brief Get the number of worker threads.
+             * @return The thread count.
+             */
+            [[nodiscard]] unsigned getThreadCount() const noexcept { return m_threadCount; }
+
+        private:
+            /**
+             * @brief One search, shared by the UI thread and the workers.
+             */
+            struct Job {
+                uint64_t id{0};
+                PatternMatcher matcher;
+                TextSnapshot snapshot;
+                std::vector<size_t> boundaries;
+                size_t startOffset{0};
+                size_t firstSegment{0};
+                std::chrono::steady_clock::time_point startTime;
+                std::atomic<size_t> nextSegment{0};
+                std::atomic<bool> cancelled{false};
+
+                // Guarded by resultMutex
+                std::mutex resultMutex;
+                std::vector<SearchMatch> results;
+                std::vector<size_t> finishedSegments;
+                size_t finishedCount{0};
+                size_t matchCount{0};
+                size_t skippedLines{0};
+                double firstResultSeconds{0.0};
+                double seconds{0.0};
+                bool notified{false};
+            };
+
+            /**
+             * @brief Start the worker threads if they are not running yet.
+             */
+            void startWorkers();
+
+            /**
+             * @brief Worker thread body: wait for a search, help run it, repeat until stopped.
+             */
+            void workerLoop();
+
+            /**
+             * @brief Claim and search segments of a job until none are left or it is cancelled.
+             * @param job The job.
+             */
+            void runJob(Job& job);
+
+            /**
+             * @brief Search one segment.
+             * @param job The job.
+             * @param segment The segment index.
+             * @param scratch Storage for segments spanning buffer pieces.
+             * @param found Receives the matches, in offset order.
+             * @return The number of lines skipped as too long.
+             */
+            static size_t searchSegment(const Job& job, size_t segment, std::string& scratch, std::vector<SearchMatch>& found);
+
+        private:
+            /**
+             * @brief Called from a worker when results are ready for poll().
+             */
+            std::function<void()> m_resultCallback;
+
+            /**
+             * @brief The number of worker threads, started or not.
+             */
+            unsigned m_threadCount{0};
+
+            /**
+             * @brief The worker threads, empty until the first search.
+             */
+            std::vector<std::thread> m_workers;
+
+            /**
+             * @brief Guards the posted job and the stop flag.
+             */
+            std::mutex m_mutex;
+
+            /**
+             * @brief Signalled when a job is posted or the workers must stop.
+             */
+            std::condition_variable m_jobReady;
+
+            /**
+             * @brief The job for the workers, or nullptr when idle.
+             */
+            std::shared_ptr<Job> m_postedJob;
+
+            /**
+             * @brief Whether the workers must stop.
+             */
+            bool m_stopping{false};
+
+            /**
+             * @brief The current job, as seen by the UI thread.
+             */
+            std::shared_ptr<Job> m_job;
+
+            /**
+             * @brief Counter giving each job a distinct id.
+             */
+            uint64_t m_nextJobId{0};
+
+            /**
+             * @brief Matches picked up by poll(), sorted by offset.
+             */
+            std::vector<SearchMatch> m_matches;
+
+            /**
+             * @brief Which segments poll() saw finish.
+             */
+            std::vector<uint8_t> m_finished;
+
+            /**
+             * @brief Number of segments poll() saw finish.
+             */
+            size_t m_finishedCount{0};
+
+            /**
+             * @brief Number of segments finished without a gap, in search order from the first.
+             */
+            size_t m_finishedPrefix{0};
+
+            /**
+             * @brief Stats as of the last poll().
+             */
+            SearchStats m_stats;
+    };
+
+}
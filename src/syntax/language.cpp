@@ -0,0 +1,278 @@
+#include "syntax/language.h"
+#include <algorithm>
+#include <array>
+
+namespace drite {
+
+    static constexpr std::array<std::string_view, 11> CppExtensions{
+        "c", "cc", "cpp", "cxx", "h", "hh", "hpp", "hxx", "inl", "m", "mm"};
+
+    static constexpr std::array<std::string_view, 72> CppKeywords{
+        "alignas", "alignof", "asm", "break", "case", "catch", "class", "co_await", "co_return", "co_yield",
+        "concept", "const", "const_cast", "consteval", "constexpr", "constinit", "continue", "decltype",
+        "default", "delete", "do", "dynamic_cast", "else", "enum", "explicit", "export", "extern", "false",
+        "final", "for", "friend", "goto", "if", "inline", "mutable", "namespace", "new", "noexcept", "nullptr",
+        "operator", "override", "private", "protected", "public", "register", "reinterpret_cast", "requires",
+        "return", "sizeof", "static", "static_assert", "static_cast", "struct", "switch", "template", "this",
+        "thread_local", "throw", "true", "try", "typedef", "typeid", "typename", "union", "using", "virtual",
+        "volatile", "while"};
+
+    static constexpr std::array<std::string_view, 25> CppTypes{
+        "auto", "bool", "char", "char16_t", "char32_t", "char8_t", "double", "float", "int", "int16_t",
+        "int32_t", "int64_t", "int8_t", "long", "ptrdiff_t", "short", "signed", "size_t", "uint16_t",
+        "uint32_t", "uint64_t", "uint8_t", "unsigned", "void", "wchar_t"};
+
+    static constexpr std::array<std::string_view, 2> PythonExtensions{"py", "pyw"};
+
+    static constexpr std::array<std::string_view, 35> PythonKeywords{
+        "False", "None", "True", "and", "as", "assert", "async", "await", "break", "class", "continue", "def",
+        "del", "elif", "else", "except", "finally", "for", "from", "global", "if", "import", "in", "is",
+        "lambda", "nonlocal", "not", "or", "pass", "raise", "return", "try", "while", "with", "yield"};
+
+    static constexpr std::array<std::string_view, 10> PythonTypes{
+        "bool", "bytes", "dict", "float", "int", "list", "object", "set", "str", "tuple"};
+
+    static constexpr std::array<std::string_view, 6> JavaScriptExtensions{"cjs", "js", "jsx", "mjs", "ts", "tsx"};
+
+    static constexpr std::array<std::string_view, 42> JavaScriptKeywords{
+        "async", "await", "break", "case", "catch", "class", "const", "continue", "debugger", "default",
+        "delete", "do", "else", "export", "extends", "false", "finally", "for", "function", "if", "import",
+        "in", "instanceof", "let", "new", "null", "of", "return", "static", "super", "switch", "this",
+        "throw", "true", "try", "typeof", "undefined", "var", "void", "while", "with", "yield"};
+
+    static constexpr std::array<std::string_view, 8> JavaScriptTypes{
+        "Array", "Map", "Object", "Promise", "Set", "boolean", "number", "string"};
+
+    static constexpr std::array<Language, 3> Languages{{
+        {"C++", CppExtensions, CppKeywords, CppTypes, "//", "/*", "*/", true, false, false},
+        {"Python", PythonExtensions, PythonKeywords, PythonTypes, "#", "", "", false, true, false},
+        {"JavaScript", JavaScriptExtensions, JavaScriptKeywords, JavaScriptTypes, "//", "/*", "*/", false, false, true},
+    }};
+
+    /**
+     * @brief Check whether a byte can start an identifier.
+     * @param character The byte.
+     * @return True for letters, underscores and UTF-8 bytes.
+     */
+    static bool isIdentifierStart(unsigned char character) noexcept {
+        return (character >= 'a' && character <= 'z') || (character >= 'A' && character <= 'Z') ||
+               character == '_' || character >= 0x80;
+    }
+
+    /**
+     * @brief Check whether a byte can continue an identifier.
+     * @param character The byte.
+     * @return True for identifier start bytes and digits.
+     */
+    static bool isIdentifierPart(unsigned char character) noexcept {
+        return isIdentifierStart(character) || (character >= '0' && character <= '9');
+    }
+
+    /**
+     * @brief Check whether a byte is a decimal digit.
+     * @param character The byte.
+     * @return True for '0' to '9'.
+     */
+    static bool isDigit(unsigned char character) noexcept {
+        return character >= '0' && character <= '9';
+    }
+
+    /**
+     * @brief Append a token if the output is wanted and the run is not empty.
+     * @param tokens The output, may be nullptr.
+     * @param start The start of the run.
+     * @param end The end of the run.
+     * @param kind The token kind.
+     */
+    static void emit(std::vector<Token>* tokens, size_t start, size_t end, TokenKind kind) {
+        if (tokens && end > start) {
+            tokens->push_back(Token{static_cast<uint32_t>(start), static_cast<uint32_t>(end - start), kind});
+        }
+    }
+
+    /**
+     * @brief Find the end of a quoted run, honoring backslash escapes.
+     * @param line The line text.
+     * @param position The offset just after the opening quote.
+     * @param quote The closing delimiter.
+     * @return The offset just after the closing delimiter, or npos if the line ends first.
+     */
+    static size_t findClosingQuote(std::string_view line, size_t position, std::string_view quote) noexcept {
+        while (position < line.size()) {
+            if (line[position] == '\\') {
+                position += 2;
+                continue;
+            }
+            if (line.substr(position).starts_with(quote)) {
+                return position + quote.size();
+            }
+            ++position;
+        }
+        return std::string_view::npos;
+    }
+
+    /**
+     * @brief Pick the language of a file from its extension.
+     * @param path The file path.
+     * @return The language, or nullptr if the file is not highlighted.
+     */
+    const Language* detectLanguage(std::string_view path) noexcept {
+        const size_t dot = path.rfind('.');
+        const size_t slash = path.find_last_of("/\\");
+        if (dot == std::string_view::npos || (slash != std::string_view::npos && dot < slash)) {
+            return nullptr;
+        }
+
+        const std::string_view extension = path.substr(dot + 1);
+        for (const Language& language : Languages) {
+            if (std::ranges::find(language.extensions, extension) != language.extensions.end()) {
+                return &language;
+            }
+        }
+        return nullptr;
+    }
+
+    /**
+     * @brief Lex one line.
+     * @param language The language rules.
+     * @param line The line text without its terminator.
+     * @param state The state at the end of the previous line.
+     * @param tokens Receives the non-text tokens of the line if not nullptr.
+     * @return The state at the end of the line.
+     */
+    LexState tokenizeLine(const Language& language, std::string_view line, LexState state, std::vector<Token>* tokens) {
+        if (line.ends_with('\r')) {
+            line.remove_suffix(1);
+        }
+        const bool continued = !line.empty() && line.back() == '\\';
+        size_t position{0};
+
+        // Finish a construct left open by the previous line
+        switch (state) {
+            case LexBlockComment: {
+                const size_t end = line.find(language.blockCommentEnd);
+                if (end == std::string_view::npos) {
+                    emit(tokens, 0, line.size(), TokenKind::Comment);
+                    return LexBlockComment;
+                }
+                position = end + language.blockCommentEnd.size();
+                emit(tokens, 0, position, TokenKind::Comment);
+                break;
+            }
+
+            case LexPreprocessor:
+                emit(tokens, 0, line.size(), TokenKind::Preprocessor);
+                return continued ? LexPreprocessor : LexNormal;
+
+            case LexString:
+            case LexTripleSingle:
+            case LexTripleDouble:
+            case LexTemplate: {
+                const std::string_view quote = state == LexString ? "\"" : state == LexTripleSingle ? "'''" : state == LexTripleDouble ? "\"\"\"" : "`";
+                const size_t end = findClosingQuote(line, 0, quote);
+                if (end == std::string_view::npos) {
+                    emit(tokens, 0, line.size(), TokenKind::String);
+                    return state == LexString && !continued ? LexNormal : state;
+                }
+                emit(tokens, 0, end, TokenKind::String);
+                position = end;
+                break;
+            }
+
+            default:
+                break;
+        }
+
+        while (position < line.size()) {
+            const unsigned char character = static_cast<unsigned char>(line[position]);
+            const std::string_view rest = line.substr(position);
+
+            if (character == ' ' || character == '\t') {
+                ++position;
+                continue;
+            }
+
+            if (language.preprocessor && character == '#' && line.find_first_not_of(" \t") == position) {
+                emit(tokens, position, line.size(), TokenKind::Preprocessor);
+                return continued ? LexPreprocessor : LexNormal;
+            }
+
+            if (!language.lineComment.empty() && rest.starts_with(language.lineComment)) {
+                emit(tokens, position, line.size(), TokenKind::Comment);
+                return LexNormal;
+            }
+
+            if (!language.blockCommentStart.empty() && rest.starts_with(language.blockCommentStart)) {
+                const size_t end = line.find(language.blockCommentEnd, position + language.blockCommentStart.size());
+                if (end == std::string_view::npos) {
+                    emit(tokens, position, line.size(), TokenKind::Comment);
+                    return LexBlockComment;
+                }
+                emit(tokens, position, end + language.blockCommentEnd.size(), TokenKind::Comment);
+                position = end + language.blockCommentEnd.size();
+                continue;
+            }
+
+            if (language.tripleQuotedStrings && (rest.starts_with("'''") || rest.starts_with("\"\"\""))) {
+                const size_t end = findClosingQuote(line, position + 3, rest.substr(0, 3));
+                if (end == std::string_view::npos) {
+                    emit(tokens, position, line.size(), TokenKind::String);
+                    return character == '\'' ? LexTripleSingle : LexTripleDouble;
+                }
+                emit(tokens, position, end, TokenKind::String);
+                position = end;
+                continue;
+            }
+
+            if (character == '"' || character == '\'' || (language.templateStrings && character == '`')) {
+                const size_t end = findClosingQuote(line, position + 1, rest.substr(0, 1));
+                if (end == std::string_view::npos) {
+                    emit(tokens, position, line.size(), TokenKind::String);
+                    if (character == '`') {
+                        return LexTemplate;
+                    }
+                    return character == '"' && continued ? LexString : LexNormal;
+                }
+                emit(tokens, position, end, TokenKind::String);
+                position = end;
+                continue;
+            }
+
+            if (isDigit(character) || (character == '.' && rest.size() > 1 && isDigit(static_cast<unsigned char>(rest[1])))) {
+                const size_t start = position;
+                while (position < line.size()) {
+                    const unsigned char next = static_cast<unsigned char>(line[position]);
+                    const bool exponentSign = (next == '+' || next == '-') &&
+                        (line[position - 1] == 'e' || line[position - 1] == 'E' || line[position - 1] == 'p' || line[position - 1] == 'P');
+                    if (!isIdentifierPart(next) && next != '.' && next != '\'' && !exponentSign) {
+                        break;
+                    }
+                    ++position;
+                }
+                emit(tokens, start, position, TokenKind::Number);
+                continue;
+            }
+
+            if (isIdentifierStart(character)) {
+                const size_t start = position;
+                while (position < line.size() && isIdentifierPart(static_cast<unsigned char>(line[position]))) {
+                    ++position;
+                }
+                if (tokens) {
+                    const std::string_view word = line.substr(start, position - start);
+                    if (std::ranges::binary_search(language.keywords, word)) {
+                        emit(tokens, start, position, TokenKind::Keyword);
+                    } else if (std::ranges::binary_search(language.types, word)) {
+                        emit(tokens, start, position, TokenKind::Type);
+                    }
+                }
+                continue;
+            }
+
+            ++position;
+        }
+
+        return LexNormal;
+    }
+
+}
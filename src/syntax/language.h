@@ -0,0 +1,95 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <string_view>
+#include <vector>
+
+namespace drite {
+
+    /**
+     * @brief Lexer state carried from the end of one line to the start of the next.
+     */
+    using LexState = uint32_t;
+
+    /**
+     * @brief Lexer states shared by the built-in languages.
+     */
+    enum LexStates : LexState {
+        LexNormal = 0,
+        LexBlockComment = 1,
+        LexPreprocessor = 2,
+        LexString = 3,
+        LexTripleSingle = 4,
+        LexTripleDouble = 5,
+        LexTemplate = 6,
+
+        /**
+         * @brief Flag on a state guessed by lexing from a nearby line instead of the top of the file.
+         */
+        LexProvisional = 0x80000000u,
+
+        /**
+         * @brief A state that has not been computed.
+         */
+        LexUnknown = 0xFFFFFFFFu
+    };
+
+    /**
+     * @brief Highlighting category of a run of text.
+     */
+    enum class TokenKind : uint8_t {
+        Text,
+        Keyword,
+        Type,
+        String,
+        Number,
+        Comment,
+        Preprocessor
+    };
+
+    /**
+     * @brief A highlighted run of a line.
+     */
+    struct Token {
+        uint32_t start{0};
+        uint32_t length{0};
+        TokenKind kind{TokenKind::Text};
+    };
+
+    /**
+     * @brief Lexical rules of a language.
+     *
+     * Keyword and type lists must be sorted so lookups can binary search.
+     */
+    struct Language {
+        std::string_view name;
+        std::span<const std::string_view> extensions;
+        std::span<const std::string_view> keywords;
+        std::span<const std::string_view> types;
+        std::string_view lineComment;
+        std::string_view blockCommentStart;
+        std::string_view blockCommentEnd;
+        bool preprocessor{false};
+        bool tripleQuotedStrings{false};
+        bool templateStrings{false};
+    };
+
+    /**
+     * @brief Pick the language of a file from its extension.
+     * @param path The file path.
+     * @return The language, or nullptr if the file is not highlighted.
+     */
+    [[nodiscard]] const Language* detectLanguage(std::string_view path) noexcept;
+
+    /**
+     * @brief Lex one line.
+     * @param language The language rules.
+     * @param line The line text without its terminator.
+     * @param state The state at the end of the previous line.
+     * @param tokens Receives the non-text tokens of the line if not nullptr.
+     * @return The state at the end of the line.
+     */
+    [[nodiscard]] LexState tokenizeLine(const Language& language, std::string_view line, LexState state, std::vector<Token>* tokens);
+
+}
@@ -0,0 +1,680 @@
+#include "syntax/syntax_highlighter.h"
+#include "core/profiler.h"
+#include "editor/newline_scanner.h"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <string>
+
+namespace drite {
+
+    /**
+     * @brief Move a read position at the end of a chunk to the start of the next one.
+     * @param chunks The snapshot chunks.
+     * @param chunk The chunk index; advanced if at the end.
+     * @param offset The offset in the chunk; reset if at the end.
+     */
+    static void normalizePosition(const std::vector<std::string_view>& chunks, size_t& chunk, size_t& offset) noexcept {
+        while (chunk < chunks.size() && offset == chunks[chunk].size()) {
+            ++chunk;
+            offset = 0;
+        }
+    }
+
+    /**
+     * @brief Get the state at the end of a line.
+     * @param line The line index.
+     * @return The state, possibly flagged LexProvisional, or LexUnknown.
+     */
+    LexState HighlightTable::getEndState(size_t line) const noexcept {
+        if (line >= lineCount || blocks.empty()) {
+            return LexUnknown;
+        }
+
+        const size_t block = static_cast<size_t>(std::upper_bound(blockFirstLines.begin(), blockFirstLines.end(), line) - blockFirstLines.begin()) - 1;
+        return blocks[block]->states[line - blockFirstLines[block]];
+    }
+
+    /**
+     * @brief Construct a new Syntax Highlighter object.
+     */
+    SyntaxHighlighter::SyntaxHighlighter() = default;
+
+    /**
+     * @brief Destroy the Syntax Highlighter object, stopping its thread.
+     */
+    SyntaxHighlighter::~SyntaxHighlighter() {
+        shutdown();
+    }
+
+    /**
+     * @brief Start highlighting a buffer, discarding the results for the previous one.
+     * @param buffer The buffer; must outlive the highlighter or the next attach().
+     * @param language The language rules, or nullptr to stop highlighting.
+     * @param states Results for the buffer from an earlier attach() or session, only lexed where inexact; ignored unless its revision and line count match the buffer.
+     */
+    void SyntaxHighlighter::attach(const TextBuffer& buffer, const Language* language, std::shared_ptr<const HighlightTable> states) {
+        m_buffer = &buffer;
+        m_language = language;
+        m_revision = buffer.getRevision();
+        m_table.reset();
+        m_unpublished.clear();
+        m_window = Window{};
+        ++m_generation;
+
+        if (!language) {
+            return;
+        }
+
+        Job job;
+        job.generation = m_generation;
+        job.revision = m_revision;
+        job.language = language;
+        job.snapshot = TextSnapshot::capture(buffer);
+
+        // Earlier results are shown right away, before the thread picks them up
+        if (states && states->revision == m_revision && states->lineCount == buffer.getLineCount() && !states->blocks.empty()) {
+            auto table = std::make_shared<HighlightTable>(*states);
+            table->generation = m_generation;
+            m_table = table;
+            job.states = std::move(table);
+        }
+        {
+            std::lock_guard lock(m_mutex);
+            m_job = std::move(job);
+        }
+        m_wake.notify_one();
+
+        if (!m_thread.joinable()) {
+            m_thread = std::thread([this] { run(); });
+        }
+    }
+
+    /**
+     * @brief Stop the highlighter thread.
+     */
+    void SyntaxHighlighter::shutdown() {
+        {
+            std::lock_guard lock(m_mutex);
+            m_stop = true;
+        }
+        m_wake.notify_one();
+
+        if (m_thread.joinable()) {
+            m_thread.join();
+        }
+        m_language = nullptr;
+    }
+
+    /**
+     * @brief Hand edits and the visible lines to the highlighter thread and pick up its latest results.
+     * @param buffer The attached buffer.
+     * @param change The lines changed since the last call, from TextBuffer::takeLineChange().
+     * @param firstLine The first visible line.
+     * @param lineCount The number of visible lines.
+     * @return True if the states of the visible lines may have changed since the last call.
+     */
+    bool SyntaxHighlighter::update(const TextBuffer& buffer, const std::optional<LineChange>& change, size_t firstLine, size_t lineCount) {
+        if (!m_language || &buffer != m_buffer) {
+            return false;
+        }
+        bool changed{false};
+
+        if (buffer.getRevision() != m_revision) {
+            m_revision = buffer.getRevision();
+            changed = true;
+
+            // Without a change every line has to be treated as edited
+            const LineChange edited = change.value_or(LineChange{0, SIZE_MAX, 0});
+            m_unpublished.emplace_back(m_revision, edited);
+
+            Job job;
+            job.generation = m_generation;
+            job.revision = m_revision;
+            job.language = m_language;
+            job.snapshot = TextSnapshot::capture(buffer);
+            {
+                std::lock_guard lock(m_mutex);
+                if (m_job && m_job->change && change) {
+                    job.change = m_job->change;
+                    job.change->merge(*change);
+                } else if (!m_job) {
+                    job.change = change;
+                }
+                if (job.change) {
+                    job.changeOffset = buffer.getLineStart(job.change->firstLine);
+                }
+                m_job = std::move(job);
+            }
+            m_wake.notify_one();
+        }
+
+        if (changed || firstLine != m_window.firstLine || lineCount != m_window.lineCount) {
+            changed = true;
+            m_window.firstLine = firstLine;
+            m_window.lineCount = lineCount;
+            m_window.syncLine = firstLine > SyncLines + 1 ? firstLine - 1 - SyncLines : 0;
+            m_window.syncOffset = buffer.getLineStart(m_window.syncLine);
+            m_window.revision = m_revision;
+            {
+                std::lock_guard lock(m_mutex);
+                m_postedWindow = m_window;
+            }
+            m_wake.notify_one();
+        }
+
+        std::shared_ptr<const HighlightTable> table;
+        {
+            std::lock_guard lock(m_publishMutex);
+            table = m_published;
+        }
+        if (table && table != m_table && table->generation == m_generation) {
+            m_table = std::move(table);
+            std::erase_if(m_unpublished, [&](const auto& entry) { return entry.first <= m_table->revision; });
+            changed = true;
+        }
+
+        return changed;
+    }
+
+    /**
+     * @brief Get the state at the start of each visible line.
+     * @param buffer The attached buffer.
+     * @param firstLine The first visible line.
+     * @param lineCount The number of visible lines.
+     * @param states Receives one state per line, LexUnknown while not yet known.
+     * @param scratch Memory for the line text, e.g. of the frame arena.
+     */
+    void SyntaxHighlighter::getLineStates(const TextBuffer& buffer, size_t firstLine, size_t lineCount, std::vector<LexState>& states,
+                                          std::pmr::memory_resource* scratch) const {
+        states.clear();
+        if (!m_language || &buffer != m_buffer) {
+            return;
+        }
+
+        // Carry the state down from the first line so edits not yet seen by
+        // the highlighter thread are still highlighted correctly
+        LexState state = getStartState(firstLine);
+        const size_t lastLine = std::min(buffer.getLineCount(), firstLine + lineCount);
+        std::pmr::string text(scratch);
+        for (size_t line = firstLine; line < lastLine; ++line) {
+            states.push_back(state);
+            if (state != LexUnknown) {
+                buffer.getText(buffer.getLineStart(line), buffer.getLineLength(line), text);
+                state = tokenizeLine(*m_language, text, state, nullptr);
+            }
+        }
+    }
+
+    /**
+     * @brief Find the start of a line in a snapshot.
+     * @param snapshot The snapshot.
+     * @param line The line index, below the snapshot line count.
+     * @return The read position.
+     */
+    SyntaxHighlighter::ReadPosition SyntaxHighlighter::seekLine(const TextSnapshot& snapshot, size_t line) {
+        ReadPosition position{0, 0, line};
+        if (line > 0) {
+            // The last chunk with fewer line feeds before it than the line index holds its preceding line feed
+            const std::vector<size_t>& lineFeeds = snapshot.chunkLineFeeds;
+            position.chunk = static_cast<size_t>(std::lower_bound(lineFeeds.begin(), lineFeeds.end(), line) - lineFeeds.begin()) - 1;
+            const std::string_view chunk = snapshot.chunks[position.chunk];
+            position.offset = findLineFeed(chunk.data(), chunk.size(), line - lineFeeds[position.chunk]) + 1;
+        }
+        normalizePosition(snapshot.chunks, position.chunk, position.offset);
+        return position;
+    }
+
+    /**
+     * @brief Get the read position of a byte offset in a snapshot.
+     * @param snapshot The snapshot.
+     * @param offset The byte offset of the start of a line.
+     * @param line The index of that line.
+     * @return The read position.
+     */
+    SyntaxHighlighter::ReadPosition SyntaxHighlighter::seekOffset(const TextSnapshot& snapshot, size_t offset, size_t line) {
+        ReadPosition position{0, 0, line};
+        if (!snapshot.chunks.empty()) {
+            position.chunk = snapshot.findChunk(offset);
+            position.offset = offset - snapshot.chunkOffsets[position.chunk];
+        }
+        normalizePosition(snapshot.chunks, position.chunk, position.offset);
+        return position;
+    }
+
+    /**
+     * @brief Read the line at a position and advance past its terminator.
+     * @param snapshot The snapshot.
+     * @param position The read position; advanced to the next line.
+     * @param scratch Storage for lines spanning chunks.
+     * @return The line text without its terminator.
+     */
+    std::string_view SyntaxHighlighter::readLine(const TextSnapshot& snapshot, ReadPosition& position, std::string& scratch) {
+        const std::vector<std::string_view>& chunks = snapshot.chunks;
+        ++position.line;
+        scratch.clear();
+        bool spanning{false};
+        while (position.chunk < chunks.size()) {
+            const char* begin = chunks[position.chunk].data() + position.offset;
+            const size_t remaining = chunks[position.chunk].size() - position.offset;
+            const auto* lineFeed = static_cast<const char*>(std::memchr(begin, '\n', remaining));
+            if (!lineFeed) {
+                snapshot.touch(std::string_view(begin, remaining));
+                scratch.append(begin, remaining);
+                spanning = true;
+                ++position.chunk;
+                position.offset = 0;
+                continue;
+            }
+
+            const size_t length = static_cast<size_t>(lineFeed - begin);
+            snapshot.touch(std::string_view(begin, length + 1));
+            position.offset += length + 1;
+            normalizePosition(chunks, position.chunk, position.offset);
+            if (!spanning) {
+                return std::string_view(begin, length);
+            }
+            scratch.append(begin, length);
+            return scratch;
+        }
+        return scratch;
+    }
+
+    /**
+     * @brief Get the state at the start of a line from the adopted table.
+     * @param line The line in the current buffer numbering.
+     * @return The state without the provisional flag, or LexUnknown.
+     */
+    LexState SyntaxHighlighter::getStartState(size_t line) const noexcept {
+        if (line == 0) {
+            return LexNormal;
+        }
+        if (!m_table) {
+            return LexUnknown;
+        }
+
+        // Map the previous line back through the edits the table has not seen
+        size_t previous = line - 1;
+        for (auto entry = m_unpublished.rbegin(); entry != m_unpublished.rend(); ++entry) {
+            const LineChange& change = entry->second;
+            if (previous > change.lastLine) {
+                previous = static_cast<size_t>(static_cast<ptrdiff_t>(previous) - change.lineDelta);
+            } else if (previous >= change.firstLine) {
+                return LexUnknown;
+            }
+        }
+
+        const LexState state = m_table->getEndState(previous);
+        return state == LexUnknown ? LexUnknown : state & ~LexProvisional;
+    }
+
+    /**
+     * @brief Highlighter thread body: apply jobs and lex until stopped.
+     */
+    void SyntaxHighlighter::run() {
+        if (Profiler::isEnabled()) {
+            Profiler::setThreadName("highlighter");
+        }
+
+        Window window;
+        while (true) {
+            std::optional<Job> job;
+            {
+                std::unique_lock lock(m_mutex);
+                m_wake.wait(lock, [&] {
+                    return m_stop || m_job || m_postedWindow.firstLine != window.firstLine ||
+                           m_postedWindow.revision != window.revision || hasWork(window);
+                });
+                if (m_stop) {
+                    return;
+                }
+                job = std::exchange(m_job, std::nullopt);
+                window = m_postedWindow;
+            }
+
+            DRITE_PROFILE_ZONE("highlight");
+            if (job) {
+                applyJob(*job);
+            }
+            if (!m_worker.language) {
+                continue;
+            }
+
+            lexWindow(window);
+            lexBatch();
+            publish();
+
+            // Wake the UI when the state its visible lines start from changed,
+            // or when an edit was first processed
+            const size_t line = window.firstLine > 0 ? window.firstLine - 1 : 0;
+            const LexState state = window.firstLine > 0 && window.firstLine <= m_worker.lineCount ? getState(line) : LexNormal;
+            if (state != m_worker.notifiedState || line != m_worker.notifiedLine || m_worker.revision != m_worker.notifiedRevision) {
+                m_worker.notifiedState = state;
+                m_worker.notifiedLine = line;
+                m_worker.notifiedRevision = m_worker.revision;
+                if (m_publishCallback) {
+                    m_publishCallback();
+                }
+            }
+        }
+    }
+
+    /**
+     * @brief Check whether the highlighter thread has lines left to lex.
+     * @param window The visible lines.
+     * @return True if there is work.
+     */
+    bool SyntaxHighlighter::hasWork(const Window& window) const noexcept {
+        if (!m_worker.language) {
+            return false;
+        }
+        if (m_worker.cursor < m_worker.lineCount) {
+            return true;
+        }
+        return window.firstLine > 0 && window.firstLine <= m_worker.lineCount && getState(window.firstLine - 1) == LexUnknown;
+    }
+
+    /**
+     * @brief Apply a job to the state cache.
+     * @param job The job.
+     */
+    void SyntaxHighlighter::applyJob(Job& job) {
+        const bool reset = job.generation != m_worker.generation || !job.change;
+        m_worker.generation = job.generation;
+        m_worker.revision = job.revision;
+        m_worker.language = job.language;
+        m_worker.snapshot = std::move(job.snapshot);
+        m_worker.positioned = false;
+
+        if (reset) {
+            if (job.states) {
+                adoptStates(*job.states);
+            } else {
+                resetStates(m_worker.snapshot.lineCount);
+            }
+            m_worker.notifiedState = LexUnknown;
+            return;
+        }
+
+        // The change replaced lines [first, first + removed) with [first, last]
+        const LineChange& change = *job.change;
+        const size_t inserted = change.lastLine - change.firstLine + 1;
+        const size_t removed = static_cast<size_t>(static_cast<ptrdiff_t>(inserted) - change.lineDelta);
+        if (change.firstLine + removed > m_worker.lineCount || m_worker.lineCount - removed + inserted != m_worker.snapshot.lineCount) {
+            resetStates(m_worker.snapshot.lineCount);
+            return;
+        }
+        replaceStates(change.firstLine, removed, inserted);
+
+        if (change.firstLine <= m_worker.cursor) {
+            m_worker.cursor = change.firstLine;
+            m_worker.position = seekOffset(m_worker.snapshot, job.changeOffset, change.firstLine);
+            m_worker.positioned = true;
+        }
+    }
+
+    /**
+     * @brief Lex the lines above the visible region if its start state is unknown.
+     * @param window The visible lines.
+     */
+    void SyntaxHighlighter::lexWindow(const Window& window) {
+        if (window.firstLine == 0 || window.firstLine > m_worker.lineCount) {
+            return;
+        }
+        const size_t target = window.firstLine - 1;
+        if (getState(target) != LexUnknown) {
+            return;
+        }
+
+        // Start from the UI's offset when it matches this snapshot; otherwise search for the line
+        const size_t syncLine = std::min(window.syncLine, target);
+        ReadPosition position = window.revision == m_worker.revision && syncLine == window.syncLine
+            ? seekOffset(m_worker.snapshot, window.syncOffset, syncLine)
+            : seekLine(m_worker.snapshot, syncLine);
+
+        // Guessed states stay provisional until the sequential pass reaches them
+        LexState state = syncLine == 0 ? LexNormal : getState(syncLine - 1);
+        if (state == LexUnknown) {
+            state = LexNormal | LexProvisional;
+        }
+
+        std::string scratch;
+        for (size_t line = syncLine; line <= target; ++line) {
+            const std::string_view text = readLine(m_worker.snapshot, position, scratch);
+            const LexState existing = getState(line);
+            if (!(existing & LexProvisional)) {
+                state = existing;
+                continue;
+            }
+            state = tokenizeLine(*m_worker.language, text, state & ~LexProvisional, nullptr) | (state & LexProvisional);
+            setState(line, state);
+        }
+    }
+
+    /**
+     * @brief Lex one batch from the sequential cursor, stopping early where states converge.
+     */
+    void SyntaxHighlighter::lexBatch() {
+        if (m_worker.cursor >= m_worker.lineCount) {
+            return;
+        }
+        if (!m_worker.positioned || m_worker.position.line != m_worker.cursor) {
+            m_worker.position = seekLine(m_worker.snapshot, m_worker.cursor);
+            m_worker.positioned = true;
+        }
+
+        // Every state above the cursor is exact
+        LexState state = m_worker.cursor == 0 ? LexNormal : getState(m_worker.cursor - 1);
+        const size_t end = std::min(m_worker.lineCount, m_worker.cursor + BatchLines);
+        std::string scratch;
+        while (m_worker.cursor < end) {
+            const std::string_view text = readLine(m_worker.snapshot, m_worker.position, scratch);
+            state = tokenizeLine(*m_worker.language, text, state, nullptr);
+            const LexState previous = getState(m_worker.cursor);
+            ++m_worker.cursor;
+            if (previous == state) {
+                // The rest agrees with what was lexed before; skip to lines never lexed
+                m_worker.cursor = findInexact(m_worker.cursor);
+                break;
+            }
+            setState(m_worker.cursor - 1, state);
+        }
+    }
+
+    /**
+     * @brief Publish the state cache as a new table.
+     */
+    void SyntaxHighlighter::publish() {
+        auto table = std::make_shared<HighlightTable>();
+        table->generation = m_worker.generation;
+        table->revision = m_worker.revision;
+        table->lineCount = m_worker.lineCount;
+        table->blocks.assign(m_worker.blocks.begin(), m_worker.blocks.end());
+        table->blockFirstLines = m_worker.blockFirstLines;
+        for (const auto& block : m_worker.blocks) {
+            table->inexactLines += block->inexact;
+        }
+        // The previous table is released outside the lock
+        std::shared_ptr<const HighlightTable> previous = std::move(table);
+        {
+            std::lock_guard lock(m_publishMutex);
+            m_published.swap(previous);
+        }
+    }
+
+    /**
+     * @brief Reset the state cache to unknown states.
+     * @param lineCount The number of lines.
+     */
+    void SyntaxHighlighter::resetStates(size_t lineCount) {
+        m_worker.blocks.clear();
+        for (size_t first = 0; first < lineCount || m_worker.blocks.empty(); first += BlockLines) {
+            auto block = std::make_shared<HighlightTable::Block>();
+            const size_t count = std::min(BlockLines, lineCount - first);
+            block->states.assign(count, LexUnknown);
+            block->inexact = count;
+            m_worker.blocks.push_back(std::move(block));
+        }
+        m_worker.lineCount = lineCount;
+        m_worker.cursor = 0;
+        updateBlockFirstLines();
+    }
+
+    /**
+     * @brief Take over the states of a table, lexing only the lines it has no exact state for.
+     * @param table The table, matching the snapshot's line count.
+     */
+    void SyntaxHighlighter::adoptStates(const HighlightTable& table) {
+        // Blocks are never created const, and getMutableBlock() copies those
+        // still shared with a table before writing
+        m_worker.blocks.clear();
+        for (const std::shared_ptr<const HighlightTable::Block>& block : table.blocks) {
+            m_worker.blocks.push_back(std::const_pointer_cast<HighlightTable::Block>(block));
+        }
+        m_worker.lineCount = table.lineCount;
+        updateBlockFirstLines();
+        m_worker.cursor = findInexact(0);
+    }
+
+    /**
+     * @brief Replace a run of line states with unknown states.
+     * @param firstLine The first line replaced.
+     * @param removed The number of states removed.
+     * @param inserted The number of unknown states inserted.
+     */
+    void SyntaxHighlighter::replaceStates(size_t firstLine, size_t removed, size_t inserted) {
+        std::vector<std::shared_ptr<HighlightTable::Block>>& blocks = m_worker.blocks;
+
+        // Erase the removed states, dropping blocks that become empty
+        size_t index = findBlock(firstLine);
+        size_t local = firstLine - m_worker.blockFirstLines[index];
+        while (removed > 0 && index < blocks.size()) {
+            HighlightTable::Block& block = getMutableBlock(index);
+            const size_t count = std::min(removed, block.states.size() - local);
+            const auto first = block.states.begin() + static_cast<ptrdiff_t>(local);
+            block.inexact -= static_cast<size_t>(std::count_if(first, first + static_cast<ptrdiff_t>(count), [](LexState state) { return state & LexProvisional; }));
+            block.states.erase(first, first + static_cast<ptrdiff_t>(count));
+            removed -= count;
+            m_worker.lineCount -= count;
+
+            if (block.states.empty() && blocks.size() > 1) {
+                blocks.erase(blocks.begin() + static_cast<ptrdiff_t>(index));
+            } else {
+                ++index;
+            }
+            local = 0;
+        }
+        updateBlockFirstLines();
+
+        // Insert unknown states, splitting a block that grows too large
+        index = findBlock(firstLine);
+        local = firstLine - m_worker.blockFirstLines[index];
+        HighlightTable::Block& block = getMutableBlock(index);
+        block.states.insert(block.states.begin() + static_cast<ptrdiff_t>(local), inserted, LexUnknown);
+        block.inexact += inserted;
+        m_worker.lineCount += inserted;
+
+        if (block.states.size() > 2 * BlockLines) {
+            std::vector<LexState> states = std::move(block.states);
+            std::vector<std::shared_ptr<HighlightTable::Block>> split;
+            for (size_t first = 0; first < states.size(); first += BlockLines) {
+                auto part = std::make_shared<HighlightTable::Block>();
+                const auto begin = states.begin() + static_cast<ptrdiff_t>(first);
+                part->states.assign(begin, begin + static_cast<ptrdiff_t>(std::min(BlockLines, states.size() - first)));
+                part->inexact = static_cast<size_t>(std::count_if(part->states.begin(), part->states.end(), [](LexState state) { return state & LexProvisional; }));
+                split.push_back(std::move(part));
+            }
+            blocks.erase(blocks.begin() + static_cast<ptrdiff_t>(index));
+            blocks.insert(blocks.begin() + static_cast<ptrdiff_t>(index), split.begin(), split.end());
+        }
+        updateBlockFirstLines();
+    }
+
+    /**
+     * @brief Recompute the first line of each block.
+     */
+    void SyntaxHighlighter::updateBlockFirstLines() {
+        m_worker.blockFirstLines.resize(m_worker.blocks.size());
+        size_t line{0};
+        for (size_t i = 0; i < m_worker.blocks.size(); ++i) {
+            m_worker.blockFirstLines[i] = line;
+            line += m_worker.blocks[i]->states.size();
+        }
+    }
+
+    /**
+     * @brief Get the block holding a line.
+     * @param line The line index.
+     * @return The block index.
+     */
+    size_t SyntaxHighlighter::findBlock(size_t line) const noexcept {
+        const std::vector<size_t>& firstLines = m_worker.blockFirstLines;
+        const auto block = std::upper_bound(firstLines.begin(), firstLines.end(), line);
+        return block == firstLines.begin() ? 0 : static_cast<size_t>(block - firstLines.begin()) - 1;
+    }
+
+    /**
+     * @brief Get a block for writing, copying it if a published table still shares it.
+     * @param block The block index.
+     * @return The block.
+     */
+    HighlightTable::Block& SyntaxHighlighter::getMutableBlock(size_t block) {
+        std::shared_ptr<HighlightTable::Block>& shared = m_worker.blocks[block];
+        if (shared.use_count() > 1) {
+            shared = std::make_shared<HighlightTable::Block>(*shared);
+        } else {
+            // Pairs with the release in the last reader's reference drop
+            std::atomic_thread_fence(std::memory_order_acquire);
+        }
+        return *shared;
+    }
+
+    /**
+     * @brief Get the cached end state of a line.
+     * @param line The line index.
+     * @return The state.
+     */
+    LexState SyntaxHighlighter::getState(size_t line) const noexcept {
+        const size_t block = findBlock(line);
+        return m_worker.blocks[block]->states[line - m_worker.blockFirstLines[block]];
+    }
+
+    /**
+     * @brief Set the cached end state of a line.
+     * @param line The line index.
+     * @param state The state.
+     */
+    void SyntaxHighlighter::setState(size_t line, LexState state) {
+        const size_t index = findBlock(line);
+        HighlightTable::Block& block = getMutableBlock(index);
+        LexState& slot = block.states[line - m_worker.blockFirstLines[index]];
+        block.inexact = block.inexact - ((slot & LexProvisional) ? 1 : 0) + ((state & LexProvisional) ? 1 : 0);
+        slot = state;
+    }
+
+    /**
+     * @brief Find the first line at or after a line whose state is unknown or provisional.
+     * @param line The line to start from.
+     * @return The line, or the line count if every state is exact.
+     */
+    size_t SyntaxHighlighter::findInexact(size_t line) const noexcept {
+        if (line >= m_worker.lineCount) {
+            return m_worker.lineCount;
+        }
+
+        for (size_t index = findBlock(line); index < m_worker.blocks.size(); ++index) {
+            const HighlightTable::Block& block = *m_worker.blocks[index];
+            if (block.inexact == 0) {
+                continue;
+            }
+            const size_t first = m_worker.blockFirstLines[index];
+            for (size_t i = line > first ? line - first : 0; i < block.states.size(); ++i) {
+                if (block.states[i] & LexProvisional) {
+                    return first + i;
+                }
+            }
+        }
+        return m_worker.lineCount;
+    }
+
+}
@@ -0,0 +1,416 @@
+#pragma once
+
+#include "editor/text_buffer.h"
+#include "editor/text_snapshot.h"
+#include "syntax/language.h"
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace drite {
+
+    /**
+     * @brief Lexer states at the end of every line of a document, as published by the highlighter thread.
+     *
+     * A published table is immutable. Its states are split into blocks shared
+     * with later tables, so publishing copies block pointers, not states.
+     */
+    struct HighlightTable {
+        /**
+         * @brief End states of a run of consecutive lines.
+         */
+        struct Block {
+            std::vector<LexState> states;
+            size_t inexact{0};
+        };
+
+        uint64_t generation{0};
+        uint64_t revision{0};
+        size_t lineCount{0};
+        size_t inexactLines{0};
+        std::vector<std::shared_ptr<const Block>> blocks;
+        std::vector<size_t> blockFirstLines;
+
+        /**
+         * @brief Get the state at the end of a line.
+         * @param line The line index.
+         * @return The state, possibly flagged LexProvisional, or LexUnknown.
+         */
+        [[nodiscard]] LexState getEndState(size_t line) const noexcept;
+    };
+
+    /**
+     * @brief Incremental syntax highlighter running on a background thread.
+     *
+     * The highlighter thread caches the lexer state at the end of every line.
+     * After an edit it re-lexes from the first changed line only until a line
+     * ends in the state it ended in before, then skips ahead to lines not yet
+     * lexed. When the visible lines start in an unlexed region they are lexed
+     * first, from a guessed state a few lines up, and the rest of the file is
+     * filled in from the top afterwards.
+     *
+     * Results are published as an immutable HighlightTable by swapping one
+     * shared pointer. The UI thread only needs the state at the start of the
+     * first visible line and lexes the visible lines itself, so text edited
+     * since the last table is highlighted without waiting for the thread.
+     */
+    class SyntaxHighlighter {
+        public:
+            /**
+             * @brief Lines lexed between checks for new edits.
+             */
+            static constexpr size_t BatchLines = 8192;
+
+            /**
+             * @brief Lines above the visible region lexed to guess its start state when nothing above is known.
+             */
+            static constexpr size_t SyncLines = 1000;
+
+            /**
+             * @brief Target number of lines per state block.
+             */
+            static constexpr size_t BlockLines = 4096;
+
+            /**
+             * @brief Construct a new Syntax Highlighter object.
+             */
+            SyntaxHighlighter();
+
+            /**
+             * @brief Destroy the Syntax Highlighter object, stopping its thread.
+             */
+            ~SyntaxHighlighter();
+
+            SyntaxHighlighter(const SyntaxHighlighter&) = delete;
+            SyntaxHighlighter& operator=(const SyntaxHighlighter&) = delete;
+
+            /**
+             * @brief Set the function called from the highlighter thread when results for the visible lines change.
+             * @param callback The callback, e.g. one that wakes the main loop.
+             */
+            void setPublishCallback(std::function<void()> callback) { m_publishCallback = std::move(callback); }
+
+            /**
+             * @brief Start highlighting a buffer, discarding the results for the previous one.
+             * @param buffer The buffer; must outlive the highlighter or the next attach().
+             * @param language The language rules, or nullptr to stop highlighting.
+             * @param states Results for the buffer from an earlier attach() or session, only lexed where inexact; ignored unless its revision and line count match the buffer.
+             */
+            void attach(const TextBuffer& buffer, const Language* language, std::shared_ptr<const HighlightTable> states = nullptr);
+
+            /**
+             * @brief Stop the highlighter thread.
+             */
+            void shutdown();
+
+            /**
+             * @brief Hand edits and the visible lines to the highlighter thread and pick up its latest results.
+             * @param buffer The attached buffer.
+             * @param change The lines changed since the last call, from TextBuffer::takeLineChange().
+             * @param firstLine The first visible line.
+             * @param lineCount The number of visible lines.
+             * @return True if the states of the visible lines may have changed since the last call.
+             */
+            bool update(const TextBuffer& buffer, const std::optional<LineChange>& change, size_t firstLine, size_t lineCount);
+
+            /**
+             * @brief Get the state at the start of each visible line.
+             * @param buffer The attached buffer.
+             * @param firstLine The first visible line.
+             * @param lineCount The number of visible lines.
+             * @param states Receives one state per line, LexUnknown while not yet known.
+             * @param scratch Memory for the line text, e.g. of the frame arena.
+             */
+            void getLineStates(const TextBuffer& buffer, size_t firstLine, size_t lineCount, std::vector<LexState>& states,
+                               std::pmr::memory_resource* scratch = std::pmr::get_default_resource()) const;
+
+            /**
+             * @brief Get the language being highlighted.
+             * @return The language, or nullptr if highlighting is off.
+             */
+            [[nodiscard]] const Language* getLanguage() const noexcept { return m_language; }
+
+            /**
+             * @brief Get the results picked up by the last update().
+             * @return The table, or nullptr if nothing was published yet.
+             */
+            [[nodiscard]] const std::shared_ptr<const HighlightTable>& getTable() const noexcept { return m_table; }
+
+        private:
+            /**
+             * @brief A position in a snapshot at the start of a line.
+             */
+            struct ReadPosition {
+                size_t chunk{0};
+                size_t offset{0};
+                size_t line{0};
+            };
+
+            /**
+             * @brief Work handed from the UI thread to the highlighter thread.
+             */
+            struct Job {
+                uint64_t generation{0};
+                uint64_t revision{0};
+                const Language* language{nullptr};
+                TextSnapshot snapshot;
+                std::optional<LineChange> change;
+                size_t changeOffset{0};
+                std::shared_ptr<const HighlightTable> states;
+            };
+
+            /**
+             * @brief The lines visible in the UI.
+             */
+            struct Window {
+                size_t firstLine{0};
+                size_t lineCount{0};
+                size_t syncLine{0};
+                size_t syncOffset{0};
+                uint64_t revision{0};
+            };
+
+            /**
+             * @brief State owned by the highlighter thread.
+             */
+            struct WorkerState {
+                uint64_t generation{0};
+                uint64_t revision{0};
+                const Language* language{nullptr};
+                TextSnapshot snapshot;
+                std::vector<std::shared_ptr<HighlightTable::Block>> blocks;
+                std::vector<size_t> blockFirstLines;
+                size_t lineCount{0};
+                size_t cursor{0};
+                ReadPosition position;
+                bool positioned{false};
+                LexState notifiedState{LexUnknown};
+                size_t notifiedLine{0};
+                uint64_t notifiedRevision{0};
+            };
+
+            /**
+             * @brief Find the start of a line in a snapshot.
+             * @param snapshot The snapshot.
+             * @param line The line index, below the snapshot line count.
+             * @return The read position.
+             */
+            [[nodiscard]] static ReadPosition seekLine(const TextSnapshot& snapshot, size_t line);
+
+            /**
+             * @brief Get the read position of a byte offset in a snapshot.
+             * @param snapshot The snapshot.
+             * @param offset The byte offset of the start of a line.
+             * @param line The index of that line.
+             * @return The read position.
+             */
+            [[nodiscard]] static ReadPosition seekOffset(const TextSnapshot& snapshot, size_t offset, size_t line);
+
+            /**
+             * @brief Read the line at a position and advance past its terminator.
+             * @param snapshot The snapshot.
+             * @param position The read position; advanced to the next line.
+             * @param scratch Storage for lines spanning chunks.
+             * @return The line text without its terminator.
+             */
+            [[nodiscard]] static std::string_view readLine(const TextSnapshot& snapshot, ReadPosition& position, std::string& scratch);
+
+            /**
+             * @brief Get the state at the start of a line from the adopted table.
+             * @param line The line in the current buffer numbering.
+             * @return The state without the provisional flag, or LexUnknown.
+             */
+            [[nodiscard]] LexState getStartState(size_t line) const noexcept;
+
+            /**
+             * @brief Highlighter thread body: apply jobs and lex until stopped.
+             */
+            void run();
+
+            /**
+             * @brief Check whether the highlighter thread has lines left to lex.
+             * @param window The visible lines.
+             * @return True if there is work.
+             */
+            [[nodiscard]] bool hasWork(const Window& window) const noexcept;
+
+            /**
+             * @brief Apply a job to the state cache.
+             * @param job The job.
+             */
+            void applyJob(Job& job);
+
+            /**
+             * @brief Lex the lines above the visible region if its start state is unknown.
+             * @param window The visible lines.
+             */
+            void lexWindow(const Window& window);
+
+            /**
+             * @brief Lex one batch from the sequential cursor, stopping early where states converge.
+             */
+            void lexBatch();
+
+            /**
+             * @brief Publish the state cache as a new table.
+             */
+            void publish();
+
+            /**
+             * @brief Reset the state cache to unknown states.
+             * @param lineCount The number of lines.
+             */
+            void resetStates(size_t lineCount);
+
+            /**
+             * @brief Take over the states of a table, lexing only the lines it has no exact state for.
+             * @param table The table, matching the snapshot's line count.
+             */
+            void adoptStates(const HighlightTable& table);
+
+            /**
+             * @brief Replace a run of line states with unknown states.
+             * @param firstLine The first line replaced.
+             * @param removed The number of states removed.
+             * @param inserted The number of unknown states inserted.
+             */
+            void replaceStates(size_t firstLine, size_t removed, size_t inserted);
+
+            /**
+             * @brief Recompute the first line of each block.
+             */
+            void updateBlockFirstLines();
+
+            /**
+             * @brief Get the block holding a line.
+             * @param line The line index.
+             * @return The block index.
+             */
+            [[nodiscard]] size_t findBlock(size_t line) const noexcept;
+
+            /**
+             * @brief Get a block for writing, copying it if a published table still shares it.
+             * @param block The block index.
+             * @return The block.
+             */
+            [[nodiscard]] HighlightTable::Block& getMutableBlock(size_t block);
+
+            /**
+             * @brief Get the cached end state of a line.
+             * @param line The line index.
+             * @return The state.
+             */
+            [[nodiscard]] LexState getState(size_t line) const noexcept;
+
+            /**
+             * @brief Set the cached end state of a line.
+             * @param line The line index.
+             * @param state The state.
+             */
+            void setState(size_t line, LexState state);
+
+            /**
+             * @brief Find the first line at or after a line whose state is unknown or provisional.
+             * @param line The line to start from.
+             * @return The line, or the line count if every state is exact.
+             */
+            [[nodiscard]] size_t findInexact(size_t line) const noexcept;
+
+        private:
+            /**
+             * @brief Called from the highlighter thread when results for the visible lines change.
+             */
+            std::function<void()> m_publishCallback;
+
+            /**
+             * @brief The attached buffer.
+             */
+            const TextBuffer* m_buffer{nullptr};
+
+            /**
+             * @brief The language of the attached buffer.
+             */
+            const Language* m_language{nullptr};
+
+            /**
+             * @brief Attach counter, used to ignore tables for earlier buffers.
+             */
+            uint64_t m_generation{0};
+
+            /**
+             * @brief The last buffer revision handed to the thread.
+             */
+            uint64_t m_revision{0};
+
+            /**
+             * @brief The visible lines last handed to the thread.
+             */
+            Window m_window;
+
+            /**
+             * @brief The table picked up by the last update().
+             */
+            std::shared_ptr<const HighlightTable> m_table;
+
+            /**
+             * @brief Line changes posted after the revision of the adopted table, oldest first.
+             */
+            std::vector<std::pair<uint64_t, LineChange>> m_unpublished;
+
+            /**
+             * @brief The highlighter thread.
+             */
+            std::thread m_thread;
+
+            /**
+             * @brief Guards the job, the window and the stop flag.
+             */
+            std::mutex m_mutex;
+
+            /**
+             * @brief Signalled when a job or window is posted or the thread must stop.
+             */
+            std::condition_variable m_wake;
+
+            /**
+             * @brief The job waiting for the thread.
+             */
+            std::optional<Job> m_job;
+
+            /**
+             * @brief The visible lines for the thread.
+             */
+            Window m_postedWindow;
+
+            /**
+             * @brief Whether the thread must stop.
+             */
+            bool m_stop{false};
+
+            /**
+             * @brief Guards the published table pointer; held only to copy or swap it.
+             */
+            mutable std::mutex m_publishMutex;
+
+            /**
+             * @brief The latest table published by the thread.
+             */
+            std::shared_ptr<const HighlightTable> m_published;
+
+            /**
+             * @brief State owned by the highlighter thread.
+             */
+            WorkerState m_worker;
+    };
+
+}
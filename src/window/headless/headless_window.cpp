@@ -0,0 +1,182 @@
+#include "window/headless/headless_window.h"
+#include "platform/headless/headless_platform.h"
+#include <algorithm>
+
+namespace drite {
+
+HeadlessWindow::HeadlessWindow(HeadlessPlatform& platform)
+    : m_platform(platform) {
+    m_platform.registerWindow(this);
+}
+
+HeadlessWindow::~HeadlessWindow() {
+    m_platform.unregisterWindow(this);
+}
+
+bool HeadlessWindow::initialize(const WindowConfig& config) {
+    m_title = config.title;
+    m_width = config.width;
+    m_height = config.height;
+
+    m_graphicsContext = std::make_unique<HeadlessGraphicsContext>(m_width, m_height);
+    if (!m_graphicsContext->initialize()) {
+        return false;
+    }
+
+    m_graphicsContext->setVSync(config.vsync);
+    return true;
+}
+
+void HeadlessWindow::show() {
+    m_visible = true;
+}
+
+void HeadlessWindow::close() {
+    m_shouldClose = true;
+}
+
+bool HeadlessWindow::shouldClose() const {
+    return m_shouldClose;
+}
+
+void HeadlessWindow::getSize(int& width, int& height) const {
+    width = m_width;
+    height = m_height;
+}
+
+void HeadlessWindow::getFramebufferSize(int& width, int& height) const {
+    m_graphicsContext->getViewportSize(width, height);
+}
+
+void HeadlessWindow::getPosition(int& x, int& y) const {
+    x = 0;
+    y = 0;
+}
+
+void HeadlessWindow::setTitle(const std::string& title) {
+    m_title = title;
+}
+
+void HeadlessWindow::setSize(int width, int height) {
+    m_width = width;
+    m_height = height;
+    m_graphicsContext->resize(width, height);
+}
+
+bool HeadlessWindow::isFocused() const {
+    return m_visible;
+}
+
+bool HeadlessWindow::isMinimized() const {
+    return false;
+}
+
+GraphicsContext* HeadlessWindow::getGraphicsContext() {
+    return m_graphicsContext.get();
+}
+
+void HeadlessWindow::setKeyCallback(KeyCallback callback) {
+    m_keyCallback = callback;
+}
+
+void HeadlessWindow::setMouseCallback(MouseCallback callback) {
+    m_mouseCallback = callback;
+}
+
+void HeadlessWindow::setScrollCallback(ScrollCallback callback) {
+    m_scrollCallback = callback;
+}
+
+void HeadlessWindow::setResizeCallback(ResizeCallback callback) {
+    m_resizeCallback = callback;
+}
+
+void HeadlessWindow::setCloseCallback(CloseCallback callback) {
+    m_closeCallback = callback;
+}
+
+void HeadlessWindow::injectKeyEvent(const KeyEvent& event, double time) {
+    enqueue(time, event);
+}
+
+void HeadlessWindow::injectMouseEvent(const MouseEvent& event, double time) {
+    enqueue(time, event);
+}
+
+void HeadlessWindow::injectScrollEvent(const ScrollEvent& event, double time) {
+    enqueue(time, event);
+}
+
+void HeadlessWindow::injectResize(int width, int height, double time) {
+    enqueue(time, ResizeRequest{width, height});
+}
+
+void HeadlessWindow::injectClose(double time) {
+    enqueue(time, CloseRequest{});
+}
+
+void HeadlessWindow::dispatchEvents(double now) {
+    // Dispatch in timestamp order; callbacks may inject further events
+    size_t due{0};
+    while (due < m_pendingEvents.size() && m_pendingEvents[due].time <= now) {
+        ++due;
+    }
+    if (due == 0) {
+        return;
+    }
+
+    std::vector<PendingEvent> ready(std::make_move_iterator(m_pendingEvents.begin()),
+                                    std::make_move_iterator(m_pendingEvents.begin() + due));
+    m_pendingEvents.erase(m_pendingEvents.begin(), m_pendingEvents.begin() + due);
+
+    for (const PendingEvent& pending : ready) {
+        dispatch(pending.event);
+    }
+}
+
+bool HeadlessWindow::hasPendingEvents() const noexcept {
+    return !m_pendingEvents.empty();
+}
+
+double HeadlessWindow::getNextEventTime() const noexcept {
+    return m_pendingEvents.empty() ? 0.0 : m_pendingEvents.front().time;
+}
+
+void HeadlessWindow::enqueue(double time, Event event) {
+    // Keep the queue sorted by time, preserving injection order for equal times
+    auto position = std::upper_bound(m_pendingEvents.begin(), m_pendingEvents.end(), time,
+        [](double value, const PendingEvent& pending) { return value < pending.time; });
+    m_pendingEvents.insert(position, PendingEvent{time, std::move(event)});
+}
+
+bool HeadlessWindow::dumpFramebuffer(const std::string& path) const {
+    return m_graphicsContext != nullptr && m_graphicsContext->dumpFramebuffer(path);
+}
+
+void HeadlessWindow::dispatch(const Event& event) {
+    if (const auto* key = std::get_if<KeyEvent>(&event)) {
+        if (m_keyCallback) {
+            m_keyCallback(*key);
+        }
+    } else if (const auto* mouse = std::get_if<MouseEvent>(&event)) {
+        if (m_mouseCallback) {
+            m_mouseCallback(*mouse);
+        }
+    } else if (const auto* scroll = std::get_if<ScrollEvent>(&event)) {
+        if (m_scrollCallback) {
+            m_scrollCallback(*scroll);
+        }
+    } else if (const auto* resize = std::get_if<ResizeRequest>(&event)) {
+        setSize(resize->width, resize->height);
+        if (m_resizeCallback) {
+            m_resizeCallback(resize->width, resize->height);
+        }
+    } else if (std::holds_alternative<CloseRequest>(event)) {
+        m_shouldClose = true;
+        if (m_closeCallback) {
+            m_closeCallback();
+        }
+    }
+}
+
+} // namespace drite
@@ -0,0 +1,94 @@
+#pragma once
+
+#include "window/window.h"
+#include "graphics/headless/headless_graphics_context.h"
+#include <memory>
+#include <variant>
+#include <vector>
+
+namespace drite {
+
+class HeadlessPlatform;
+
+// Offscreen window for the headless platform. Input is injected with a
+// timestamp and delivered through the regular callbacks once the platform
+// clock reaches it.
+class HeadlessWindow : public Window {
+public:
+    explicit HeadlessWindow(HeadlessPlatform& platform);
+    ~HeadlessWindow() override;
+
+    [[nodiscard]] bool initialize(const WindowConfig& config) override;
+
+    void show() override;
+    void close() override;
+    [[nodiscard]] bool shouldClose() const override;
+
+    void getSize(int& width, int& height) const override;
+    void getFramebufferSize(int& width, int& height) const override;
+    void getPosition(int& x, int& y) const override;
+
+    void setTitle(const std::string& title) override;
+    void setSize(int width, int height) override;
+
+    [[nodiscard]] bool isFocused() const override;
+    [[nodiscard]] bool isMinimized() const override;
+
+    [[nodiscard]] GraphicsContext* getGraphicsContext() override;
+
+    void setKeyCallback(KeyCallback callback) override;
+    void setMouseCallback(MouseCallback callback) override;
+    void setScrollCallback(ScrollCallback callback) override;
+    void setResizeCallback(ResizeCallback callback) override;
+    void setCloseCallback(CloseCallback callback) override;
+
+    // Event injection; events are delivered once the platform time reaches `time`
+    void injectKeyEvent(const KeyEvent& event, double time = 0.0);
+    void injectMouseEvent(const MouseEvent& event, double time = 0.0);
+    void injectScrollEvent(const ScrollEvent& event, double time = 0.0);
+    void injectResize(int width, int height, double time = 0.0);
+    void injectClose(double time = 0.0);
+
+    // Internal methods called by the platform
+    void dispatchEvents(double now);
+    [[nodiscard]] bool hasPendingEvents() const noexcept;
+    [[nodiscard]] double getNextEventTime() const noexcept;
+    [[nodiscard]] bool dumpFramebuffer(const std::string& path) const;
+
+private:
+    struct ResizeRequest {
+        int width{0};
+        int height{0};
+    };
+
+    struct CloseRequest {};
+
+    using Event = std::variant<KeyEvent, MouseEvent, ScrollEvent, ResizeRequest, CloseRequest>;
+
+    struct PendingEvent {
+        double time{0.0};
+        Event event;
+    };
+
+    void enqueue(double time, Event event);
+    void dispatch(const Event& event);
+
+    HeadlessPlatform& m_platform;
+    std::unique_ptr<HeadlessGraphicsContext> m_graphicsContext{nullptr};
+    std::vector<PendingEvent> m_pendingEvents;
+
+    std::string m_title;
+    int m_width{0};
+    int m_height{0};
+
+    KeyCallback m_keyCallback;
+    MouseCallback m_mouseCallback;
+    ScrollCallback m_scrollCallback;
+    ResizeCallback m_resizeCallback;
+    CloseCallback m_closeCallback;
+
+    bool m_visible{false};
+    bool m_shouldClose{false};
+};
+
+} // namespace drite